@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class BenchContext;
+
+using BenchFn = void (*)(BenchContext&);
+
+struct BenchCase
+{
+    const char* name;
+    BenchFn fn;
+};
+
+std::vector<BenchCase>& Bench_Registry();
+
+struct BenchRegistrar
+{
+    BenchRegistrar(const char* name, BenchFn fn)
+    {
+        Bench_Registry().push_back(BenchCase{ name, fn });
+    }
+};
+
+#define SSR_BENCH(name) \
+    static void name(BenchContext& ctx); \
+    static BenchRegistrar name##_registrar(#name, name); \
+    static void name(BenchContext& ctx)
+
+struct BenchMetric
+{
+    std::string name;
+    double value;
+    std::string unit;
+    // 核对类指标：value 与 expected 不等即为失败，ssr_bench 据此返回 1
+    bool check = false;
+    double expected = 0;
+};
+
+// 防止编译器把被测代码优化掉
+void Bench_Consume(const void* p);
+
+template <typename T>
+inline void Bench_Consume(const T& value)
+{
+    Bench_Consume(static_cast<const void*>(&value));
+}
+
+// 本次运行独占的新建临时目录，POSIX 上由 mkdtemp 创建（名字不可预测，只有自己能访问）；
+// 调用方用完后删除。失败时返回空路径
+std::filesystem::path Bench_TempDir(const char* tag);
+
+class BenchContext
+{
+public:
+    explicit BenchContext(double minSeconds) : m_minSeconds(minSeconds) {}
+
+    // 自动调整迭代次数，记录每次调用的平均耗时（ns/op）
+    template <typename Fn>
+    void Run(const char* metric, Fn&& fn)
+    {
+        using Clock = std::chrono::steady_clock;
+        std::uint64_t iterations = 1;
+        for (;;)
+        {
+            const auto start = Clock::now();
+            for (std::uint64_t i = 0; i < iterations; i++)
+            {
+                fn();
+            }
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if (seconds >= m_minSeconds || iterations >= (1ull << 40))
+            {
+                Report(metric, seconds * 1e9 / (double)iterations, "ns/op");
+                return;
+            }
+            const double scale = seconds > 0 ? (m_minSeconds * 1.2 / seconds) : 100.0;
+            iterations = (std::uint64_t)((double)iterations * (scale > 100.0 ? 100.0 : (scale < 2.0 ? 2.0 : scale)));
+        }
+    }
+
+    void Report(const char* metric, double value, const char* unit)
+    {
+        m_metrics.push_back(BenchMetric{ metric, value, unit });
+    }
+
+    // 核对结果（违规数、不一致数、准备失败等），与基线无关
+    void Check(const char* metric, double value, double expected = 0, const char* unit = "count")
+    {
+        m_metrics.push_back(BenchMetric{ metric, value, unit, true, expected });
+    }
+
+    const std::vector<BenchMetric>& Metrics() const { return m_metrics; }
+
+private:
+    double m_minSeconds;
+    std::vector<BenchMetric> m_metrics;
+};
@@ -0,0 +1,661 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "anim_decode.h"
+#include "anim_player.h"
+#include "inflate.h"
+#include "process_footprint.h"
+#include "show_arena.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const ColorRef kAnimBg = MakeColor(0x20, 0x40, 0x60);
+
+    // ---- 测试用的 GIF：256 色调色板，每帧整幅，LZW 只输出单个像素的码并定期清表，码长保持 9 位 ----
+
+    std::uint32_t GifPaletteColor(int i)
+    {
+        return 0xFF000000u | ((std::uint32_t)i << 16) | ((std::uint32_t)(255 - i) << 8) | (std::uint32_t)((i * 3) & 0xFF);
+    }
+
+    int GifPixel(int x, int y, int frame)
+    {
+        return (x + y * 3 + frame * 8) & 0xFF;
+    }
+
+    struct BitWriter
+    {
+        std::vector<std::uint8_t> bytes;
+        std::uint32_t buf = 0;
+        int count = 0;
+
+        void Put(std::uint32_t value, int bits)
+        {
+            buf |= value << count;
+            count += bits;
+            while (count >= 8)
+            {
+                bytes.push_back((std::uint8_t)buf);
+                buf >>= 8;
+                count -= 8;
+            }
+        }
+
+        void Flush()
+        {
+            if (count > 0)
+            {
+                bytes.push_back((std::uint8_t)buf);
+            }
+            buf = 0;
+            count = 0;
+        }
+    };
+
+    void PutLe16(std::vector<std::uint8_t>& out, int v)
+    {
+        out.push_back((std::uint8_t)v);
+        out.push_back((std::uint8_t)(v >> 8));
+    }
+
+    std::vector<std::uint8_t> MakeGif(int width, int height, int frames, int delayCs, int repeats)
+    {
+        std::vector<std::uint8_t> out{ 'G', 'I', 'F', '8', '9', 'a' };
+        PutLe16(out, width);
+        PutLe16(out, height);
+        out.push_back(0xF7);   // 全局调色板，256 色
+        out.push_back(0);
+        out.push_back(0);
+        for (int i = 0; i < 256; i++)
+        {
+            const std::uint32_t c = GifPaletteColor(i);
+            out.push_back((std::uint8_t)(c >> 16));
+            out.push_back((std::uint8_t)(c >> 8));
+            out.push_back((std::uint8_t)c);
+        }
+        if (repeats >= 0)
+        {
+            const char app[] = "NETSCAPE2.0";
+            out.push_back(0x21);
+            out.push_back(0xFF);
+            out.push_back(11);
+            out.insert(out.end(), app, app + 11);
+            out.push_back(3);
+            out.push_back(1);
+            PutLe16(out, repeats);
+            out.push_back(0);
+        }
+        for (int f = 0; f < frames; f++)
+        {
+            out.push_back(0x21);
+            out.push_back(0xF9);
+            out.push_back(4);
+            out.push_back(1 << 2);   // 处置方式：保留
+            PutLe16(out, delayCs);
+            out.push_back(0);
+            out.push_back(0);
+
+            out.push_back(0x2C);
+            PutLe16(out, 0);
+            PutLe16(out, 0);
+            PutLe16(out, width);
+            PutLe16(out, height);
+            out.push_back(0);
+            out.push_back(8);
+
+            BitWriter bits;
+            int sinceClear = 0;
+            bits.Put(256, 9);
+            for (int y = 0; y < height; y++)
+            {
+                for (int x = 0; x < width; x++)
+                {
+                    if (sinceClear == 250)
+                    {
+                        bits.Put(256, 9);
+                        sinceClear = 0;
+                    }
+                    bits.Put((std::uint32_t)GifPixel(x, y, f), 9);
+                    sinceClear++;
+                }
+            }
+            bits.Put(257, 9);
+            bits.Flush();
+            for (size_t pos = 0; pos < bits.bytes.size(); pos += 255)
+            {
+                const size_t n = std::min<size_t>(255, bits.bytes.size() - pos);
+                out.push_back((std::uint8_t)n);
+                out.insert(out.end(), bits.bytes.begin() + (std::ptrdiff_t)pos, bits.bytes.begin() + (std::ptrdiff_t)(pos + n));
+            }
+            out.push_back(0);
+        }
+        out.push_back(0x3B);
+        return out;
+    }
+
+    // 只有一幅图像的小 GIF，图像描述符的位置与宽高任意（可以超出逻辑屏幕），数据只有清表与结束两个码
+    std::vector<std::uint8_t> MakeGifImage(int screenW, int screenH, int x, int y, int w, int h)
+    {
+        std::vector<std::uint8_t> out{ 'G', 'I', 'F', '8', '9', 'a' };
+        PutLe16(out, screenW);
+        PutLe16(out, screenH);
+        out.push_back(0x80);   // 全局调色板，2 色
+        out.push_back(0);
+        out.push_back(0);
+        out.insert(out.end(), { 0, 0, 0, 0xFF, 0xFF, 0xFF });
+        out.push_back(0x2C);
+        PutLe16(out, x);
+        PutLe16(out, y);
+        PutLe16(out, w);
+        PutLe16(out, h);
+        out.push_back(0);
+        out.push_back(2);
+        BitWriter bits;
+        bits.Put(4, 3);
+        bits.Put(5, 3);
+        bits.Flush();
+        out.push_back((std::uint8_t)bits.bytes.size());
+        out.insert(out.end(), bits.bytes.begin(), bits.bytes.end());
+        out.push_back(0);
+        out.push_back(0x3B);
+        return out;
+    }
+
+    // ---- 测试用的 APNG：RGBA，偶数帧用 stored 块、奇数帧用固定 Huffman 加距离 4 的重复，覆盖两种解压路径 ----
+
+    std::uint32_t ApngPixel(int x, int y, int frame)
+    {
+        // 未预乘的 0xAARRGGBB；透明度随位置变化，播放时要合成到背景上
+        const std::uint32_t a = (std::uint32_t)((x / 8 + frame) % 4) * 85;
+        const std::uint32_t r = (std::uint32_t)((y / 4 + frame * 16) & 0xFF);
+        const std::uint32_t g = (std::uint32_t)((x / 16) * 32 & 0xFF);
+        return (a << 24) | (r << 16) | (g << 8) | (std::uint32_t)(frame * 20 & 0xFF);
+    }
+
+    std::uint32_t Crc32(const std::uint8_t* data, size_t size, std::uint32_t crc = 0)
+    {
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++)
+        {
+            crc ^= data[i];
+            for (int k = 0; k < 8; k++)
+            {
+                crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+
+    std::uint32_t Adler32(const std::vector<std::uint8_t>& data)
+    {
+        std::uint32_t a = 1;
+        std::uint32_t b = 0;
+        for (std::uint8_t v : data)
+        {
+            a = (a + v) % 65521;
+            b = (b + a) % 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    void PutBe32(std::vector<std::uint8_t>& out, std::uint32_t v)
+    {
+        out.push_back((std::uint8_t)(v >> 24));
+        out.push_back((std::uint8_t)(v >> 16));
+        out.push_back((std::uint8_t)(v >> 8));
+        out.push_back((std::uint8_t)v);
+    }
+
+    void PutChunk(std::vector<std::uint8_t>& out, const char* type, const std::vector<std::uint8_t>& body)
+    {
+        PutBe32(out, (std::uint32_t)body.size());
+        const size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), body.begin(), body.end());
+        PutBe32(out, Crc32(out.data() + start, out.size() - start));
+    }
+
+    // Huffman 码按高位在前写入，位流本身低位在前
+    void PutHuffman(BitWriter& bits, std::uint32_t code, int length)
+    {
+        std::uint32_t reversed = 0;
+        for (int i = 0; i < length; i++)
+        {
+            reversed |= ((code >> i) & 1u) << (length - 1 - i);
+        }
+        bits.Put(reversed, length);
+    }
+
+    void PutFixedSymbol(BitWriter& bits, int sym)
+    {
+        if (sym < 144) PutHuffman(bits, 0x30u + (std::uint32_t)sym, 8);
+        else if (sym < 256) PutHuffman(bits, 0x190u + (std::uint32_t)(sym - 144), 9);
+        else if (sym < 280) PutHuffman(bits, (std::uint32_t)(sym - 256), 7);
+        else PutHuffman(bits, 0xC0u + (std::uint32_t)(sym - 280), 8);
+    }
+
+    std::vector<std::uint8_t> ZlibStored(const std::vector<std::uint8_t>& raw)
+    {
+        std::vector<std::uint8_t> out{ 0x78, 0x01 };
+        size_t pos = 0;
+        do
+        {
+            const size_t n = std::min<size_t>(65535, raw.size() - pos);
+            out.push_back(pos + n == raw.size() ? 1 : 0);
+            PutLe16(out, (int)n);
+            PutLe16(out, (int)(~n & 0xFFFF));
+            out.insert(out.end(), raw.begin() + (std::ptrdiff_t)pos, raw.begin() + (std::ptrdiff_t)(pos + n));
+            pos += n;
+        } while (pos < raw.size());
+        PutBe32(out, Adler32(raw));
+        return out;
+    }
+
+    std::vector<std::uint8_t> ZlibFixed(const std::vector<std::uint8_t>& raw)
+    {
+        static const int kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const int kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        BitWriter bits;
+        bits.bytes = { 0x78, 0x01 };
+        bits.Put(1, 1);   // 最后一块
+        bits.Put(1, 2);   // 固定 Huffman
+        size_t i = 0;
+        while (i < raw.size())
+        {
+            int len = 0;
+            if (i >= 4)
+            {
+                while (len < 258 && i + (size_t)len < raw.size() && raw[i + (size_t)len] == raw[i + (size_t)len - 4])
+                {
+                    len++;
+                }
+            }
+            if (len < 3)
+            {
+                PutFixedSymbol(bits, raw[i]);
+                i++;
+                continue;
+            }
+            int code = 28;
+            while (kLengthBase[code] > len)
+            {
+                code--;
+            }
+            PutFixedSymbol(bits, 257 + code);
+            bits.Put((std::uint32_t)(len - kLengthBase[code]), kLengthExtra[code]);
+            PutHuffman(bits, 3, 5);   // 距离 4
+            i += (size_t)len;
+        }
+        PutFixedSymbol(bits, 256);
+        bits.Flush();
+        PutBe32(bits.bytes, Adler32(raw));
+        return bits.bytes;
+    }
+
+    std::vector<std::uint8_t> ApngRaw(int width, int height, int frame)
+    {
+        std::vector<std::uint8_t> raw;
+        raw.reserve((size_t)height * ((size_t)width * 4 + 1));
+        for (int y = 0; y < height; y++)
+        {
+            raw.push_back(0);
+            for (int x = 0; x < width; x++)
+            {
+                const std::uint32_t c = ApngPixel(x, y, frame);
+                raw.push_back((std::uint8_t)(c >> 16));
+                raw.push_back((std::uint8_t)(c >> 8));
+                raw.push_back((std::uint8_t)c);
+                raw.push_back((std::uint8_t)(c >> 24));
+            }
+        }
+        return raw;
+    }
+
+    std::vector<std::uint8_t> MakeApng(int width, int height, int frames, int delayMs, int plays)
+    {
+        std::vector<std::uint8_t> out{ 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+        std::vector<std::uint8_t> body;
+        PutBe32(body, (std::uint32_t)width);
+        PutBe32(body, (std::uint32_t)height);
+        body.insert(body.end(), { 8, 6, 0, 0, 0 });
+        PutChunk(out, "IHDR", body);
+        body.clear();
+        PutBe32(body, (std::uint32_t)frames);
+        PutBe32(body, (std::uint32_t)plays);
+        PutChunk(out, "acTL", body);
+
+        std::uint32_t seq = 0;
+        for (int f = 0; f < frames; f++)
+        {
+            body.clear();
+            PutBe32(body, seq++);
+            PutBe32(body, (std::uint32_t)width);
+            PutBe32(body, (std::uint32_t)height);
+            PutBe32(body, 0);
+            PutBe32(body, 0);
+            body.push_back((std::uint8_t)(delayMs >> 8));
+            body.push_back((std::uint8_t)delayMs);
+            body.push_back(0x03);
+            body.push_back(0xE8);   // 分母 1000
+            body.push_back(0);      // 处置：保留
+            body.push_back(0);      // 混合：覆盖
+            PutChunk(out, "fcTL", body);
+
+            const std::vector<std::uint8_t> raw = ApngRaw(width, height, f);
+            const std::vector<std::uint8_t> z = f % 2 == 0 ? ZlibStored(raw) : ZlibFixed(raw);
+            if (f == 0)
+            {
+                PutChunk(out, "IDAT", z);
+            }
+            else
+            {
+                body.clear();
+                PutBe32(body, seq++);
+                body.insert(body.end(), z.begin(), z.end());
+                PutChunk(out, "fdAT", body);
+            }
+        }
+        PutChunk(out, "IEND", {});
+        return out;
+    }
+
+    std::filesystem::path WriteTemp(const std::filesystem::path& dir, const char* name, const std::vector<std::uint8_t>& data)
+    {
+        const std::filesystem::path path = dir / name;
+        if (FILE* f = std::fopen(path.string().c_str(), "wb"))
+        {
+            std::fwrite(data.data(), 1, data.size(), f);
+            std::fclose(f);
+        }
+        return path;
+    }
+
+    // 逐帧解码整个文件，返回与 expected 不一致的像素数
+    template <typename Expected>
+    std::uint64_t DecodeMismatches(const std::vector<std::uint8_t>& file, int frames, Expected expected)
+    {
+        AnimDecoder decoder;
+        if (!decoder.Open(file.data(), file.size()))
+        {
+            return 1;
+        }
+        const int w = decoder.Info().width;
+        const int h = decoder.Info().height;
+        std::uint64_t mismatches = 0;
+        int delay = 0;
+        for (int f = 0; f < frames; f++)
+        {
+            if (!decoder.Next(delay))
+            {
+                return mismatches + 1;
+            }
+            const std::uint32_t* canvas = decoder.Canvas();
+            for (int y = 0; y < h; y++)
+            {
+                for (int x = 0; x < w; x++)
+                {
+                    mismatches += canvas[(size_t)y * (size_t)w + (size_t)x] != expected(x, y, f) ? 1 : 0;
+                }
+            }
+        }
+        mismatches += decoder.Next(delay) ? 1 : 0;
+        return mismatches;
+    }
+
+    // 解码整个文件若干遍，返回每秒帧数与每秒输出的画布字节
+    void MeasureDecode(BenchContext& ctx, const std::vector<std::uint8_t>& file, const char* fpsMetric, const char* mbMetric)
+    {
+        AnimDecoder decoder;
+        decoder.Open(file.data(), file.size());
+        const double canvasBytes = (double)decoder.Info().width * decoder.Info().height * 4;
+        std::uint64_t frames = 0;
+        int delay = 0;
+        const Clock::time_point start = Clock::now();
+        double seconds = 0;
+        while (seconds < 0.3)
+        {
+            if (!decoder.Next(delay))
+            {
+                decoder.Rewind();
+                continue;
+            }
+            frames++;
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        ctx.Report(fpsMetric, (double)frames / seconds, "frames/s");
+        ctx.Report(mbMetric, (double)frames * canvasBytes / seconds / (1024.0 * 1024.0), "MB/s");
+    }
+
+    struct PlaybackResult
+    {
+        AnimPlayerStats stats;
+        std::uint64_t advanceMaxNs = 0;   // 界面线程单次 Advance 的最长耗时
+        std::uint64_t arenaPeak = 0;
+        std::uint64_t rssPeak = 0;
+        std::uint64_t missingFrames = 0;  // 有帧之后 Frame 仍返回空的次数
+        bool finished = false;
+    };
+
+    // 像宿主的一次性计时器那样：睡到 NextDelay 再 Advance，直到播完或超过 maxMs
+    PlaybackResult Play(const std::filesystem::path& path, const std::vector<AnimTarget>& targets, std::uint64_t maxMs)
+    {
+        PlaybackResult result;
+        AnimPlayer player;
+        if (!player.Open(path))
+        {
+            result.stats.errors = 1;
+            return result;
+        }
+        const Clock::time_point t0 = Clock::now();
+        auto nowMs = [&] { return (std::uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0).count(); };
+        player.Start(targets, kAnimBg, nowMs());
+        bool seenFrame = false;
+        ProcessFootprint footprint;
+        for (;;)
+        {
+            const Clock::time_point a = Clock::now();
+            const bool changed = player.Advance(nowMs());
+            result.advanceMaxNs = std::max<std::uint64_t>(result.advanceMaxNs, (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - a).count());
+            if (changed)
+            {
+                seenFrame = true;
+            }
+            if (seenFrame)
+            {
+                for (const AnimTarget& t : targets)
+                {
+                    result.missingFrames += player.Frame(t.width, t.height) ? 0 : 1;
+                }
+            }
+            result.arenaPeak = std::max(result.arenaPeak, ShowArena_Overlay().Stats().reservedBytes);
+            if (ProcessFootprint_Read(0, footprint))
+            {
+                result.rssPeak = std::max(result.rssPeak, footprint.rssBytes);
+            }
+            std::uint32_t delay = 0;
+            if (!player.NextDelay(nowMs(), delay))
+            {
+                result.finished = true;
+                break;
+            }
+            if (nowMs() >= maxMs)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+        }
+        result.stats = player.Stats();
+        player.Close();
+        ShowArena_Overlay().Release();
+        return result;
+    }
+
+    std::uint64_t TargetBytes(const std::vector<AnimTarget>& targets)
+    {
+        std::uint64_t bytes = 0;
+        for (const AnimTarget& t : targets)
+        {
+            bytes += (std::uint64_t)t.width * (std::uint64_t)t.height * 4;
+        }
+        return bytes;
+    }
+}
+
+SSR_BENCH(AnimDecode)
+{
+    // 解码正确性：每一帧的画布与生成时的像素逐个比较
+    const int gifW = 320;
+    const int gifH = 240;
+    const int gifFrames = 24;
+    const std::vector<std::uint8_t> gif = MakeGif(gifW, gifH, gifFrames, 4, 0);
+    const std::uint64_t gifMismatch = DecodeMismatches(gif, gifFrames,
+        [](int x, int y, int f) { return GifPaletteColor(GifPixel(x, y, f)); });
+
+    const int pngW = 256;
+    const int pngH = 192;
+    const int pngFrames = 12;
+    const std::vector<std::uint8_t> apng = MakeApng(pngW, pngH, pngFrames, 30, 2);
+    const std::uint64_t apngMismatch = DecodeMismatches(apng, pngFrames,
+        [](int x, int y, int f) { return ApngPixel(x, y, f); });
+
+    // 两种压缩方式各解一次，与原始字节比较
+    const std::vector<std::uint8_t> raw = ApngRaw(pngW, pngH, 3);
+    std::vector<std::uint8_t> roundTrip(raw.size());
+    int inflateFailures = 0;
+    for (const std::vector<std::uint8_t>& z : { ZlibStored(raw), ZlibFixed(raw) })
+    {
+        std::fill(roundTrip.begin(), roundTrip.end(), 0);
+        inflateFailures += Inflate_Zlib(z.data(), z.size(), roundTrip.data(), roundTrip.size()) && roundTrip == raw ? 0 : 1;
+    }
+    // 损坏的数据必须失败而不是越界
+    std::vector<std::uint8_t> broken = ZlibFixed(raw);
+    broken[broken.size() / 2] ^= 0x5A;
+    inflateFailures += Inflate_Zlib(broken.data(), broken.size(), roundTrip.data(), roundTrip.size()) ? 1 : 0;
+
+    // 图像描述符超出逻辑屏幕（包括 1×1 屏幕上 65535×65535 的一帧）时这一帧无效，不按文件里的宽高申请内存
+    int malformedGif = 0;
+    {
+        struct Case { int x, y, w, h; bool valid; };
+        const Case cases[] = {
+            { 0, 0, 1, 1, true },
+            { 0, 0, 65535, 65535, false },
+            { 0, 0, 0, 0, false },
+            { 0, 0, 2, 1, false },
+            { 1, 0, 1, 1, false },
+            { 0, 65535, 1, 1, false },
+        };
+        for (const Case& c : cases)
+        {
+            const std::vector<std::uint8_t> bytes = MakeGifImage(1, 1, c.x, c.y, c.w, c.h);
+            AnimDecoder decoder;
+            int delay = 0;
+            const bool opened = decoder.Open(bytes.data(), bytes.size());
+            malformedGif += opened && decoder.Next(delay) == c.valid ? 0 : 1;
+        }
+    }
+
+    AnimDecoder info;
+    info.Open(gif.data(), gif.size());
+    const int gifLoops = info.Info().loops;
+    info.Open(apng.data(), apng.size());
+    const int apngLoops = info.Info().loops;
+
+    int violations = 0;
+    violations += gifMismatch == 0 ? 0 : 1;
+    violations += apngMismatch == 0 ? 0 : 1;
+    violations += inflateFailures;
+    violations += malformedGif;
+    violations += gifLoops == 0 ? 0 : 1;
+    violations += apngLoops == 2 ? 0 : 1;
+
+    ctx.Check("gif_mismatched_pixels", (double)gifMismatch);
+    ctx.Check("apng_mismatched_pixels", (double)apngMismatch);
+    ctx.Check("inflate_failures", (double)inflateFailures);
+    ctx.Check("malformed_gif_failures", (double)malformedGif);
+    ctx.Check("violations", (double)violations);
+
+    MeasureDecode(ctx, gif, "gif_decode_fps", "gif_decode_mbps");
+    MeasureDecode(ctx, apng, "apng_decode_fps", "apng_decode_mbps");
+
+    AnimDecoder decoder;
+    decoder.Open(gif.data(), gif.size());
+    ctx.Run("gif_next_frame", [&]
+    {
+        int delay = 0;
+        if (!decoder.Next(delay))
+        {
+            decoder.Rewind();
+        }
+        Bench_Consume(decoder.Canvas()[0]);
+    });
+}
+
+SSR_BENCH(AnimPlayback)
+{
+    // 50 帧/秒的 GIF 在两块不同尺寸的显示器上播放 1.5 秒：测换帧的抖动、环的内存上限与界面线程的耗时
+    const std::filesystem::path dir = Bench_TempDir("anim");
+    if (dir.empty())
+    {
+        ctx.Check("tempdir_failed", 1, 0, "bool");
+        return;
+    }
+    const std::filesystem::path gifPath = WriteTemp(dir, "anim.gif", MakeGif(320, 240, 30, 2, 0));
+    const std::vector<AnimTarget> targets{ AnimTarget{ 480, 360 }, AnimTarget{ 640, 480 } };
+    const PlaybackResult steady = Play(gifPath, targets, 1500);
+
+    // 解码线程跟不上（20ms 一帧、放大到 2560×1440）：必须丢帧而不是拖慢界面
+    const std::vector<AnimTarget> large{ AnimTarget{ 2560, 1440 } };
+    const std::filesystem::path fastPath = WriteTemp(dir, "anim_fast.gif", MakeGif(320, 240, 30, 2, 0));
+    const PlaybackResult behind = Play(fastPath, large, 1000);
+
+    // 播放两遍后停在最后一帧，计时器不再需要
+    const std::filesystem::path apngPath = WriteTemp(dir, "anim.png", MakeApng(256, 192, 12, 30, 2));
+    const PlaybackResult finite = Play(apngPath, targets, 3000);
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+
+    const std::uint64_t ringLimit = TargetBytes(targets) * (ANIM_RING_FRAMES + 1);
+    const double lateMean = steady.stats.presented ? (double)steady.stats.lateMsTotal / (double)steady.stats.presented : 0.0;
+    // 源画布合成背景用的一份，另加 arena 按块申请的取整
+    const std::uint64_t arenaSlack = 320ull * 240 * 4 + ShowArena::CHUNK_BYTES;
+
+    int violations = 0;
+    violations += steady.stats.errors == 0 && steady.stats.presented > 0 ? 0 : 1;
+    violations += steady.stats.ringBytes == ringLimit ? 0 : 1;
+    violations += steady.arenaPeak <= ringLimit + arenaSlack ? 0 : 1;
+    violations += steady.missingFrames == 0 ? 0 : 1;
+    // 单次 Advance 只交换缓冲，不等待解码线程
+    violations += steady.advanceMaxNs < 2000000 && behind.advanceMaxNs < 2000000 ? 0 : 1;
+    violations += behind.stats.dropped > 0 ? 0 : 1;
+    violations += finite.finished && finite.stats.loops == 2 && finite.stats.errors == 0 ? 0 : 1;
+    violations += finite.stats.presented + finite.stats.dropped >= 24 ? 0 : 1;
+
+    ctx.Report("steady_presented", (double)steady.stats.presented, "frames");
+    ctx.Report("steady_dropped", (double)steady.stats.dropped, "frames");
+    ctx.Report("steady_underruns", (double)steady.stats.underruns, "count");
+    ctx.Report("steady_late_mean", lateMean, "ms");
+    ctx.Report("steady_late_max", (double)steady.stats.lateMsMax, "ms");
+    ctx.Report("steady_decode_per_frame", steady.stats.decoded ? (double)steady.stats.decodeNs / (double)steady.stats.decoded : 0.0, "ns");
+    ctx.Report("steady_advance_max", (double)steady.advanceMaxNs, "ns");
+    ctx.Report("ring_bytes", (double)steady.stats.ringBytes, "bytes");
+    ctx.Report("arena_peak", (double)steady.arenaPeak, "bytes");
+    ctx.Report("rss_peak", (double)steady.rssPeak, "bytes");
+    ctx.Report("behind_presented", (double)behind.stats.presented, "frames");
+    ctx.Report("behind_dropped", (double)behind.stats.dropped, "frames");
+    ctx.Report("behind_underruns", (double)behind.stats.underruns, "count");
+    ctx.Report("behind_late_max", (double)behind.stats.lateMsMax, "ms");
+    ctx.Report("behind_advance_max", (double)behind.advanceMaxNs, "ns");
+    ctx.Report("finite_presented", (double)finite.stats.presented, "frames");
+    ctx.Report("finite_loops", (double)finite.stats.loops, "count");
+    ctx.Check("violations", (double)violations);
+}
@@ -0,0 +1,345 @@
+#include "bench.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "asset_pack.h"
+#include "overlay_frame.h"
+#include "process_footprint.h"
+#include "soft_render.h"
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const ColorRef kAssetBg = MakeColor(0x20, 0x30, 0x60);
+    const std::wstring kAssetText = L"该休息一下了，看看远处，放松眼睛。";
+
+    std::filesystem::path AssetDir(const char* tag)
+    {
+#ifdef _WIN32
+        return std::filesystem::path(std::string("ssr-assets-") + tag);
+#else
+        return std::filesystem::path("/tmp/ssr-assets-" + std::to_string((long)getpid()) + "-" + tag);
+#endif
+    }
+
+    AssetKey AssetKeyFor(int w, int h, int dpi)
+    {
+        return AssetKey{ w, h, dpi, OverlayFrame_ContentHash(kAssetBg, kAssetText) };
+    }
+
+    std::vector<std::uint32_t> RenderBase(int w, int h, int dpi)
+    {
+        std::vector<std::uint32_t> pixels((size_t)w * (size_t)h);
+        PixelBuffer buf{ pixels.data(), w, h, w };
+        SoftOverlayLayout layout;
+        Soft_LayoutOverlay(w, h, dpi, kAssetText, layout);
+        Soft_RenderOverlayBase(buf, layout, kAssetBg, kAssetText);
+        return pixels;
+    }
+}
+
+SSR_BENCH(AssetPackRoundTrip)
+{
+    // 发布 → 两个使用者映射 → 依次关闭：还有使用者时文件保留，最后一个关闭时删除；
+    // 改动过的、别人能改写的、别的用户的资源包不映射；被杀掉的使用者不会让文件一直留着
+    const std::filesystem::path dir = AssetDir("roundtrip");
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    const std::uint64_t packKey = 0x5353520000000001ull;
+    const auto small = RenderBase(640, 360, 96);
+    const auto large = RenderBase(1920, 1080, 144);
+
+    int violations = 0;
+    AssetPackBuilder builder;
+    builder.Add(AssetKind::FrameBase, AssetKeyFor(640, 360, 96), small.data(), small.size() * sizeof(std::uint32_t));
+    builder.Add(AssetKind::FrameBase, AssetKeyFor(1920, 1080, 144), large.data(), large.size() * sizeof(std::uint32_t));
+    violations += builder.Publish(dir, packKey) ? 0 : 1;
+    // 已存在时不覆盖
+    violations += builder.Publish(dir, packKey) ? 0 : 1;
+
+    {
+        SharedAssetPack a;
+        SharedAssetPack b;
+        violations += a.Open(dir, packKey) && b.Open(dir, packKey) ? 0 : 1;
+
+        size_t size = 0;
+        const std::uint8_t* data = b.Find(AssetKind::FrameBase, AssetKeyFor(1920, 1080, 144), size);
+        violations += data && size == large.size() * sizeof(std::uint32_t) && std::memcmp(data, large.data(), size) == 0 ? 0 : 1;
+        violations += reinterpret_cast<std::uintptr_t>(data) % 64 == 0 ? 0 : 1;
+        data = a.Find(AssetKind::FrameBase, AssetKeyFor(640, 360, 96), size);
+        violations += data && size == small.size() * sizeof(std::uint32_t) && std::memcmp(data, small.data(), size) == 0 ? 0 : 1;
+        violations += a.Find(AssetKind::FrameBase, AssetKeyFor(640, 360, 120), size) == nullptr ? 0 : 1;
+
+        SharedAssetPack wrongKey;
+        violations += wrongKey.Open(dir, packKey + 1) ? 1 : 0;
+
+        b.Close();
+        violations += std::filesystem::exists(AssetPack_Path(dir, packKey), ec) ? 0 : 1;
+        ctx.Report("pack_bytes", (double)a.MappedBytes(), "bytes");
+
+        ctx.Run("find", [&]
+        {
+            size_t n = 0;
+            Bench_Consume(a.Find(AssetKind::FrameBase, AssetKeyFor(1920, 1080, 144), n));
+        });
+    }
+    violations += std::filesystem::exists(AssetPack_Path(dir, packKey), ec) ? 1 : 0;
+
+    const std::filesystem::path path = AssetPack_Path(dir, packKey);
+    {
+        // 改掉数据里的一个字节：散列不符
+        violations += builder.Publish(dir, packKey) ? 0 : 1;
+        {
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekg(-1, std::ios::end);
+            const char last = (char)f.get();
+            f.seekp(-1, std::ios::end);
+            f.put((char)(last ^ 0x5A));
+        }
+        SharedAssetPack tampered;
+        ctx.Check("tampered_accepted", tampered.Open(dir, packKey) ? 1 : 0, 0, "bool");
+        std::filesystem::remove(path, ec);
+    }
+#ifndef _WIN32
+    {
+        // 组或其他人可写：别的用户能改，不映射；root 运行时再试属于别的用户的文件
+        violations += builder.Publish(dir, packKey) ? 0 : 1;
+        std::filesystem::permissions(path, std::filesystem::perms::group_write | std::filesystem::perms::others_write,
+            std::filesystem::perm_options::add, ec);
+        SharedAssetPack writable;
+        int untrusted = writable.Open(dir, packKey) ? 1 : 0;
+        std::filesystem::permissions(path, std::filesystem::perms::group_write | std::filesystem::perms::others_write,
+            std::filesystem::perm_options::remove, ec);
+        if (geteuid() == 0 && chown(path.c_str(), 65534, 65534) == 0)
+        {
+            SharedAssetPack foreign;
+            untrusted += foreign.Open(dir, packKey) ? 1 : 0;
+        }
+        ctx.Check("untrusted_accepted", untrusted);
+        std::filesystem::remove(path, ec);
+    }
+    {
+        // 子进程映射后被 SIGKILL：活着时父进程关闭不删除文件，死后锁由系统释放，父进程关闭时删除
+        violations += builder.Publish(dir, packKey) ? 0 : 1;
+        int ready[2];
+        if (pipe(ready) != 0)
+        {
+            ctx.Check("pipe_failed", 1, 0, "bool");
+            return;
+        }
+        const pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(ready[0]);
+            auto pack = new SharedAssetPack();
+            char c = pack->Open(dir, packKey) ? 1 : 0;
+            [[maybe_unused]] ssize_t w = write(ready[1], &c, 1);
+            for (;;)
+            {
+                pause();
+            }
+        }
+        close(ready[1]);
+        char c = 0;
+        violations += read(ready[0], &c, 1) == 1 && c == 1 ? 0 : 1;
+        close(ready[0]);
+        {
+            SharedAssetPack parent;
+            violations += parent.Open(dir, packKey) ? 0 : 1;
+        }
+        violations += std::filesystem::exists(path, ec) ? 0 : 1;
+        kill(pid, SIGKILL);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        {
+            SharedAssetPack parent;
+            violations += parent.Open(dir, packKey) ? 0 : 1;
+        }
+        ctx.Check("killed_holder_leaked", std::filesystem::exists(path, ec) ? 1 : 0, 0, "bool");
+    }
+#endif
+
+    violations += builder.Publish(dir, packKey) ? 0 : 1;
+    {
+        // 另留一个使用者，避免每次关闭都删除文件
+        SharedAssetPack keep;
+        keep.Open(dir, packKey);
+        ctx.Run("open_close", [&]
+        {
+            SharedAssetPack pack;
+            Bench_Consume(pack.Open(dir, packKey));
+        });
+    }
+    std::filesystem::remove_all(dir, ec);
+    ctx.Check("violations", (double)violations);
+}
+
+#ifndef _WIN32
+
+namespace
+{
+    // 子进程准备好遮罩的像素后通知父进程并等待被结束；父进程趁这时读取各子进程的内存占用
+    struct FootprintTotals
+    {
+        std::uint64_t rss = 0;
+        std::uint64_t pss = 0;
+        std::uint64_t priv = 0;
+        std::uint64_t shared = 0;
+        int failed = 0;
+    };
+
+    template <typename Child>
+    FootprintTotals MeasureChildren(int count, Child child)
+    {
+        FootprintTotals totals;
+        std::vector<pid_t> pids;
+        std::vector<int> pipes;
+        for (int i = 0; i < count; i++)
+        {
+            int ready[2];
+            if (pipe(ready) != 0)
+            {
+                totals.failed++;
+                break;
+            }
+            const pid_t pid = fork();
+            if (pid == 0)
+            {
+                close(ready[0]);
+                char c = child() ? 1 : 0;
+                [[maybe_unused]] ssize_t w = write(ready[1], &c, 1);
+                for (;;)
+                {
+                    pause();
+                }
+            }
+            close(ready[1]);
+            pids.push_back(pid);
+            pipes.push_back(ready[0]);
+        }
+        for (int fd : pipes)
+        {
+            char c = 0;
+            if (read(fd, &c, 1) != 1 || c != 1)
+            {
+                totals.failed++;
+            }
+            close(fd);
+        }
+        // 所有子进程都已映射后再读，PSS 才按实际共享的进程数均摊
+        for (pid_t pid : pids)
+        {
+            ProcessFootprint fp;
+            if (!ProcessFootprint_Read((long)pid, fp))
+            {
+                totals.failed++;
+                continue;
+            }
+            totals.rss += fp.rssBytes;
+            totals.pss += fp.pssBytes;
+            totals.priv += fp.privateBytes;
+            totals.shared += fp.sharedBytes;
+        }
+        for (pid_t pid : pids)
+        {
+            kill(pid, SIGKILL);
+            int status = 0;
+            waitpid(pid, &status, 0);
+        }
+        return totals;
+    }
+
+    std::uint64_t TouchPages(const std::uint8_t* data, size_t size)
+    {
+        std::uint64_t sum = 0;
+        for (size_t i = 0; i < size; i += 4096)
+        {
+            sum += data[i];
+        }
+        return sum;
+    }
+
+    void ReportTotals(BenchContext& ctx, const char* prefix, const FootprintTotals& t, int count)
+    {
+        const std::string p(prefix);
+        const double mib = 1024.0 * 1024.0;
+        ctx.Report((p + "_rss_per_session").c_str(), t.rss / mib / count, "MiB");
+        ctx.Report((p + "_pss_per_session").c_str(), t.pss / mib / count, "MiB");
+        ctx.Report((p + "_private_per_session").c_str(), t.priv / mib / count, "MiB");
+        ctx.Report((p + "_shared_total").c_str(), t.shared / mib, "MiB");
+    }
+}
+
+SSR_BENCH(AssetPackSessions)
+{
+    // 模拟一台终端服务器上的 N 个会话，每个会话一块 1920x1080 显示器：
+    // 私有模式下每个进程各自持有底图与合成好的首帧；低占用模式下只映射共享资源包里的底图
+    const int sessions = 16;
+    const int w = 1920;
+    const int h = 1080;
+    const int dpi = 96;
+    const std::filesystem::path dir = AssetDir("sessions");
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+
+    ProcessFootprint self;
+    if (!ProcessFootprint_Read(0, self))
+    {
+        ctx.Check("smaps_unavailable", 1, 0, "bool");
+        return;
+    }
+
+    const FootprintTotals privateMode = MeasureChildren(sessions, [&]
+    {
+        auto frame = new OverlayFrame();
+        const auto pixels = RenderBase(w, h, dpi);
+        frame->base.assign(pixels.begin(), pixels.end());
+        frame->composed = frame->base;
+        Bench_Consume(TouchPages(reinterpret_cast<const std::uint8_t*>(frame->composed.data()), frame->composed.size() * 4));
+        return true;
+    });
+
+    const std::uint64_t packKey = 0x5353520000000002ull;
+    {
+        AssetPackBuilder builder;
+        const auto base = RenderBase(w, h, dpi);
+        builder.Add(AssetKind::FrameBase, AssetKeyFor(w, h, dpi), base.data(), base.size() * sizeof(std::uint32_t));
+        builder.Publish(dir, packKey);
+    }
+    // 父进程也映射着资源包；子进程被 SIGKILL 后锁由系统释放，父进程关闭时应删除文件
+    SharedAssetPack holder;
+    holder.Open(dir, packKey);
+    const FootprintTotals sharedMode = MeasureChildren(sessions, [&]
+    {
+        auto pack = new SharedAssetPack();
+        size_t size = 0;
+        const std::uint8_t* data = pack->Open(dir, packKey) ? pack->Find(AssetKind::FrameBase, AssetKeyFor(w, h, dpi), size) : nullptr;
+        if (!data)
+        {
+            return false;
+        }
+        Bench_Consume(TouchPages(data, size));
+        return true;
+    });
+    holder.Close();
+    ctx.Check("pack_leaked", std::filesystem::exists(AssetPack_Path(dir, packKey), ec) ? 1 : 0, 0, "bool");
+    std::filesystem::remove_all(dir, ec);
+
+    ctx.Report("sessions", (double)sessions, "count");
+    ReportTotals(ctx, "private", privateMode, sessions);
+    ReportTotals(ctx, "shared", sharedMode, sessions);
+    ctx.Report("pss_saved_per_session", ((double)privateMode.pss - (double)sharedMode.pss) / (1024.0 * 1024.0) / sessions, "MiB");
+    ctx.Check("failures", (double)(privateMode.failed + sharedMode.failed));
+}
+
+#endif
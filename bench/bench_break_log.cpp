@@ -0,0 +1,162 @@
+#include "bench.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "break_log.h"
+#include "mapped_file.h"
+
+static constexpr std::uint64_t SYNTHETIC_RECORDS = 10'000'000;
+
+// 每 5 分钟一次提醒，每次提醒 4 条记录，约覆盖 24 年
+static void WriteSyntheticLog(const std::filesystem::path& path)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::vector<BreakRecord> chunk;
+    chunk.reserve(4096);
+
+    std::int64_t t = 1262304000000ll; // 2010-01-01
+    std::uint32_t cycle = 0;
+    for (std::uint64_t i = 0; i < SYNTHETIC_RECORDS; i += 4)
+    {
+        cycle++;
+        const std::uint32_t away = 2000 + (cycle * 7919u) % 60000u;
+        chunk.push_back(BreakLog_MakeRecord(BreakEvent::Shown, 0, cycle, t, 0));
+        chunk.push_back(BreakLog_MakeRecord(BreakEvent::FadeInDone, 0, cycle, t + 5000, 5000));
+        chunk.push_back(BreakLog_MakeRecord(BreakEvent::FirstActivity, 0, cycle, t + 5000 + away, 5000 + away));
+        chunk.push_back(BreakLog_MakeRecord(BreakEvent::Hidden, 0, cycle, t + 10000 + away, 10000 + away));
+        t += 5 * 60 * 1000;
+
+        if (chunk.size() >= 4096)
+        {
+            out.write(reinterpret_cast<const char*>(chunk.data()), (std::streamsize)(chunk.size() * sizeof(BreakRecord)));
+            chunk.clear();
+        }
+    }
+    out.write(reinterpret_cast<const char*>(chunk.data()), (std::streamsize)(chunk.size() * sizeof(BreakRecord)));
+}
+
+SSR_BENCH(BreakLogAggregate)
+{
+    const std::filesystem::path dir = Bench_TempDir("breaks");
+    if (dir.empty())
+    {
+        ctx.Check("tempdir_failed", 1, 0, "bool");
+        return;
+    }
+    const auto path = dir / "breaks.log";
+    WriteSyntheticLog(path);
+
+    MappedFile file;
+    std::error_code ec;
+    if (!file.OpenRead(path))
+    {
+        ctx.Check("map_failed", 1, 0, "bool");
+        std::filesystem::remove_all(dir, ec);
+        return;
+    }
+
+    BreakLogSummary summary;
+    ctx.Run("daily_10M_records", [&]
+    {
+        BreakLog_Aggregate(file.data(), file.size(), BreakBucket::Day, 480, summary);
+        Bench_Consume(summary);
+    });
+    ctx.Report("daily_buckets", (double)summary.buckets.size(), "count");
+
+    ctx.Run("weekly_10M_records", [&]
+    {
+        BreakLog_Aggregate(file.data(), file.size(), BreakBucket::Week, 480, summary);
+        Bench_Consume(summary);
+    });
+    ctx.Report("weekly_buckets", (double)summary.buckets.size(), "count");
+    ctx.Report("records", (double)summary.records, "count");
+
+    ctx.Run("open_map_aggregate_daily", [&]
+    {
+        BreakLog_AggregateFile(path, BreakBucket::Day, 480, summary);
+        Bench_Consume(summary);
+    });
+
+    // 启动时只从末尾往回数今天的提醒，结果与整份统计的最后一天一致；周期编号更大的（本进程的）不计入
+    BreakLog_AggregateFile(path, BreakBucket::Day, 480, summary);
+    const BreakStats& lastDay = summary.buckets.back();
+    std::uint32_t today = 0;
+    ctx.Run("count_today_10M_records", [&]
+    {
+        today = BreakLog_CountDay(file.data(), file.size(), lastDay.bucket, 480, UINT32_MAX);
+        Bench_Consume(today);
+    });
+    BreakRecord last{};
+    std::memcpy(&last, file.data() + file.size() - sizeof(BreakRecord), sizeof(last));
+    int todayMismatches = today == lastDay.reminders ? 0 : 1;
+    todayMismatches += BreakLog_CountDay(file.data(), file.size(), lastDay.bucket, 480, last.cycle - 10) == lastDay.reminders - 10 ? 0 : 1;
+
+    // 后台数出的部分与弹出时累加的部分相加，跨日只算当天的
+    BreakDayCounter counter;
+    counter.OnShown(lastDay.bucket);
+    counter.Seed(lastDay.bucket, today);
+    counter.OnShown(lastDay.bucket);
+    todayMismatches += counter.Count(lastDay.bucket) == (int)today + 2 ? 0 : 1;
+    todayMismatches += counter.CountWithNext(lastDay.bucket + 1) == 1 ? 0 : 1;
+    counter.OnShown(lastDay.bucket + 1);
+    todayMismatches += counter.Count(lastDay.bucket + 1) == 1 && counter.Count(lastDay.bucket) == (int)today ? 0 : 1;
+    ctx.Check("today_mismatches", (double)todayMismatches);
+
+    file.Close();
+    std::filesystem::remove_all(dir, ec);
+}
+
+static bool ReadLastRecord(const std::filesystem::path& path, BreakRecord& rec)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    const std::streamoff size = in ? (std::streamoff)in.tellg() : 0;
+    if (size < (std::streamoff)sizeof(BreakRecord))
+    {
+        return false;
+    }
+    in.seekg(size - (std::streamoff)sizeof(BreakRecord));
+    return in.read(reinterpret_cast<char*>(&rec), sizeof(rec)) && BreakLog_IsValid(rec);
+}
+
+SSR_BENCH(BreakLogWriterAppend)
+{
+    const std::filesystem::path dir = Bench_TempDir("breaks-writer");
+    if (dir.empty())
+    {
+        ctx.Check("tempdir_failed", 1, 0, "bool");
+        return;
+    }
+    const auto path = dir / "breaks.log";
+    std::error_code ec;
+
+    // 连续追加远快于写文件时 Append 等写线程，一条都不丢；耗时即持续写入的速度
+    BreakLogWriter writer;
+    writer.Start(path);
+    std::uint64_t i = 0;
+    ctx.Run("append_ui_thread", [&]
+    {
+        writer.Append((BreakEvent)(1 + (i++ & 3)));
+    });
+    writer.Stop();
+    ctx.Report("written", (double)writer.Written(), "count");
+    ctx.Report("append_waits", (double)writer.Waits(), "count");
+    ctx.Check("dropped", (double)writer.Dropped());
+    ctx.Check("lost", (double)(i - writer.Written()));
+
+    // 重启后周期编号接着文件中最后一条记录
+    BreakRecord before{};
+    BreakRecord after{};
+    const bool hadLast = ReadLastRecord(path, before);
+    BreakLogWriter restarted;
+    restarted.Start(path);
+    restarted.Append(BreakEvent::Shown);
+    restarted.Stop();
+    ctx.Check("cycle_reused", hadLast && ReadLastRecord(path, after) && after.cycle == before.cycle + 1 ? 0.0 : 1.0, 0, "bool");
+
+    std::filesystem::remove_all(dir, ec);
+}
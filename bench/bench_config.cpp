@@ -0,0 +1,393 @@
+#include "bench.h"
+
+#include <climits>
+#include <cstdio>
+#include <cwchar>
+#include <cwctype>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+#include "config.h"
+#include "config_schema.h"
+#include "utf8.h"
+
+static std::string SampleIni()
+{
+    AppConfig cfg;
+    cfg.intervalMinutes = 45;
+    cfg.opacityPercent = 72;
+    cfg.fadeSeconds = 3;
+    cfg.bgColor = MakeColor(0x12, 0x34, 0x56);
+    cfg.autoStart = true;
+
+    std::string ini;
+    Config_SerializeIni(cfg, ini);
+    return ini;
+}
+
+static std::string ReadWholeFile(const std::filesystem::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static bool WideKeyEquals(std::wstring_view a, std::wstring_view b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (std::towlower(a[i]) != std::towlower(b[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 模拟原先的 GetPrivateProfile*W：每个键都重新打开文件、转换为宽字符并逐行查找；
+// 节名与键名不区分大小写，同名的键取第一个
+static std::wstring LegacyLookup(const std::string& bytes, const wchar_t* key, const wchar_t* def)
+{
+    const std::wstring wide = Utf8ToWide(bytes);
+    bool inSection = false;
+    size_t pos = 0;
+    while (pos < wide.size())
+    {
+        size_t eol = wide.find(L'\n', pos);
+        if (eol == std::wstring::npos) eol = wide.size();
+        std::wstring line = wide.substr(pos, eol - pos);
+        pos = eol + 1;
+        while (!line.empty() && (line.back() == L'\r' || line.back() == L' ')) line.pop_back();
+        if (!line.empty() && line[0] == L'[')
+        {
+            // 方括号内的空白忽略
+            std::wstring_view name(line);
+            name.remove_prefix(1);
+            if (!name.empty() && name.back() == L']') name.remove_suffix(1);
+            while (!name.empty() && name.back() == L' ') name.remove_suffix(1);
+            while (!name.empty() && name.front() == L' ') name.remove_prefix(1);
+            inSection = WideKeyEquals(name, L"General");
+            continue;
+        }
+        const size_t eq = line.find(L'=');
+        if (!inSection || eq == std::wstring::npos)
+        {
+            continue;
+        }
+        std::wstring_view name(line.data(), eq);
+        while (!name.empty() && name.back() == L' ') name.remove_suffix(1);
+        while (!name.empty() && name.front() == L' ') name.remove_prefix(1);
+        if (WideKeyEquals(name, key))
+        {
+            return line.substr(eq + 1);
+        }
+    }
+    return def;
+}
+
+static void LegacyLoad(const std::string& bytes, AppConfig& cfg)
+{
+    cfg = AppConfig{};
+    cfg.intervalMinutes = (int)std::wcstol(LegacyLookup(bytes, L"IntervalMinutes", L"15").c_str(), nullptr, 10);
+    cfg.opacityPercent = (int)std::wcstol(LegacyLookup(bytes, L"OpacityPercent", L"60").c_str(), nullptr, 10);
+    cfg.fadeSeconds = (int)std::wcstol(LegacyLookup(bytes, L"FadeSeconds", L"5").c_str(), nullptr, 10);
+    cfg.autoStart = std::wcstol(LegacyLookup(bytes, L"AutoStart", L"0").c_str(), nullptr, 10) != 0;
+    ColorRef color{};
+    if (TryParseHexColor(LegacyLookup(bytes, L"BgColorHex", L"#000000"), color))
+    {
+        cfg.bgColor = color;
+    }
+    Config_Normalize(cfg);
+}
+
+SSR_BENCH(ConfigLoad)
+{
+    const std::string ini = SampleIni();
+    AppConfig cfg;
+
+    ctx.Run("parse_schema", [&]
+    {
+        Config_ParseIni(ini, cfg);
+        Config_Normalize(cfg);
+        Bench_Consume(cfg);
+    });
+
+    ctx.Run("parse_legacy_per_key", [&]
+    {
+        LegacyLoad(ini, cfg);
+        Bench_Consume(cfg);
+    });
+
+    const std::filesystem::path dir = Bench_TempDir("config");
+    if (dir.empty())
+    {
+        ctx.Check("tempdir_failed", 1, 0, "bool");
+        return;
+    }
+    const auto path = dir / "config.ini";
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << ini;
+    }
+
+    ctx.Run("file_schema", [&]
+    {
+        Config_ParseIni(ReadWholeFile(path), cfg);
+        Config_Normalize(cfg);
+        Bench_Consume(cfg);
+    });
+
+    ctx.Run("file_legacy_per_key", [&]
+    {
+        // 原实现每个键各打开一次文件
+        std::string bytes;
+        for (int i = 0; i < 5; i++)
+        {
+            bytes = ReadWholeFile(path);
+        }
+        LegacyLoad(bytes, cfg);
+        Bench_Consume(cfg);
+    });
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+}
+
+SSR_BENCH(ConfigSave)
+{
+    AppConfig cfg;
+    std::string out;
+    ctx.Run("serialize_schema", [&]
+    {
+        Config_SerializeIni(cfg, out);
+        Bench_Consume(out);
+    });
+}
+
+SSR_BENCH(ConfigValidate)
+{
+    AppConfig cfg;
+    std::wstring error;
+    int i = 0;
+    ctx.Run("validate_normalize", [&]
+    {
+        cfg.intervalMinutes = (i++ & 1) ? 0 : 30;
+        const bool ok = Config_Validate(cfg, error);
+        Config_Normalize(cfg);
+        Bench_Consume(ok);
+    });
+}
+
+namespace
+{
+    template <typename Field>
+    bool SameField(const Field& field, const AppConfig& a, const AppConfig& b)
+    {
+        return a.*field.member == b.*field.member;
+    }
+
+    std::string WithKeyCase(std::string ini, bool upper)
+    {
+        for (char& ch : ini)
+        {
+            if (upper && ch >= 'a' && ch <= 'z') ch = (char)(ch - 'a' + 'A');
+            if (!upper && ch >= 'A' && ch <= 'Z') ch = (char)(ch - 'A' + 'a');
+        }
+        return ini;
+    }
+
+    // 先序列化再解析，回到同一个值
+    template <typename Field>
+    int RoundTrip(const Field& field, const AppConfig& cfg)
+    {
+        std::string ini;
+        Config_SerializeIni(cfg, ini);
+        AppConfig back;
+        Config_ParseIni(ini, back);
+        return SameField(field, cfg, back) ? 0 : 1;
+    }
+
+    // 超出范围的值经 Config_Normalize 后等于 expected，且 Config_Validate 先给出错误信息
+    template <typename Field, typename Value>
+    int Clamped(const Field& field, Value value, Value expected)
+    {
+        AppConfig cfg;
+        cfg.*field.member = value;
+        std::wstring error;
+        const bool rejected = !Config_Validate(cfg, error) && !error.empty();
+        Config_Normalize(cfg);
+        return cfg.*field.member == expected && rejected ? 0 : 1;
+    }
+
+    int CheckField(const IntField& f)
+    {
+        int bad = 0;
+        for (int v : { f.minValue, f.maxValue, f.defaultValue, f.minValue + (f.maxValue - f.minValue) / 2 })
+        {
+            AppConfig cfg;
+            cfg.*f.member = v;
+            bad += RoundTrip(f, cfg);
+        }
+        bad += Clamped(f, f.minValue - 1, f.minValue);
+        bad += Clamped(f, f.maxValue + 1, f.maxValue);
+        bad += Clamped(f, INT_MIN, f.minValue);
+        bad += Clamped(f, INT_MAX, f.maxValue);
+        // 文件里超出 int 的数字按 GetPrivateProfileInt 的方式截断后再收进范围
+        AppConfig cfg;
+        Config_ParseIni(std::string("[General]\r\n") + f.key + "=99999999999\r\n", cfg);
+        Config_Normalize(cfg);
+        bad += cfg.*f.member == f.maxValue ? 0 : 1;
+        return bad;
+    }
+
+    int CheckField(const BoolField& f)
+    {
+        int bad = 0;
+        for (bool v : { true, false })
+        {
+            AppConfig cfg;
+            cfg.*f.member = v;
+            bad += RoundTrip(f, cfg);
+        }
+        return bad;
+    }
+
+    int CheckField(const ColorField& f)
+    {
+        int bad = 0;
+        for (ColorRef v : { MakeColor(0, 0, 0), MakeColor(0xFF, 0xFF, 0xFF), MakeColor(0x12, 0xAB, 0x7F), f.defaultValue })
+        {
+            AppConfig cfg;
+            cfg.*f.member = v;
+            bad += RoundTrip(f, cfg);
+        }
+        // 高字节不是颜色的一部分
+        AppConfig cfg;
+        cfg.*f.member = 0xFF123456u;
+        Config_Normalize(cfg);
+        bad += cfg.*f.member == 0x00123456u ? 0 : 1;
+        return bad;
+    }
+
+    int CheckField(const ChoiceField& f)
+    {
+        int bad = 0;
+        for (int v = 0; v < f.count; v++)
+        {
+            AppConfig cfg;
+            cfg.*f.member = v;
+            bad += RoundTrip(f, cfg);
+        }
+        bad += Clamped(f, -1, f.defaultValue);
+        bad += Clamped(f, f.count, f.defaultValue);
+        return bad;
+    }
+
+    // 文字保存在 text.txt，ini 中只读不写
+    int CheckField(const TextField& f)
+    {
+        int bad = 0;
+        AppConfig cfg;
+        Config_ParseIni(std::string("[General]\r\n") + f.key + "= \xE8\xB5\xB7\xE6\x9D\xA5\xE8\xB5\xB0\xE8\xB5\xB0 \r\n", cfg);
+        bad += cfg.*f.member == L"\u8D77\u6765\u8D70\u8D70" ? 0 : 1;
+        std::string ini;
+        Config_SerializeIni(cfg, ini);
+        bad += ini.find(f.key) == std::string::npos ? 0 : 1;
+        (cfg.*f.member).assign((size_t)f.maxLength + 10, L'x');
+        Config_Normalize(cfg);
+        bad += (cfg.*f.member).size() == (size_t)f.maxLength ? 0 : 1;
+        return bad;
+    }
+
+    int CheckField(const RegionField& f)
+    {
+        int bad = 0;
+        for (const char* v : { "", "*:-75%,0,100%,25%", "2:+0,0,0,0" })
+        {
+            AppConfig cfg;
+            cfg.*f.member = v;
+            bad += RoundTrip(f, cfg);
+        }
+        bad += Clamped(f, std::string("not a rule"), std::string(f.defaultValue));
+        bad += Clamped(f, std::string((size_t)f.maxLength + 1, '*'), std::string(f.defaultValue));
+        return bad;
+    }
+
+    int CheckField(const PathField& f)
+    {
+        int bad = 0;
+        for (const wchar_t* v : { L"", L"clips/\u773C\u4FDD\u5065\u64CD.gif", L"C:\\Anim\\stretch.APNG" })
+        {
+            AppConfig cfg;
+            cfg.*f.member = v;
+            bad += RoundTrip(f, cfg);
+        }
+        bad += Clamped(f, std::wstring(L"clip.mp4"), std::wstring(f.defaultValue));
+        bad += Clamped(f, std::wstring((size_t)f.maxLength, L'a') + L".gif", std::wstring(f.defaultValue));
+        return bad;
+    }
+}
+
+SSR_BENCH(ConfigRoundTrip)
+{
+    // 每个字段：序列化后解析回到同一个值，超出范围的值被收进范围
+    int fieldFailures = 0;
+    Config_ForEachField([&](const auto& field) { fieldFailures += CheckField(field); });
+
+    // 键名与节名的大小写、不认识的键、其他节中的同名键、重复的键：与 GetPrivateProfile* 的结果一致
+    AppConfig custom;
+    custom.intervalMinutes = 45;
+    custom.opacityPercent = 72;
+    custom.fadeSeconds = 3;
+    custom.bgColor = MakeColor(0x12, 0x34, 0x56);
+    custom.autoStart = true;
+    custom.fullscreenMode = 2;
+    custom.overlayRegions = "*:-75%,0,100%,25%";
+    custom.animation = L"eyes.gif";
+    std::string ini;
+    Config_SerializeIni(custom, ini);
+
+    int keyFailures = 0;
+    const std::string variants[] = {
+        WithKeyCase(ini, true),
+        WithKeyCase(ini, false),
+        "[Other]\r\nIntervalMinutes=7\r\n" + ini + "Bogus=1\r\nIntervalMinutesX=9\r\nIntervalMinutes=8\r\n[Other]\r\nFadeSeconds=9\r\n",
+        "; comment\r\n[ general ]\r\n  intervalminutes = 45\r\nOPACITYPERCENT=72\r\nFadeSeconds=3\r\nbgcolorhex=#123456\r\nAutoStart=1\r\n"
+            "FullscreenMode=suppress\r\nOverlayRegions=*:-75%,0,100%,25%\r\nANIMATION=eyes.gif\r\n",
+    };
+    for (const std::string& variant : variants)
+    {
+        AppConfig parsed;
+        Config_ParseIni(variant, parsed);
+        Config_ForEachField([&](const auto& field)
+        {
+            // 全部转成大写或小写时选项名与路径也变了，只比较数值类字段
+            using Field = std::decay_t<decltype(field)>;
+            if constexpr (std::is_same_v<Field, IntField> || std::is_same_v<Field, BoolField> || std::is_same_v<Field, ColorField>)
+            {
+                keyFailures += SameField(field, custom, parsed) ? 0 : 1;
+            }
+        });
+        AppConfig legacy;
+        LegacyLoad(variant, legacy);
+        Config_Normalize(parsed);
+        keyFailures += parsed.intervalMinutes == legacy.intervalMinutes && parsed.opacityPercent == legacy.opacityPercent &&
+            parsed.fadeSeconds == legacy.fadeSeconds && parsed.autoStart == legacy.autoStart && parsed.bgColor == legacy.bgColor ? 0 : 1;
+    }
+    {
+        AppConfig parsed;
+        Config_ParseIni(variants[2], parsed);
+        keyFailures += parsed.fullscreenMode == 2 && parsed.overlayRegions == custom.overlayRegions && parsed.animation == custom.animation ? 0 : 1;
+        Config_ParseIni(variants[3], parsed);
+        keyFailures += Config_FieldIndex("fadeseconds") == Config_FieldIndex(kFieldFade.key) && Config_FieldIndex("Fade") < 0 ? 0 : 1;
+    }
+
+    ctx.Check("field_failures", (double)fieldFailures);
+    ctx.Check("key_mismatches", (double)keyFailures);
+}
@@ -0,0 +1,330 @@
+#include "bench.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "config_layers.h"
+#include "config_schema.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    fs::path LayersDir(const char* tag)
+    {
+#ifdef _WIN32
+        return fs::path(std::string("ssr-layers-") + tag);
+#else
+        return fs::path("/tmp/ssr-layers-" + std::to_string((long)getpid()) + "-" + tag);
+#endif
+    }
+
+    void WriteFile(const fs::path& path, const std::string& bytes)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), (std::streamsize)bytes.size());
+    }
+
+    // 修改时间前移一秒，模拟重新下发了内容相同的文件
+    void Touch(const fs::path& path)
+    {
+        std::error_code ec;
+        fs::last_write_time(path, fs::last_write_time(path, ec) + std::chrono::seconds(1), ec);
+    }
+
+    bool SameConfig(const AppConfig& a, const AppConfig& b)
+    {
+        std::string ia;
+        std::string ib;
+        Config_SerializeIni(a, ia);
+        Config_SerializeIni(b, ib);
+        return ia == ib && a.text == b.text;
+    }
+
+    struct LayerFiles
+    {
+        fs::path root;
+        fs::path policy;
+        fs::path userIni;
+        fs::path userText;
+
+        explicit LayerFiles(const char* tag) : root(LayersDir(tag))
+        {
+            std::error_code ec;
+            fs::remove_all(root, ec);
+            policy = root / "policy";
+            fs::create_directories(policy, ec);
+            userIni = root / "config.ini";
+            userText = root / "text.txt";
+        }
+
+        ~LayerFiles()
+        {
+            std::error_code ec;
+            fs::remove_all(root, ec);
+        }
+
+        void Sources(LayeredConfig& layers) const
+        {
+            layers.SetSources(policy, userIni, userText);
+        }
+    };
+
+    // 策略文件：大量注释与无关节，真正的键只有几行
+    std::string LargePolicy(size_t bytes)
+    {
+        std::string ini = "; 由组策略下发，请勿手工修改\r\n[General]\r\nIntervalMinutes=45\r\nBgColorHex=#203040\r\n";
+        ini += "[Locked]\r\nIntervalMinutes=1\r\n[Limits]\r\nFadeSecondsMin=2\r\n";
+        size_t i = 0;
+        while (ini.size() < bytes)
+        {
+            ini += "; 第 " + std::to_string(i) + " 条说明：此处记录策略变更历史，与提醒程序无关\r\n";
+            if (i % 64 == 0)
+            {
+                ini += "[Inventory" + std::to_string(i) + "]\r\nAsset=PC-" + std::to_string(i) + "\r\nOwner=IT\r\n";
+            }
+            i++;
+        }
+        return ini;
+    }
+}
+
+SSR_BENCH(ConfigLayersPrecedence)
+{
+    LayerFiles files("precedence");
+    int mismatches = 0;
+    auto expect = [&](bool ok) { mismatches += ok ? 0 : 1; };
+
+    // 只有用户层
+    WriteFile(files.userIni, "[General]\r\nIntervalMinutes=20\r\nBgColorHex=#112233\r\n");
+    {
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.Load();
+        expect(layers.Merged().intervalMinutes == 20 && layers.Locked() == 0);
+        expect(layers.Merged().opacityPercent == kFieldOpacity.defaultValue);
+    }
+
+    // 策略给出取值但不锁定：用户层覆盖
+    WriteFile(files.policy / "10-base.ini", "[General]\r\nIntervalMinutes=30\r\nOpacityPercent=80\r\n");
+    {
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.Load();
+        expect(layers.Merged().intervalMinutes == 20);
+        expect(layers.Merged().opacityPercent == 80);
+    }
+
+    // 锁定：用户层对该键的设置被忽略，其他键照常
+    WriteFile(files.policy / "10-base.ini", "[General]\r\nIntervalMinutes=30\r\n[Locked]\r\nIntervalMinutes=1\r\nText=1\r\n");
+    WriteFile(files.policy / "text.txt", "请按公司规定休息。");
+    WriteFile(files.userText, "我自己的提醒");
+    {
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.Load();
+        const int interval = Config_FieldIndex(kFieldInterval.key);
+        const int text = Config_FieldIndex(kFieldText.key);
+        expect(layers.Merged().intervalMinutes == 30);
+        expect(layers.Merged().text == L"请按公司规定休息。");
+        expect(layers.Merged().bgColor == MakeColor(0x11, 0x22, 0x33));
+        expect(layers.Locked() == (Config_FieldBit(interval) | Config_FieldBit(text)));
+
+        // 保存用户文件时不写出被锁定的键
+        std::string ini;
+        Config_SerializeIni(layers.Merged(), ini, layers.Locked());
+        expect(ini.find(kFieldInterval.key) == std::string::npos && ini.find(kFieldBgColor.key) != std::string::npos);
+    }
+
+    // 后面的策略文件覆盖前面的取值与范围；锁定取并集，后面的文件不能解锁；范围收窄用户的取值
+    WriteFile(files.policy / "20-site.ini", "[General]\r\nIntervalMinutes=40\r\n[Locked]\r\nText=0\r\n[Limits]\r\nFadeSecondsMin=3\r\nFadeSecondsMax=6\r\n");
+    WriteFile(files.userIni, "[General]\r\nIntervalMinutes=20\r\nFadeSeconds=1\r\nBgColorHex=#112233\r\n");
+    {
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.Load();
+        expect(layers.Merged().intervalMinutes == 40);
+        expect(layers.Merged().fadeSeconds == 3);
+        expect(layers.Merged().text == L"请按公司规定休息。");
+
+        AppConfig candidate = layers.Merged();
+        std::wstring error;
+        candidate.fadeSeconds = 8;
+        expect(!Config_CheckPolicy(layers.Policy(), candidate, error) && !error.empty());
+        candidate.fadeSeconds = 5;
+        expect(Config_CheckPolicy(layers.Policy(), candidate, error));
+    }
+
+    // 只写了上限的策略文件不覆盖前面文件的下限
+    WriteFile(files.policy / "25-max.ini", "[Limits]\r\nFadeSecondsMax=8\r\n");
+    {
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.Load();
+        expect(layers.Merged().fadeSeconds == 3);
+
+        AppConfig candidate = layers.Merged();
+        std::wstring error;
+        candidate.fadeSeconds = 2;
+        expect(!Config_CheckPolicy(layers.Policy(), candidate, error));
+        candidate.fadeSeconds = 7;
+        expect(Config_CheckPolicy(layers.Policy(), candidate, error));
+        candidate.fadeSeconds = 9;
+        expect(!Config_CheckPolicy(layers.Policy(), candidate, error));
+    }
+    {
+        std::error_code ec;
+        fs::remove(files.policy / "25-max.ini", ec);
+    }
+
+    // 同一个文件中上下限写反时交换并报告；与前面文件的下限冲突时以后面的文件为准
+    WriteFile(files.policy / "25-swapped.ini", "[Limits]\r\nFadeSecondsMin=9\r\nFadeSecondsMax=4\r\n");
+    {
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.Load();
+        expect(layers.Merged().fadeSeconds == 4 && layers.Problems().size() == 1);
+        AppConfig candidate = layers.Merged();
+        std::wstring error;
+        candidate.fadeSeconds = 9;
+        expect(Config_CheckPolicy(layers.Policy(), candidate, error));
+    }
+    WriteFile(files.policy / "25-swapped.ini", "[Limits]\r\nFadeSecondsMax=2\r\n");
+    {
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.Load();
+        expect(layers.Merged().fadeSeconds == 2 && layers.Problems().size() == 1);
+        AppConfig candidate = layers.Merged();
+        std::wstring error;
+        expect(Config_CheckPolicy(layers.Policy(), candidate, error));
+    }
+    {
+        std::error_code ec;
+        fs::remove(files.policy / "25-swapped.ini", ec);
+    }
+
+    // 缓存：没变的层不读取；只改了时间的层只计算哈希；改了内容的层重新解析
+    {
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.Load();
+        const AppConfig first = layers.Merged();
+        const ConfigLayerStats before = layers.Stats();
+        expect(!layers.Load());
+        expect(layers.Stats().parsed == before.parsed && layers.Stats().merges == before.merges);
+
+        Touch(files.policy / "10-base.ini");
+        expect(!layers.Load());
+        expect(layers.Stats().hashed == before.hashed + 1 && layers.Stats().parsed == before.parsed);
+
+        WriteFile(files.userIni, "[General]\r\nIntervalMinutes=20\r\nFadeSeconds=5\r\nBgColorHex=#445566\r\n");
+        Touch(files.userIni);
+        expect(layers.Load());
+        expect(layers.Stats().parsed == before.parsed + 1);
+        expect(layers.Merged().bgColor == MakeColor(0x44, 0x55, 0x66) && layers.Merged().fadeSeconds == 5);
+        expect(!SameConfig(first, layers.Merged()));
+
+        // 下次启动从磁盘缓存恢复，不解析任何一层
+        const fs::path cache = files.root / "config.cache";
+        expect(layers.SaveCache(cache));
+        LayeredConfig restarted;
+        files.Sources(restarted);
+        expect(restarted.LoadCache(cache));
+        expect(!restarted.Load());
+        expect(restarted.Stats().parsed == 0 && SameConfig(restarted.Merged(), layers.Merged()));
+        expect(restarted.Locked() == layers.Locked());
+
+        // 删除策略文件后锁定随之解除，用户层重新生效
+        std::error_code ec;
+        fs::remove(files.policy / "10-base.ini", ec);
+        expect(restarted.Load());
+        expect(restarted.Locked() == 0);
+        expect(restarted.Merged().text == L"我自己的提醒" && restarted.Merged().intervalMinutes == 20);
+    }
+
+    // 第一次读取就失败（超过大小上限）的策略层锁定全部键并报告，不进缓存，缓存仍能完整读回
+    {
+        const fs::path huge = files.policy / "30-huge.ini";
+        WriteFile(huge, "");
+        std::error_code ec;
+        fs::resize_file(huge, 17ull * 1024 * 1024, ec);
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.Load();
+        expect(layers.Locked() == (std::uint32_t)((1ull << CONFIG_FIELD_COUNT) - 1) && layers.Problems().size() == 1);
+        expect(layers.Merged().intervalMinutes == 40);
+        const fs::path cache = files.root / "config-partial.cache";
+        expect(!ec && layers.SaveCache(cache));
+        LayeredConfig restarted;
+        files.Sources(restarted);
+        expect(restarted.LoadCache(cache));
+        restarted.Load();
+        expect(restarted.Stats().parsed == 0 && SameConfig(restarted.Merged(), layers.Merged()));
+        expect(restarted.Locked() == layers.Locked());
+
+        // 读到之后锁定解除；之后再读不到时沿用上次的内容
+        WriteFile(huge, "[General]\r\nOpacityPercent=70\r\n");
+        Touch(huge);
+        expect(layers.Load());
+        expect(layers.Merged().opacityPercent == 70 && layers.Locked() == 0 && layers.Problems().empty());
+        fs::resize_file(huge, 17ull * 1024 * 1024, ec);
+        Touch(huge);
+        expect(layers.Load());
+        expect(layers.Merged().opacityPercent == 70 && layers.Locked() == 0 && layers.Problems().size() == 1);
+        fs::remove(huge, ec);
+    }
+
+    ctx.Check("mismatches", (double)mismatches);
+}
+
+SSR_BENCH(ConfigLayersMerge)
+{
+    LayerFiles files("merge");
+    const std::string policy = LargePolicy(2 * 1024 * 1024);
+    WriteFile(files.policy / "10-fleet.ini", policy);
+    WriteFile(files.policy / "text.txt", "请按公司规定休息。");
+    WriteFile(files.userIni, "[General]\r\nIntervalMinutes=20\r\nBgColorHex=#112233\r\n");
+    WriteFile(files.userText, "我自己的提醒");
+    ctx.Report("policy_bytes", (double)policy.size(), "bytes");
+
+    // 每次都从头解析所有层（没有缓存时的启动）
+    ctx.Run("cold_load", [&]
+    {
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.Load();
+        Bench_Consume(layers.Merged().intervalMinutes);
+    });
+
+    // 重新加载，各层都没变：只检查大小与修改时间
+    LayeredConfig warm;
+    files.Sources(warm);
+    warm.Load();
+    ctx.Run("reload_unchanged", [&] { Bench_Consume(warm.Load()); });
+
+    // 策略被重新下发但内容相同：读取并计算哈希，不解析
+    ctx.Run("reload_touched", [&]
+    {
+        Touch(files.policy / "10-fleet.ini");
+        Bench_Consume(warm.Load());
+    });
+
+    // 带磁盘缓存的启动
+    const fs::path cache = files.root / "config.cache";
+    warm.SaveCache(cache);
+    ctx.Run("startup_cached", [&]
+    {
+        LayeredConfig layers;
+        files.Sources(layers);
+        layers.LoadCache(cache);
+        layers.Load();
+        Bench_Consume(layers.Merged().intervalMinutes);
+    });
+    ctx.Check("interval_locked", warm.Merged().intervalMinutes == 45 ? 1 : 0, 1, "bool");
+}
@@ -0,0 +1,252 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "control_server.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // 模拟界面线程：I/O 线程只把整批请求交过来，应答在这里生成后再交回
+    class FakeUiThread
+    {
+    public:
+        explicit FakeUiThread(ControlServer& server) : m_server(server), m_thread([this] { Run(); }) {}
+
+        ~FakeUiThread()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_one();
+            m_thread.join();
+        }
+
+        void Submit(std::vector<ControlRequest>& batch)
+        {
+            bool notify;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                notify = m_inbox.empty();
+                for (auto& r : batch)
+                {
+                    m_inbox.push_back(std::move(r));
+                }
+            }
+            if (notify)
+            {
+                m_cv.notify_one();
+            }
+        }
+
+        std::uint64_t Wakeups() const { return m_wakeups; }
+
+    private:
+        void Run()
+        {
+            std::vector<ControlRequest> work;
+            std::vector<ControlResponse> responses;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cv.wait(lock, [this] { return m_stop || !m_inbox.empty(); });
+                    if (m_stop)
+                    {
+                        return;
+                    }
+                    work.swap(m_inbox);
+                }
+                m_wakeups++;
+                for (auto& r : work)
+                {
+                    ControlResponse response;
+                    response.client = r.client;
+                    response.id = r.id;
+                    response.body = r.op == ControlOp::Status ? "state=Hidden\nnext_ms=900000\n" : "";
+                    responses.push_back(std::move(response));
+                }
+                work.clear();
+                m_server.Respond(responses);
+            }
+        }
+
+        ControlServer& m_server;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::vector<ControlRequest> m_inbox;
+        bool m_stop = false;
+        std::uint64_t m_wakeups = 0;
+        std::thread m_thread;
+    };
+
+    struct LoadResult
+    {
+        double seconds = 0;
+        std::uint64_t requests = 0;
+        std::uint64_t failures = 0;
+        std::vector<double> latenciesUs;
+    };
+
+    // clients 个连接各自发送 perClient 条请求，每次最多 depth 条在途
+    void RunLoad(const std::string& endpoint, int clients, int perClient, int depth, LoadResult& out)
+    {
+        using Clock = std::chrono::steady_clock;
+        std::vector<std::vector<double>> latencies((size_t)clients);
+        std::atomic<std::uint64_t> failures{0};
+        std::vector<std::thread> threads;
+
+        const auto start = Clock::now();
+        for (int t = 0; t < clients; t++)
+        {
+            threads.emplace_back([&, t]
+            {
+                ControlClient client;
+                if (!client.Connect(endpoint, 2000))
+                {
+                    failures.fetch_add((std::uint64_t)perClient);
+                    return;
+                }
+                std::vector<Clock::time_point> sent((size_t)depth);
+                auto& samples = latencies[(size_t)t];
+                samples.reserve((size_t)perClient);
+                ControlResponse response;
+                for (int done = 0; done < perClient; done += depth)
+                {
+                    const int n = std::min(depth, perClient - done);
+                    for (int i = 0; i < n; i++)
+                    {
+                        sent[(size_t)i] = Clock::now();
+                        client.Send((std::uint32_t)(done + i), ControlOp::Status);
+                    }
+                    for (int i = 0; i < n; i++)
+                    {
+                        if (!client.Receive(response) || response.id != (std::uint32_t)(done + i))
+                        {
+                            failures.fetch_add(1);
+                            continue;
+                        }
+                        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent[(size_t)i]).count());
+                    }
+                }
+            });
+        }
+        for (auto& th : threads)
+        {
+            th.join();
+        }
+        out.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        out.failures = failures.load();
+        out.latenciesUs.clear();
+        for (auto& samples : latencies)
+        {
+            out.latenciesUs.insert(out.latenciesUs.end(), samples.begin(), samples.end());
+        }
+        out.requests = out.latenciesUs.size();
+        std::sort(out.latenciesUs.begin(), out.latenciesUs.end());
+    }
+
+    double Percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        const size_t index = std::min(sorted.size() - 1, (size_t)(p * (double)(sorted.size() - 1)));
+        return sorted[index];
+    }
+
+    void ReportLoad(BenchContext& ctx, const char* prefix, const LoadResult& r)
+    {
+        const std::string p(prefix);
+        ctx.Report((p + "_rps").c_str(), r.seconds > 0 ? (double)r.requests / r.seconds : 0, "req/s");
+        ctx.Report((p + "_p50").c_str(), Percentile(r.latenciesUs, 0.50), "us");
+        ctx.Report((p + "_p99").c_str(), Percentile(r.latenciesUs, 0.99), "us");
+        ctx.Check((p + "_failures").c_str(), (double)r.failures);
+    }
+}
+
+SSR_BENCH(ControlLoad)
+{
+    std::string endpoint = ControlServer::DefaultEndpoint();
+#ifndef _WIN32
+    endpoint = "/tmp/ssr-bench-" + std::to_string((long)getpid()) + ".sock";
+#else
+    endpoint += ".bench";
+#endif
+
+    ControlServer server;
+    std::unique_ptr<FakeUiThread> ui = std::make_unique<FakeUiThread>(server);
+    if (!server.Start(endpoint, [&](std::vector<ControlRequest>& batch) { ui->Submit(batch); }))
+    {
+        ctx.Check("start_failed", 1, 0, "bool");
+        return;
+    }
+
+    // 每个连接只有一条请求在途：衡量往返延迟
+    LoadResult roundtrip;
+    RunLoad(endpoint, 64, 2000, 1, roundtrip);
+    ReportLoad(ctx, "roundtrip", roundtrip);
+
+    // 每个连接连续发送 32 条再收：衡量批处理后的吞吐
+    LoadResult pipelined;
+    RunLoad(endpoint, 64, 4096, 32, pipelined);
+    ReportLoad(ctx, "pipelined", pipelined);
+
+    const ControlServerStats stats = server.GetStats();
+    ctx.Report("connections", (double)stats.connections, "count");
+    ctx.Report("avg_batch", stats.batches ? (double)stats.requests / (double)stats.batches : 0, "req");
+    ctx.Report("max_batch", (double)stats.maxBatch, "req");
+    ctx.Report("ui_wakeups", (double)ui->Wakeups(), "count");
+    ctx.Check("protocol_errors", (double)stats.protocolErrors);
+
+    server.Stop();
+    ui.reset();
+}
+
+SSR_BENCH(ControlReceiveTimeout)
+{
+    // 服务端收下请求但不应答：客户端按 Connect 的超时返回失败，而不是一直阻塞
+    std::string endpoint = ControlServer::DefaultEndpoint();
+#ifndef _WIN32
+    endpoint = "/tmp/ssr-bench-timeout-" + std::to_string((long)getpid()) + ".sock";
+#else
+    endpoint += ".timeout";
+#endif
+
+    ControlServer server;
+    std::atomic<int> received{0};
+    if (!server.Start(endpoint, [&](std::vector<ControlRequest>& batch) { received.fetch_add((int)batch.size()); }))
+    {
+        ctx.Check("start_failed", 1, 0, "bool");
+        return;
+    }
+
+    const std::uint32_t timeoutMs = 100;
+    ControlClient client;
+    ControlResponse response;
+    const auto start = std::chrono::steady_clock::now();
+    const bool connected = client.Connect(endpoint, timeoutMs);
+    const bool answered = connected && client.Call(ControlOp::Status, {}, response);
+    const double waitedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    client.Close();
+    server.Stop();
+
+    ctx.Report("waited", waitedMs, "ms");
+    ctx.Check("connect_failed", connected ? 0 : 1, 0, "bool");
+    ctx.Check("answered", answered ? 1 : 0, 0, "bool");
+    ctx.Check("received", (double)received.load(), 1);
+    // 远超超时说明接收没有超时
+    ctx.Check("timeout_ignored", waitedMs > timeoutMs * 20.0 ? 1 : 0, 0, "bool");
+}
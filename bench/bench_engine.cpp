@@ -0,0 +1,55 @@
+#include "bench.h"
+
+#include "engine_log.h"
+#include "engine_sim.h"
+
+SSR_BENCH(EngineWeek)
+{
+    // 一周的虚拟时间：15 分钟间隔、每天改一次设置、定期预览与显示器变化
+    EngineSimOptions options;
+    EngineSimResult result;
+    ctx.Run("simulate_week", [&] { EngineSim_Run(options, result); });
+
+    ctx.Report("reminders", (double)result.reminders, "count");
+    ctx.Report("transitions", (double)result.transitions, "count");
+    ctx.Report("timer_firings", (double)result.timerFirings, "count");
+    ctx.Report("alpha_changes", (double)result.alphaChanges, "count");
+}
+
+SSR_BENCH(EngineReplay)
+{
+    EngineSimOptions options;
+    EngineSimResult simulated;
+    EngineRecorder recorder;
+    EngineSim_Run(options, simulated, &recorder);
+
+    EngineReplayResult replayed;
+    ctx.Run("replay_week", [&]
+    {
+        EngineReplay_Run(reinterpret_cast<const std::uint8_t*>(recorder.Data().data()), recorder.Data().size(), replayed);
+    });
+
+    // 回放必须逐字节重现同样的记录：同样的状态转移与透明度
+    ctx.Check("matched", replayed.matched ? 1.0 : 0.0, 1, "bool");
+    ctx.Report("checkpoints", (double)replayed.checkpoints, "count");
+    ctx.Report("log_bytes", (double)recorder.Data().size(), "bytes");
+    ctx.Report("log_records", (double)recorder.Records(), "count");
+    ctx.Report("virtual_hours", (double)replayed.durationMs / 3600000.0, "h");
+    ctx.Report("alpha_changes_delta", (double)replayed.alphaChanges - (double)simulated.alphaChanges, "count");
+
+    // 篡改一条计时器记录的时间增量，回放应在之后的第一个检查点发现差异
+    std::string tampered = recorder.Data();
+    const size_t at = tampered.size() / 2;
+    for (size_t i = at; i + 1 < tampered.size(); i++)
+    {
+        if (((std::uint8_t)tampered[i] & 0x0F) == (std::uint8_t)EngineRecordType::Timer && ((std::uint8_t)tampered[i] >> 4) == (std::uint8_t)EngineTimer::Anim
+            && (std::uint8_t)tampered[i + 1] < 0x40)
+        {
+            tampered[i + 1] = (char)((std::uint8_t)tampered[i + 1] + 0x20);
+            break;
+        }
+    }
+    EngineReplayResult diverged;
+    EngineReplay_Run(reinterpret_cast<const std::uint8_t*>(tampered.data()), tampered.size(), diverged);
+    ctx.Check("tampered_detected", diverged.matched ? 0.0 : 1.0, 1, "bool");
+}
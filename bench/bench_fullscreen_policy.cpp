@@ -0,0 +1,154 @@
+#include "bench.h"
+
+#include "config.h"
+#include "engine_sim.h"
+#include "fullscreen_policy.h"
+
+namespace
+{
+    // 假的前台状态来源，记录被探测的次数
+    class FakeForeground final : public ForegroundStateProvider
+    {
+    public:
+        ForegroundState Current(std::uint64_t) override
+        {
+            calls++;
+            return state;
+        }
+
+        ForegroundState state{};
+        std::uint64_t calls = 0;
+    };
+
+    ForegroundState MakeState(bool fullscreen, bool presentation, bool exclusive)
+    {
+        ForegroundState s;
+        s.fullscreen = fullscreen;
+        s.presentation = presentation;
+        s.exclusive = exclusive;
+        if (fullscreen)
+        {
+            s.monitor = ScreenRect{ 0, 0, 1920, 1080 };
+        }
+        return s;
+    }
+}
+
+SSR_BENCH(FullscreenPolicyDecide)
+{
+    // 决策表：模式 × 前台状态 × 显示器数量
+    struct Case { FullscreenMode mode; ForegroundState state; size_t monitors; FullscreenAction expect; };
+    const ForegroundState idle = MakeState(false, false, false);
+    const ForegroundState video = MakeState(true, false, false);
+    const ForegroundState slides = MakeState(false, true, false);
+    const ForegroundState game = MakeState(true, false, true);
+    const Case cases[] = {
+        { FullscreenMode::Show, video, 1, FullscreenAction::Show },
+        { FullscreenMode::Show, game, 2, FullscreenAction::Show },
+        { FullscreenMode::Defer, idle, 1, FullscreenAction::Show },
+        { FullscreenMode::Defer, video, 1, FullscreenAction::Defer },
+        { FullscreenMode::Defer, slides, 2, FullscreenAction::Defer },
+        { FullscreenMode::Defer, game, 1, FullscreenAction::Defer },
+        { FullscreenMode::Suppress, idle, 2, FullscreenAction::Show },
+        { FullscreenMode::Suppress, video, 2, FullscreenAction::Suppress },
+        { FullscreenMode::Suppress, game, 1, FullscreenAction::Suppress },
+        { FullscreenMode::OtherMonitors, idle, 2, FullscreenAction::Show },
+        { FullscreenMode::OtherMonitors, video, 2, FullscreenAction::ShowOthers },
+        { FullscreenMode::OtherMonitors, video, 1, FullscreenAction::Defer },
+        { FullscreenMode::OtherMonitors, slides, 2, FullscreenAction::Defer },
+        { FullscreenMode::OtherMonitors, game, 2, FullscreenAction::Defer },
+    };
+    int mismatches = 0;
+    for (const auto& c : cases)
+    {
+        mismatches += FullscreenPolicy_Decide(c.mode, c.state, c.monitors) == c.expect ? 0 : 1;
+    }
+    ctx.Check("decision_mismatches", (double)mismatches);
+
+    // 缓存：没有窗口事件时到点只读缓存，事件或超过最长缓存时间后才重新探测
+    FakeForeground fake;
+    ForegroundStateCache cache(fake, 5000);
+    int cacheViolations = 0;
+    cache.Current(1000);
+    cache.Current(2000);
+    cache.Current(5999);
+    cacheViolations += fake.calls == 1 ? 0 : 1;
+    fake.state = video;
+    cache.Invalidate();
+    cacheViolations += cache.Current(6000).fullscreen && fake.calls == 2 ? 0 : 1;
+    cache.Current(11000);
+    cacheViolations += fake.calls == 3 ? 0 : 1;
+    ctx.Check("cache_violations", (double)cacheViolations);
+
+    // 前台不是全屏时也走缓存：一小时内每秒一次评估，最多按最长缓存时间探测
+    fake.state = idle;
+    fake.calls = 0;
+    FullscreenPolicy policy(cache);
+    for (std::uint64_t t = 0; t < 3600 * 1000; t += 1000)
+    {
+        policy.Evaluate(FullscreenMode::Defer, 2, 20000 + t);
+    }
+    ctx.Report("probes_per_hour", (double)fake.calls, "count");
+
+    std::uint64_t now = 0;
+    ctx.Run("evaluate_cached", [&] { Bench_Consume(policy.Evaluate(FullscreenMode::OtherMonitors, 2, ++now)); });
+}
+
+SSR_BENCH(FullscreenPolicyEngine)
+{
+    AppConfig cfg;
+    Config_ApplyDefaults(cfg);
+    const std::uint64_t intervalMs = (std::uint64_t)cfg.intervalMinutes * 60 * 1000;
+    int violations = 0;
+
+    // 推迟：到点时前台全屏，保持隐藏，之后每 ENGINE_DEFER_RETRY_MS 重试，退出全屏后的第一次重试显示
+    {
+        FakeForeground fake;
+        fake.state = MakeState(true, false, false);
+        FullscreenPolicy policy(fake);
+        VirtualEngineHost host;
+        host.SetFullscreenPolicy(&policy, FullscreenMode::Defer, 1);
+        OverlayEngine engine(host);
+        engine.Start(0, cfg);
+        host.RunUntil(engine, intervalMs + 1);
+        violations += engine.State() == OverlayState::Hidden && !host.IsVisible() && policy.Stats().deferred == 1 ? 0 : 1;
+        host.RunUntil(engine, intervalMs + ENGINE_DEFER_RETRY_MS + 1);
+        violations += engine.State() == OverlayState::Hidden && policy.Stats().deferred == 2 ? 0 : 1;
+        fake.state = MakeState(false, false, false);
+        host.RunUntil(engine, intervalMs + 2 * ENGINE_DEFER_RETRY_MS + 1);
+        violations += host.reminders == 1 && engine.State() != OverlayState::Hidden ? 0 : 1;
+    }
+
+    // 跳过：本次不显示，重新按完整间隔计时
+    {
+        FakeForeground fake;
+        fake.state = MakeState(false, false, true);
+        FullscreenPolicy policy(fake);
+        VirtualEngineHost host;
+        host.SetFullscreenPolicy(&policy, FullscreenMode::Suppress, 2);
+        OverlayEngine engine(host);
+        engine.Start(0, cfg);
+        host.RunUntil(engine, 2 * intervalMs - 1);
+        violations += policy.Stats().suppressed == 1 && host.reminders == 0 ? 0 : 1;
+        host.RunUntil(engine, 2 * intervalMs + 1);
+        violations += policy.Stats().suppressed == 2 && engine.State() == OverlayState::Hidden ? 0 : 1;
+    }
+    ctx.Check("engine_violations", (double)violations);
+
+    // 一周模拟：定期全屏，策略随设置保存随机切换
+    EngineSimOptions options;
+    EngineSimResult result;
+    EngineSim_Run(options, result);
+    ctx.Report("sim_reminders", (double)result.reminders, "count");
+    ctx.Report("sim_deferred", (double)result.deferred, "count");
+    ctx.Report("sim_suppressed", (double)result.suppressed, "count");
+    ctx.Report("sim_partial", (double)result.partial, "count");
+
+    // 固定为“只显示在其他显示器”：全屏期间的提醒都应跳过全屏所在的显示器，而不是推迟
+    options.config.fullscreenMode = (int)FullscreenMode::OtherMonitors;
+    options.configChangeEveryMs = 0;
+    EngineSimResult others;
+    EngineSim_Run(options, others);
+    ctx.Report("others_partial", (double)others.partial, "count");
+    ctx.Report("others_deferred", (double)others.deferred, "count");
+}
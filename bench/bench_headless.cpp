@@ -0,0 +1,174 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "headless.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // 按输出行核对事件顺序：reminder → fade_in_done → dismiss → fade_out_done
+    struct EventChecker
+    {
+        int expected = 0;
+        std::uint64_t lines = 0;
+        std::uint64_t bytes = 0;
+        int violations = 0;
+
+        void operator()(std::string_view line)
+        {
+            lines++;
+            bytes += line.size();
+            if (line.size() < 2 || line.front() != '{' || line.back() != '}')
+            {
+                violations++;
+                return;
+            }
+            static constexpr const char* kCycle[] = { "\"reminder\"", "\"fade_in_done\"", "\"dismiss\"", "\"fade_out_done\"" };
+            for (int i = 0; i < 4; i++)
+            {
+                if (line.find(kCycle[i]) != std::string_view::npos)
+                {
+                    violations += i == expected ? 0 : 1;
+                    expected = (i + 1) % 4;
+                }
+            }
+            violations += line.find("\"error\"") != std::string_view::npos ? 1 : 0;
+        }
+    };
+}
+
+SSR_BENCH(HeadlessSoak)
+{
+    // 一周的虚拟时间：每次淡入完成 5 秒后自动关闭，穿插 stdin 命令与控制端点请求
+    const std::uint64_t weekMs = 7ull * 24 * 3600 * 1000;
+    EventChecker checker;
+    HeadlessOptions options;
+    options.stepClock = true;
+    options.autoActivityMs = 5000;
+    options.config.intervalMinutes = 20;
+    HeadlessRunner runner(options, [&](std::string_view line) { checker(line); });
+
+    const auto started = std::chrono::steady_clock::now();
+    runner.Start(0);
+    std::uint64_t requests = 0;
+    for (std::uint64_t hour = 1; runner.Now() < weekMs; hour++)
+    {
+        runner.Execute("advance 3600000", runner.Now());
+        if (hour % 5 == 0)
+        {
+            runner.Execute("snooze 7", runner.Now());
+        }
+        if (hour % 11 == 0)
+        {
+            runner.Execute("trigger", runner.Now());
+        }
+        if (hour % 13 == 0)
+        {
+            runner.Execute("display", runner.Now());
+        }
+        if (hour % 24 == 0)
+        {
+            runner.Execute("set FadeSeconds=" + std::to_string(1 + hour / 24 % 6), runner.Now());
+        }
+        ControlRequest request;
+        request.id = (std::uint32_t)hour;
+        request.op = hour % 2 ? ControlOp::Status : ControlOp::Metrics;
+        ControlResponse response;
+        runner.HandleControl(request, response, runner.Now());
+        checker.violations += response.status == ControlStatus::Ok && response.id == request.id && !response.body.empty() ? 0 : 1;
+        requests++;
+    }
+    runner.Finish(runner.Now(), 0);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    const HeadlessStats& stats = runner.Stats();
+    checker.violations += stats.reminders == stats.dismissals && stats.reminders > 0 ? 0 : 1;
+    ctx.Report("reminders", (double)stats.reminders, "count");
+    ctx.Report("events", (double)checker.lines, "count");
+    ctx.Report("control_requests", (double)requests, "count");
+    ctx.Report("events_per_sec", checker.lines / seconds, "events/s");
+    ctx.Report("sim_hours_per_sec", weekMs / 3600000.0 / seconds, "h/s");
+    ctx.Report("output_bytes", (double)checker.bytes, "bytes");
+    ctx.Check("violations", (double)checker.violations);
+}
+
+SSR_BENCH(HeadlessStartup)
+{
+    // 从入口到引擎启动的阶段耗时（分层设置各有一个文件，每次都是新的 runner），与 kStartupBudgetUs 比较
+    namespace fs = std::filesystem;
+#ifdef _WIN32
+    const fs::path root = "ssr-startup";
+#else
+    const fs::path root = "/tmp/ssr-startup-" + std::to_string((long)getpid());
+#endif
+    std::error_code ec;
+    fs::create_directories(root / "policy", ec);
+    auto write = [](const fs::path& path, const char* bytes)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << bytes;
+    };
+    write(root / "policy" / "10-base.ini", "[General]\nIntervalMinutes=30\n[Locked]\nIntervalMinutes=1\n");
+    write(root / "config.ini", "[General]\nFadeSeconds=3\nOpacity=80\n");
+    write(root / "text.txt", "休息一下，看看远处");
+
+    HeadlessOptions options;
+    options.stepClock = true;
+    options.policyDir = root / "policy";
+    options.configIni = root / "config.ini";
+    options.textFile = root / "text.txt";
+
+    const int runs = 200;
+    int overBudget = 0;
+    int missingEvents = 0;
+    std::uint64_t worstUs = 0;
+    std::uint64_t sumUs = 0;
+    std::uint64_t configUs = 0;
+    std::uint64_t engineUs = 0;
+    for (int i = 0; i < runs; i++)
+    {
+        StartupProfile startup;
+        startup.Begin();
+        options.startup = &startup;
+        bool sawStartup = false;
+        HeadlessRunner runner(options, [&](std::string_view line)
+        {
+            sawStartup |= line.find("\"startup\"") != std::string_view::npos && line.find("\"over_budget\"") != std::string_view::npos;
+        });
+        startup.Mark("runner");
+        runner.Start(0);
+        missingEvents += sawStartup && startup.IsFinished() ? 0 : 1;
+        overBudget += startup.OverBudget() ? 1 : 0;
+        worstUs = std::max(worstUs, startup.TotalUs());
+        sumUs += startup.TotalUs();
+        for (int p = 0; p < startup.PhaseCount(); p++)
+        {
+            const std::string name = startup.Phase(p).name;
+            if (name == "config_load")
+            {
+                configUs += startup.Phase(p).durUs;
+            }
+            else if (name == "engine_start")
+            {
+                engineUs += startup.Phase(p).durUs;
+            }
+        }
+    }
+    fs::remove_all(root, ec);
+
+    ctx.Report("startup_avg", (double)sumUs / runs, "us");
+    ctx.Report("startup_worst", (double)worstUs, "us");
+    ctx.Report("config_load_avg", (double)configUs / runs, "us");
+    ctx.Report("engine_start_avg", (double)engineUs / runs, "us");
+    ctx.Report("budget", (double)kStartupBudgetUs, "us");
+    ctx.Check("over_budget", (double)overBudget);
+    ctx.Check("violations", (double)missingEvents);
+}
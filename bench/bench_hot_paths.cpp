@@ -0,0 +1,253 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine_sim.h"
+#include "overlay_engine.h"
+#include "soft_render.h"
+#include "utf8.h"
+
+// 发布候选版本逐项计时的热点路径（与其他文件里的 ConfigLoad/ConfigSave/OverlayFirstFrame 等一起）：
+// 每种分辨率的整帧渲染与每秒时间刷新、文字版面、UTF-8 转换、淡入淡出计时、调度与键鼠活动到淡出的延迟
+namespace
+{
+    const ColorRef kHotBg = MakeColor(0x10, 0x40, 0x20);
+
+    std::wstring HotText(int repeat)
+    {
+        std::wstring text;
+        for (int i = 0; i < repeat; i++)
+        {
+            text += L"该休息一下了，看看远处，放松眼睛。Take a break and look at something far away.\n";
+        }
+        return text;
+    }
+
+    struct Resolution
+    {
+        const char* renderMetric;
+        const char* clockMetric;
+        int width;
+        int height;
+        int dpi;
+    };
+
+    // 引擎在虚拟时间里前进到下一个动画计时器
+    bool StepAnim(VirtualEngineHost& host, OverlayEngine& engine)
+    {
+        std::uint64_t deadline = 0;
+        if (!host.TimerDeadline(EngineTimer::Anim, deadline))
+        {
+            return false;
+        }
+        host.RunUntil(engine, deadline);
+        return true;
+    }
+
+    void RunToState(VirtualEngineHost& host, OverlayEngine& engine, OverlayState state)
+    {
+        while (engine.State() != state && StepAnim(host, engine))
+        {
+        }
+    }
+}
+
+SSR_BENCH(SoftRenderFrame)
+{
+    static const Resolution kResolutions[] = {
+        { "render_base_720p", "clock_tick_720p", 1280, 720, 96 },
+        { "render_base_1080p", "clock_tick_1080p", 1920, 1080, 96 },
+        { "render_base_1440p", "clock_tick_1440p", 2560, 1440, 120 },
+        { "render_base_2160p", "clock_tick_2160p", 3840, 2160, 144 },
+    };
+    const std::wstring text = HotText(3);
+    for (const Resolution& r : kResolutions)
+    {
+        std::vector<std::uint32_t> pixels((size_t)r.width * (size_t)r.height);
+        PixelBuffer buf{ pixels.data(), r.width, r.height, r.width };
+        SoftOverlayLayout layout;
+        Soft_LayoutOverlay(r.width, r.height, r.dpi, text, layout);
+        ctx.Run(r.renderMetric, [&]
+        {
+            Soft_RenderOverlayBase(buf, layout, kHotBg, text);
+            Bench_Consume(pixels[0]);
+        });
+        int second = 0;
+        ctx.Run(r.clockMetric, [&]
+        {
+            second = (second + 1) % 86400;
+            Soft_RenderOverlayClock(buf, layout, kHotBg, second / 3600, second / 60 % 60, second % 60);
+            Bench_Consume(pixels[0]);
+        });
+    }
+}
+
+SSR_BENCH(TextLayout)
+{
+    const std::wstring shortText = HotText(1);
+    const std::wstring longText = HotText(40);
+    SoftOverlayLayout layout;
+    ctx.Run("layout_short", [&]
+    {
+        Soft_LayoutOverlay(1920, 1080, 96, shortText, layout);
+        Bench_Consume(layout);
+    });
+    ctx.Run("layout_long", [&]
+    {
+        Soft_LayoutOverlay(1920, 1080, 96, longText, layout);
+        Bench_Consume(layout);
+    });
+}
+
+SSR_BENCH(Utf8Convert)
+{
+    const std::wstring wide = HotText(16);
+    const std::string utf8 = WideToUtf8(wide);
+    std::string narrowOut;
+    std::wstring wideOut;
+    ctx.Run("wide_to_utf8", [&]
+    {
+        WideToUtf8(wide, narrowOut);
+        Bench_Consume(narrowOut.data());
+    });
+    ctx.Run("utf8_to_wide", [&]
+    {
+        Utf8ToWide(utf8, wideOut);
+        Bench_Consume(wideOut.data());
+    });
+    ctx.Report("chars", (double)wide.size(), "count");
+}
+
+SSR_BENCH(EngineTicks)
+{
+    VirtualEngineHost host;
+    OverlayEngine engine(host);
+    AppConfig cfg;
+    cfg.fadeSeconds = 2;
+    engine.Start(0, cfg);
+
+    // 一次淡入/淡出计时：提醒开始后每 tick 推进透明度，到头时切换状态
+    ctx.Run("fade_tick", [&]
+    {
+        if (engine.State() == OverlayState::Hidden)
+        {
+            engine.OnTriggerNow(host.Now());
+        }
+        else if (engine.State() == OverlayState::WaitingInput)
+        {
+            engine.OnActivity(host.Now());
+        }
+        StepAnim(host, engine);
+    });
+    RunToState(host, engine, OverlayState::WaitingInput);
+    engine.OnActivity(host.Now());
+    RunToState(host, engine, OverlayState::Hidden);
+
+    // 调度：稍后提醒重新设定间隔计时器；到点触发一次完整的提醒（淡入、活动、淡出）
+    std::uint32_t minutes = 1;
+    ctx.Run("schedule_insert", [&]
+    {
+        minutes = minutes % 60 + 1;
+        engine.OnSnooze(host.Now(), minutes);
+    });
+    ctx.Run("schedule_fire", [&]
+    {
+        std::uint64_t deadline = 0;
+        if (host.TimerDeadline(EngineTimer::Interval, deadline))
+        {
+            host.RunUntil(engine, deadline, true);
+        }
+        // 回到隐藏，每次触发前的状态相同
+        RunToState(host, engine, OverlayState::WaitingInput);
+        engine.OnActivity(host.Now());
+        RunToState(host, engine, OverlayState::Hidden);
+    });
+    ctx.Report("reminders", (double)host.reminders, "count");
+}
+
+SSR_BENCH(ActivityToFadeOut)
+{
+    // 键鼠钩子在自己的线程上，活动经队列（Win32 为 PostMessage）交给界面线程，引擎切到淡出。
+    // 测量从钩子线程入队到状态转为 FadingOut 的延迟
+    using Clock = std::chrono::steady_clock;
+    class StampHost final : public VirtualEngineHost
+    {
+    public:
+        void OnStateChanged(OverlayState prev, OverlayState next) override
+        {
+            VirtualEngineHost::OnStateChanged(prev, next);
+            if (next == OverlayState::FadingOut)
+            {
+                fadeOutAt = Clock::now();
+            }
+        }
+        Clock::time_point fadeOutAt;
+    };
+
+    StampHost host;
+    OverlayEngine engine(host);
+    AppConfig cfg;
+    cfg.fadeSeconds = 1;
+    engine.Start(0, cfg);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Clock::time_point> queue;
+    bool ready = false;
+    bool stop = false;
+
+    std::thread hook([&]
+    {
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return ready || stop; });
+            if (stop)
+            {
+                return;
+            }
+            ready = false;
+            queue.push_back(Clock::now());
+            cv.notify_all();
+        }
+    });
+
+    const int samples = 2000;
+    std::vector<double> latencies;
+    latencies.reserve(samples);
+    for (int i = 0; i < samples; i++)
+    {
+        engine.OnTriggerNow(host.Now());
+        RunToState(host, engine, OverlayState::WaitingInput);
+        Clock::time_point posted;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready = true;
+            cv.notify_all();
+            cv.wait(lock, [&] { return !queue.empty(); });
+            posted = queue.front();
+            queue.pop_front();
+        }
+        engine.OnActivity(host.Now());
+        latencies.push_back(std::chrono::duration<double, std::nano>(host.fadeOutAt - posted).count());
+        RunToState(host, engine, OverlayState::Hidden);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+        cv.notify_all();
+    }
+    hook.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    ctx.Report("latency_p50", latencies[samples / 2], "ns");
+    ctx.Report("latency_p99", latencies[samples * 99 / 100], "ns");
+    ctx.Report("latency_max", latencies.back(), "ns");
+}
@@ -0,0 +1,243 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "engine_sim.h"
+#include "overlay_frame.h"
+#include "overlay_pool.h"
+#include "process_footprint.h"
+#include "soft_render.h"
+#include "surface_headless.h"
+#include "surface_tracking.h"
+
+namespace
+{
+    // 与 Win32EngineHost 相同的遮罩生命周期：遮罩池复用窗口，绘制时缓存底图、只重画时间，
+    // 隐藏时清空画面缓存。计时器用虚拟时钟，一轮提醒只需几十微秒
+    class ChurnHost final : public VirtualEngineHost
+    {
+    public:
+        ChurnHost(SurfaceBackend& backend, ResourceLedger& ledger) : m_pool(backend), m_ledger(ledger) {}
+
+        OverlayEngine* engine = nullptr;
+        std::vector<MonitorInfo> monitors;
+
+        bool ShowSurfaces() override
+        {
+            m_pool.Prepare(monitors);
+            const bool shown = m_pool.Show(0);
+            if (shown)
+            {
+                PaintAll();
+            }
+            return shown;
+        }
+
+        void HideSurfaces() override
+        {
+            m_pool.Hide();
+            m_frames.Clear();
+        }
+
+        void SetAlpha(std::uint8_t alpha) override
+        {
+            VirtualEngineHost::SetAlpha(alpha);
+            m_pool.SetAlpha(alpha);
+        }
+
+        void InvalidateSurfaces() override
+        {
+            VirtualEngineHost::InvalidateSurfaces();
+            m_pool.InvalidateAll();
+            PaintAll();
+        }
+
+        void ReconcileSurfaces() override
+        {
+            VirtualEngineHost::ReconcileSurfaces();
+            m_pool.Reconcile(monitors);
+            m_frames.Clear();
+        }
+
+        OverlayPool& Pool() { return m_pool; }
+
+    private:
+        void PaintAll()
+        {
+            if (!m_pool.IsVisible())
+            {
+                return;
+            }
+            m_pool.ForEachSurface([&](SurfaceHandle surface, const MonitorInfo& monitor)
+            {
+                if (surface)
+                {
+                    Paint(surface, monitor);
+                }
+            });
+        }
+
+        // 对应 Overlay_Paint：临时像素缓冲（内存 DC + DIB）在本次绘制内申请并释放
+        void Paint(SurfaceHandle surface, const MonitorInfo& monitor)
+        {
+            const AppConfig& cfg = engine->OverlayConfig();
+            const int w = monitor.rect.Width();
+            const int h = monitor.rect.Height();
+            const OverlayFrameKey key{ w, h, monitor.dpi, OverlayFrame_ContentHash(cfg.bgColor, cfg.text) };
+
+            m_ledger.Acquire(TrackedResource::Pixels);
+            std::vector<std::uint32_t> pixels((size_t)w * (size_t)h);
+            PixelBuffer buf{ pixels.data(), w, h, w };
+            SoftOverlayLayout layout;
+            Soft_LayoutOverlay(w, h, monitor.dpi, cfg.text, layout);
+
+            if (auto frame = m_frames.Find(surface, key))
+            {
+                std::copy_n(frame->BasePixels(), pixels.size(), pixels.data());
+            }
+            else
+            {
+                Soft_RenderOverlayBase(buf, layout, cfg.bgColor, cfg.text);
+                ResourceLedger* ledger = &m_ledger;
+                ledger->Acquire(TrackedResource::Frame);
+                std::shared_ptr<OverlayFrame> base(new OverlayFrame(), [ledger](OverlayFrame* f)
+                {
+                    ledger->Release(TrackedResource::Frame);
+                    delete f;
+                });
+                base->key = key;
+                base->base.assign(pixels.begin(), pixels.end());
+                m_frames.Store(surface, std::move(base));
+            }
+            const std::uint64_t second = Now() / 1000;
+            Soft_RenderOverlayClock(buf, layout, cfg.bgColor, (int)(second / 3600 % 24), (int)(second / 60 % 60), (int)(second % 60));
+            auto* s = HeadlessSurfaceBackend::FromHandle(surface);
+            s->pixels.swap(pixels);
+            m_ledger.Release(TrackedResource::Pixels);
+        }
+
+        OverlayPool m_pool;
+        ResourceLedger& m_ledger;
+        OverlayFrameCache m_frames;
+    };
+
+    std::vector<MonitorInfo> ChurnMonitors(int variant)
+    {
+        // 每隔若干轮换一次显示器布局：拔掉副屏、改 DPI、换分辨率
+        std::vector<MonitorInfo> monitors{ { ScreenRect{ 0, 0, 320, 180 }, 96 } };
+        if (variant % 3 != 1)
+        {
+            monitors.push_back({ ScreenRect{ 320, 0, 576, 144 }, variant % 2 ? 144 : 96 });
+        }
+        if (variant % 4 == 3)
+        {
+            monitors.push_back({ ScreenRect{ -240, 0, 0, 135 }, 120 });
+        }
+        return monitors;
+    }
+}
+
+SSR_BENCH(OverlayChurn)
+{
+    // 显示 → 淡入 → 键鼠活动 → 淡出隐藏，循环数千次；每轮隐藏后记录存活资源、
+    // 堆与句柄，热身之后任何增长都算违规
+    const int cycles = 4000;
+    const int warmup = 100;
+    const int topologyEvery = 37;
+
+    ResourceLedger ledger;
+    HeadlessSurfaceBackend headless;
+    TrackingSurfaceBackend tracking(headless, ledger);
+    tracking.FailCreateEvery(5);
+    ChurnHost host(tracking, ledger);
+    host.monitors = ChurnMonitors(0);
+    headless.SetMonitors(host.monitors);
+    OverlayEngine engine(host);
+    host.engine = &engine;
+
+    AppConfig cfg;
+    cfg.intervalMinutes = 1;
+    cfg.fadeSeconds = 1;
+    cfg.text = L"该休息一下了。Take a break.";
+    host.SetNow(1000);
+    engine.Start(host.Now(), cfg);
+
+    int violations = 0;
+    ProcessHandles baseline;
+    ProcessHandles last;
+    std::uint64_t heapGrowthMax = 0;
+    std::uint64_t handleGrowthMax = 0;
+    std::uint64_t completed = 0;
+    const auto started = std::chrono::steady_clock::now();
+    for (int cycle = 0; cycle < cycles; cycle++)
+    {
+        if (cycle % topologyEvery == topologyEvery - 1)
+        {
+            host.monitors = ChurnMonitors(cycle / topologyEvery + 1);
+            headless.SetMonitors(host.monitors);
+            engine.OnDisplayChange(host.Now());
+        }
+
+        // 到点并淡入；活动在等待键鼠时到来
+        for (int guard = 0; guard < 8 && engine.State() != OverlayState::WaitingInput; guard++)
+        {
+            host.RunUntil(engine, host.Now() + 120000, true);
+        }
+        if (engine.State() == OverlayState::WaitingInput)
+        {
+            host.RunUntil(engine, host.Now() + 2500);
+            engine.OnActivity(host.Now());
+        }
+        for (int guard = 0; guard < 8 && engine.State() != OverlayState::Hidden; guard++)
+        {
+            host.RunUntil(engine, host.Now() + 5000, true);
+        }
+        completed += engine.State() == OverlayState::Hidden ? 1 : 0;
+
+        // 隐藏后：只剩池里的遮罩，没有画面缓存与临时像素
+        violations += ledger.Live(TrackedResource::Surface) == (std::int64_t)tracking.LiveSurfaces() ? 0 : 1;
+        violations += ledger.Live(TrackedResource::Frame) == 0 && ledger.Live(TrackedResource::Pixels) == 0 ? 0 : 1;
+        violations += (size_t)ledger.Live(TrackedResource::Surface) <= host.monitors.size() ? 0 : 1;
+        violations += headless.LiveSurfaces() == tracking.LiveSurfaces() ? 0 : 1;
+
+        // 遮罩自身的像素缓冲随显示器布局变化，不算增长
+        ProcessHandles_ReadSelf(last);
+        host.Pool().ForEachSurface([&](SurfaceHandle surface, const MonitorInfo&)
+        {
+            last.heapBytes -= HeadlessSurfaceBackend::FromHandle(surface)->pixels.capacity() * sizeof(std::uint32_t);
+        });
+        if (cycle == warmup)
+        {
+            baseline = last;
+        }
+        else if (cycle > warmup)
+        {
+            heapGrowthMax = std::max<std::uint64_t>(heapGrowthMax, last.heapBytes > baseline.heapBytes ? last.heapBytes - baseline.heapBytes : 0);
+            handleGrowthMax = std::max<std::uint64_t>(handleGrowthMax, last.handles > baseline.handles ? last.handles - baseline.handles : 0);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    engine.OnExit(host.Now());
+    host.Pool().DestroyAll();
+    violations += ledger.TotalLive() == 0 && headless.LiveSurfaces() == 0 ? 0 : 1;
+    violations += ledger.Underflows() == 0 && tracking.InvalidCalls() == 0 ? 0 : 1;
+    // 堆里允许少量碎片与分配器内部缓存，句柄不允许增长
+    const std::uint64_t heapTolerance = 64 * 1024;
+    violations += heapGrowthMax <= heapTolerance ? 0 : 1;
+    violations += handleGrowthMax == 0 ? 0 : 1;
+
+    ctx.Report("cycles", (double)cycles, "count");
+    ctx.Report("cycles_completed", (double)completed, "count");
+    ctx.Report("cycles_per_sec", cycles / seconds, "cycles/s");
+    ctx.Report("injected_create_faults", (double)tracking.InjectedFailures(), "count");
+    ctx.Report("peak_surfaces", (double)ledger.Peak(TrackedResource::Surface), "count");
+    ctx.Report("repaints", (double)host.repaints, "count");
+    ctx.Report("heap_growth_max", (double)heapGrowthMax, "bytes");
+    ctx.Report("handle_growth_max", (double)handleGrowthMax, "count");
+    ctx.Check("violations", (double)violations);
+}
@@ -0,0 +1,135 @@
+#include "bench.h"
+
+#include "overlay_fsm.h"
+
+namespace
+{
+    // 按命令维护各项资源是否处于运行状态，用来核对每个状态应有的资源
+    struct ResourceModel
+    {
+        bool scheduler = true;
+        bool anim = false;
+        bool clock = false;
+        bool input = false;
+        bool visible = false;
+        bool showFails = false;
+        OverlayFsm* fsm = nullptr;
+
+        void Run(std::uint32_t command)
+        {
+            switch (command)
+            {
+            case OVERLAY_CMD_SCHEDULER_STOP: scheduler = false; break;
+            case OVERLAY_CMD_ANIM_TIMER_STOP: anim = false; break;
+            case OVERLAY_CMD_CLOCK_TIMER_STOP: clock = false; break;
+            case OVERLAY_CMD_INPUT_STOP: input = false; break;
+            case OVERLAY_CMD_HIDE: visible = false; break;
+            case OVERLAY_CMD_SHOW:
+            case OVERLAY_CMD_SHOW_PREVIEW:
+                if (showFails) fsm->Post(OverlayEvent::ShowFailed);
+                else visible = true;
+                break;
+            case OVERLAY_CMD_INPUT_START: input = true; break;
+            case OVERLAY_CMD_CLOCK_TIMER_START: clock = true; break;
+            case OVERLAY_CMD_ANIM_TIMER_START: anim = true; break;
+            case OVERLAY_CMD_SCHEDULER_START: scheduler = true; break;
+            default: break;
+            }
+        }
+
+        bool Consistent(OverlayState state) const
+        {
+            switch (state)
+            {
+            case OverlayState::Hidden: return scheduler && !anim && !clock && !input && !visible;
+            case OverlayState::FadingIn: return !scheduler && anim && clock && input && visible;
+            case OverlayState::WaitingInput: return !scheduler && !anim && clock && input && visible;
+            case OverlayState::FadingOut: return !scheduler && anim && clock && input && visible;
+            case OverlayState::Exited: return !scheduler && !anim && !clock && !input && !visible;
+            }
+            return false;
+        }
+    };
+
+    // ShowFailed 由执行命令时产生，不作为外部事件枚举
+    constexpr OverlayEvent kExternalEvents[] = {
+        OverlayEvent::Interval, OverlayEvent::Preview, OverlayEvent::FadeInDone, OverlayEvent::Activity,
+        OverlayEvent::FadeOutDone, OverlayEvent::ConfigSaved, OverlayEvent::Exit,
+    };
+    constexpr int kExternalEventCount = (int)(sizeof(kExternalEvents) / sizeof(kExternalEvents[0]));
+
+    // 一次完整序列：返回违反不变式的步数
+    int RunSequence(const int* events, int length, bool showFails)
+    {
+        OverlayFsm fsm;
+        ResourceModel model;
+        model.fsm = &fsm;
+        model.showFails = showFails;
+
+        int violations = 0;
+        for (int i = 0; i < length; i++)
+        {
+            fsm.Post(kExternalEvents[events[i]]);
+            fsm.Dispatch([&](OverlayState prev, OverlayEvent, const OverlayTransition& t)
+            {
+                // 同一次转移里不应同时启动和停止同一项资源
+                const std::uint32_t c = t.commands;
+                if ((c & OVERLAY_CMD_SCHEDULER_START) && (c & OVERLAY_CMD_SCHEDULER_STOP)) violations++;
+                if ((c & OVERLAY_CMD_ANIM_TIMER_START) && (c & OVERLAY_CMD_ANIM_TIMER_STOP)) violations++;
+                if ((c & OVERLAY_CMD_CLOCK_TIMER_START) && (c & OVERLAY_CMD_CLOCK_TIMER_STOP)) violations++;
+                if ((c & OVERLAY_CMD_INPUT_START) && (c & OVERLAY_CMD_INPUT_STOP)) violations++;
+                if (prev == OverlayState::Exited && (t.next != OverlayState::Exited || c != 0)) violations++;
+                for (std::uint32_t bits = c; bits != 0; bits &= bits - 1)
+                {
+                    model.Run(bits & (0u - bits));
+                }
+            });
+            if (!model.Consistent(fsm.State())) violations++;
+        }
+        if (fsm.Dropped() != 0) violations++;
+        return violations;
+    }
+}
+
+SSR_BENCH(OverlayFsmExhaustive)
+{
+    // 枚举长度不超过 6 的全部外部事件序列（含预览中淡出、淡入中保存、各状态退出等），
+    // 分别在显示成功与显示失败两种情况下核对资源状态
+    constexpr int kMaxLength = 6;
+    int events[kMaxLength]{};
+    std::uint64_t sequences = 0;
+    std::uint64_t violations = 0;
+
+    for (int length = 1; length <= kMaxLength; length++)
+    {
+        std::uint64_t total = 1;
+        for (int i = 0; i < length; i++) total *= kExternalEventCount;
+        for (std::uint64_t n = 0; n < total; n++)
+        {
+            std::uint64_t v = n;
+            for (int i = 0; i < length; i++)
+            {
+                events[i] = (int)(v % kExternalEventCount);
+                v /= kExternalEventCount;
+            }
+            violations += (std::uint64_t)RunSequence(events, length, false);
+            violations += (std::uint64_t)RunSequence(events, length, true);
+            sequences += 2;
+        }
+    }
+    ctx.Report("sequences", (double)sequences, "count");
+    ctx.Check("violations", (double)violations);
+
+    OverlayFsm fsm;
+    const OverlayEvent cycle[] = {
+        OverlayEvent::Interval, OverlayEvent::FadeInDone, OverlayEvent::Activity, OverlayEvent::FadeOutDone,
+    };
+    size_t step = 0;
+    std::uint32_t sink = 0;
+    ctx.Run("transition", [&]
+    {
+        fsm.Post(cycle[step++ & 3]);
+        fsm.Dispatch([&](OverlayState, OverlayEvent, const OverlayTransition& t) { sink ^= t.commands; });
+    });
+    Bench_Consume(sink);
+}
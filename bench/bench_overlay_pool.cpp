@@ -0,0 +1,126 @@
+#include "bench.h"
+
+#include "overlay_pool.h"
+#include "surface_headless.h"
+
+static std::vector<MonitorInfo> BenchMonitors()
+{
+    return {
+        MonitorInfo{ ScreenRect{ 0, 0, 2560, 1440 }, 120 },
+        MonitorInfo{ ScreenRect{ 2560, 0, 4480, 1080 }, 96 },
+        MonitorInfo{ ScreenRect{ -3840, 0, 0, 2160 }, 144 },
+    };
+}
+
+SSR_BENCH(OverlayShow)
+{
+    HeadlessSurfaceBackend backend(BenchMonitors());
+
+    // 旧流程：每次提醒枚举显示器、创建窗口，结束时销毁
+    std::vector<MonitorInfo> monitors;
+    std::vector<SurfaceHandle> surfaces;
+    ctx.Run("create_per_show", [&]
+    {
+        monitors.clear();
+        backend.EnumMonitors(monitors);
+        for (const auto& m : monitors)
+        {
+            const SurfaceHandle s = backend.Create(m);
+            backend.SetAlpha(s, 0);
+            backend.Show(s);
+            surfaces.push_back(s);
+        }
+        for (SurfaceHandle s : surfaces)
+        {
+            backend.Destroy(s);
+        }
+        surfaces.clear();
+    });
+
+    OverlayPool pool(backend);
+    pool.Prepare();
+    ctx.Run("pooled", [&]
+    {
+        pool.Show(0);
+        pool.Hide();
+    });
+
+    ctx.Run("topology_unchanged", [&] { pool.MarkTopologyDirty(); Bench_Consume(pool.Prepare()); });
+    ctx.Report("surfaces_created", (double)backend.GetCounters().creates, "count");
+}
+
+// 按 pool 当前的遮罩检查：与显示器一一对应、全部可见且透明度未被重置
+static int CountTopologyViolations(const OverlayPool& pool, const std::vector<MonitorInfo>& monitors, std::uint8_t alpha)
+{
+    int violations = pool.Size() == monitors.size() ? 0 : 1;
+    size_t i = 0;
+    pool.ForEachSurface([&](SurfaceHandle surface, const MonitorInfo& monitor)
+    {
+        const auto* s = HeadlessSurfaceBackend::FromHandle(surface);
+        if (i >= monitors.size() || !(monitor == monitors[i]) || !(s->monitor == monitor)) violations++;
+        if (!s->visible || s->alpha != alpha) violations++;
+        if (s->pixels.size() != (size_t)monitor.rect.Width() * (size_t)monitor.rect.Height()) violations++;
+        i++;
+    });
+    return violations;
+}
+
+SSR_BENCH(OverlayTopology)
+{
+    const MonitorInfo laptop{ ScreenRect{ 0, 0, 1920, 1200 }, 144 };
+    const MonitorInfo laptopScaled{ ScreenRect{ 0, 0, 1920, 1200 }, 120 };
+    const MonitorInfo dockLeft{ ScreenRect{ -2560, 0, 0, 1440 }, 96 };
+    const MonitorInfo dockRight{ ScreenRect{ 1920, 0, 4480, 1440 }, 96 };
+    const MonitorInfo dockRightMoved{ ScreenRect{ 1920, -240, 4480, 1200 }, 96 };
+    const MonitorInfo projector{ ScreenRect{ 0, 1200, 1280, 1920 }, 96 };
+
+    // 插拔扩展坞、DPI 调整、显示器重新排列、主屏换位
+    const std::vector<std::vector<MonitorInfo>> sequence = {
+        { laptop },
+        { laptop, dockLeft, dockRight },
+        { laptopScaled, dockLeft, dockRight },
+        { laptopScaled, dockLeft, dockRightMoved },
+        { laptopScaled },
+        { laptopScaled, projector },
+        { projector, laptop },
+        { dockRight },
+        {},
+        { laptop, dockLeft },
+    };
+
+    HeadlessSurfaceBackend backend(sequence.front());
+    OverlayPool pool(backend);
+    pool.Prepare();
+
+    const std::uint8_t alpha = 97;
+    pool.Show(alpha);
+
+    int violations = 0;
+    OverlayReconcileResult total;
+    for (const auto& monitors : sequence)
+    {
+        const OverlayReconcileResult r = pool.Reconcile(monitors);
+        total.kept += r.kept;
+        total.moved += r.moved;
+        total.created += r.created;
+        total.retired += r.retired;
+        violations += CountTopologyViolations(pool, monitors, alpha);
+    }
+    // 拓扑变化不应改变可见状态；全部显示器拔掉后重新插上也要立即覆盖
+    if (!pool.IsVisible()) violations++;
+
+    ctx.Check("violations", (double)violations);
+    ctx.Report("kept", (double)total.kept, "count");
+    ctx.Report("moved", (double)total.moved, "count");
+    ctx.Report("created", (double)total.created, "count");
+    ctx.Report("retired", (double)total.retired, "count");
+
+    size_t step = 0;
+    ctx.Run("reconcile_step", [&]
+    {
+        Bench_Consume(pool.Reconcile(sequence[step]));
+        step = (step + 1) % sequence.size();
+    });
+    pool.DestroyAll();
+    ctx.Check("leaked_surfaces", (double)backend.LiveSurfaces());
+}
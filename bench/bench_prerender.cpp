@@ -0,0 +1,156 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <string>
+
+#include "overlay_frame.h"
+#include "soft_render.h"
+#include "surface_headless.h"
+
+static const MonitorInfo kPrerenderMonitor{ ScreenRect{ 0, 0, 2560, 1440 }, 120 };
+static const ColorRef kPrerenderBg = MakeColor(0x00, 0x80, 0x40);
+
+static std::wstring PrerenderText()
+{
+    std::wstring text;
+    for (int i = 0; i < 6; i++)
+    {
+        text += L"该休息一下了，看看远处，放松眼睛。Take a break and look at something far away.\n";
+    }
+    return text;
+}
+
+static std::shared_ptr<OverlayFrame> RenderSoftFrame(const MonitorInfo& monitor, const std::wstring& text, std::int64_t second)
+{
+    const int w = monitor.rect.Width();
+    const int h = monitor.rect.Height();
+    auto frame = std::make_shared<OverlayFrame>();
+    frame->key = OverlayFrameKey{ w, h, monitor.dpi, OverlayFrame_ContentHash(kPrerenderBg, text) };
+    frame->clockSecond = second;
+    frame->base.resize((size_t)w * (size_t)h);
+
+    PixelBuffer buf{ frame->base.data(), w, h, w };
+    SoftOverlayLayout layout;
+    Soft_LayoutOverlay(w, h, monitor.dpi, text, layout);
+    Soft_RenderOverlayBase(buf, layout, kPrerenderBg, text);
+
+    frame->composed = frame->base;
+    buf.pixels = frame->composed.data();
+    Soft_RenderOverlayClock(buf, layout, kPrerenderBg, (int)(second / 3600 % 24), (int)(second / 60 % 60), (int)(second % 60));
+    return frame;
+}
+
+SSR_BENCH(OverlayFirstFrame)
+{
+    HeadlessSurfaceBackend backend;
+    const SurfaceHandle surface = backend.Create(kPrerenderMonitor);
+    auto* target = HeadlessSurfaceBackend::FromHandle(surface);
+    const std::wstring text = PrerenderText();
+    const int w = kPrerenderMonitor.rect.Width();
+    const int h = kPrerenderMonitor.rect.Height();
+    const OverlayFrameKey key{ w, h, kPrerenderMonitor.dpi, OverlayFrame_ContentHash(kPrerenderBg, text) };
+
+    // 未预渲染：弹出时在绘制消息里完成版面、背景、文字与时间
+    std::int64_t second = 12 * 3600;
+    ctx.Run("no_prerender", [&]
+    {
+        PixelBuffer buf{ target->pixels.data(), w, h, w };
+        SoftOverlayLayout layout;
+        Soft_LayoutOverlay(w, h, kPrerenderMonitor.dpi, text, layout);
+        Soft_RenderOverlayBase(buf, layout, kPrerenderBg, text);
+        Soft_RenderOverlayClock(buf, layout, kPrerenderBg, 12, 0, (int)(second++ % 60));
+        Bench_Consume(target->pixels[0]);
+    });
+
+    OverlayFrameCache cache;
+    cache.Store(surface, RenderSoftFrame(kPrerenderMonitor, text, second));
+
+    // 命中：只需把画好的首帧交给遮罩显示
+    ctx.Run("prerender_hit", [&]
+    {
+        backend.Present(surface, cache.Find(surface, key));
+        Bench_Consume(target->presented);
+    });
+    backend.Invalidate(surface);
+
+    // 预测的秒数过期：复用底图，只重画时间
+    ctx.Run("prerender_stale", [&]
+    {
+        const auto frame = cache.Find(surface, key);
+        std::copy(frame->base.begin(), frame->base.end(), target->pixels.begin());
+        PixelBuffer buf{ target->pixels.data(), w, h, w };
+        SoftOverlayLayout layout;
+        Soft_LayoutOverlay(w, h, kPrerenderMonitor.dpi, text, layout);
+        Soft_RenderOverlayClock(buf, layout, kPrerenderBg, 12, 0, (int)(second++ % 60));
+        Bench_Consume(target->pixels[0]);
+    });
+
+    ctx.Run("background_render", [&] { Bench_Consume(RenderSoftFrame(kPrerenderMonitor, text, second++)); });
+
+    // 后台线程端到端：计划、唤醒、渲染并写入缓存
+    PrerenderWorker worker;
+    worker.Start();
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    bool done = false;
+    ctx.Run("worker_round_trip", [&]
+    {
+        done = false;
+        worker.Schedule(PrerenderWorker::Clock::now(), std::chrono::milliseconds(0), [&](std::int64_t predictedUnixMs)
+        {
+            cache.Store(surface, RenderSoftFrame(kPrerenderMonitor, text, predictedUnixMs / 1000));
+            std::lock_guard<std::mutex> lock(doneMutex);
+            done = true;
+            doneCv.notify_one();
+        });
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneCv.wait(lock, [&] { return done; });
+    });
+
+    // 任务已经在渲染时被取消、缓存也清空了：画完的画面不能再写进缓存
+    int lateStoreViolations = 0;
+    for (int round = 0; round < 2; round++)
+    {
+        std::mutex stepMutex;
+        std::condition_variable stepCv;
+        bool started = false;
+        bool cancelled = false;
+        bool finished = false;
+        bool stored = true;
+        const std::uint64_t generation = cache.Generation();
+        worker.Schedule(PrerenderWorker::Clock::now(), std::chrono::milliseconds(0), [&](std::int64_t predictedUnixMs)
+        {
+            auto frame = RenderSoftFrame(kPrerenderMonitor, text, predictedUnixMs / 1000);
+            std::unique_lock<std::mutex> lock(stepMutex);
+            started = true;
+            stepCv.notify_all();
+            stepCv.wait(lock, [&] { return cancelled; });
+            stored = cache.Store(surface, std::move(frame), generation);
+            finished = true;
+            stepCv.notify_all();
+        });
+        std::unique_lock<std::mutex> lock(stepMutex);
+        stepCv.wait(lock, [&] { return started; });
+        // 第一轮模拟提醒结束（清空缓存），第二轮模拟计时停止（只取消）
+        worker.Cancel();
+        if (round == 0)
+        {
+            cache.Clear();
+        }
+        else
+        {
+            cache.Store(surface, RenderSoftFrame(kPrerenderMonitor, text, second));
+            cache.Revoke();
+        }
+        const auto kept = cache.Find(surface, key);
+        cancelled = true;
+        stepCv.notify_all();
+        stepCv.wait(lock, [&] { return finished; });
+        lateStoreViolations += !stored && cache.Find(surface, key) == kept ? 0 : 1;
+    }
+    lateStoreViolations += cache.Discarded() == 2 ? 0 : 1;
+    ctx.Check("late_store_violations", (double)lateStoreViolations);
+    worker.Stop();
+
+    backend.Destroy(surface);
+}
@@ -0,0 +1,145 @@
+#include "bench.h"
+
+#include "config.h"
+#include "engine_sim.h"
+#include "presence.h"
+
+namespace
+{
+    // 假的会话与电源通知来源：把“锁屏 / 断开 / 显示器”通知按 Win32 的顺序送给跟踪器与引擎
+    struct FakeSession
+    {
+        PresenceTracker tracker;
+        VirtualEngineHost host;
+        OverlayEngine engine{ host };
+        std::uint64_t credited = 0;
+
+        void Notify(PresenceReason reason, bool active)
+        {
+            if (tracker.Set(reason, active, host.Now()))
+            {
+                credited += engine.OnPresence(host.Now(), tracker.IsPresent()) ? 1 : 0;
+            }
+        }
+
+        void Advance(std::uint64_t ms) { host.RunUntil(engine, host.Now() + ms); }
+    };
+
+    AppConfig DefaultConfig()
+    {
+        AppConfig cfg;
+        Config_ApplyDefaults(cfg);
+        return cfg;
+    }
+}
+
+SSR_BENCH(PresenceReasons)
+{
+    // 原因合并：锁屏后显示器关闭再亮起，直到解锁才算回来；重复通知不改变状态
+    PresenceTracker t;
+    int violations = 0;
+    violations += t.Set(PRESENCE_LOCKED, true, 1000) && !t.IsPresent() ? 0 : 1;
+    violations += !t.Set(PRESENCE_DISPLAY_OFF, true, 2000) ? 0 : 1;
+    violations += !t.Set(PRESENCE_DISPLAY_OFF, true, 2500) ? 0 : 1;
+    violations += !t.Set(PRESENCE_DISPLAY_OFF, false, 3000) && !t.IsPresent() ? 0 : 1;
+    violations += t.Set(PRESENCE_LOCKED, false, 61000) && t.IsPresent() && t.LastAwayMs() == 60000 ? 0 : 1;
+    violations += !t.Set(PRESENCE_DISCONNECTED, false, 62000) ? 0 : 1;
+    violations += t.Set(PRESENCE_DISCONNECTED, true, 70000) && t.Reasons() == PRESENCE_DISCONNECTED ? 0 : 1;
+    violations += t.Set(PRESENCE_DISCONNECTED, false, 80000) && t.Stats().absences == 2 && t.Stats().awayMs == 70000 ? 0 : 1;
+    violations += t.Stats().redundant == 2 ? 0 : 1;
+    ctx.Check("tracker_violations", (double)violations);
+
+    std::uint64_t now = 0;
+    ctx.Run("set", [&]
+    {
+        now++;
+        Bench_Consume(t.Set(PRESENCE_DISPLAY_OFF, (now & 1) != 0, now));
+    });
+}
+
+SSR_BENCH(PresenceEngine)
+{
+    const AppConfig cfg = DefaultConfig();
+    const std::uint64_t intervalMs = (std::uint64_t)cfg.intervalMinutes * 60 * 1000;
+    int violations = 0;
+
+    // 离开期间不提醒：锁屏跨过到点时间也不显示，也不触发计时器
+    {
+        FakeSession s;
+        s.engine.Start(0, cfg);
+        s.Advance(intervalMs / 2);
+        s.Notify(PRESENCE_LOCKED, true);
+        const std::uint64_t firings = s.host.timerFirings;
+        s.Advance(3 * intervalMs);
+        violations += s.host.reminders == 0 && s.host.timerFirings == firings ? 0 : 1;
+        s.engine.OnTriggerNow(s.host.Now());
+        violations += s.engine.State() == OverlayState::Hidden ? 0 : 1;
+        // 离开够久：按休息处理，从回来起重新计完整的间隔
+        s.Notify(PRESENCE_LOCKED, false);
+        violations += s.credited == 1 ? 0 : 1;
+        s.Advance(intervalMs - 1);
+        violations += s.host.reminders == 0 ? 0 : 1;
+        s.Advance(2);
+        violations += s.host.reminders == 1 ? 0 : 1;
+    }
+
+    // 短暂离开只是暂停：回来后接着剩余时间
+    {
+        FakeSession s;
+        s.engine.Start(0, cfg);
+        s.Advance(intervalMs - 120000);
+        s.Notify(PRESENCE_DISPLAY_OFF, true);
+        s.Advance(ENGINE_AWAY_BREAK_MS / 2);
+        s.Notify(PRESENCE_DISPLAY_OFF, false);
+        violations += s.credited == 0 ? 0 : 1;
+        s.Advance(120000 - 1);
+        violations += s.host.reminders == 0 ? 0 : 1;
+        s.Advance(2);
+        violations += s.host.reminders == 1 ? 0 : 1;
+    }
+
+    // 提醒中锁屏：立即撤下（不淡出），回来时直接算作完成了这次休息
+    {
+        FakeSession s;
+        s.engine.Start(0, cfg);
+        s.Advance(intervalMs + 100);
+        const bool showing = s.host.IsVisible() && s.host.IsInputActive();
+        s.Notify(PRESENCE_DISCONNECTED, true);
+        violations += showing && !s.host.IsVisible() && !s.host.IsInputActive() && s.engine.State() == OverlayState::Hidden ? 0 : 1;
+        s.Advance(5000);
+        s.Notify(PRESENCE_DISCONNECTED, false);
+        violations += s.credited == 1 ? 0 : 1;
+        s.Advance(intervalMs - 1);
+        violations += s.host.reminders == 1 ? 0 : 1;
+        s.Advance(2);
+        violations += s.host.reminders == 2 ? 0 : 1;
+    }
+
+    // 离开期间请求的稍后提醒在回来时生效
+    {
+        FakeSession s;
+        s.engine.Start(0, cfg);
+        s.Notify(PRESENCE_LOCKED, true);
+        s.engine.OnSnooze(s.host.Now(), 3);
+        s.Advance(10 * 60 * 1000);
+        violations += s.host.reminders == 0 ? 0 : 1;
+        s.Notify(PRESENCE_LOCKED, false);
+        s.Advance(3 * 60 * 1000 + 1);
+        violations += s.host.reminders == 1 ? 0 : 1;
+    }
+    ctx.Check("engine_violations", (double)violations);
+
+    // 一周模拟：定期锁屏并关闭显示器
+    EngineSimOptions options;
+    EngineSimResult result;
+    EngineSim_Run(options, result);
+    ctx.Report("sim_absences", (double)result.absences, "count");
+    ctx.Report("sim_away_breaks", (double)result.awayBreaks, "count");
+    ctx.Report("sim_reminders", (double)result.reminders, "count");
+
+    // 同一周没有离开时的计时器触发次数，对比离开期间省下的唤醒
+    EngineSimResult present;
+    options.awayEveryMs = 0;
+    EngineSim_Run(options, present);
+    ctx.Report("timer_firings_saved", (double)present.timerFirings - (double)result.timerFirings, "count");
+}
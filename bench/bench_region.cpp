@@ -0,0 +1,315 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "overlay_pool.h"
+#include "overlay_region.h"
+#include "screen_region.h"
+#include "soft_render.h"
+#include "surface_headless.h"
+
+// 遮罩区域：几百个矩形的并、交、差与逐像素的暴力结果对照，并测量各运算与限于区域的填充
+namespace
+{
+    const ColorRef kRegionBg = MakeColor(0x10, 0x30, 0x50);
+
+    struct Lcg
+    {
+        std::uint32_t state;
+
+        int Next(int bound)
+        {
+            state = state * 1664525u + 1013904223u;
+            return (int)((state >> 8) % (std::uint32_t)bound);
+        }
+    };
+
+    // 大小不一、相互重叠的矩形，偶尔有空矩形
+    std::vector<ScreenRect> RandomRects(Lcg& rng, size_t count, int width, int height)
+    {
+        std::vector<ScreenRect> rects;
+        rects.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const int x = rng.Next(width);
+            const int y = rng.Next(height);
+            const int w = rng.Next(width / 6 + 1);
+            const int h = rng.Next(height / 6 + 1);
+            rects.push_back(ScreenRect{ x, y, std::min(width, x + w), std::min(height, y + h) });
+        }
+        return rects;
+    }
+
+    void Rasterize(const std::vector<ScreenRect>& rects, int width, std::vector<std::uint8_t>& out)
+    {
+        for (const ScreenRect& r : rects)
+        {
+            for (int y = r.top; y < r.bottom; y++)
+            {
+                for (int x = r.left; x < r.right; x++)
+                {
+                    out[(size_t)y * (size_t)width + (size_t)x] = 1;
+                }
+            }
+        }
+    }
+
+    // 区域与期望的逐像素覆盖不一致的像素数；Contains 与 Area 也一并核对
+    size_t CountMismatches(const ScreenRegion& region, const std::vector<std::uint8_t>& expected, int width, int height)
+    {
+        std::vector<std::uint8_t> actual(expected.size(), 0);
+        Rasterize(region.Rects(), width, actual);
+        size_t mismatches = 0;
+        long long area = 0;
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                const size_t i = (size_t)y * (size_t)width + (size_t)x;
+                area += expected[i];
+                if (actual[i] != expected[i] || region.Contains(x, y) != (expected[i] != 0))
+                {
+                    mismatches++;
+                }
+            }
+        }
+        return mismatches + (region.Area() != area ? 1 : 0);
+    }
+}
+
+SSR_BENCH(RegionAlgebra)
+{
+    // 正确性：小画布上逐像素对照，矩形数从几个到几百个
+    const int gridW = 256;
+    const int gridH = 192;
+    Lcg rng{ 12345u };
+    size_t mismatches = 0;
+    size_t nonCanonical = 0;
+    size_t checks = 0;
+    std::vector<std::uint8_t> inA((size_t)gridW * gridH);
+    std::vector<std::uint8_t> inB((size_t)gridW * gridH);
+    std::vector<std::uint8_t> expected((size_t)gridW * gridH);
+    for (size_t count : { 1u, 2u, 5u, 17u, 64u, 150u, 300u, 500u })
+    {
+        for (int trial = 0; trial < 4; trial++)
+        {
+            const std::vector<ScreenRect> a = RandomRects(rng, count, gridW, gridH);
+            const std::vector<ScreenRect> b = RandomRects(rng, count / 2 + 1, gridW, gridH);
+            std::fill(inA.begin(), inA.end(), 0);
+            std::fill(inB.begin(), inB.end(), 0);
+            Rasterize(a, gridW, inA);
+            Rasterize(b, gridW, inB);
+
+            ScreenRegion ra;
+            ScreenRegion rb;
+            Region_FromRects(a.data(), a.size(), ra);
+            Region_FromRects(b.data(), b.size(), rb);
+            ScreenRegion result;
+            const RegionOp ops[] = { RegionOp::Union, RegionOp::Intersect, RegionOp::Subtract };
+            for (RegionOp op : ops)
+            {
+                Region_Combine(ra, rb, op, result);
+                for (size_t i = 0; i < expected.size(); i++)
+                {
+                    expected[i] = op == RegionOp::Union ? (inA[i] | inB[i])
+                        : op == RegionOp::Intersect ? (inA[i] & inB[i])
+                        : (std::uint8_t)(inA[i] & !inB[i]);
+                }
+                mismatches += CountMismatches(result, expected, gridW, gridH);
+                nonCanonical += result.IsCanonical() ? 0 : 1;
+                checks++;
+            }
+            // 输出与输入是同一个对象
+            ScreenRegion inPlace = ra;
+            Region_Subtract(inPlace, rb, inPlace);
+            Region_Combine(ra, rb, RegionOp::Subtract, result);
+            mismatches += inPlace == result ? 0 : 1;
+            nonCanonical += ra.IsCanonical() && rb.IsCanonical() ? 0 : 1;
+        }
+    }
+    ctx.Report("checks", (double)checks, "count");
+    ctx.Check("mismatches", (double)mismatches);
+    ctx.Check("non_canonical", (double)nonCanonical);
+
+    // 速度：4K 画布上的几百个矩形
+    const int w = 3840;
+    const int h = 2160;
+    Lcg timing{ 777u };
+    const std::vector<ScreenRect> rects200 = RandomRects(timing, 200, w, h);
+    const std::vector<ScreenRect> rects800 = RandomRects(timing, 800, w, h);
+    const std::vector<ScreenRect> holes = RandomRects(timing, 300, w, h);
+    ScreenRegion a;
+    ScreenRegion b;
+    ScreenRegion out;
+    ctx.Run("from_rects_200", [&]
+    {
+        Region_FromRects(rects200.data(), rects200.size(), a);
+        Bench_Consume(a);
+    });
+    ctx.Run("from_rects_800", [&]
+    {
+        Region_FromRects(rects800.data(), rects800.size(), a);
+        Bench_Consume(a);
+    });
+    Region_FromRects(rects200.data(), rects200.size(), a);
+    Region_FromRects(holes.data(), holes.size(), b);
+    ctx.Run("union", [&]
+    {
+        Region_Union(a, b, out);
+        Bench_Consume(out);
+    });
+    ctx.Run("intersect", [&]
+    {
+        Region_Intersect(a, b, out);
+        Bench_Consume(out);
+    });
+    ctx.Run("subtract", [&]
+    {
+        Region_Subtract(a, b, out);
+        Bench_Consume(out);
+    });
+    int probe = 0;
+    ctx.Run("contains", [&]
+    {
+        probe = (probe + 7919) % (w * h);
+        bool inside = a.Contains(probe % w, probe / w);
+        Bench_Consume(inside);
+    });
+    ctx.Report("region_rects_200", (double)a.Rects().size(), "count");
+    ctx.Report("region_rects_subtract", (double)out.Rects().size(), "count");
+}
+
+SSR_BENCH(RegionFill)
+{
+    // 2160p 遮罩：右上角留出 25% x 25% 给视频会议窗口，底部留出 64 像素的任务栏条
+    const int w = 3840;
+    const int h = 2160;
+    std::vector<OverlayRegionRule> rules;
+    OverlayRegion_Parse("*:-75%,0,100%,25%; *:-0,2096,100%,100%", rules);
+    ScreenRegion region;
+    OverlayRegion_Build(rules, 0, w, h, region);
+
+    const std::wstring text = L"该休息一下了，看看远处，放松眼睛。";
+    std::vector<std::uint32_t> pixels((size_t)w * (size_t)h);
+    std::vector<std::uint32_t> base((size_t)w * (size_t)h, 0x00123456u);
+    SoftOverlayLayout layout;
+    Soft_LayoutOverlay(w, h, 144, text, layout);
+
+    PixelBuffer full{ pixels.data(), w, h, w, nullptr };
+    PixelBuffer clipped{ pixels.data(), w, h, w, &region };
+    ctx.Run("render_base_full", [&]
+    {
+        Soft_RenderOverlayBase(full, layout, kRegionBg, text);
+        Bench_Consume(pixels[0]);
+    });
+    ctx.Run("render_base_region", [&]
+    {
+        Soft_RenderOverlayBase(clipped, layout, kRegionBg, text);
+        Bench_Consume(pixels[0]);
+    });
+    ctx.Run("copy_base_full", [&]
+    {
+        Soft_Copy(full, base.data(), w);
+        Bench_Consume(pixels[0]);
+    });
+    ctx.Run("copy_base_region", [&]
+    {
+        Soft_Copy(clipped, base.data(), w);
+        Bench_Consume(pixels[0]);
+    });
+
+    // 区域外的像素一个都不能碰
+    const std::uint32_t sentinel = 0xDEADBEEFu;
+    std::fill(pixels.begin(), pixels.end(), sentinel);
+    Soft_RenderOverlayBase(clipped, layout, kRegionBg, text);
+    Soft_RenderOverlayClock(clipped, layout, kRegionBg, 12, 34, 56);
+    size_t leaked = 0;
+    size_t unfilled = 0;
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            const bool touched = pixels[(size_t)y * (size_t)w + (size_t)x] != sentinel;
+            leaked += touched && !region.Contains(x, y) ? 1 : 0;
+            unfilled += !touched && region.Contains(x, y) ? 1 : 0;
+        }
+    }
+    ctx.Report("region_rects", (double)region.Rects().size(), "count");
+    ctx.Report("area_percent", (double)region.Area() * 100.0 / ((double)w * h), "%");
+    ctx.Check("pixels_outside_region", (double)leaked);
+    ctx.Check("pixels_unfilled", (double)unfilled);
+}
+
+SSR_BENCH(OverlayRegions)
+{
+    // 三个显示器：第 2 个关闭，其余右上角留洞；遮罩池只显示两个，并把形状交给后端
+    HeadlessSurfaceBackend backend({
+        MonitorInfo{ ScreenRect{ 0, 0, 1920, 1080 }, 96 },
+        MonitorInfo{ ScreenRect{ 1920, 0, 3840, 1080 }, 96 },
+        MonitorInfo{ ScreenRect{ -2560, 0, 0, 1440 }, 120 },
+    });
+    OverlayPool pool(backend);
+    pool.Prepare();
+    pool.SetRegionSpec("2:+0,0,0,0; *:-75%,0,100%,25%");
+    pool.Show(255);
+
+    size_t shown = 0;
+    size_t errors = 0;
+    size_t index = 0;
+    pool.ForEachSurface([&](SurfaceHandle surface, const MonitorInfo& monitor)
+    {
+        const HeadlessSurfaceBackend::Surface* s = HeadlessSurfaceBackend::FromHandle(surface);
+        shown += s->visible ? 1 : 0;
+        const bool expectVisible = index != 1;
+        errors += s->visible != expectVisible ? 1 : 0;
+        if (expectVisible)
+        {
+            // 右上角的洞不可见，其余可见
+            const int w = monitor.rect.Width();
+            const int h = monitor.rect.Height();
+            errors += s->region.Contains(w - 1, 0) ? 1 : 0;
+            errors += s->region.Contains(0, 0) && s->region.Contains(w - 1, h - 1) ? 0 : 1;
+        }
+        index++;
+    });
+
+    // 显示期间改为整屏：第 2 个遮罩以当前透明度出现，形状取消
+    pool.SetRegionSpec("");
+    size_t shownAfter = 0;
+    pool.ForEachSurface([&](SurfaceHandle surface, const MonitorInfo& monitor)
+    {
+        const HeadlessSurfaceBackend::Surface* s = HeadlessSurfaceBackend::FromHandle(surface);
+        shownAfter += s->visible && s->alpha == 255 ? 1 : 0;
+        errors += s->region.IsExactly(ScreenRect{ 0, 0, monitor.rect.Width(), monitor.rect.Height() }) ? 0 : 1;
+    });
+    ctx.Report("surfaces_shown", (double)shown, "count");
+    ctx.Report("surfaces_shown_full", (double)shownAfter, "count");
+    ctx.Check("region_errors", (double)errors);
+    ctx.Report("region_updates", (double)backend.GetCounters().regions, "count");
+
+    // 几百条规则的解析与按显示器求区域
+    std::string spec;
+    Lcg rng{ 4242u };
+    for (int i = 0; i < 300; i++)
+    {
+        spec += i % 3 == 0 ? "*:+" : "*:-";
+        spec += std::to_string(rng.Next(1800)) + "," + std::to_string(rng.Next(1000)) + ",";
+        spec += std::to_string(rng.Next(100)) + "%," + std::to_string(rng.Next(100)) + "%;";
+    }
+    std::vector<OverlayRegionRule> rules;
+    ScreenRegion region;
+    ctx.Run("parse_300_rules", [&]
+    {
+        OverlayRegion_Parse(spec, rules);
+        Bench_Consume(rules.data());
+    });
+    ctx.Run("build_300_rules", [&]
+    {
+        OverlayRegion_Build(rules, 0, 3840, 2160, region);
+        Bench_Consume(region);
+    });
+    ctx.Report("rules_parsed", (double)rules.size(), "count");
+}
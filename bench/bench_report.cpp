@@ -0,0 +1,373 @@
+#include "bench_report.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    void AppendJsonString(std::string& out, std::string_view s)
+    {
+        out += '"';
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+                out += c;
+            }
+            else if ((unsigned char)c < 0x20)
+            {
+                char esc[8];
+                std::snprintf(esc, sizeof(esc), "\\u%04x", (unsigned)(unsigned char)c);
+                out += esc;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+        out += '"';
+    }
+
+    // 只解析结果文件需要的子集：对象、数组、字符串、数字、true/false/null
+    class Reader
+    {
+    public:
+        explicit Reader(std::string_view text) : m_text(text) {}
+
+        void SkipSpace()
+        {
+            while (m_pos < m_text.size() && std::strchr(" \t\r\n", m_text[m_pos]))
+            {
+                m_pos++;
+            }
+        }
+
+        bool Consume(char c)
+        {
+            SkipSpace();
+            if (m_pos < m_text.size() && m_text[m_pos] == c)
+            {
+                m_pos++;
+                return true;
+            }
+            return false;
+        }
+
+        bool Peek(char c)
+        {
+            SkipSpace();
+            return m_pos < m_text.size() && m_text[m_pos] == c;
+        }
+
+        bool String(std::string& out)
+        {
+            out.clear();
+            if (!Consume('"'))
+            {
+                return false;
+            }
+            while (m_pos < m_text.size())
+            {
+                const char c = m_text[m_pos++];
+                if (c == '"')
+                {
+                    return true;
+                }
+                if (c != '\\')
+                {
+                    out += c;
+                    continue;
+                }
+                if (m_pos >= m_text.size())
+                {
+                    return false;
+                }
+                const char e = m_text[m_pos++];
+                switch (e)
+                {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u':
+                {
+                    // 指标名只有 ASCII；其余码点原样保留为 ?
+                    if (m_pos + 4 > m_text.size())
+                    {
+                        return false;
+                    }
+                    const unsigned long code = std::strtoul(std::string(m_text.substr(m_pos, 4)).c_str(), nullptr, 16);
+                    out += code < 0x80 ? (char)code : '?';
+                    m_pos += 4;
+                    break;
+                }
+                default: out += e; break;
+                }
+            }
+            return false;
+        }
+
+        bool Number(double& out)
+        {
+            SkipSpace();
+            const std::string rest(m_text.substr(m_pos, 64));
+            char* end = nullptr;
+            out = std::strtod(rest.c_str(), &end);
+            if (end == rest.c_str())
+            {
+                return false;
+            }
+            m_pos += (size_t)(end - rest.c_str());
+            return true;
+        }
+
+        // 跳过任意值（未知字段）
+        bool Skip()
+        {
+            SkipSpace();
+            if (m_pos >= m_text.size())
+            {
+                return false;
+            }
+            const char c = m_text[m_pos];
+            if (c == '"')
+            {
+                std::string ignored;
+                return String(ignored);
+            }
+            if (c == '{' || c == '[')
+            {
+                const char close = c == '{' ? '}' : ']';
+                m_pos++;
+                if (Consume(close))
+                {
+                    return true;
+                }
+                do
+                {
+                    if (c == '{')
+                    {
+                        std::string key;
+                        if (!String(key) || !Consume(':'))
+                        {
+                            return false;
+                        }
+                    }
+                    if (!Skip())
+                    {
+                        return false;
+                    }
+                } while (Consume(','));
+                return Consume(close);
+            }
+            for (const char* word : { "true", "false", "null" })
+            {
+                if (m_text.substr(m_pos, std::strlen(word)) == word)
+                {
+                    m_pos += std::strlen(word);
+                    return true;
+                }
+            }
+            double ignored = 0;
+            return Number(ignored);
+        }
+
+        bool AtEnd()
+        {
+            SkipSpace();
+            return m_pos == m_text.size();
+        }
+
+        size_t Pos() const { return m_pos; }
+
+    private:
+        std::string_view m_text;
+        size_t m_pos = 0;
+    };
+
+    bool ParseResult(Reader& r, BenchResult& out)
+    {
+        if (!r.Consume('{'))
+        {
+            return false;
+        }
+        bool hasBench = false;
+        bool hasMetric = false;
+        bool hasValue = false;
+        if (!r.Peek('}'))
+        {
+            do
+            {
+                std::string key;
+                if (!r.String(key) || !r.Consume(':'))
+                {
+                    return false;
+                }
+                bool ok = true;
+                if (key == "bench") { ok = r.String(out.bench); hasBench = true; }
+                else if (key == "metric") { ok = r.String(out.metric); hasMetric = true; }
+                else if (key == "unit") { ok = r.String(out.unit); }
+                else if (key == "value") { ok = r.Number(out.value); hasValue = true; }
+                else if (key == "expected") { ok = r.Number(out.expected); out.check = true; }
+                else { ok = r.Skip(); }
+                if (!ok)
+                {
+                    return false;
+                }
+            } while (r.Consume(','));
+        }
+        return r.Consume('}') && hasBench && hasMetric && hasValue;
+    }
+}
+
+void BenchReport_WriteJson(const std::vector<BenchResult>& results, std::string& out)
+{
+    out += "{\"version\":1,\"results\":[";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& r = results[i];
+        out += i == 0 ? "\n  {\"bench\":" : ",\n  {\"bench\":";
+        AppendJsonString(out, r.bench);
+        out += ",\"metric\":";
+        AppendJsonString(out, r.metric);
+        char value[64];
+        std::snprintf(value, sizeof(value), ",\"value\":%.17g,\"unit\":", r.value);
+        out += value;
+        AppendJsonString(out, r.unit);
+        if (r.check)
+        {
+            std::snprintf(value, sizeof(value), ",\"expected\":%.17g", r.expected);
+            out += value;
+        }
+        out += '}';
+    }
+    out += "\n]}\n";
+}
+
+bool BenchReport_ParseJson(std::string_view text, std::vector<BenchResult>& out, std::string& error)
+{
+    out.clear();
+    Reader r(text);
+    if (!r.Consume('{'))
+    {
+        error = "expected object";
+        return false;
+    }
+    bool hasResults = false;
+    if (!r.Peek('}'))
+    {
+        do
+        {
+            std::string key;
+            if (!r.String(key) || !r.Consume(':'))
+            {
+                error = "bad key at offset " + std::to_string(r.Pos());
+                return false;
+            }
+            if (key != "results")
+            {
+                if (!r.Skip())
+                {
+                    error = "bad value at offset " + std::to_string(r.Pos());
+                    return false;
+                }
+                continue;
+            }
+            hasResults = true;
+            if (!r.Consume('['))
+            {
+                error = "results is not an array";
+                return false;
+            }
+            if (r.Consume(']'))
+            {
+                continue;
+            }
+            do
+            {
+                BenchResult result;
+                if (!ParseResult(r, result))
+                {
+                    error = "bad result at offset " + std::to_string(r.Pos());
+                    return false;
+                }
+                out.push_back(std::move(result));
+            } while (r.Consume(','));
+            if (!r.Consume(']'))
+            {
+                error = "unterminated results at offset " + std::to_string(r.Pos());
+                return false;
+            }
+        } while (r.Consume(','));
+    }
+    if (!r.Consume('}') || !r.AtEnd())
+    {
+        error = "trailing data at offset " + std::to_string(r.Pos());
+        return false;
+    }
+    if (!hasResults)
+    {
+        error = "missing results";
+        return false;
+    }
+    return true;
+}
+
+bool BenchReport_IsTiming(std::string_view unit)
+{
+    return unit == "ns/op" || unit == "ns" || unit == "us" || unit == "ms";
+}
+
+bool BenchReport_IsThroughput(std::string_view unit)
+{
+    if (unit.size() < 3 || unit.substr(unit.size() - 2) != "/s")
+    {
+        return false;
+    }
+    const std::string_view per = unit.substr(0, unit.size() - 2);
+    return per != "1" && !BenchReport_IsTiming(per);
+}
+
+std::vector<const BenchResult*> BenchReport_FailedChecks(const std::vector<BenchResult>& results)
+{
+    std::vector<const BenchResult*> out;
+    for (const BenchResult& r : results)
+    {
+        if (r.check && r.value != r.expected)
+        {
+            out.push_back(&r);
+        }
+    }
+    return out;
+}
+
+std::vector<BenchComparison> BenchReport_Compare(const std::vector<BenchResult>& baseline, const std::vector<BenchResult>& current, double thresholdPercent)
+{
+    std::vector<BenchComparison> out;
+    for (const BenchResult& cur : current)
+    {
+        const bool timing = BenchReport_IsTiming(cur.unit);
+        if (!timing && !BenchReport_IsThroughput(cur.unit))
+        {
+            continue;
+        }
+        for (const BenchResult& base : baseline)
+        {
+            if (base.bench != cur.bench || base.metric != cur.metric || base.unit != cur.unit)
+            {
+                continue;
+            }
+            BenchComparison c;
+            c.baseline = &base;
+            c.current = &cur;
+            c.changePercent = base.value > 0 ? (cur.value - base.value) * 100.0 / base.value : 0;
+            c.regressed = base.value > 0 && (timing ? c.changePercent > thresholdPercent : c.changePercent < -thresholdPercent);
+            out.push_back(c);
+            break;
+        }
+    }
+    return out;
+}
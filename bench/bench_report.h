@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ssr_bench 的结果文件：
+//   {"version":1,"results":[{"bench":"ConfigLoad","metric":"parse_schema","value":812.5,"unit":"ns/op"},...]}
+// 每个发布候选版本都跑一遍，与保存的基线比较。
+
+struct BenchResult
+{
+    std::string bench;
+    std::string metric;
+    double value = 0;
+    std::string unit;
+    // 核对类指标在结果文件里多一个 "expected" 字段
+    bool check = false;
+    double expected = 0;
+};
+
+void BenchReport_WriteJson(const std::vector<BenchResult>& results, std::string& out);
+// 只认上面的格式（键的顺序与空白不限）；失败时 error 给出原因
+bool BenchReport_ParseJson(std::string_view text, std::vector<BenchResult>& out, std::string& error);
+
+// 耗时类单位（ns/op、ns、us、ms）越小越好，参与比较
+bool BenchReport_IsTiming(std::string_view unit);
+// 吞吐类单位（req/s、MB/s、frames/s 等，不含 1/s 与 ms/s 这类频率/占用）越大越好，参与比较；计数、字节等只记录
+bool BenchReport_IsThroughput(std::string_view unit);
+
+// value 与 expected 不等的核对类指标（BenchContext::Check 报告的），与基线无关，ssr_bench 据此返回 1
+std::vector<const BenchResult*> BenchReport_FailedChecks(const std::vector<BenchResult>& results);
+
+struct BenchComparison
+{
+    const BenchResult* baseline = nullptr;
+    const BenchResult* current = nullptr;
+    double changePercent = 0;
+    bool regressed = false;
+};
+
+// 按 (bench, metric) 配对；耗时比基线慢、吞吐比基线低超过 thresholdPercent 的记为回退。基线里没有的指标不比较
+std::vector<BenchComparison> BenchReport_Compare(const std::vector<BenchResult>& baseline, const std::vector<BenchResult>& current, double thresholdPercent);
@@ -0,0 +1,234 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "scheduler_state.h"
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // 所有字段都由同一个 k 推出，读到的记录若混杂了两次写入就能被发现
+    SchedulerStateRecord RecordFor(std::uint64_t k)
+    {
+        SchedulerStateRecord r;
+        r.deadlineUnixMs = k * 1000 + 1;
+        r.lastBreakUnixMs = k * 3;
+        r.savedUnixMs = k * 1000;
+        r.intervalMinutes = (std::uint32_t)(k % 1440) + 1;
+        r.pendingSnoozeMinutes = (std::uint32_t)(k % 7);
+        return r;
+    }
+
+    bool RecordIs(const SchedulerStateRecord& r, std::uint64_t& k)
+    {
+        if (r.deadlineUnixMs == 0)
+        {
+            return false;
+        }
+        k = (r.deadlineUnixMs - 1) / 1000;
+        const SchedulerStateRecord expect = RecordFor(k);
+        return std::memcmp(&r, &expect, sizeof(r)) == 0;
+    }
+
+    std::string StatePath(const char* tag)
+    {
+#ifdef _WIN32
+        return std::string("ssr-state-") + tag + ".bin";
+#else
+        return "/tmp/ssr-state-" + std::to_string((long)getpid()) + "-" + tag + ".bin";
+#endif
+    }
+}
+
+SSR_BENCH(SchedulerStateTornWrite)
+{
+    // 在一个有效状态上，把下一次写入的槽位只写前 n 字节，模拟写到一半被杀掉
+    const std::string path = StatePath("torn");
+    std::remove(path.c_str());
+    int violations = 0;
+    int recoveredOld = 0;
+    int recoveredNew = 0;
+    for (size_t n = 0; n <= SCHEDULER_STATE_SLOT_SIZE; n++)
+    {
+        std::vector<std::uint8_t> before;
+        std::vector<std::uint8_t> after;
+        {
+            SchedulerStateFile file;
+            SchedulerStateRecord ignored;
+            file.Open(path, ignored);
+            file.Save(RecordFor(10 + n));
+            before.resize(SCHEDULER_STATE_FILE_SIZE);
+            MappedFile view;
+            view.OpenRead(path);
+            std::memcpy(before.data(), view.data(), before.size());
+            file.Save(RecordFor(20 + n));
+            view.OpenRead(path);
+            after.assign(view.data(), view.data() + SCHEDULER_STATE_FILE_SIZE);
+        }
+        // 找到这次写入改动的槽位，只保留前 n 字节
+        std::vector<std::uint8_t> torn = before;
+        size_t slotStart = 16;
+        if (std::memcmp(before.data() + 16, after.data() + 16, SCHEDULER_STATE_SLOT_SIZE) == 0)
+        {
+            slotStart += SCHEDULER_STATE_SLOT_SIZE;
+        }
+        std::memcpy(torn.data() + slotStart, after.data() + slotStart, n);
+
+        SchedulerStateRecord r;
+        std::uint64_t seq = 0;
+        std::uint64_t k = 0;
+        const bool ok = SchedulerState_Parse(torn.data(), torn.size(), r, seq) && RecordIs(r, k);
+        if (!ok || (k != 10 + n && k != 20 + n) || (n == SCHEDULER_STATE_SLOT_SIZE && k != 20 + n))
+        {
+            violations++;
+        }
+        recoveredOld += ok && k == 10 + n ? 1 : 0;
+        recoveredNew += ok && k == 20 + n ? 1 : 0;
+    }
+    std::remove(path.c_str());
+    ctx.Report("prefixes", (double)(SCHEDULER_STATE_SLOT_SIZE + 1), "count");
+    ctx.Report("recovered_previous", (double)recoveredOld, "count");
+    ctx.Report("recovered_new", (double)recoveredNew, "count");
+    ctx.Check("violations", (double)violations);
+
+    // 启动时的恢复规则
+    const std::uint64_t now = 1'000'000'000'000ull;
+    const std::uint32_t interval = 60;
+    const std::uint64_t intervalMs = 60ull * 60 * 1000;
+    struct ResumeCase { SchedulerStateRecord r; std::uint32_t expect; };
+    SchedulerStateRecord future{};
+    future.deadlineUnixMs = now + 25 * 60 * 1000;
+    future.savedUnixMs = now - 35 * 60 * 1000;
+    SchedulerStateRecord skewed = future;
+    skewed.deadlineUnixMs = now + 3 * intervalMs;
+    SchedulerStateRecord overdue{};
+    overdue.deadlineUnixMs = now - 10 * 60 * 1000;
+    SchedulerStateRecord longAway{};
+    longAway.deadlineUnixMs = now - 2 * intervalMs;
+    SchedulerStateRecord snoozed = overdue;
+    snoozed.pendingSnoozeMinutes = 15;
+    snoozed.savedUnixMs = now - 60 * 1000;
+    SchedulerStateRecord staleSnooze = snoozed;
+    staleSnooze.savedUnixMs = now - 2 * intervalMs;
+    staleSnooze.deadlineUnixMs = now - 2 * intervalMs;
+    const ResumeCase cases[] = {
+        { SchedulerStateRecord{}, 0 },
+        { future, 25u * 60 * 1000 },
+        { skewed, (std::uint32_t)intervalMs },
+        { overdue, SCHEDULER_RESUME_GRACE_MS },
+        { longAway, 0 },
+        { snoozed, 15u * 60 * 1000 },
+        { staleSnooze, 0 },
+    };
+    int resumeMismatches = 0;
+    for (const auto& c : cases)
+    {
+        resumeMismatches += SchedulerState_ResumeDelayMs(c.r, now, interval) == c.expect ? 0 : 1;
+    }
+    ctx.Check("resume_rule_mismatches", (double)resumeMismatches);
+
+    // 写入只是一次内存拷贝；启动时的打开与解析只做一次
+    SchedulerStateFile file;
+    SchedulerStateRecord loaded;
+    file.Open(path, loaded);
+    std::uint64_t k = 0;
+    ctx.Run("save", [&] { file.Save(RecordFor(++k)); });
+    file.Close();
+    ctx.Run("open_and_parse", [&]
+    {
+        SchedulerStateFile reopen;
+        SchedulerStateRecord r;
+        Bench_Consume(reopen.Open(path, r));
+    });
+    std::remove(path.c_str());
+}
+
+#ifndef _WIN32
+
+SSR_BENCH(SchedulerStateKill)
+{
+    // 子进程不停写入，父进程在随机时刻 SIGKILL；之后读到的记录必须完整，且不早于已确认的最后一次写入
+    const std::string path = StatePath("kill");
+    const int rounds = 200;
+    auto* acked = static_cast<volatile std::uint64_t*>(mmap(nullptr, sizeof(std::uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (acked == MAP_FAILED)
+    {
+        ctx.Check("mmap_failed", 1, 0, "bool");
+        return;
+    }
+
+    int violations = 0;
+    int lost = 0;
+    std::uint64_t writes = 0;
+    std::uint32_t seed = 0x9E3779B9u;
+    for (int round = 0; round < rounds; round++)
+    {
+        std::remove(path.c_str());
+        *acked = 0;
+        int ready[2];
+        if (pipe(ready) != 0)
+        {
+            violations++;
+            break;
+        }
+        const pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(ready[0]);
+            SchedulerStateFile file;
+            SchedulerStateRecord ignored;
+            file.Open(path, ignored);
+            char c = 1;
+            [[maybe_unused]] ssize_t w = write(ready[1], &c, 1);
+            for (std::uint64_t k = 1;; k++)
+            {
+                file.Save(RecordFor(k));
+                *acked = k;
+            }
+        }
+        close(ready[1]);
+        char c;
+        [[maybe_unused]] ssize_t r = read(ready[0], &c, 1);
+        close(ready[0]);
+        seed = seed * 1664525u + 1013904223u;
+        usleep(50 + (seed >> 8) % 400);
+        kill(pid, SIGKILL);
+        int status = 0;
+        waitpid(pid, &status, 0);
+
+        const std::uint64_t ackedK = *acked;
+        writes += ackedK;
+        MappedFile view;
+        SchedulerStateRecord rec;
+        std::uint64_t seq = 0;
+        std::uint64_t k = 0;
+        const bool parsed = view.OpenRead(path) && SchedulerState_Parse(view.data(), view.size(), rec, seq);
+        if (ackedK == 0)
+        {
+            continue;
+        }
+        if (!parsed || !RecordIs(rec, k) || k < ackedK || k > ackedK + 1)
+        {
+            violations++;
+        }
+        lost += parsed && k < ackedK ? 1 : 0;
+    }
+    std::remove(path.c_str());
+    munmap((void*)acked, sizeof(std::uint64_t));
+
+    ctx.Report("kills", (double)rounds, "count");
+    ctx.Report("writes_before_kill", (double)writes, "count");
+    ctx.Check("lost_acked_writes", (double)lost);
+    ctx.Check("violations", (double)violations);
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "overlay_frame.h"
+#include "process_footprint.h"
+#include "show_arena.h"
+#include "soft_render.h"
+
+namespace
+{
+    const ColorRef kArenaBg = MakeColor(0x30, 0x50, 0x70);
+
+    // 一次提醒：每个显示器预渲染首帧（底图 + 时间）放进画面缓存，再复制一份文字与版面，
+    // 与 Win32/X11 遮罩在显示期间的分配相同
+    void ShowOnce(OverlayFrameCache& cache, const std::vector<MonitorInfo>& monitors, const std::wstring& text, int cycle)
+    {
+        for (size_t i = 0; i < monitors.size(); i++)
+        {
+            const int w = monitors[i].rect.Width();
+            const int h = monitors[i].rect.Height();
+            const std::wstring copy = text;
+            auto frame = std::make_shared<OverlayFrame>();
+            frame->key = OverlayFrameKey{ w, h, monitors[i].dpi, OverlayFrame_ContentHash(kArenaBg, copy) };
+            frame->clockSecond = cycle;
+            frame->base.resize((size_t)w * (size_t)h);
+            PixelBuffer buf{ frame->base.data(), w, h, w };
+            SoftOverlayLayout layout;
+            Soft_LayoutOverlay(w, h, monitors[i].dpi, copy, layout);
+            Soft_RenderOverlayBase(buf, layout, kArenaBg, copy);
+            frame->composed = frame->base;
+            buf.pixels = frame->composed.data();
+            Soft_RenderOverlayClock(buf, layout, kArenaBg, cycle / 3600 % 24, cycle / 60 % 60, cycle % 60);
+            cache.Store(reinterpret_cast<SurfaceHandle>(i + 1), std::move(frame));
+        }
+    }
+
+    void HideOnce(OverlayFrameCache& cache)
+    {
+        cache.Clear();
+        ShowArena_Overlay().Release();
+        ProcessFootprint_Trim();
+    }
+}
+
+SSR_BENCH(ShowArenaCycles)
+{
+    // 1000 次显示/隐藏后，提醒之间的常驻内存应回到第一次隐藏后的基线
+    ProcessFootprint footprint;
+    if (!ProcessFootprint_Read(0, footprint))
+    {
+        ctx.Check("smaps_unavailable", 1, 0, "bool");
+        return;
+    }
+    const std::vector<MonitorInfo> monitors{ MonitorInfo{ ScreenRect{ 0, 0, 1280, 720 }, 96 }, MonitorInfo{ ScreenRect{ 1280, 0, 2080, 600 }, 120 } };
+    const std::wstring text = L"该休息一下了，看看远处，放松眼睛。\nTake a break and look at something far away.";
+    OverlayFrameCache cache;
+
+    ShowOnce(cache, monitors, text, 0);
+    HideOnce(cache);
+    ProcessFootprint_Read(0, footprint);
+    const std::uint64_t baseline = footprint.rssBytes;
+
+    const int cycles = 1000;
+    std::uint64_t activePeak = 0;
+    std::uint64_t idlePeak = 0;
+    for (int cycle = 1; cycle <= cycles; cycle++)
+    {
+        ShowOnce(cache, monitors, text, cycle);
+        if (cycle % 100 == 0)
+        {
+            ProcessFootprint_Read(0, footprint);
+            activePeak = std::max(activePeak, footprint.rssBytes);
+        }
+        HideOnce(cache);
+        if (cycle % 100 == 0)
+        {
+            ProcessFootprint_Read(0, footprint);
+            idlePeak = std::max(idlePeak, footprint.rssBytes);
+        }
+    }
+    ProcessFootprint_Read(0, footprint);
+    const std::uint64_t idle = footprint.rssBytes;
+    const ShowArenaStats stats = ShowArena_Overlay().Stats();
+
+    // 页表、smaps 读取本身等会有少量浮动，允许 512KB
+    const std::uint64_t tolerance = 512 * 1024;
+    int violations = 0;
+    violations += idle <= baseline + tolerance ? 0 : 1;
+    violations += idlePeak <= baseline + tolerance ? 0 : 1;
+    violations += stats.reservedBytes == 0 && stats.liveBytes == 0 ? 0 : 1;
+    violations += stats.releases >= (std::uint64_t)cycles ? 0 : 1;
+
+    // Release 时仍有一帧被引用：只有它所在的块留下并计入 pinnedBytes，其余立即归还，
+    // 这一帧释放后全部归还
+    int pinnedViolations = 0;
+    {
+        ShowOnce(cache, monitors, text, 1);
+        const auto held = cache.Find(reinterpret_cast<SurfaceHandle>((size_t)1), OverlayFrameKey{ monitors[0].rect.Width(), monitors[0].rect.Height(),
+            monitors[0].dpi, OverlayFrame_ContentHash(kArenaBg, text) });
+        const std::uint64_t deferredBefore = ShowArena_Overlay().Stats().deferred;
+        const std::uint64_t reservedShown = ShowArena_Overlay().Stats().reservedBytes;
+        HideOnce(cache);
+        const ShowArenaStats pinned = ShowArena_Overlay().Stats();
+        pinnedViolations += held && pinned.deferred == deferredBefore + 1 ? 0 : 1;
+        pinnedViolations += pinned.pinnedBytes > 0 && pinned.pinnedBytes == pinned.reservedBytes && pinned.reservedBytes < reservedShown ? 0 : 1;
+        // 被占住的块不再分配：下一次提醒用新的块
+        ShowOnce(cache, monitors, text, 2);
+        HideOnce(cache);
+        pinnedViolations += ShowArena_Overlay().Stats().reservedBytes == pinned.pinnedBytes ? 0 : 1;
+        ctx.Report("pinned_bytes", (double)pinned.pinnedBytes, "bytes");
+    }
+    const ShowArenaStats unpinned = ShowArena_Overlay().Stats();
+    pinnedViolations += unpinned.reservedBytes == 0 && unpinned.pinnedBytes == 0 && unpinned.liveBytes == 0 ? 0 : 1;
+    violations += pinnedViolations;
+
+    ctx.Report("idle_baseline", (double)baseline, "bytes");
+    ctx.Report("idle_after", (double)idle, "bytes");
+    ctx.Report("idle_growth", (double)idle - (double)baseline, "bytes");
+    ctx.Report("active_peak", (double)activePeak, "bytes");
+    ctx.Report("arena_peak", (double)stats.peakBytes, "bytes");
+    ctx.Report("arena_releases", (double)stats.releases, "count");
+    ctx.Check("pinned_violations", (double)pinnedViolations);
+    ctx.Check("violations", (double)violations);
+
+    ctx.Run("show_hide_cycle", [&]
+    {
+        ShowOnce(cache, monitors, text, 1);
+        HideOnce(cache);
+    });
+}
@@ -0,0 +1,262 @@
+#include "bench.h"
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "control_server.h"
+#include "single_instance.h"
+
+namespace
+{
+    struct LaunchRecord
+    {
+        std::int32_t primary;
+        std::int32_t ok;
+        std::uint32_t received;
+        double micros;
+    };
+
+    // 一次“启动”：抢到锁就当唯一实例，等其余启动把命令转发过来；否则转发后退出
+    LaunchRecord Launch(const std::string& lockName, const std::string& endpoint, int launches)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        LaunchRecord record{};
+
+        SingleInstance instance;
+        if (instance.Acquire(lockName))
+        {
+            record.primary = 1;
+            std::atomic<std::uint32_t> received{0};
+            ControlServer server;
+            record.ok = server.Start(endpoint, [&](std::vector<ControlRequest>& batch)
+            {
+                std::vector<ControlResponse> responses(batch.size());
+                for (size_t i = 0; i < batch.size(); i++)
+                {
+                    responses[i].client = batch[i].client;
+                    responses[i].id = batch[i].id;
+                }
+                received.fetch_add((std::uint32_t)batch.size());
+                server.Respond(responses);
+            }) ? 1 : 0;
+
+            const auto deadline = start + std::chrono::seconds(5);
+            while (record.ok && received.load() < (std::uint32_t)(launches - 1) && Clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            // 留一点时间把最后的应答写出去
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            server.Stop();
+            record.received = received.load();
+        }
+        else
+        {
+            InstanceVerb verb;
+            verb.op = ControlOp::TriggerNow;
+            ControlResponse response;
+            record.ok = Instance_Forward(endpoint, verb, 5000, response) ? 1 : 0;
+        }
+        record.micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        return record;
+    }
+}
+
+SSR_BENCH(SingleInstanceRace)
+{
+    const int launches = 32;
+    const std::string base = "/tmp/ssr-race-" + std::to_string((long)getpid());
+    const std::string lockName = base + ".lock";
+    const std::string endpoint = base + ".sock";
+
+    // 所有子进程先阻塞在 startPipe 上，父进程关闭写端后同时放行
+    int startPipe[2];
+    int resultPipe[2];
+    if (pipe(startPipe) != 0 || pipe(resultPipe) != 0)
+    {
+        ctx.Check("pipe_failed", 1, 0, "bool");
+        return;
+    }
+
+    std::vector<pid_t> children;
+    for (int i = 0; i < launches; i++)
+    {
+        const pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(startPipe[1]);
+            close(resultPipe[0]);
+            char c;
+            [[maybe_unused]] ssize_t r = read(startPipe[0], &c, 1);
+            const LaunchRecord record = Launch(lockName, endpoint, launches);
+            [[maybe_unused]] ssize_t w = write(resultPipe[1], &record, sizeof(record));
+            _exit(0);
+        }
+        if (pid > 0)
+        {
+            children.push_back(pid);
+        }
+    }
+    close(startPipe[0]);
+    close(startPipe[1]);
+    close(resultPipe[1]);
+
+    std::vector<LaunchRecord> records;
+    LaunchRecord record;
+    while (read(resultPipe[0], &record, sizeof(record)) == (ssize_t)sizeof(record))
+    {
+        records.push_back(record);
+    }
+    close(resultPipe[0]);
+    for (pid_t pid : children)
+    {
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+
+    int primaries = 0;
+    int forwarded = 0;
+    int failures = 0;
+    std::uint32_t received = 0;
+    std::vector<double> forwardUs;
+    for (const auto& r : records)
+    {
+        if (r.primary)
+        {
+            primaries++;
+            received += r.received;
+            failures += r.ok ? 0 : 1;
+            continue;
+        }
+        if (r.ok)
+        {
+            forwarded++;
+            forwardUs.push_back(r.micros);
+        }
+        else
+        {
+            failures++;
+        }
+    }
+    std::sort(forwardUs.begin(), forwardUs.end());
+    auto percentile = [&](double p) { return forwardUs.empty() ? 0.0 : forwardUs[std::min(forwardUs.size() - 1, (size_t)(p * (double)(forwardUs.size() - 1)))]; };
+
+    // 同时启动时，后来者可能要等唯一实例开始监听，因此这里的延迟包含对方的启动时间
+    ctx.Report("launches", (double)records.size(), "count");
+    ctx.Report("primaries", (double)primaries, "count");
+    ctx.Report("forwarded", (double)forwarded, "count");
+    ctx.Report("received_by_primary", (double)received, "count");
+    ctx.Check("failures", (double)failures);
+    ctx.Report("race_forward_p50", percentile(0.50), "us");
+    ctx.Report("race_forward_p99", percentile(0.99), "us");
+
+    // 唯一实例已就绪时，第二次启动从检查锁到收到应答的耗时
+    SingleInstance holder;
+    holder.Acquire(lockName);
+    ControlServer server;
+    server.Start(endpoint, [&](std::vector<ControlRequest>& batch)
+    {
+        std::vector<ControlResponse> responses(batch.size());
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            responses[i].client = batch[i].client;
+            responses[i].id = batch[i].id;
+        }
+        server.Respond(responses);
+    });
+    int warmFailures = 0;
+    ctx.Run("forward_warm", [&]
+    {
+        SingleInstance second;
+        InstanceVerb verb;
+        verb.op = ControlOp::TriggerNow;
+        ControlResponse response;
+        if (second.Acquire(lockName) || !Instance_Forward(endpoint, verb, 1000, response))
+        {
+            warmFailures++;
+        }
+    });
+    ctx.Check("warm_failures", (double)warmFailures);
+    server.Stop();
+    holder.Release();
+    unlink(lockName.c_str());
+}
+
+SSR_BENCH(SingleInstanceEndpointSafety)
+{
+    // 别的用户能进入的运行目录不用；端点或锁文件的位置上已有别的东西（普通文件、符号链接）时
+    // 启动失败且不删除、不跟随它
+    namespace fs = std::filesystem;
+    const fs::path base = "/tmp/ssr-bench-endpoint-" + std::to_string((long)getpid());
+    std::error_code ec;
+    fs::remove_all(base, ec);
+    fs::create_directories(base / "public", ec);
+    fs::create_directories(base / "private", ec);
+    chmod((base / "public").c_str(), 0755);
+    chmod((base / "private").c_str(), 0700);
+
+    const char* oldRuntime = std::getenv("XDG_RUNTIME_DIR");
+    const std::string savedRuntime = oldRuntime ? oldRuntime : "";
+    int unsafe = 0;
+    int violations = 0;
+
+    setenv("XDG_RUNTIME_DIR", (base / "public").c_str(), 1);
+    unsafe += ControlServer::DefaultEndpoint().empty() && SingleInstance::DefaultName().empty() ? 0 : 1;
+    setenv("XDG_RUNTIME_DIR", (base / "private").c_str(), 1);
+    violations += ControlServer::DefaultEndpoint() == (base / "private" / "ssr-control.sock").string() ? 0 : 1;
+    unsetenv("XDG_RUNTIME_DIR");
+    const std::string fallback = ControlServer::DefaultEndpoint();
+    struct stat st{};
+    violations += !fallback.empty() && lstat(fs::path(fallback).parent_path().c_str(), &st) == 0 && (st.st_mode & 0777) == 0700 ? 0 : 1;
+    if (oldRuntime)
+    {
+        setenv("XDG_RUNTIME_DIR", savedRuntime.c_str(), 1);
+    }
+
+    const fs::path target = base / "private" / "target";
+    std::ofstream(target) << "keep";
+    const fs::path regular = base / "private" / "regular.sock";
+    std::ofstream(regular) << "keep";
+    const fs::path link = base / "private" / "link.sock";
+    fs::create_symlink(target, link, ec);
+    auto handler = [](std::vector<ControlRequest>&) {};
+    {
+        ControlServer server;
+        unsafe += server.Start(regular.string(), handler) ? 1 : 0;
+        server.Stop();
+    }
+    {
+        ControlServer server;
+        unsafe += server.Start(link.string(), handler) ? 1 : 0;
+        server.Stop();
+    }
+    violations += fs::is_regular_file(regular, ec) && fs::is_symlink(fs::symlink_status(link, ec)) ? 0 : 1;
+
+    const fs::path lockLink = base / "private" / "lock.lock";
+    fs::create_symlink(base / "private" / "lock-target", lockLink, ec);
+    {
+        SingleInstance instance;
+        unsafe += instance.Acquire(lockLink.string()) ? 1 : 0;
+    }
+    violations += fs::exists(base / "private" / "lock-target", ec) ? 1 : 0;
+
+    fs::remove_all(base, ec);
+    ctx.Check("unsafe_accepted", (double)unsafe);
+    ctx.Check("violations", (double)violations);
+}
+
+#endif
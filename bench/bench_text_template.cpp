@@ -0,0 +1,293 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "soft_render.h"
+#include "text_template.h"
+
+namespace
+{
+    const ColorRef kTextBg = MakeColor(0x20, 0x30, 0x40);
+
+    // 不经过编译的展开：每次都从头扫描整段文字，逐个替换占位符（基准对照，也用来核对结果）
+    std::wstring NaiveExpand(const std::wstring& source, const TemplateInputs& in)
+    {
+        static const wchar_t* const kNames[] = { L"time", L"date", L"next_break", L"breaks_today", L"idle_minutes" };
+        std::wstring out;
+        std::wstring value;
+        for (size_t i = 0; i < source.size(); i++)
+        {
+            const wchar_t ch = source[i];
+            if (ch == L'\r')
+            {
+                continue;
+            }
+            if ((ch == L'{' || ch == L'}') && i + 1 < source.size() && source[i + 1] == ch)
+            {
+                out.push_back(ch);
+                i++;
+                continue;
+            }
+            if (ch == L'{')
+            {
+                const size_t close = source.find(L'}', i + 1);
+                const size_t newline = source.find(L'\n', i + 1);
+                bool replaced = false;
+                for (int v = 0; close != std::wstring::npos && close < newline && v < TEMPLATE_VAR_COUNT && !replaced; v++)
+                {
+                    if (source.compare(i + 1, close - i - 1, kNames[v]) == 0)
+                    {
+                        TextTemplate::Format((TemplateVar)v, in, value);
+                        out += value;
+                        i = close;
+                        replaced = true;
+                    }
+                }
+                if (replaced)
+                {
+                    continue;
+                }
+            }
+            out.push_back(ch);
+        }
+        return out;
+    }
+
+    std::vector<std::wstring> SplitLines(const std::wstring& text)
+    {
+        std::vector<std::wstring> lines;
+        if (text.empty())
+        {
+            return lines;
+        }
+        size_t pos = 0;
+        for (;;)
+        {
+            const size_t end = text.find(L'\n', pos);
+            lines.push_back(text.substr(pos, end == std::wstring::npos ? std::wstring::npos : end - pos));
+            if (end == std::wstring::npos)
+            {
+                return lines;
+            }
+            pos = end + 1;
+        }
+    }
+
+    // staticLines 行固定文字，中间插一行 {time}，末尾一行日期与计数
+    std::wstring MakeTemplate(int staticLines)
+    {
+        std::wstring text;
+        for (int i = 0; i < staticLines; i++)
+        {
+            if (i == staticLines / 2)
+            {
+                text += L"现在是 {time}，已经坐了很久\n";
+            }
+            text += L"第 " + std::to_wstring(i) + L" 行：起来走走，看看远处 {{放松}}\n";
+        }
+        text += L"{date} 今天第 {breaks_today} 次提醒，下一次 {next_break}，空闲 {idle_minutes} 分钟";
+        return text;
+    }
+
+    TemplateInputs InputsAt(std::int64_t second)
+    {
+        TemplateInputs in;
+        in.year = 2026;
+        in.month = 10;
+        in.day = 19 + (int)(second / 86400 % 10);
+        in.hour = (int)(second / 3600 % 24);
+        in.minute = (int)(second / 60 % 60);
+        in.second = (int)(second % 60);
+        in.nextBreakHour = (in.hour + 1) % 24;
+        in.nextBreakMinute = in.minute;
+        in.breaksToday = 3;
+        in.idleMinutes = 2;
+        return in;
+    }
+
+    // 逐行与不经过编译的展开比较，返回不一致的行数
+    int Mismatches(const TextTemplate& text, const std::wstring& source, const TemplateInputs& in)
+    {
+        const std::vector<std::wstring> expected = SplitLines(NaiveExpand(source, in));
+        int bad = expected.size() == text.LineCount() ? 0 : 1;
+        for (size_t i = 0; i < expected.size() && i < text.LineCount(); i++)
+        {
+            bad += expected[i] == text.Line(i) ? 0 : 1;
+        }
+        return bad;
+    }
+}
+
+SSR_BENCH(TextTemplateTick)
+{
+    int violations = 0;
+
+    // 转义与不认识的占位符原样保留，行尾的 \r 丢弃
+    {
+        TextTemplate text;
+        text.Compile(L"a{{b}}c {nope} {time\r\n{{time}} {date}}\n\n{idle_minutes}");
+        TemplateInputs in = InputsAt(3723);
+        in.idleMinutes = 42;
+        text.Update(in);
+        const bool ok = text.LineCount() == 4
+            && text.Line(0) == L"a{b}c {nope} {time"
+            && text.Line(1) == L"{time} 2026-10-19}"
+            && text.Line(2).empty()
+            && text.Line(3) == L"42"
+            && !text.IsDynamicLine(0) && text.IsDynamicLine(1) && text.IsDynamicLine(3)
+            && text.UsedVars() == ((1u << (int)TemplateVar::Date) | (1u << (int)TemplateVar::IdleMinutes));
+        violations += ok ? 0 : 1;
+        ctx.Check("escape_violations", ok ? 0.0 : 1.0);
+
+        TemplateInputs paused = in;
+        paused.nextBreakHour = -1;
+        std::wstring value;
+        TextTemplate::Format(TemplateVar::NextBreak, paused, value);
+        violations += value == L"--:--" ? 0 : 1;
+    }
+
+    // 一整天逐秒（抽样）推进：每次展开都与逐个替换的结果一致，且只报告真正变了的行
+    const std::wstring source = MakeTemplate(100);
+    TextTemplate text;
+    text.Compile(source);
+    int mismatches = 0;
+    int wrongChanges = 0;
+    std::vector<std::wstring> previous;
+    for (std::int64_t second = 0; second < 3 * 86400; second += 37)
+    {
+        const TemplateInputs in = InputsAt(second);
+        text.Update(in);
+        mismatches += Mismatches(text, source, in);
+        const std::vector<std::wstring> lines = SplitLines(NaiveExpand(source, in));
+        std::vector<std::uint32_t> expected;
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            if (previous.empty() || previous[i] != lines[i])
+            {
+                expected.push_back((std::uint32_t)i);
+            }
+        }
+        std::vector<std::uint32_t> changed(text.ChangedLines().begin(), text.ChangedLines().end());
+        std::sort(changed.begin(), changed.end());
+        wrongChanges += changed == expected ? 0 : 1;
+        previous = lines;
+    }
+    // 输入没变时不报告任何变化，版本也不前进
+    const std::uint64_t revision = text.Revision();
+    text.Update(InputsAt(3 * 86400 + 5));
+    const size_t sameAgain = text.Update(InputsAt(3 * 86400 + 5));
+    violations += sameAgain == 0 && text.Revision() == revision + 1 ? 0 : 1;
+    violations += mismatches == 0 ? 0 : 1;
+    violations += wrongChanges == 0 ? 0 : 1;
+    ctx.Check("mismatched_lines", (double)mismatches);
+    ctx.Check("wrong_change_sets", (double)wrongChanges);
+
+    // 行高缓存只测量变了的行
+    {
+        TextLineLayout layout;
+        int measured = 0;
+        auto measure = [&](std::wstring_view line)
+        {
+            measured++;
+            return Soft_TextRows(line, 24);
+        };
+        text.Update(InputsAt(10));
+        layout.Update(text, 1, measure);
+        const int full = measured;
+        measured = 0;
+        text.Update(InputsAt(11));
+        const bool moved = layout.Update(text, 1, measure);
+        const int perTick = measured;
+        violations += full == (int)text.LineCount() && perTick == 1 && !moved ? 0 : 1;
+        // 宽度或 DPI 变了才全部重新测量
+        measured = 0;
+        layout.Update(text, 2, measure);
+        violations += measured == (int)text.LineCount() ? 0 : 1;
+        ctx.Report("measured_lines_per_tick", (double)perTick, "lines");
+    }
+
+    // 每秒的代价：模板从 1 行增长到 1000 行，编译后的更新（含行高缓存）应保持不变，
+    // 逐个替换的展开随长度线性增长
+    double firstTickNs = 0;
+    double lastTickNs = 0;
+    for (int staticLines : { 1, 10, 100, 1000 })
+    {
+        const std::wstring big = MakeTemplate(staticLines);
+        TextTemplate compiled;
+        compiled.Compile(big);
+        TextLineLayout lines;
+        auto measure = [](std::wstring_view line) { return Soft_TextRows(line, 60); };
+        std::int64_t second = 0;
+        compiled.Update(InputsAt(second));
+        lines.Update(compiled, 1, measure);
+
+        char metric[64];
+        std::snprintf(metric, sizeof(metric), "tick_ns_lines_%d", staticLines);
+        ctx.Run(metric, [&]
+        {
+            compiled.Update(InputsAt(++second));
+            lines.Update(compiled, 1, measure);
+            Bench_Consume(lines.TotalHeight());
+        });
+        const double tickNs = ctx.Metrics().back().value;
+        if (staticLines == 1)
+        {
+            firstTickNs = tickNs;
+        }
+        lastTickNs = tickNs;
+
+        std::snprintf(metric, sizeof(metric), "naive_ns_lines_%d", staticLines);
+        ctx.Run(metric, [&]
+        {
+            const std::wstring expanded = NaiveExpand(big, InputsAt(++second));
+            Bench_Consume(expanded.size());
+        });
+    }
+    const double growth = firstTickNs > 0 ? lastTickNs / firstTickNs : 0.0;
+    ctx.Report("tick_growth_1000_vs_1", growth, "x");
+    violations += growth < 3.0 ? 0 : 1;
+
+    // 软件渲染：每秒只重画 {time} 所在的行，对比整屏重画底图与全部文字
+    {
+        const int w = 1920;
+        const int h = 1080;
+        const int dpi = 96;
+        std::vector<std::uint32_t> pixels((size_t)w * (size_t)h);
+        PixelBuffer buf{ pixels.data(), w, h, w, nullptr };
+        TextTemplate screen;
+        screen.Compile(MakeTemplate(20));
+        screen.Update(InputsAt(0));
+        const int charsPerLine = Soft_TextCharsPerLine(w, dpi);
+        TextLineLayout lines;
+        lines.Update(screen, 1, [&](std::wstring_view line) { return Soft_TextRows(line, charsPerLine); });
+        SoftOverlayLayout layout;
+        Soft_LayoutOverlayRows(w, h, dpi, lines.TotalHeight(), layout);
+        size_t timeLine = 0;
+        while (timeLine < screen.LineCount() && !(screen.IsDynamicLine(timeLine) && screen.Line(timeLine).find(L':') != std::wstring_view::npos))
+        {
+            timeLine++;
+        }
+        const std::uint32_t bgPixel = Soft_PixelFromColor(kTextBg);
+        std::int64_t second = 0;
+        ctx.Run("soft_line_repaint", [&]
+        {
+            screen.Update(InputsAt(++second));
+            const ScreenRect band = Soft_TextRowsRect(layout, lines.Top(timeLine), lines.Height(timeLine));
+            Soft_Fill(buf, band, bgPixel);
+            Soft_RenderTextLine(buf, layout, lines.Top(timeLine), screen.Line(timeLine));
+            Bench_Consume(pixels[(size_t)band.top * (size_t)w]);
+        });
+        ctx.Run("soft_full_repaint", [&]
+        {
+            const std::wstring expanded = NaiveExpand(screen.Source(), InputsAt(++second));
+            Soft_LayoutOverlay(w, h, dpi, expanded, layout);
+            Soft_RenderOverlayBase(buf, layout, kTextBg, expanded);
+            Bench_Consume(pixels[0]);
+        });
+    }
+
+    ctx.Check("violations", (double)violations);
+}
@@ -0,0 +1,58 @@
+#include "bench.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace.h"
+
+SSR_BENCH(TraceEvent)
+{
+    Trace_SetEnabled(false);
+    int i = 0;
+    ctx.Run("instant_disabled", [&] { Trace_Instant("bench", "instant", i++); });
+    ctx.Run("scope_disabled", [&] { TRACE_SCOPE("bench", "scope"); Bench_Consume(i); });
+
+    Trace_SetEnabled(true);
+    ctx.Run("instant_enabled", [&] { Trace_Instant("bench", "instant", i++); });
+    ctx.Run("scope_enabled", [&] { TRACE_SCOPE("bench", "scope"); Bench_Consume(i); });
+    ctx.Run("counter_enabled", [&] { Trace_Counter("bench", "alpha", i++ & 0xFF); });
+    Trace_SetEnabled(false);
+
+    std::string json;
+    Trace_WriteJson(json, true);
+}
+
+SSR_BENCH(TraceFlush)
+{
+    Trace_SetEnabled(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([]
+        {
+            Trace_SetThreadName("bench_worker");
+            for (int i = 0; i < 20000; i++)
+            {
+                TRACE_SCOPE("bench", "work");
+                Trace_Counter("bench", "value", i);
+            }
+        });
+    }
+    for (auto& th : threads)
+    {
+        th.join();
+    }
+    Trace_SetEnabled(false);
+
+    const size_t events = Trace_EventCount();
+    std::string json;
+    ctx.Run("write_json", [&]
+    {
+        Trace_WriteJson(json, false);
+        Bench_Consume(json);
+    });
+    ctx.Report("events", (double)events, "count");
+    ctx.Report("json_bytes", (double)json.size(), "bytes");
+    Trace_WriteJson(json, true);
+}
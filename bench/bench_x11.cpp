@@ -0,0 +1,212 @@
+#include "bench.h"
+
+#include <sys/resource.h>
+
+#include "overlay_engine.h"
+#include "x11_host.h"
+
+// Xlib 定义了 None、Bool、Status 等宏，放在项目头文件之后
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+// 需要 X 服务器（例如 xvfb-run -s "-screen 0 1920x1080x24" ./ssr_bench --filter X11）；
+// 没有 DISPLAY 时只报告 skipped
+namespace
+{
+    double CpuMs()
+    {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0 +
+            usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+    }
+
+    bool RunUntilState(X11EngineHost& host, const OverlayEngine& engine, OverlayState state, std::uint64_t timeoutMs)
+    {
+        const std::uint64_t deadline = host.Now() + timeoutMs;
+        while (engine.State() != state && host.Now() < deadline)
+        {
+            host.Run(host.Now() + 20);
+        }
+        return engine.State() == state;
+    }
+
+    unsigned long ReadOpacity(Display* display, unsigned long window)
+    {
+        Atom type = 0;
+        int format = 0;
+        unsigned long count = 0;
+        unsigned long after = 0;
+        unsigned char* data = nullptr;
+        unsigned long opacity = 0;
+        const Atom atom = XInternAtom(display, "_NET_WM_WINDOW_OPACITY", False);
+        if (XGetWindowProperty(display, window, atom, 0, 1, False, XA_CARDINAL, &type, &format, &count, &after, &data) == Success && data)
+        {
+            if (count == 1 && format == 32)
+            {
+                opacity = *reinterpret_cast<unsigned long*>(data);
+            }
+            XFree(data);
+        }
+        return opacity;
+    }
+}
+
+SSR_BENCH(X11FrameUpload)
+{
+    Display* display = XOpenDisplay(nullptr);
+    if (!display)
+    {
+        ctx.Report("skipped", 1, "bool");
+        return;
+    }
+    {
+        // 1080p 整帧：共享内存只需一次请求，XPutImage 要把 8MB 像素写进套接字
+        const MonitorInfo monitor{ ScreenRect{ 0, 0, 1920, 1080 }, 96 };
+        for (bool shm : { true, false })
+        {
+            X11SurfaceBackend backend(display, shm);
+            backend.SetPainter([](SurfaceHandle, const MonitorInfo&, PixelBuffer& buf)
+            {
+                Soft_Fill(buf, ScreenRect{ 0, 0, buf.width, buf.height }, Soft_PixelFromColor(MakeColor(0x20, 0x30, 0x40)));
+            });
+            const SurfaceHandle surface = backend.Create(monitor);
+            if (!surface)
+            {
+                ctx.Check(shm ? "create_failed_shm" : "create_failed_putimage", 1, 0, "bool");
+                continue;
+            }
+            backend.Show(surface);
+            backend.Invalidate(surface);
+            XSync(display, False);
+            if (shm)
+            {
+                ctx.Report("xshm_available", backend.UsesShm() ? 1 : 0, "bool");
+                ctx.Report("argb_visual", backend.UsesArgb() ? 1 : 0, "bool");
+            }
+            ctx.Run(shm ? "upload_shm" : "upload_putimage", [&]
+            {
+                backend.Upload(surface);
+                XSync(display, False);
+            });
+            ctx.Run(shm ? "paint_upload_shm" : "paint_upload_putimage", [&]
+            {
+                backend.Invalidate(surface);
+                XSync(display, False);
+            });
+            backend.Destroy(surface);
+        }
+    }
+    XCloseDisplay(display);
+}
+
+SSR_BENCH(X11IdleCpu)
+{
+    Display* display = XOpenDisplay(nullptr);
+    if (!display)
+    {
+        ctx.Report("skipped", 1, "bool");
+        return;
+    }
+    {
+        X11EngineHost host(display);
+        OverlayEngine engine(host);
+        host.SetEngine(&engine);
+        AppConfig cfg;
+        cfg.intervalMinutes = 60;
+        cfg.fadeSeconds = 1;
+        engine.Start(host.Now(), cfg);
+        host.ReconcileSurfaces();
+
+        // 两次提醒之间：没有任何计时器以外的唤醒
+        const std::uint64_t windowMs = 2000;
+        std::uint64_t wakeups = host.Stats().wakeups;
+        double cpu = CpuMs();
+        host.Run(host.Now() + windowMs);
+        ctx.Report("idle_cpu", (CpuMs() - cpu) * 1000.0 / windowMs, "ms/s");
+        ctx.Report("idle_wakeups", (double)(host.Stats().wakeups - wakeups) * 1000.0 / windowMs, "1/s");
+
+        // 等待键鼠活动：XInput2 时只有每秒一次的时间刷新，否则再加 100ms 一次的轮询
+        engine.OnTriggerNow(host.Now());
+        RunUntilState(host, engine, OverlayState::WaitingInput, 5000);
+        wakeups = host.Stats().wakeups;
+        cpu = CpuMs();
+        host.Run(host.Now() + windowMs);
+        ctx.Report("waiting_cpu", (CpuMs() - cpu) * 1000.0 / windowMs, "ms/s");
+        ctx.Report("waiting_wakeups", (double)(host.Stats().wakeups - wakeups) * 1000.0 / windowMs, "1/s");
+        ctx.Report("xinput2", host.HasXInput2() ? 1 : 0, "bool");
+
+        host.InjectActivity();
+        RunUntilState(host, engine, OverlayState::Hidden, 5000);
+        engine.OnExit(host.Now());
+    }
+    XCloseDisplay(display);
+}
+
+SSR_BENCH(X11Overlay)
+{
+    // 端到端：立即提醒 → 每个显示器一个可见遮罩、透明度到达目标、像素是背景色 → 活动 → 全部隐藏
+    Display* display = XOpenDisplay(nullptr);
+    if (!display)
+    {
+        ctx.Report("skipped", 1, "bool");
+        return;
+    }
+    int violations = 0;
+    {
+        X11EngineHost host(display);
+        OverlayEngine engine(host);
+        host.SetEngine(&engine);
+        AppConfig cfg;
+        cfg.fadeSeconds = 1;
+        cfg.bgColor = MakeColor(0x10, 0x80, 0x30);
+        engine.Start(host.Now(), cfg);
+        host.ReconcileSurfaces();
+
+        std::vector<MonitorInfo> monitors;
+        host.Backend().EnumMonitors(monitors);
+        const std::uint64_t shown = host.Now();
+        engine.OnTriggerNow(shown);
+        violations += RunUntilState(host, engine, OverlayState::WaitingInput, 5000) ? 0 : 1;
+        ctx.Report("show_to_opaque_ms", (double)(host.Now() - shown), "ms");
+        violations += host.Pool().Size() == monitors.size() ? 0 : 1;
+
+        const unsigned long target = (unsigned long)engine.Alpha() * 0x01010101ul;
+        const std::uint32_t expected = Soft_PixelFromColor(cfg.bgColor) & 0xFFFFFFu;
+        host.Pool().ForEachSurface([&](SurfaceHandle surface, const MonitorInfo& monitor)
+        {
+            const Window window = host.Backend().WindowOf(surface);
+            XWindowAttributes attrs{};
+            XGetWindowAttributes(display, window, &attrs);
+            violations += attrs.map_state == IsViewable && attrs.override_redirect ? 0 : 1;
+            violations += ReadOpacity(display, window) == target ? 0 : 1;
+            // 左上角在版面边距内，只有背景色
+            if (XImage* image = XGetImage(display, window, 2, 2, 1, 1, AllPlanes, ZPixmap))
+            {
+                violations += (XGetPixel(image, 0, 0) & 0xFFFFFFu) == expected ? 0 : 1;
+                XDestroyImage(image);
+            }
+            else
+            {
+                violations++;
+            }
+            (void)monitor;
+        });
+
+        host.InjectActivity();
+        violations += RunUntilState(host, engine, OverlayState::Hidden, 5000) ? 0 : 1;
+        host.Pool().ForEachSurface([&](SurfaceHandle surface, const MonitorInfo&)
+        {
+            XWindowAttributes attrs{};
+            XGetWindowAttributes(display, host.Backend().WindowOf(surface), &attrs);
+            violations += attrs.map_state == IsUnmapped ? 0 : 1;
+        });
+        ctx.Report("monitors", (double)monitors.size(), "count");
+        ctx.Report("xshm", host.Backend().UsesShm() ? 1 : 0, "bool");
+        ctx.Report("upload_bytes", (double)host.Backend().Stats().uploadBytes, "bytes");
+        engine.OnExit(host.Now());
+    }
+    ctx.Check("violations", (double)violations);
+    XCloseDisplay(display);
+}
@@ -0,0 +1,188 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "bench_report.h"
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <stdlib.h>
+#endif
+
+std::vector<BenchCase>& Bench_Registry()
+{
+    static std::vector<BenchCase> registry;
+    return registry;
+}
+
+static const void* volatile g_benchSink = nullptr;
+
+void Bench_Consume(const void* p)
+{
+    g_benchSink = p;
+}
+
+std::filesystem::path Bench_TempDir(const char* tag)
+{
+    std::error_code ec;
+    const std::filesystem::path base = std::filesystem::temp_directory_path(ec);
+    if (ec)
+    {
+        return {};
+    }
+#ifdef _WIN32
+    // Windows 的临时目录本来就只属于当前用户
+    const std::filesystem::path dir = base / ("ssr-bench-" + std::string(tag) + "-" + std::to_string((long)_getpid()));
+    std::filesystem::remove_all(dir, ec);
+    return std::filesystem::create_directory(dir, ec) ? dir : std::filesystem::path();
+#else
+    std::string templ = (base / ("ssr-bench-" + std::string(tag) + "-XXXXXX")).string();
+    return mkdtemp(templ.data()) ? std::filesystem::path(templ) : std::filesystem::path();
+#endif
+}
+
+static void PrintUsage()
+{
+    std::fprintf(stderr,
+        "usage: ssr_bench [--filter <substr>] [--min-time <seconds>] [--list]\n"
+        "                 [--json <file>] [--baseline <file>] [--threshold <percent>]\n");
+}
+
+static bool ReadWholeFile(const char* path, std::string& out)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    out = buffer.str();
+    return true;
+}
+
+// 打印每个耗时与吞吐指标相对基线的变化；返回回退的个数
+static int CompareWithBaseline(const std::vector<BenchResult>& baseline, const std::vector<BenchResult>& results, double thresholdPercent)
+{
+    int regressions = 0;
+    std::printf("\n%-40s %-32s %14s %14s %9s\n", "bench", "metric", "baseline", "current", "change");
+    for (const BenchComparison& c : BenchReport_Compare(baseline, results, thresholdPercent))
+    {
+        std::printf("%-40s %-32s %14.2f %14.2f %+8.1f%%%s\n", c.current->bench.c_str(), c.current->metric.c_str(),
+            c.baseline->value, c.current->value, c.changePercent, c.regressed ? "  REGRESSED" : "");
+        regressions += c.regressed ? 1 : 0;
+    }
+    std::printf("%d regression(s) over %.1f%%\n", regressions, thresholdPercent);
+    return regressions;
+}
+
+// 打印与期望值不符的核对类指标；返回个数
+static int ReportFailedChecks(const std::vector<BenchResult>& results)
+{
+    const std::vector<const BenchResult*> failed = BenchReport_FailedChecks(results);
+    for (const BenchResult* r : failed)
+    {
+        std::fprintf(stderr, "ssr_bench: check failed: %s %s = %.2f %s (expected %.2f)\n", r->bench.c_str(), r->metric.c_str(), r->value, r->unit.c_str(), r->expected);
+    }
+    return (int)failed.size();
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = nullptr;
+    double minSeconds = 0.2;
+    bool listOnly = false;
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+    double thresholdPercent = 10;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+        {
+            minSeconds = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--list") == 0)
+        {
+            listOnly = true;
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+        {
+            thresholdPercent = std::atof(argv[++i]);
+        }
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    // 先读基线，文件有问题时不必等全部跑完才发现
+    std::vector<BenchResult> baseline;
+    if (baselinePath)
+    {
+        std::string text;
+        std::string error;
+        if (!ReadWholeFile(baselinePath, text) || !BenchReport_ParseJson(text, baseline, error))
+        {
+            std::fprintf(stderr, "ssr_bench: cannot read baseline %s%s%s\n", baselinePath, error.empty() ? "" : ": ", error.c_str());
+            return 2;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    for (const auto& bench : Bench_Registry())
+    {
+        if (filter && !std::strstr(bench.name, filter))
+        {
+            continue;
+        }
+        if (listOnly)
+        {
+            std::printf("%s\n", bench.name);
+            continue;
+        }
+
+        BenchContext ctx(minSeconds);
+        bench.fn(ctx);
+        for (const auto& m : ctx.Metrics())
+        {
+            std::printf("%-40s %-32s %14.2f %s\n", bench.name, m.name.c_str(), m.value, m.unit.c_str());
+            results.push_back(BenchResult{ bench.name, m.name, m.value, m.unit, m.check, m.expected });
+        }
+        std::fflush(stdout);
+    }
+
+    if (jsonPath)
+    {
+        std::string json;
+        BenchReport_WriteJson(results, json);
+        std::ofstream out(jsonPath, std::ios::binary | std::ios::trunc);
+        out.write(json.data(), (std::streamsize)json.size());
+        if (!out)
+        {
+            std::fprintf(stderr, "ssr_bench: cannot write %s\n", jsonPath);
+            return 2;
+        }
+    }
+    const int failedChecks = ReportFailedChecks(results);
+    const int regressions = baselinePath ? CompareWithBaseline(baseline, results, thresholdPercent) : 0;
+    return failedChecks > 0 || regressions > 0 ? 1 : 0;
+}
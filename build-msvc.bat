@@ -19,12 +19,14 @@ if not exist "%OUT%" mkdir "%OUT%"
 rc /nologo /I "src" /fo "%OUT%\\resource.res" "resource.rc"
 if errorlevel 1 exit /b 1
 
+set SOURCES="src\\main.cpp" "src\\config.cpp" "src\\utf8.cpp" "src\\trace.cpp" "src\\break_log.cpp" "src\\mapped_file.cpp" "src\\overlay_pool.cpp" "src\\surface_headless.cpp" "src\\overlay_frame.cpp" "src\\soft_render.cpp" "src\\overlay_fsm.cpp" "src\\overlay_engine.cpp" "src\\engine_log.cpp" "src\\engine_sim.cpp" "src\\control_protocol.cpp" "src\\control_server.cpp" "src\\single_instance.cpp" "src\\settings_preview.cpp" "src\\scheduler_state.cpp" "src\\fullscreen_policy.cpp" "src\\presence.cpp" "src\\asset_pack.cpp" "src\\process_footprint.cpp" "src\\surface_tracking.cpp" "src\\config_layers.cpp" "src\\headless.cpp" "src\\startup_profile.cpp" "src\\show_arena.cpp" "src\\overlay_region.cpp" "src\\screen_region.cpp" "src\\inflate.cpp" "src\\anim_decode.cpp" "src\\anim_player.cpp" "src\\text_template.cpp"
+
 cl /nologo /std:c++17 /O2 /MT ^
   /DUNICODE /D_UNICODE /DNOMINMAX /DWIN32_LEAN_AND_MEAN ^
   /W4 /EHsc /utf-8 ^
-  "src\\main.cpp" "%OUT%\\resource.res" ^
+  /I "src" /Fo"%OUT%\\" %SOURCES% "%OUT%\\resource.res" ^
   /link /SUBSYSTEM:WINDOWS /OUT:"%OUT%\\ScreenSaverReminderCPP.exe" ^
-  user32.lib gdi32.lib shell32.lib comctl32.lib comdlg32.lib ole32.lib advapi32.lib
+  user32.lib gdi32.lib shell32.lib comctl32.lib comdlg32.lib ole32.lib advapi32.lib shcore.lib wtsapi32.lib
 
 if errorlevel 1 exit /b 1
 
@@ -0,0 +1,929 @@
+#include "anim_decode.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "inflate.h"
+
+namespace
+{
+    constexpr std::uint8_t kPngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    constexpr int LZW_MAX_CODES = 4096;
+
+    constexpr std::uint32_t Tag(char a, char b, char c, char d)
+    {
+        return ((std::uint32_t)(std::uint8_t)a << 24) | ((std::uint32_t)(std::uint8_t)b << 16) | ((std::uint32_t)(std::uint8_t)c << 8) | (std::uint32_t)(std::uint8_t)d;
+    }
+
+    constexpr std::uint32_t TAG_IHDR = Tag('I', 'H', 'D', 'R');
+    constexpr std::uint32_t TAG_PLTE = Tag('P', 'L', 'T', 'E');
+    constexpr std::uint32_t TAG_TRNS = Tag('t', 'R', 'N', 'S');
+    constexpr std::uint32_t TAG_ACTL = Tag('a', 'c', 'T', 'L');
+    constexpr std::uint32_t TAG_FCTL = Tag('f', 'c', 'T', 'L');
+    constexpr std::uint32_t TAG_IDAT = Tag('I', 'D', 'A', 'T');
+    constexpr std::uint32_t TAG_FDAT = Tag('f', 'd', 'A', 'T');
+    constexpr std::uint32_t TAG_IEND = Tag('I', 'E', 'N', 'D');
+
+    std::uint16_t Le16(const std::uint8_t* p)
+    {
+        return (std::uint16_t)(p[0] | (p[1] << 8));
+    }
+
+    std::uint16_t Be16(const std::uint8_t* p)
+    {
+        return (std::uint16_t)((p[0] << 8) | p[1]);
+    }
+
+    std::uint32_t Be32(const std::uint8_t* p)
+    {
+        return ((std::uint32_t)p[0] << 24) | ((std::uint32_t)p[1] << 16) | ((std::uint32_t)p[2] << 8) | (std::uint32_t)p[3];
+    }
+
+    void SetError(std::wstring* error, const wchar_t* message)
+    {
+        if (error)
+        {
+            *error = message;
+        }
+    }
+
+    bool ValidSize(std::uint32_t width, std::uint32_t height)
+    {
+        return width != 0 && height != 0 && width <= (std::uint32_t)ANIM_MAX_DIMENSION && height <= (std::uint32_t)ANIM_MAX_DIMENSION;
+    }
+
+    // 跳过 GIF 的数据子块直到长度为 0 的结束块；数据截断时返回 false
+    bool SkipSubBlocks(const std::uint8_t* data, size_t size, size_t& pos)
+    {
+        while (pos < size)
+        {
+            const size_t n = data[pos++];
+            if (n == 0)
+            {
+                return true;
+            }
+            if (n > size - pos)
+            {
+                break;
+            }
+            pos += n;
+        }
+        pos = size;
+        return false;
+    }
+
+    // 逐字节读取连续的 GIF 数据子块；遇到结束块或数据截断后 NextByte 返回 -1
+    struct SubBlockReader
+    {
+        const std::uint8_t* data;
+        size_t size;
+        size_t pos;
+        size_t blockEnd;
+        bool terminated = false;
+
+        int NextByte()
+        {
+            if (pos == blockEnd)
+            {
+                if (terminated || pos >= size)
+                {
+                    return -1;
+                }
+                const size_t n = data[pos++];
+                if (n == 0 || n > size - pos)
+                {
+                    terminated = true;
+                    pos = n == 0 ? pos : size;
+                    blockEnd = pos;
+                    return -1;
+                }
+                blockEnd = pos + n;
+            }
+            return data[pos++];
+        }
+    };
+
+    // 隔行 GIF 第 r 个解出的行在图像中的行号
+    int InterlacedRow(int r, int height)
+    {
+        const int pass1 = (height + 7) / 8;
+        if (r < pass1)
+        {
+            return r * 8;
+        }
+        r -= pass1;
+        const int pass2 = (height + 3) / 8;
+        if (r < pass2)
+        {
+            return 4 + r * 8;
+        }
+        r -= pass2;
+        const int pass3 = (height + 1) / 4;
+        if (r < pass3)
+        {
+            return 2 + r * 4;
+        }
+        return 1 + (r - pass3) * 2;
+    }
+
+    int PaethPredictor(int a, int b, int c)
+    {
+        const int p = a + b - c;
+        const int pa = p > a ? p - a : a - p;
+        const int pb = p > b ? p - b : b - p;
+        const int pc = p > c ? p - c : c - p;
+        if (pa <= pb && pa <= pc)
+        {
+            return a;
+        }
+        return pb <= pc ? b : c;
+    }
+
+    bool Unfilter(std::uint8_t* row, const std::uint8_t* prev, size_t rowBytes, size_t bpp)
+    {
+        const std::uint8_t type = row[0];
+        std::uint8_t* cur = row + 1;
+        switch (type)
+        {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = bpp; i < rowBytes; i++)
+            {
+                cur[i] = (std::uint8_t)(cur[i] + cur[i - bpp]);
+            }
+            break;
+        case 2:
+            if (prev)
+            {
+                for (size_t i = 0; i < rowBytes; i++)
+                {
+                    cur[i] = (std::uint8_t)(cur[i] + prev[i]);
+                }
+            }
+            break;
+        case 3:
+            for (size_t i = 0; i < rowBytes; i++)
+            {
+                const int left = i >= bpp ? cur[i - bpp] : 0;
+                const int up = prev ? prev[i] : 0;
+                cur[i] = (std::uint8_t)(cur[i] + ((left + up) >> 1));
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < rowBytes; i++)
+            {
+                const int left = i >= bpp ? cur[i - bpp] : 0;
+                const int up = prev ? prev[i] : 0;
+                const int upLeft = prev && i >= bpp ? prev[i - bpp] : 0;
+                cur[i] = (std::uint8_t)(cur[i] + PaethPredictor(left, up, upLeft));
+            }
+            break;
+        default:
+            return false;
+        }
+        return true;
+    }
+
+    // 未预乘的 src 叠加到 dst 上
+    std::uint32_t BlendOver(std::uint32_t src, std::uint32_t dst)
+    {
+        const std::uint32_t sa = src >> 24;
+        if (sa == 255)
+        {
+            return src;
+        }
+        if (sa == 0)
+        {
+            return dst;
+        }
+        const std::uint32_t da = dst >> 24;
+        const std::uint32_t dw = da * (255 - sa) / 255;
+        const std::uint32_t oa = sa + dw;
+        auto channel = [&](int shift)
+        {
+            const std::uint32_t s = (src >> shift) & 0xFFu;
+            const std::uint32_t d = (dst >> shift) & 0xFFu;
+            return ((s * sa + d * dw) / oa) << shift;
+        };
+        return (oa << 24) | channel(16) | channel(8) | channel(0);
+    }
+}
+
+bool AnimDecoder::Open(const std::uint8_t* data, size_t size, std::wstring* error)
+{
+    Close();
+    m_data = data;
+    m_size = size;
+    bool ok = false;
+    if (data && size >= 6 && (std::memcmp(data, "GIF87a", 6) == 0 || std::memcmp(data, "GIF89a", 6) == 0))
+    {
+        ok = OpenGif(error);
+    }
+    else if (data && size >= 8 && std::memcmp(data, kPngSignature, 8) == 0)
+    {
+        ok = OpenPng(error);
+    }
+    else
+    {
+        SetError(error, L"动画文件不是 GIF 或 PNG/APNG 格式。");
+    }
+    if (!ok)
+    {
+        Close();
+        return false;
+    }
+    m_canvas.assign((size_t)m_info.width * (size_t)m_info.height, 0);
+    Rewind();
+    return true;
+}
+
+void AnimDecoder::Close()
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_pos = 0;
+    m_firstFrame = 0;
+    m_info = AnimInfo{};
+    // 两次提醒之间不保留画布与解码缓冲
+    std::vector<std::uint32_t>().swap(m_canvas);
+    std::vector<std::uint32_t>().swap(m_saved);
+    std::vector<std::uint8_t>().swap(m_indices);
+    std::vector<std::uint16_t>().swap(m_prefix);
+    std::vector<std::uint8_t>().swap(m_suffix);
+    std::vector<std::uint16_t>().swap(m_length);
+    std::vector<std::uint8_t>().swap(m_zbuf);
+    std::vector<std::uint8_t>().swap(m_raw);
+    m_globalPaletteSize = 0;
+    m_hasKey = false;
+    m_animated = false;
+}
+
+void AnimDecoder::Rewind()
+{
+    m_pos = m_firstFrame;
+    m_frameIndex = 0;
+    std::fill(m_canvas.begin(), m_canvas.end(), 0u);
+    m_lastDispose = Dispose::None;
+    m_lastRect = Rect{};
+}
+
+bool AnimDecoder::Next(int& delayMs)
+{
+    if (!IsOpen())
+    {
+        return false;
+    }
+    const bool ok = m_info.format == AnimFormat::Gif ? NextGif(delayMs) : NextPng(delayMs);
+    if (ok)
+    {
+        m_frameIndex++;
+    }
+    return ok;
+}
+
+void AnimDecoder::BeginFrame(const Rect& rect, Dispose dispose)
+{
+    const int width = m_info.width;
+    auto clip = [&](const Rect& r, int& x0, int& y0, int& x1, int& y1)
+    {
+        x0 = std::max(0, r.x);
+        y0 = std::max(0, r.y);
+        x1 = std::min(width, r.x + r.w);
+        y1 = std::min(m_info.height, r.y + r.h);
+        return x0 < x1 && y0 < y1;
+    };
+
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+    if (m_lastDispose != Dispose::None && clip(m_lastRect, x0, y0, x1, y1))
+    {
+        for (int y = y0; y < y1; y++)
+        {
+            std::uint32_t* row = m_canvas.data() + (size_t)y * (size_t)width;
+            if (m_lastDispose == Dispose::Background)
+            {
+                std::fill(row + x0, row + x1, 0u);
+            }
+            else
+            {
+                const std::uint32_t* saved = m_saved.data() + (size_t)y * (size_t)width;
+                std::copy(saved + x0, saved + x1, row + x0);
+            }
+        }
+    }
+
+    // 第一帧没有“之前”的画面，Previous 按清为透明处理
+    if (dispose == Dispose::Previous && m_frameIndex == 0)
+    {
+        dispose = Dispose::Background;
+    }
+    if (dispose == Dispose::Previous && clip(rect, x0, y0, x1, y1))
+    {
+        m_saved.resize(m_canvas.size());
+        for (int y = y0; y < y1; y++)
+        {
+            const std::uint32_t* row = m_canvas.data() + (size_t)y * (size_t)width;
+            std::copy(row + x0, row + x1, m_saved.data() + (size_t)y * (size_t)width + x0);
+        }
+    }
+    m_lastRect = rect;
+    m_lastDispose = dispose;
+}
+
+bool AnimDecoder::OpenGif(std::wstring* error)
+{
+    if (m_size < 13)
+    {
+        SetError(error, L"GIF 文件头不完整。");
+        return false;
+    }
+    const int width = Le16(m_data + 6);
+    const int height = Le16(m_data + 8);
+    if (!ValidSize((std::uint32_t)width, (std::uint32_t)height))
+    {
+        SetError(error, L"动画的宽高为 0 或超过 4096 像素。");
+        return false;
+    }
+    const std::uint8_t packed = m_data[10];
+    size_t pos = 13;
+    if (packed & 0x80)
+    {
+        m_globalPaletteSize = 2 << (packed & 7);
+        if ((size_t)m_globalPaletteSize * 3 > m_size - pos)
+        {
+            SetError(error, L"GIF 文件头不完整。");
+            return false;
+        }
+        std::memcpy(m_globalPalette, m_data + pos, (size_t)m_globalPaletteSize * 3);
+        pos += (size_t)m_globalPaletteSize * 3;
+    }
+    m_firstFrame = pos;
+
+    // 循环次数在第一幅图像之前的 NETSCAPE2.0 扩展里；没有时只播放一遍
+    int loops = 1;
+    while (pos + 2 <= m_size && m_data[pos] == 0x21)
+    {
+        const std::uint8_t label = m_data[pos + 1];
+        pos += 2;
+        if (label == 0xFF && pos + 16 <= m_size && m_data[pos] == 11 && std::memcmp(m_data + pos + 1, "NETSCAPE2.0", 11) == 0 &&
+            m_data[pos + 12] == 3 && m_data[pos + 13] == 1)
+        {
+            // 记录的是重复次数：0 为无限，n 为共播放 n + 1 遍
+            const int repeats = Le16(m_data + pos + 14);
+            loops = repeats == 0 ? 0 : repeats + 1;
+        }
+        if (!SkipSubBlocks(m_data, m_size, pos))
+        {
+            break;
+        }
+    }
+
+    m_prefix.assign(LZW_MAX_CODES, 0);
+    m_suffix.assign(LZW_MAX_CODES, 0);
+    m_length.assign(LZW_MAX_CODES, 0);
+    m_info = AnimInfo{ AnimFormat::Gif, width, height, loops };
+    return true;
+}
+
+bool AnimDecoder::NextGif(int& delayMs)
+{
+    Dispose dispose = Dispose::None;
+    int transparent = -1;
+    int delayCs = 0;
+    while (m_pos < m_size)
+    {
+        const std::uint8_t introducer = m_data[m_pos];
+        if (introducer == 0x21)
+        {
+            if (m_pos + 2 > m_size)
+            {
+                break;
+            }
+            const std::uint8_t label = m_data[m_pos + 1];
+            const size_t body = m_pos + 2;
+            // 图形控制扩展：处置方式、延时与透明色，作用于紧随其后的图像
+            if (label == 0xF9 && body + 5 <= m_size && m_data[body] == 4)
+            {
+                const std::uint8_t packed = m_data[body + 1];
+                const int method = (packed >> 2) & 7;
+                dispose = method == 2 ? Dispose::Background : (method == 3 ? Dispose::Previous : Dispose::None);
+                delayCs = Le16(m_data + body + 2);
+                transparent = (packed & 1) ? m_data[body + 4] : -1;
+            }
+            m_pos = body;
+            if (!SkipSubBlocks(m_data, m_size, m_pos))
+            {
+                return false;
+            }
+            continue;
+        }
+        if (introducer != 0x2C || m_pos + 10 > m_size)
+        {
+            // 0x3B 为文件结尾，其余为无法识别的数据
+            break;
+        }
+
+        const std::uint8_t* d = m_data + m_pos;
+        const Rect rect{ Le16(d + 1), Le16(d + 3), Le16(d + 5), Le16(d + 7) };
+        const std::uint8_t packed = d[9];
+        m_pos += 10;
+        // 图像必须落在逻辑屏幕之内（与 APNG 的 fcTL 相同），索引缓冲因此不超过画布的大小；
+        // 否则文件头里的 16 位宽高可以让一帧申请 4GB
+        if (rect.w <= 0 || rect.h <= 0 || rect.x > m_info.width - rect.w || rect.y > m_info.height - rect.h)
+        {
+            break;
+        }
+        const std::uint8_t* palette = m_globalPalette;
+        int paletteSize = m_globalPaletteSize;
+        if (packed & 0x80)
+        {
+            paletteSize = 2 << (packed & 7);
+            if ((size_t)paletteSize * 3 > m_size - m_pos)
+            {
+                break;
+            }
+            palette = m_data + m_pos;
+            m_pos += (size_t)paletteSize * 3;
+        }
+
+        BeginFrame(rect, dispose);
+        if (!DecodeGifImage(palette, paletteSize, transparent, (packed & 0x40) != 0, rect))
+        {
+            break;
+        }
+        delayMs = delayCs <= 1 ? ANIM_DEFAULT_DELAY_MS : delayCs * 10;
+        return true;
+    }
+    m_pos = m_size;
+    return false;
+}
+
+bool AnimDecoder::DecodeGifImage(const std::uint8_t* palette, int paletteSize, int transparent, bool interlaced, const Rect& rect)
+{
+    if (m_pos >= m_size)
+    {
+        return false;
+    }
+    const int minCodeSize = m_data[m_pos++];
+    if (minCodeSize < 2 || minCodeSize > 8)
+    {
+        return false;
+    }
+
+    const size_t pixels = (size_t)rect.w * (size_t)rect.h;
+    if (m_indices.size() < pixels)
+    {
+        m_indices.resize(pixels);
+    }
+    std::uint8_t* indices = m_indices.data();
+    std::uint16_t* prefix = m_prefix.data();
+    std::uint8_t* suffix = m_suffix.data();
+    std::uint16_t* length = m_length.data();
+
+    const int clear = 1 << minCodeSize;
+    const int endOfInfo = clear + 1;
+    for (int i = 0; i < clear; i++)
+    {
+        prefix[i] = 0;
+        suffix[i] = (std::uint8_t)i;
+        length[i] = 1;
+    }
+
+    SubBlockReader reader{ m_data, m_size, m_pos, m_pos };
+    int codeSize = minCodeSize + 1;
+    int next = clear + 2;
+    int prev = -1;
+    std::uint32_t bitBuf = 0;
+    int bitCount = 0;
+    size_t out = 0;
+
+    // 把 code 对应的串写到 out 处（从尾到头沿前缀回溯），返回串的第一个字节
+    auto emit = [&](int code)
+    {
+        const size_t len = length[code];
+        size_t pos = out + len - 1;
+        int c = code;
+        for (;;)
+        {
+            if (pos < pixels)
+            {
+                indices[pos] = suffix[c];
+            }
+            if (length[c] == 1)
+            {
+                break;
+            }
+            c = prefix[c];
+            pos--;
+        }
+        out += len;
+        return suffix[c];
+    };
+
+    while (out < pixels)
+    {
+        while (bitCount < codeSize)
+        {
+            const int byte = reader.NextByte();
+            if (byte < 0)
+            {
+                break;
+            }
+            bitBuf |= (std::uint32_t)byte << bitCount;
+            bitCount += 8;
+        }
+        if (bitCount < codeSize)
+        {
+            break;
+        }
+        const int code = (int)(bitBuf & ((1u << codeSize) - 1));
+        bitBuf >>= codeSize;
+        bitCount -= codeSize;
+
+        if (code == clear)
+        {
+            codeSize = minCodeSize + 1;
+            next = clear + 2;
+            prev = -1;
+            continue;
+        }
+        if (code == endOfInfo)
+        {
+            break;
+        }
+        if (prev < 0)
+        {
+            if (code >= clear)
+            {
+                break;
+            }
+            indices[out++] = (std::uint8_t)code;
+            prev = code;
+            continue;
+        }
+
+        std::uint8_t first = 0;
+        if (code < next)
+        {
+            first = emit(code);
+        }
+        else if (code == next)
+        {
+            // KwKwK：前一个串再接上它自己的第一个字节
+            first = emit(prev);
+            if (out < pixels)
+            {
+                indices[out] = first;
+            }
+            out++;
+        }
+        else
+        {
+            break;
+        }
+        if (next < LZW_MAX_CODES)
+        {
+            prefix[next] = (std::uint16_t)prev;
+            suffix[next] = first;
+            length[next] = (std::uint16_t)(length[prev] + 1);
+            next++;
+            if (next == (1 << codeSize) && codeSize < 12)
+            {
+                codeSize++;
+            }
+        }
+        prev = code;
+    }
+    const size_t decoded = std::min(out, pixels);
+
+    // 跳过这幅图像剩余的数据子块
+    m_pos = reader.blockEnd;
+    if (!reader.terminated && !SkipSubBlocks(m_data, m_size, m_pos))
+    {
+        m_pos = m_size;
+    }
+    else if (reader.terminated)
+    {
+        m_pos = reader.pos;
+    }
+
+    std::uint32_t colors[256];
+    for (int i = 0; i < 256; i++)
+    {
+        // 超出调色板或透明色的像素保持画布原样
+        colors[i] = i < paletteSize && i != transparent
+            ? 0xFF000000u | ((std::uint32_t)palette[i * 3] << 16) | ((std::uint32_t)palette[i * 3 + 1] << 8) | palette[i * 3 + 2]
+            : 0u;
+    }
+
+    const int width = m_info.width;
+    const int x0 = std::max(0, rect.x);
+    const int x1 = std::min(width, rect.x + rect.w);
+    for (int r = 0; r < rect.h && (size_t)r * (size_t)rect.w < decoded; r++)
+    {
+        const int y = rect.y + (interlaced ? InterlacedRow(r, rect.h) : r);
+        if (y < 0 || y >= m_info.height)
+        {
+            continue;
+        }
+        const std::uint8_t* src = indices + (size_t)r * (size_t)rect.w;
+        const size_t rowEnd = std::min<size_t>(rect.w, decoded - (size_t)r * (size_t)rect.w);
+        std::uint32_t* dst = m_canvas.data() + (size_t)y * (size_t)width;
+        for (int x = x0; x < x1 && (size_t)(x - rect.x) < rowEnd; x++)
+        {
+            const std::uint32_t c = colors[src[x - rect.x]];
+            if (c != 0)
+            {
+                dst[x] = c;
+            }
+        }
+    }
+    return true;
+}
+
+bool AnimDecoder::OpenPng(std::wstring* error)
+{
+    size_t pos = 8;
+    if (m_size < pos + 8 + 13 + 4 || Be32(m_data + pos) != 13 || Be32(m_data + pos + 4) != TAG_IHDR)
+    {
+        SetError(error, L"PNG 文件头不完整。");
+        return false;
+    }
+    const std::uint8_t* ihdr = m_data + pos + 8;
+    const std::uint32_t width = Be32(ihdr);
+    const std::uint32_t height = Be32(ihdr + 4);
+    m_bitDepth = ihdr[8];
+    m_colorType = ihdr[9];
+    if (!ValidSize(width, height))
+    {
+        SetError(error, L"动画的宽高为 0 或超过 4096 像素。");
+        return false;
+    }
+    const int depth = m_bitDepth;
+    bool validDepth = false;
+    switch (m_colorType)
+    {
+    case 0: validDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16; break;
+    case 3: validDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8; break;
+    case 2:
+    case 4:
+    case 6: validDepth = depth == 8 || depth == 16; break;
+    default: break;
+    }
+    if (!validDepth || ihdr[10] != 0 || ihdr[11] != 0)
+    {
+        SetError(error, L"PNG 的颜色类型或位深不正确。");
+        return false;
+    }
+    if (ihdr[12] != 0)
+    {
+        SetError(error, L"不支持隔行扫描的 PNG，请另存为非隔行。");
+        return false;
+    }
+    pos += 8 + 13 + 4;
+
+    // 没有调色板的条目按不透明黑色处理
+    std::fill(std::begin(m_palette), std::end(m_palette), 0xFF000000u);
+    bool hasPalette = false;
+    int loops = 1;
+    while (pos + 12 <= m_size)
+    {
+        const std::uint32_t len = Be32(m_data + pos);
+        const std::uint32_t type = Be32(m_data + pos + 4);
+        if (len > m_size - pos - 12)
+        {
+            break;
+        }
+        const std::uint8_t* d = m_data + pos + 8;
+        if (type == TAG_IDAT || type == TAG_FCTL || type == TAG_IEND)
+        {
+            break;
+        }
+        if (type == TAG_PLTE && len % 3 == 0 && len <= 256 * 3)
+        {
+            for (std::uint32_t i = 0; i < len / 3; i++)
+            {
+                m_palette[i] = 0xFF000000u | ((std::uint32_t)d[i * 3] << 16) | ((std::uint32_t)d[i * 3 + 1] << 8) | d[i * 3 + 2];
+            }
+            hasPalette = true;
+        }
+        else if (type == TAG_TRNS)
+        {
+            if (m_colorType == 3)
+            {
+                for (std::uint32_t i = 0; i < len && i < 256; i++)
+                {
+                    m_palette[i] = (m_palette[i] & 0x00FFFFFFu) | ((std::uint32_t)d[i] << 24);
+                }
+            }
+            else if (m_colorType == 0 && len >= 2)
+            {
+                m_hasKey = true;
+                m_key[0] = Be16(d);
+            }
+            else if (m_colorType == 2 && len >= 6)
+            {
+                m_hasKey = true;
+                m_key[0] = Be16(d);
+                m_key[1] = Be16(d + 2);
+                m_key[2] = Be16(d + 4);
+            }
+        }
+        else if (type == TAG_ACTL && len >= 8)
+        {
+            m_animated = Be32(d) != 0;
+            loops = (int)std::min<std::uint32_t>(Be32(d + 4), 0x7FFFFFFF);
+        }
+        pos += (size_t)len + 12;
+    }
+    if (m_colorType == 3 && !hasPalette)
+    {
+        SetError(error, L"PNG 缺少调色板。");
+        return false;
+    }
+    m_firstFrame = pos;
+    m_info = AnimInfo{ AnimFormat::Apng, (int)width, (int)height, m_animated ? loops : 1 };
+    return true;
+}
+
+bool AnimDecoder::NextPng(int& delayMs)
+{
+    bool haveControl = false;
+    Rect rect{ 0, 0, m_info.width, m_info.height };
+    Dispose dispose = Dispose::None;
+    bool blendOver = false;
+    int delay = ANIM_DEFAULT_DELAY_MS;
+
+    while (m_pos + 12 <= m_size)
+    {
+        const std::uint32_t len = Be32(m_data + m_pos);
+        const std::uint32_t type = Be32(m_data + m_pos + 4);
+        if (len > m_size - m_pos - 12 || type == TAG_IEND)
+        {
+            break;
+        }
+        const std::uint8_t* d = m_data + m_pos + 8;
+        const size_t nextChunk = m_pos + (size_t)len + 12;
+
+        if (type == TAG_FCTL && m_animated)
+        {
+            if (len < 26)
+            {
+                break;
+            }
+            rect = Rect{ (int)Be32(d + 12), (int)Be32(d + 16), (int)Be32(d + 4), (int)Be32(d + 8) };
+            if (rect.w <= 0 || rect.h <= 0 || rect.x < 0 || rect.y < 0 ||
+                rect.x > m_info.width - rect.w || rect.y > m_info.height - rect.h)
+            {
+                break;
+            }
+            const int num = Be16(d + 20);
+            const int den = Be16(d + 22) != 0 ? Be16(d + 22) : 100;
+            delay = std::max(ANIM_MIN_DELAY_MS, num * 1000 / den);
+            dispose = d[24] == 1 ? Dispose::Background : (d[24] == 2 ? Dispose::Previous : Dispose::None);
+            blendOver = d[25] == 1;
+            haveControl = true;
+            m_pos = nextChunk;
+            continue;
+        }
+
+        // 动画中没有 fcTL 在前的 IDAT 是不参与播放的默认图像
+        const bool frameData = (type == TAG_IDAT && (haveControl || !m_animated)) || (type == TAG_FDAT && haveControl);
+        if (!frameData)
+        {
+            m_pos = nextChunk;
+            continue;
+        }
+
+        // 一帧的数据可以分成多个相邻的同类块，拼接后一次解压
+        m_zbuf.clear();
+        while (m_pos + 12 <= m_size)
+        {
+            const std::uint32_t partLen = Be32(m_data + m_pos);
+            if (Be32(m_data + m_pos + 4) != type || partLen > m_size - m_pos - 12)
+            {
+                break;
+            }
+            const size_t skip = type == TAG_FDAT ? 4 : 0;   // fdAT 以序号开头
+            if (partLen >= skip)
+            {
+                const std::uint8_t* part = m_data + m_pos + 8 + skip;
+                m_zbuf.insert(m_zbuf.end(), part, part + (partLen - skip));
+            }
+            m_pos += (size_t)partLen + 12;
+        }
+
+        BeginFrame(rect, dispose);
+        if (!DecodePngImage(rect, blendOver))
+        {
+            break;
+        }
+        delayMs = delay;
+        if (!m_animated)
+        {
+            m_pos = m_size;
+        }
+        return true;
+    }
+    m_pos = m_size;
+    return false;
+}
+
+bool AnimDecoder::DecodePngImage(const Rect& rect, bool blendOver)
+{
+    static constexpr int kChannels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+    const int channels = kChannels[m_colorType];
+    const size_t bitsPerPixel = (size_t)channels * (size_t)m_bitDepth;
+    const size_t rowBytes = ((size_t)rect.w * bitsPerPixel + 7) / 8;
+    const size_t filterBpp = std::max<size_t>(1, bitsPerPixel / 8);
+    const size_t stride = rowBytes + 1;
+    m_raw.resize(stride * (size_t)rect.h);
+    if (!Inflate_Zlib(m_zbuf.data(), m_zbuf.size(), m_raw.data(), m_raw.size()))
+    {
+        return false;
+    }
+
+    const int depth = m_bitDepth;
+    const bool wide = depth == 16;
+    const int maxSample = (1 << depth) - 1;
+    const std::uint8_t* prev = nullptr;
+    for (int r = 0; r < rect.h; r++)
+    {
+        std::uint8_t* row = m_raw.data() + (size_t)r * stride;
+        if (!Unfilter(row, prev, rowBytes, filterBpp))
+        {
+            return false;
+        }
+        const std::uint8_t* s = row + 1;
+        prev = s;
+
+        std::uint32_t* dst = m_canvas.data() + (size_t)(rect.y + r) * (size_t)m_info.width + rect.x;
+        for (int x = 0; x < rect.w; x++)
+        {
+            std::uint32_t c = 0;
+            switch (m_colorType)
+            {
+            case 0:
+            {
+                int v = 0;
+                if (depth < 8)
+                {
+                    const size_t bit = (size_t)x * (size_t)depth;
+                    v = (s[bit >> 3] >> (8 - depth - (int)(bit & 7))) & maxSample;
+                }
+                else
+                {
+                    v = wide ? Be16(s + x * 2) : s[x];
+                }
+                const std::uint32_t g = wide ? (std::uint32_t)v >> 8 : (std::uint32_t)(v * 255 / maxSample);
+                const std::uint32_t a = m_hasKey && v == m_key[0] ? 0u : 255u;
+                c = (a << 24) | (g << 16) | (g << 8) | g;
+                break;
+            }
+            case 2:
+            {
+                std::uint32_t rgb[3];
+                bool keyed = m_hasKey;
+                for (int i = 0; i < 3; i++)
+                {
+                    const int v = wide ? Be16(s + x * 6 + i * 2) : s[x * 3 + i];
+                    keyed = keyed && v == m_key[i];
+                    rgb[i] = wide ? (std::uint32_t)v >> 8 : (std::uint32_t)v;
+                }
+                c = (keyed ? 0u : 0xFF000000u) | (rgb[0] << 16) | (rgb[1] << 8) | rgb[2];
+                break;
+            }
+            case 3:
+            {
+                int v = s[x];
+                if (depth < 8)
+                {
+                    const size_t bit = (size_t)x * (size_t)depth;
+                    v = (s[bit >> 3] >> (8 - depth - (int)(bit & 7))) & maxSample;
+                }
+                c = m_palette[v];
+                break;
+            }
+            case 4:
+            {
+                const std::uint32_t g = wide ? s[x * 4] : s[x * 2];
+                const std::uint32_t a = wide ? s[x * 4 + 2] : s[x * 2 + 1];
+                c = (a << 24) | (g << 16) | (g << 8) | g;
+                break;
+            }
+            default:
+            {
+                const std::uint8_t* p = wide ? s + x * 8 : s + x * 4;
+                const int step = wide ? 2 : 1;
+                c = ((std::uint32_t)p[step * 3] << 24) | ((std::uint32_t)p[0] << 16) | ((std::uint32_t)p[step] << 8) | p[step * 2];
+                break;
+            }
+            }
+            dst[x] = blendOver ? BlendOver(c, dst[x]) : c;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 遮罩上播放的眼保健操、拉伸动作短片：GIF（87a/89a）与 APNG，逐帧流式解码。
+// 解码器直接读调用方提供的内存（通常是映射的文件），只保存一张源尺寸的画布，
+// 不预先展开所有帧；画布为未预乘的 0xAARRGGBB，帧之间按各自的处置方式合成。
+enum class AnimFormat : int
+{
+    None = 0,
+    Gif = 1,
+    Apng = 2,   // 没有 acTL 的普通 PNG 也按单帧动画处理
+};
+
+struct AnimInfo
+{
+    AnimFormat format = AnimFormat::None;
+    int width = 0;
+    int height = 0;
+    int loops = 0;   // 文件要求的播放次数，0 为无限循环
+};
+
+constexpr int ANIM_MAX_DIMENSION = 4096;
+// GIF 与浏览器一致：0、1 个百分之一秒的帧按 100ms 播放；APNG 的 0 延时按最短延时播放
+constexpr int ANIM_MIN_DELAY_MS = 10;
+constexpr int ANIM_DEFAULT_DELAY_MS = 100;
+
+class AnimDecoder
+{
+public:
+    // data 在解码器使用期间必须有效；只解析文件头。格式不支持或头部损坏时返回 false
+    bool Open(const std::uint8_t* data, size_t size, std::wstring* error = nullptr);
+    void Close();
+
+    bool IsOpen() const { return m_info.format != AnimFormat::None; }
+    const AnimInfo& Info() const { return m_info; }
+
+    // 解码下一帧并合成到画布，delayMs 为这一帧的显示时长。到达文件末尾或遇到损坏的数据时
+    // 返回 false，此前解出的帧仍然有效；之后调用 Rewind 从第一帧重新开始
+    bool Next(int& delayMs);
+    void Rewind();
+
+    // Width × Height，行距等于宽度
+    const std::uint32_t* Canvas() const { return m_canvas.data(); }
+
+private:
+    struct Rect
+    {
+        int x = 0;
+        int y = 0;
+        int w = 0;
+        int h = 0;
+    };
+
+    // 处置方式，GIF 与 APNG 共用
+    enum class Dispose : int
+    {
+        None = 0,
+        Background = 1,   // 清为透明
+        Previous = 2,     // 恢复到绘制这一帧之前
+    };
+
+    bool OpenGif(std::wstring* error);
+    bool OpenPng(std::wstring* error);
+    bool NextGif(int& delayMs);
+    bool NextPng(int& delayMs);
+    bool DecodeGifImage(const std::uint8_t* palette, int paletteSize, int transparent, bool interlaced, const Rect& rect);
+    bool DecodePngImage(const Rect& rect, bool blendOver);
+
+    // 先按上一帧的处置方式处理画布，再记下这一帧的处置方式
+    void BeginFrame(const Rect& rect, Dispose dispose);
+
+    const std::uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_pos = 0;
+    size_t m_firstFrame = 0;
+    int m_frameIndex = 0;   // Rewind 之后解出的帧数
+    AnimInfo m_info;
+
+    std::vector<std::uint32_t> m_canvas;
+    std::vector<std::uint32_t> m_saved;   // 处置方式为 Previous 的帧之前的画布
+    Rect m_lastRect;
+    Dispose m_lastDispose = Dispose::None;
+
+    // GIF
+    std::uint8_t m_globalPalette[256 * 3]{};
+    int m_globalPaletteSize = 0;
+    std::vector<std::uint8_t> m_indices;
+    std::vector<std::uint16_t> m_prefix;
+    std::vector<std::uint8_t> m_suffix;
+    std::vector<std::uint16_t> m_length;
+
+    // PNG
+    int m_bitDepth = 8;
+    int m_colorType = 6;
+    std::uint32_t m_palette[256]{};
+    bool m_hasKey = false;
+    std::uint16_t m_key[3]{};   // 灰度或 RGB 的透明色
+    bool m_animated = false;
+    std::vector<std::uint8_t> m_zbuf;
+    std::vector<std::uint8_t> m_raw;
+};
@@ -0,0 +1,428 @@
+#include "anim_player.h"
+
+#include <algorithm>
+
+#include "mapped_file.h"
+#include "soft_render.h"
+
+namespace
+{
+    // 透明部分合成到不透明的背景上；输出 0x00RRGGBB
+    void ComposeOver(const std::uint32_t* src, size_t count, std::uint32_t bg, std::uint32_t* dst)
+    {
+        const std::uint32_t bgRb = bg & 0x00FF00FFu;
+        const std::uint32_t bgG = bg & 0x0000FF00u;
+        for (size_t i = 0; i < count; i++)
+        {
+            const std::uint32_t c = src[i];
+            const std::uint32_t a = c >> 24;
+            if (a == 255)
+            {
+                dst[i] = c & 0x00FFFFFFu;
+                continue;
+            }
+            if (a == 0)
+            {
+                dst[i] = bg;
+                continue;
+            }
+            const std::uint32_t rb = (((c & 0x00FF00FFu) * a + bgRb * (255 - a)) / 255) & 0x00FF00FFu;
+            const std::uint32_t g = (((c & 0x0000FF00u) * a + bgG * (255 - a)) / 255) & 0x0000FF00u;
+            dst[i] = rb | g;
+        }
+    }
+
+    // 两个像素按 0..256 的权重混合，红蓝与绿分两路同时计算
+    std::uint32_t Lerp(std::uint32_t a, std::uint32_t b, std::uint32_t w)
+    {
+        const std::uint32_t rb = ((a & 0x00FF00FFu) * (256 - w) + (b & 0x00FF00FFu) * w) >> 8;
+        const std::uint32_t g = ((a & 0x0000FF00u) * (256 - w) + (b & 0x0000FF00u) * w) >> 8;
+        return (rb & 0x00FF00FFu) | (g & 0x0000FF00u);
+    }
+
+    // 双线性缩放，采样点取像素中心
+    void ScaleBilinear(const std::uint32_t* src, int sw, int sh, std::uint32_t* dst, int dw, int dh)
+    {
+        if (sw == dw && sh == dh)
+        {
+            std::copy(src, src + (size_t)sw * (size_t)sh, dst);
+            return;
+        }
+        std::vector<int> xs((size_t)dw);
+        std::vector<std::uint32_t> wx((size_t)dw);
+        for (int x = 0; x < dw; x++)
+        {
+            const long long fx = std::max<long long>(0, (((long long)x * 2 + 1) * sw * 256) / ((long long)dw * 2) - 128);
+            xs[(size_t)x] = std::min((int)(fx >> 8), sw - 1);
+            wx[(size_t)x] = xs[(size_t)x] + 1 < sw ? (std::uint32_t)(fx & 0xFF) : 0;
+        }
+        for (int y = 0; y < dh; y++)
+        {
+            const long long fy = std::max<long long>(0, (((long long)y * 2 + 1) * sh * 256) / ((long long)dh * 2) - 128);
+            const int y0 = std::min((int)(fy >> 8), sh - 1);
+            const int y1 = std::min(y0 + 1, sh - 1);
+            const std::uint32_t wy = y1 != y0 ? (std::uint32_t)(fy & 0xFF) : 0;
+            const std::uint32_t* r0 = src + (size_t)y0 * (size_t)sw;
+            const std::uint32_t* r1 = src + (size_t)y1 * (size_t)sw;
+            std::uint32_t* out = dst + (size_t)y * (size_t)dw;
+            for (int x = 0; x < dw; x++)
+            {
+                const int x0 = xs[(size_t)x];
+                const int x1 = x0 + (wx[(size_t)x] != 0 ? 1 : 0);
+                const std::uint32_t top = Lerp(r0[x0], r0[x1], wx[(size_t)x]);
+                const std::uint32_t bottom = Lerp(r1[x0], r1[x1], wx[(size_t)x]);
+                out[x] = Lerp(top, bottom, wy);
+            }
+        }
+    }
+
+    std::uint64_t HashContent(const std::filesystem::path& path, std::uint64_t fileSize, const AnimInfo& info)
+    {
+        // FNV-1a；0 留给“没有动画”
+        std::uint64_t h = 0xCBF29CE484222325ull;
+        for (char ch : path.u8string())
+        {
+            h = (h ^ (std::uint8_t)ch) * 0x100000001B3ull;
+        }
+        for (std::uint64_t v : { fileSize, (std::uint64_t)info.width, (std::uint64_t)info.height, (std::uint64_t)info.format })
+        {
+            h = (h ^ v) * 0x100000001B3ull;
+        }
+        return h | 1;
+    }
+}
+
+AnimPlayer::~AnimPlayer()
+{
+    Stop();
+}
+
+bool AnimPlayer::Open(const std::filesystem::path& path, std::wstring* error)
+{
+    Close();
+    MappedFile file;
+    if (!file.OpenRead(path) || file.size() == 0)
+    {
+        if (error)
+        {
+            *error = L"无法读取动画文件。";
+        }
+        return false;
+    }
+    AnimDecoder decoder;
+    if (!decoder.Open(file.data(), file.size(), error))
+    {
+        return false;
+    }
+    m_path = path;
+    m_info = decoder.Info();
+    m_contentKey = HashContent(path, file.size(), m_info);
+    return true;
+}
+
+void AnimPlayer::Close()
+{
+    Stop();
+    m_path.clear();
+    m_info = AnimInfo{};
+    m_contentKey = 0;
+}
+
+void AnimPlayer::Start(const std::vector<AnimTarget>& targets, ColorRef bgColor, std::uint64_t nowMs)
+{
+    Stop();
+    if (!IsOpen())
+    {
+        return;
+    }
+    m_targets.clear();
+    for (const AnimTarget& t : targets)
+    {
+        const bool seen = std::any_of(m_targets.begin(), m_targets.end(), [&](const AnimTarget& o) { return o.width == t.width && o.height == t.height; });
+        if (!seen && t.width > 0 && t.height > 0 && (int)m_targets.size() < ANIM_MAX_TARGETS)
+        {
+            m_targets.push_back(t);
+        }
+    }
+    if (m_targets.empty())
+    {
+        return;
+    }
+    m_bgPixel = Soft_PixelFromColor(bgColor);
+    m_startMs = nowMs;
+    m_startTime = Clock::now();
+    m_stop = false;
+    m_finished = false;
+    m_head = 0;
+    m_count = 0;
+    m_hasCurrent = false;
+    m_underrunDue = UINT64_MAX;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats = AnimPlayerStats{};
+    }
+    m_thread = std::thread([this] { WorkerLoop(); });
+}
+
+void AnimPlayer::Stop()
+{
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+    for (Slot& slot : m_ring)
+    {
+        std::vector<Pixels>().swap(slot.targets);
+    }
+    std::vector<Pixels>().swap(m_current.targets);
+    Pixels().swap(m_opaque);
+    m_hasCurrent = false;
+    m_head = 0;
+    m_count = 0;
+}
+
+std::uint64_t AnimPlayer::WorkerNowMs() const
+{
+    return m_startMs + (std::uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_startTime).count();
+}
+
+void AnimPlayer::Render(const std::uint32_t* canvas, Slot& slot)
+{
+    const size_t count = (size_t)m_info.width * (size_t)m_info.height;
+    m_opaque.resize(count);
+    ComposeOver(canvas, count, m_bgPixel, m_opaque.data());
+    slot.targets.resize(m_targets.size());
+    for (size_t i = 0; i < m_targets.size(); i++)
+    {
+        const AnimTarget& t = m_targets[i];
+        slot.targets[i].resize((size_t)t.width * (size_t)t.height);
+        ScaleBilinear(m_opaque.data(), m_info.width, m_info.height, slot.targets[i].data(), t.width, t.height);
+    }
+}
+
+void AnimPlayer::WorkerLoop()
+{
+    MappedFile file;
+    AnimDecoder decoder;
+    // 文件在两次提醒之间被替换成了不同尺寸的动画时，版面已按旧尺寸排好，不播放
+    if (!file.OpenRead(m_path) || !decoder.Open(file.data(), file.size()) ||
+        decoder.Info().width != m_info.width || decoder.Info().height != m_info.height)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.errors++;
+        m_finished = true;
+        return;
+    }
+
+    size_t ringBytes = 0;
+    for (const AnimTarget& t : m_targets)
+    {
+        ringBytes += (size_t)t.width * (size_t)t.height * sizeof(std::uint32_t);
+    }
+    ringBytes *= ANIM_RING_FRAMES + 1;
+
+    std::uint64_t offsetMs = 0;
+    int loopsDone = 0;
+    int framesThisLoop = 0;
+    bool sentAny = false;
+    // 连续跳过的帧数有上限：解码本身跟不上时仍然每隔几帧更新一次画面
+    int skipped = 0;
+    // 解码线程跳过了缩放的最后一帧；播放结束时仍要送出，画面停在最后一帧
+    bool pendingLast = false;
+    std::uint64_t pendingDue = 0;
+    std::uint32_t pendingDelay = 0;
+
+    for (;;)
+    {
+        const Clock::time_point t0 = Clock::now();
+        int delay = 0;
+        bool push = decoder.Next(delay);
+        std::uint64_t due = offsetMs;
+        std::uint32_t delayMs = (std::uint32_t)delay;
+        bool last = false;
+        if (!push)
+        {
+            loopsDone++;
+            bool error = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stats.loops++;
+                error = framesThisLoop == 0;
+                m_stats.errors += error ? 1 : 0;
+            }
+            // 单帧的图片不必反复解码
+            last = error || framesThisLoop == 1 || (m_info.loops != 0 && loopsDone >= m_info.loops);
+            if (!last)
+            {
+                decoder.Rewind();
+                framesThisLoop = 0;
+                continue;
+            }
+            if (!pendingLast)
+            {
+                break;
+            }
+            push = true;
+            due = pendingDue;
+            delayMs = pendingDelay;
+        }
+        else
+        {
+            framesThisLoop++;
+            offsetMs += delayMs;
+            // 这一帧的显示时段已经过去：仍需解码（后面的帧在它之上合成），但不再缩放送出
+            if (sentAny && skipped < ANIM_RING_FRAMES && m_startMs + offsetMs <= WorkerNowMs())
+            {
+                skipped++;
+                pendingLast = true;
+                pendingDue = due;
+                pendingDelay = delayMs;
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stats.dropped++;
+                m_stats.decodeNs += (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+                continue;
+            }
+            pendingLast = false;
+            skipped = 0;
+        }
+
+        // 等待环中空位的时间不算解码耗时
+        const std::uint64_t decodeNs = (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+        int index = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_stop || m_count < ANIM_RING_FRAMES; });
+            if (m_stop)
+            {
+                return;
+            }
+            index = (m_head + m_count) % ANIM_RING_FRAMES;
+        }
+        // 环中 m_count 之后的槽只有解码线程访问
+        Slot& slot = m_ring[index];
+        const Clock::time_point t1 = Clock::now();
+        Render(decoder.Canvas(), slot);
+        slot.dueMs = due;
+        slot.delayMs = delayMs;
+        sentAny = true;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_count++;
+            m_stats.decoded++;
+            m_stats.decodeNs += decodeNs + (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t1).count();
+            m_stats.ringBytes = ringBytes;
+        }
+        if (last)
+        {
+            break;
+        }
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_finished = true;
+}
+
+bool AnimPlayer::Advance(std::uint64_t nowMs)
+{
+    bool changed = false;
+    bool freed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (m_count > 0)
+        {
+            Slot& front = m_ring[m_head];
+            if (m_startMs + front.dueMs > nowMs)
+            {
+                break;
+            }
+            const Slot& following = m_ring[(m_head + 1) % ANIM_RING_FRAMES];
+            if (m_count >= 2 && m_startMs + following.dueMs <= nowMs)
+            {
+                // 后一帧也已到点：这一帧来不及显示
+                m_stats.dropped++;
+            }
+            else
+            {
+                // 交换像素缓冲：旧的当前帧成为空槽，由解码线程复用
+                std::swap(front.targets, m_current.targets);
+                m_current.dueMs = front.dueMs;
+                m_current.delayMs = front.delayMs;
+                const std::uint64_t late = nowMs - (m_startMs + front.dueMs);
+                m_stats.presented++;
+                m_stats.lateMsTotal += late;
+                m_stats.lateMsMax = std::max(m_stats.lateMsMax, late);
+                m_hasCurrent = true;
+                changed = true;
+            }
+            m_head = (m_head + 1) % ANIM_RING_FRAMES;
+            m_count--;
+            freed = true;
+            if (changed)
+            {
+                break;
+            }
+        }
+        if (!changed && m_count == 0 && m_hasCurrent && !m_finished &&
+            nowMs >= m_startMs + m_current.dueMs + m_current.delayMs && m_underrunDue != m_current.dueMs)
+        {
+            m_stats.underruns++;
+            m_underrunDue = m_current.dueMs;
+        }
+    }
+    if (freed)
+    {
+        m_cv.notify_all();
+    }
+    return changed;
+}
+
+bool AnimPlayer::NextDelay(std::uint64_t nowMs, std::uint32_t& delayMs) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::uint64_t due = 0;
+    if (m_count > 0)
+    {
+        due = m_startMs + m_ring[m_head].dueMs;
+    }
+    else if (m_finished || !m_thread.joinable())
+    {
+        return false;
+    }
+    else if (m_hasCurrent && m_startMs + m_current.dueMs + m_current.delayMs > nowMs)
+    {
+        due = m_startMs + m_current.dueMs + m_current.delayMs;
+    }
+    else
+    {
+        delayMs = ANIM_RETRY_MS;
+        return true;
+    }
+    delayMs = (std::uint32_t)std::max<std::uint64_t>(1, due > nowMs ? due - nowMs : 0);
+    return true;
+}
+
+const std::uint32_t* AnimPlayer::Frame(int width, int height) const
+{
+    if (!m_hasCurrent)
+    {
+        return nullptr;
+    }
+    for (size_t i = 0; i < m_targets.size() && i < m_current.targets.size(); i++)
+    {
+        if (m_targets[i].width == width && m_targets[i].height == height)
+        {
+            return m_current.targets[i].data();
+        }
+    }
+    return nullptr;
+}
+
+AnimPlayerStats AnimPlayer::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "anim_decode.h"
+#include "config.h"
+#include "show_arena.h"
+
+// 环中的帧数：解码线程最多领先界面这么多帧，内存上限为 (ANIM_RING_FRAMES + 1) × 各目标尺寸之和
+constexpr int ANIM_RING_FRAMES = 6;
+// 不同尺寸的显示器各需要一份缩放后的帧；超出的尺寸不显示动画
+constexpr int ANIM_MAX_TARGETS = 4;
+// 该显示下一帧而解码线程还没送来时，隔这么久再看一次
+constexpr std::uint32_t ANIM_RETRY_MS = 4;
+
+struct AnimTarget
+{
+    int width = 0;
+    int height = 0;
+};
+
+struct AnimPlayerStats
+{
+    std::uint64_t decoded = 0;      // 解码线程送进环的帧
+    std::uint64_t presented = 0;
+    std::uint64_t dropped = 0;      // 落后时没有显示的帧（解码线程跳过缩放的也算）
+    std::uint64_t underruns = 0;    // 到点时下一帧还没解出，继续显示当前帧
+    std::uint64_t loops = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t decodeNs = 0;     // 解码、合成背景与缩放的累计耗时
+    std::uint64_t lateMsTotal = 0;  // 显示时刻晚于计划时刻的累计毫秒
+    std::uint64_t lateMsMax = 0;
+    std::uint64_t ringBytes = 0;    // 环与当前帧的像素字节数
+};
+
+// 遮罩上的动画。解码线程逐帧解码，把透明部分合成到背景色上并缩放成各显示器需要的尺寸，
+// 放进固定容量的环；环满时解码线程等待。界面线程由计时器驱动 Advance，按帧延时
+// 取出该显示的帧：落后时丢弃过期的帧（解码线程也不再缩放已经过期的帧），
+// 下一帧还没解出时继续显示当前帧，从不等待解码线程。
+// 帧像素放在 ShowArena_Overlay 里，Stop 之后随遮罩的其他画面一起归还系统。
+class AnimPlayer
+{
+public:
+    using Pixels = std::vector<std::uint32_t, ShowArenaAllocator<std::uint32_t>>;
+
+    AnimPlayer() = default;
+    ~AnimPlayer();
+
+    AnimPlayer(const AnimPlayer&) = delete;
+    AnimPlayer& operator=(const AnimPlayer&) = delete;
+
+    // 只读取文件头；文件在每次 Start 时重新映射，Stop 后不占用文件。
+    // 失败时关闭之前打开的动画，error 说明原因
+    bool Open(const std::filesystem::path& path, std::wstring* error = nullptr);
+    void Close();
+
+    bool IsOpen() const { return m_info.format != AnimFormat::None; }
+    const AnimInfo& Info() const { return m_info; }
+    const std::filesystem::path& Path() const { return m_path; }
+    // 路径、文件大小与画面尺寸的哈希，区分画面缓存；未打开时为 0
+    std::uint64_t ContentKey() const { return m_contentKey; }
+
+    // 从第一帧开始一次播放。targets 为各显示器上动画的像素尺寸（重复的合并），
+    // bgColor 填在动画透明的部分；第一帧计划在 nowMs 显示
+    void Start(const std::vector<AnimTarget>& targets, ColorRef bgColor, std::uint64_t nowMs);
+    // 停止解码线程，释放环、画布与当前帧
+    void Stop();
+    bool IsPlaying() const { return m_thread.joinable(); }
+
+    // 界面线程：换到 nowMs 应显示的帧，返回当前帧是否变化
+    bool Advance(std::uint64_t nowMs);
+    // 距下一次需要 Advance 的毫秒数；已播完最后一帧、不再需要计时器时返回 false
+    bool NextDelay(std::uint64_t nowMs, std::uint32_t& delayMs) const;
+
+    // 当前帧在 width × height 目标上的 0x00RRGGBB 像素，行距为 width；
+    // 还没有帧或不是 Start 时给出的尺寸时返回 nullptr
+    const std::uint32_t* Frame(int width, int height) const;
+
+    AnimPlayerStats Stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Slot
+    {
+        std::vector<Pixels> targets;
+        std::uint64_t dueMs = 0;    // 相对 Start 的计划显示时刻
+        std::uint32_t delayMs = 0;
+    };
+
+    void WorkerLoop();
+    std::uint64_t WorkerNowMs() const;
+    // 把解码器画布合成到背景上并缩放到各目标尺寸
+    void Render(const std::uint32_t* canvas, Slot& slot);
+
+    std::filesystem::path m_path;
+    AnimInfo m_info;
+    std::uint64_t m_contentKey = 0;
+
+    std::vector<AnimTarget> m_targets;
+    std::uint32_t m_bgPixel = 0;
+    std::uint64_t m_startMs = 0;
+    Clock::time_point m_startTime{};
+    Pixels m_opaque;
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+    bool m_finished = false;
+    Slot m_ring[ANIM_RING_FRAMES];
+    int m_head = 0;
+    int m_count = 0;
+
+    // 界面线程持有的当前帧
+    Slot m_current;
+    bool m_hasCurrent = false;
+    std::uint64_t m_underrunDue = UINT64_MAX;
+
+    AnimPlayerStats m_stats;
+};
@@ -0,0 +1,229 @@
+#include "asset_pack.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct PackHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t packKey;
+        std::uint64_t fileSize;
+        std::uint32_t entryCount;
+        std::uint32_t reserved;
+        std::uint64_t dataHash;     // 头之后所有字节的散列
+    };
+
+    struct PackEntry
+    {
+        std::uint32_t kind;
+        std::int32_t width;
+        std::int32_t height;
+        std::int32_t dpi;
+        std::uint64_t contentHash;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    static_assert(sizeof(PackHeader) == 40, "header layout");
+    static_assert(sizeof(PackEntry) == 40, "entry layout");
+
+    constexpr size_t DATA_ALIGN = 64;
+
+    size_t AlignUp(size_t value)
+    {
+        return (value + DATA_ALIGN - 1) & ~(DATA_ALIGN - 1);
+    }
+
+    // 与 ConfigLayer_Hash 相同的每次 8 字节的 FNV-1a 变体：发现截断与损坏；防篡改靠所有者检查
+    std::uint64_t PackHash(const std::uint8_t* data, size_t size)
+    {
+        std::uint64_t h = 0xCBF29CE484222325ull ^ size;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            h = (h ^ word) * 0x100000001B3ull;
+            h ^= h >> 29;
+        }
+        for (; i < size; i++)
+        {
+            h = (h ^ data[i]) * 0x100000001B3ull;
+        }
+        return h;
+    }
+
+    long CurrentPid()
+    {
+#ifdef _WIN32
+        return (long)_getpid();
+#else
+        return (long)getpid();
+#endif
+    }
+}
+
+std::filesystem::path AssetPack_Path(const std::filesystem::path& dir, std::uint64_t packKey)
+{
+    char name[40];
+    std::snprintf(name, sizeof(name), "ssr-%016llx.pack", (unsigned long long)packKey);
+    return dir / name;
+}
+
+void AssetPackBuilder::Add(AssetKind kind, const AssetKey& key, const void* data, size_t size)
+{
+    Pending entry{ kind, key, {} };
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    entry.bytes.assign(bytes, bytes + size);
+    m_entries.push_back(std::move(entry));
+}
+
+bool AssetPackBuilder::Publish(const std::filesystem::path& dir, std::uint64_t packKey) const
+{
+    const std::filesystem::path path = AssetPack_Path(dir, packKey);
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec))
+    {
+        return true;
+    }
+    std::filesystem::create_directories(dir, ec);
+
+    const size_t tableEnd = sizeof(PackHeader) + m_entries.size() * sizeof(PackEntry);
+    std::vector<PackEntry> table;
+    size_t offset = AlignUp(tableEnd);
+    for (const Pending& e : m_entries)
+    {
+        table.push_back(PackEntry{ (std::uint32_t)e.kind, e.key.width, e.key.height, e.key.dpi, e.key.contentHash, offset, e.bytes.size() });
+        offset = AlignUp(offset + e.bytes.size());
+    }
+
+    std::vector<std::uint8_t> image(offset, 0);
+    if (!table.empty())
+    {
+        std::memcpy(image.data() + sizeof(PackHeader), table.data(), table.size() * sizeof(PackEntry));
+    }
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        if (!m_entries[i].bytes.empty())
+        {
+            std::memcpy(image.data() + table[i].offset, m_entries[i].bytes.data(), m_entries[i].bytes.size());
+        }
+    }
+    const PackHeader header{ ASSET_PACK_MAGIC, ASSET_PACK_VERSION, packKey, offset, (std::uint32_t)m_entries.size(), 0,
+        PackHash(image.data() + sizeof(PackHeader), image.size() - sizeof(PackHeader)) };
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    std::filesystem::path tmp = path;
+    tmp += ".tmp" + std::to_string(CurrentPid());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(image.data()), (std::streamsize)image.size());
+        out.close();
+        // 权限在发布前设好：硬链接与原文件共用同一份权限
+        if (!out || !MappedFile_RestrictWriteToOwner(tmp))
+        {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+    // 用硬链接发布：目标已存在时失败而不是替换，已被其他会话映射的资源包保持不变
+    std::filesystem::create_hard_link(tmp, path, ec);
+    if (ec && !std::filesystem::exists(path, ec))
+    {
+        // 不支持硬链接的文件系统
+        std::filesystem::rename(tmp, path, ec);
+    }
+    std::filesystem::remove(tmp, ec);
+    return std::filesystem::exists(path, ec);
+}
+
+SharedAssetPack::~SharedAssetPack()
+{
+    Close();
+}
+
+bool SharedAssetPack::Open(const std::filesystem::path& dir, std::uint64_t packKey)
+{
+    Close();
+    const std::filesystem::path path = AssetPack_Path(dir, packKey);
+    // 共享目录里谁都能放文件：别的普通用户发布的资源包不映射，调用方改用自己的目录
+    if (!m_file.OpenRead(path) || !m_file.OwnerTrusted() || !m_file.LockShared())
+    {
+        Close();
+        return false;
+    }
+
+    PackHeader header{};
+    if (m_file.size() < sizeof(header))
+    {
+        Close();
+        return false;
+    }
+    std::memcpy(&header, m_file.data(), sizeof(header));
+    const size_t tableEnd = sizeof(PackHeader) + (size_t)header.entryCount * sizeof(PackEntry);
+    if (header.magic != ASSET_PACK_MAGIC || header.version != ASSET_PACK_VERSION || header.packKey != packKey ||
+        header.fileSize != m_file.size() || tableEnd > m_file.size() ||
+        header.dataHash != PackHash(m_file.data() + sizeof(PackHeader), m_file.size() - sizeof(PackHeader)))
+    {
+        Close();
+        return false;
+    }
+
+    m_path = path;
+    m_packKey = packKey;
+    m_entryCount = header.entryCount;
+    return true;
+}
+
+void SharedAssetPack::Close()
+{
+    // 能取得独占锁说明没有别的使用者（崩溃的进程的锁已由系统释放）；
+    // 没有删除权限（别的用户发布的）时留给下一个使用者复用
+    if (IsOpen() && !m_path.empty() && m_file.TryLockExclusive())
+    {
+        std::error_code ec;
+        std::filesystem::remove(m_path, ec);
+    }
+    m_file.Close();
+    m_path.clear();
+    m_packKey = 0;
+    m_entryCount = 0;
+}
+
+const std::uint8_t* SharedAssetPack::Find(AssetKind kind, const AssetKey& key, size_t& size) const
+{
+    size = 0;
+    const std::uint8_t* base = m_file.data();
+    if (!base)
+    {
+        return nullptr;
+    }
+    for (std::uint32_t i = 0; i < m_entryCount; i++)
+    {
+        PackEntry e;
+        std::memcpy(&e, base + sizeof(PackHeader) + (size_t)i * sizeof(PackEntry), sizeof(e));
+        if (e.kind != (std::uint32_t)kind || e.width != key.width || e.height != key.height || e.dpi != key.dpi || e.contentHash != key.contentHash)
+        {
+            continue;
+        }
+        if (e.offset > m_file.size() || e.size > m_file.size() - e.offset)
+        {
+            return nullptr;
+        }
+        size = (size_t)e.size;
+        return base + e.offset;
+    }
+    return nullptr;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "mapped_file.h"
+
+// 多会话主机（RDS / Citrix）上的共享只读资源包：同样的配置与显示器在每个会话里渲染出的
+// 底图完全相同，第一个会话渲染后写成按内容寻址的文件，其余会话直接映射，物理页只有一份。
+// 文件 = 头 + 条目表 + 按 64 字节对齐的数据，头里记录条目表与数据的散列，打开时校验。
+// 目录对所有用户可写，只映射当前用户或管理员发布、其他用户不能改写的资源包；发布时把文件设为其他人只读。
+// 每个使用者在文件上持有共享锁，锁随进程退出（包括崩溃）由系统释放；关闭时能取得独占锁
+// 说明没有别的使用者了，删除文件。
+
+enum class AssetKind : std::uint32_t
+{
+    FrameBase = 1,   // 背景与文字的底图，自上而下 32 位 0x00RRGGBB
+};
+
+struct AssetKey
+{
+    int width = 0;
+    int height = 0;
+    int dpi = 0;
+    std::uint64_t contentHash = 0;
+};
+
+constexpr std::uint32_t ASSET_PACK_MAGIC = 0x41525353; // "SSRA"
+constexpr std::uint32_t ASSET_PACK_VERSION = 2;
+
+class AssetPackBuilder
+{
+public:
+    void Add(AssetKind kind, const AssetKey& key, const void* data, size_t size);
+
+    // 先写临时文件再改名，读取方不会看到写了一半的资源包；已有同名资源包时不覆盖（即使不受信任）
+    bool Publish(const std::filesystem::path& dir, std::uint64_t packKey) const;
+
+    size_t Entries() const { return m_entries.size(); }
+
+private:
+    struct Pending
+    {
+        AssetKind kind;
+        AssetKey key;
+        std::vector<std::uint8_t> bytes;
+    };
+    std::vector<Pending> m_entries;
+};
+
+class SharedAssetPack
+{
+public:
+    SharedAssetPack() = default;
+    ~SharedAssetPack();
+
+    SharedAssetPack(const SharedAssetPack&) = delete;
+    SharedAssetPack& operator=(const SharedAssetPack&) = delete;
+
+    // 映射已发布的资源包并持有共享锁；不存在、所有者不受信任、格式或散列不对时返回 false
+    bool Open(const std::filesystem::path& dir, std::uint64_t packKey);
+    void Close();
+
+    bool IsOpen() const { return m_file.data() != nullptr; }
+    std::uint64_t PackKey() const { return m_packKey; }
+
+    // 找不到时返回 nullptr
+    const std::uint8_t* Find(AssetKind kind, const AssetKey& key, size_t& size) const;
+
+    size_t MappedBytes() const { return m_file.size(); }
+
+private:
+    MappedFile m_file;
+    std::filesystem::path m_path;
+    std::uint64_t m_packKey = 0;
+    std::uint32_t m_entryCount = 0;
+};
+
+std::filesystem::path AssetPack_Path(const std::filesystem::path& dir, std::uint64_t packKey);
@@ -0,0 +1,407 @@
+#include "break_log.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+#include "mapped_file.h"
+
+static std::uint64_t Rotl64(std::uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// 覆盖前 28 字节；四个乘法互不依赖，扫描大文件时不会成为瓶颈
+std::uint32_t BreakLog_Checksum(const BreakRecord& rec)
+{
+    std::uint64_t w[3];
+    std::uint32_t last;
+    std::memcpy(w, &rec, sizeof(w));
+    std::memcpy(&last, reinterpret_cast<const std::uint8_t*>(&rec) + sizeof(w), sizeof(last));
+
+    const std::uint64_t a = (w[0] ^ 0x243F6A8885A308D3ull) * 0x9E3779B97F4A7C15ull;
+    const std::uint64_t b = (w[1] ^ 0x13198A2E03707344ull) * 0xC2B2AE3D27D4EB4Full;
+    const std::uint64_t c = (w[2] ^ 0xA4093822299F31D0ull) * 0x165667B19E3779F9ull;
+    const std::uint64_t d = ((std::uint64_t)last ^ 0x082EFA98EC4E6C89ull) * 0xD6E8FEB86659FD93ull;
+
+    std::uint64_t h = Rotl64(a, 31) ^ Rotl64(b, 27) ^ Rotl64(c, 33) ^ d;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    return (std::uint32_t)h;
+}
+
+BreakRecord BreakLog_MakeRecord(BreakEvent event, std::uint16_t flags, std::uint32_t cycle, std::int64_t unixMs, std::uint32_t sinceShownMs)
+{
+    BreakRecord rec{};
+    rec.magic = BREAK_LOG_MAGIC;
+    rec.version = BREAK_LOG_VERSION;
+    rec.event = (std::uint8_t)event;
+    rec.flags = flags;
+    rec.cycle = cycle;
+    rec.unixMs = unixMs;
+    rec.sinceShownMs = sinceShownMs;
+    rec.checksum = BreakLog_Checksum(rec);
+    return rec;
+}
+
+bool BreakLog_IsValid(const BreakRecord& rec)
+{
+    return rec.magic == BREAK_LOG_MAGIC && rec.version == BREAK_LOG_VERSION && rec.checksum == BreakLog_Checksum(rec);
+}
+
+std::int64_t BreakLog_NowUnixMs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+BreakLogWriter::~BreakLogWriter()
+{
+    Stop();
+}
+
+bool BreakLogWriter::Start(const std::filesystem::path& path)
+{
+    Stop();
+    m_path = path;
+
+    // 上次崩溃可能留下半条记录，截断到记录边界，保证后续追加仍然对齐
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (!ec && size % sizeof(BreakRecord) != 0)
+    {
+        std::filesystem::resize_file(path, size - size % sizeof(BreakRecord), ec);
+    }
+
+    std::ofstream probe(path, std::ios::binary | std::ios::app);
+    if (!probe)
+    {
+        return false;
+    }
+    probe.close();
+    SeedFromLastRecord();
+
+    m_stop.store(false);
+    m_thread = std::thread([this] { WriterLoop(); });
+    return true;
+}
+
+// 周期编号接着文件中最后一条有效记录，重启后的提醒不会与之前的记录用同一个编号
+void BreakLogWriter::SeedFromLastRecord()
+{
+    m_cycle = 0;
+    m_shownUnixMs = 0;
+    std::ifstream in(m_path, std::ios::binary | std::ios::ate);
+    const std::streamoff size = in ? (std::streamoff)in.tellg() : 0;
+    // 末尾最多往回找 64 条，跳过崩溃留下的损坏记录
+    for (std::streamoff pos = size - (std::streamoff)sizeof(BreakRecord), n = 0; pos >= 0 && n < 64; pos -= (std::streamoff)sizeof(BreakRecord), n++)
+    {
+        BreakRecord rec{};
+        in.seekg(pos);
+        if (!in.read(reinterpret_cast<char*>(&rec), sizeof(rec)))
+        {
+            return;
+        }
+        if (BreakLog_IsValid(rec))
+        {
+            m_cycle = rec.cycle;
+            m_shownUnixMs = rec.unixMs - (std::int64_t)rec.sinceShownMs;
+            return;
+        }
+    }
+}
+
+void BreakLogWriter::Stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop.store(true);
+    }
+    m_cv.notify_one();
+    m_thread.join();
+}
+
+void BreakLogWriter::Append(BreakEvent event, std::uint16_t flags)
+{
+    const std::int64_t now = BreakLog_NowUnixMs();
+    if (event == BreakEvent::Shown)
+    {
+        m_cycle++;
+        m_shownUnixMs = now;
+    }
+
+    const std::int64_t since = now - m_shownUnixMs;
+    const std::uint32_t sinceMs = since < 0 ? 0u : (since > 0xFFFFFFFFll ? 0xFFFFFFFFu : (std::uint32_t)since);
+    Append(BreakLog_MakeRecord(event, flags, m_cycle, now, sinceMs));
+}
+
+void BreakLogWriter::Append(const BreakRecord& rec)
+{
+    if (!m_thread.joinable())
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const std::uint64_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) >= QUEUE_CAPACITY)
+    {
+        // 写线程跟不上：等它腾出空间，而不是丢掉这次状态切换
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.notify_one();
+        m_spaceCv.wait(lock, [&] { return head - m_tail.load(std::memory_order_acquire) < QUEUE_CAPACITY; });
+        m_waits.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_queue[head % QUEUE_CAPACITY] = rec;
+    m_head.store(head + 1, std::memory_order_release);
+
+    // 写线程已取走之前的全部记录时它可能正要等待，持锁通知以免错过唤醒；否则它处理完这批会再检查一次
+    if (m_tail.load(std::memory_order_acquire) == head)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cv.notify_one();
+    }
+}
+
+void BreakLogWriter::WriterLoop()
+{
+    std::ofstream out(m_path, std::ios::binary | std::ios::app);
+    std::vector<BreakRecord> batch;
+    batch.reserve(QUEUE_CAPACITY);
+
+    for (;;)
+    {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait_for(lock, std::chrono::seconds(1), [this]
+            {
+                return m_stop.load() || m_head.load(std::memory_order_acquire) != m_tail.load(std::memory_order_relaxed);
+            });
+            stopping = m_stop.load();
+        }
+
+        const std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const std::uint64_t head = m_head.load(std::memory_order_acquire);
+        batch.clear();
+        for (std::uint64_t i = tail; i < head; i++)
+        {
+            batch.push_back(m_queue[i % QUEUE_CAPACITY]);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tail.store(head, std::memory_order_release);
+            m_spaceCv.notify_one();
+        }
+
+        if (!batch.empty())
+        {
+            if (out)
+            {
+                out.write(reinterpret_cast<const char*>(batch.data()), (std::streamsize)(batch.size() * sizeof(BreakRecord)));
+                out.flush();
+            }
+            (out ? m_written : m_dropped).fetch_add(batch.size(), std::memory_order_relaxed);
+        }
+
+        if (stopping && m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+static std::int64_t FloorDiv(std::int64_t a, std::int64_t b)
+{
+    const std::int64_t q = a / b;
+    return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+static std::int64_t BucketOf(std::int64_t unixMs, BreakBucket bucket, std::int64_t offsetMs)
+{
+    const std::int64_t day = FloorDiv(unixMs + offsetMs, 86400000ll);
+    // 1970-01-01 是星期四，+3 让每周从星期一开始
+    return bucket == BreakBucket::Day ? day : FloorDiv(day + 3, 7);
+}
+
+void BreakLog_Aggregate(const std::uint8_t* data, size_t size, BreakBucket bucket, int utcOffsetMinutes, BreakLogSummary& out)
+{
+    out = BreakLogSummary{};
+    const std::int64_t offsetMs = (std::int64_t)utcOffsetMinutes * 60000ll;
+    const size_t count = size / sizeof(BreakRecord);
+
+    std::uint32_t cycle = 0;
+    bool cycleOpen = false;
+    bool activitySeen = false;
+    std::int64_t shownMs = 0;
+    std::int64_t fadeInDoneMs = -1;
+    size_t statsIndex = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        BreakRecord rec;
+        std::memcpy(&rec, data + i * sizeof(BreakRecord), sizeof(rec));
+        if (!BreakLog_IsValid(rec))
+        {
+            out.corrupt++;
+            continue;
+        }
+        out.records++;
+
+        if (rec.flags & BREAK_FLAG_PREVIEW)
+        {
+            continue;
+        }
+
+        const auto event = (BreakEvent)rec.event;
+        if (event == BreakEvent::Shown)
+        {
+            const std::int64_t b = BucketOf(rec.unixMs, bucket, offsetMs);
+            if (out.buckets.empty() || out.buckets.back().bucket < b)
+            {
+                out.buckets.push_back(BreakStats{});
+                out.buckets.back().bucket = b;
+                statsIndex = out.buckets.size() - 1;
+            }
+            else
+            {
+                // 系统时间被调回时才会走到这里
+                statsIndex = out.buckets.size();
+                while (statsIndex > 0 && out.buckets[statsIndex - 1].bucket > b) statsIndex--;
+                if (statsIndex == 0 || out.buckets[statsIndex - 1].bucket != b)
+                {
+                    BreakStats stats{};
+                    stats.bucket = b;
+                    out.buckets.insert(out.buckets.begin() + (std::ptrdiff_t)statsIndex, stats);
+                }
+                else
+                {
+                    statsIndex--;
+                }
+            }
+
+            out.buckets[statsIndex].reminders++;
+            cycle = rec.cycle;
+            cycleOpen = true;
+            activitySeen = false;
+            shownMs = rec.unixMs;
+            fadeInDoneMs = -1;
+            continue;
+        }
+
+        if (!cycleOpen || rec.cycle != cycle)
+        {
+            continue;
+        }
+
+        BreakStats& stats = out.buckets[statsIndex];
+        switch (event)
+        {
+        case BreakEvent::FadeInDone:
+            fadeInDoneMs = rec.unixMs;
+            break;
+        case BreakEvent::FirstActivity:
+            if (!activitySeen)
+            {
+                activitySeen = true;
+                if (fadeInDoneMs >= 0 && rec.unixMs >= fadeInDoneMs)
+                {
+                    const std::int64_t away = rec.unixMs - fadeInDoneMs;
+                    const std::uint32_t away32 = away > 0xFFFFFFFFll ? 0xFFFFFFFFu : (std::uint32_t)away;
+                    stats.awayMsTotal += away32;
+                    if (away32 > stats.awayMsMax) stats.awayMsMax = away32;
+                }
+                if (rec.unixMs >= shownMs)
+                {
+                    stats.responseMsTotal += (std::uint64_t)(rec.unixMs - shownMs);
+                }
+            }
+            break;
+        case BreakEvent::Hidden:
+            if (activitySeen) stats.completed++;
+            else stats.interrupted++;
+            cycleOpen = false;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool BreakLog_AggregateFile(const std::filesystem::path& path, BreakBucket bucket, int utcOffsetMinutes, BreakLogSummary& out)
+{
+    MappedFile file;
+    if (!file.OpenRead(path))
+    {
+        out = BreakLogSummary{};
+        return false;
+    }
+    BreakLog_Aggregate(file.data(), file.size(), bucket, utcOffsetMinutes, out);
+    return true;
+}
+
+void BreakDayCounter::Seed(std::int64_t day, std::uint32_t reminders)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_seedDay = day;
+    m_seedReminders = reminders;
+}
+
+void BreakDayCounter::OnShown(std::int64_t day)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_day != day)
+    {
+        m_day = day;
+        m_shown = 0;
+    }
+    m_shown++;
+}
+
+int BreakDayCounter::Count(std::int64_t day) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (int)((m_seedDay == day ? m_seedReminders : 0) + (m_day == day ? m_shown : 0));
+}
+
+std::uint32_t BreakLog_CountDay(const std::uint8_t* data, size_t size, std::int64_t day, int utcOffsetMinutes, std::uint32_t maxCycle)
+{
+    const std::int64_t offsetMs = (std::int64_t)utcOffsetMinutes * 60000ll;
+    std::uint32_t reminders = 0;
+    for (size_t i = size / sizeof(BreakRecord); i > 0; i--)
+    {
+        BreakRecord rec;
+        std::memcpy(&rec, data + (i - 1) * sizeof(BreakRecord), sizeof(rec));
+        if (!BreakLog_IsValid(rec) || rec.cycle > maxCycle)
+        {
+            continue;
+        }
+        const std::int64_t b = BucketOf(rec.unixMs, BreakBucket::Day, offsetMs);
+        if (b < day)
+        {
+            break;
+        }
+        if (b == day && (BreakEvent)rec.event == BreakEvent::Shown && !(rec.flags & BREAK_FLAG_PREVIEW))
+        {
+            reminders++;
+        }
+    }
+    return reminders;
+}
+
+bool BreakLog_CountDayFile(const std::filesystem::path& path, std::int64_t day, int utcOffsetMinutes, std::uint32_t maxCycle, std::uint32_t& reminders)
+{
+    reminders = 0;
+    MappedFile file;
+    if (!file.OpenRead(path))
+    {
+        return false;
+    }
+    reminders = BreakLog_CountDay(file.data(), file.size(), day, utcOffsetMinutes, maxCycle);
+    return true;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 休息记录：每次遮罩状态切换追加一条 32 字节的定长记录。
+// 每条记录自带 magic 与校验和，崩溃导致的半条记录或损坏记录在读取时被跳过。
+
+enum class BreakEvent : std::uint8_t
+{
+    Shown = 1,
+    FadeInDone = 2,
+    FirstActivity = 3,
+    Hidden = 4,
+};
+
+enum BreakFlags : std::uint16_t
+{
+    BREAK_FLAG_PREVIEW = 1 << 0,
+};
+
+struct BreakRecord
+{
+    std::uint32_t magic;
+    std::uint8_t version;
+    std::uint8_t event;
+    std::uint16_t flags;
+    std::uint32_t cycle;
+    std::uint32_t reserved;
+    std::int64_t unixMs;
+    std::uint32_t sinceShownMs;
+    std::uint32_t checksum;
+};
+static_assert(sizeof(BreakRecord) == 32, "BreakRecord must stay 32 bytes");
+
+constexpr std::uint32_t BREAK_LOG_MAGIC = 0x42525353; // "SSRB"
+constexpr std::uint8_t BREAK_LOG_VERSION = 1;
+
+std::uint32_t BreakLog_Checksum(const BreakRecord& rec);
+BreakRecord BreakLog_MakeRecord(BreakEvent event, std::uint16_t flags, std::uint32_t cycle, std::int64_t unixMs, std::uint32_t sinceShownMs);
+bool BreakLog_IsValid(const BreakRecord& rec);
+std::int64_t BreakLog_NowUnixMs();
+
+// UI 线程只把记录放入环形队列，由后台线程批量追加到文件。每条记录都是一次状态切换，不能丢：
+// 队列满时 Append 等写线程腾出空间（正常使用时每次提醒只有几条，不会等）
+
+class BreakLogWriter
+{
+public:
+    BreakLogWriter() = default;
+    ~BreakLogWriter();
+
+    BreakLogWriter(const BreakLogWriter&) = delete;
+    BreakLogWriter& operator=(const BreakLogWriter&) = delete;
+
+    bool Start(const std::filesystem::path& path);
+    void Stop();
+
+    void Append(BreakEvent event, std::uint16_t flags = 0);
+    void Append(const BreakRecord& rec);
+
+    std::uint64_t Written() const { return m_written.load(std::memory_order_relaxed); }
+    // 写线程没有运行或写文件失败而没有写出的记录
+    std::uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    // Append 因队列满而等待的次数
+    std::uint64_t Waits() const { return m_waits.load(std::memory_order_relaxed); }
+    // 最近一次提醒的周期编号（Start 时接着文件中的记录）；与 Append 在同一个线程调用
+    std::uint32_t Cycle() const { return m_cycle; }
+
+private:
+    static constexpr size_t QUEUE_CAPACITY = 256;
+
+    void SeedFromLastRecord();
+    void WriterLoop();
+
+    std::filesystem::path m_path;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::condition_variable m_spaceCv;
+    std::atomic<bool> m_stop{false};
+
+    BreakRecord m_queue[QUEUE_CAPACITY]{};
+    std::atomic<std::uint64_t> m_head{0};
+    std::atomic<std::uint64_t> m_tail{0};
+
+    std::atomic<std::uint64_t> m_written{0};
+    std::atomic<std::uint64_t> m_dropped{0};
+    std::atomic<std::uint64_t> m_waits{0};
+
+    std::uint32_t m_cycle = 0;
+    std::int64_t m_shownUnixMs = 0;
+};
+
+struct BreakStats
+{
+    std::int64_t bucket = 0;          // 自 1970-01-01 起的天数或周数（本地时间）
+    std::uint32_t reminders = 0;      // 正式提醒次数（不含预览）
+    std::uint32_t completed = 0;      // 用户活动后正常淡出的次数
+    std::uint32_t interrupted = 0;    // 未等到活动就被关闭（退出、重新预览等）
+    std::uint64_t awayMsTotal = 0;    // 淡入完成 → 首次活动：用户离开屏幕的时长
+    std::uint32_t awayMsMax = 0;
+    std::uint64_t responseMsTotal = 0; // 弹出 → 首次活动
+};
+
+enum class BreakBucket
+{
+    Day,
+    Week,
+};
+
+struct BreakLogSummary
+{
+    std::uint64_t records = 0;
+    std::uint64_t corrupt = 0;
+    std::vector<BreakStats> buckets;
+};
+
+// 今天的正式提醒次数：启动时在后台线程数出文件中今天的部分（Seed），此后只由界面线程在弹出时累加（OnShown）。
+// 两部分按周期编号分开，文件里是否已写入本进程的记录都不会重复计数
+class BreakDayCounter
+{
+public:
+    void Seed(std::int64_t day, std::uint32_t reminders);
+    void OnShown(std::int64_t day);
+    // day 这一天目前为止的次数
+    int Count(std::int64_t day) const;
+    // day 这一天再弹出一次之后的次数：预渲染的下一次提醒要显示的值（弹出落在第二天时为 1）
+    int CountWithNext(std::int64_t day) const { return Count(day) + 1; }
+
+private:
+    mutable std::mutex m_mutex;
+    std::int64_t m_seedDay = -1;
+    std::uint32_t m_seedReminders = 0;
+    std::int64_t m_day = -1;
+    std::uint32_t m_shown = 0;
+};
+
+// 从末尾往回数 day 这一天周期编号不超过 maxCycle 的正式提醒，遇到更早一天的记录即停止，只读文件末尾的几页
+std::uint32_t BreakLog_CountDay(const std::uint8_t* data, size_t size, std::int64_t day, int utcOffsetMinutes, std::uint32_t maxCycle);
+bool BreakLog_CountDayFile(const std::filesystem::path& path, std::int64_t day, int utcOffsetMinutes, std::uint32_t maxCycle, std::uint32_t& reminders);
+
+// 对映射到内存的记录做一次线性扫描；utcOffsetMinutes 用于按本地日期分组
+void BreakLog_Aggregate(const std::uint8_t* data, size_t size, BreakBucket bucket, int utcOffsetMinutes, BreakLogSummary& out);
+bool BreakLog_AggregateFile(const std::filesystem::path& path, BreakBucket bucket, int utcOffsetMinutes, BreakLogSummary& out);
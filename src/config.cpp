@@ -0,0 +1,536 @@
+#include "config.h"
+
+#include <climits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "config_schema.h"
+#include "overlay_region.h"
+#include "utf8.h"
+
+AppConfig::AppConfig()
+{
+    Config_ApplyDefaults(*this);
+}
+
+template <typename Char>
+static bool IsSpace(Char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+template <typename Char>
+static std::basic_string_view<Char> TrimView(std::basic_string_view<Char> s)
+{
+    size_t start = 0;
+    while (start < s.size() && IsSpace(s[start])) start++;
+    size_t end = s.size();
+    while (end > start && IsSpace(s[end - 1])) end--;
+    return s.substr(start, end - start);
+}
+
+template <typename Char>
+static bool TryParseHexColorT(std::basic_string_view<Char> input, ColorRef& colorOut)
+{
+    auto s = TrimView(input);
+    if (!s.empty() && s[0] == '#')
+    {
+        s.remove_prefix(1);
+    }
+    if (s.size() != 6)
+    {
+        return false;
+    }
+
+    ColorRef rgb = 0;
+    for (Char ch : s)
+    {
+        int v;
+        if (ch >= '0' && ch <= '9') v = ch - '0';
+        else if (ch >= 'a' && ch <= 'f') v = 10 + (ch - 'a');
+        else if (ch >= 'A' && ch <= 'F') v = 10 + (ch - 'A');
+        else return false;
+        rgb = (rgb << 4) | (ColorRef)v;
+    }
+    colorOut = MakeColor((int)(rgb >> 16), (int)(rgb >> 8), (int)rgb);
+    return true;
+}
+
+bool TryParseHexColor(std::wstring_view input, ColorRef& colorOut)
+{
+    return TryParseHexColorT(input, colorOut);
+}
+
+bool TryParseHexColor(std::string_view input, ColorRef& colorOut)
+{
+    return TryParseHexColorT(input, colorOut);
+}
+
+static const char kHexDigits[] = "0123456789ABCDEF";
+
+static void FormatHexColor(ColorRef c, char (&buf)[8])
+{
+    const int channels[3] = { ColorR(c), ColorG(c), ColorB(c) };
+    buf[0] = '#';
+    for (int i = 0; i < 3; i++)
+    {
+        buf[1 + i * 2] = kHexDigits[channels[i] >> 4];
+        buf[2 + i * 2] = kHexDigits[channels[i] & 0xF];
+    }
+    buf[7] = '\0';
+}
+
+std::wstring ColorToHex(ColorRef c)
+{
+    char buf[8];
+    FormatHexColor(c, buf);
+    return std::wstring(buf, buf + 7);
+}
+
+// 与 GetPrivateProfileInt 一致：可选符号 + 前导数字，其余忽略
+static bool TryParseInt(std::string_view s, int& out)
+{
+    s = TrimView(s);
+    bool negative = false;
+    if (!s.empty() && (s[0] == '-' || s[0] == '+'))
+    {
+        negative = s[0] == '-';
+        s.remove_prefix(1);
+    }
+
+    long long value = 0;
+    size_t digits = 0;
+    while (digits < s.size() && s[digits] >= '0' && s[digits] <= '9')
+    {
+        if (value < INT_MAX)
+        {
+            value = value * 10 + (s[digits] - '0');
+        }
+        digits++;
+    }
+    if (digits == 0)
+    {
+        return false;
+    }
+
+    if (negative) value = -value;
+    out = value > INT_MAX ? INT_MAX : (value < INT_MIN ? INT_MIN : (int)value);
+    return true;
+}
+
+// 与 GetPrivateProfile* 一致：节名与键名不区分大小写（只比较 ASCII）
+static bool KeyEquals(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        char x = a[i];
+        char y = b[i];
+        if (x >= 'A' && x <= 'Z') x = (char)(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = (char)(y - 'A' + 'a');
+        if (x != y)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void AppendInt(std::string& out, int value)
+{
+    char buf[16];
+    char* p = buf + sizeof(buf);
+    unsigned v = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+    do
+    {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    if (value < 0) *--p = '-';
+    out.append(p, (size_t)(buf + sizeof(buf) - p));
+}
+
+// 空路径表示不播放动画
+static bool HasAnimationExtension(std::wstring_view path)
+{
+    if (path.empty())
+    {
+        return true;
+    }
+    const size_t dot = path.find_last_of(L'.');
+    if (dot == std::wstring_view::npos)
+    {
+        return false;
+    }
+    std::wstring ext(path.substr(dot + 1));
+    for (wchar_t& ch : ext)
+    {
+        if (ch >= L'A' && ch <= L'Z') ch = (wchar_t)(ch - L'A' + L'a');
+    }
+    return ext == L"gif" || ext == L"png" || ext == L"apng";
+}
+
+static void ApplyDefault(const IntField& f, AppConfig& cfg) { cfg.*f.member = f.defaultValue; }
+static void ApplyDefault(const BoolField& f, AppConfig& cfg) { cfg.*f.member = f.defaultValue; }
+static void ApplyDefault(const ColorField& f, AppConfig& cfg) { cfg.*f.member = f.defaultValue; }
+static void ApplyDefault(const ChoiceField& f, AppConfig& cfg) { cfg.*f.member = f.defaultValue; }
+static void ApplyDefault(const TextField& f, AppConfig& cfg) { cfg.*f.member = f.defaultValue; }
+static void ApplyDefault(const RegionField& f, AppConfig& cfg) { cfg.*f.member = f.defaultValue; }
+static void ApplyDefault(const PathField& f, AppConfig& cfg) { cfg.*f.member = f.defaultValue; }
+
+static void NormalizeField(const IntField& f, AppConfig& cfg) { cfg.*f.member = Config_Clamp(f, cfg.*f.member); }
+static void NormalizeField(const BoolField&, AppConfig&) {}
+static void NormalizeField(const ColorField& f, AppConfig& cfg) { cfg.*f.member &= 0x00FFFFFFu; }
+static void NormalizeField(const ChoiceField& f, AppConfig& cfg)
+{
+    if (cfg.*f.member < 0 || cfg.*f.member >= f.count) cfg.*f.member = f.defaultValue;
+}
+static void NormalizeField(const TextField& f, AppConfig& cfg)
+{
+    auto& text = cfg.*f.member;
+    if (text.size() > (size_t)f.maxLength) text.resize((size_t)f.maxLength);
+}
+static void NormalizeField(const RegionField& f, AppConfig& cfg)
+{
+    // 写错的规则整体作废，遮罩回到整屏显示
+    std::vector<OverlayRegionRule> rules;
+    auto& spec = cfg.*f.member;
+    if (spec.size() > (size_t)f.maxLength || !OverlayRegion_Parse(spec, rules)) spec = f.defaultValue;
+}
+static void NormalizeField(const PathField& f, AppConfig& cfg)
+{
+    auto& path = cfg.*f.member;
+    if (path.size() > (size_t)f.maxLength || !HasAnimationExtension(path)) path = f.defaultValue;
+}
+
+static bool ValidateField(const IntField& f, const AppConfig& cfg, std::wstring& error)
+{
+    if (Config_InRange(f, cfg.*f.member)) return true;
+    error = f.rangeError;
+    return false;
+}
+static bool ValidateField(const BoolField&, const AppConfig&, std::wstring&) { return true; }
+static bool ValidateField(const ColorField&, const AppConfig&, std::wstring&) { return true; }
+static bool ValidateField(const ChoiceField& f, const AppConfig& cfg, std::wstring& error)
+{
+    if (cfg.*f.member >= 0 && cfg.*f.member < f.count) return true;
+    error = std::wstring(f.label) + L"选项无效。";
+    return false;
+}
+static bool ValidateField(const TextField&, const AppConfig&, std::wstring&) { return true; }
+static bool ValidateField(const RegionField& f, const AppConfig& cfg, std::wstring& error)
+{
+    if ((cfg.*f.member).size() > (size_t)f.maxLength)
+    {
+        error = std::wstring(f.label) + L"规则过长。";
+        return false;
+    }
+    std::vector<OverlayRegionRule> rules;
+    return OverlayRegion_Parse(cfg.*f.member, rules, &error);
+}
+static bool ValidateField(const PathField& f, const AppConfig& cfg, std::wstring& error)
+{
+    const auto& path = cfg.*f.member;
+    if (path.size() > (size_t)f.maxLength)
+    {
+        error = std::wstring(f.label) + L"路径过长。";
+        return false;
+    }
+    if (!HasAnimationExtension(path))
+    {
+        error = std::wstring(f.label) + L"只支持 .gif、.png 与 .apng。";
+        return false;
+    }
+    return true;
+}
+
+static void ParseField(const IntField& f, std::string_view value, AppConfig& cfg)
+{
+    int v = 0;
+    if (TryParseInt(value, v)) cfg.*f.member = v;
+}
+static void ParseField(const BoolField& f, std::string_view value, AppConfig& cfg)
+{
+    int v = 0;
+    if (TryParseInt(value, v)) cfg.*f.member = v != 0;
+}
+static void ParseField(const ColorField& f, std::string_view value, AppConfig& cfg)
+{
+    ColorRef c{};
+    if (TryParseHexColor(value, c)) cfg.*f.member = c;
+}
+static void ParseField(const ChoiceField& f, std::string_view value, AppConfig& cfg)
+{
+    value = TrimView(value);
+    for (int i = 0; i < f.count; i++)
+    {
+        if (value == f.names[i])
+        {
+            cfg.*f.member = i;
+            return;
+        }
+    }
+    int v = 0;
+    if (TryParseInt(value, v) && v >= 0 && v < f.count) cfg.*f.member = v;
+}
+static void ParseField(const TextField& f, std::string_view value, AppConfig& cfg)
+{
+    Utf8ToWide(TrimView(value), cfg.*f.member);
+}
+static void ParseField(const RegionField& f, std::string_view value, AppConfig& cfg)
+{
+    cfg.*f.member = TrimView(value);
+}
+static void ParseField(const PathField& f, std::string_view value, AppConfig& cfg)
+{
+    Utf8ToWide(TrimView(value), cfg.*f.member);
+}
+
+static void SerializeField(const IntField& f, const AppConfig& cfg, std::string& out)
+{
+    out.append(f.key).push_back('=');
+    AppendInt(out, cfg.*f.member);
+    out.append("\r\n");
+}
+static void SerializeField(const BoolField& f, const AppConfig& cfg, std::string& out)
+{
+    out.append(f.key).append(cfg.*f.member ? "=1\r\n" : "=0\r\n");
+}
+static void SerializeField(const ColorField& f, const AppConfig& cfg, std::string& out)
+{
+    char buf[8];
+    FormatHexColor(cfg.*f.member, buf);
+    out.append(f.key).push_back('=');
+    out.append(buf, 7).append("\r\n");
+}
+static void SerializeField(const ChoiceField& f, const AppConfig& cfg, std::string& out)
+{
+    const int v = cfg.*f.member;
+    out.append(f.key).push_back('=');
+    out.append(v >= 0 && v < f.count ? f.names[v] : f.names[f.defaultValue]).append("\r\n");
+}
+static void SerializeField(const TextField&, const AppConfig&, std::string&) {}
+static void SerializeField(const RegionField& f, const AppConfig& cfg, std::string& out)
+{
+    out.append(f.key).push_back('=');
+    out.append(cfg.*f.member).append("\r\n");
+}
+static void SerializeField(const PathField& f, const AppConfig& cfg, std::string& out)
+{
+    out.append(f.key).push_back('=');
+    out.append(WideToUtf8(cfg.*f.member)).append("\r\n");
+}
+
+void Config_ApplyDefaults(AppConfig& cfg)
+{
+    Config_ForEachField([&](const auto& field) { ApplyDefault(field, cfg); });
+}
+
+void Config_Normalize(AppConfig& cfg)
+{
+    Config_ForEachField([&](const auto& field) { NormalizeField(field, cfg); });
+}
+
+bool Config_Validate(const AppConfig& cfg, std::wstring& error)
+{
+    return Config_AllFields([&](const auto& field) { return ValidateField(field, cfg, error); });
+}
+
+template <typename Fn>
+static void ForEachIndexedField(Fn&& fn)
+{
+    int index = 0;
+    Config_ForEachField([&](const auto& field) { fn(field, index++); });
+}
+
+int Config_FieldIndex(std::string_view key)
+{
+    int found = -1;
+    ForEachIndexedField([&](const auto& field, int index)
+    {
+        if (found < 0 && KeyEquals(key, field.key)) found = index;
+    });
+    return found;
+}
+
+const char* Config_FieldKey(int index)
+{
+    const char* key = "";
+    ForEachIndexedField([&](const auto& field, int i)
+    {
+        if (i == index) key = field.key;
+    });
+    return key;
+}
+
+static void ParseLimit(std::string_view key, std::string_view value, ConfigPolicy& policy)
+{
+    const bool isMin = key.size() > 3 && KeyEquals(key.substr(key.size() - 3), "Min");
+    const bool isMax = key.size() > 3 && KeyEquals(key.substr(key.size() - 3), "Max");
+    int v = 0;
+    if ((!isMin && !isMax) || !TryParseInt(value, v))
+    {
+        return;
+    }
+    const auto name = key.substr(0, key.size() - 3);
+    ForEachIndexedField([&](const auto& field, int index)
+    {
+        if constexpr (std::is_same_v<std::decay_t<decltype(field)>, IntField>)
+        {
+            if (!KeyEquals(name, field.key)) return;
+            (isMin ? policy.minValue[index] : policy.maxValue[index]) = Config_Clamp(field, v);
+            (isMin ? policy.minLimited : policy.maxLimited) |= Config_FieldBit(index);
+        }
+    });
+}
+
+// 策略对整数项的有效范围：没有限制的一端取字段本身的范围
+static void PolicyRange(const IntField& field, const ConfigPolicy& policy, int index, int& lo, int& hi)
+{
+    lo = (policy.minLimited & Config_FieldBit(index)) ? policy.minValue[index] : field.minValue;
+    hi = (policy.maxLimited & Config_FieldBit(index)) ? policy.maxValue[index] : field.maxValue;
+}
+
+std::uint32_t Config_ParseIniLayer(std::string_view ini, AppConfig& cfg, ConfigPolicy* policy)
+{
+    if (ini.size() >= 3 && ini.substr(0, 3) == "\xEF\xBB\xBF")
+    {
+        ini.remove_prefix(3);
+    }
+
+    enum class Section { Other, General, Locked, Limits };
+    Section section = Section::Other;
+    std::uint32_t present = 0;
+    while (!ini.empty())
+    {
+        const size_t eol = ini.find('\n');
+        auto line = TrimView(ini.substr(0, eol));
+        ini.remove_prefix(eol == std::string_view::npos ? ini.size() : eol + 1);
+
+        if (line.empty() || line[0] == ';' || line[0] == '#')
+        {
+            continue;
+        }
+        if (line.front() == '[')
+        {
+            const auto name = line.size() >= 2 && line.back() == ']' ? TrimView(line.substr(1, line.size() - 2)) : std::string_view{};
+            section = KeyEquals(name, kConfigSection) ? Section::General
+                : (policy && KeyEquals(name, kConfigLockedSection)) ? Section::Locked
+                : (policy && KeyEquals(name, kConfigLimitsSection)) ? Section::Limits
+                : Section::Other;
+            continue;
+        }
+        if (section == Section::Other)
+        {
+            continue;
+        }
+
+        const size_t eq = line.find('=');
+        if (eq == std::string_view::npos)
+        {
+            continue;
+        }
+        const auto key = TrimView(line.substr(0, eq));
+        const auto value = line.substr(eq + 1);
+
+        if (section == Section::Limits)
+        {
+            ParseLimit(key, value, *policy);
+            continue;
+        }
+        const int index = Config_FieldIndex(key);
+        if (index < 0)
+        {
+            continue;
+        }
+        if (section == Section::Locked)
+        {
+            int v = 0;
+            if (TryParseInt(value, v))
+            {
+                policy->locked = v != 0 ? policy->locked | Config_FieldBit(index) : policy->locked & ~Config_FieldBit(index);
+            }
+            continue;
+        }
+        // 同一个键出现多次时与 GetPrivateProfile* 一样取第一个
+        if (present & Config_FieldBit(index))
+        {
+            continue;
+        }
+        ForEachIndexedField([&](const auto& field, int i)
+        {
+            if (i == index) ParseField(field, value, cfg);
+        });
+        present |= Config_FieldBit(index);
+    }
+    if (policy)
+    {
+        // 上下限写反时交换：否则合并后的范围为空，之后的每次保存都会被 Config_CheckPolicy 拒绝
+        const std::uint32_t both = policy->minLimited & policy->maxLimited;
+        for (int i = 0; i < CONFIG_FIELD_COUNT; i++)
+        {
+            if ((both & Config_FieldBit(i)) && policy->minValue[i] > policy->maxValue[i])
+            {
+                std::swap(policy->minValue[i], policy->maxValue[i]);
+                policy->inverted |= Config_FieldBit(i);
+            }
+        }
+    }
+    return present;
+}
+
+void Config_ParseIni(std::string_view ini, AppConfig& cfg)
+{
+    Config_ParseIniLayer(ini, cfg, nullptr);
+}
+
+void Config_SerializeIni(const AppConfig& cfg, std::string& out, std::uint32_t skip)
+{
+    out.clear();
+    out.append("[").append(kConfigSection).append("]\r\n");
+    ForEachIndexedField([&](const auto& field, int index)
+    {
+        if (!(skip & Config_FieldBit(index))) SerializeField(field, cfg, out);
+    });
+}
+
+void Config_ApplyPolicyLimits(const ConfigPolicy& policy, AppConfig& cfg)
+{
+    ForEachIndexedField([&](const auto& field, int index)
+    {
+        if constexpr (std::is_same_v<std::decay_t<decltype(field)>, IntField>)
+        {
+            if (!((policy.minLimited | policy.maxLimited) & Config_FieldBit(index))) return;
+            int lo = 0;
+            int hi = 0;
+            PolicyRange(field, policy, index, lo, hi);
+            int& v = cfg.*field.member;
+            v = v < lo ? lo : (v > hi ? hi : v);
+        }
+    });
+}
+
+bool Config_CheckPolicy(const ConfigPolicy& policy, const AppConfig& cfg, std::wstring& error)
+{
+    bool ok = true;
+    ForEachIndexedField([&](const auto& field, int index)
+    {
+        if constexpr (std::is_same_v<std::decay_t<decltype(field)>, IntField>)
+        {
+            if (!ok || !((policy.minLimited | policy.maxLimited) & Config_FieldBit(index))) return;
+            int lo = 0;
+            int hi = 0;
+            PolicyRange(field, policy, index, lo, hi);
+            const int v = cfg.*field.member;
+            if (v >= lo && v <= hi) return;
+            error = std::wstring(field.label) + L"受管理员策略限制，必须在 " + std::to_wstring(lo) +
+                L"-" + std::to_wstring(hi) + L" 之间。";
+            ok = false;
+        }
+    });
+    return ok;
+}
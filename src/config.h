@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 与 Win32 COLORREF 相同的布局：0x00BBGGRR
+using ColorRef = std::uint32_t;
+
+constexpr ColorRef MakeColor(int r, int g, int b)
+{
+    return (ColorRef)(r & 0xFF) | ((ColorRef)(g & 0xFF) << 8) | ((ColorRef)(b & 0xFF) << 16);
+}
+
+constexpr int ColorR(ColorRef c) { return (int)(c & 0xFF); }
+constexpr int ColorG(ColorRef c) { return (int)((c >> 8) & 0xFF); }
+constexpr int ColorB(ColorRef c) { return (int)((c >> 16) & 0xFF); }
+
+constexpr int TEXT_MAX_LEN = 500;
+
+// 字段的默认值、范围与 ini 键名统一定义在 config_schema.h 中
+struct AppConfig
+{
+    AppConfig();
+
+    int intervalMinutes;
+    int opacityPercent;
+    int fadeSeconds;
+    ColorRef bgColor;
+    bool autoStart;
+    int fullscreenMode;   // FullscreenMode
+    std::wstring text;
+    std::string overlayRegions;   // 见 overlay_region.h
+    std::wstring animation;       // GIF/APNG 文件，相对路径相对配置文件所在目录；为空时显示文字
+};
+
+void Config_ApplyDefaults(AppConfig& cfg);
+void Config_Normalize(AppConfig& cfg);
+bool Config_Validate(const AppConfig& cfg, std::wstring& error);
+
+// 管理员策略（见 config_layers.h）：锁定的键用户不能修改，整数键还可以收窄范围。
+// 各掩码按 kConfigFields 中的序号置位
+constexpr int CONFIG_MAX_FIELDS = 16;
+
+struct ConfigPolicy
+{
+    std::uint32_t locked = 0;
+    // 下限与上限分别记录：只写了 键Min= 的字段上限仍是字段本身的上限
+    std::uint32_t minLimited = 0;
+    std::uint32_t maxLimited = 0;
+    // 同一个文件中 键Min= 大于 键Max= 的字段：解析时已交换上下限，留待报告
+    std::uint32_t inverted = 0;
+    int minValue[CONFIG_MAX_FIELDS]{};
+    int maxValue[CONFIG_MAX_FIELDS]{};
+};
+
+// 只覆盖 ini 中出现的键；不分配内存（Text、OverlayRegions、Animation 键除外）。
+// 与 GetPrivateProfile* 相同：节名与键名不区分大小写，同一个键出现多次时取第一个，不认识的键忽略
+void Config_ParseIni(std::string_view ini, AppConfig& cfg);
+// 同上，返回 [General] 中出现过的键；policy 非空时同时读取 [Locked]（键=1）与 [Limits]（键Min=、键Max=）
+std::uint32_t Config_ParseIniLayer(std::string_view ini, AppConfig& cfg, ConfigPolicy* policy);
+// skip 中的键不写出：被策略锁定的键不保存到用户文件
+void Config_SerializeIni(const AppConfig& cfg, std::string& out, std::uint32_t skip = 0);
+
+// 不区分大小写；找不到时返回 -1
+int Config_FieldIndex(std::string_view key);
+const char* Config_FieldKey(int index);
+void Config_ApplyPolicyLimits(const ConfigPolicy& policy, AppConfig& cfg);
+bool Config_CheckPolicy(const ConfigPolicy& policy, const AppConfig& cfg, std::wstring& error);
+
+bool TryParseHexColor(std::wstring_view input, ColorRef& colorOut);
+bool TryParseHexColor(std::string_view input, ColorRef& colorOut);
+std::wstring ColorToHex(ColorRef c);
@@ -0,0 +1,421 @@
+#include "config_layers.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#include "config_schema.h"
+#include "utf8.h"
+
+namespace
+{
+    constexpr std::uint32_t CONFIG_CACHE_MAGIC = 0x4C525353;   // "SSRL"
+    constexpr std::uint32_t CONFIG_CACHE_VERSION = 2;
+    constexpr std::uint64_t CONFIG_LAYER_MAX_BYTES = 16ull * 1024 * 1024;
+    constexpr std::uint32_t CONFIG_ALL_FIELDS = (std::uint32_t)((1ull << CONFIG_FIELD_COUNT) - 1);
+
+    bool IsPolicy(ConfigLayerKind kind)
+    {
+        return kind == ConfigLayerKind::PolicyIni || kind == ConfigLayerKind::PolicyText;
+    }
+
+    bool IsText(ConfigLayerKind kind)
+    {
+        return kind == ConfigLayerKind::PolicyText || kind == ConfigLayerKind::UserText;
+    }
+
+    bool ReadBytes(const std::filesystem::path& path, std::uint64_t size, std::string& out)
+    {
+        out.clear();
+        if (size > CONFIG_LAYER_MAX_BYTES)
+        {
+            return false;
+        }
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            return false;
+        }
+        out.resize((size_t)size);
+        in.read(out.data(), (std::streamsize)out.size());
+        out.resize((size_t)in.gcount());
+        return true;
+    }
+
+    template <typename Fn>
+    void ForEachIndexedField(Fn&& fn)
+    {
+        int index = 0;
+        Config_ForEachField([&](const auto& field) { fn(field, index++); });
+    }
+
+    // 把 from 中 mask 置位的字段复制到 to
+    void CopyFields(const AppConfig& from, std::uint32_t mask, AppConfig& to)
+    {
+        ForEachIndexedField([&](const auto& field, int index)
+        {
+            if (mask & Config_FieldBit(index)) to.*field.member = from.*field.member;
+        });
+    }
+
+    template <typename T>
+    void Put(std::string& out, const T& value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void PutString(std::string& out, std::string_view s)
+    {
+        Put(out, (std::uint32_t)s.size());
+        out.append(s);
+    }
+
+    struct Reader
+    {
+        std::string_view data;
+        bool ok = true;
+
+        template <typename T>
+        T Get()
+        {
+            T value{};
+            if (data.size() < sizeof(T))
+            {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, data.data(), sizeof(T));
+            data.remove_prefix(sizeof(T));
+            return value;
+        }
+
+        std::string_view GetString()
+        {
+            const std::uint32_t n = Get<std::uint32_t>();
+            if (!ok || data.size() < n)
+            {
+                ok = false;
+                return {};
+            }
+            const auto s = data.substr(0, n);
+            data.remove_prefix(n);
+            return s;
+        }
+    };
+}
+
+std::uint64_t ConfigLayer_Hash(std::string_view bytes)
+{
+    // FNV-1a 的变体，每次混入 8 字节：策略文件可能有几 MB，逐字节计算的耗时接近直接解析
+    std::uint64_t h = 0xCBF29CE484222325ull ^ bytes.size();
+    size_t i = 0;
+    for (; i + 8 <= bytes.size(); i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes.data() + i, sizeof(word));
+        h = (h ^ word) * 0x100000001B3ull;
+        h ^= h >> 29;
+    }
+    for (; i < bytes.size(); i++)
+    {
+        h = (h ^ (unsigned char)bytes[i]) * 0x100000001B3ull;
+    }
+    return h;
+}
+
+void LayeredConfig::SetSources(const std::filesystem::path& policyDir, const std::filesystem::path& userIni, const std::filesystem::path& userText)
+{
+    m_policyDir = policyDir;
+    m_userIni = userIni;
+    m_userText = userText;
+}
+
+bool LayeredConfig::ListLayers(std::vector<Layer>& out)
+{
+    out.clear();
+    auto add = [&](ConfigLayerKind kind, std::filesystem::path path)
+    {
+        Layer layer;
+        layer.kind = kind;
+        layer.path = std::move(path);
+        out.push_back(std::move(layer));
+    };
+    std::error_code ec;
+    if (!m_policyDir.empty() && std::filesystem::is_directory(m_policyDir, ec))
+    {
+        std::vector<std::filesystem::path> inis;
+        for (std::filesystem::directory_iterator it(m_policyDir, ec), end; !ec && it != end; it.increment(ec))
+        {
+            if (it->path().extension() == ".ini")
+            {
+                inis.push_back(it->path());
+            }
+        }
+        std::sort(inis.begin(), inis.end());
+        for (const auto& path : inis)
+        {
+            add(ConfigLayerKind::PolicyIni, path);
+        }
+        add(ConfigLayerKind::PolicyText, m_policyDir / "text.txt");
+    }
+    add(ConfigLayerKind::UserIni, m_userIni);
+    add(ConfigLayerKind::UserText, m_userText);
+
+    bool changed = out.size() != m_layers.size();
+    for (size_t i = 0; !changed && i < out.size(); i++)
+    {
+        changed = m_layers[i].kind != out[i].kind || m_layers[i].path != out[i].path;
+    }
+
+    // 沿用上次的解析结果
+    for (Layer& layer : out)
+    {
+        for (Layer& old : m_layers)
+        {
+            if (old.kind == layer.kind && old.path == layer.path)
+            {
+                layer = std::move(old);
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+bool LayeredConfig::Refresh(Layer& layer)
+{
+    std::error_code ec;
+    ConfigFileStamp stamp;
+    stamp.exists = std::filesystem::is_regular_file(layer.path, ec);
+    if (stamp.exists)
+    {
+        stamp.size = std::filesystem::file_size(layer.path, ec);
+        stamp.mtime = (std::int64_t)std::filesystem::last_write_time(layer.path, ec).time_since_epoch().count();
+    }
+    // 从读取失败中恢复时总要重新合并，以便撤销锁定与问题报告
+    const bool recovered = layer.failed;
+    if (!stamp.exists)
+    {
+        const bool changed = !layer.valid || layer.stamp.exists || recovered;
+        layer.failed = false;
+        layer.stamp = stamp;
+        layer.valid = true;
+        layer.present = 0;
+        layer.policy = ConfigPolicy{};
+        m_stats.skipped++;
+        return changed;
+    }
+    if (layer.valid && !layer.failed && layer.stamp.exists && stamp.size == layer.stamp.size && stamp.mtime == layer.stamp.mtime)
+    {
+        m_stats.skipped++;
+        return false;
+    }
+
+    std::string bytes;
+    if (!ReadBytes(layer.path, stamp.size, bytes))
+    {
+        // 读不到（被占用、过大）时保留上次的结果；Merge 据 failed 报告问题，策略层从未读到过时锁定全部键
+        layer.failed = true;
+        return !recovered;
+    }
+    layer.failed = false;
+    stamp.size = bytes.size();
+    stamp.hash = ConfigLayer_Hash(bytes);
+    if (layer.valid && layer.stamp.exists && stamp.hash == layer.stamp.hash && stamp.size == layer.stamp.size)
+    {
+        layer.stamp = stamp;
+        m_stats.hashed++;
+        return recovered;
+    }
+
+    layer.stamp = stamp;
+    layer.valid = true;
+    layer.values = AppConfig{};
+    layer.policy = ConfigPolicy{};
+    layer.present = 0;
+    if (IsText(layer.kind))
+    {
+        // 与旧版本一致：空文件视为没有设置文字
+        if (!bytes.empty())
+        {
+            Utf8ToWide(bytes, layer.values.text);
+            layer.present = Config_FieldBit(Config_FieldIndex(kFieldText.key));
+        }
+    }
+    else
+    {
+        // 旧版本由 WritePrivateProfileStringW 创建的文件可能是 UTF-16
+        if (bytes.size() >= 2 && (unsigned char)bytes[0] == 0xFF && (unsigned char)bytes[1] == 0xFE)
+        {
+            bytes = Utf16LeToUtf8(std::string_view(bytes).substr(2));
+        }
+        layer.present = Config_ParseIniLayer(bytes, layer.values, layer.kind == ConfigLayerKind::PolicyIni ? &layer.policy : nullptr);
+    }
+    m_stats.parsed++;
+    return true;
+}
+
+void LayeredConfig::Merge()
+{
+    m_merged = AppConfig{};
+    m_policy = ConfigPolicy{};
+    m_problems.clear();
+    for (const Layer& layer : m_layers)
+    {
+        if (IsPolicy(layer.kind) && layer.failed)
+        {
+            // 失败时不放开：沿用上次读到的内容，从未读到过的策略文件可能锁定任何键，于是全部锁定
+            m_problems.push_back(layer.path.u8string() + (layer.valid ? ": unreadable, keeping the last policy read" : ": unreadable, all settings locked"));
+            if (!layer.valid)
+            {
+                m_policy.locked |= CONFIG_ALL_FIELDS;
+            }
+        }
+        if (IsPolicy(layer.kind))
+        {
+            // 后面的策略文件覆盖前面的取值与范围（上下限各自覆盖），锁定取并集
+            CopyFields(layer.values, layer.present, m_merged);
+            m_policy.locked |= layer.policy.locked;
+            for (int i = 0; i < CONFIG_FIELD_COUNT; i++)
+            {
+                const std::uint32_t bit = Config_FieldBit(i);
+                const std::string key = Config_FieldKey(i);
+                if (layer.policy.inverted & bit)
+                {
+                    m_problems.push_back(layer.path.u8string() + ": " + key + "Min is above " + key + "Max, bounds swapped");
+                }
+                if (layer.policy.minLimited & bit)
+                {
+                    m_policy.minValue[i] = layer.policy.minValue[i];
+                }
+                if (layer.policy.maxLimited & bit)
+                {
+                    m_policy.maxValue[i] = layer.policy.maxValue[i];
+                }
+                m_policy.minLimited |= layer.policy.minLimited & bit;
+                m_policy.maxLimited |= layer.policy.maxLimited & bit;
+                // 与前面文件的另一端冲突时以这个文件为准，范围收成一个值
+                if ((m_policy.minLimited & m_policy.maxLimited & bit) && m_policy.minValue[i] > m_policy.maxValue[i])
+                {
+                    int& other = (layer.policy.maxLimited & bit) ? m_policy.minValue[i] : m_policy.maxValue[i];
+                    other = (layer.policy.maxLimited & bit) ? m_policy.maxValue[i] : m_policy.minValue[i];
+                    m_problems.push_back(layer.path.u8string() + ": " + key + " limit conflicts with an earlier policy file, range narrowed to " +
+                        std::to_string(other));
+                }
+            }
+        }
+        else
+        {
+            CopyFields(layer.values, layer.present & ~m_policy.locked, m_merged);
+        }
+    }
+    Config_Normalize(m_merged);
+    Config_ApplyPolicyLimits(m_policy, m_merged);
+    m_stats.merges++;
+}
+
+bool LayeredConfig::Load()
+{
+    m_stats.loads++;
+    std::vector<Layer> layers;
+    bool changed = ListLayers(layers);
+    for (Layer& layer : layers)
+    {
+        changed |= Refresh(layer);
+    }
+    m_layers = std::move(layers);
+    if (changed || m_stats.merges == 0)
+    {
+        Merge();
+    }
+    return changed;
+}
+
+bool LayeredConfig::SaveCache(const std::filesystem::path& path) const
+{
+    std::string out;
+    Put(out, CONFIG_CACHE_MAGIC);
+    Put(out, CONFIG_CACHE_VERSION);
+    // 第一次读取就失败的层不写出，头里的层数只算写出的
+    std::uint32_t count = 0;
+    for (const Layer& layer : m_layers)
+    {
+        count += layer.valid ? 1 : 0;
+    }
+    Put(out, count);
+    std::string ini;
+    for (const Layer& layer : m_layers)
+    {
+        if (!layer.valid)
+        {
+            continue;
+        }
+        Put(out, (std::uint8_t)layer.kind);
+        Put(out, (std::uint8_t)(layer.stamp.exists ? 1 : 0));
+        Put(out, layer.present);
+        Put(out, layer.stamp.size);
+        Put(out, layer.stamp.mtime);
+        Put(out, layer.stamp.hash);
+        Put(out, layer.policy);
+        PutString(out, layer.path.u8string());
+        Config_SerializeIni(layer.values, ini);
+        PutString(out, ini);
+        PutString(out, WideToUtf8(layer.values.text));
+    }
+
+    std::error_code ec;
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        file.write(out.data(), (std::streamsize)out.size());
+        if (!file)
+        {
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+bool LayeredConfig::LoadCache(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    Reader r{ bytes };
+    if (r.Get<std::uint32_t>() != CONFIG_CACHE_MAGIC || r.Get<std::uint32_t>() != CONFIG_CACHE_VERSION)
+    {
+        return false;
+    }
+    const std::uint32_t count = r.Get<std::uint32_t>();
+    std::vector<Layer> layers;
+    for (std::uint32_t i = 0; i < count && r.ok; i++)
+    {
+        Layer layer;
+        layer.kind = (ConfigLayerKind)r.Get<std::uint8_t>();
+        layer.stamp.exists = r.Get<std::uint8_t>() != 0;
+        layer.present = r.Get<std::uint32_t>();
+        layer.stamp.size = r.Get<std::uint64_t>();
+        layer.stamp.mtime = r.Get<std::int64_t>();
+        layer.stamp.hash = r.Get<std::uint64_t>();
+        layer.policy = r.Get<ConfigPolicy>();
+        layer.path = std::filesystem::u8path(r.GetString());
+        Config_ParseIni(r.GetString(), layer.values);
+        Utf8ToWide(r.GetString(), layer.values.text);
+        layer.valid = true;
+        layers.push_back(std::move(layer));
+    }
+    if (!r.ok)
+    {
+        return false;
+    }
+    // 来源与当前设置不同的条目在下一次 Load 时丢弃
+    m_layers = std::move(layers);
+    return true;
+}
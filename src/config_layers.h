@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+// 分层设置：内置默认值 → 机器策略目录（IT 统一下发、用户只读）→ 用户的 config.ini 与 text.txt。
+// 策略目录中的 *.ini 按文件名顺序叠加，text.txt 提供文字；策略可以锁定键（用户层对该键的
+// 设置被忽略），也可以收窄整数键的范围。策略文件读不到时沿用上次读到的内容，从未读到过则锁定全部键。
+// 每层的解析结果按 (大小, 修改时间, 内容哈希) 缓存：大小与时间都没变时不读文件；
+// 只有时间变了时读取并比较哈希，内容没变就不重新解析。缓存可以写到磁盘，下次启动沿用。
+
+enum class ConfigLayerKind : std::uint8_t
+{
+    PolicyIni = 1,
+    PolicyText = 2,
+    UserIni = 3,
+    UserText = 4,
+};
+
+struct ConfigFileStamp
+{
+    bool exists = false;
+    std::uint64_t size = 0;
+    std::int64_t mtime = 0;
+    std::uint64_t hash = 0;
+};
+
+struct ConfigLayerStats
+{
+    std::uint64_t loads = 0;
+    std::uint64_t parsed = 0;     // 读取并解析
+    std::uint64_t hashed = 0;     // 时间变了但内容没变，只读取并计算哈希
+    std::uint64_t skipped = 0;    // 大小与时间都没变，没有读取
+    std::uint64_t merges = 0;
+};
+
+class LayeredConfig
+{
+public:
+    // policyDir 为空或不存在时没有策略层
+    void SetSources(const std::filesystem::path& policyDir, const std::filesystem::path& userIni, const std::filesystem::path& userText);
+
+    // 重新检查各层，有变化时重新合并；返回是否有层变化（需要重新保存缓存）
+    bool Load();
+
+    const AppConfig& Merged() const { return m_merged; }
+    const ConfigPolicy& Policy() const { return m_policy; }
+    std::uint32_t Locked() const { return m_policy.locked; }
+    const ConfigLayerStats& Stats() const { return m_stats; }
+    size_t LayerCount() const { return m_layers.size(); }
+    // 最近一次合并时策略文件的问题（读不到、上下限写反等），每条形如 "<文件>: <说明>"，供日志与 metrics 使用
+    const std::vector<std::string>& Problems() const { return m_problems; }
+
+    // 缓存文件不存在、格式不对或来源不同时忽略，之后的 Load 照常解析
+    bool LoadCache(const std::filesystem::path& path);
+    bool SaveCache(const std::filesystem::path& path) const;
+
+private:
+    struct Layer
+    {
+        ConfigLayerKind kind = ConfigLayerKind::UserIni;
+        std::filesystem::path path;
+        ConfigFileStamp stamp;
+        bool valid = false;             // 已按 stamp 解析
+        bool failed = false;            // 最近一次读取失败（过大、读不到）；valid 时沿用上次的结果
+        std::uint32_t present = 0;
+        AppConfig values;
+        ConfigPolicy policy;
+    };
+
+    // 返回层的列表（策略文件的增删）是否变化
+    bool ListLayers(std::vector<Layer>& out);
+    bool Refresh(Layer& layer);
+    void Merge();
+
+    std::filesystem::path m_policyDir;
+    std::filesystem::path m_userIni;
+    std::filesystem::path m_userText;
+    std::vector<Layer> m_layers;
+    AppConfig m_merged;
+    ConfigPolicy m_policy;
+    std::vector<std::string> m_problems;
+    ConfigLayerStats m_stats;
+};
+
+std::uint64_t ConfigLayer_Hash(std::string_view bytes);
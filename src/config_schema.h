@@ -0,0 +1,159 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+
+#include "config.h"
+#include "resource.h"
+
+enum class ConfigUnit : int
+{
+    None = 0,
+    Minutes = 1,
+    Seconds = 2,
+    Percent = 3,
+};
+
+struct IntField
+{
+    const char* key;
+    int AppConfig::* member;
+    int defaultValue;
+    int minValue;
+    int maxValue;
+    ConfigUnit unit;
+    const wchar_t* label;
+    const wchar_t* rangeError;
+    int controlId;
+    int buddyControlId;
+};
+
+struct BoolField
+{
+    const char* key;
+    bool AppConfig::* member;
+    bool defaultValue;
+    const wchar_t* label;
+    int controlId;
+};
+
+struct ColorField
+{
+    const char* key;
+    ColorRef AppConfig::* member;
+    ColorRef defaultValue;
+    const wchar_t* label;
+    const wchar_t* formatError;
+    int controlId;
+};
+
+// 从固定选项中选一个；ini 中保存选项名，也接受序号
+struct ChoiceField
+{
+    const char* key;
+    int AppConfig::* member;
+    int defaultValue;
+    const char* const* names;
+    const wchar_t* const* labels;
+    int count;
+    const wchar_t* label;
+    int controlId;
+};
+
+// 文本保存在 text.txt；ini 中的同名键只作为旧版本的回退来源
+struct TextField
+{
+    const char* key;
+    std::wstring AppConfig::* member;
+    const wchar_t* defaultValue;
+    int maxLength;
+    const wchar_t* label;
+    int controlId;
+};
+
+// 遮罩区域规则（格式见 overlay_region.h），没有对应的设置控件，只在 ini 中编辑
+struct RegionField
+{
+    const char* key;
+    std::string AppConfig::* member;
+    const char* defaultValue;
+    int maxLength;
+    const wchar_t* label;
+};
+
+// 遮罩上代替文字播放的动画文件路径，没有对应的设置控件，只在 ini 中编辑
+struct PathField
+{
+    const char* key;
+    std::wstring AppConfig::* member;
+    const wchar_t* defaultValue;
+    int maxLength;
+    const wchar_t* label;
+};
+
+inline constexpr IntField kFieldInterval{ "IntervalMinutes", &AppConfig::intervalMinutes, 15, 1, 9999, ConfigUnit::Minutes,
+    L"间隔（分钟）", L"间隔（分钟）必须在 1-9999 之间。", IDC_INTERVAL_EDIT, 0 };
+inline constexpr IntField kFieldOpacity{ "OpacityPercent", &AppConfig::opacityPercent, 60, 0, 100, ConfigUnit::Percent,
+    L"透明度（0-100）", L"透明度必须在 0-100 之间。", IDC_OPACITY_EDIT, IDC_OPACITY_TRACK };
+inline constexpr IntField kFieldFade{ "FadeSeconds", &AppConfig::fadeSeconds, 5, 1, 999, ConfigUnit::Seconds,
+    L"淡入/淡出（秒）", L"淡入/淡出（秒）必须在 1-999 之间。", IDC_FADE_EDIT, 0 };
+inline constexpr ColorField kFieldBgColor{ "BgColorHex", &AppConfig::bgColor, MakeColor(0, 128, 64),
+    L"背景颜色（HEX）", L"背景颜色格式不正确，请输入类似 #008040 的 HEX。", IDC_COLOR_EDIT };
+inline constexpr BoolField kFieldAutoStart{ "AutoStart", &AppConfig::autoStart, false, L"开机自启", IDC_AUTOSTART_CHECK };
+inline constexpr const char* kFullscreenModeNames[] = { "show", "defer", "suppress", "others" };
+inline constexpr const wchar_t* kFullscreenModeLabels[] = { L"照常显示", L"推迟到退出全屏", L"跳过本次提醒", L"只显示在其他显示器" };
+inline constexpr ChoiceField kFieldFullscreen{ "FullscreenMode", &AppConfig::fullscreenMode, 1, kFullscreenModeNames, kFullscreenModeLabels, 4,
+    L"全屏应用时", IDC_FULLSCREEN_COMBO };
+inline constexpr TextField kFieldText{ "Text", &AppConfig::text, L"抬眼望远处，给目光放个假。", TEXT_MAX_LEN,
+    L"显示文字（可选，最多500字）", IDC_TEXT_EDIT };
+inline constexpr RegionField kFieldRegions{ "OverlayRegions", &AppConfig::overlayRegions, "", 4096, L"遮罩区域" };
+inline constexpr PathField kFieldAnimation{ "Animation", &AppConfig::animation, L"", 1024, L"动画文件" };
+
+inline constexpr auto kConfigFields = std::make_tuple(
+    kFieldInterval, kFieldOpacity, kFieldFade, kFieldBgColor, kFieldAutoStart, kFieldFullscreen, kFieldText, kFieldRegions, kFieldAnimation);
+
+inline constexpr const char* kConfigSection = "General";
+inline constexpr const char* kConfigLockedSection = "Locked";
+inline constexpr const char* kConfigLimitsSection = "Limits";
+
+inline constexpr int CONFIG_FIELD_COUNT = (int)std::tuple_size_v<decltype(kConfigFields)>;
+static_assert(CONFIG_FIELD_COUNT <= CONFIG_MAX_FIELDS, "ConfigPolicy masks and limits");
+
+inline constexpr std::uint32_t Config_FieldBit(int index)
+{
+    return 1u << index;
+}
+
+template <typename Fn>
+inline void Config_ForEachField(Fn&& fn)
+{
+    std::apply([&](const auto&... field) { (fn(field), ...); }, kConfigFields);
+}
+
+// 依次处理每个字段，遇到第一个返回 false 的字段即停止
+template <typename Fn>
+inline bool Config_AllFields(Fn&& fn)
+{
+    return std::apply([&](const auto&... field) { return (fn(field) && ...); }, kConfigFields);
+}
+
+constexpr int Config_DigitCount(int value)
+{
+    int digits = 1;
+    while (value >= 10)
+    {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+constexpr int Config_Clamp(const IntField& field, int value)
+{
+    return value < field.minValue ? field.minValue : (value > field.maxValue ? field.maxValue : value);
+}
+
+constexpr bool Config_InRange(const IntField& field, int value)
+{
+    return (unsigned)value - (unsigned)field.minValue <= (unsigned)field.maxValue - (unsigned)field.minValue;
+}
@@ -0,0 +1,126 @@
+#include "control_protocol.h"
+
+#include <cstring>
+
+static void AppendU32(std::string& out, std::uint32_t v)
+{
+    char bytes[4] = { (char)(v & 0xFF), (char)((v >> 8) & 0xFF), (char)((v >> 16) & 0xFF), (char)((v >> 24) & 0xFF) };
+    out.append(bytes, sizeof(bytes));
+}
+
+static std::uint32_t ReadU32(const char* p)
+{
+    const auto* b = reinterpret_cast<const std::uint8_t*>(p);
+    return (std::uint32_t)b[0] | ((std::uint32_t)b[1] << 8) | ((std::uint32_t)b[2] << 16) | ((std::uint32_t)b[3] << 24);
+}
+
+static void AppendFrame(std::string& out, std::uint8_t code, std::uint32_t id, std::string_view body)
+{
+    AppendU32(out, (std::uint32_t)(CONTROL_HEADER_SIZE + body.size()));
+    out.push_back((char)code);
+    AppendU32(out, id);
+    out.append(body.data(), body.size());
+}
+
+void Control_AppendRequest(std::string& out, std::uint32_t id, ControlOp op, std::string_view arg)
+{
+    AppendFrame(out, (std::uint8_t)op, id, arg);
+}
+
+void Control_AppendResponse(std::string& out, std::uint32_t id, ControlStatus status, std::string_view body)
+{
+    AppendFrame(out, (std::uint8_t)status, id, body);
+}
+
+bool Control_ParseRequest(std::string_view payload, ControlRequest& out)
+{
+    if (payload.size() < CONTROL_HEADER_SIZE)
+    {
+        return false;
+    }
+    const auto op = (std::uint8_t)payload[0];
+    if (op < (std::uint8_t)ControlOp::Status || op > (std::uint8_t)ControlOp::OpenSettings)
+    {
+        return false;
+    }
+    out.op = (ControlOp)op;
+    out.id = ReadU32(payload.data() + 1);
+    out.arg.assign(payload.data() + CONTROL_HEADER_SIZE, payload.size() - CONTROL_HEADER_SIZE);
+    return true;
+}
+
+bool Control_ParseResponse(std::string_view payload, ControlResponse& out)
+{
+    if (payload.size() < CONTROL_HEADER_SIZE)
+    {
+        return false;
+    }
+    out.status = (ControlStatus)(std::uint8_t)payload[0];
+    out.id = ReadU32(payload.data() + 1);
+    out.body.assign(payload.data() + CONTROL_HEADER_SIZE, payload.size() - CONTROL_HEADER_SIZE);
+    return true;
+}
+
+std::string Control_SnoozeArg(std::uint32_t minutes)
+{
+    std::string arg;
+    AppendU32(arg, minutes);
+    return arg;
+}
+
+bool Control_ParseSnoozeArg(std::string_view arg, std::uint32_t& minutes)
+{
+    if (arg.size() != 4)
+    {
+        return false;
+    }
+    minutes = ReadU32(arg.data());
+    return true;
+}
+
+const char* Control_OpName(ControlOp op)
+{
+    switch (op)
+    {
+    case ControlOp::Status: return "status";
+    case ControlOp::Snooze: return "snooze";
+    case ControlOp::TriggerNow: return "trigger";
+    case ControlOp::ReloadConfig: return "reload";
+    case ControlOp::Metrics: return "metrics";
+    case ControlOp::Trace: return "trace";
+    case ControlOp::OpenSettings: return "settings";
+    }
+    return "?";
+}
+
+void ControlFrameReader::Append(const char* data, size_t size)
+{
+    // 已消费的部分超过一半时再整理，避免每帧都搬移
+    if (m_pos > 0 && m_pos * 2 >= m_buf.size())
+    {
+        m_buf.erase(0, m_pos);
+        m_pos = 0;
+    }
+    m_buf.append(data, size);
+}
+
+bool ControlFrameReader::Next(std::string_view& payload)
+{
+    if (m_failed || m_buf.size() - m_pos < 4)
+    {
+        return false;
+    }
+    const std::uint32_t len = ReadU32(m_buf.data() + m_pos);
+    if (len > CONTROL_MAX_FRAME)
+    {
+        m_failed = true;
+        return false;
+    }
+    if (m_buf.size() - m_pos - 4 < len)
+    {
+        return false;
+    }
+    payload = std::string_view(m_buf.data() + m_pos + 4, len);
+    m_pos += 4 + (size_t)len;
+    return true;
+}
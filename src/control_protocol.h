@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 本地控制协议。每帧 = u32 小端负载长度 + 负载：
+//   请求负载：u8 操作码 + u32 请求号 + 参数
+//   应答负载：u8 状态 + u32 请求号 + 正文
+// 请求号由客户端分配，服务端原样带回；同一连接上的应答按请求顺序返回。
+
+enum class ControlOp : std::uint8_t
+{
+    Status = 1,        // 正文为 key=value 行
+    Snooze = 2,        // 参数：u32 分钟数，当前提醒结束后（或立即）按此间隔重新计时
+    TriggerNow = 3,
+    ReloadConfig = 4,  // 重新读取 config.ini / text.txt
+    Metrics = 5,       // 正文为 key=value 行
+    Trace = 6,         // 正文为 Chrome trace-event JSON，导出后清空缓冲区
+    OpenSettings = 7,  // 打开设置窗口（第二个实例转发 --settings）
+};
+
+enum class ControlStatus : std::uint8_t
+{
+    Ok = 0,
+    BadRequest = 1,
+    Busy = 2,
+    Failed = 3,
+};
+
+constexpr std::uint32_t CONTROL_MAX_FRAME = 4u << 20;
+constexpr size_t CONTROL_HEADER_SIZE = 5;
+
+struct ControlRequest
+{
+    std::uint64_t client = 0;   // 服务端填写，应答时原样带回
+    std::uint32_t id = 0;
+    ControlOp op = ControlOp::Status;
+    std::string arg;
+};
+
+struct ControlResponse
+{
+    std::uint64_t client = 0;
+    std::uint32_t id = 0;
+    ControlStatus status = ControlStatus::Ok;
+    std::string body;
+};
+
+void Control_AppendRequest(std::string& out, std::uint32_t id, ControlOp op, std::string_view arg = {});
+void Control_AppendResponse(std::string& out, std::uint32_t id, ControlStatus status, std::string_view body);
+
+bool Control_ParseRequest(std::string_view payload, ControlRequest& out);
+bool Control_ParseResponse(std::string_view payload, ControlResponse& out);
+
+std::string Control_SnoozeArg(std::uint32_t minutes);
+bool Control_ParseSnoozeArg(std::string_view arg, std::uint32_t& minutes);
+
+const char* Control_OpName(ControlOp op);
+
+// 从字节流中切出完整的帧；超长帧视为协议错误，之后 Failed() 为 true
+class ControlFrameReader
+{
+public:
+    void Append(const char* data, size_t size);
+
+    // 取出下一帧的负载；返回的视图在下一次 Append 之前有效
+    bool Next(std::string_view& payload);
+
+    bool Failed() const { return m_failed; }
+    size_t Buffered() const { return m_buf.size() - m_pos; }
+
+private:
+    std::string m_buf;
+    size_t m_pos = 0;
+    bool m_failed = false;
+};
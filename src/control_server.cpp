@@ -0,0 +1,1131 @@
+#include "control_server.h"
+
+#include <chrono>
+#include <iterator>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "utf8.h"
+#else
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct ControlCounters
+    {
+        std::atomic<std::uint64_t> connections{0};
+        std::atomic<std::uint64_t> activeClients{0};
+        std::atomic<std::uint64_t> requests{0};
+        std::atomic<std::uint64_t> responses{0};
+        std::atomic<std::uint64_t> batches{0};
+        std::atomic<std::uint64_t> maxBatch{0};
+        std::atomic<std::uint64_t> protocolErrors{0};
+    };
+
+    // 从连接的缓冲区里切出请求放入本轮批次，直到挂起数达到上限；协议错误时返回 false
+    template <class Client>
+    bool ParseFrames(Client& c, std::vector<ControlRequest>& batch, ControlCounters& counters)
+    {
+        std::string_view payload;
+        while (c.pending < ControlServer::MAX_PENDING_PER_CLIENT && c.reader.Next(payload))
+        {
+            ControlRequest request;
+            if (!Control_ParseRequest(payload, request))
+            {
+                counters.protocolErrors.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            request.client = c.id;
+            batch.push_back(std::move(request));
+            c.pending++;
+        }
+        if (c.reader.Failed())
+        {
+            counters.protocolErrors.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+}
+
+#ifdef _WIN32
+
+// 每个连接一个管道实例，读写都是重叠 I/O，完成通知统一进入一个完成端口。
+// 连接关闭后要等它的全部 I/O 完成（或被取消）才能释放。
+struct ControlServer::Impl
+{
+    struct Client
+    {
+        std::uint64_t id = 0;
+        HANDLE pipe = INVALID_HANDLE_VALUE;
+        OVERLAPPED readOv{};
+        OVERLAPPED writeOv{};
+        char readBuf[8192];
+        ControlFrameReader reader;
+        std::string out;
+        std::string writing;
+        unsigned pending = 0;
+        int ops = 0;
+        bool connecting = true;
+        bool reading = false;
+        bool writeActive = false;
+        bool paused = false;
+        bool closing = false;
+    };
+
+    HANDLE iocp = nullptr;
+    std::wstring pipeName;
+    bool firstInstance = true;
+    std::uint64_t nextClientId = 1;
+    std::unordered_map<std::uint64_t, Client*> clients;
+    std::vector<Client*> all;
+    std::vector<ControlRequest> batch;
+    ControlCounters counters;
+
+    void Wake()
+    {
+        PostQueuedCompletionStatus(iocp, 0, 0, nullptr);
+    }
+
+    bool Listen()
+    {
+        const DWORD flags = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (firstInstance ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+        HANDLE pipe = CreateNamedPipeW(pipeName.c_str(), flags, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES, 64 * 1024, 64 * 1024, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        firstInstance = false;
+
+        auto* c = new Client();
+        c->id = nextClientId++;
+        c->pipe = pipe;
+        all.push_back(c);
+        if (!CreateIoCompletionPort(pipe, iocp, (ULONG_PTR)c, 0))
+        {
+            Close(c);
+            return false;
+        }
+
+        c->ops++;
+        if (!ConnectNamedPipe(pipe, &c->readOv))
+        {
+            const DWORD err = GetLastError();
+            if (err == ERROR_PIPE_CONNECTED)
+            {
+                // 客户端在 ConnectNamedPipe 之前已连上，不会再有完成通知
+                c->ops--;
+                OnConnected(c);
+            }
+            else if (err != ERROR_IO_PENDING)
+            {
+                c->ops--;
+                Close(c);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void OnConnected(Client* c)
+    {
+        c->connecting = false;
+        clients.emplace(c->id, c);
+        counters.connections.fetch_add(1, std::memory_order_relaxed);
+        counters.activeClients.fetch_add(1, std::memory_order_relaxed);
+        StartRead(c);
+        Listen();
+    }
+
+    void StartRead(Client* c)
+    {
+        if (c->closing || c->reading || c->paused)
+        {
+            return;
+        }
+        c->reading = true;
+        c->ops++;
+        if (!ReadFile(c->pipe, c->readBuf, (DWORD)sizeof(c->readBuf), nullptr, &c->readOv) && GetLastError() != ERROR_IO_PENDING)
+        {
+            c->ops--;
+            c->reading = false;
+            Close(c);
+        }
+    }
+
+    void StartWrite(Client* c)
+    {
+        if (c->closing || c->writeActive || c->out.empty())
+        {
+            return;
+        }
+        c->writing.swap(c->out);
+        c->out.clear();
+        c->writeActive = true;
+        c->ops++;
+        if (!WriteFile(c->pipe, c->writing.data(), (DWORD)c->writing.size(), nullptr, &c->writeOv) && GetLastError() != ERROR_IO_PENDING)
+        {
+            c->ops--;
+            c->writeActive = false;
+            Close(c);
+        }
+    }
+
+    void Close(Client* c)
+    {
+        if (c->closing)
+        {
+            return;
+        }
+        c->closing = true;
+        if (clients.erase(c->id) != 0)
+        {
+            counters.activeClients.fetch_sub(1, std::memory_order_relaxed);
+        }
+        CancelIoEx(c->pipe, nullptr);
+        CloseHandle(c->pipe);
+        c->pipe = INVALID_HANDLE_VALUE;
+        Release(c);
+    }
+
+    void Release(Client* c)
+    {
+        if (c->closing && c->ops == 0)
+        {
+            for (size_t i = 0; i < all.size(); i++)
+            {
+                if (all[i] == c)
+                {
+                    all[i] = all.back();
+                    all.pop_back();
+                    break;
+                }
+            }
+            delete c;
+        }
+    }
+
+    void OnCompletion(Client* c, OVERLAPPED* ov, bool ok, DWORD bytes, bool stopping)
+    {
+        c->ops--;
+        if (c->closing)
+        {
+            Release(c);
+            return;
+        }
+
+        if (ov == &c->readOv && c->connecting)
+        {
+            if (!ok)
+            {
+                Close(c);
+                if (!stopping)
+                {
+                    Listen();
+                }
+                return;
+            }
+            OnConnected(c);
+            return;
+        }
+
+        if (ov == &c->readOv)
+        {
+            c->reading = false;
+            if (!ok || bytes == 0)
+            {
+                Close(c);
+                return;
+            }
+            c->reader.Append(c->readBuf, bytes);
+            if (!ParseFrames(*c, batch, counters))
+            {
+                Close(c);
+                return;
+            }
+            c->paused = c->pending >= MAX_PENDING_PER_CLIENT;
+            StartRead(c);
+            return;
+        }
+
+        c->writeActive = false;
+        c->writing.clear();
+        if (!ok)
+        {
+            Close(c);
+            return;
+        }
+        StartWrite(c);
+    }
+
+    void Deliver(std::vector<ControlResponse>& responses)
+    {
+        for (auto& r : responses)
+        {
+            auto it = clients.find(r.client);
+            if (it == clients.end())
+            {
+                continue;
+            }
+            Client* c = it->second;
+            Control_AppendResponse(c->out, r.id, r.status, r.body);
+            if (c->pending > 0)
+            {
+                c->pending--;
+            }
+            counters.responses.fetch_add(1, std::memory_order_relaxed);
+            StartWrite(c);
+            if (c->paused && c->pending < MAX_PENDING_PER_CLIENT)
+            {
+                // 先处理已缓冲的请求，仍有余量才恢复读取
+                if (!ParseFrames(*c, batch, counters))
+                {
+                    Close(c);
+                    continue;
+                }
+                c->paused = c->pending >= MAX_PENDING_PER_CLIENT;
+                StartRead(c);
+            }
+        }
+    }
+
+    void Shutdown()
+    {
+        for (Client* c : std::vector<Client*>(all))
+        {
+            Close(c);
+        }
+        // 等待被取消的 I/O 全部回到完成端口后再释放连接
+        while (!all.empty())
+        {
+            DWORD bytes = 0;
+            ULONG_PTR key = 0;
+            OVERLAPPED* ov = nullptr;
+            const BOOL ok = GetQueuedCompletionStatus(iocp, &bytes, &key, &ov, 1000);
+            if (!ok && ov == nullptr)
+            {
+                break;
+            }
+            if (ov != nullptr)
+            {
+                OnCompletion((Client*)key, ov, ok != FALSE, bytes, true);
+            }
+        }
+        CloseHandle(iocp);
+        iocp = nullptr;
+    }
+};
+
+bool ControlServer::Start(const std::string& endpoint, BatchHandler handler)
+{
+    if (IsRunning())
+    {
+        return false;
+    }
+    m_impl = std::make_unique<Impl>();
+    m_impl->pipeName = Utf8ToWide(endpoint);
+    m_impl->iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    if (!m_impl->iocp)
+    {
+        m_impl.reset();
+        return false;
+    }
+    // 第一个实例带 FILE_FLAG_FIRST_PIPE_INSTANCE：同名管道已存在说明另一个实例在运行
+    if (!m_impl->Listen())
+    {
+        m_impl->Shutdown();
+        m_impl.reset();
+        return false;
+    }
+    m_handler = std::move(handler);
+    m_stopping.store(false);
+    m_thread = std::thread([this] { Run(); });
+    return true;
+}
+
+void ControlServer::Run()
+{
+    Impl& impl = *m_impl;
+    std::vector<ControlResponse> responses;
+    while (!m_stopping.load())
+    {
+        DWORD bytes = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* ov = nullptr;
+        BOOL ok = GetQueuedCompletionStatus(impl.iocp, &bytes, &key, &ov, INFINITE);
+        if (!ok && ov == nullptr)
+        {
+            break;
+        }
+        // 一次取完当前已完成的所有 I/O，请求合成一批处理
+        for (;;)
+        {
+            if (ov != nullptr)
+            {
+                impl.OnCompletion((Impl::Client*)key, ov, ok != FALSE, bytes, false);
+            }
+            ov = nullptr;
+            ok = GetQueuedCompletionStatus(impl.iocp, &bytes, &key, &ov, 0);
+            if (!ok && ov == nullptr)
+            {
+                break;
+            }
+        }
+
+        if (!impl.batch.empty())
+        {
+            const std::uint64_t size = impl.batch.size();
+            impl.counters.requests.fetch_add(size, std::memory_order_relaxed);
+            impl.counters.batches.fetch_add(1, std::memory_order_relaxed);
+            if (size > impl.counters.maxBatch.load(std::memory_order_relaxed))
+            {
+                impl.counters.maxBatch.store(size, std::memory_order_relaxed);
+            }
+            m_handler(impl.batch);
+            impl.batch.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_outboxMutex);
+            responses.swap(m_outbox);
+        }
+        impl.Deliver(responses);
+        responses.clear();
+    }
+}
+
+void ControlServer::Stop()
+{
+    if (!IsRunning())
+    {
+        return;
+    }
+    m_stopping.store(true);
+    m_impl->Wake();
+    m_thread.join();
+    m_impl->Shutdown();
+    m_impl.reset();
+}
+
+std::string ControlServer::DefaultEndpoint()
+{
+    wchar_t user[128]{};
+    const DWORD len = GetEnvironmentVariableW(L"USERNAME", user, (DWORD)std::size(user));
+    std::wstring name = L"\\\\.\\pipe\\ScreenSaverReminderCPP";
+    if (len > 0 && len < std::size(user))
+    {
+        name += L".";
+        name += user;
+    }
+    return WideToUtf8(name);
+}
+
+#else
+
+// 监听套接字、唤醒用的 eventfd 与所有连接都挂在同一个 epoll 上（水平触发）
+struct ControlServer::Impl
+{
+    static constexpr std::uint64_t LISTEN_KEY = 0;
+    static constexpr std::uint64_t WAKE_KEY = 1;
+
+    struct Client
+    {
+        std::uint64_t id = 0;
+        int fd = -1;
+        ControlFrameReader reader;
+        std::string out;
+        size_t outPos = 0;
+        unsigned pending = 0;
+        std::uint32_t events = 0;
+        bool paused = false;
+    };
+
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::string path;
+    std::uint64_t nextClientId = 16;
+    std::unordered_map<std::uint64_t, std::unique_ptr<Client>> clients;
+    std::vector<ControlRequest> batch;
+    ControlCounters counters;
+
+    void Wake()
+    {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = write(wakeFd, &one, sizeof(one));
+    }
+
+    void Watch(Client& c)
+    {
+        std::uint32_t events = (c.paused ? 0u : (std::uint32_t)EPOLLIN) | (c.outPos < c.out.size() ? (std::uint32_t)EPOLLOUT : 0u);
+        if (events != c.events)
+        {
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.u64 = c.id;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+            c.events = events;
+        }
+    }
+
+    void Accept()
+    {
+        for (;;)
+        {
+            const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                return;
+            }
+            auto c = std::make_unique<Client>();
+            c->id = nextClientId++;
+            c->fd = fd;
+            c->events = EPOLLIN;
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = c->id;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+            {
+                close(fd);
+                continue;
+            }
+            clients.emplace(c->id, std::move(c));
+            counters.connections.fetch_add(1, std::memory_order_relaxed);
+            counters.activeClients.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Close(Client& c)
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+        close(c.fd);
+        counters.activeClients.fetch_sub(1, std::memory_order_relaxed);
+        clients.erase(c.id);
+    }
+
+    // 返回 false 表示连接已关闭
+    bool Read(Client& c)
+    {
+        char buf[16384];
+        while (!c.paused)
+        {
+            const ssize_t n = read(c.fd, buf, sizeof(buf));
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            {
+                Close(c);
+                return false;
+            }
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                break;
+            }
+            c.reader.Append(buf, (size_t)n);
+            if (!ParseFrames(c, batch, counters))
+            {
+                Close(c);
+                return false;
+            }
+            c.paused = c.pending >= MAX_PENDING_PER_CLIENT;
+        }
+        Watch(c);
+        return true;
+    }
+
+    bool Flush(Client& c)
+    {
+        while (c.outPos < c.out.size())
+        {
+            const ssize_t n = send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    break;
+                }
+                Close(c);
+                return false;
+            }
+            c.outPos += (size_t)n;
+        }
+        if (c.outPos == c.out.size())
+        {
+            c.out.clear();
+            c.outPos = 0;
+        }
+        Watch(c);
+        return true;
+    }
+
+    void Deliver(std::vector<ControlResponse>& responses)
+    {
+        std::vector<std::uint64_t> touched;
+        for (auto& r : responses)
+        {
+            auto it = clients.find(r.client);
+            if (it == clients.end())
+            {
+                continue;
+            }
+            Client& c = *it->second;
+            if (c.out.empty())
+            {
+                touched.push_back(c.id);
+            }
+            Control_AppendResponse(c.out, r.id, r.status, r.body);
+            if (c.pending > 0)
+            {
+                c.pending--;
+            }
+            counters.responses.fetch_add(1, std::memory_order_relaxed);
+        }
+        for (std::uint64_t id : touched)
+        {
+            auto it = clients.find(id);
+            if (it == clients.end())
+            {
+                continue;
+            }
+            Client& c = *it->second;
+            if (!Flush(c))
+            {
+                continue;
+            }
+            if (c.paused && c.pending < MAX_PENDING_PER_CLIENT)
+            {
+                // 先处理已缓冲的请求，仍有余量才恢复读取
+                if (!ParseFrames(c, batch, counters))
+                {
+                    Close(c);
+                    continue;
+                }
+                c.paused = c.pending >= MAX_PENDING_PER_CLIENT;
+                Watch(c);
+            }
+        }
+    }
+
+    void Shutdown()
+    {
+        for (auto& entry : clients)
+        {
+            close(entry.second->fd);
+        }
+        clients.clear();
+        counters.activeClients.store(0);
+        if (listenFd >= 0)
+        {
+            close(listenFd);
+            unlink(path.c_str());
+        }
+        if (epollFd >= 0)
+        {
+            close(epollFd);
+        }
+        if (wakeFd >= 0)
+        {
+            close(wakeFd);
+        }
+        listenFd = epollFd = wakeFd = -1;
+    }
+};
+
+static bool Control_FillAddress(const std::string& path, sockaddr_un& addr)
+{
+    addr = sockaddr_un{};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+    {
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    return true;
+}
+
+bool ControlServer::Start(const std::string& endpoint, BatchHandler handler)
+{
+    if (IsRunning())
+    {
+        return false;
+    }
+    sockaddr_un addr;
+    if (!Control_FillAddress(endpoint, addr))
+    {
+        return false;
+    }
+
+    // 能连上说明另一个实例在监听；连不上则是残留的套接字文件，删掉重建。
+    // 只删除自己的套接字：普通文件、符号链接或别的用户的套接字不动，直接失败
+    {
+        ControlClient probe;
+        if (probe.Connect(endpoint, 0))
+        {
+            return false;
+        }
+    }
+    struct stat st{};
+    if (lstat(endpoint.c_str(), &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode) || st.st_uid != getuid())
+        {
+            return false;
+        }
+        unlink(endpoint.c_str());
+    }
+
+    m_impl = std::make_unique<Impl>();
+    Impl& impl = *m_impl;
+    impl.path = endpoint;
+    impl.listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    const mode_t oldMask = umask(077);
+    const bool bound = impl.listenFd >= 0 && bind(impl.listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    umask(oldMask);
+    if (!bound || listen(impl.listenFd, SOMAXCONN) != 0)
+    {
+        if (!bound && impl.listenFd >= 0)
+        {
+            close(impl.listenFd);
+            impl.listenFd = -1;
+        }
+        impl.Shutdown();
+        m_impl.reset();
+        return false;
+    }
+
+    impl.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    impl.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = Impl::LISTEN_KEY;
+    const bool watched = impl.epollFd >= 0 && impl.wakeFd >= 0 && epoll_ctl(impl.epollFd, EPOLL_CTL_ADD, impl.listenFd, &ev) == 0;
+    ev.data.u64 = Impl::WAKE_KEY;
+    if (!watched || epoll_ctl(impl.epollFd, EPOLL_CTL_ADD, impl.wakeFd, &ev) != 0)
+    {
+        impl.Shutdown();
+        m_impl.reset();
+        return false;
+    }
+
+    m_handler = std::move(handler);
+    m_stopping.store(false);
+    m_thread = std::thread([this] { Run(); });
+    return true;
+}
+
+void ControlServer::Run()
+{
+    Impl& impl = *m_impl;
+    std::vector<ControlResponse> responses;
+    epoll_event events[64];
+    while (!m_stopping.load())
+    {
+        const int n = epoll_wait(impl.epollFd, events, (int)std::size(events), -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            const std::uint64_t key = events[i].data.u64;
+            if (key == Impl::LISTEN_KEY)
+            {
+                impl.Accept();
+                continue;
+            }
+            if (key == Impl::WAKE_KEY)
+            {
+                std::uint64_t value;
+                [[maybe_unused]] ssize_t r = read(impl.wakeFd, &value, sizeof(value));
+                continue;
+            }
+            // 同一轮里前面的事件可能已经关闭了这个连接
+            auto it = impl.clients.find(key);
+            if (it == impl.clients.end())
+            {
+                continue;
+            }
+            Impl::Client& c = *it->second;
+            if ((events[i].events & EPOLLOUT) && !impl.Flush(c))
+            {
+                continue;
+            }
+            if (c.paused && (events[i].events & (EPOLLHUP | EPOLLERR)))
+            {
+                // 对端已断开，暂停读取的连接也不会再收到应答
+                impl.Close(c);
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                impl.Read(c);
+            }
+        }
+
+        if (!impl.batch.empty())
+        {
+            const std::uint64_t size = impl.batch.size();
+            impl.counters.requests.fetch_add(size, std::memory_order_relaxed);
+            impl.counters.batches.fetch_add(1, std::memory_order_relaxed);
+            if (size > impl.counters.maxBatch.load(std::memory_order_relaxed))
+            {
+                impl.counters.maxBatch.store(size, std::memory_order_relaxed);
+            }
+            m_handler(impl.batch);
+            impl.batch.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_outboxMutex);
+            responses.swap(m_outbox);
+        }
+        impl.Deliver(responses);
+        responses.clear();
+    }
+}
+
+void ControlServer::Stop()
+{
+    if (!IsRunning())
+    {
+        return;
+    }
+    m_stopping.store(true);
+    m_impl->Wake();
+    m_thread.join();
+    m_impl->Shutdown();
+    m_impl.reset();
+}
+
+// 只有当前用户能进入的目录：不是符号链接，属于当前用户，组和其他人没有任何权限
+static bool Control_IsPrivateDir(const std::string& dir)
+{
+    struct stat st{};
+    return lstat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode) && st.st_uid == getuid() && (st.st_mode & 077) == 0;
+}
+
+std::string ControlServer::DefaultEndpoint()
+{
+    // /tmp 下的名字别的用户可以抢先占用：没有 $XDG_RUNTIME_DIR 时在 /tmp 下建只有自己能进的目录，
+    // 已存在但属主或权限不对时不用
+    const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+    std::string dir;
+    if (runtimeDir && *runtimeDir)
+    {
+        dir = runtimeDir;
+    }
+    else
+    {
+        dir = "/tmp/ssr-" + std::to_string((unsigned long)getuid());
+        mkdir(dir.c_str(), 0700);
+    }
+    return Control_IsPrivateDir(dir) ? dir + "/ssr-control.sock" : std::string();
+}
+
+#endif
+
+ControlServer::ControlServer() = default;
+
+ControlServer::~ControlServer()
+{
+    Stop();
+}
+
+void ControlServer::Respond(std::vector<ControlResponse>& responses)
+{
+    if (responses.empty())
+    {
+        return;
+    }
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_outboxMutex);
+        // 只有发件箱由空变为非空时才需要唤醒 I/O 线程
+        wake = m_outbox.empty();
+        if (wake)
+        {
+            m_outbox.swap(responses);
+        }
+        else
+        {
+            for (auto& r : responses)
+            {
+                m_outbox.push_back(std::move(r));
+            }
+        }
+    }
+    responses.clear();
+    if (wake && m_impl)
+    {
+        m_impl->Wake();
+    }
+}
+
+ControlServerStats ControlServer::GetStats() const
+{
+    ControlServerStats stats;
+    if (!m_impl)
+    {
+        return stats;
+    }
+    const ControlCounters& c = m_impl->counters;
+    stats.connections = c.connections.load(std::memory_order_relaxed);
+    stats.activeClients = c.activeClients.load(std::memory_order_relaxed);
+    stats.requests = c.requests.load(std::memory_order_relaxed);
+    stats.responses = c.responses.load(std::memory_order_relaxed);
+    stats.batches = c.batches.load(std::memory_order_relaxed);
+    stats.maxBatch = c.maxBatch.load(std::memory_order_relaxed);
+    stats.protocolErrors = c.protocolErrors.load(std::memory_order_relaxed);
+    return stats;
+}
+
+ControlClient::~ControlClient()
+{
+    Close();
+}
+
+bool ControlClient::Call(ControlOp op, std::string_view arg, ControlResponse& out)
+{
+    const std::uint32_t id = m_nextId++;
+    if (!Send(id, op, arg))
+    {
+        return false;
+    }
+    return Receive(out) && out.id == id;
+}
+
+bool ControlClient::Send(std::uint32_t id, ControlOp op, std::string_view arg)
+{
+    m_scratch.clear();
+    Control_AppendRequest(m_scratch, id, op, arg);
+    return WriteAll(m_scratch.data(), m_scratch.size());
+}
+
+#ifdef _WIN32
+
+// 客户端管道以重叠方式打开：等待 timeoutMs（0 表示一直等）后取消这次 I/O，与 Linux 上的 SO_RCVTIMEO 一致。
+// 取消与完成同时发生时以实际传输的字节为准，不丢数据
+static bool Control_PipeIo(HANDLE pipe, HANDLE event, bool write, void* buf, DWORD size, DWORD timeoutMs, DWORD& done)
+{
+    OVERLAPPED ov{};
+    ov.hEvent = event;
+    done = 0;
+    const BOOL ok = write ? WriteFile(pipe, buf, size, nullptr, &ov) : ReadFile(pipe, buf, size, nullptr, &ov);
+    if (!ok && GetLastError() != ERROR_IO_PENDING)
+    {
+        return false;
+    }
+    if (!ok && WaitForSingleObject(event, timeoutMs == 0 ? INFINITE : timeoutMs) == WAIT_TIMEOUT)
+    {
+        CancelIoEx(pipe, &ov);
+        // 等取消真正完成，OVERLAPPED 才能离开作用域
+        return GetOverlappedResult(pipe, &ov, &done, TRUE) && done > 0;
+    }
+    return GetOverlappedResult(pipe, &ov, &done, FALSE) != FALSE;
+}
+
+bool ControlClient::Connect(const std::string& endpoint, std::uint32_t timeoutMs)
+{
+    Close();
+    const std::wstring name = Utf8ToWide(endpoint);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;)
+    {
+        HANDLE pipe = CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+        if (pipe != INVALID_HANDLE_VALUE)
+        {
+            HANDLE event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            if (!event)
+            {
+                CloseHandle(pipe);
+                return false;
+            }
+            m_pipe = pipe;
+            m_event = event;
+            m_timeoutMs = timeoutMs;
+            m_reader = ControlFrameReader();
+            return true;
+        }
+        if (GetLastError() != ERROR_PIPE_BUSY || std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        WaitNamedPipeW(name.c_str(), timeoutMs);
+    }
+}
+
+void ControlClient::Close()
+{
+    if (m_pipe)
+    {
+        CloseHandle((HANDLE)m_pipe);
+        m_pipe = nullptr;
+    }
+    if (m_event)
+    {
+        CloseHandle((HANDLE)m_event);
+        m_event = nullptr;
+    }
+}
+
+bool ControlClient::IsConnected() const
+{
+    return m_pipe != nullptr;
+}
+
+bool ControlClient::WriteAll(const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        // 与 Linux 一样，发送不设超时
+        DWORD written = 0;
+        if (!m_pipe || !Control_PipeIo((HANDLE)m_pipe, (HANDLE)m_event, true, const_cast<char*>(data), (DWORD)size, 0, written))
+        {
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool ControlClient::Receive(ControlResponse& out)
+{
+    std::string_view payload;
+    while (!m_reader.Next(payload))
+    {
+        char buf[8192];
+        DWORD read = 0;
+        if (!m_pipe || m_reader.Failed() || !Control_PipeIo((HANDLE)m_pipe, (HANDLE)m_event, false, buf, (DWORD)sizeof(buf), m_timeoutMs, read) || read == 0)
+        {
+            return false;
+        }
+        m_reader.Append(buf, read);
+    }
+    return Control_ParseResponse(payload, out);
+}
+
+#else
+
+bool ControlClient::Connect(const std::string& endpoint, std::uint32_t timeoutMs)
+{
+    Close();
+    sockaddr_un addr;
+    if (!Control_FillAddress(endpoint, addr))
+    {
+        return false;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;)
+    {
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            // 接收超时，避免对方挂起时调用方一直阻塞
+            if (timeoutMs > 0)
+            {
+                timeval tv{};
+                tv.tv_sec = (time_t)(timeoutMs / 1000);
+                tv.tv_usec = (suseconds_t)((timeoutMs % 1000) * 1000);
+                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            }
+            m_fd = fd;
+            m_reader = ControlFrameReader();
+            return true;
+        }
+        const int err = errno;
+        close(fd);
+        // 监听队列已满时稍后重试
+        if (err != EAGAIN || std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void ControlClient::Close()
+{
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool ControlClient::IsConnected() const
+{
+    return m_fd >= 0;
+}
+
+bool ControlClient::WriteAll(const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t n = send(m_fd, data, size, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool ControlClient::Receive(ControlResponse& out)
+{
+    std::string_view payload;
+    while (!m_reader.Next(payload))
+    {
+        if (m_fd < 0 || m_reader.Failed())
+        {
+            return false;
+        }
+        char buf[16384];
+        const ssize_t n = read(m_fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        m_reader.Append(buf, (size_t)n);
+    }
+    return Control_ParseResponse(payload, out);
+}
+
+#endif
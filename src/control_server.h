@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "control_protocol.h"
+
+struct ControlServerStats
+{
+    std::uint64_t connections = 0;
+    std::uint64_t activeClients = 0;
+    std::uint64_t requests = 0;
+    std::uint64_t responses = 0;
+    std::uint64_t batches = 0;
+    std::uint64_t maxBatch = 0;
+    std::uint64_t protocolErrors = 0;
+};
+
+// 本地控制端点：Windows 上是命名管道（IOCP），Linux 上是 Unix 域套接字（epoll）。
+// 所有连接由一个后台线程以非阻塞方式处理；一轮 I/O 中收到的全部请求合成一批交给 handler，
+// handler 可以立即或稍后（任意线程）调用 Respond 返回应答。
+class ControlServer
+{
+public:
+    using BatchHandler = std::function<void(std::vector<ControlRequest>& batch)>;
+
+    // 每个连接最多同时挂起的请求数，超过后暂停读取该连接
+    static constexpr unsigned MAX_PENDING_PER_CLIENT = 64;
+
+    ControlServer();
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // 已有服务端在监听同一端点时返回 false
+    bool Start(const std::string& endpoint, BatchHandler handler);
+    void Stop();
+    bool IsRunning() const { return m_thread.joinable(); }
+
+    void Respond(std::vector<ControlResponse>& responses);
+
+    ControlServerStats GetStats() const;
+
+    // Windows：\\.\pipe\ScreenSaverReminderCPP.<用户名>；Linux：$XDG_RUNTIME_DIR/ssr-control.sock，
+    // 没有该变量时为 /tmp/ssr-<uid>/ssr-control.sock；目录不是只有当前用户能访问时返回空
+    static std::string DefaultEndpoint();
+
+    struct Impl;
+
+private:
+    void Run();
+
+    std::unique_ptr<Impl> m_impl;
+    std::thread m_thread;
+    BatchHandler m_handler;
+
+    std::mutex m_outboxMutex;
+    std::vector<ControlResponse> m_outbox;
+    std::atomic<bool> m_stopping{false};
+};
+
+// 同步客户端，供命令行工具、第二个实例转发命令与压力测试使用
+class ControlClient
+{
+public:
+    ControlClient() = default;
+    ~ControlClient();
+
+    ControlClient(const ControlClient&) = delete;
+    ControlClient& operator=(const ControlClient&) = delete;
+
+    // timeoutMs 同时是之后每次接收的超时，0 表示一直等
+    bool Connect(const std::string& endpoint, std::uint32_t timeoutMs = 1000);
+    void Close();
+    bool IsConnected() const;
+
+    // 只发送不等待，可以连续发送多条（流水线）
+    bool Send(std::uint32_t id, ControlOp op, std::string_view arg = {});
+    bool Receive(ControlResponse& out);
+
+    bool Call(ControlOp op, std::string_view arg, ControlResponse& out);
+
+private:
+    bool WriteAll(const char* data, size_t size);
+
+#ifdef _WIN32
+    void* m_pipe = nullptr;
+    void* m_event = nullptr;
+    std::uint32_t m_timeoutMs = 0;
+#else
+    int m_fd = -1;
+#endif
+    ControlFrameReader m_reader;
+    std::string m_scratch;
+    std::uint32_t m_nextId = 1;
+};
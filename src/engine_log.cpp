@@ -0,0 +1,328 @@
+#include "engine_log.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "mapped_file.h"
+#include "utf8.h"
+
+static void AppendVarint(std::string& out, std::uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back((char)((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+static bool ReadVarint(const std::uint8_t*& p, const std::uint8_t* end, std::uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7)
+    {
+        const std::uint8_t b = *p++;
+        v |= (std::uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+EngineRecorder::EngineRecorder()
+{
+    std::uint8_t header[5];
+    std::memcpy(header, &ENGINE_LOG_MAGIC, 4);
+    header[4] = ENGINE_LOG_VERSION;
+    m_data.assign(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+void EngineRecorder::Header(EngineRecordType type, std::uint8_t extra, std::uint64_t nowMs)
+{
+    m_data.push_back((char)((std::uint8_t)type | (std::uint8_t)(extra << 4)));
+    if (type == EngineRecordType::Start || !m_started)
+    {
+        // 第一条记录保存绝对时间，之后都是增量
+        m_started = true;
+        AppendVarint(m_data, nowMs);
+    }
+    else
+    {
+        AppendVarint(m_data, nowMs >= m_lastMs ? nowMs - m_lastMs : 0);
+    }
+    m_lastMs = nowMs;
+    m_records++;
+}
+
+void EngineRecorder::Input(EngineRecordType type, std::uint64_t nowMs)
+{
+    Header(type, 0, nowMs);
+}
+
+void EngineRecorder::Timer(EngineTimer id, std::uint64_t nowMs)
+{
+    Header(EngineRecordType::Timer, (std::uint8_t)id, nowMs);
+}
+
+void EngineRecorder::Config(EngineRecordType type, std::uint64_t nowMs, const AppConfig& cfg)
+{
+    Header(type, 0, nowMs);
+    Config_SerializeIni(cfg, m_scratch);
+    AppendVarint(m_data, m_scratch.size());
+    m_data.append(m_scratch);
+    WideToUtf8(cfg.text, m_scratch);
+    AppendVarint(m_data, m_scratch.size());
+    m_data.append(m_scratch);
+}
+
+void EngineRecorder::Snooze(std::uint64_t nowMs, std::uint32_t minutes)
+{
+    Header(EngineRecordType::Snooze, 0, nowMs);
+    AppendVarint(m_data, minutes);
+}
+
+void EngineRecorder::Resume(std::uint64_t nowMs, std::uint32_t delayMs)
+{
+    Header(EngineRecordType::Resume, 0, nowMs);
+    AppendVarint(m_data, delayMs);
+}
+
+void EngineRecorder::Policy(std::uint64_t nowMs, EngineShowPolicy policy)
+{
+    Header(EngineRecordType::Policy, (std::uint8_t)policy, nowMs);
+}
+
+void EngineRecorder::Presence(std::uint64_t nowMs, bool present)
+{
+    Header(EngineRecordType::Presence, present ? 1 : 0, nowMs);
+}
+
+void EngineRecorder::Checkpoint(std::uint32_t outputHash)
+{
+    m_data.push_back((char)EngineRecordType::Checkpoint);
+    char bytes[4];
+    std::memcpy(bytes, &outputHash, sizeof(bytes));
+    m_data.append(bytes, sizeof(bytes));
+    m_records++;
+}
+
+bool EngineRecorder::WriteFile(const std::filesystem::path& path) const
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(m_data.data(), (std::streamsize)m_data.size());
+    return (bool)out;
+}
+
+namespace
+{
+    struct LogCursor
+    {
+        const std::uint8_t* p;
+        const std::uint8_t* end;
+    };
+
+    // 回放用的宿主：计时器由记录驱动，因此这里只统计输出；显示结果按记录重现
+    class ReplayHost final : public EngineHost
+    {
+    public:
+        explicit ReplayHost(LogCursor& cursor) : m_cursor(cursor) {}
+
+        void SetTimer(EngineTimer, std::uint32_t) override {}
+        void KillTimer(EngineTimer) override {}
+        bool ShowSurfaces() override
+        {
+            if (m_cursor.p < m_cursor.end && (*m_cursor.p & 0x0F) == (std::uint8_t)EngineRecordType::ShowFailed)
+            {
+                // ShowFailed 由引擎重新记录，这里只跳过原记录
+                std::uint64_t delta;
+                m_cursor.p++;
+                ReadVarint(m_cursor.p, m_cursor.end, delta);
+                return false;
+            }
+            return true;
+        }
+        void HideSurfaces() override {}
+        void SetAlpha(std::uint8_t) override { alphaChanges++; }
+        void InvalidateSurfaces() override {}
+        void ReconcileSurfaces() override {}
+        void StartInput() override {}
+        void StopInput() override {}
+        void ResetActivityLatch() override {}
+        void OnStateChanged(OverlayState, OverlayState) override {}
+        EngineShowPolicy QueryShowPolicy() override
+        {
+            if (m_cursor.p < m_cursor.end && (*m_cursor.p & 0x0F) == (std::uint8_t)EngineRecordType::Policy)
+            {
+                // 与 ShowFailed 一样由引擎重新记录
+                const auto policy = (EngineShowPolicy)(*m_cursor.p >> 4);
+                std::uint64_t delta;
+                m_cursor.p++;
+                ReadVarint(m_cursor.p, m_cursor.end, delta);
+                return policy;
+            }
+            return EngineShowPolicy::Show;
+        }
+
+        std::uint64_t alphaChanges = 0;
+
+    private:
+        LogCursor& m_cursor;
+    };
+
+    bool ReadConfig(LogCursor& c, AppConfig& cfg)
+    {
+        std::uint64_t len;
+        if (!ReadVarint(c.p, c.end, len) || len > (std::uint64_t)(c.end - c.p))
+        {
+            return false;
+        }
+        cfg = AppConfig();
+        Config_ParseIni(std::string_view(reinterpret_cast<const char*>(c.p), (size_t)len), cfg);
+        c.p += len;
+        if (!ReadVarint(c.p, c.end, len) || len > (std::uint64_t)(c.end - c.p))
+        {
+            return false;
+        }
+        Utf8ToWide(std::string_view(reinterpret_cast<const char*>(c.p), (size_t)len), cfg.text);
+        c.p += len;
+        return true;
+    }
+}
+
+bool EngineReplay_Run(const std::uint8_t* data, size_t size, EngineReplayResult& out)
+{
+    out = EngineReplayResult{};
+    if (size < 5 || std::memcmp(data, &ENGINE_LOG_MAGIC, 4) != 0 || data[4] != ENGINE_LOG_VERSION)
+    {
+        out.malformed = true;
+        return false;
+    }
+
+    LogCursor cursor{ data + 5, data + size };
+    ReplayHost host(cursor);
+    OverlayEngine engine(host);
+    EngineRecorder rerecord;
+    engine.SetRecorder(&rerecord);
+
+    std::uint64_t startMs = 0;
+    std::uint64_t nowMs = 0;
+    std::uint64_t lastMatchedMs = 0;
+    bool started = false;
+    AppConfig cfg;
+
+    while (cursor.p < cursor.end)
+    {
+        const std::uint8_t tag = *cursor.p++;
+        const auto type = (EngineRecordType)(tag & 0x0F);
+
+        if (type == EngineRecordType::Checkpoint)
+        {
+            if (cursor.end - cursor.p < 4)
+            {
+                out.malformed = true;
+                break;
+            }
+            cursor.p += 4;
+            // 重新生成的记录到这里为止应与原记录完全一致
+            const size_t offset = (size_t)(cursor.p - data);
+            if (rerecord.Data().size() != offset || std::memcmp(rerecord.Data().data(), data, offset) != 0)
+            {
+                break;
+            }
+            out.checkpoints++;
+            lastMatchedMs = nowMs;
+            continue;
+        }
+
+        std::uint64_t delta;
+        if (!ReadVarint(cursor.p, cursor.end, delta))
+        {
+            out.malformed = true;
+            break;
+        }
+        nowMs = started ? nowMs + delta : delta;
+        if (!started)
+        {
+            startMs = nowMs;
+            started = true;
+        }
+        out.inputs++;
+
+        switch (type)
+        {
+        case EngineRecordType::Start:
+            if (!ReadConfig(cursor, cfg)) { out.malformed = true; break; }
+            engine.Start(nowMs, cfg);
+            break;
+        case EngineRecordType::Timer:
+            engine.OnTimer((EngineTimer)(tag >> 4), nowMs);
+            break;
+        case EngineRecordType::Activity:
+            engine.OnActivity(nowMs);
+            break;
+        case EngineRecordType::Config:
+            if (!ReadConfig(cursor, cfg)) { out.malformed = true; break; }
+            engine.OnConfigSaved(nowMs, cfg);
+            break;
+        case EngineRecordType::Preview:
+            if (!ReadConfig(cursor, cfg)) { out.malformed = true; break; }
+            engine.OnPreview(nowMs, cfg);
+            break;
+        case EngineRecordType::DisplayChange:
+            engine.OnDisplayChange(nowMs);
+            break;
+        case EngineRecordType::Exit:
+            engine.OnExit(nowMs);
+            break;
+        case EngineRecordType::Snooze:
+        {
+            std::uint64_t minutes;
+            if (!ReadVarint(cursor.p, cursor.end, minutes)) { out.malformed = true; break; }
+            engine.OnSnooze(nowMs, (std::uint32_t)minutes);
+            break;
+        }
+        case EngineRecordType::TriggerNow:
+            engine.OnTriggerNow(nowMs);
+            break;
+        case EngineRecordType::Presence:
+            engine.OnPresence(nowMs, (tag >> 4) != 0);
+            break;
+        case EngineRecordType::Resume:
+        {
+            std::uint64_t delayMs;
+            if (!ReadVarint(cursor.p, cursor.end, delayMs) || delayMs > 0xFFFFFFFFull) { out.malformed = true; break; }
+            engine.OnResume(nowMs, (std::uint32_t)delayMs);
+            break;
+        }
+        default:
+            // ShowFailed / Policy 只应由 ReplayHost 在引擎询问时读取
+            out.malformed = true;
+            break;
+        }
+        if (out.malformed)
+        {
+            break;
+        }
+    }
+
+    out.matched = !out.malformed && rerecord.Data().size() == size && std::memcmp(rerecord.Data().data(), data, size) == 0;
+    out.divergedAtMs = out.matched ? 0 : lastMatchedMs;
+    out.durationMs = nowMs - startMs;
+    out.alphaChanges = host.alphaChanges;
+    out.finalState = engine.State();
+    return out.matched;
+}
+
+bool EngineReplay_RunFile(const std::filesystem::path& path, EngineReplayResult& out)
+{
+    MappedFile file;
+    if (!file.OpenRead(path))
+    {
+        out = EngineReplayResult{};
+        out.malformed = true;
+        return false;
+    }
+    return EngineReplay_Run(file.data(), file.size(), out);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "config.h"
+#include "overlay_engine.h"
+
+// 会话记录：按时间顺序保存引擎的全部输入（计时器到点、键鼠活动、配置、预览、显示器变化、退出），
+// 以及每次状态转移后的输出哈希。每条记录为 varint 时间增量 + 1 字节类型（计时器编号在高 4 位）。
+
+enum class EngineRecordType : std::uint8_t
+{
+    Start = 1,        // 绝对时间 + 配置
+    Timer = 2,
+    Activity = 3,
+    Config = 4,
+    Preview = 5,
+    DisplayChange = 6,
+    Exit = 7,
+    ShowFailed = 8,   // 显示遮罩失败，由宿主决定，回放时按记录重现
+    Checkpoint = 9,   // 4 字节输出哈希，不带时间
+    Snooze = 10,      // varint 分钟数
+    TriggerNow = 11,
+    Resume = 12,      // varint 毫秒数
+    Policy = 13,      // 计时到点时宿主推迟或跳过了提醒，决定在高 4 位；回放时按记录重现
+    Presence = 14,    // 用户离开 / 回来，高 4 位为 1 表示回来
+};
+
+constexpr std::uint32_t ENGINE_LOG_MAGIC = 0x45525353; // "SSRE"
+constexpr std::uint8_t ENGINE_LOG_VERSION = 1;
+
+class EngineRecorder
+{
+public:
+    EngineRecorder();
+
+    void Input(EngineRecordType type, std::uint64_t nowMs);
+    void Timer(EngineTimer id, std::uint64_t nowMs);
+    void Config(EngineRecordType type, std::uint64_t nowMs, const AppConfig& cfg);
+    void Snooze(std::uint64_t nowMs, std::uint32_t minutes);
+    void Resume(std::uint64_t nowMs, std::uint32_t delayMs);
+    void Policy(std::uint64_t nowMs, EngineShowPolicy policy);
+    void Presence(std::uint64_t nowMs, bool present);
+    void Checkpoint(std::uint32_t outputHash);
+
+    const std::string& Data() const { return m_data; }
+    std::uint64_t Records() const { return m_records; }
+    bool WriteFile(const std::filesystem::path& path) const;
+
+private:
+    void Header(EngineRecordType type, std::uint8_t extra, std::uint64_t nowMs);
+
+    std::string m_data;
+    std::string m_scratch;
+    std::uint64_t m_lastMs = 0;
+    std::uint64_t m_records = 0;
+    bool m_started = false;
+};
+
+struct EngineReplayResult
+{
+    std::uint64_t inputs = 0;
+    std::uint64_t checkpoints = 0;        // 与记录一致的状态转移数
+    bool matched = false;                 // 回放重新生成的记录与原记录逐字节一致
+    std::uint64_t divergedAtMs = 0;       // 不一致时，第一处差异之前最后一条记录的时间
+    std::uint64_t durationMs = 0;         // 记录覆盖的虚拟时长
+    std::uint64_t alphaChanges = 0;
+    OverlayState finalState = OverlayState::Hidden;
+    bool malformed = false;
+};
+
+// 以虚拟时间重放记录：时间直接取自记录，不等待
+bool EngineReplay_Run(const std::uint8_t* data, size_t size, EngineReplayResult& out);
+bool EngineReplay_RunFile(const std::filesystem::path& path, EngineReplayResult& out);
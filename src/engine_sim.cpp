@@ -0,0 +1,229 @@
+#include "engine_sim.h"
+
+#include <algorithm>
+
+#include "presence.h"
+
+void VirtualEngineHost::SetTimer(EngineTimer id, std::uint32_t periodMs)
+{
+    const int slot = (int)id;
+    m_active[slot] = true;
+    m_period[slot] = std::max<std::uint32_t>(1, periodMs);
+    m_deadline[slot] = m_nowMs + m_period[slot];
+}
+
+void VirtualEngineHost::KillTimer(EngineTimer id)
+{
+    m_active[(int)id] = false;
+}
+
+bool VirtualEngineHost::TimerDeadline(EngineTimer id, std::uint64_t& deadlineMs) const
+{
+    const int slot = (int)id;
+    if (!m_active[slot])
+    {
+        return false;
+    }
+    deadlineMs = m_deadline[slot];
+    return true;
+}
+
+void VirtualEngineHost::OnStateChanged(OverlayState prev, OverlayState next)
+{
+    transitions++;
+    if (prev == OverlayState::Hidden && next == OverlayState::FadingIn)
+    {
+        reminders++;
+    }
+}
+
+EngineShowPolicy VirtualEngineHost::QueryShowPolicy()
+{
+    return m_policy ? m_policy->Evaluate(m_mode, m_monitors, m_nowMs) : EngineShowPolicy::Show;
+}
+
+std::uint64_t VirtualEngineHost::RunUntil(OverlayEngine& engine, std::uint64_t untilMs, bool stopOnTransition)
+{
+    const std::uint64_t transitionsBefore = transitions;
+    std::uint64_t fired = 0;
+    for (;;)
+    {
+        int next = -1;
+        for (int i = 0; i < TIMER_SLOTS; i++)
+        {
+            if (m_active[i] && m_deadline[i] <= untilMs && (next < 0 || m_deadline[i] < m_deadline[next]))
+            {
+                next = i;
+            }
+        }
+        if (next < 0)
+        {
+            break;
+        }
+        m_nowMs = m_deadline[next];
+        m_deadline[next] += m_period[next];
+        engine.OnTimer((EngineTimer)next, m_nowMs);
+        fired++;
+        if (stopOnTransition && transitions != transitionsBefore)
+        {
+            timerFirings += fired;
+            return fired;
+        }
+    }
+    timerFirings += fired;
+    m_nowMs = std::max(m_nowMs, untilMs);
+    return fired;
+}
+
+namespace
+{
+    struct Lcg
+    {
+        std::uint32_t state;
+        std::uint32_t Next()
+        {
+            state = state * 1664525u + 1013904223u;
+            return state >> 8;
+        }
+        std::uint32_t Range(std::uint32_t lo, std::uint32_t hi)
+        {
+            return hi <= lo ? lo : lo + Next() % (hi - lo + 1);
+        }
+    };
+
+    // 周期性地进入全屏，全屏时占据第一个显示器
+    class SimForeground final : public ForegroundStateProvider
+    {
+    public:
+        SimForeground(std::uint64_t everyMs, std::uint64_t forMs) : m_everyMs(everyMs), m_forMs(forMs) {}
+
+        ForegroundState Current(std::uint64_t nowMs) override
+        {
+            ForegroundState state;
+            state.fullscreen = m_everyMs != 0 && nowMs % m_everyMs < m_forMs;
+            state.monitor = ScreenRect{ 0, 0, 1920, 1080 };
+            return state;
+        }
+
+    private:
+        std::uint64_t m_everyMs;
+        std::uint64_t m_forMs;
+    };
+}
+
+void EngineSim_Run(const EngineSimOptions& options, EngineSimResult& out, EngineRecorder* recorder)
+{
+    VirtualEngineHost host;
+    OverlayEngine engine(host);
+    engine.SetRecorder(recorder);
+    Lcg rng{ options.seed * 2654435761u + 1 };
+
+    AppConfig cfg = options.config;
+    SimForeground foreground(options.fullscreenEveryMs, options.fullscreenForMs);
+    FullscreenPolicy policy(foreground);
+    host.SetFullscreenPolicy(&policy, (FullscreenMode)cfg.fullscreenMode, options.monitors);
+    const std::uint64_t startMs = 1000;
+    host.SetNow(startMs);
+    engine.Start(startMs, cfg);
+
+    const std::uint64_t endMs = startMs + options.durationMs;
+    std::uint64_t nextConfigMs = options.configChangeEveryMs ? startMs + options.configChangeEveryMs : endMs;
+    std::uint64_t nextDisplayMs = options.displayChangeEveryMs ? startMs + options.displayChangeEveryMs : endMs;
+    std::uint64_t nextPreviewMs = options.previewEveryMs ? startMs + options.previewEveryMs : endMs;
+    std::uint64_t nextSnoozeMs = options.snoozeEveryMs ? startMs + options.snoozeEveryMs : endMs;
+    std::uint64_t nextTriggerMs = options.triggerEveryMs ? startMs + options.triggerEveryMs : endMs;
+    std::uint64_t activityMs = 0;
+    std::uint64_t activities = 0;
+    // 离开：锁屏 → 显示器关闭 → 显示器亮起 → 解锁，四步均分离开时长
+    PresenceTracker presence;
+    std::uint64_t nextAwayMs = options.awayEveryMs ? startMs + options.awayEveryMs : endMs;
+    std::uint64_t awayStepMs = 0;
+    int awayStep = 0;
+    std::uint64_t awayBreaks = 0;
+
+    while (host.Now() < endMs)
+    {
+        // 淡入完成后安排一次用户活动
+        if (engine.State() == OverlayState::WaitingInput && activityMs == 0)
+        {
+            activityMs = host.Now() + rng.Range(options.minAwayMs, options.maxAwayMs);
+        }
+
+        std::uint64_t until = std::min({ endMs, nextConfigMs, nextDisplayMs, nextPreviewMs, nextSnoozeMs, nextTriggerMs, nextAwayMs });
+        if (activityMs != 0)
+        {
+            until = std::min(until, activityMs);
+        }
+        // 状态一变就停下来，以便在淡入完成时安排用户活动
+        host.RunUntil(engine, until, true);
+        const std::uint64_t now = host.Now();
+
+        if (activityMs != 0 && now >= activityMs)
+        {
+            activityMs = 0;
+            activities++;
+            engine.OnActivity(now);
+        }
+        if (now >= nextConfigMs)
+        {
+            cfg.intervalMinutes = (int)rng.Range(10, 45);
+            cfg.fadeSeconds = (int)rng.Range(1, 8);
+            cfg.opacityPercent = (int)rng.Range(30, 90);
+            cfg.fullscreenMode = (int)rng.Range(0, 3);
+            host.SetFullscreenPolicy(&policy, (FullscreenMode)cfg.fullscreenMode, options.monitors);
+            engine.OnConfigSaved(now, cfg);
+            nextConfigMs += options.configChangeEveryMs;
+        }
+        if (now >= nextDisplayMs)
+        {
+            engine.OnDisplayChange(now);
+            nextDisplayMs += options.displayChangeEveryMs;
+        }
+        if (now >= nextPreviewMs)
+        {
+            AppConfig preview = cfg;
+            preview.fadeSeconds = 1;
+            engine.OnPreview(now, preview);
+            nextPreviewMs += options.previewEveryMs;
+        }
+        if (now >= nextSnoozeMs)
+        {
+            engine.OnSnooze(now, rng.Range(5, 30));
+            nextSnoozeMs += options.snoozeEveryMs;
+        }
+        if (now >= nextTriggerMs)
+        {
+            engine.OnTriggerNow(now);
+            nextTriggerMs += options.triggerEveryMs;
+        }
+        if (now >= nextAwayMs)
+        {
+            if (awayStep == 0)
+            {
+                awayStepMs = rng.Range(options.minAbsenceMs, options.maxAbsenceMs) / 3;
+            }
+            static constexpr PresenceReason kSteps[] = { PRESENCE_LOCKED, PRESENCE_DISPLAY_OFF, PRESENCE_DISPLAY_OFF, PRESENCE_LOCKED };
+            if (presence.Set(kSteps[awayStep], awayStep < 2, now))
+            {
+                activityMs = 0;
+                awayBreaks += engine.OnPresence(now, presence.IsPresent()) ? 1 : 0;
+            }
+            awayStep = (awayStep + 1) % 4;
+            nextAwayMs = awayStep == 0 ? nextAwayMs - 3 * awayStepMs + options.awayEveryMs : now + awayStepMs;
+        }
+    }
+    engine.OnExit(host.Now());
+
+    out.reminders = host.reminders;
+    out.transitions = host.transitions;
+    out.timerFirings = host.timerFirings;
+    out.alphaChanges = host.alphaChanges;
+    out.activities = activities;
+    out.deferred = policy.Stats().deferred;
+    out.suppressed = policy.Stats().suppressed;
+    out.partial = policy.Stats().partial;
+    out.absences = presence.Stats().absences;
+    out.awayBreaks = awayBreaks;
+    out.outputHash = engine.OutputHash();
+    out.finalState = engine.State();
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+
+#include "config.h"
+#include "fullscreen_policy.h"
+#include "overlay_engine.h"
+
+// 虚拟时钟宿主：计时器按截止时间排队，时间直接跳到下一个到点的计时器，
+// 不真正等待，一周的使用可以在很短时间内跑完。
+class VirtualEngineHost : public EngineHost
+{
+public:
+    void SetTimer(EngineTimer id, std::uint32_t periodMs) override;
+    void KillTimer(EngineTimer id) override;
+    bool ShowSurfaces() override { m_visible = m_surfacesAvailable; return m_surfacesAvailable; }
+    void HideSurfaces() override { m_visible = false; }
+    void SetAlpha(std::uint8_t alpha) override { m_alpha = alpha; alphaChanges++; }
+    void InvalidateSurfaces() override { repaints++; }
+    void ReconcileSurfaces() override { reconciles++; }
+    void StartInput() override { m_inputActive = true; }
+    void StopInput() override { m_inputActive = false; }
+    void ResetActivityLatch() override {}
+    void OnStateChanged(OverlayState prev, OverlayState next) override;
+    EngineShowPolicy QueryShowPolicy() override;
+
+    void SetSurfacesAvailable(bool available) { m_surfacesAvailable = available; }
+    // 设置后计时到点时按全屏策略决定是否显示；policy 为 nullptr 时总是显示
+    void SetFullscreenPolicy(FullscreenPolicy* policy, FullscreenMode mode, size_t monitors)
+    {
+        m_policy = policy;
+        m_mode = mode;
+        m_monitors = monitors;
+    }
+
+    std::uint64_t Now() const { return m_nowMs; }
+    void SetNow(std::uint64_t nowMs) { m_nowMs = nowMs; }
+
+    // 依次触发 untilMs 之前到点的计时器；stopOnTransition 时在第一次状态转移后提前返回。
+    // 返回触发次数
+    std::uint64_t RunUntil(OverlayEngine& engine, std::uint64_t untilMs, bool stopOnTransition = false);
+
+    // 计时器未启动时返回 false
+    bool TimerDeadline(EngineTimer id, std::uint64_t& deadlineMs) const;
+
+    bool IsVisible() const { return m_visible; }
+    bool IsInputActive() const { return m_inputActive; }
+    std::uint8_t Alpha() const { return m_alpha; }
+
+    std::uint64_t alphaChanges = 0;
+    std::uint64_t repaints = 0;
+    std::uint64_t reconciles = 0;
+    std::uint64_t transitions = 0;
+    std::uint64_t reminders = 0;
+    std::uint64_t timerFirings = 0;
+
+private:
+    static constexpr int TIMER_SLOTS = 4;
+
+    std::uint64_t m_nowMs = 0;
+    std::uint64_t m_deadline[TIMER_SLOTS]{};
+    std::uint32_t m_period[TIMER_SLOTS]{};
+    bool m_active[TIMER_SLOTS]{};
+    bool m_visible = false;
+    bool m_inputActive = false;
+    bool m_surfacesAvailable = true;
+    std::uint8_t m_alpha = 0;
+    FullscreenPolicy* m_policy = nullptr;
+    FullscreenMode m_mode = FullscreenMode::Show;
+    size_t m_monitors = 1;
+};
+
+struct EngineSimOptions
+{
+    std::uint64_t durationMs = 7ull * 24 * 3600 * 1000;
+    std::uint32_t seed = 1;
+    AppConfig config{};
+    // 遮罩淡入完成后用户多久才有键鼠活动，在此区间内随机
+    std::uint32_t minAwayMs = 2000;
+    std::uint32_t maxAwayMs = 300000;
+    // 每隔多久保存一次设置（随机改动间隔与淡入淡出时长），0 表示不改
+    std::uint64_t configChangeEveryMs = 24ull * 3600 * 1000;
+    std::uint64_t displayChangeEveryMs = 6ull * 3600 * 1000;
+    std::uint64_t previewEveryMs = 12ull * 3600 * 1000;
+    // 通过控制端点发来的推迟与立即提醒
+    std::uint64_t snoozeEveryMs = 9ull * 3600 * 1000;
+    std::uint64_t triggerEveryMs = 17ull * 3600 * 1000;
+    // 每隔多久进入一次全屏（游戏、视频），持续多久；策略取自配置，设置保存时随机切换
+    std::uint64_t fullscreenEveryMs = 5ull * 3600 * 1000;
+    std::uint64_t fullscreenForMs = 90ull * 60 * 1000;
+    size_t monitors = 2;
+    // 每隔多久离开一次（锁屏并关闭显示器），离开时长在此区间内随机
+    std::uint64_t awayEveryMs = 11ull * 3600 * 1000;
+    std::uint32_t minAbsenceMs = 15000;
+    std::uint32_t maxAbsenceMs = 3 * 3600 * 1000;
+};
+
+struct EngineSimResult
+{
+    std::uint64_t reminders = 0;
+    std::uint64_t transitions = 0;
+    std::uint64_t timerFirings = 0;
+    std::uint64_t alphaChanges = 0;
+    std::uint64_t activities = 0;
+    std::uint64_t deferred = 0;
+    std::uint64_t suppressed = 0;
+    std::uint64_t partial = 0;
+    std::uint64_t absences = 0;
+    std::uint64_t awayBreaks = 0;       // 离开按休息处理的次数
+    std::uint32_t outputHash = 0;
+    OverlayState finalState = OverlayState::Hidden;
+};
+
+// 以虚拟时间模拟一段使用过程；传入 recorder 时同时生成可回放的会话记录
+void EngineSim_Run(const EngineSimOptions& options, EngineSimResult& out, EngineRecorder* recorder = nullptr);
@@ -0,0 +1,62 @@
+#include "fullscreen_policy.h"
+
+ForegroundState ForegroundStateCache::Current(std::uint64_t nowMs)
+{
+    if (m_dirty || nowMs < m_probedAtMs || nowMs - m_probedAtMs >= m_maxAgeMs)
+    {
+        m_state = m_probe.Current(nowMs);
+        m_probedAtMs = nowMs;
+        m_probes++;
+        m_dirty = false;
+    }
+    return m_state;
+}
+
+FullscreenAction FullscreenPolicy_Decide(FullscreenMode mode, const ForegroundState& state, size_t monitorCount)
+{
+    if (!state.fullscreen && !state.presentation && !state.exclusive)
+    {
+        return FullscreenAction::Show;
+    }
+    switch (mode)
+    {
+    case FullscreenMode::Show:
+        return FullscreenAction::Show;
+    case FullscreenMode::Suppress:
+        return FullscreenAction::Suppress;
+    case FullscreenMode::OtherMonitors:
+        // 独占全屏时任何置顶窗口都可能让游戏切出，只能推迟
+        if (state.fullscreen && !state.exclusive && monitorCount > 1 && state.monitor.Width() > 0 && state.monitor.Height() > 0)
+        {
+            return FullscreenAction::ShowOthers;
+        }
+        return FullscreenAction::Defer;
+    case FullscreenMode::Defer:
+    default:
+        return FullscreenAction::Defer;
+    }
+}
+
+EngineShowPolicy FullscreenPolicy::Evaluate(FullscreenMode mode, size_t monitorCount, std::uint64_t nowMs)
+{
+    m_stats.evaluations++;
+    // 选“照常显示”时不必探测
+    const ForegroundState state = mode == FullscreenMode::Show ? ForegroundState{} : m_provider.Current(nowMs);
+    m_lastAction = FullscreenPolicy_Decide(mode, state, monitorCount);
+    switch (m_lastAction)
+    {
+    case FullscreenAction::ShowOthers:
+        m_skip = state.monitor;
+        m_stats.partial++;
+        return EngineShowPolicy::Show;
+    case FullscreenAction::Defer:
+        m_stats.deferred++;
+        return EngineShowPolicy::Defer;
+    case FullscreenAction::Suppress:
+        m_stats.suppressed++;
+        return EngineShowPolicy::Suppress;
+    case FullscreenAction::Show:
+    default:
+        return EngineShowPolicy::Show;
+    }
+}
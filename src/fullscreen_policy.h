@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "overlay_engine.h"
+#include "overlay_surface.h"
+
+// 前台是全屏游戏、视频或演示时，置顶的分层遮罩会强制 DWM 合成并拖慢前台应用。
+// 计时到点时按配置决定照常显示、推迟、跳过本次，或只显示在其他显示器上。
+
+enum class FullscreenMode : int
+{
+    Show = 0,
+    Defer = 1,
+    Suppress = 2,
+    OtherMonitors = 3,
+};
+
+struct ForegroundState
+{
+    bool fullscreen = false;    // 前台窗口覆盖了它所在的整个显示器
+    bool presentation = false;  // 系统处于演示模式 / 全屏应用的免打扰状态
+    bool exclusive = false;     // D3D 独占全屏
+    ScreenRect monitor{};       // 前台窗口所在的显示器
+};
+
+class ForegroundStateProvider
+{
+public:
+    virtual ~ForegroundStateProvider() = default;
+    virtual ForegroundState Current(std::uint64_t nowMs) = 0;
+};
+
+// 缓存探测结果：只有窗口事件调用 Invalidate()、或缓存超过 maxAgeMs 时才重新探测，
+// 计时到点时读取的是缓存，不在高频计时器里轮询
+class ForegroundStateCache final : public ForegroundStateProvider
+{
+public:
+    ForegroundStateCache(ForegroundStateProvider& probe, std::uint32_t maxAgeMs) : m_probe(probe), m_maxAgeMs(maxAgeMs) {}
+
+    void Invalidate() { m_dirty = true; }
+    ForegroundState Current(std::uint64_t nowMs) override;
+
+    std::uint64_t Probes() const { return m_probes; }
+
+private:
+    ForegroundStateProvider& m_probe;
+    std::uint32_t m_maxAgeMs;
+    ForegroundState m_state{};
+    std::uint64_t m_probedAtMs = 0;
+    std::uint64_t m_probes = 0;
+    bool m_dirty = true;
+};
+
+enum class FullscreenAction : std::uint8_t
+{
+    Show,
+    ShowOthers,   // 跳过前台全屏所在的显示器
+    Defer,
+    Suppress,
+};
+
+// 独占全屏与没有具体显示器的演示模式下，“只显示在其他显示器”退化为推迟
+FullscreenAction FullscreenPolicy_Decide(FullscreenMode mode, const ForegroundState& state, size_t monitorCount);
+
+struct FullscreenPolicyStats
+{
+    std::uint64_t evaluations = 0;
+    std::uint64_t deferred = 0;
+    std::uint64_t suppressed = 0;
+    std::uint64_t partial = 0;
+};
+
+class FullscreenPolicy
+{
+public:
+    explicit FullscreenPolicy(ForegroundStateProvider& provider) : m_provider(provider) {}
+
+    // 转成引擎的决定；ShowOthers 对引擎来说就是显示，跳过哪个显示器由 SkipMonitor() 给出
+    EngineShowPolicy Evaluate(FullscreenMode mode, size_t monitorCount, std::uint64_t nowMs);
+
+    FullscreenAction LastAction() const { return m_lastAction; }
+    // 仅当 LastAction() == ShowOthers 时有意义
+    const ScreenRect& SkipMonitor() const { return m_skip; }
+    const FullscreenPolicyStats& Stats() const { return m_stats; }
+
+private:
+    ForegroundStateProvider& m_provider;
+    FullscreenAction m_lastAction = FullscreenAction::Show;
+    ScreenRect m_skip{};
+    FullscreenPolicyStats m_stats{};
+};
@@ -0,0 +1,518 @@
+#include "headless.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+
+#include "config_schema.h"
+
+namespace
+{
+    std::string_view Trim(std::string_view s)
+    {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        {
+            s.remove_prefix(1);
+        }
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r' || s.back() == '\n'))
+        {
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+
+    template <typename T>
+    bool ParseNumber(std::string_view s, T& out)
+    {
+        const auto result = std::from_chars(s.data(), s.data() + s.size(), out);
+        return result.ec == std::errc() && result.ptr == s.data() + s.size();
+    }
+
+    void AppendField(std::string& out, const char* key, long long value)
+    {
+        out += ",\"";
+        out += key;
+        out += "\":";
+        out += std::to_string(value);
+    }
+
+    void AppendField(std::string& out, const char* key, std::string_view value)
+    {
+        out += ",\"";
+        out += key;
+        out += "\":";
+        Headless_AppendJsonString(out, value);
+    }
+
+    void AppendBool(std::string& out, const char* key, bool value)
+    {
+        out += ",\"";
+        out += key;
+        out += value ? "\":true" : "\":false";
+    }
+
+    void AppendLine(std::string& out, const char* key, long long value)
+    {
+        out += key;
+        out += '=';
+        out += std::to_string(value);
+        out += '\n';
+    }
+}
+
+void Headless_AppendJsonString(std::string& out, std::string_view s)
+{
+    out += '"';
+    for (char c : s)
+    {
+        switch (c)
+        {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20)
+            {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+                out += buf;
+            }
+            else
+            {
+                out += c;
+            }
+            break;
+        }
+    }
+    out += '"';
+}
+
+const char* Headless_TransitionEvent(OverlayState prev, OverlayState next)
+{
+    if (prev == OverlayState::Hidden && next == OverlayState::FadingIn)
+    {
+        return "reminder";
+    }
+    if (prev == OverlayState::FadingIn && next == OverlayState::WaitingInput)
+    {
+        return "fade_in_done";
+    }
+    if (next == OverlayState::FadingOut)
+    {
+        return "dismiss";
+    }
+    if (prev == OverlayState::FadingOut && next == OverlayState::Hidden)
+    {
+        return "fade_out_done";
+    }
+    if (next == OverlayState::Hidden)
+    {
+        return "hidden";
+    }
+    return "state";
+}
+
+void HeadlessRunner::EventHost::OnStateChanged(OverlayState prev, OverlayState next)
+{
+    VirtualEngineHost::OnStateChanged(prev, next);
+    m_runner.OnTransition(prev, next);
+}
+
+HeadlessRunner::HeadlessRunner(const HeadlessOptions& options, Sink sink)
+    : m_options(options), m_sink(std::move(sink)), m_host(*this), m_engine(m_host)
+{
+    m_useLayers = !options.policyDir.empty() || !options.configIni.empty() || !options.textFile.empty();
+    if (m_useLayers)
+    {
+        m_layers.SetSources(options.policyDir, options.configIni, options.textFile);
+    }
+}
+
+std::string& HeadlessRunner::BeginEvent(const char* event)
+{
+    m_line.clear();
+    m_line += "{\"t\":";
+    m_line += std::to_string(m_host.Now());
+    m_line += ",\"event\":\"";
+    m_line += event;
+    m_line += '"';
+    return m_line;
+}
+
+void HeadlessRunner::EndEvent()
+{
+    m_line += '}';
+    m_stats.events++;
+    m_sink(m_line);
+}
+
+void HeadlessRunner::Error(std::string_view message)
+{
+    m_stats.errors++;
+    AppendField(BeginEvent("error"), "message", message);
+    EndEvent();
+}
+
+void HeadlessRunner::ReportPolicyProblems()
+{
+    for (const std::string& problem : m_layers.Problems())
+    {
+        Error("policy " + problem);
+    }
+}
+
+void HeadlessRunner::Start(std::uint64_t nowMs)
+{
+    m_host.SetNow(nowMs);
+    if (m_useLayers)
+    {
+        m_layers.Load();
+        m_config = m_layers.Merged();
+        ReportPolicyProblems();
+    }
+    else
+    {
+        m_config = m_options.config;
+        Config_Normalize(m_config);
+    }
+    StartupProfile* startup = m_options.startup;
+    if (startup)
+    {
+        startup->Mark("config_load");
+    }
+    m_engine.Start(nowMs, m_config);
+
+    std::string& line = BeginEvent("start");
+    AppendField(line, "clock", m_options.stepClock ? "step" : "timed");
+    AppendField(line, "interval_minutes", m_config.intervalMinutes);
+    AppendField(line, "fade_seconds", m_config.fadeSeconds);
+    AppendField(line, "locked", (long long)m_layers.Locked());
+    EndEvent();
+
+    if (startup)
+    {
+        startup->Mark("engine_start");
+        startup->Finish();
+        std::string& out = BeginEvent("startup");
+        for (int i = 0; i < startup->PhaseCount(); i++)
+        {
+            const StartupPhase& phase = startup->Phase(i);
+            AppendField(out, (std::string(phase.name) + "_us").c_str(), (long long)phase.durUs);
+        }
+        AppendField(out, "total_us", (long long)startup->TotalUs());
+        AppendField(out, "budget_us", (long long)kStartupBudgetUs);
+        AppendField(out, "over_budget", startup->OverBudget() ? 1 : 0);
+        EndEvent();
+    }
+}
+
+void HeadlessRunner::OnTransition(OverlayState prev, OverlayState next)
+{
+    if (next != OverlayState::WaitingInput)
+    {
+        m_activityMs = 0;
+    }
+
+    const char* event = Headless_TransitionEvent(prev, next);
+    if (prev == OverlayState::Hidden && next == OverlayState::FadingIn)
+    {
+        m_stats.reminders++;
+    }
+    else if (next == OverlayState::FadingOut)
+    {
+        m_stats.dismissals++;
+    }
+
+    std::string& line = BeginEvent(event);
+    AppendField(line, "from", OverlayFsm_StateName(prev));
+    AppendField(line, "to", OverlayFsm_StateName(next));
+    if (next == OverlayState::FadingIn)
+    {
+        AppendBool(line, "preview", m_engine.IsPreview());
+    }
+    if (next == OverlayState::WaitingInput)
+    {
+        AppendField(line, "alpha", m_engine.Alpha());
+    }
+    EndEvent();
+}
+
+std::uint64_t HeadlessRunner::NextDeadline() const
+{
+    std::uint64_t next = UINT64_MAX;
+    for (EngineTimer id : { EngineTimer::Interval, EngineTimer::Anim, EngineTimer::Clock })
+    {
+        std::uint64_t deadline;
+        if (m_host.TimerDeadline(id, deadline) && deadline < next)
+        {
+            next = deadline;
+        }
+    }
+    if (m_options.autoActivityMs != 0 && m_engine.State() == OverlayState::WaitingInput)
+    {
+        const std::uint64_t activity = m_activityMs != 0 ? m_activityMs : m_host.Now() + m_options.autoActivityMs;
+        next = std::min(next, activity);
+    }
+    return next;
+}
+
+void HeadlessRunner::AdvanceTo(std::uint64_t nowMs)
+{
+    for (;;)
+    {
+        // 淡入完成后安排一次自动活动
+        if (m_options.autoActivityMs != 0 && m_engine.State() == OverlayState::WaitingInput && m_activityMs == 0)
+        {
+            m_activityMs = m_host.Now() + m_options.autoActivityMs;
+        }
+
+        std::uint64_t until = nowMs;
+        if (m_activityMs != 0 && m_activityMs < until)
+        {
+            until = m_activityMs;
+        }
+        const std::uint64_t transitions = m_host.transitions;
+        m_host.RunUntil(m_engine, until, true);
+
+        if (m_activityMs != 0 && m_host.Now() >= m_activityMs)
+        {
+            m_activityMs = 0;
+            m_stats.activities++;
+            m_engine.OnActivity(m_host.Now());
+            continue;
+        }
+        // 状态转移时提前返回过，同一时刻可能还有计时器没触发
+        if (m_host.transitions == transitions && m_host.Now() >= nowMs)
+        {
+            break;
+        }
+    }
+}
+
+bool HeadlessRunner::ReloadConfig()
+{
+    if (!m_useLayers)
+    {
+        return false;
+    }
+    const bool changed = m_layers.Load();
+    if (changed)
+    {
+        m_config = m_layers.Merged();
+        m_engine.OnConfigSaved(m_host.Now(), m_config);
+        ReportPolicyProblems();
+    }
+    std::string& line = BeginEvent("config");
+    AppendBool(line, "changed", changed);
+    AppendField(line, "interval_minutes", m_config.intervalMinutes);
+    AppendField(line, "fade_seconds", m_config.fadeSeconds);
+    AppendField(line, "locked", (long long)m_layers.Locked());
+    EndEvent();
+    return true;
+}
+
+bool HeadlessRunner::Execute(std::string_view line, std::uint64_t nowMs)
+{
+    line = Trim(line);
+    if (line.empty() || line.front() == '#')
+    {
+        return true;
+    }
+    m_stats.commands++;
+    AdvanceTo(std::max(nowMs, m_host.Now()));
+    const std::uint64_t now = m_host.Now();
+
+    const size_t space = line.find(' ');
+    const std::string_view verb = line.substr(0, space);
+    const std::string_view arg = space == std::string_view::npos ? std::string_view() : Trim(line.substr(space + 1));
+
+    if (verb == "activity")
+    {
+        m_stats.activities++;
+        m_activityMs = 0;
+        m_engine.OnActivity(now);
+    }
+    else if (verb == "trigger")
+    {
+        m_engine.OnTriggerNow(now);
+    }
+    else if (verb == "snooze")
+    {
+        std::uint32_t minutes = 0;
+        if (!ParseNumber(arg, minutes) || minutes == 0)
+        {
+            Error("snooze needs a positive number of minutes");
+            return true;
+        }
+        m_engine.OnSnooze(now, minutes);
+    }
+    else if (verb == "preview")
+    {
+        m_engine.OnPreview(now, m_config);
+    }
+    else if (verb == "display")
+    {
+        m_engine.OnDisplayChange(now);
+    }
+    else if (verb == "away" || verb == "back")
+    {
+        const bool present = verb == "back";
+        const bool credited = m_engine.OnPresence(now, present);
+        std::string& out = BeginEvent(present ? "back" : "away");
+        if (present)
+        {
+            AppendBool(out, "break", credited);
+        }
+        EndEvent();
+    }
+    else if (verb == "set")
+    {
+        // 与用户文件相同的规则：被策略锁定的键不能修改，整数键受策略范围限制
+        AppConfig cfg = m_config;
+        const std::uint32_t present = Config_ParseIniLayer(std::string("[") + kConfigSection + "]\n" + std::string(arg), cfg, nullptr);
+        if (present == 0)
+        {
+            Error("set needs <key>=<value> with a known key");
+            return true;
+        }
+        if (present & m_layers.Locked())
+        {
+            Error("key is locked by policy");
+            return true;
+        }
+        Config_Normalize(cfg);
+        Config_ApplyPolicyLimits(m_layers.Policy(), cfg);
+        m_config = cfg;
+        m_engine.OnConfigSaved(now, m_config);
+        std::string& out = BeginEvent("config");
+        AppendBool(out, "changed", true);
+        AppendField(out, "interval_minutes", m_config.intervalMinutes);
+        AppendField(out, "fade_seconds", m_config.fadeSeconds);
+        EndEvent();
+    }
+    else if (verb == "reload")
+    {
+        if (!ReloadConfig())
+        {
+            Error("no config sources (--config, --text or --policy)");
+        }
+    }
+    else if (verb == "status")
+    {
+        std::string& out = BeginEvent("status");
+        AppendField(out, "state", OverlayFsm_StateName(m_engine.State()));
+        AppendBool(out, "preview", m_engine.IsPreview());
+        AppendBool(out, "away", m_engine.IsAway());
+        AppendField(out, "alpha", m_engine.Alpha());
+        std::uint64_t deadline;
+        AppendField(out, "next_reminder_ms", m_host.TimerDeadline(EngineTimer::Interval, deadline) ? (long long)(deadline - now) : -1);
+        EndEvent();
+    }
+    else if (verb == "advance")
+    {
+        std::uint64_t ms = 0;
+        if (!m_options.stepClock)
+        {
+            Error("advance is only available with --simulate");
+            return true;
+        }
+        if (!ParseNumber(arg, ms))
+        {
+            Error("advance needs a number of milliseconds");
+            return true;
+        }
+        AdvanceTo(now + ms);
+    }
+    else if (verb == "quit")
+    {
+        return false;
+    }
+    else
+    {
+        Error("unknown command: " + std::string(verb));
+    }
+    return true;
+}
+
+void HeadlessRunner::WriteStatus(std::string& out) const
+{
+    out += "state=";
+    out += OverlayFsm_StateName(m_engine.State());
+    out += '\n';
+    AppendLine(out, "preview", m_engine.IsPreview() ? 1 : 0);
+    AppendLine(out, "away", m_engine.IsAway() ? 1 : 0);
+    AppendLine(out, "alpha", m_engine.Alpha());
+    AppendLine(out, "interval_minutes", m_config.intervalMinutes);
+    std::uint64_t deadline;
+    AppendLine(out, "next_reminder_ms", m_host.TimerDeadline(EngineTimer::Interval, deadline) ? (long long)(deadline - m_host.Now()) : -1);
+}
+
+void HeadlessRunner::HandleControl(const ControlRequest& request, ControlResponse& response, std::uint64_t nowMs)
+{
+    AdvanceTo(std::max(nowMs, m_host.Now()));
+    const std::uint64_t now = m_host.Now();
+    response.client = request.client;
+    response.id = request.id;
+    response.status = ControlStatus::Ok;
+    response.body.clear();
+
+    AppendField(BeginEvent("control"), "op", Control_OpName(request.op));
+    EndEvent();
+
+    switch (request.op)
+    {
+    case ControlOp::Status:
+        WriteStatus(response.body);
+        break;
+    case ControlOp::Snooze:
+    {
+        std::uint32_t minutes = 0;
+        if (!Control_ParseSnoozeArg(request.arg, minutes) || minutes == 0)
+        {
+            response.status = ControlStatus::BadRequest;
+            break;
+        }
+        m_engine.OnSnooze(now, minutes);
+        break;
+    }
+    case ControlOp::TriggerNow:
+        m_engine.OnTriggerNow(now);
+        break;
+    case ControlOp::ReloadConfig:
+        response.status = ReloadConfig() ? ControlStatus::Ok : ControlStatus::Failed;
+        break;
+    case ControlOp::Metrics:
+        AppendLine(response.body, "reminders", (long long)m_stats.reminders);
+        AppendLine(response.body, "dismissals", (long long)m_stats.dismissals);
+        AppendLine(response.body, "activities", (long long)m_stats.activities);
+        AppendLine(response.body, "commands", (long long)m_stats.commands);
+        AppendLine(response.body, "events", (long long)m_stats.events);
+        AppendLine(response.body, "transitions", (long long)m_host.transitions);
+        AppendLine(response.body, "timer_firings", (long long)m_host.timerFirings);
+        break;
+    default:
+        // 没有跟踪缓冲区与设置窗口
+        response.status = ControlStatus::Failed;
+        break;
+    }
+}
+
+void HeadlessRunner::Finish(std::uint64_t nowMs, double wallSeconds)
+{
+    AdvanceTo(std::max(nowMs, m_host.Now()));
+    m_engine.OnExit(m_host.Now());
+
+    std::string& line = BeginEvent("exit");
+    AppendField(line, "reminders", (long long)m_stats.reminders);
+    AppendField(line, "dismissals", (long long)m_stats.dismissals);
+    AppendField(line, "activities", (long long)m_stats.activities);
+    AppendField(line, "transitions", (long long)m_host.transitions);
+    AppendField(line, "timer_firings", (long long)m_host.timerFirings);
+    AppendField(line, "commands", (long long)m_stats.commands);
+    AppendField(line, "errors", (long long)m_stats.errors);
+    AppendField(line, "output_hash", (long long)m_engine.OutputHash());
+    AppendField(line, "wall_ms", (long long)(wallSeconds * 1000));
+    EndEvent();
+}
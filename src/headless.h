@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "config_layers.h"
+#include "control_protocol.h"
+#include "engine_sim.h"
+#include "startup_profile.h"
+
+// 无界面运行：与 Win32 程序同一个 OverlayEngine，没有遮罩窗口与键鼠钩子。
+// 提醒、淡入淡出与关闭以一行一个 JSON 对象输出；键鼠活动与命令按行输入：
+//   activity | trigger | snooze <分钟> | preview | display | away | back
+//   set <键>=<值> | reload | status | advance <毫秒> | quit
+// 时间由调用方传入：真实时钟、按倍数加速的时钟，或只随 advance 前进的虚拟时钟。
+
+struct HeadlessOptions
+{
+    AppConfig config{};
+    // 任一非空时按分层设置读取，reload 重新检查
+    std::filesystem::path policyDir;
+    std::filesystem::path configIni;
+    std::filesystem::path textFile;
+    // 淡入完成后多久自动产生一次键鼠活动，0 表示只由输入决定
+    std::uint32_t autoActivityMs = 0;
+    // 只随 advance 命令前进的虚拟时钟（--simulate）
+    bool stepClock = false;
+    // 非空时 Start 记录读取设置与启动引擎两个阶段，结束计时并输出 startup 行
+    StartupProfile* startup = nullptr;
+};
+
+struct HeadlessStats
+{
+    std::uint64_t commands = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t events = 0;
+    std::uint64_t reminders = 0;
+    std::uint64_t dismissals = 0;
+    std::uint64_t activities = 0;
+};
+
+class HeadlessRunner
+{
+public:
+    using Sink = std::function<void(std::string_view line)>;
+
+    HeadlessRunner(const HeadlessOptions& options, Sink sink);
+
+    void Start(std::uint64_t nowMs);
+    // 触发 nowMs 之前到点的计时器与自动活动
+    void AdvanceTo(std::uint64_t nowMs);
+    // 执行一行命令（先推进到 nowMs）；收到 quit 时返回 false
+    bool Execute(std::string_view line, std::uint64_t nowMs);
+    // 控制端点的请求；ReloadConfig 与 Execute("reload") 相同
+    void HandleControl(const ControlRequest& request, ControlResponse& response, std::uint64_t nowMs);
+    // 退出并输出汇总行
+    void Finish(std::uint64_t nowMs, double wallSeconds);
+
+    // 下一个计时器或自动活动的时间；没有时返回 UINT64_MAX
+    std::uint64_t NextDeadline() const;
+    std::uint64_t Now() const { return m_host.Now(); }
+
+    const OverlayEngine& Engine() const { return m_engine; }
+    const HeadlessStats& Stats() const { return m_stats; }
+    const VirtualEngineHost& Host() const { return m_host; }
+
+private:
+    class EventHost final : public VirtualEngineHost
+    {
+    public:
+        explicit EventHost(HeadlessRunner& runner) : m_runner(runner) {}
+        void OnStateChanged(OverlayState prev, OverlayState next) override;
+
+    private:
+        HeadlessRunner& m_runner;
+    };
+
+    void OnTransition(OverlayState prev, OverlayState next);
+    bool ReloadConfig();
+    void WriteStatus(std::string& out) const;
+    void Error(std::string_view message);
+    void ReportPolicyProblems();
+
+    // 输出行：{"t":…,"event":"…" 之后由调用方追加字段，EndEvent 补上 }
+    std::string& BeginEvent(const char* event);
+    void EndEvent();
+
+    HeadlessOptions m_options;
+    Sink m_sink;
+    EventHost m_host;
+    OverlayEngine m_engine;
+    LayeredConfig m_layers;
+    bool m_useLayers = false;
+    AppConfig m_config{};
+    std::uint64_t m_activityMs = 0;
+    std::string m_line;
+    HeadlessStats m_stats;
+};
+
+void Headless_AppendJsonString(std::string& out, std::string_view s);
+// 状态转移对应的事件名：reminder、fade_in_done、dismiss、fade_out_done、hidden，其余为 state
+const char* Headless_TransitionEvent(OverlayState prev, OverlayState next);
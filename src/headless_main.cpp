@@ -0,0 +1,261 @@
+// ssr_headless：无界面运行提醒引擎，供没有显示器的构建机做长时间运行与吞吐测试。
+//   ssr_headless                          按真实时间运行，stdin 输入命令，stdout 输出 JSON 行
+//   ssr_headless --simulate               虚拟时钟，只随 advance 命令前进；输入结束后跑到 --duration
+//   ssr_headless --simulate=60            时间按 60 倍加速
+//   ssr_headless --simulate --duration 604800000 --auto-activity 5000 < /dev/null
+//                                         一周的提醒，每次淡入完成 5 秒后自动关闭
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "control_server.h"
+#include "headless.h"
+
+namespace
+{
+    std::atomic<bool> g_stop{false};
+
+    void OnSignal(int)
+    {
+        g_stop.store(true);
+    }
+
+    // stdin 与控制端点的输入汇总到同一个队列，由主线程按到达顺序执行
+    struct InputQueue
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::string> lines;
+        std::vector<ControlRequest> requests;
+        bool eof = false;
+    };
+
+    void PrintUsage()
+    {
+        std::fprintf(stderr,
+            "usage: ssr_headless [--simulate[=<speed>]] [--duration <ms>] [--auto-activity <ms>]\n"
+            "                    [--config <ini>] [--text <file>] [--policy <dir>] [--set <key>=<value>]...\n"
+            "                    [--control[=<endpoint>]]\n");
+    }
+
+    bool StartsWith(const char* arg, const char* prefix)
+    {
+        return std::strncmp(arg, prefix, std::strlen(prefix)) == 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    static StartupProfile startup;
+    startup.Begin();
+    HeadlessOptions options;
+    options.startup = &startup;
+    double speed = 1;
+    std::uint64_t durationMs = 0;
+    bool control = false;
+    std::string endpoint;
+    std::vector<std::string> sets;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--simulate") == 0)
+        {
+            options.stepClock = true;
+            speed = 0;
+        }
+        else if (StartsWith(arg, "--simulate="))
+        {
+            speed = std::atof(arg + std::strlen("--simulate="));
+            if (speed <= 0)
+            {
+                PrintUsage();
+                return 2;
+            }
+        }
+        else if (std::strcmp(arg, "--duration") == 0 && i + 1 < argc)
+        {
+            durationMs = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(arg, "--auto-activity") == 0 && i + 1 < argc)
+        {
+            options.autoActivityMs = (std::uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(arg, "--config") == 0 && i + 1 < argc)
+        {
+            options.configIni = std::filesystem::u8path(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--text") == 0 && i + 1 < argc)
+        {
+            options.textFile = std::filesystem::u8path(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--policy") == 0 && i + 1 < argc)
+        {
+            options.policyDir = std::filesystem::u8path(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--set") == 0 && i + 1 < argc)
+        {
+            sets.push_back(std::string("set ") + argv[++i]);
+        }
+        else if (std::strcmp(arg, "--control") == 0)
+        {
+            control = true;
+            endpoint = ControlServer::DefaultEndpoint();
+        }
+        else if (StartsWith(arg, "--control="))
+        {
+            control = true;
+            endpoint = arg + std::strlen("--control=");
+        }
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    startup.Mark("args");
+
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+    std::ios::sync_with_stdio(false);
+
+    HeadlessRunner runner(options, [](std::string_view line)
+    {
+        std::fwrite(line.data(), 1, line.size(), stdout);
+        std::fputc('\n', stdout);
+        std::fflush(stdout);
+    });
+
+    using Clock = std::chrono::steady_clock;
+    const auto started = Clock::now();
+    // 真实或加速的时钟；步进时钟下时间只由 runner 推进
+    auto now = [&]() -> std::uint64_t
+    {
+        if (speed <= 0)
+        {
+            return runner.Now();
+        }
+        const double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+        return (std::uint64_t)(elapsedMs * speed);
+    };
+
+    runner.Start(0);
+    for (const std::string& line : sets)
+    {
+        runner.Execute(line, now());
+    }
+
+    static InputQueue input;
+    std::thread reader([]
+    {
+        std::string line;
+        while (std::getline(std::cin, line))
+        {
+            std::lock_guard<std::mutex> lock(input.mutex);
+            input.lines.push_back(std::move(line));
+            input.cv.notify_one();
+        }
+        std::lock_guard<std::mutex> lock(input.mutex);
+        input.eof = true;
+        input.cv.notify_one();
+    });
+    // 阻塞在 getline 上的线程无法打断，退出时不等待
+    reader.detach();
+
+    ControlServer server;
+    if (control && !server.Start(endpoint, [](std::vector<ControlRequest>& batch)
+        {
+            std::lock_guard<std::mutex> lock(input.mutex);
+            for (auto& request : batch)
+            {
+                input.requests.push_back(std::move(request));
+            }
+            input.cv.notify_one();
+        }))
+    {
+        std::fprintf(stderr, "ssr_headless: cannot listen on %s\n", endpoint.c_str());
+        return 1;
+    }
+
+    std::deque<std::string> lines;
+    std::vector<ControlRequest> requests;
+    std::vector<ControlResponse> responses;
+    bool running = true;
+    bool eof = false;
+    while (running && !g_stop.load())
+    {
+        {
+            // 等到有输入、下一个计时器到点，或最多 200ms（检查信号与 --duration）
+            std::chrono::milliseconds wait(200);
+            if (speed > 0)
+            {
+                const std::uint64_t next = runner.NextDeadline();
+                const std::uint64_t current = now();
+                if (next != UINT64_MAX)
+                {
+                    const double realMs = next > current ? (double)(next - current) / speed : 0;
+                    wait = std::min(wait, std::chrono::milliseconds((long long)realMs));
+                }
+            }
+            std::unique_lock<std::mutex> lock(input.mutex);
+            input.cv.wait_for(lock, wait, [&] { return !input.lines.empty() || !input.requests.empty() || (input.eof && !eof); });
+            lines.swap(input.lines);
+            requests.swap(input.requests);
+            eof = input.eof;
+        }
+
+        for (const std::string& line : lines)
+        {
+            if (!runner.Execute(line, now()))
+            {
+                running = false;
+                break;
+            }
+        }
+        lines.clear();
+
+        if (!requests.empty())
+        {
+            responses.resize(requests.size());
+            for (size_t i = 0; i < requests.size(); i++)
+            {
+                runner.HandleControl(requests[i], responses[i], now());
+            }
+            server.Respond(responses);
+            requests.clear();
+            responses.clear();
+        }
+
+        if (speed > 0)
+        {
+            runner.AdvanceTo(now());
+        }
+        else if (eof && running)
+        {
+            // 步进时钟：输入结束后一口气跑完剩余的模拟时长
+            runner.AdvanceTo(std::max(durationMs, runner.Now()));
+            running = false;
+        }
+        if (durationMs != 0 && runner.Now() >= durationMs)
+        {
+            running = false;
+        }
+    }
+
+    server.Stop();
+    runner.Finish(speed > 0 ? now() : runner.Now(), std::chrono::duration<double>(Clock::now() - started).count());
+    return 0;
+}
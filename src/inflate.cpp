@@ -0,0 +1,434 @@
+#include "inflate.h"
+
+#include <cstring>
+
+namespace
+{
+    constexpr int MAX_BITS = 15;
+    constexpr int MAX_LIT_CODES = 288;
+    constexpr int MAX_DIST_CODES = 30;
+    // 不超过 FAST_BITS 位的码字查表一次解出，更长的逐位按范式哈夫曼解码
+    constexpr int FAST_BITS = 9;
+
+    constexpr std::uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    constexpr std::uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    constexpr std::uint16_t kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    constexpr std::uint8_t kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    constexpr std::uint8_t kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    struct Huffman
+    {
+        std::uint16_t count[MAX_BITS + 1];
+        std::uint16_t symbol[MAX_LIT_CODES];
+        std::uint16_t fast[1 << FAST_BITS];   // (码长 << 9) | 符号；0 表示要走慢路径
+    };
+
+    // 数据读完后补零字节，补进来的位被用掉说明流被截断
+    struct BitReader
+    {
+        const std::uint8_t* p;
+        const std::uint8_t* end;
+        std::uint64_t buf = 0;
+        int bits = 0;
+        int padded = 0;
+
+        void Refill()
+        {
+            while (bits <= 56)
+            {
+                if (p < end)
+                {
+                    buf |= (std::uint64_t)*p++ << bits;
+                }
+                else
+                {
+                    padded++;
+                }
+                bits += 8;
+            }
+        }
+
+        std::uint32_t Peek(int n)
+        {
+            if (bits < n)
+            {
+                Refill();
+            }
+            return (std::uint32_t)(buf & ((1ull << n) - 1));
+        }
+
+        void Consume(int n)
+        {
+            buf >>= n;
+            bits -= n;
+        }
+
+        std::uint32_t Bits(int n)
+        {
+            const std::uint32_t v = Peek(n);
+            Consume(n);
+            return v;
+        }
+
+        bool Overrun() const { return bits < padded * 8; }
+
+        void AlignToByte() { Consume(bits & 7); }
+    };
+
+    std::uint32_t ReverseBits(std::uint32_t code, int length)
+    {
+        std::uint32_t r = 0;
+        for (int i = 0; i < length; i++)
+        {
+            r = (r << 1) | (code & 1u);
+            code >>= 1;
+        }
+        return r;
+    }
+
+    // 不完整的码表也接受（只有一个距离码的流很常见），过度占用的码表拒绝
+    bool Build(Huffman& h, const std::uint8_t* lengths, int n)
+    {
+        std::memset(h.count, 0, sizeof(h.count));
+        std::memset(h.fast, 0, sizeof(h.fast));
+        for (int i = 0; i < n; i++)
+        {
+            h.count[lengths[i]]++;
+        }
+        int left = 1;
+        for (int len = 1; len <= MAX_BITS; len++)
+        {
+            left = (left << 1) - h.count[len];
+            if (left < 0)
+            {
+                return false;
+            }
+        }
+
+        std::uint16_t offs[MAX_BITS + 2];
+        offs[1] = 0;
+        for (int len = 1; len <= MAX_BITS; len++)
+        {
+            offs[len + 1] = (std::uint16_t)(offs[len] + h.count[len]);
+        }
+        for (int i = 0; i < n; i++)
+        {
+            if (lengths[i] != 0)
+            {
+                h.symbol[offs[lengths[i]]++] = (std::uint16_t)i;
+            }
+        }
+
+        std::uint32_t code = 0;
+        int index = 0;
+        for (int len = 1; len <= MAX_BITS; len++)
+        {
+            for (int k = 0; k < h.count[len]; k++, index++, code++)
+            {
+                if (len > FAST_BITS)
+                {
+                    continue;
+                }
+                const std::uint16_t entry = (std::uint16_t)((len << 9) | h.symbol[index]);
+                for (std::uint32_t i = ReverseBits(code, len); i < (1u << FAST_BITS); i += 1u << len)
+                {
+                    h.fast[i] = entry;
+                }
+            }
+            code <<= 1;
+        }
+        return true;
+    }
+
+    int Decode(BitReader& in, const Huffman& h)
+    {
+        const std::uint16_t entry = h.fast[in.Peek(FAST_BITS)];
+        if (entry != 0)
+        {
+            in.Consume(entry >> 9);
+            return entry & 0x1FF;
+        }
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int len = 1; len <= MAX_BITS; len++)
+        {
+            code |= (int)in.Bits(1);
+            const int count = h.count[len];
+            if (code - count < first)
+            {
+                return h.symbol[index + (code - first)];
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    class Inflater
+    {
+    public:
+        Inflater(const std::uint8_t* data, size_t size, std::uint8_t* out, size_t outSize)
+            : m_out(out), m_outSize(outSize)
+        {
+            m_in.p = data;
+            m_in.end = data + size;
+        }
+
+        bool Run()
+        {
+            bool last = false;
+            while (!last)
+            {
+                last = m_in.Bits(1) != 0;
+                const std::uint32_t type = m_in.Bits(2);
+                bool ok = false;
+                switch (type)
+                {
+                case 0: ok = Stored(); break;
+                case 1: ok = Fixed(); break;
+                case 2: ok = Dynamic(); break;
+                default: break;
+                }
+                if (!ok || m_in.Overrun())
+                {
+                    return false;
+                }
+            }
+            return m_written == m_outSize;
+        }
+
+        // 校验和紧跟在最后一个块之后，按字节对齐
+        bool ReadAdler(std::uint32_t& adler)
+        {
+            m_in.AlignToByte();
+            adler = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                adler = (adler << 8) | m_in.Bits(8);
+            }
+            return !m_in.Overrun();
+        }
+
+    private:
+        bool Stored()
+        {
+            m_in.AlignToByte();
+            const std::uint32_t len = m_in.Bits(16);
+            const std::uint32_t nlen = m_in.Bits(16);
+            if (m_in.Overrun() || (len ^ 0xFFFFu) != nlen || len > m_outSize - m_written)
+            {
+                return false;
+            }
+            std::uint32_t remaining = len;
+            // 先取出位缓冲里已读入的整字节，其余直接从输入复制
+            while (remaining != 0 && m_in.bits - m_in.padded * 8 >= 8)
+            {
+                m_out[m_written++] = (std::uint8_t)m_in.Bits(8);
+                remaining--;
+            }
+            if (remaining == 0)
+            {
+                return true;
+            }
+            if ((size_t)(m_in.end - m_in.p) < remaining)
+            {
+                return false;
+            }
+            std::memcpy(m_out + m_written, m_in.p, remaining);
+            m_in.p += remaining;
+            m_written += remaining;
+            return true;
+        }
+
+        bool Fixed()
+        {
+            if (!m_fixedBuilt)
+            {
+                std::uint8_t lengths[MAX_LIT_CODES];
+                int i = 0;
+                for (; i < 144; i++) lengths[i] = 8;
+                for (; i < 256; i++) lengths[i] = 9;
+                for (; i < 280; i++) lengths[i] = 7;
+                for (; i < MAX_LIT_CODES; i++) lengths[i] = 8;
+                Build(m_fixedLit, lengths, MAX_LIT_CODES);
+                for (i = 0; i < MAX_DIST_CODES; i++) lengths[i] = 5;
+                Build(m_fixedDist, lengths, MAX_DIST_CODES);
+                m_fixedBuilt = true;
+            }
+            return Codes(m_fixedLit, m_fixedDist);
+        }
+
+        bool Dynamic()
+        {
+            const int nlen = (int)m_in.Bits(5) + 257;
+            const int ndist = (int)m_in.Bits(5) + 1;
+            const int ncode = (int)m_in.Bits(4) + 4;
+            if (nlen > 286 || ndist > MAX_DIST_CODES)
+            {
+                return false;
+            }
+
+            std::uint8_t lengths[MAX_LIT_CODES + MAX_DIST_CODES]{};
+            for (int i = 0; i < ncode; i++)
+            {
+                lengths[kCodeLengthOrder[i]] = (std::uint8_t)m_in.Bits(3);
+            }
+            if (!Build(m_lit, lengths, 19))
+            {
+                return false;
+            }
+
+            int index = 0;
+            while (index < nlen + ndist)
+            {
+                const int symbol = Decode(m_in, m_lit);
+                if (symbol < 0 || m_in.Overrun())
+                {
+                    return false;
+                }
+                if (symbol < 16)
+                {
+                    lengths[index++] = (std::uint8_t)symbol;
+                    continue;
+                }
+                std::uint8_t value = 0;
+                int repeat = 0;
+                if (symbol == 16)
+                {
+                    if (index == 0)
+                    {
+                        return false;
+                    }
+                    value = lengths[index - 1];
+                    repeat = 3 + (int)m_in.Bits(2);
+                }
+                else if (symbol == 17)
+                {
+                    repeat = 3 + (int)m_in.Bits(3);
+                }
+                else
+                {
+                    repeat = 11 + (int)m_in.Bits(7);
+                }
+                if (index + repeat > nlen + ndist)
+                {
+                    return false;
+                }
+                while (repeat-- > 0)
+                {
+                    lengths[index++] = value;
+                }
+            }
+            // 没有块结束码的码表无法解出合法的块
+            if (lengths[256] == 0)
+            {
+                return false;
+            }
+            if (!Build(m_lit, lengths, nlen) || !Build(m_dist, lengths + nlen, ndist))
+            {
+                return false;
+            }
+            return Codes(m_lit, m_dist);
+        }
+
+        bool Codes(const Huffman& lit, const Huffman& dist)
+        {
+            for (;;)
+            {
+                int symbol = Decode(m_in, lit);
+                if (symbol < 256)
+                {
+                    if (symbol < 0 || m_written == m_outSize)
+                    {
+                        return false;
+                    }
+                    m_out[m_written++] = (std::uint8_t)symbol;
+                    continue;
+                }
+                if (symbol == 256)
+                {
+                    return true;
+                }
+                symbol -= 257;
+                if (symbol >= 29)
+                {
+                    return false;
+                }
+                const size_t length = kLengthBase[symbol] + m_in.Bits(kLengthExtra[symbol]);
+                const int d = Decode(m_in, dist);
+                if (d < 0 || d >= MAX_DIST_CODES)
+                {
+                    return false;
+                }
+                const size_t distance = kDistBase[d] + m_in.Bits(kDistExtra[d]);
+                if (m_in.Overrun() || distance > m_written || length > m_outSize - m_written)
+                {
+                    return false;
+                }
+                // 源与目标可能重叠（distance < length 时重复前面的字节），逐字节复制
+                const std::uint8_t* from = m_out + m_written - distance;
+                std::uint8_t* to = m_out + m_written;
+                for (size_t i = 0; i < length; i++)
+                {
+                    to[i] = from[i];
+                }
+                m_written += length;
+            }
+        }
+
+        BitReader m_in;
+        std::uint8_t* m_out;
+        size_t m_outSize;
+        size_t m_written = 0;
+        Huffman m_lit;
+        Huffman m_dist;
+        Huffman m_fixedLit;
+        Huffman m_fixedDist;
+        bool m_fixedBuilt = false;
+    };
+
+    std::uint32_t Adler32(const std::uint8_t* data, size_t size)
+    {
+        std::uint32_t a = 1;
+        std::uint32_t b = 0;
+        while (size > 0)
+        {
+            // 5552 是保证 b 不溢出 32 位的最大分段
+            const size_t n = size < 5552 ? size : 5552;
+            for (size_t i = 0; i < n; i++)
+            {
+                a += data[i];
+                b += a;
+            }
+            a %= 65521u;
+            b %= 65521u;
+            data += n;
+            size -= n;
+        }
+        return (b << 16) | a;
+    }
+}
+
+bool Inflate_Zlib(const std::uint8_t* data, size_t size, std::uint8_t* out, size_t outSize)
+{
+    if (size < 6)
+    {
+        return false;
+    }
+    const std::uint32_t cmf = data[0];
+    const std::uint32_t flg = data[1];
+    // 只有 deflate、窗口不超过 32KB、没有预置字典的流
+    if ((cmf & 0x0Fu) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31u != 0 || (flg & 0x20u) != 0)
+    {
+        return false;
+    }
+    Inflater inflater(data + 2, size - 2, out, outSize);
+    std::uint32_t adler = 0;
+    return inflater.Run() && inflater.ReadAdler(adler) && adler == Adler32(out, outSize);
+}
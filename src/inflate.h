@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// zlib 流（RFC 1950 / 1951）解压，供 APNG 使用。输出缓冲由调用方按已知的大小预先分配，
+// 解压结果必须正好填满 outSize 字节；数据损坏、校验和不符或长度不符时返回 false。
+bool Inflate_Zlib(const std::uint8_t* data, size_t size, std::uint8_t* out, size_t outSize);
@@ -4,49 +4,66 @@
 #include <commdlg.h>
 #include <shellapi.h>
 #include <shlobj.h>
+#include <shellscalingapi.h>
+#include <wtsapi32.h>
 
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <cstdint>
-#include <cwctype>
+#include <cstring>
+#include <cwchar>
+#include <filesystem>
 #include <algorithm>
 #include <iterator>
 #include <vector>
 #include <string>
 #include <string_view>
 
+#include "anim_player.h"
+#include "asset_pack.h"
+#include "break_log.h"
+#include "config.h"
+#include "config_layers.h"
+#include "config_schema.h"
+#include "control_server.h"
+#include "engine_log.h"
+#include "fullscreen_policy.h"
+#include "overlay_frame.h"
+#include "overlay_engine.h"
+#include "overlay_fsm.h"
+#include "overlay_pool.h"
+#include "presence.h"
+#include "process_footprint.h"
 #include "resource.h"
+#include "scheduler_state.h"
+#include "screen_region.h"
+#include "settings_preview.h"
+#include "show_arena.h"
+#include "single_instance.h"
+#include "soft_render.h"
+#include "startup_profile.h"
+#include "text_template.h"
+#include "trace.h"
+#include "utf8.h"
 
 static constexpr UINT WMAPP_TRAY = WM_APP + 1;
 static constexpr UINT WMAPP_ACTIVITY = WM_APP + 2;
+static constexpr UINT WMAPP_CONTROL = WM_APP + 3;
 
 static constexpr UINT_PTR TIMER_INTERVAL = 1;
 static constexpr UINT_PTR TIMER_OVERLAY_ANIM = 2;
 static constexpr UINT_PTR TIMER_OVERLAY_CLOCK = 3;
-
-static constexpr int TEXT_MAX_LEN = 500;
-
-enum class OverlayState : int
-{
-    Hidden = 0,
-    FadingIn = 1,
-    WaitingInput = 2,
-    FadingOut = 3,
-};
-
-struct AppConfig
-{
-    int intervalMinutes = 15;
-    int opacityPercent = 60;
-    int fadeSeconds = 5;
-    COLORREF bgColor = RGB(0, 128, 64); // #008040
-    bool autoStart = false;
-    std::wstring text = L"抬眼望远处，给目光放个假。";
-};
+static constexpr UINT_PTR TIMER_TOPOLOGY = 4;
+static constexpr UINT_PTR TIMER_PREVIEW_DEBOUNCE = 5;
+static constexpr UINT_PTR TIMER_PREVIEW_CLOCK = 6;
+static constexpr UINT_PTR TIMER_OVERLAY_WARMUP = 7;
+static constexpr UINT_PTR TIMER_OVERLAY_FRAME = 8;
 
 static HINSTANCE g_hInstance = nullptr;
 static HWND g_hwndMain = nullptr;
 static HWND g_hwndSettings = nullptr;
-static std::vector<HWND> g_overlayWindows;
 static HBRUSH g_settingsBgBrush = nullptr;
 
 static NOTIFYICONDATAW g_nid{};
@@ -55,18 +72,41 @@ static HMENU g_trayMenu = nullptr;
 static HHOOK g_hHookKeyboard = nullptr;
 static HHOOK g_hHookMouse = nullptr;
 
+// 引擎只在界面线程上运行；g_overlayState 是给键鼠钩子读取的镜像
 static std::atomic<OverlayState> g_overlayState{OverlayState::Hidden};
 static std::atomic<long> g_activityLatch{0};
 static std::atomic<bool> g_exiting{false};
 
-static ULONGLONG g_fadeStartTick = 0;
-static BYTE g_targetAlpha = 153;
-static BYTE g_currentAlpha = 0;
-
 static AppConfig g_config{};
-static AppConfig g_overlayConfig{};
-
-static void Overlay_ShowWithConfig(HWND hwnd, const AppConfig& cfg);
+static LayeredConfig g_configLayers;
+
+static BreakLogWriter g_breakLog;
+// 今天的正式提醒次数：启动时后台线程只数记录末尾今天的部分，之后由弹出时的状态切换累加
+static BreakDayCounter g_breaksToday;
+static std::thread g_breaksTodayScan;
+static std::chrono::steady_clock::time_point g_schedulerDeadline{};
+static SchedulerStateFile g_schedulerState;
+static SchedulerStateRecord g_schedulerRecord{};
+
+static constexpr const char* TRACE_CAT_OVERLAY = "overlay";
+static constexpr const char* TRACE_CAT_SCHEDULER = "scheduler";
+static constexpr const char* TRACE_CAT_INPUT = "input";
+static constexpr const char* TRACE_CAT_CONTROL = "control";
+
+// 入口到消息循环的各阶段；设置窗口、遮罩窗口与预渲染线程不在其中，第一次用到时才初始化
+static StartupProfile g_startup;
+
+// 控制端点的 I/O 在后台线程；请求整批放进收件箱，界面线程一次取完
+static ControlServer g_controlServer;
+static std::mutex g_controlInboxMutex;
+static std::vector<ControlRequest> g_controlInbox;
+
+static void Overlay_SchedulePrerender(std::chrono::steady_clock::time_point deadline);
+static void Overlay_CancelPrerender();
+static void Overlay_EnsureReady();
+static void Overlay_StartAnim();
+static void Overlay_StopAnim();
+static void Settings_EnsureClass();
 static bool Settings_TryBuildCandidateFromControls(HWND hwndDlg, AppConfig& candidate, std::wstring& error);
 static bool AutoStart_Apply(bool enabled, std::wstring& error);
 
@@ -95,45 +135,64 @@ static std::wstring GetTextPath()
     return GetAppDataFolder() + L"\\text.txt";
 }
 
-static std::string WideToUtf8(const std::wstring& input)
+static std::wstring GetBreakLogPath()
 {
-    if (input.empty())
-    {
-        return {};
-    }
+    return GetAppDataFolder() + L"\\breaks.log";
+}
 
-    const int size = WideCharToMultiByte(CP_UTF8, 0, input.c_str(), (int)input.size(), nullptr, 0, nullptr, nullptr);
-    if (size <= 0)
-    {
-        return {};
-    }
+static std::wstring GetSchedulerStatePath()
+{
+    return GetAppDataFolder() + L"\\scheduler.state";
+}
 
-    std::string out;
-    out.resize((size_t)size);
-    WideCharToMultiByte(CP_UTF8, 0, input.c_str(), (int)input.size(), out.data(), size, nullptr, nullptr);
-    return out;
+static std::wstring GetConfigCachePath()
+{
+    return GetAppDataFolder() + L"\\config.cache";
 }
 
-static std::wstring Utf8ToWide(const std::string& input)
+// 本机所有用户共用的目录；取不到时返回空
+static std::wstring GetMachineFolder()
 {
-    if (input.empty())
+    PWSTR path = nullptr;
+    if (FAILED(SHGetKnownFolderPath(FOLDERID_ProgramData, 0, nullptr, &path)) || path == nullptr)
     {
-        return {};
+        return std::wstring();
     }
 
-    const int size = MultiByteToWideChar(CP_UTF8, 0, input.data(), (int)input.size(), nullptr, 0);
-    if (size <= 0)
+    std::wstring folder(path);
+    CoTaskMemFree(path);
+    return folder + L"\\ScreenSaverReminderCPP";
+}
+
+// 所有会话、所有用户共用的资源包目录
+static std::wstring GetSharedAssetFolder()
+{
+    const std::wstring machine = GetMachineFolder();
+    return machine.empty() ? GetAppDataFolder() + L"\\assets" : machine + L"\\assets";
+}
+
+// 共享目录里的同名资源包由别的普通用户发布、不受信任时，本用户的各个会话改用这里（本机目录，不随配置漫游）
+static std::wstring GetUserAssetFolder()
+{
+    PWSTR path = nullptr;
+    if (FAILED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &path)) || path == nullptr)
     {
-        return {};
+        return GetAppDataFolder() + L"\\assets";
     }
 
-    std::wstring out;
-    out.resize((size_t)size);
-    MultiByteToWideChar(CP_UTF8, 0, input.data(), (int)input.size(), out.data(), size);
-    return out;
+    std::wstring folder(path);
+    CoTaskMemFree(path);
+    return folder + L"\\ScreenSaverReminderCPP\\assets";
 }
 
-static bool ReadFileUtf8(const std::wstring& path, std::wstring& contentOut)
+// IT 下发的只读策略（*.ini 与 text.txt），普通用户没有写权限
+static std::wstring GetPolicyFolder()
+{
+    const std::wstring machine = GetMachineFolder();
+    return machine.empty() ? std::wstring() : machine + L"\\policy";
+}
+
+static bool ReadFileBytes(const std::wstring& path, std::string& contentOut)
 {
     contentOut.clear();
     HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
@@ -149,25 +208,34 @@ static bool ReadFileUtf8(const std::wstring& path, std::wstring& contentOut)
         return false;
     }
 
-    std::string buffer;
-    buffer.resize((size_t)size.QuadPart);
+    contentOut.resize((size_t)size.QuadPart);
 
     DWORD read = 0;
-    const BOOL ok = ReadFile(hFile, buffer.data(), (DWORD)buffer.size(), &read, nullptr);
+    const BOOL ok = ReadFile(hFile, contentOut.data(), (DWORD)contentOut.size(), &read, nullptr);
     CloseHandle(hFile);
     if (!ok)
     {
+        contentOut.clear();
         return false;
     }
-    buffer.resize(read);
+    contentOut.resize(read);
+    return true;
+}
 
-    contentOut = Utf8ToWide(buffer);
+static bool ReadFileUtf8(const std::wstring& path, std::wstring& contentOut)
+{
+    contentOut.clear();
+    std::string buffer;
+    if (!ReadFileBytes(path, buffer))
+    {
+        return false;
+    }
+    Utf8ToWide(buffer, contentOut);
     return true;
 }
 
-static bool WriteFileUtf8(const std::wstring& path, const std::wstring& content)
+static bool WriteFileBytes(const std::wstring& path, std::string_view bytes)
 {
-    const auto bytes = WideToUtf8(content);
     HANDLE hFile = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
     if (hFile == INVALID_HANDLE_VALUE)
     {
@@ -180,116 +248,51 @@ static bool WriteFileUtf8(const std::wstring& path, const std::wstring& content)
     return ok == TRUE;
 }
 
-static std::wstring Trim(std::wstring_view s)
-{
-    size_t start = 0;
-    while (start < s.size() && iswspace(s[start])) start++;
-    size_t end = s.size();
-    while (end > start && iswspace(s[end - 1])) end--;
-    return std::wstring(s.substr(start, end - start));
-}
-
-static bool TryParseHexColor(const std::wstring& input, COLORREF& colorOut)
-{
-    auto s = Trim(input);
-    if (!s.empty() && s[0] == L'#')
-    {
-        s.erase(0, 1);
-    }
-    if (s.size() != 6)
-    {
-        return false;
-    }
-    auto hexVal = [](wchar_t ch) -> int
-    {
-        if (ch >= L'0' && ch <= L'9') return ch - L'0';
-        if (ch >= L'a' && ch <= L'f') return 10 + (ch - L'a');
-        if (ch >= L'A' && ch <= L'F') return 10 + (ch - L'A');
-        return -1;
-    };
-    int r1 = hexVal(s[0]), r2 = hexVal(s[1]);
-    int g1 = hexVal(s[2]), g2 = hexVal(s[3]);
-    int b1 = hexVal(s[4]), b2 = hexVal(s[5]);
-    if (r1 < 0 || r2 < 0 || g1 < 0 || g2 < 0 || b1 < 0 || b2 < 0)
-    {
-        return false;
-    }
-    int r = (r1 << 4) | r2;
-    int g = (g1 << 4) | g2;
-    int b = (b1 << 4) | b2;
-    colorOut = RGB(r, g, b);
-    return true;
-}
-
-static std::wstring ColorToHex(COLORREF c)
-{
-    wchar_t buf[16]{};
-    wsprintfW(buf, L"#%02X%02X%02X", GetRValue(c), GetGValue(c), GetBValue(c));
-    return buf;
-}
-
-static void NormalizeConfig(AppConfig& cfg)
+static bool WriteFileUtf8(const std::wstring& path, const std::wstring& content)
 {
-    if (cfg.intervalMinutes < 1) cfg.intervalMinutes = 1;
-    if (cfg.fadeSeconds < 1) cfg.fadeSeconds = 1;
-    if (cfg.opacityPercent < 0) cfg.opacityPercent = 0;
-    if (cfg.opacityPercent > 100) cfg.opacityPercent = 100;
-    if (cfg.text.size() > TEXT_MAX_LEN) cfg.text.resize(TEXT_MAX_LEN);
+    return WriteFileBytes(path, WideToUtf8(content));
 }
 
+// 默认值 → 策略 → 用户文件；没有变化的层沿用上次（或磁盘缓存中）的解析结果
 static void LoadConfig(AppConfig& cfg)
 {
-    cfg = AppConfig{};
-    const auto iniPath = GetConfigIniPath();
-
-    wchar_t buf[2048]{};
-
-    cfg.intervalMinutes = GetPrivateProfileIntW(L"General", L"IntervalMinutes", cfg.intervalMinutes, iniPath.c_str());
-    cfg.opacityPercent = GetPrivateProfileIntW(L"General", L"OpacityPercent", cfg.opacityPercent, iniPath.c_str());
-    cfg.fadeSeconds = GetPrivateProfileIntW(L"General", L"FadeSeconds", cfg.fadeSeconds, iniPath.c_str());
-    cfg.autoStart = GetPrivateProfileIntW(L"General", L"AutoStart", cfg.autoStart ? 1 : 0, iniPath.c_str()) != 0;
-
-    GetPrivateProfileStringW(L"General", L"BgColorHex", L"#000000", buf, (DWORD)std::size(buf), iniPath.c_str());
-    COLORREF color{};
-    if (TryParseHexColor(buf, color))
+    static bool s_sourcesSet = false;
+    if (!s_sourcesSet)
     {
-        cfg.bgColor = color;
+        g_configLayers.SetSources(GetPolicyFolder(), GetConfigIniPath(), GetTextPath());
+        g_configLayers.LoadCache(GetConfigCachePath());
+        s_sourcesSet = true;
     }
-
-    std::wstring text;
-    if (ReadFileUtf8(GetTextPath(), text))
+    const std::uint64_t mergesBefore = g_configLayers.Stats().merges;
+    if (g_configLayers.Load())
     {
-        cfg.text = text;
+        g_configLayers.SaveCache(GetConfigCachePath());
     }
-    else
+    // 重新合并过时把策略文件的问题写到调试输出，metrics 报告条数
+    if (g_configLayers.Stats().merges != mergesBefore)
     {
-        GetPrivateProfileStringW(L"General", L"Text", L"", buf, (DWORD)std::size(buf), iniPath.c_str());
-        cfg.text = buf;
+        for (const std::string& problem : g_configLayers.Problems())
+        {
+            std::wstring line;
+            Utf8ToWide(problem, line);
+            OutputDebugStringW((L"ScreenSaverReminder: policy " + line + L"\n").c_str());
+        }
+        Trace_Instant(TRACE_CAT_SCHEDULER, "config_policy_problems", (std::int64_t)g_configLayers.Problems().size());
     }
-
-    NormalizeConfig(cfg);
+    cfg = g_configLayers.Merged();
 }
 
+// 被策略锁定的键不写入用户文件
 static void SaveConfig(const AppConfig& cfg)
 {
-    const auto iniPath = GetConfigIniPath();
-
-    wchar_t tmp[64]{};
-
-    wsprintfW(tmp, L"%d", cfg.intervalMinutes);
-    WritePrivateProfileStringW(L"General", L"IntervalMinutes", tmp, iniPath.c_str());
-
-    wsprintfW(tmp, L"%d", cfg.opacityPercent);
-    WritePrivateProfileStringW(L"General", L"OpacityPercent", tmp, iniPath.c_str());
-
-    wsprintfW(tmp, L"%d", cfg.fadeSeconds);
-    WritePrivateProfileStringW(L"General", L"FadeSeconds", tmp, iniPath.c_str());
-
-    const auto hex = ColorToHex(cfg.bgColor);
-    WritePrivateProfileStringW(L"General", L"BgColorHex", hex.c_str(), iniPath.c_str());
-
-    WritePrivateProfileStringW(L"General", L"AutoStart", cfg.autoStart ? L"1" : L"0", iniPath.c_str());
-    WriteFileUtf8(GetTextPath(), cfg.text);
+    const std::uint32_t locked = g_configLayers.Locked();
+    std::string ini;
+    Config_SerializeIni(cfg, ini, locked);
+    WriteFileBytes(GetConfigIniPath(), ini);
+    if (!(locked & Config_FieldBit(Config_FieldIndex(kFieldText.key))))
+    {
+        WriteFileUtf8(GetTextPath(), cfg.text);
+    }
 }
 
 static void Tray_ShowMenu(HWND hwnd)
@@ -345,67 +348,407 @@ static void Tray_Destroy()
     }
 }
 
-static void Scheduler_Start(HWND hwnd)
+static std::uint64_t SchedulerState_NowUnixMs()
+{
+    FILETIME ft{};
+    GetSystemTimeAsFileTime(&ft);
+    const ULONGLONG ticks = ((ULONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    return (std::uint64_t)(ticks / 10000ull) - 11644473600000ull;
+}
+
+// 只在重新计时、稍后提醒时写入；每次只是对映射内存的一次拷贝
+static void SchedulerState_Save()
+{
+    g_schedulerRecord.savedUnixMs = SchedulerState_NowUnixMs();
+    g_schedulerRecord.intervalMinutes = (std::uint32_t)g_config.intervalMinutes;
+    if (g_schedulerState.Save(g_schedulerRecord))
+    {
+        Trace_Instant(TRACE_CAT_SCHEDULER, "SchedulerState_Save", (std::int64_t)g_schedulerState.Sequence());
+    }
+}
+
+static void Scheduler_Start(HWND hwnd, UINT elapseMs)
 {
     KillTimer(hwnd, TIMER_INTERVAL);
-    const UINT elapseMs = (UINT)g_config.intervalMinutes * 60u * 1000u;
     SetTimer(hwnd, TIMER_INTERVAL, elapseMs, nullptr);
+    g_schedulerDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(elapseMs);
+    // 稍后提醒在这次计时里生效，不再是待生效状态
+    g_schedulerRecord.deadlineUnixMs = SchedulerState_NowUnixMs() + elapseMs;
+    g_schedulerRecord.pendingSnoozeMinutes = 0;
+    SchedulerState_Save();
+    Overlay_SchedulePrerender(g_schedulerDeadline);
+    Trace_Instant(TRACE_CAT_SCHEDULER, "Scheduler_Start", elapseMs);
 }
 
 static void Scheduler_Stop(HWND hwnd)
 {
     KillTimer(hwnd, TIMER_INTERVAL);
+    g_schedulerDeadline = {};
+    Overlay_CancelPrerender();
+    Trace_Instant(TRACE_CAT_SCHEDULER, "Scheduler_Stop");
 }
 
-static void Overlay_SetAlpha(HWND hwnd, BYTE alpha)
+static std::int64_t LocalDayFromUnixSecond(std::int64_t unixSecond, int& utcOffsetMinutes)
 {
-    SetLayeredWindowAttributes(hwnd, 0, alpha, LWA_ALPHA);
+    const ULONGLONG ticks = (ULONGLONG)(unixSecond + 11644473600ll) * 10000000ull;
+    FILETIME utc{ (DWORD)ticks, (DWORD)(ticks >> 32) };
+    FILETIME local{};
+    FileTimeToLocalFileTime(&utc, &local);
+    const ULONGLONG localTicks = ((ULONGLONG)local.dwHighDateTime << 32) | local.dwLowDateTime;
+    const std::int64_t localSecond = (std::int64_t)(localTicks / 10000000ull) - 11644473600ll;
+    utcOffsetMinutes = (int)((localSecond - unixSecond) / 60);
+    return localSecond >= 0 ? localSecond / 86400 : (localSecond - 86399) / 86400;
 }
 
-static void Overlay_Invalidate(HWND hwnd)
+// 今天已有的提醒次数在后台线程数；周期编号不超过启动时最后一条记录的属于之前的进程，之后的由 BreakLog_OnTransition 累加
+static void BreakLog_StartDayCount()
 {
-    InvalidateRect(hwnd, nullptr, FALSE);
+    int utcOffsetMinutes = 0;
+    const std::int64_t day = LocalDayFromUnixSecond((std::int64_t)(BreakLog_NowUnixMs() / 1000), utcOffsetMinutes);
+    const std::uint32_t lastCycle = g_breakLog.Cycle();
+    g_breaksTodayScan = std::thread([path = GetBreakLogPath(), day, utcOffsetMinutes, lastCycle]
+    {
+        Trace_SetThreadName("break_log_scan");
+        std::uint32_t reminders = 0;
+        BreakLog_CountDayFile(path, day, utcOffsetMinutes, lastCycle, reminders);
+        g_breaksToday.Seed(day, reminders);
+    });
 }
 
-static bool Overlay_IsVisible()
+static void BreakLog_OnTransition(OverlayState prev, OverlayState next, bool preview)
+{
+    const std::uint16_t flags = preview ? BREAK_FLAG_PREVIEW : 0;
+    if (next == OverlayState::Hidden || next == OverlayState::Exited)
+    {
+        // 提醒之间退出程序时遮罩本来就是隐藏的，不算一次提醒结束
+        if (prev == OverlayState::FadingIn || prev == OverlayState::WaitingInput || prev == OverlayState::FadingOut)
+        {
+            g_breakLog.Append(BreakEvent::Hidden, flags);
+        }
+    }
+    else if (prev == OverlayState::Hidden && next == OverlayState::FadingIn)
+    {
+        g_breakLog.Append(BreakEvent::Shown, flags);
+        if (!preview)
+        {
+            int utcOffsetMinutes = 0;
+            g_breaksToday.OnShown(LocalDayFromUnixSecond((std::int64_t)(BreakLog_NowUnixMs() / 1000), utcOffsetMinutes));
+        }
+    }
+    else if (prev == OverlayState::FadingIn && next == OverlayState::WaitingInput)
+    {
+        g_breakLog.Append(BreakEvent::FadeInDone, flags);
+    }
+    else if (prev == OverlayState::WaitingInput && next == OverlayState::FadingOut)
+    {
+        g_breakLog.Append(BreakEvent::FirstActivity, flags);
+    }
+}
+
+// 第一次提醒结束后的句柄数作为基准，此后每次隐藏都与之比较，运行几周后的泄漏能在 metrics 里看出来
+static ProcessHandles g_handlesBaseline;
+static ProcessHandles g_handlesAfterHide;
+static std::uint64_t g_hideCycles = 0;
+
+static void Overlay_SampleHandles()
 {
-    return !g_overlayWindows.empty();
+    ProcessHandles_ReadSelf(g_handlesAfterHide);
+    if (g_hideCycles++ == 0)
+    {
+        g_handlesBaseline = g_handlesAfterHide;
+    }
 }
 
-static void Overlay_SetAlphaAll(BYTE alpha)
+static void Overlay_SetState(OverlayState state, bool preview)
+{
+    const OverlayState prev = g_overlayState.exchange(state);
+    if (prev == state)
+    {
+        return;
+    }
+    BreakLog_OnTransition(prev, state, preview);
+    if (prev == OverlayState::FadingOut && state == OverlayState::Hidden && !preview)
+    {
+        // 随后的 SchedulerStart 会一并写入
+        g_schedulerRecord.lastBreakUnixMs = SchedulerState_NowUnixMs();
+    }
+    if (state == OverlayState::Hidden)
+    {
+        Overlay_SampleHandles();
+    }
+    if (Trace_IsEnabled())
+    {
+        Trace_Instant(TRACE_CAT_OVERLAY, OverlayFsm_StateName(state), (int)prev);
+        Trace_Counter(TRACE_CAT_OVERLAY, "overlay_state", (int)state);
+    }
+}
+
+static BOOL CALLBACK EnumMonitorsProc(HMONITOR monitor, HDC, LPRECT rc, LPARAM lParam)
+{
+    auto* monitors = reinterpret_cast<std::vector<MonitorInfo>*>(lParam);
+    MonitorInfo info{};
+    info.rect = ScreenRect{ (int)rc->left, (int)rc->top, (int)rc->right, (int)rc->bottom };
+    UINT dpiX = 96;
+    UINT dpiY = 96;
+    if (SUCCEEDED(GetDpiForMonitor(monitor, MDT_EFFECTIVE_DPI, &dpiX, &dpiY)))
+    {
+        info.dpi = (int)dpiX;
+    }
+    monitors->push_back(info);
+    return TRUE;
+}
+
+// ScreenRegion 的矩形已按 y-x 分带排好，直接作为 RGNDATA 交给 GDI
+static HRGN Overlay_CreateRgn(const ScreenRegion& region)
 {
-    for (HWND w : g_overlayWindows)
+    const auto& rects = region.Rects();
+    std::vector<std::uint8_t> data(sizeof(RGNDATAHEADER) + rects.size() * sizeof(RECT));
+    auto* rgn = reinterpret_cast<RGNDATA*>(data.data());
+    rgn->rdh.dwSize = sizeof(RGNDATAHEADER);
+    rgn->rdh.iType = RDH_RECTANGLES;
+    rgn->rdh.nCount = (DWORD)rects.size();
+    rgn->rdh.nRgnSize = (DWORD)(rects.size() * sizeof(RECT));
+    const ScreenRect& b = region.Bounds();
+    rgn->rdh.rcBound = RECT{ b.left, b.top, b.right, b.bottom };
+    auto* out = reinterpret_cast<RECT*>(rgn->Buffer);
+    for (size_t i = 0; i < rects.size(); i++)
+    {
+        out[i] = RECT{ rects[i].left, rects[i].top, rects[i].right, rects[i].bottom };
+    }
+    return ExtCreateRegion(nullptr, (DWORD)data.size(), rgn);
+}
+
+// 遮罩的绘制裁剪区域；覆盖整个遮罩时为 nullptr
+static const ScreenRegion* Overlay_Clip(const ScreenRegion* region, int width, int height)
+{
+    return region && !region->IsExactly(ScreenRect{ 0, 0, width, height }) ? region : nullptr;
+}
+
+// 分层遮罩窗口：创建时即设置好样式与 0 透明度，保持隐藏直到提醒开始
+class Win32SurfaceBackend final : public SurfaceBackend
+{
+public:
+    void EnumMonitors(std::vector<MonitorInfo>& out) override
+    {
+        EnumDisplayMonitors(nullptr, nullptr, EnumMonitorsProc, reinterpret_cast<LPARAM>(&out));
+    }
+
+    SurfaceHandle Create(const MonitorInfo& monitor) override
     {
+        const DWORD exStyle = WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE | WS_EX_TOPMOST;
+        HWND w = CreateWindowExW(
+            exStyle,
+            L"SSR_OVERLAY",
+            L"",
+            WS_POPUP,
+            monitor.rect.left, monitor.rect.top,
+            monitor.rect.Width(), monitor.rect.Height(),
+            nullptr, nullptr, g_hInstance, nullptr
+        );
         if (w)
         {
-            Overlay_SetAlpha(w, alpha);
+            SetLayeredWindowAttributes(w, 0, 0, LWA_ALPHA);
+        }
+        return reinterpret_cast<SurfaceHandle>(w);
+    }
+
+    void Destroy(SurfaceHandle surface) override
+    {
+        DestroyWindow(ToHwnd(surface));
+    }
+
+    void Reposition(SurfaceHandle surface, const MonitorInfo& monitor) override
+    {
+        SetWindowPos(ToHwnd(surface), HWND_TOPMOST, monitor.rect.left, monitor.rect.top,
+            monitor.rect.Width(), monitor.rect.Height(), SWP_NOACTIVATE);
+        InvalidateRect(ToHwnd(surface), nullptr, FALSE);
+    }
+
+    void Show(SurfaceHandle surface) override
+    {
+        SetWindowPos(ToHwnd(surface), HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE | SWP_SHOWWINDOW);
+    }
+
+    void Hide(SurfaceHandle surface) override
+    {
+        ShowWindow(ToHwnd(surface), SW_HIDE);
+    }
+
+    void SetAlpha(SurfaceHandle surface, std::uint8_t alpha) override
+    {
+        SetLayeredWindowAttributes(ToHwnd(surface), 0, alpha, LWA_ALPHA);
+    }
+
+    void Invalidate(SurfaceHandle surface) override
+    {
+        // 有窗口区域时只让区域内的部分失效
+        HWND hwnd = ToHwnd(surface);
+        HRGN rgn = CreateRectRgn(0, 0, 0, 0);
+        if (rgn && GetWindowRgn(hwnd, rgn) != ERROR)
+        {
+            InvalidateRgn(hwnd, rgn, FALSE);
+        }
+        else
+        {
+            InvalidateRect(hwnd, nullptr, FALSE);
+        }
+        if (rgn)
+        {
+            DeleteObject(rgn);
         }
     }
+
+    void SetRegion(SurfaceHandle surface, const ScreenRegion& region) override
+    {
+        // 窗口区域外的部分不参与合成；区域交给系统后由系统释放
+        HWND hwnd = ToHwnd(surface);
+        RECT rc{};
+        GetClientRect(hwnd, &rc);
+        SetWindowRgn(hwnd, Overlay_Clip(&region, rc.right, rc.bottom) ? Overlay_CreateRgn(region) : nullptr, TRUE);
+    }
+
+private:
+    static HWND ToHwnd(SurfaceHandle surface) { return reinterpret_cast<HWND>(surface); }
+};
+
+static Win32SurfaceBackend g_surfaceBackend;
+static OverlayPool g_overlayPool(g_surfaceBackend);
+static OverlayFrameCache g_frameCache;
+static PrerenderWorker g_prerender;
+static constexpr std::chrono::milliseconds PRERENDER_LEAD{2000};
+
+// 遮罩上的动画（config.ini 的 Animation）；只在界面线程使用。
+// g_animSetting 为打开时的配置值，配置变化后下次提醒前重新打开
+static AnimPlayer g_anim;
+static std::wstring g_animSetting;
+// text.txt 编译后的模板：每秒只格式化变了的变量，只让时间与变了的行失效
+static TextTemplate g_text;
+
+// 每个遮罩上次整窗绘制时的排版；计时时按它只让时间与变了的行失效
+struct OverlaySurfaceText
+{
+    HWND hwnd = nullptr;
+    TextLineLayout lines;
+    RECT rcTime{};
+    std::vector<RECT> rcLines;
+    std::uint64_t contentHash = 0;
+    bool painted = false;
+};
+static std::vector<OverlaySurfaceText> g_surfaceText;
+
+// 底图与版面只需要动画的尺寸与内容键，预渲染线程按值捕获
+struct OverlayAnim
+{
+    int width = 0;
+    int height = 0;
+    std::uint64_t key = 0;   // 0 表示不播放动画，照常显示文字
+};
+
+// 多会话主机的低占用模式：底图放在共享资源包里，会话之间只有一份；不预渲染私有首帧。
+// 资源包由预渲染线程准备、界面线程读取
+static bool g_footprintMode = false;
+static std::mutex g_assetMutex;
+static std::shared_ptr<SharedAssetPack> g_assetPack;
+static std::atomic<std::uint64_t> g_assetHits{0};
+// 遮罩窗口类、遮罩窗口与预渲染线程在第一次提醒前才创建，不占用登录时的启动时间
+static bool g_overlayReady = false;
+// 第一次提醒前多久创建遮罩窗口，之后照常按 PRERENDER_LEAD 预渲染首帧
+static constexpr std::chrono::milliseconds OVERLAY_WARMUP_LEAD{3000};
+
+static bool Overlay_IsVisible()
+{
+    return g_overlayPool.IsVisible();
+}
+
+static void Overlay_SetAlphaAll(BYTE alpha)
+{
+    Trace_Counter(TRACE_CAT_OVERLAY, "alpha", alpha);
+    g_overlayPool.SetAlpha(alpha);
 }
 
+static bool Overlay_InvalidateText();
+static void Overlay_ShowText();
+
 static void Overlay_InvalidateAll()
 {
-    for (HWND w : g_overlayWindows)
+    // 显示期间保存了新的区域规则时，形状变化的遮罩已在 SetRegionSpec 中重绘
+    g_overlayPool.SetRegionSpec(g_config.overlayRegions);
+    // 每秒的计时多数时候只需重画时间与 {time} 所在的行
+    if (Overlay_InvalidateText())
     {
-        if (w)
-        {
-            Overlay_Invalidate(w);
-        }
+        return;
+    }
+    g_overlayPool.InvalidateAll();
+}
+
+// 最近一次提醒结束（整理之后）与显示期间的常驻内存，在 metrics 里对比
+static ProcessFootprint g_footprintIdle{};
+static ProcessFootprint g_footprintActive{};
+
+// 一次提醒结束：画面缓存与 arena 一起归还系统，再整理堆与工作集
+static void Overlay_ReleaseShowMemory()
+{
+    TRACE_SCOPE(TRACE_CAT_OVERLAY, "Overlay_ReleaseShowMemory");
+    g_frameCache.Clear();
+    // 连同容量一起释放，下面整理堆时才能归还
+    std::vector<OverlaySurfaceText>().swap(g_surfaceText);
+    ShowArena_Overlay().Release();
+    // 仍有画面被引用（例如正在画的后台任务）时，被占住的块等它释放后才归还
+    if (const std::uint64_t pinned = ShowArena_Overlay().Stats().pinnedBytes)
+    {
+        Trace_Instant(TRACE_CAT_OVERLAY, "show_arena_pinned", (std::int64_t)pinned);
+    }
+    // 设置窗口开着（预览）时不清空工作集，免得界面马上又缺页
+    if (!g_hwndSettings || !IsWindowVisible(g_hwndSettings))
+    {
+        ProcessFootprint_Trim();
     }
+    ProcessFootprint_Read(0, g_footprintIdle);
 }
 
-static BOOL CALLBACK EnumMonitorsProc(HMONITOR, HDC, LPRECT rc, LPARAM lParam)
+// 显示器或 DPI 变化的通知往往成串到来，合并后再处理；遮罩显示中时尽快处理，避免新屏幕露出
+static void Overlay_OnTopologyChanged()
 {
-    auto* rects = reinterpret_cast<std::vector<RECT>*>(lParam);
-    rects->push_back(*rc);
-    return TRUE;
+    Trace_Instant(TRACE_CAT_OVERLAY, "topology_changed");
+    g_overlayPool.MarkTopologyDirty();
+    if (g_hwndMain)
+    {
+        SetTimer(g_hwndMain, TIMER_TOPOLOGY, Overlay_IsVisible() ? 100 : 500, nullptr);
+    }
 }
 
-static std::vector<RECT> GetMonitorRects()
+// 只增删有变化的遮罩、挪动移位或缩放的遮罩；状态、透明度与淡入淡出计时都不动
+static void Overlay_ReconcileTopology(HWND hwnd)
 {
-    std::vector<RECT> rects;
-    EnumDisplayMonitors(nullptr, nullptr, EnumMonitorsProc, reinterpret_cast<LPARAM>(&rects));
-    return rects;
+    KillTimer(hwnd, TIMER_TOPOLOGY);
+    if (!g_overlayReady)
+    {
+        // 还没有遮罩窗口；第一次 Prepare 时按当时的显示器创建
+        return;
+    }
+    TRACE_SCOPE(TRACE_CAT_OVERLAY, "Overlay_ReconcileTopology");
+
+    std::vector<MonitorInfo> monitors;
+    g_surfaceBackend.EnumMonitors(monitors);
+    const OverlayReconcileResult result = g_overlayPool.Reconcile(monitors);
+    g_surfaceText.clear();
+    if (Trace_IsEnabled())
+    {
+        Trace_Counter(TRACE_CAT_OVERLAY, "surfaces", (std::int64_t)g_overlayPool.Size());
+        Trace_Instant(TRACE_CAT_OVERLAY, "topology_moved", (std::int64_t)result.moved);
+        Trace_Instant(TRACE_CAT_OVERLAY, "topology_created", (std::int64_t)result.created);
+        Trace_Instant(TRACE_CAT_OVERLAY, "topology_retired", (std::int64_t)result.retired);
+    }
+
+    if (!Overlay_IsVisible() && g_schedulerDeadline != std::chrono::steady_clock::time_point{})
+    {
+        Overlay_SchedulePrerender(g_schedulerDeadline);
+    }
+    else if (g_anim.IsPlaying())
+    {
+        // 各显示器上动画的尺寸可能变了
+        Overlay_StartAnim();
+    }
 }
 
 static LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
@@ -416,6 +759,7 @@ static LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lP
         {
             if (g_activityLatch.exchange(1) == 0)
             {
+                Trace_Instant(TRACE_CAT_INPUT, "keyboard_activity", (std::int64_t)wParam);
                 PostMessageW(g_hwndMain, WMAPP_ACTIVITY, 0, 0);
             }
         }
@@ -431,6 +775,7 @@ static LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lPara
         {
             if (g_activityLatch.exchange(1) == 0)
             {
+                Trace_Instant(TRACE_CAT_INPUT, "mouse_activity", (std::int64_t)wParam);
                 PostMessageW(g_hwndMain, WMAPP_ACTIVITY, 0, 0);
             }
         }
@@ -447,6 +792,7 @@ static void InputMonitor_Start()
     g_activityLatch.store(0);
     g_hHookKeyboard = SetWindowsHookExW(WH_KEYBOARD_LL, LowLevelKeyboardProc, g_hInstance, 0);
     g_hHookMouse = SetWindowsHookExW(WH_MOUSE_LL, LowLevelMouseProc, g_hInstance, 0);
+    Trace_Instant(TRACE_CAT_INPUT, "InputMonitor_Start");
 }
 
 static void InputMonitor_Stop()
@@ -460,261 +806,1145 @@ static void InputMonitor_Stop()
     {
         UnhookWindowsHookEx(g_hHookMouse);
         g_hHookMouse = nullptr;
+        Trace_Instant(TRACE_CAT_INPUT, "InputMonitor_Stop");
     }
     g_activityLatch.store(0);
 }
 
-static void Overlay_Show(HWND hwnd)
-{
-    Overlay_ShowWithConfig(hwnd, g_config);
-}
-
-static void Overlay_ShowWithConfig(HWND hwnd, const AppConfig& cfg)
+// 探测前台窗口是否铺满所在显示器，以及系统是否处于演示模式或 D3D 独占全屏
+class Win32ForegroundProbe final : public ForegroundStateProvider
 {
-    if (Overlay_IsVisible())
+public:
+    ForegroundState Current(std::uint64_t) override
     {
-        return;
-    }
-
-    g_overlayConfig = cfg;
+        ForegroundState state;
+        QUERY_USER_NOTIFICATION_STATE quns{};
+        if (SUCCEEDED(SHQueryUserNotificationState(&quns)))
+        {
+            state.exclusive = quns == QUNS_RUNNING_D3D_FULL_SCREEN;
+            state.presentation = quns == QUNS_PRESENTATION_MODE || quns == QUNS_BUSY;
+        }
 
-    const auto rects = GetMonitorRects();
-    if (rects.empty())
-    {
-        return;
+        HWND fg = GetForegroundWindow();
+        if (!fg || IsShellWindow(fg))
+        {
+            return state;
+        }
+        DWORD pid = 0;
+        GetWindowThreadProcessId(fg, &pid);
+        if (pid == GetCurrentProcessId())
+        {
+            return state;
+        }
+        HMONITOR monitor = MonitorFromWindow(fg, MONITOR_DEFAULTTONULL);
+        MONITORINFO mi{};
+        mi.cbSize = sizeof(mi);
+        RECT rc{};
+        if (!monitor || !GetMonitorInfoW(monitor, &mi) || !GetWindowRect(fg, &rc))
+        {
+            return state;
+        }
+        const RECT& m = mi.rcMonitor;
+        state.monitor = ScreenRect{ (int)m.left, (int)m.top, (int)m.right, (int)m.bottom };
+        state.fullscreen = rc.left <= m.left && rc.top <= m.top && rc.right >= m.right && rc.bottom >= m.bottom;
+        return state;
     }
 
-    const DWORD exStyle = WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE | WS_EX_TOPMOST;
-    const DWORD style = WS_POPUP;
-
-    for (const auto& r : rects)
+private:
+    // 桌面与任务栏铺满屏幕，但不是全屏应用
+    static bool IsShellWindow(HWND hwnd)
     {
-        HWND w = CreateWindowExW(
-            exStyle,
-            L"SSR_OVERLAY",
-            L"",
-            style,
-            r.left, r.top,
-            r.right - r.left, r.bottom - r.top,
-            nullptr, nullptr, g_hInstance, nullptr
-        );
-
-        if (!w)
+        if (hwnd == GetShellWindow() || hwnd == GetDesktopWindow())
         {
-            for (HWND created : g_overlayWindows)
-            {
-                if (created)
-                {
-                    DestroyWindow(created);
-                }
-            }
-            g_overlayWindows.clear();
-            return;
+            return true;
         }
-
-        g_overlayWindows.push_back(w);
+        wchar_t cls[32]{};
+        GetClassNameW(hwnd, cls, (int)std::size(cls));
+        return wcscmp(cls, L"WorkerW") == 0 || wcscmp(cls, L"Progman") == 0 || wcscmp(cls, L"Shell_TrayWnd") == 0;
     }
+};
 
-    g_targetAlpha = (BYTE)((g_overlayConfig.opacityPercent * 255) / 100);
-    g_currentAlpha = 0;
-
-    Overlay_SetAlphaAll(0);
-    for (HWND w : g_overlayWindows)
-    {
-        ShowWindow(w, SW_SHOWNOACTIVATE);
-        SetWindowPos(w, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE | SWP_SHOWWINDOW);
-    }
+static constexpr std::uint32_t FOREGROUND_CACHE_MAX_AGE_MS = 5000;
 
-    g_overlayState.store(OverlayState::FadingIn);
-    g_fadeStartTick = GetTickCount64();
+static Win32ForegroundProbe g_foregroundProbe;
+static ForegroundStateCache g_foregroundCache(g_foregroundProbe, FOREGROUND_CACHE_MAX_AGE_MS);
+static FullscreenPolicy g_fullscreenPolicy(g_foregroundCache);
+static HWINEVENTHOOK g_hForegroundHook = nullptr;
+static HWINEVENTHOOK g_hLocationHook = nullptr;
 
-    InputMonitor_Start();
+static void ForegroundMonitor_WatchProcess(HWND hwnd);
 
-    SetTimer(hwnd, TIMER_OVERLAY_CLOCK, 1000, nullptr);
-    SetTimer(hwnd, TIMER_OVERLAY_ANIM, 15, nullptr);
-    Overlay_InvalidateAll();
+// 前台切换、或前台窗口移动缩放（例如按 F11 进入全屏）时只把缓存标记为过期，到点时再探测
+static void CALLBACK ForegroundMonitor_WinEventProc(HWINEVENTHOOK, DWORD event, HWND hwnd, LONG idObject, LONG, DWORD, DWORD)
+{
+    if (event == EVENT_OBJECT_LOCATIONCHANGE && (idObject != OBJID_WINDOW || hwnd != GetForegroundWindow()))
+    {
+        return;
+    }
+    g_foregroundCache.Invalidate();
+    if (event == EVENT_SYSTEM_FOREGROUND)
+    {
+        ForegroundMonitor_WatchProcess(hwnd);
+    }
 }
 
-static void Overlay_BeginFadeOut(HWND hwnd)
+// 位置变化事件只订阅前台进程，避免收到整个桌面的光标与窗口移动
+static void ForegroundMonitor_WatchProcess(HWND hwnd)
 {
-    if (!Overlay_IsVisible())
+    if (g_hLocationHook)
     {
-        return;
+        UnhookWinEvent(g_hLocationHook);
+        g_hLocationHook = nullptr;
     }
-    if (g_overlayState.load() == OverlayState::FadingOut)
+    DWORD pid = 0;
+    if (!hwnd || !GetWindowThreadProcessId(hwnd, &pid) || pid == 0 || pid == GetCurrentProcessId())
     {
         return;
     }
-    g_overlayState.store(OverlayState::FadingOut);
-    g_fadeStartTick = GetTickCount64();
-    SetTimer(hwnd, TIMER_OVERLAY_ANIM, 15, nullptr);
+    g_hLocationHook = SetWinEventHook(EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE, nullptr,
+        ForegroundMonitor_WinEventProc, pid, 0, WINEVENT_OUTOFCONTEXT);
 }
 
-static void Overlay_DestroyAll(HWND hwnd, bool restartScheduler)
+static void ForegroundMonitor_Start()
 {
-    if (!Overlay_IsVisible())
+    if (g_hForegroundHook)
     {
         return;
     }
+    g_hForegroundHook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+        ForegroundMonitor_WinEventProc, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+    ForegroundMonitor_WatchProcess(GetForegroundWindow());
+    g_foregroundCache.Invalidate();
+}
 
-    KillTimer(hwnd, TIMER_OVERLAY_ANIM);
-    KillTimer(hwnd, TIMER_OVERLAY_CLOCK);
+static void ForegroundMonitor_Stop()
+{
+    if (g_hLocationHook)
+    {
+        UnhookWinEvent(g_hLocationHook);
+        g_hLocationHook = nullptr;
+    }
+    if (g_hForegroundHook)
+    {
+        UnhookWinEvent(g_hForegroundHook);
+        g_hForegroundHook = nullptr;
+    }
+}
 
-    for (HWND w : g_overlayWindows)
+static UINT_PTR Engine_TimerId(EngineTimer id)
+{
+    switch (id)
     {
-        if (w)
+    case EngineTimer::Interval:
+        return TIMER_INTERVAL;
+    case EngineTimer::Anim:
+        return TIMER_OVERLAY_ANIM;
+    case EngineTimer::Clock:
+        return TIMER_OVERLAY_CLOCK;
+    }
+    return 0;
+}
+
+// 引擎的 Win32 宿主：计时器挂在主窗口上，遮罩来自窗口池
+class Win32EngineHost final : public EngineHost
+{
+public:
+    void SetTimer(EngineTimer id, std::uint32_t periodMs) override
+    {
+        if (id == EngineTimer::Interval)
         {
-            DestroyWindow(w);
+            Scheduler_Start(g_hwndMain, periodMs);
+            return;
         }
+        ::SetTimer(g_hwndMain, Engine_TimerId(id), periodMs, nullptr);
+    }
+
+    void KillTimer(EngineTimer id) override
+    {
+        if (id == EngineTimer::Interval)
+        {
+            Scheduler_Stop(g_hwndMain);
+            return;
+        }
+        ::KillTimer(g_hwndMain, Engine_TimerId(id));
+    }
+
+    bool ShowSurfaces() override;
+
+    void HideSurfaces() override
+    {
+        // 窗口隐藏后留在池中供下次提醒复用，退出时才真正销毁；像素内存现在就还
+        g_overlayPool.Hide();
+        Overlay_StopAnim();
+        Overlay_ReleaseShowMemory();
     }
-    g_overlayWindows.clear();
 
-    g_overlayState.store(OverlayState::Hidden);
-    InputMonitor_Stop();
+    void SetAlpha(std::uint8_t alpha) override { Overlay_SetAlphaAll(alpha); }
+    void InvalidateSurfaces() override { Overlay_InvalidateAll(); }
+    void ReconcileSurfaces() override { Overlay_ReconcileTopology(g_hwndMain); }
+    void StartInput() override { InputMonitor_Start(); }
+    void StopInput() override { InputMonitor_Stop(); }
+    void ResetActivityLatch() override { g_activityLatch.store(0); }
+    void OnStateChanged(OverlayState prev, OverlayState next) override;
+
+    EngineShowPolicy QueryShowPolicy() override;
+
+private:
+    // 只对紧接着的这一次显示有效；立即提醒与预览不经过策略
+    bool m_skipFullscreen = false;
+};
+
+static Win32EngineHost g_engineHost;
+static OverlayEngine g_engine(g_engineHost);
+// --record 时记录引擎的全部输入，退出时写入 session.ssrlog，可在任何平台上回放
+static std::unique_ptr<EngineRecorder> g_engineRecorder;
+
+void Win32EngineHost::OnStateChanged(OverlayState, OverlayState next)
+{
+    Overlay_SetState(next, g_engine.IsPreview());
+    if (next == OverlayState::WaitingInput)
+    {
+        ProcessFootprint_Read(0, g_footprintActive);
+    }
+}
+
+static std::uint64_t Engine_Now()
+{
+    return GetTickCount64();
+}
+
+bool Win32EngineHost::ShowSurfaces()
+{
+    // 遮罩窗口通常已在提醒前创建，这里只需设置透明度并显示
+    TRACE_SCOPE(TRACE_CAT_OVERLAY, "Overlay_Show");
+    Overlay_EnsureReady();
+    g_overlayPool.SetRegionSpec(g_config.overlayRegions);
+    const bool skip = m_skipFullscreen && !g_engine.IsPreview();
+    m_skipFullscreen = false;
+    if (!g_overlayPool.Show(0, skip ? &g_fullscreenPolicy.SkipMonitor() : nullptr))
+    {
+        return false;
+    }
+    Overlay_StartAnim();
+    // 第一次绘制在消息循环里，这时模板已带上这一次提醒
+    Overlay_ShowText();
+    return true;
+}
+
+EngineShowPolicy Win32EngineHost::QueryShowPolicy()
+{
+    Overlay_EnsureReady();
+    const size_t monitors = g_overlayPool.Prepare();
+    const EngineShowPolicy policy = g_fullscreenPolicy.Evaluate((FullscreenMode)g_engine.Config().fullscreenMode, monitors, Engine_Now());
+    m_skipFullscreen = g_fullscreenPolicy.LastAction() == FullscreenAction::ShowOthers;
+    if (policy != EngineShowPolicy::Show || m_skipFullscreen)
+    {
+        Trace_Instant(TRACE_CAT_OVERLAY, "fullscreen_policy", (std::int64_t)g_fullscreenPolicy.LastAction());
+    }
+    return policy;
+}
+
+// 启动时读取一次上次保存的调度状态，接着上次的倒计时继续
+static void Scheduler_Resume()
+{
+    SchedulerStateRecord saved;
+    const bool resumed = g_schedulerState.Open(GetSchedulerStatePath(), saved);
+    if (resumed)
+    {
+        g_schedulerRecord.lastBreakUnixMs = saved.lastBreakUnixMs;
+    }
+    const std::uint32_t delayMs = resumed ? SchedulerState_ResumeDelayMs(saved, SchedulerState_NowUnixMs(), (std::uint32_t)g_config.intervalMinutes) : 0;
+    g_engine.Start(Engine_Now(), g_config);
+    if (delayMs != 0)
+    {
+        Trace_Instant(TRACE_CAT_SCHEDULER, "Scheduler_Resume", delayMs);
+        g_engine.OnResume(Engine_Now(), delayMs);
+    }
+}
 
-    if (restartScheduler)
+// 稍后提醒没有立即生效（遮罩正在淡入淡出）时记下来，重启后仍然有效
+static void Scheduler_OnSnoozed()
+{
+    const std::uint32_t pendingMs = g_engine.PendingSnoozeMs();
+    if (pendingMs != 0)
     {
-        Scheduler_Start(hwnd);
+        g_schedulerRecord.pendingSnoozeMinutes = pendingMs / 60000u;
+        SchedulerState_Save();
     }
 }
 
-static void Overlay_Hide(HWND hwnd)
+// GUID_CONSOLE_DISPLAY_STATE：0 关闭、1 打开、2 变暗
+static const GUID kConsoleDisplayState = { 0x6FE69556, 0x704A, 0x47A0, { 0x8F, 0x24, 0xC2, 0x8D, 0x93, 0x6F, 0xDA, 0x47 } };
+
+static PresenceTracker g_presence;
+static HPOWERNOTIFY g_hDisplayNotify = nullptr;
+
+static void Presence_Start(HWND hwnd)
+{
+    WTSRegisterSessionNotification(hwnd, NOTIFY_FOR_THIS_SESSION);
+    // 注册后系统立即发来一次当前的显示器状态
+    g_hDisplayNotify = RegisterPowerSettingNotification(hwnd, &kConsoleDisplayState, DEVICE_NOTIFY_WINDOW_HANDLE);
+}
+
+static void Presence_Stop(HWND hwnd)
 {
-    Overlay_DestroyAll(hwnd, true);
+    WTSUnRegisterSessionNotification(hwnd);
+    if (g_hDisplayNotify)
+    {
+        UnregisterPowerSettingNotification(g_hDisplayNotify);
+        g_hDisplayNotify = nullptr;
+    }
 }
 
-static void Overlay_TickAnim(HWND hwnd)
+// 离开时引擎撤下遮罩并暂停计时；这里再停掉前台窗口钩子与设置预览的时间刷新
+static void Presence_Notify(PresenceReason reason, bool active)
 {
-    if (!Overlay_IsVisible())
+    const std::uint64_t now = Engine_Now();
+    if (!g_presence.Set(reason, active, now))
     {
-        KillTimer(hwnd, TIMER_OVERLAY_ANIM);
         return;
     }
+    const bool present = g_presence.IsPresent();
+    Trace_Instant(TRACE_CAT_SCHEDULER, present ? "Presence_Back" : "Presence_Away", (std::int64_t)g_presence.Reasons());
+    if (!present)
+    {
+        ForegroundMonitor_Stop();
+        if (g_hwndSettings)
+        {
+            KillTimer(g_hwndSettings, TIMER_PREVIEW_CLOCK);
+        }
+        g_engine.OnPresence(now, false);
+        return;
+    }
+
+    ForegroundMonitor_Start();
+    if (g_hwndSettings && IsWindowVisible(g_hwndSettings))
+    {
+        SetTimer(g_hwndSettings, TIMER_PREVIEW_CLOCK, 1000, nullptr);
+    }
+    if (g_engine.OnPresence(now, true))
+    {
+        // 随后的 SchedulerStart 会一并写入
+        g_schedulerRecord.lastBreakUnixMs = SchedulerState_NowUnixMs();
+    }
+}
+
+static void Presence_OnSessionChange(WPARAM code)
+{
+    switch (code)
+    {
+    case WTS_SESSION_LOCK:
+        Presence_Notify(PRESENCE_LOCKED, true);
+        break;
+    case WTS_SESSION_UNLOCK:
+        Presence_Notify(PRESENCE_LOCKED, false);
+        break;
+    case WTS_CONSOLE_DISCONNECT:
+    case WTS_REMOTE_DISCONNECT:
+        Presence_Notify(PRESENCE_DISCONNECTED, true);
+        break;
+    case WTS_CONSOLE_CONNECT:
+    case WTS_REMOTE_CONNECT:
+        Presence_Notify(PRESENCE_DISCONNECTED, false);
+        break;
+    default:
+        break;
+    }
+}
 
-    const auto state = g_overlayState.load();
-    const ULONGLONG now = GetTickCount64();
-    const ULONGLONG elapsedMs = now - g_fadeStartTick;
-    const ULONGLONG durationMs = (ULONGLONG)g_overlayConfig.fadeSeconds * 1000ull;
+static void Presence_OnPowerSetting(const POWERBROADCAST_SETTING* setting)
+{
+    if (setting && setting->DataLength >= sizeof(DWORD) && IsEqualGUID(setting->PowerSetting, kConsoleDisplayState))
+    {
+        DWORD state = 0;
+        std::memcpy(&state, setting->Data, sizeof(state));
+        Presence_Notify(PRESENCE_DISPLAY_OFF, state == 0);
+    }
+}
+
+static HFONT CreateUIFont(int pointSize, int dpi, bool bold)
+{
+    const int heightPx = -MulDiv(pointSize, dpi, 72);
+    return CreateFontW(heightPx, 0, 0, 0, bold ? FW_SEMIBOLD : FW_NORMAL, FALSE, FALSE, FALSE,
+        DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI");
+}
 
-    if (durationMs == 0)
+struct OverlayLayout
+{
+    HFONT fontTime = nullptr;
+    HFONT fontText = nullptr;
+    RECT rcTime{};
+    RECT rcText{};
+    std::vector<RECT> rcLines;   // 模板各行在 rcText 中的位置
+};
+
+// 逐行测量模板折行后的高度，只测量内容变过的行；需要测量时才创建字体。返回行高是否变化
+static bool Overlay_MeasureLines(HDC dc, int width, int dpi, const TextTemplate& text, TextLineLayout& lines)
+{
+    const int availWidth = std::max(1, width - (MulDiv(80, dpi, 96) * 2));
+    HFONT font = nullptr;
+    HGDIOBJ oldFont = nullptr;
+    const std::uint64_t key = ((std::uint64_t)(std::uint32_t)width << 32) | (std::uint32_t)dpi;
+    const bool changed = lines.Update(text, key, [&](std::wstring_view line)
     {
+        if (!font)
+        {
+            font = CreateUIFont(36, dpi, false);
+            oldFont = SelectObject(dc, font);
+        }
+        // 空行按一个空格测量，与整段测量时空行也占一行一致
+        RECT calc{ 0, 0, availWidth, 0 };
+        DrawTextW(dc, line.empty() ? L" " : line.data(), line.empty() ? 1 : (int)line.size(), &calc,
+            DT_CALCRECT | DT_WORDBREAK | DT_NOPREFIX);
+        return (int)(calc.bottom - calc.top);
+    });
+    if (font)
+    {
+        SelectObject(dc, oldFont);
+        DeleteObject(font);
+    }
+    return changed;
+}
+
+static void Overlay_Layout(HDC dc, int width, int height, int dpi, const TextTemplate& text, TextLineLayout& lines, const OverlayAnim& anim, OverlayLayout& layout)
+{
+    layout.fontTime = CreateUIFont(72, dpi, true);
+    layout.fontText = CreateUIFont(36, dpi, false);
+
+    const int marginX = MulDiv(80, dpi, 96);
+    const int gap = MulDiv(18, dpi, 96);
+    const int availWidth = std::max(1, width - (marginX * 2));
+
+    // 时间区域的高度只取决于字体，用固定的样例字符串测量
+    SelectObject(dc, layout.fontTime);
+    RECT timeCalc{ 0, 0, availWidth, 0 };
+    DrawTextW(dc, L"00:00:00", -1, &timeCalc, DT_CALCRECT | DT_SINGLELINE | DT_NOPREFIX);
+    const int timeH = timeCalc.bottom - timeCalc.top;
+
+    if (anim.key)
+    {
+        // 文字的位置换成动画
+        ScreenRect timeRect;
+        ScreenRect animRect;
+        Soft_LayoutAnimation(width, height, dpi, timeH, anim.width, anim.height, timeRect, animRect);
+        layout.rcTime = RECT{ timeRect.left, timeRect.top, timeRect.right, timeRect.bottom };
+        layout.rcText = RECT{ animRect.left, animRect.top, animRect.right, animRect.bottom };
         return;
     }
 
-    if (state == OverlayState::FadingIn)
+    // 各行分别折行，与整段 DT_WORDBREAK 的结果相同；只有变过的行重新测量
+    Overlay_MeasureLines(dc, width, dpi, text, lines);
+    const int textH = lines.TotalHeight();
+
+    const int combinedH = timeH + (textH > 0 ? (gap + textH) : 0);
+    int startY = (height - combinedH) / 2;
+    if (startY < 0) startY = 0;
+
+    layout.rcTime = RECT{ marginX, startY, width - marginX, startY + timeH };
+    layout.rcText = RECT{ marginX, startY + timeH + gap, width - marginX, startY + timeH + gap + textH };
+    layout.rcLines.resize(text.LineCount());
+    for (size_t i = 0; i < text.LineCount(); i++)
     {
-        if (elapsedMs >= durationMs)
+        const int top = layout.rcText.top + lines.Top(i);
+        layout.rcLines[i] = RECT{ marginX, top, width - marginX, top + lines.Height(i) };
+    }
+}
+
+static void Overlay_FreeLayout(OverlayLayout& layout)
+{
+    DeleteObject(layout.fontTime);
+    DeleteObject(layout.fontText);
+    layout.fontTime = nullptr;
+    layout.fontText = nullptr;
+}
+
+static void Overlay_DrawLines(HDC dc, const TextTemplate& text, const OverlayLayout& layout, bool dynamic)
+{
+    SetBkMode(dc, TRANSPARENT);
+    SetTextColor(dc, RGB(255, 255, 255));
+    SelectObject(dc, layout.fontText);
+    for (size_t i = 0; i < text.LineCount() && i < layout.rcLines.size(); i++)
+    {
+        const std::wstring_view line = text.Line(i);
+        if (text.IsDynamicLine(i) != dynamic || line.empty())
         {
-            g_currentAlpha = g_targetAlpha;
-            Overlay_SetAlphaAll(g_currentAlpha);
-            g_overlayState.store(OverlayState::WaitingInput);
-            g_activityLatch.store(0);
-            KillTimer(hwnd, TIMER_OVERLAY_ANIM);
-            return;
+            continue;
         }
+        RECT rcLine = layout.rcLines[i];
+        DrawTextW(dc, line.data(), (int)line.size(), &rcLine, DT_CENTER | DT_WORDBREAK | DT_NOPREFIX);
+    }
+}
+
+// 背景与不含变量的文字行；含变量的行每次绘制时由 Overlay_DrawDynamicText 画在上面
+static void Overlay_DrawBase(HDC dc, int width, int height, const AppConfig& cfg, const TextTemplate& text, const OverlayAnim& anim, const OverlayLayout& layout)
+{
+    RECT rc{ 0, 0, width, height };
+    HBRUSH brush = CreateSolidBrush(cfg.bgColor);
+    FillRect(dc, &rc, brush);
+    DeleteObject(brush);
+
+    if (!anim.key)
+    {
+        Overlay_DrawLines(dc, text, layout, false);
+    }
+}
+
+static void Overlay_DrawDynamicText(HDC dc, const TextTemplate& text, const OverlayAnim& anim, const OverlayLayout& layout)
+{
+    if (!anim.key && text.HasVariables())
+    {
+        Overlay_DrawLines(dc, text, layout, true);
+    }
+}
 
-        const double t = (double)elapsedMs / (double)durationMs;
-        const int alpha = (int)(t * (double)g_targetAlpha);
-        g_currentAlpha = (BYTE)std::clamp(alpha, 0, 255);
-        Overlay_SetAlphaAll(g_currentAlpha);
+static void Overlay_DrawClock(HDC dc, const AppConfig& cfg, const OverlayLayout& layout, const SYSTEMTIME& st)
+{
+    RECT rcTime = layout.rcTime;
+    HBRUSH brush = CreateSolidBrush(cfg.bgColor);
+    FillRect(dc, &rcTime, brush);
+    DeleteObject(brush);
+
+    wchar_t timeBuf[32]{};
+    wsprintfW(timeBuf, L"%02d:%02d:%02d", st.wHour, st.wMinute, st.wSecond);
+
+    SetBkMode(dc, TRANSPARENT);
+    SetTextColor(dc, RGB(255, 255, 255));
+    SelectObject(dc, layout.fontTime);
+    DrawTextW(dc, timeBuf, -1, &rcTime, DT_CENTER | DT_SINGLELINE | DT_NOPREFIX);
+}
+
+static BITMAPINFO Overlay_DibInfo(int width, int height)
+{
+    BITMAPINFO bmi{};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    return bmi;
+}
+
+static std::int64_t UnixSecondsFromFileTime(const FILETIME& ft)
+{
+    const ULONGLONG ticks = ((ULONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    return (std::int64_t)(ticks / 10000000ull) - 11644473600ll;
+}
+
+static std::int64_t UnixSecondNow()
+{
+    FILETIME ft{};
+    GetSystemTimeAsFileTime(&ft);
+    return UnixSecondsFromFileTime(ft);
+}
+
+static SYSTEMTIME LocalTimeFromUnixSecond(std::int64_t unixSecond)
+{
+    const ULONGLONG ticks = (ULONGLONG)(unixSecond + 11644473600ll) * 10000000ull;
+    FILETIME utc{ (DWORD)ticks, (DWORD)(ticks >> 32) };
+    FILETIME local{};
+    FileTimeToLocalFileTime(&utc, &local);
+    SYSTEMTIME st{};
+    FileTimeToSystemTime(&local, &st);
+    return st;
+}
+
+static std::uint64_t Overlay_ContentHash(const AppConfig& cfg, const TextTemplate& text, const TextLineLayout& lines, const OverlayAnim& anim)
+{
+    return anim.key ? OverlayFrame_ContentHash(cfg.bgColor, std::wstring_view(), anim.key) : OverlayFrame_TemplateHash(cfg.bgColor, text.SourceHash(), lines.Signature());
+}
+
+static OverlayFrameKey Overlay_FrameKey(int width, int height, int dpi, const AppConfig& cfg, const TextTemplate& text, const TextLineLayout& lines, const OverlayAnim& anim, const ScreenRegion* clip)
+{
+    return OverlayFrameKey{ width, height, dpi, Overlay_ContentHash(cfg, text, lines, anim), OverlayFrame_RegionHash(clip) };
+}
+
+static OverlayAnim Overlay_CurrentAnim()
+{
+    return g_anim.IsOpen() ? OverlayAnim{ g_anim.Info().width, g_anim.Info().height, g_anim.ContentKey() } : OverlayAnim{};
+}
+
+// unixSecond 那一刻的模板取值。nextPeriodSeconds 为下一次计时的时长（小于 0 时计时暂停），
+// 只用线程安全的系统调用，预渲染线程也可以调用
+static TemplateInputs Overlay_TextInputsAt(std::int64_t unixSecond, std::int64_t nextPeriodSeconds, int breaksToday)
+{
+    TemplateInputs in;
+    const SYSTEMTIME st = LocalTimeFromUnixSecond(unixSecond);
+    in.year = st.wYear;
+    in.month = st.wMonth;
+    in.day = st.wDay;
+    in.hour = st.wHour;
+    in.minute = st.wMinute;
+    in.second = st.wSecond;
+    if (nextPeriodSeconds >= 0)
+    {
+        const SYSTEMTIME next = LocalTimeFromUnixSecond(unixSecond + nextPeriodSeconds);
+        in.nextBreakHour = next.wHour;
+        in.nextBreakMinute = next.wMinute;
+    }
+    in.breaksToday = breaksToday;
+    // 系统范围的最近一次键鼠输入
+    LASTINPUTINFO lii{};
+    lii.cbSize = sizeof(lii);
+    if (GetLastInputInfo(&lii))
+    {
+        in.idleMinutes = (int)((GetTickCount() - lii.dwTime) / 60000u);
+    }
+    return in;
+}
+
+static int Overlay_BreaksToday(std::int64_t unixSecond)
+{
+    int utcOffsetMinutes = 0;
+    return g_breaksToday.Count(LocalDayFromUnixSecond(unixSecond, utcOffsetMinutes));
+}
+
+static TemplateInputs Overlay_TextInputs(std::int64_t unixSecond)
+{
+    // 现在回来的话下一次提醒的时刻；离开期间计时暂停
+    const std::int64_t nextPeriod = g_engine.IsAway() ? -1 : (std::int64_t)(g_engine.NextPeriodMs() / 1000);
+    const bool counts = (g_text.UsedVars() & (1u << (int)TemplateVar::BreaksToday)) != 0;
+    return Overlay_TextInputsAt(unixSecond, nextPeriod, counts ? Overlay_BreaksToday(unixSecond) : 0);
+}
+
+// 配置中的文字换过时重新编译并取值；返回是否重新编译了
+static bool Overlay_SyncText(const AppConfig& cfg)
+{
+    if (cfg.text == g_text.Source())
+    {
+        return false;
+    }
+    g_text.Compile(cfg.text);
+    g_text.Update(Overlay_TextInputs(UnixSecondNow()));
+    return true;
+}
+
+static void Overlay_ShowText()
+{
+    Overlay_SyncText(g_engine.OverlayConfig());
+    g_text.Update(Overlay_TextInputs(UnixSecondNow()));
+}
+
+static OverlaySurfaceText& Overlay_TextEntry(HWND hwnd)
+{
+    for (OverlaySurfaceText& entry : g_surfaceText)
+    {
+        if (entry.hwnd == hwnd)
+        {
+            return entry;
+        }
+    }
+    g_surfaceText.emplace_back();
+    g_surfaceText.back().hwnd = hwnd;
+    return g_surfaceText.back();
+}
+
+// 计时：更新模板的取值，各遮罩都能沿用上次的排版时只让时间与变了的行失效。
+// 返回 false 时需要整窗重画（文字或背景换过、还没有完整绘制过的遮罩）
+static bool Overlay_InvalidateText()
+{
+    const AppConfig& cfg = g_engine.OverlayConfig();
+    if (Overlay_SyncText(cfg))
+    {
+        return false;
+    }
+    g_text.Update(Overlay_TextInputs(UnixSecondNow()));
+
+    const OverlayAnim anim = Overlay_CurrentAnim();
+    bool reuse = true;
+    g_overlayPool.ForEachSurface([&](SurfaceHandle surface, const MonitorInfo&)
+    {
+        const OverlaySurfaceText& entry = Overlay_TextEntry(reinterpret_cast<HWND>(surface));
+        if (!entry.painted || entry.contentHash != Overlay_ContentHash(cfg, g_text, entry.lines, anim))
+        {
+            reuse = false;
+        }
+    });
+    if (!reuse)
+    {
+        return false;
+    }
+    // 行高变了时由 Overlay_Paint 发现并整窗重画
+    g_overlayPool.ForEachSurface([&](SurfaceHandle surface, const MonitorInfo&)
+    {
+        const HWND hwnd = reinterpret_cast<HWND>(surface);
+        const OverlaySurfaceText& entry = Overlay_TextEntry(hwnd);
+        InvalidateRect(hwnd, &entry.rcTime, FALSE);
+        for (std::uint32_t line : g_text.ChangedLines())
+        {
+            if (!anim.key && line < entry.rcLines.size())
+            {
+                InvalidateRect(hwnd, &entry.rcLines[line], FALSE);
+            }
+        }
+    });
+    return true;
+}
+
+// 按配置打开或关闭动画文件；文件缺失或损坏时照常显示文字
+static void Overlay_SyncAnim(const AppConfig& cfg)
+{
+    if (cfg.animation == g_animSetting && (cfg.animation.empty() || g_anim.IsOpen()))
+    {
+        return;
+    }
+    g_animSetting = cfg.animation;
+    g_anim.Close();
+    if (cfg.animation.empty())
+    {
+        return;
+    }
+    std::filesystem::path path(cfg.animation);
+    if (path.is_relative())
+    {
+        path = std::filesystem::path(GetAppDataFolder()) / path;
+    }
+    std::wstring error;
+    if (!g_anim.Open(path, &error))
+    {
+        Trace_Instant(TRACE_CAT_OVERLAY, "anim_open_failed");
+    }
+}
+
+// 遮罩上动画的位置；时间一行的高度只与 DPI 有关，每种 DPI 测量一次后记下
+static ScreenRect Overlay_AnimRect(int width, int height, int dpi)
+{
+    static std::vector<std::pair<int, int>> s_timeHeights;
+    auto it = std::find_if(s_timeHeights.begin(), s_timeHeights.end(), [dpi](const std::pair<int, int>& e) { return e.first == dpi; });
+    if (it == s_timeHeights.end())
+    {
+        HDC dc = GetDC(nullptr);
+        HFONT font = CreateUIFont(72, dpi, true);
+        HGDIOBJ oldFont = SelectObject(dc, font);
+        RECT timeCalc{ 0, 0, width, 0 };
+        DrawTextW(dc, L"00:00:00", -1, &timeCalc, DT_CALCRECT | DT_SINGLELINE | DT_NOPREFIX);
+        SelectObject(dc, oldFont);
+        DeleteObject(font);
+        ReleaseDC(nullptr, dc);
+        s_timeHeights.emplace_back(dpi, timeCalc.bottom - timeCalc.top);
+        it = s_timeHeights.end() - 1;
+    }
+    ScreenRect timeRect;
+    ScreenRect animRect;
+    Soft_LayoutAnimation(width, height, dpi, it->second, g_anim.Info().width, g_anim.Info().height, timeRect, animRect);
+    return animRect;
+}
+
+// 输出动画的当前帧；第一帧还没解出时留着底图上的背景色
+static void Overlay_BlitAnim(HDC hdc, const ScreenRect& rect)
+{
+    if (const std::uint32_t* frame = g_anim.Frame(rect.Width(), rect.Height()))
+    {
+        const BITMAPINFO bmi = Overlay_DibInfo(rect.Width(), rect.Height());
+        SetDIBitsToDevice(hdc, rect.left, rect.top, rect.Width(), rect.Height(), 0, 0, 0, rect.Height(), frame, &bmi, DIB_RGB_COLORS);
+    }
+}
+
+static void Overlay_ArmAnimTimer()
+{
+    std::uint32_t delayMs = 0;
+    KillTimer(g_hwndMain, TIMER_OVERLAY_FRAME);
+    if (g_anim.IsPlaying() && g_anim.NextDelay(Engine_Now(), delayMs))
+    {
+        SetTimer(g_hwndMain, TIMER_OVERLAY_FRAME, delayMs, nullptr);
+    }
+}
+
+static void Overlay_StartAnim()
+{
+    Overlay_SyncAnim(g_engine.OverlayConfig());
+    if (!g_anim.IsOpen())
+    {
         return;
     }
+    std::vector<AnimTarget> targets;
+    g_overlayPool.ForEachSurface([&](SurfaceHandle, const MonitorInfo& monitor)
+    {
+        const ScreenRect r = Overlay_AnimRect(monitor.rect.Width(), monitor.rect.Height(), monitor.dpi);
+        targets.push_back(AnimTarget{ r.Width(), r.Height() });
+    });
+    g_anim.Start(targets, g_engine.OverlayConfig().bgColor, Engine_Now());
+    Overlay_ArmAnimTimer();
+}
+
+static void Overlay_StopAnim()
+{
+    KillTimer(g_hwndMain, TIMER_OVERLAY_FRAME);
+    g_anim.Stop();
+}
 
-    if (state == OverlayState::FadingOut)
+// 换到该显示的帧后只让动画所在的矩形失效，WM_PAINT 走只输出动画的快速路径
+static void Overlay_OnFrameTimer()
+{
+    if (g_anim.Advance(Engine_Now()))
     {
-        if (elapsedMs >= durationMs)
+        g_overlayPool.ForEachSurface([](SurfaceHandle surface, const MonitorInfo& monitor)
+        {
+            const ScreenRect r = Overlay_AnimRect(monitor.rect.Width(), monitor.rect.Height(), monitor.dpi);
+            const RECT rc{ r.left, r.top, r.right, r.bottom };
+            InvalidateRect(reinterpret_cast<HWND>(surface), &rc, FALSE);
+        });
+    }
+    Overlay_ArmAnimTimer();
+}
+
+// 在后台线程渲染一个遮罩的画面：背景与不含变量的文字行一份，叠加好预计那一秒的时间与
+// 含变量的行（text 已按那一秒取值）的一份；clockSecond < 0 时只渲染底图。clip 非空时只填充区域内的部分
+static std::shared_ptr<OverlayFrame> Overlay_RenderFrame(const MonitorInfo& monitor, const AppConfig& cfg, const TextTemplate& text, const OverlayAnim& anim, std::int64_t clockSecond, const ScreenRegion* clip)
+{
+    const int width = monitor.rect.Width();
+    const int height = monitor.rect.Height();
+    if (width <= 0 || height <= 0)
+    {
+        return nullptr;
+    }
+
+    HDC dc = CreateCompatibleDC(nullptr);
+    if (!dc)
+    {
+        return nullptr;
+    }
+    const BITMAPINFO bmi = Overlay_DibInfo(width, height);
+    void* bits = nullptr;
+    HBITMAP dib = CreateDIBSection(dc, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!dib || !bits)
+    {
+        if (dib) DeleteObject(dib);
+        DeleteDC(dc);
+        return nullptr;
+    }
+    HGDIOBJ oldBmp = SelectObject(dc, dib);
+    if (clip)
+    {
+        HRGN rgn = Overlay_CreateRgn(*clip);
+        SelectClipRgn(dc, rgn);
+        DeleteObject(rgn);
+    }
+
+    const size_t count = (size_t)width * (size_t)height;
+    const auto* pixels = static_cast<const std::uint32_t*>(bits);
+
+    OverlayLayout layout;
+    TextLineLayout lines;
+    Overlay_Layout(dc, width, height, monitor.dpi, text, lines, anim, layout);
+
+    auto frame = std::make_shared<OverlayFrame>();
+    frame->key = Overlay_FrameKey(width, height, monitor.dpi, cfg, text, lines, anim, clip);
+    frame->clockSecond = clockSecond;
+    frame->textKey = text.ValuesHash();
+
+    Overlay_DrawBase(dc, width, height, cfg, text, anim, layout);
+    GdiFlush();
+    frame->base.assign(pixels, pixels + count);
+
+    if (clockSecond >= 0)
+    {
+        Overlay_DrawDynamicText(dc, text, anim, layout);
+        Overlay_DrawClock(dc, cfg, layout, LocalTimeFromUnixSecond(clockSecond));
+        GdiFlush();
+        frame->composed.assign(pixels, pixels + count);
+    }
+    Overlay_FreeLayout(layout);
+
+    SelectObject(dc, oldBmp);
+    DeleteObject(dib);
+    DeleteDC(dc);
+    return frame;
+}
+
+static std::uint64_t Assets_PackKey(const std::vector<MonitorInfo>& monitors, const AppConfig& cfg, const OverlayAnim& anim)
+{
+    std::uint64_t hash = OverlayFrame_ContentHash(cfg.bgColor, cfg.text, anim.key);
+    for (const MonitorInfo& m : monitors)
+    {
+        const std::int64_t parts[] = { m.rect.Width(), m.rect.Height(), m.dpi };
+        for (std::int64_t v : parts)
+        {
+            hash = (hash ^ (std::uint64_t)v) * 0x100000001B3ull;
+        }
+    }
+    return hash;
+}
+
+// 预渲染线程：打开与当前配置、显示器对应的资源包；还没有会话发布过时渲染底图并发布
+static void Assets_Prepare(const std::vector<MonitorInfo>& monitors, const AppConfig& cfg, const TextTemplate& text, const OverlayAnim& anim)
+{
+    const std::uint64_t packKey = Assets_PackKey(monitors, cfg, anim);
+    {
+        std::lock_guard<std::mutex> lock(g_assetMutex);
+        if (g_assetPack && g_assetPack->PackKey() == packKey)
         {
-            g_currentAlpha = 0;
-            Overlay_SetAlphaAll(0);
-            Overlay_Hide(hwnd);
             return;
         }
+    }
 
-        const double t = (double)elapsedMs / (double)durationMs;
-        const int alpha = (int)((1.0 - t) * (double)g_targetAlpha);
-        g_currentAlpha = (BYTE)std::clamp(alpha, 0, 255);
-        Overlay_SetAlphaAll(g_currentAlpha);
+    TRACE_SCOPE(TRACE_CAT_OVERLAY, "Assets_Prepare");
+    const std::filesystem::path sharedDir(GetSharedAssetFolder());
+    const std::filesystem::path userDir(GetUserAssetFolder());
+    auto pack = std::make_shared<SharedAssetPack>();
+    if (!pack->Open(sharedDir, packKey) && !pack->Open(userDir, packKey))
+    {
+        AssetPackBuilder builder;
+        std::vector<MonitorInfo> added;
+        for (const MonitorInfo& monitor : monitors)
+        {
+            // 尺寸与 DPI 相同的显示器底图相同（含变量的行高也相同）
+            const bool seen = std::any_of(added.begin(), added.end(), [&](const MonitorInfo& m)
+            {
+                return m.rect.Width() == monitor.rect.Width() && m.rect.Height() == monitor.rect.Height() && m.dpi == monitor.dpi;
+            });
+            if (seen)
+            {
+                continue;
+            }
+            // 共享底图给所有会话使用，总是整屏
+            if (auto frame = Overlay_RenderFrame(monitor, cfg, text, anim, -1, nullptr))
+            {
+                const OverlayFrameKey& key = frame->key;
+                builder.Add(AssetKind::FrameBase, AssetKey{ key.width, key.height, key.dpi, key.contentHash },
+                    frame->base.data(), frame->base.size() * sizeof(std::uint32_t));
+                added.push_back(monitor);
+            }
+        }
+        if (builder.Entries() == 0)
+        {
+            return;
+        }
+        // 共享目录里已有别的普通用户发布的同名资源包时 Publish 不覆盖、Open 不信任，改发布到自己的目录
+        const bool opened = (builder.Publish(sharedDir, packKey) && pack->Open(sharedDir, packKey)) ||
+            (builder.Publish(userDir, packKey) && pack->Open(userDir, packKey));
+        if (!opened)
+        {
+            return;
+        }
+    }
+    std::lock_guard<std::mutex> lock(g_assetMutex);
+    g_assetPack = std::move(pack);
+}
+
+// 界面线程：资源包里有这个遮罩的底图时，返回指向映射内存的画面，不复制像素
+static std::shared_ptr<const OverlayFrame> Assets_FindFrame(const OverlayFrameKey& key)
+{
+    std::shared_ptr<SharedAssetPack> pack;
+    {
+        std::lock_guard<std::mutex> lock(g_assetMutex);
+        pack = g_assetPack;
+    }
+    size_t size = 0;
+    const std::uint8_t* data = pack ? pack->Find(AssetKind::FrameBase, AssetKey{ key.width, key.height, key.dpi, key.contentHash }, size) : nullptr;
+    if (!data || size != (size_t)key.width * (size_t)key.height * sizeof(std::uint32_t))
+    {
+        return nullptr;
+    }
+    auto frame = std::make_shared<OverlayFrame>();
+    frame->key = key;
+    frame->sharedBase = reinterpret_cast<const std::uint32_t*>(data);
+    frame->owner = std::move(pack);
+    g_assetHits.fetch_add(1, std::memory_order_relaxed);
+    return frame;
+}
+
+// 在计时器到点前唤醒后台线程，按当前配置与遮罩池快照预先渲染首帧
+static void Overlay_SchedulePrerender(std::chrono::steady_clock::time_point deadline)
+{
+    if (!g_overlayReady)
+    {
+        // 到点前先由界面线程创建遮罩窗口（TIMER_OVERLAY_WARMUP），再回到这里预渲染
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        const long long delayMs = std::max<long long>(0, (remaining - PRERENDER_LEAD - OVERLAY_WARMUP_LEAD).count());
+        SetTimer(g_hwndMain, TIMER_OVERLAY_WARMUP, (UINT)std::min<long long>(delayMs, 0x7FFFFFFF), nullptr);
         return;
     }
+
+    struct Target
+    {
+        SurfaceHandle surface;
+        MonitorInfo monitor;
+        ScreenRegion region;
+    };
+    std::vector<Target> targets;
+    g_overlayPool.SetRegionSpec(g_config.overlayRegions);
+    g_overlayPool.ForEachSurface([&](SurfaceHandle surface, const MonitorInfo& monitor)
+    {
+        const ScreenRegion* region = g_overlayPool.RegionOf(surface);
+        if (region && !region->IsEmpty())
+        {
+            targets.push_back(Target{ surface, monitor, *region });
+        }
+    });
+    if (targets.empty())
+    {
+        g_prerender.Cancel();
+        return;
+    }
+
+    // 动画只读文件头，首帧由提醒时的解码线程送来
+    Overlay_SyncAnim(g_config);
+    // 模板的取值按预计弹出的那一秒计算；提醒次数取弹出那天的，并含即将弹出的这一次（与弹出后的取值一致）
+    TextTemplate text;
+    text.Compile(g_config.text);
+    const std::int64_t nextPeriod = (std::int64_t)(g_engine.NextPeriodMs() / 1000);
+    const bool countsBreaks = (text.UsedVars() & (1u << (int)TemplateVar::BreaksToday)) != 0;
+    // 取消或提醒结束清空缓存之后才画完的画面不再写入
+    const std::uint64_t generation = g_frameCache.Generation();
+    g_prerender.Schedule(deadline, PRERENDER_LEAD, [targets = std::move(targets), cfg = g_config, anim = Overlay_CurrentAnim(), text = std::move(text), nextPeriod, countsBreaks, generation](std::int64_t predictedUnixMs) mutable
+    {
+        int utcOffsetMinutes = 0;
+        const int breaksToday = countsBreaks ? g_breaksToday.CountWithNext(LocalDayFromUnixSecond(predictedUnixMs / 1000, utcOffsetMinutes)) : 0;
+        text.Update(Overlay_TextInputsAt(predictedUnixMs / 1000, nextPeriod, breaksToday));
+        if (g_footprintMode)
+        {
+            // 只准备共享底图，不为本会话保留首帧
+            std::vector<MonitorInfo> monitors;
+            for (const Target& target : targets)
+            {
+                monitors.push_back(target.monitor);
+            }
+            Assets_Prepare(monitors, cfg, text, anim);
+            return;
+        }
+        const std::int64_t second = predictedUnixMs / 1000;
+        for (const Target& target : targets)
+        {
+            const ScreenRegion* clip = Overlay_Clip(&target.region, target.monitor.rect.Width(), target.monitor.rect.Height());
+            if (auto frame = Overlay_RenderFrame(target.monitor, cfg, text, anim, second, clip))
+            {
+                if (!g_frameCache.Store(target.surface, std::move(frame), generation))
+                {
+                    return;
+                }
+            }
+        }
+    });
 }
 
-static HFONT CreateUIFont(int pointSize, int dpi, bool bold)
+static void Overlay_CancelPrerender()
 {
-    const int heightPx = -MulDiv(pointSize, dpi, 72);
-    return CreateFontW(heightPx, 0, 0, 0, bold ? FW_SEMIBOLD : FW_NORMAL, FALSE, FALSE, FALSE,
-        DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI");
+    if (g_hwndMain)
+    {
+        KillTimer(g_hwndMain, TIMER_OVERLAY_WARMUP);
+    }
+    g_prerender.Cancel();
+    // 已经在渲染的任务停不下来，让它画完的画面作废
+    g_frameCache.Revoke();
 }
 
 static void Overlay_Paint(HWND hwnd)
 {
+    TRACE_SCOPE(TRACE_CAT_OVERLAY, "Overlay_Paint");
     PAINTSTRUCT ps{};
     HDC hdc = BeginPaint(hwnd, &ps);
 
     RECT rc{};
     GetClientRect(hwnd, &rc);
-
-    const int dpi = GetDpiForWindow(hwnd);
-    HFONT fontTime = CreateUIFont(72, dpi, true);
-    HFONT fontText = CreateUIFont(36, dpi, false);
-
     const int width = rc.right - rc.left;
     const int height = rc.bottom - rc.top;
+    const int dpi = GetDpiForWindow(hwnd);
+    const BITMAPINFO bmi = Overlay_DibInfo(width, height);
 
-    HDC memDc = CreateCompatibleDC(hdc);
-    HBITMAP memBmp = CreateCompatibleBitmap(hdc, width, height);
-    HGDIOBJ oldBmp = SelectObject(memDc, memBmp);
-
-    HBRUSH brush = CreateSolidBrush(g_overlayConfig.bgColor);
-    FillRect(memDc, &rc, brush);
-    DeleteObject(brush);
-
-    SetBkMode(memDc, TRANSPARENT);
-    SetTextColor(memDc, RGB(255, 255, 255));
-
-    SYSTEMTIME st{};
-    GetLocalTime(&st);
-    wchar_t timeBuf[32]{};
-    wsprintfW(timeBuf, L"%02d:%02d:%02d", st.wHour, st.wMinute, st.wSecond);
-
-    const int marginX = MulDiv(80, dpi, 96);
-    const int gap = MulDiv(18, dpi, 96);
-    const int availWidth = std::max(1, width - (marginX * 2));
+    const OverlayAnim anim = Overlay_CurrentAnim();
+    const ScreenRect animRect = anim.key ? Overlay_AnimRect(width, height, dpi) : ScreenRect{};
+    if (anim.key && ps.rcPaint.left >= animRect.left && ps.rcPaint.top >= animRect.top &&
+        ps.rcPaint.right <= animRect.right && ps.rcPaint.bottom <= animRect.bottom)
+    {
+        // 只是动画换帧：其余部分仍在屏幕上，不必重画底图与时间
+        Overlay_BlitAnim(hdc, animRect);
+        EndPaint(hwnd, &ps);
+        return;
+    }
 
-    SelectObject(memDc, fontTime);
-    RECT timeCalc{ 0, 0, availWidth, 0 };
-    DrawTextW(memDc, timeBuf, -1, &timeCalc, DT_CALCRECT | DT_SINGLELINE | DT_NOPREFIX);
-    const int timeH = timeCalc.bottom - timeCalc.top;
+    const SurfaceHandle surface = reinterpret_cast<SurfaceHandle>(hwnd);
+    const ScreenRegion* clip = Overlay_Clip(g_overlayPool.RegionOf(surface), width, height);
+    const AppConfig& cfg = g_engine.OverlayConfig();
+    Overlay_SyncText(cfg);
+    OverlaySurfaceText& entry = Overlay_TextEntry(hwnd);
+    if (!anim.key && Overlay_MeasureLines(hdc, width, dpi, g_text, entry.lines) && entry.painted)
+    {
+        // 含变量的行折行数变了，下面的行跟着挪动：这次只画了失效的部分，接着整窗重画
+        InvalidateRect(hwnd, nullptr, FALSE);
+    }
+    const OverlayFrameKey key = Overlay_FrameKey(width, height, dpi, cfg, g_text, entry.lines, anim, clip);
+    auto frame = g_frameCache.Find(surface, key);
+    if (!frame && g_footprintMode)
+    {
+        frame = Assets_FindFrame(key);
+        if (frame)
+        {
+            g_frameCache.Store(surface, frame);
+        }
+    }
+    const std::int64_t second = UnixSecondNow();
 
-    int textH = 0;
-    if (!g_overlayConfig.text.empty())
+    // 预渲染命中：首帧只需输出（含变量的行按同样的取值画好）
+    if (frame && frame->clockSecond == second && frame->textKey == g_text.ValuesHash() && !frame->composed.empty())
     {
-        SelectObject(memDc, fontText);
-        RECT textCalc{ 0, 0, availWidth, 0 };
-        DrawTextW(memDc, g_overlayConfig.text.c_str(), (int)g_overlayConfig.text.size(), &textCalc,
-            DT_CALCRECT | DT_WORDBREAK | DT_NOPREFIX);
-        textH = textCalc.bottom - textCalc.top;
+        g_frameCache.CountHit();
+        Trace_Instant(TRACE_CAT_OVERLAY, "prerender_hit");
+        SetDIBitsToDevice(hdc, 0, 0, width, height, 0, 0, 0, height, frame->composed.data(), &bmi, DIB_RGB_COLORS);
+        if (anim.key)
+        {
+            Overlay_BlitAnim(hdc, animRect);
+        }
+        EndPaint(hwnd, &ps);
+        return;
     }
 
-    const int combinedH = timeH + (textH > 0 ? (gap + textH) : 0);
-    int startY = (height - combinedH) / 2;
-    if (startY < 0) startY = 0;
+    HDC memDc = CreateCompatibleDC(hdc);
+    void* bits = nullptr;
+    HBITMAP memBmp = CreateDIBSection(memDc, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    HGDIOBJ oldBmp = SelectObject(memDc, memBmp);
+    if (clip)
+    {
+        // 背景、文字与时间只填充窗口区域内的部分
+        HRGN rgn = Overlay_CreateRgn(*clip);
+        SelectClipRgn(memDc, rgn);
+        DeleteObject(rgn);
+    }
 
-    RECT rcTime{ marginX, startY, width - marginX, startY + timeH };
-    SelectObject(memDc, fontTime);
-    DrawTextW(memDc, timeBuf, -1, &rcTime, DT_CENTER | DT_SINGLELINE | DT_NOPREFIX);
+    OverlayLayout layout;
+    Overlay_Layout(memDc, width, height, dpi, g_text, entry.lines, anim, layout);
 
-    if (!g_overlayConfig.text.empty())
+    const size_t count = (size_t)width * (size_t)height;
+    if (frame && bits)
     {
-        RECT rcText{ marginX, rcTime.bottom + gap, width - marginX, rcTime.bottom + gap + textH };
-        SelectObject(memDc, fontText);
-        DrawTextW(memDc, g_overlayConfig.text.c_str(), (int)g_overlayConfig.text.size(), &rcText,
-            DT_CENTER | DT_WORDBREAK | DT_NOPREFIX);
+        // 预测的秒数或模板取值已过期，或只有底图（含共享资源包里的底图）：复用背景与不含变量的行
+        g_frameCache.CountStale();
+        Trace_Instant(TRACE_CAT_OVERLAY, "prerender_stale", second - frame->clockSecond);
+        GdiFlush();
+        PixelBuffer dst{ static_cast<std::uint32_t*>(bits), width, height, width, clip };
+        Soft_Copy(dst, frame->BasePixels(), width);
+    }
+    else
+    {
+        g_frameCache.CountMiss();
+        Trace_Instant(TRACE_CAT_OVERLAY, "prerender_miss");
+        Overlay_DrawBase(memDc, width, height, cfg, g_text, anim, layout);
+        if (bits)
+        {
+            // 留一份底图，此后每秒的重绘只需画时间与含变量的行
+            GdiFlush();
+            auto baseFrame = std::make_shared<OverlayFrame>();
+            baseFrame->key = key;
+            const auto* pixels = static_cast<const std::uint32_t*>(bits);
+            baseFrame->base.assign(pixels, pixels + count);
+            g_frameCache.Store(surface, std::move(baseFrame));
+        }
     }
 
-    DeleteObject(fontTime);
-    DeleteObject(fontText);
+    Overlay_DrawDynamicText(memDc, g_text, anim, layout);
+    Overlay_DrawClock(memDc, cfg, layout, LocalTimeFromUnixSecond(second));
+    entry.rcTime = layout.rcTime;
+    entry.rcLines = layout.rcLines;
+    entry.contentHash = key.contentHash;
+    entry.painted = true;
+    Overlay_FreeLayout(layout);
 
-    BitBlt(hdc, 0, 0, width, height, memDc, 0, 0, SRCCOPY);
+    const ScreenRect blit = clip ? clip->Bounds() : ScreenRect{ 0, 0, width, height };
+    BitBlt(hdc, blit.left, blit.top, blit.Width(), blit.Height(), memDc, blit.left, blit.top, SRCCOPY);
+    if (anim.key)
+    {
+        Overlay_BlitAnim(hdc, animRect);
+    }
 
     SelectObject(memDc, oldBmp);
     DeleteObject(memBmp);
@@ -799,26 +2029,193 @@ static bool AutoStart_Apply(bool enabled, std::wstring& error)
         error = L"开启开机自启失败。";
         return false;
     }
-
-    return true;
+
+    return true;
+}
+
+static void App_Exit()
+{
+    if (g_exiting.exchange(true))
+    {
+        return;
+    }
+    g_engine.OnExit(Engine_Now());
+    g_overlayPool.DestroyAll();
+    if (g_hwndSettings)
+    {
+        DestroyWindow(g_hwndSettings);
+        g_hwndSettings = nullptr;
+    }
+    Tray_Destroy();
+    PostQuitMessage(0);
+}
+
+// 后台 I/O 线程调用：收件箱由空变为非空时才投递消息，一批请求只唤醒界面线程一次
+static void Control_OnBatch(std::vector<ControlRequest>& batch)
+{
+    bool notify;
+    {
+        std::lock_guard<std::mutex> lock(g_controlInboxMutex);
+        notify = g_controlInbox.empty();
+        for (auto& request : batch)
+        {
+            g_controlInbox.push_back(std::move(request));
+        }
+    }
+    if (notify)
+    {
+        PostMessageW(g_hwndMain, WMAPP_CONTROL, 0, 0);
+    }
+}
+
+static void Control_AppendLine(std::string& out, const char* key, long long value)
+{
+    out += key;
+    out += '=';
+    out += std::to_string(value);
+    out += '\n';
+}
+
+static void Control_Status(std::string& out)
+{
+    out += "state=";
+    out += OverlayFsm_StateName(g_engine.State());
+    out += '\n';
+    Control_AppendLine(out, "preview", g_engine.IsPreview() ? 1 : 0);
+    Control_AppendLine(out, "away", g_engine.IsAway() ? 1 : 0);
+    Control_AppendLine(out, "alpha", g_engine.Alpha());
+    Control_AppendLine(out, "interval_minutes", g_config.intervalMinutes);
+    long long nextMs = -1;
+    if (g_schedulerDeadline != std::chrono::steady_clock::time_point{})
+    {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(g_schedulerDeadline - std::chrono::steady_clock::now());
+        nextMs = std::max<long long>(0, remaining.count());
+    }
+    Control_AppendLine(out, "next_reminder_ms", nextMs);
+}
+
+static void Control_Metrics(std::string& out)
+{
+    const ControlServerStats control = g_controlServer.GetStats();
+    Control_AppendLine(out, "surfaces", (long long)g_overlayPool.Size());
+    Control_AppendLine(out, "overlay_ready", g_overlayReady ? 1 : 0);
+    g_startup.AppendText(out);
+    Control_AppendLine(out, "frame_cache_hits", (long long)g_frameCache.Hits());
+    Control_AppendLine(out, "frame_cache_stale", (long long)g_frameCache.Stale());
+    Control_AppendLine(out, "frame_cache_misses", (long long)g_frameCache.Misses());
+    Control_AppendLine(out, "frame_cache_discarded", (long long)g_frameCache.Discarded());
+    Control_AppendLine(out, "prerender_completed", (long long)g_prerender.Completed());
+    Control_AppendLine(out, "trace_events", (long long)Trace_EventCount());
+    Control_AppendLine(out, "fullscreen_deferred", (long long)g_fullscreenPolicy.Stats().deferred);
+    Control_AppendLine(out, "fullscreen_suppressed", (long long)g_fullscreenPolicy.Stats().suppressed);
+    Control_AppendLine(out, "fullscreen_partial", (long long)g_fullscreenPolicy.Stats().partial);
+    Control_AppendLine(out, "foreground_probes", (long long)g_foregroundCache.Probes());
+    Control_AppendLine(out, "presence_absences", (long long)g_presence.Stats().absences);
+    Control_AppendLine(out, "presence_away_ms", (long long)g_presence.Stats().awayMs);
+    {
+        std::lock_guard<std::mutex> lock(g_assetMutex);
+        Control_AppendLine(out, "footprint_mode", g_footprintMode ? 1 : 0);
+        Control_AppendLine(out, "shared_asset_bytes", g_assetPack ? (long long)g_assetPack->MappedBytes() : 0);
+    }
+    Control_AppendLine(out, "shared_asset_hits", (long long)g_assetHits.load(std::memory_order_relaxed));
+    ProcessFootprint footprint;
+    if (ProcessFootprint_Read(0, footprint))
+    {
+        Control_AppendLine(out, "process_private_bytes", (long long)footprint.privateBytes);
+        Control_AppendLine(out, "process_shared_bytes", (long long)footprint.sharedBytes);
+    }
+    Control_AppendLine(out, "footprint_idle_bytes", (long long)g_footprintIdle.rssBytes);
+    Control_AppendLine(out, "footprint_idle_private_bytes", (long long)g_footprintIdle.privateBytes);
+    Control_AppendLine(out, "footprint_active_bytes", (long long)g_footprintActive.rssBytes);
+    Control_AppendLine(out, "footprint_active_private_bytes", (long long)g_footprintActive.privateBytes);
+    const ShowArenaStats arena = ShowArena_Overlay().Stats();
+    Control_AppendLine(out, "show_arena_bytes", (long long)arena.reservedBytes);
+    Control_AppendLine(out, "show_arena_peak_bytes", (long long)arena.peakBytes);
+    Control_AppendLine(out, "show_arena_releases", (long long)arena.releases);
+    Control_AppendLine(out, "show_arena_deferred", (long long)arena.deferred);
+    Control_AppendLine(out, "show_arena_pinned_bytes", (long long)arena.pinnedBytes);
+    ProcessHandles handles;
+    ProcessHandles_ReadSelf(handles);
+    Control_AppendLine(out, "gdi_objects", (long long)handles.gdiObjects);
+    Control_AppendLine(out, "user_objects", (long long)handles.userObjects);
+    Control_AppendLine(out, "handle_count", (long long)handles.handles);
+    Control_AppendLine(out, "hide_cycles", (long long)g_hideCycles);
+    Control_AppendLine(out, "gdi_growth_since_first_hide", (long long)g_handlesAfterHide.gdiObjects - (long long)g_handlesBaseline.gdiObjects);
+    Control_AppendLine(out, "user_growth_since_first_hide", (long long)g_handlesAfterHide.userObjects - (long long)g_handlesBaseline.userObjects);
+    Control_AppendLine(out, "config_layers", (long long)g_configLayers.LayerCount());
+    Control_AppendLine(out, "config_locked", (long long)g_configLayers.Locked());
+    Control_AppendLine(out, "config_problems", (long long)g_configLayers.Problems().size());
+    Control_AppendLine(out, "config_parsed", (long long)g_configLayers.Stats().parsed);
+    Control_AppendLine(out, "config_skipped", (long long)g_configLayers.Stats().skipped);
+    Control_AppendLine(out, "control_connections", (long long)control.connections);
+    Control_AppendLine(out, "control_clients", (long long)control.activeClients);
+    Control_AppendLine(out, "control_requests", (long long)control.requests);
+    Control_AppendLine(out, "control_batches", (long long)control.batches);
+    Control_AppendLine(out, "control_max_batch", (long long)control.maxBatch);
+    Control_AppendLine(out, "control_protocol_errors", (long long)control.protocolErrors);
+}
+
+static void Control_Handle(const ControlRequest& request, ControlResponse& response)
+{
+    Trace_Instant(TRACE_CAT_CONTROL, Control_OpName(request.op), (std::int64_t)request.client);
+    const std::uint64_t now = Engine_Now();
+    switch (request.op)
+    {
+    case ControlOp::Status:
+        Control_Status(response.body);
+        break;
+    case ControlOp::Snooze:
+    {
+        std::uint32_t minutes = 0;
+        if (!Control_ParseSnoozeArg(request.arg, minutes) || minutes == 0)
+        {
+            response.status = ControlStatus::BadRequest;
+            break;
+        }
+        g_engine.OnSnooze(now, minutes);
+        Scheduler_OnSnoozed();
+        break;
+    }
+    case ControlOp::TriggerNow:
+        if (g_engine.State() != OverlayState::Hidden)
+        {
+            response.status = ControlStatus::Busy;
+            break;
+        }
+        g_engine.OnTriggerNow(now);
+        break;
+    case ControlOp::ReloadConfig:
+        LoadConfig(g_config);
+        g_engine.OnConfigSaved(now, g_config);
+        break;
+    case ControlOp::Metrics:
+        Control_Metrics(response.body);
+        break;
+    case ControlOp::Trace:
+        Trace_WriteJson(response.body, true);
+        break;
+    case ControlOp::OpenSettings:
+        Settings_Show(g_hwndMain);
+        break;
+    }
 }
 
-static void App_Exit(HWND hwnd)
+static void Control_Drain()
 {
-    if (g_exiting.exchange(true))
+    std::vector<ControlRequest> batch;
     {
-        return;
+        std::lock_guard<std::mutex> lock(g_controlInboxMutex);
+        batch.swap(g_controlInbox);
     }
-    Scheduler_Stop(hwnd);
-    InputMonitor_Stop();
-    Overlay_DestroyAll(hwnd, false);
-    if (g_hwndSettings)
+    TRACE_SCOPE(TRACE_CAT_CONTROL, "Control_Drain");
+    std::vector<ControlResponse> responses(batch.size());
+    for (size_t i = 0; i < batch.size(); i++)
     {
-        DestroyWindow(g_hwndSettings);
-        g_hwndSettings = nullptr;
+        responses[i].client = batch[i].client;
+        responses[i].id = batch[i].id;
+        Control_Handle(batch[i], responses[i]);
     }
-    Tray_Destroy();
-    PostQuitMessage(0);
+    g_controlServer.Respond(responses);
 }
 
 static LRESULT CALLBACK OverlayWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -830,6 +2227,9 @@ static LRESULT CALLBACK OverlayWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARA
     case WM_PAINT:
         Overlay_Paint(hwnd);
         return 0;
+    case WM_DPICHANGED:
+        Overlay_OnTopologyChanged();
+        return 0;
     default:
         return DefWindowProcW(hwnd, msg, wParam, lParam);
     }
@@ -859,17 +2259,145 @@ static void Settings_UpdateCount(HWND hwndDlg)
     SetWindowTextW(hCount, buf);
 }
 
-static void Settings_LoadToControls(HWND hwndDlg)
+static void Settings_LoadField(HWND hwndDlg, const IntField& field, const AppConfig& cfg)
+{
+    SetEditInt(GetDlgItem(hwndDlg, field.controlId), cfg.*field.member);
+    if (field.buddyControlId)
+    {
+        HWND hBuddy = GetDlgItem(hwndDlg, field.buddyControlId);
+        SendMessageW(hBuddy, TBM_SETRANGE, TRUE, MAKELPARAM(field.minValue, field.maxValue));
+        SendMessageW(hBuddy, TBM_SETPOS, TRUE, cfg.*field.member);
+    }
+}
+
+static void Settings_LoadField(HWND hwndDlg, const BoolField& field, const AppConfig& cfg)
+{
+    SendMessageW(GetDlgItem(hwndDlg, field.controlId), BM_SETCHECK, cfg.*field.member ? BST_CHECKED : BST_UNCHECKED, 0);
+}
+
+static void Settings_LoadField(HWND hwndDlg, const ColorField& field, const AppConfig& cfg)
+{
+    SetWindowTextW(GetDlgItem(hwndDlg, field.controlId), ColorToHex(cfg.*field.member).c_str());
+}
+
+static void Settings_LoadField(HWND hwndDlg, const TextField& field, const AppConfig& cfg)
+{
+    SetWindowTextW(GetDlgItem(hwndDlg, field.controlId), (cfg.*field.member).c_str());
+}
+
+static void Settings_LoadField(HWND hwndDlg, const ChoiceField& field, const AppConfig& cfg)
+{
+    HWND hCombo = GetDlgItem(hwndDlg, field.controlId);
+    SendMessageW(hCombo, CB_RESETCONTENT, 0, 0);
+    for (int i = 0; i < field.count; i++)
+    {
+        SendMessageW(hCombo, CB_ADDSTRING, 0, (LPARAM)field.labels[i]);
+    }
+    SendMessageW(hCombo, CB_SETCURSEL, cfg.*field.member, 0);
+}
+
+// 遮罩区域只在 ini 中编辑，设置窗口保留原值
+static void Settings_LoadField(HWND, const RegionField&, const AppConfig&) {}
+// 动画文件同样只在 ini 中配置
+static void Settings_LoadField(HWND, const PathField&, const AppConfig&) {}
+
+static bool Settings_ReadField(HWND hwndDlg, const IntField& field, AppConfig& candidate, std::wstring& error)
+{
+    const int value = GetEditInt(GetDlgItem(hwndDlg, field.controlId));
+    if (!Config_InRange(field, value))
+    {
+        error = field.rangeError;
+        return false;
+    }
+    candidate.*field.member = value;
+    return true;
+}
+
+static bool Settings_ReadField(HWND hwndDlg, const BoolField& field, AppConfig& candidate, std::wstring&)
+{
+    candidate.*field.member = SendMessageW(GetDlgItem(hwndDlg, field.controlId), BM_GETCHECK, 0, 0) == BST_CHECKED;
+    return true;
+}
+
+static bool Settings_ReadField(HWND hwndDlg, const ColorField& field, AppConfig& candidate, std::wstring& error)
+{
+    wchar_t colorBuf[32]{};
+    GetWindowTextW(GetDlgItem(hwndDlg, field.controlId), colorBuf, (int)std::size(colorBuf));
+    ColorRef color{};
+    if (!TryParseHexColor(colorBuf, color))
+    {
+        error = field.formatError;
+        return false;
+    }
+    candidate.*field.member = color;
+    return true;
+}
+
+static bool Settings_ReadField(HWND hwndDlg, const TextField& field, AppConfig& candidate, std::wstring&)
+{
+    HWND hText = GetDlgItem(hwndDlg, field.controlId);
+    const int textLen = GetWindowTextLengthW(hText);
+    std::wstring text;
+    text.resize((size_t)textLen);
+    GetWindowTextW(hText, text.data(), textLen + 1);
+    if (text.size() > (size_t)field.maxLength)
+    {
+        text.resize((size_t)field.maxLength);
+    }
+    candidate.*field.member = std::move(text);
+    return true;
+}
+
+static bool Settings_ReadField(HWND hwndDlg, const ChoiceField& field, AppConfig& candidate, std::wstring&)
+{
+    const int sel = (int)SendMessageW(GetDlgItem(hwndDlg, field.controlId), CB_GETCURSEL, 0, 0);
+    candidate.*field.member = sel >= 0 && sel < field.count ? sel : field.defaultValue;
+    return true;
+}
+
+static bool Settings_ReadField(HWND, const RegionField&, AppConfig&, std::wstring&)
 {
-    SetEditInt(GetDlgItem(hwndDlg, IDC_INTERVAL_EDIT), g_config.intervalMinutes);
-    SetEditInt(GetDlgItem(hwndDlg, IDC_FADE_EDIT), g_config.fadeSeconds);
-    SetEditInt(GetDlgItem(hwndDlg, IDC_OPACITY_EDIT), g_config.opacityPercent);
-    SendMessageW(GetDlgItem(hwndDlg, IDC_OPACITY_TRACK), TBM_SETRANGE, TRUE, MAKELPARAM(0, 100));
-    SendMessageW(GetDlgItem(hwndDlg, IDC_OPACITY_TRACK), TBM_SETPOS, TRUE, g_config.opacityPercent);
+    return true;
+}
+
+static bool Settings_ReadField(HWND, const PathField&, AppConfig&, std::wstring&)
+{
+    return true;
+}
+
+static void Settings_LockField(HWND hwndDlg, const IntField& field, bool locked)
+{
+    EnableWindow(GetDlgItem(hwndDlg, field.controlId), !locked);
+    if (field.buddyControlId)
+    {
+        EnableWindow(GetDlgItem(hwndDlg, field.buddyControlId), !locked);
+    }
+}
+
+static void Settings_LockField(HWND hwndDlg, const ColorField& field, bool locked)
+{
+    EnableWindow(GetDlgItem(hwndDlg, field.controlId), !locked);
+    EnableWindow(GetDlgItem(hwndDlg, IDC_COLOR_PICK), !locked);
+}
+
+static void Settings_LockField(HWND, const RegionField&, bool) {}
+static void Settings_LockField(HWND, const PathField&, bool) {}
+
+template <typename Field>
+static void Settings_LockField(HWND hwndDlg, const Field& field, bool locked)
+{
+    EnableWindow(GetDlgItem(hwndDlg, field.controlId), !locked);
+}
 
-    SetWindowTextW(GetDlgItem(hwndDlg, IDC_COLOR_EDIT), ColorToHex(g_config.bgColor).c_str());
-    SetWindowTextW(GetDlgItem(hwndDlg, IDC_TEXT_EDIT), g_config.text.c_str());
-    SendMessageW(GetDlgItem(hwndDlg, IDC_AUTOSTART_CHECK), BM_SETCHECK, g_config.autoStart ? BST_CHECKED : BST_UNCHECKED, 0);
+static void Settings_LoadToControls(HWND hwndDlg)
+{
+    Config_ForEachField([&](const auto& field) { Settings_LoadField(hwndDlg, field, g_config); });
+    // 被管理员策略锁定的项只读
+    int index = 0;
+    Config_ForEachField([&](const auto& field)
+    {
+        Settings_LockField(hwndDlg, field, (g_configLayers.Locked() & Config_FieldBit(index++)) != 0);
+    });
     Settings_UpdateCount(hwndDlg);
 }
 
@@ -891,7 +2419,7 @@ static bool Settings_SaveFromControls(HWND hwndDlg, std::wstring& error)
     g_config = candidate;
     SaveConfig(g_config);
 
-    Scheduler_Start(g_hwndMain);
+    g_engine.OnConfigSaved(Engine_Now(), g_config);
     return true;
 }
 
@@ -899,50 +2427,193 @@ static bool Settings_TryBuildCandidateFromControls(HWND hwndDlg, AppConfig& cand
 {
     candidate = g_config;
 
-    candidate.intervalMinutes = GetEditInt(GetDlgItem(hwndDlg, IDC_INTERVAL_EDIT));
-    candidate.fadeSeconds = GetEditInt(GetDlgItem(hwndDlg, IDC_FADE_EDIT));
-    candidate.opacityPercent = GetEditInt(GetDlgItem(hwndDlg, IDC_OPACITY_EDIT));
-
-    if (candidate.intervalMinutes < 1)
+    const bool ok = Config_AllFields([&](const auto& field)
+    {
+        return Settings_ReadField(hwndDlg, field, candidate, error);
+    });
+    if (!ok)
     {
-        error = L"间隔（分钟）最小为 1。";
         return false;
     }
-    if (candidate.fadeSeconds < 1)
+
+    if (!Config_CheckPolicy(g_configLayers.Policy(), candidate, error))
     {
-        error = L"淡入/淡出（秒）最小为 1。";
         return false;
     }
-    if (candidate.opacityPercent < 0 || candidate.opacityPercent > 100)
+
+    Config_Normalize(candidate);
+    return true;
+}
+
+// 设置窗口缩略预览的 GDI 后端：与 Overlay_RenderFrame 同一套排版与绘制，只是 DPI 按缩略比例缩小
+class GdiPreviewPainter final : public PreviewPainter
+{
+public:
+    ~GdiPreviewPainter() override
     {
-        error = L"透明度必须在 0-100 之间。";
-        return false;
+        Release();
     }
 
-    wchar_t colorBuf[32]{};
-    GetWindowTextW(GetDlgItem(hwndDlg, IDC_COLOR_EDIT), colorBuf, (int)std::size(colorBuf));
-    COLORREF color{};
-    if (!TryParseHexColor(colorBuf, color))
+    PixelBuffer Allocate(int width, int height) override
     {
-        error = L"背景颜色格式不正确，请输入类似 #008040 的 HEX。";
-        return false;
+        Release();
+        PixelBuffer buf;
+        m_dc = CreateCompatibleDC(nullptr);
+        if (!m_dc || width <= 0 || height <= 0)
+        {
+            return buf;
+        }
+        const BITMAPINFO bmi = Overlay_DibInfo(width, height);
+        void* bits = nullptr;
+        m_dib = CreateDIBSection(m_dc, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+        if (!m_dib || !bits)
+        {
+            return buf;
+        }
+        m_oldBmp = SelectObject(m_dc, m_dib);
+        buf.pixels = static_cast<std::uint32_t*>(bits);
+        buf.width = width;
+        buf.height = height;
+        buf.stride = width;
+        return buf;
     }
-    candidate.bgColor = color;
 
-    const int textLen = GetWindowTextLengthW(GetDlgItem(hwndDlg, IDC_TEXT_EDIT));
-    std::wstring text;
-    text.resize((size_t)textLen);
-    GetWindowTextW(GetDlgItem(hwndDlg, IDC_TEXT_EDIT), text.data(), textLen + 1);
-    if (text.size() > TEXT_MAX_LEN)
+    void Layout(int width, int height, int dpi, const AppConfig& cfg) override
     {
-        text.resize(TEXT_MAX_LEN);
+        Overlay_FreeLayout(m_layout);
+        // 占位符按排版时的取值显示，之后每秒只重画时间
+        if (cfg.text != m_text.Source())
+        {
+            m_text.Compile(cfg.text);
+        }
+        m_text.Update(Overlay_TextInputs(UnixSecondNow()));
+        Overlay_Layout(m_dc, width, height, dpi, m_text, m_lines, OverlayAnim{}, m_layout);
+    }
+
+    void DrawBase(PixelBuffer& buf, const AppConfig& cfg) override
+    {
+        Overlay_DrawBase(m_dc, buf.width, buf.height, cfg, m_text, OverlayAnim{}, m_layout);
+        Overlay_DrawDynamicText(m_dc, m_text, OverlayAnim{}, m_layout);
     }
-    candidate.text = std::move(text);
 
-    candidate.autoStart = SendMessageW(GetDlgItem(hwndDlg, IDC_AUTOSTART_CHECK), BM_GETCHECK, 0, 0) == BST_CHECKED;
+    ScreenRect DrawClock(PixelBuffer&, const AppConfig& cfg, std::int64_t unixSecond) override
+    {
+        Overlay_DrawClock(m_dc, cfg, m_layout, LocalTimeFromUnixSecond(unixSecond));
+        const RECT& rc = m_layout.rcTime;
+        return ScreenRect{ (int)rc.left, (int)rc.top, (int)rc.right, (int)rc.bottom };
+    }
 
-    NormalizeConfig(candidate);
-    return true;
+    void Flush() override
+    {
+        GdiFlush();
+    }
+
+private:
+    void Release()
+    {
+        Overlay_FreeLayout(m_layout);
+        if (m_dc && m_oldBmp)
+        {
+            SelectObject(m_dc, m_oldBmp);
+        }
+        if (m_dib) DeleteObject(m_dib);
+        if (m_dc) DeleteDC(m_dc);
+        m_dc = nullptr;
+        m_dib = nullptr;
+        m_oldBmp = nullptr;
+    }
+
+    HDC m_dc = nullptr;
+    HBITMAP m_dib = nullptr;
+    HGDIOBJ m_oldBmp = nullptr;
+    OverlayLayout m_layout;
+    TextTemplate m_text;
+    TextLineLayout m_lines;
+};
+
+static GdiPreviewPainter g_previewPainter;
+static SettingsPreview g_settingsPreview(g_previewPainter);
+static PreviewDebouncer g_previewDebounce(PREVIEW_DEBOUNCE_MS);
+// 预览用的候选配置：某个字段暂时不合法（例如颜色只输入了一半）时沿用上一次的值
+static AppConfig g_previewConfig{};
+
+// 缩略图宽度固定，高度与等效 DPI 按主显示器的比例换算
+static void Settings_PreviewResize(HWND hwndDlg)
+{
+    HWND hThumb = GetDlgItem(hwndDlg, IDC_PREVIEW_THUMB);
+    if (!hThumb)
+    {
+        return;
+    }
+    HMONITOR monitor = MonitorFromWindow(hwndDlg, MONITOR_DEFAULTTOPRIMARY);
+    MONITORINFO mi{};
+    mi.cbSize = sizeof(mi);
+    UINT dpiX = 96;
+    UINT dpiY = 96;
+    if (!GetMonitorInfoW(monitor, &mi) || FAILED(GetDpiForMonitor(monitor, MDT_EFFECTIVE_DPI, &dpiX, &dpiY)))
+    {
+        dpiX = 96;
+    }
+    const int monitorW = std::max(1, (int)(mi.rcMonitor.right - mi.rcMonitor.left));
+    const int monitorH = std::max(1, (int)(mi.rcMonitor.bottom - mi.rcMonitor.top));
+
+    RECT rc{};
+    GetClientRect(hThumb, &rc);
+    const int width = std::max(1, (int)rc.right);
+    const int height = std::max(1, MulDiv(width, monitorH, monitorW));
+    if (rc.bottom != height)
+    {
+        SetWindowPos(hThumb, nullptr, 0, 0, width, height, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+    }
+    g_settingsPreview.Resize(width, height, std::max(1, MulDiv((int)dpiX, width, monitorW)));
+}
+
+static void Settings_PreviewRefresh(HWND hwndDlg)
+{
+    std::wstring ignored;
+    Settings_ReadField(hwndDlg, kFieldBgColor, g_previewConfig, ignored);
+    Settings_ReadField(hwndDlg, kFieldOpacity, g_previewConfig, ignored);
+    Settings_ReadField(hwndDlg, kFieldText, g_previewConfig, ignored);
+    g_settingsPreview.SetCandidate(g_previewConfig);
+    g_settingsPreview.SetSecond(UnixSecondNow());
+
+    const ScreenRect changed = g_settingsPreview.Update();
+    if (changed.Width() > 0 && changed.Height() > 0)
+    {
+        RECT rc{ changed.left, changed.top, changed.right, changed.bottom };
+        InvalidateRect(GetDlgItem(hwndDlg, IDC_PREVIEW_THUMB), &rc, FALSE);
+    }
+}
+
+static void Settings_PreviewReset(HWND hwndDlg)
+{
+    KillTimer(hwndDlg, TIMER_PREVIEW_DEBOUNCE);
+    g_previewDebounce.Clear();
+    g_previewConfig = g_config;
+    Settings_PreviewResize(hwndDlg);
+    Settings_PreviewRefresh(hwndDlg);
+}
+
+// 文字输入合并后再渲染；定时器只在第一次未处理的改动时设置，连续输入不会推迟它
+static void Settings_PreviewTextChanged(HWND hwndDlg)
+{
+    if (!g_previewDebounce.Pending())
+    {
+        SetTimer(hwndDlg, TIMER_PREVIEW_DEBOUNCE, PREVIEW_DEBOUNCE_MS, nullptr);
+    }
+    g_previewDebounce.Touch(GetTickCount64());
+}
+
+static void Settings_PreviewDraw(const DRAWITEMSTRUCT& dis)
+{
+    const PixelBuffer& out = g_settingsPreview.Output();
+    if (!out.pixels)
+    {
+        return;
+    }
+    // 整幅交给 GDI，实际只回填 Settings_PreviewRefresh 失效的区域（剪裁区）
+    const BITMAPINFO bmi = Overlay_DibInfo(out.width, out.height);
+    SetDIBitsToDevice(dis.hDC, 0, 0, (DWORD)out.width, (DWORD)out.height, 0, 0, 0, (UINT)out.height, out.pixels, &bmi, DIB_RGB_COLORS);
 }
 
 static LRESULT CALLBACK SettingsWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -970,37 +2641,83 @@ static LRESULT CALLBACK SettingsWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
         const int dpi = GetDpiForWindow(hwnd);
         auto D = [dpi](int x) { return MulDiv(x, dpi, 96); };
 
-        CreateWindowExW(0, L"STATIC", L"间隔（分钟）", WS_CHILD | WS_VISIBLE, D(14), D(14), D(130), D(22), hwnd, nullptr, g_hInstance, nullptr);
+        CreateWindowExW(0, L"STATIC", kFieldInterval.label, WS_CHILD | WS_VISIBLE, D(14), D(14), D(130), D(22), hwnd, nullptr, g_hInstance, nullptr);
         HWND hInterval = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE | ES_NUMBER, D(150), D(12), D(120), D(26), hwnd, (HMENU)IDC_INTERVAL_EDIT, g_hInstance, nullptr);
-        SendMessageW(hInterval, EM_SETLIMITTEXT, 4, 0);
+        SendMessageW(hInterval, EM_SETLIMITTEXT, Config_DigitCount(kFieldInterval.maxValue), 0);
 
-        CreateWindowExW(0, L"STATIC", L"背景颜色（HEX）", WS_CHILD | WS_VISIBLE, D(14), D(48), D(130), D(22), hwnd, nullptr, g_hInstance, nullptr);
+        CreateWindowExW(0, L"STATIC", kFieldBgColor.label, WS_CHILD | WS_VISIBLE, D(14), D(48), D(130), D(22), hwnd, nullptr, g_hInstance, nullptr);
         CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE, D(150), D(46), D(120), D(26), hwnd, (HMENU)IDC_COLOR_EDIT, g_hInstance, nullptr);
         CreateWindowExW(0, L"BUTTON", L"选择", WS_CHILD | WS_VISIBLE, D(280), D(46), D(70), D(26), hwnd, (HMENU)IDC_COLOR_PICK, g_hInstance, nullptr);
 
-        CreateWindowExW(0, L"STATIC", L"透明度（0-100）", WS_CHILD | WS_VISIBLE, D(14), D(82), D(130), D(22), hwnd, nullptr, g_hInstance, nullptr);
+        CreateWindowExW(0, L"STATIC", kFieldOpacity.label, WS_CHILD | WS_VISIBLE, D(14), D(82), D(130), D(22), hwnd, nullptr, g_hInstance, nullptr);
         HWND hTrack = CreateWindowExW(0, TRACKBAR_CLASSW, L"", WS_CHILD | WS_VISIBLE | TBS_AUTOTICKS, D(150), D(78), D(180), D(30), hwnd, (HMENU)IDC_OPACITY_TRACK, g_hInstance, nullptr);
         CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE | ES_NUMBER, D(340), D(78), D(60), D(26), hwnd, (HMENU)IDC_OPACITY_EDIT, g_hInstance, nullptr);
-        SendMessageW(GetDlgItem(hwnd, IDC_OPACITY_EDIT), EM_SETLIMITTEXT, 3, 0);
+        SendMessageW(GetDlgItem(hwnd, IDC_OPACITY_EDIT), EM_SETLIMITTEXT, Config_DigitCount(kFieldOpacity.maxValue), 0);
 
-        CreateWindowExW(0, L"STATIC", L"淡入/淡出（秒）", WS_CHILD | WS_VISIBLE, D(14), D(116), D(130), D(22), hwnd, nullptr, g_hInstance, nullptr);
+        CreateWindowExW(0, L"STATIC", kFieldFade.label, WS_CHILD | WS_VISIBLE, D(14), D(116), D(130), D(22), hwnd, nullptr, g_hInstance, nullptr);
         HWND hFade = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE | ES_NUMBER, D(150), D(114), D(120), D(26), hwnd, (HMENU)IDC_FADE_EDIT, g_hInstance, nullptr);
-        SendMessageW(hFade, EM_SETLIMITTEXT, 3, 0);
+        SendMessageW(hFade, EM_SETLIMITTEXT, Config_DigitCount(kFieldFade.maxValue), 0);
+
+        CreateWindowExW(0, L"STATIC", kFieldFullscreen.label, WS_CHILD | WS_VISIBLE, D(14), D(150), D(130), D(22), hwnd, nullptr, g_hInstance, nullptr);
+        CreateWindowExW(0, L"COMBOBOX", L"", WS_CHILD | WS_VISIBLE | WS_VSCROLL | CBS_DROPDOWNLIST, D(150), D(148), D(200), D(200), hwnd, (HMENU)IDC_FULLSCREEN_COMBO, g_hInstance, nullptr);
 
-        CreateWindowExW(0, L"STATIC", L"显示文字（可选，最多500字）", WS_CHILD | WS_VISIBLE, D(14), D(152), D(250), D(22), hwnd, nullptr, g_hInstance, nullptr);
+        CreateWindowExW(0, L"STATIC", kFieldText.label, WS_CHILD | WS_VISIBLE, D(14), D(186), D(250), D(22), hwnd, nullptr, g_hInstance, nullptr);
         HWND hText = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE | ES_MULTILINE | ES_AUTOVSCROLL | WS_VSCROLL,
-            D(14), D(176), D(386), D(140), hwnd, (HMENU)IDC_TEXT_EDIT, g_hInstance, nullptr);
-        SendMessageW(hText, EM_SETLIMITTEXT, TEXT_MAX_LEN, 0);
+            D(14), D(210), D(386), D(140), hwnd, (HMENU)IDC_TEXT_EDIT, g_hInstance, nullptr);
+        SendMessageW(hText, EM_SETLIMITTEXT, kFieldText.maxLength, 0);
 
-        CreateWindowExW(0, L"STATIC", L"0/500", WS_CHILD | WS_VISIBLE | SS_RIGHT, D(300), D(322), D(100), D(22), hwnd, (HMENU)IDC_TEXT_COUNT, g_hInstance, nullptr);
+        CreateWindowExW(0, L"STATIC", L"0/500", WS_CHILD | WS_VISIBLE | SS_RIGHT, D(300), D(356), D(100), D(22), hwnd, (HMENU)IDC_TEXT_COUNT, g_hInstance, nullptr);
 
-        CreateWindowExW(0, L"BUTTON", L"开机自启", WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX, D(14), D(350), D(130), D(30), hwnd, (HMENU)IDC_AUTOSTART_CHECK, g_hInstance, nullptr);
-        CreateWindowExW(0, L"BUTTON", L"预览", WS_CHILD | WS_VISIBLE, D(170), D(350), D(110), D(30), hwnd, (HMENU)IDC_PREVIEW, g_hInstance, nullptr);
-        CreateWindowExW(0, L"BUTTON", L"保存", WS_CHILD | WS_VISIBLE, D(290), D(350), D(110), D(30), hwnd, (HMENU)IDC_SAVE, g_hInstance, nullptr);
+        CreateWindowExW(0, L"BUTTON", kFieldAutoStart.label, WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX, D(14), D(384), D(130), D(30), hwnd, (HMENU)IDC_AUTOSTART_CHECK, g_hInstance, nullptr);
+        CreateWindowExW(0, L"BUTTON", L"预览", WS_CHILD | WS_VISIBLE, D(170), D(384), D(110), D(30), hwnd, (HMENU)IDC_PREVIEW, g_hInstance, nullptr);
+        CreateWindowExW(0, L"BUTTON", L"保存", WS_CHILD | WS_VISIBLE, D(290), D(384), D(110), D(30), hwnd, (HMENU)IDC_SAVE, g_hInstance, nullptr);
+
+        // 高度由 Settings_PreviewResize 按显示器比例修正
+        CreateWindowExW(0, L"STATIC", L"", WS_CHILD | WS_VISIBLE | SS_OWNERDRAW, D(14), D(426), D(386), D(217), hwnd, (HMENU)IDC_PREVIEW_THUMB, g_hInstance, nullptr);
 
         Settings_LoadToControls(hwnd);
+        Settings_PreviewReset(hwnd);
         return 0;
     }
+    case WM_DRAWITEM:
+        if (wParam == IDC_PREVIEW_THUMB)
+        {
+            Settings_PreviewDraw(*reinterpret_cast<const DRAWITEMSTRUCT*>(lParam));
+            return TRUE;
+        }
+        return FALSE;
+    case WM_SHOWWINDOW:
+        // 隐藏时不再每秒刷新预览里的时间
+        if (wParam)
+        {
+            SetTimer(hwnd, TIMER_PREVIEW_CLOCK, 1000, nullptr);
+        }
+        else
+        {
+            KillTimer(hwnd, TIMER_PREVIEW_CLOCK);
+        }
+        return DefWindowProcW(hwnd, msg, wParam, lParam);
+    case WM_TIMER:
+        if (wParam == TIMER_PREVIEW_DEBOUNCE)
+        {
+            KillTimer(hwnd, TIMER_PREVIEW_DEBOUNCE);
+            g_previewDebounce.Clear();
+            Settings_PreviewRefresh(hwnd);
+            return 0;
+        }
+        if (wParam == TIMER_PREVIEW_CLOCK)
+        {
+            // 文字还在合并中时只动时间区域，候选配置等合并结束再取
+            g_settingsPreview.SetSecond(UnixSecondNow());
+            const ScreenRect changed = g_settingsPreview.Update();
+            if (changed.Width() > 0 && changed.Height() > 0)
+            {
+                RECT rc{ changed.left, changed.top, changed.right, changed.bottom };
+                InvalidateRect(GetDlgItem(hwnd, IDC_PREVIEW_THUMB), &rc, FALSE);
+            }
+            return 0;
+        }
+        return 0;
     case WM_COMMAND:
     {
         const int id = LOWORD(wParam);
@@ -1026,6 +2743,13 @@ static LRESULT CALLBACK SettingsWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
         if (id == IDC_TEXT_EDIT && code == EN_CHANGE)
         {
             Settings_UpdateCount(hwnd);
+            Settings_PreviewTextChanged(hwnd);
+            return 0;
+        }
+
+        if (id == IDC_COLOR_EDIT && code == EN_CHANGE)
+        {
+            Settings_PreviewRefresh(hwnd);
             return 0;
         }
 
@@ -1038,10 +2762,9 @@ static LRESULT CALLBACK SettingsWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
 
         if (id == IDC_OPACITY_EDIT && code == EN_CHANGE)
         {
-            int val = GetEditInt(GetDlgItem(hwnd, IDC_OPACITY_EDIT));
-            if (val < 0) val = 0;
-            if (val > 100) val = 100;
+            const int val = Config_Clamp(kFieldOpacity, GetEditInt(GetDlgItem(hwnd, IDC_OPACITY_EDIT)));
             SendMessageW(GetDlgItem(hwnd, IDC_OPACITY_TRACK), TBM_SETPOS, TRUE, val);
+            Settings_PreviewRefresh(hwnd);
             return 0;
         }
 
@@ -1073,8 +2796,7 @@ static LRESULT CALLBACK SettingsWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
                 return 0;
             }
 
-            Scheduler_Stop(g_hwndMain);
-            Overlay_ShowWithConfig(g_hwndMain, candidate);
+            g_engine.OnPreview(Engine_Now(), candidate);
             return 0;
         }
 
@@ -1092,6 +2814,7 @@ static void Settings_Show(HWND hwndOwner)
 {
     if (!g_hwndSettings)
     {
+        Settings_EnsureClass();
         const DWORD style = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU;
         g_hwndSettings = CreateWindowExW(
             WS_EX_APPWINDOW,
@@ -1099,7 +2822,7 @@ static void Settings_Show(HWND hwndOwner)
             L"屏保提醒工具 - 设置",
             style,
             CW_USEDEFAULT, CW_USEDEFAULT,
-            440, 430,
+            440, 694,
             hwndOwner, nullptr, g_hInstance, nullptr
         );
     }
@@ -1110,6 +2833,7 @@ static void Settings_Show(HWND hwndOwner)
     }
 
     Settings_LoadToControls(g_hwndSettings);
+    Settings_PreviewReset(g_hwndSettings);
     ShowWindow(g_hwndSettings, SW_SHOW);
     SetForegroundWindow(g_hwndSettings);
 }
@@ -1119,30 +2843,62 @@ static LRESULT CALLBACK MainWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM l
     switch (msg)
     {
     case WM_CREATE:
+        // 引擎在这里启动并设置计时器，CreateWindowExW 返回前就要用到主窗口句柄
+        g_hwndMain = hwnd;
         LoadConfig(g_config);
+        g_startup.Mark("config_load");
+        g_breakLog.Start(GetBreakLogPath());
+        BreakLog_StartDayCount();
         Tray_Create(hwnd);
-        Scheduler_Start(hwnd);
+        g_startup.Mark("tray");
+        ForegroundMonitor_Start();
+        Presence_Start(hwnd);
+        g_startup.Mark("monitors");
+        Scheduler_Resume();
+        g_startup.Mark("scheduler");
+        g_controlServer.Start(ControlServer::DefaultEndpoint(), Control_OnBatch);
+        g_startup.Mark("control_server");
         return 0;
     case WM_TIMER:
         if (wParam == TIMER_INTERVAL)
         {
-            Scheduler_Stop(hwnd);
-            Overlay_Show(hwnd);
+            Trace_Instant(TRACE_CAT_SCHEDULER, "TIMER_INTERVAL");
+            g_engine.OnTimer(EngineTimer::Interval, Engine_Now());
             return 0;
         }
         if (wParam == TIMER_OVERLAY_ANIM)
         {
-            Overlay_TickAnim(hwnd);
+            TRACE_SCOPE(TRACE_CAT_OVERLAY, "Overlay_TickAnim");
+            g_engine.OnTimer(EngineTimer::Anim, Engine_Now());
             return 0;
         }
-        if (wParam == TIMER_OVERLAY_CLOCK)
+        if (wParam == TIMER_OVERLAY_FRAME)
         {
-            if (Overlay_IsVisible())
+            TRACE_SCOPE(TRACE_CAT_OVERLAY, "Overlay_TickFrame");
+            Overlay_OnFrameTimer();
+            return 0;
+        }
+        if (wParam == TIMER_OVERLAY_WARMUP)
+        {
+            KillTimer(hwnd, TIMER_OVERLAY_WARMUP);
+            Overlay_EnsureReady();
+            if (!Overlay_IsVisible() && g_schedulerDeadline != std::chrono::steady_clock::time_point{})
             {
-                Overlay_InvalidateAll();
+                Overlay_SchedulePrerender(g_schedulerDeadline);
             }
             return 0;
         }
+        if (wParam == TIMER_TOPOLOGY)
+        {
+            g_engine.OnDisplayChange(Engine_Now());
+            return 0;
+        }
+        if (wParam == TIMER_OVERLAY_CLOCK)
+        {
+            Trace_Instant(TRACE_CAT_OVERLAY, "TIMER_OVERLAY_CLOCK");
+            g_engine.OnTimer(EngineTimer::Clock, Engine_Now());
+            return 0;
+        }
         return 0;
     case WMAPP_TRAY:
     {
@@ -1159,10 +2915,11 @@ static LRESULT CALLBACK MainWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM l
         return 0;
     }
     case WMAPP_ACTIVITY:
-        if (g_overlayState.load() == OverlayState::WaitingInput)
-        {
-            Overlay_BeginFadeOut(hwnd);
-        }
+        Trace_Instant(TRACE_CAT_INPUT, "WMAPP_ACTIVITY", (int)g_overlayState.load());
+        g_engine.OnActivity(Engine_Now());
+        return 0;
+    case WMAPP_CONTROL:
+        Control_Drain();
         return 0;
     case WM_COMMAND:
     {
@@ -1174,15 +2931,37 @@ static LRESULT CALLBACK MainWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM l
         }
         if (id == IDM_TRAY_EXIT)
         {
-            App_Exit(hwnd);
+            App_Exit();
             return 0;
         }
         return 0;
     }
+    case WM_DISPLAYCHANGE:
+        Overlay_OnTopologyChanged();
+        return 0;
+    case WM_WTSSESSION_CHANGE:
+        Presence_OnSessionChange(wParam);
+        return 0;
+    case WM_POWERBROADCAST:
+        if (wParam == PBT_POWERSETTINGCHANGE)
+        {
+            Presence_OnPowerSetting(reinterpret_cast<const POWERBROADCAST_SETTING*>(lParam));
+            return TRUE;
+        }
+        return DefWindowProcW(hwnd, msg, wParam, lParam);
+    case WM_SETTINGCHANGE:
+        if (wParam == SPI_SETWORKAREA)
+        {
+            Overlay_OnTopologyChanged();
+        }
+        return DefWindowProcW(hwnd, msg, wParam, lParam);
     case WM_DESTROY:
         Tray_Destroy();
         Scheduler_Stop(hwnd);
+        Overlay_StopAnim();
         InputMonitor_Stop();
+        ForegroundMonitor_Stop();
+        Presence_Stop(hwnd);
         return 0;
     default:
         return DefWindowProcW(hwnd, msg, wParam, lParam);
@@ -1203,10 +2982,28 @@ static ATOM RegisterWindowClass(const wchar_t* name, WNDPROC proc, HICON icon, H
     return RegisterClassExW(&wc);
 }
 
-int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int)
+static void Overlay_EnsureReady()
 {
-    g_hInstance = hInstance;
-    CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    if (g_overlayReady)
+    {
+        return;
+    }
+    TRACE_SCOPE(TRACE_CAT_OVERLAY, "Overlay_EnsureReady");
+    g_overlayReady = true;
+    RegisterWindowClass(L"SSR_OVERLAY", OverlayWndProc, LoadIconW(g_hInstance, MAKEINTRESOURCEW(IDI_FAVICON)), (HBRUSH)GetStockObject(NULL_BRUSH));
+    g_overlayPool.Prepare();
+    g_prerender.Start();
+}
+
+// 通用控件只有设置窗口用到（滑块等），第一次打开设置时才初始化
+static void Settings_EnsureClass()
+{
+    static bool registered = false;
+    if (registered)
+    {
+        return;
+    }
+    registered = true;
 
     INITCOMMONCONTROLSEX icc{};
     icc.dwSize = sizeof(icc);
@@ -1214,11 +3011,107 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int)
     InitCommonControlsEx(&icc);
 
     g_settingsBgBrush = CreateSolidBrush(RGB(250, 250, 250));
+    RegisterWindowClass(L"SSR_SETTINGS", SettingsWndProc, LoadIconW(g_hInstance, MAKEINTRESOURCEW(IDI_FAVICON)),
+        g_settingsBgBrush ? g_settingsBgBrush : (HBRUSH)GetStockObject(WHITE_BRUSH));
+}
+
+static bool App_TraceRequested(PWSTR cmdLine)
+{
+    if (cmdLine && wcsstr(cmdLine, L"--trace"))
+    {
+        return true;
+    }
+    wchar_t value[8]{};
+    const DWORD len = GetEnvironmentVariableW(L"SSR_TRACE", value, (DWORD)std::size(value));
+    return len > 0 && len < std::size(value) && value[0] != L'0';
+}
+
+static bool App_RecordRequested(PWSTR cmdLine)
+{
+    return cmdLine && wcsstr(cmdLine, L"--record");
+}
+
+// 远程会话默认开启；本地也可用 --footprint 打开
+static bool App_FootprintRequested(PWSTR cmdLine)
+{
+    return (cmdLine && wcsstr(cmdLine, L"--footprint")) || GetSystemMetrics(SM_REMOTESESSION) != 0;
+}
+
+static void App_WriteSessionLog()
+{
+    if (g_engineRecorder)
+    {
+        g_engineRecorder->WriteFile(std::filesystem::path(GetAppDataFolder()) / L"session.ssrlog");
+    }
+}
+
+// 第一个实例自己带的动词在窗口创建后直接执行，不经过控制端点
+static void App_ApplyVerb(const InstanceVerb& verb)
+{
+    switch (verb.op)
+    {
+    case ControlOp::OpenSettings:
+        Settings_Show(g_hwndMain);
+        break;
+    case ControlOp::TriggerNow:
+        g_engine.OnTriggerNow(Engine_Now());
+        break;
+    case ControlOp::Snooze:
+        g_engine.OnSnooze(Engine_Now(), verb.snoozeMinutes);
+        Scheduler_OnSnoozed();
+        break;
+    default:
+        break;
+    }
+}
+
+static void App_WriteTraceFile()
+{
+    if (Trace_EventCount() == 0)
+    {
+        return;
+    }
+    std::string json;
+    Trace_WriteJson(json, true);
+    WriteFileBytes(GetAppDataFolder() + L"\\trace.json", json);
+}
+
+int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR cmdLine, int)
+{
+    g_startup.Begin();
+    g_hInstance = hInstance;
+
+    InstanceVerb verb;
+    const bool hasVerb = Instance_ParseVerb(cmdLine ? cmdLine : L"", verb);
+    SingleInstance instance;
+    if (!instance.Acquire(SingleInstance::DefaultName()))
+    {
+        // 已有实例在运行：把命令转交给它后直接退出，不创建任何窗口、钩子或托盘图标
+        if (verb.op == ControlOp::OpenSettings)
+        {
+            AllowSetForegroundWindow(ASFW_ANY);
+        }
+        ControlResponse response;
+        Instance_Forward(ControlServer::DefaultEndpoint(), verb, 2000, response);
+        return 0;
+    }
+
+    g_startup.Mark("single_instance");
+
+    Trace_SetEnabled(App_TraceRequested(cmdLine));
+    g_footprintMode = App_FootprintRequested(cmdLine);
+    Trace_SetThreadName("ui");
+    if (App_RecordRequested(cmdLine))
+    {
+        g_engineRecorder = std::make_unique<EngineRecorder>();
+        g_engine.SetRecorder(g_engineRecorder.get());
+    }
+    CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    g_startup.Mark("com_init");
 
     HICON icon = LoadIconW(hInstance, MAKEINTRESOURCEW(IDI_FAVICON));
     RegisterWindowClass(L"SSR_MAIN", MainWndProc, icon, (HBRUSH)GetStockObject(WHITE_BRUSH));
-    RegisterWindowClass(L"SSR_SETTINGS", SettingsWndProc, icon, g_settingsBgBrush ? g_settingsBgBrush : (HBRUSH)GetStockObject(WHITE_BRUSH));
-    RegisterWindowClass(L"SSR_OVERLAY", OverlayWndProc, icon, (HBRUSH)GetStockObject(NULL_BRUSH));
+    g_startup.Mark("window_class");
 
     g_hwndMain = CreateWindowExW(
         0,
@@ -1233,8 +3126,15 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int)
     {
         return 1;
     }
+    g_startup.Mark("main_window");
 
     ShowWindow(g_hwndMain, SW_HIDE);
+    if (hasVerb)
+    {
+        App_ApplyVerb(verb);
+        g_startup.Mark("verb");
+    }
+    g_startup.Finish();
 
     MSG msg{};
     while (GetMessageW(&msg, nullptr, 0, 0) > 0)
@@ -1249,6 +3149,17 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int)
         g_settingsBgBrush = nullptr;
     }
 
+    g_controlServer.Stop();
+    g_prerender.Stop();
+    g_frameCache.Clear();
+    g_assetPack.reset();
+    g_breakLog.Stop();
+    if (g_breaksTodayScan.joinable())
+    {
+        g_breaksTodayScan.join();
+    }
+    App_WriteSessionLog();
+    App_WriteTraceFile();
     CoUninitialize();
     return 0;
 }
@@ -0,0 +1,323 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <aclapi.h>
+#include <sddl.h>
+#include <vector>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::OpenRead(const std::filesystem::path& path)
+{
+    Close();
+
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart < 0 || (unsigned long long)size.QuadPart > (size_t)-1)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    m_file = hFile;
+    if (size.QuadPart == 0)
+    {
+        return true;
+    }
+
+    HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapping)
+    {
+        Close();
+        return false;
+    }
+    m_mapping = hMapping;
+
+    void* view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        Close();
+        return false;
+    }
+
+    m_data = static_cast<const std::uint8_t*>(view);
+    m_size = (size_t)size.QuadPart;
+    return true;
+}
+
+bool MappedFile::OpenReadWrite(const std::filesystem::path& path, size_t size)
+{
+    Close();
+    if (size == 0)
+    {
+        return false;
+    }
+
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    m_file = hFile;
+
+    LARGE_INTEGER current{};
+    if (!GetFileSizeEx(hFile, &current) || current.QuadPart < 0)
+    {
+        Close();
+        return false;
+    }
+    const size_t mapSize = std::max((size_t)current.QuadPart, size);
+
+    // 映射大小超过文件长度时由系统补零扩展
+    HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READWRITE, (DWORD)((unsigned long long)mapSize >> 32), (DWORD)mapSize, nullptr);
+    if (!hMapping)
+    {
+        Close();
+        return false;
+    }
+    m_mapping = hMapping;
+
+    void* view = MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, 0);
+    if (!view)
+    {
+        Close();
+        return false;
+    }
+
+    m_data = static_cast<const std::uint8_t*>(view);
+    m_size = mapSize;
+    m_writable = true;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping)
+    {
+        CloseHandle(m_mapping);
+    }
+    if (m_file)
+    {
+        CloseHandle(m_file);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_writable = false;
+    m_mapping = nullptr;
+    m_file = nullptr;
+}
+
+bool MappedFile::OwnerTrusted() const
+{
+    if (!m_file)
+    {
+        return false;
+    }
+    PSID owner = nullptr;
+    PSECURITY_DESCRIPTOR sd = nullptr;
+    if (GetSecurityInfo(m_file, SE_FILE_OBJECT, OWNER_SECURITY_INFORMATION, &owner, nullptr, nullptr, nullptr, &sd) != ERROR_SUCCESS)
+    {
+        return false;
+    }
+    // 以管理员身份运行时新建文件的所有者是 Administrators 组
+    bool trusted = IsWellKnownSid(owner, WinBuiltinAdministratorsSid) || IsWellKnownSid(owner, WinLocalSystemSid);
+    HANDLE token = nullptr;
+    if (!trusted && OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token))
+    {
+        DWORD len = 0;
+        GetTokenInformation(token, TokenUser, nullptr, 0, &len);
+        std::vector<std::uint8_t> user(len);
+        if (len > 0 && GetTokenInformation(token, TokenUser, user.data(), len, &len))
+        {
+            trusted = EqualSid(owner, reinterpret_cast<TOKEN_USER*>(user.data())->User.Sid) != FALSE;
+        }
+        CloseHandle(token);
+    }
+    LocalFree(sd);
+    return trusted;
+}
+
+bool MappedFile::LockShared()
+{
+    OVERLAPPED ov{};
+    return m_file && LockFileEx(m_file, 0, 0, MAXDWORD, MAXDWORD, &ov);
+}
+
+bool MappedFile::TryLockExclusive()
+{
+    if (!m_file)
+    {
+        return false;
+    }
+    // 同一句柄不能把共享锁升级为独占锁
+    OVERLAPPED ov{};
+    UnlockFileEx(m_file, 0, MAXDWORD, MAXDWORD, &ov);
+    ov = OVERLAPPED{};
+    return LockFileEx(m_file, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, MAXDWORD, MAXDWORD, &ov) != FALSE;
+}
+
+bool MappedFile_RestrictWriteToOwner(const std::filesystem::path& path)
+{
+    // P：不继承目录的权限；OW：所有者，WD：Everyone
+    PSECURITY_DESCRIPTOR sd = nullptr;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(L"D:P(A;;FA;;;OW)(A;;FR;;;WD)", SDDL_REVISION_1, &sd, nullptr))
+    {
+        return false;
+    }
+    BOOL present = FALSE;
+    BOOL defaulted = FALSE;
+    PACL dacl = nullptr;
+    const bool ok = GetSecurityDescriptorDacl(sd, &present, &dacl, &defaulted) &&
+        SetNamedSecurityInfoW(const_cast<wchar_t*>(path.c_str()), SE_FILE_OBJECT, DACL_SECURITY_INFORMATION | PROTECTED_DACL_SECURITY_INFORMATION,
+            nullptr, nullptr, dacl, nullptr) == ERROR_SUCCESS;
+    LocalFree(sd);
+    return ok;
+}
+
+#else
+
+bool MappedFile::OpenRead(const std::filesystem::path& path)
+{
+    Close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size < 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    if (st.st_size == 0)
+    {
+        return true;
+    }
+
+    void* view = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    ::madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    m_data = static_cast<const std::uint8_t*>(view);
+    m_size = (size_t)st.st_size;
+    return true;
+}
+
+bool MappedFile::OpenReadWrite(const std::filesystem::path& path, size_t size)
+{
+    Close();
+    if (size == 0)
+    {
+        return false;
+    }
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        return false;
+    }
+    m_fd = fd;
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size < 0)
+    {
+        Close();
+        return false;
+    }
+    if ((size_t)st.st_size < size && ::ftruncate(fd, (off_t)size) != 0)
+    {
+        Close();
+        return false;
+    }
+    const size_t mapSize = std::max((size_t)st.st_size, size);
+
+    void* view = ::mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+
+    m_data = static_cast<const std::uint8_t*>(view);
+    m_size = mapSize;
+    m_writable = true;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data)
+    {
+        ::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+    }
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_writable = false;
+    m_fd = -1;
+}
+
+bool MappedFile::OwnerTrusted() const
+{
+    struct stat st{};
+    if (m_fd < 0 || ::fstat(m_fd, &st) != 0)
+    {
+        return false;
+    }
+    return S_ISREG(st.st_mode) && (st.st_uid == ::geteuid() || st.st_uid == 0) && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+bool MappedFile::LockShared()
+{
+    return m_fd >= 0 && ::flock(m_fd, LOCK_SH) == 0;
+}
+
+bool MappedFile::TryLockExclusive()
+{
+    return m_fd >= 0 && ::flock(m_fd, LOCK_EX | LOCK_NB) == 0;
+}
+
+bool MappedFile_RestrictWriteToOwner(const std::filesystem::path& path)
+{
+    return ::chmod(path.c_str(), 0644) == 0;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// 内存映射文件。只读打开时空文件视为打开成功但 size() == 0；
+// 读写打开时文件不存在则创建，不足 size 字节则补零到 size
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool OpenRead(const std::filesystem::path& path);
+    bool OpenReadWrite(const std::filesystem::path& path, size_t size);
+    void Close();
+
+    // 文件属于当前用户或管理员（root、Administrators、SYSTEM）；POSIX 上还要求组和其他人不可写
+    bool OwnerTrusted() const;
+    // 整个文件上的建议锁（Windows 为字节范围锁），关闭文件或进程退出（包括崩溃）时由系统释放
+    bool LockShared();
+    // 没有其他句柄持有锁时取得独占锁；失败时不再持有本句柄原来的共享锁
+    bool TryLockExclusive();
+
+    const std::uint8_t* data() const { return m_data; }
+    // 只读打开时为 nullptr；写入直接进入页缓存，进程崩溃也不会丢失
+    std::uint8_t* writable_data() const { return m_writable ? const_cast<std::uint8_t*>(m_data) : nullptr; }
+    size_t size() const { return m_size; }
+
+private:
+    const std::uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_writable = false;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+// 只有所有者可写，其他用户只读：POSIX 上为 0644，Windows 上设置受保护的 DACL（所有者完全控制，其他人读取）
+bool MappedFile_RestrictWriteToOwner(const std::filesystem::path& path);
@@ -0,0 +1,361 @@
+#include "overlay_engine.h"
+
+#include <algorithm>
+
+#include "engine_log.h"
+
+void OverlayEngine::Emit(std::uint32_t value)
+{
+    // FNV-1a，按 4 字节混入
+    for (int i = 0; i < 4; i++)
+    {
+        m_outputHash ^= (value >> (i * 8)) & 0xFFu;
+        m_outputHash *= 0x01000193u;
+    }
+}
+
+void OverlayEngine::SetAlpha(std::uint8_t alpha)
+{
+    m_currentAlpha = alpha;
+    Emit(0x100u | alpha);
+    m_host.SetAlpha(alpha);
+}
+
+void OverlayEngine::Start(std::uint64_t nowMs, const AppConfig& cfg)
+{
+    m_nowMs = nowMs;
+    m_config = cfg;
+    if (m_recorder)
+    {
+        m_recorder->Config(EngineRecordType::Start, nowMs, cfg);
+    }
+    RunCommand(OVERLAY_CMD_SCHEDULER_START);
+}
+
+void OverlayEngine::OnTimer(EngineTimer id, std::uint64_t nowMs)
+{
+    m_nowMs = nowMs;
+    if (m_recorder)
+    {
+        m_recorder->Timer(id, nowMs);
+    }
+    switch (id)
+    {
+    case EngineTimer::Interval:
+        if (m_fsm.State() == OverlayState::Hidden && !ApplyShowPolicy())
+        {
+            break;
+        }
+        Post(OverlayEvent::Interval);
+        break;
+    case EngineTimer::Anim:
+        TickAnim();
+        break;
+    case EngineTimer::Clock:
+        if (m_fsm.State() != OverlayState::Hidden && m_fsm.State() != OverlayState::Exited)
+        {
+            Emit(0x200u);
+            m_host.InvalidateSurfaces();
+        }
+        break;
+    }
+}
+
+void OverlayEngine::OnActivity(std::uint64_t nowMs)
+{
+    m_nowMs = nowMs;
+    if (m_recorder)
+    {
+        m_recorder->Input(EngineRecordType::Activity, nowMs);
+    }
+    Post(OverlayEvent::Activity);
+}
+
+void OverlayEngine::OnConfigSaved(std::uint64_t nowMs, const AppConfig& cfg)
+{
+    m_nowMs = nowMs;
+    if (m_recorder)
+    {
+        m_recorder->Config(EngineRecordType::Config, nowMs, cfg);
+    }
+    m_config = cfg;
+    if (m_away)
+    {
+        // 间隔可能变了，回来时按新配置重新计时
+        m_pausedRemainingMs = 0;
+    }
+    Post(OverlayEvent::ConfigSaved);
+}
+
+void OverlayEngine::OnPreview(std::uint64_t nowMs, const AppConfig& cfg)
+{
+    m_nowMs = nowMs;
+    if (m_recorder)
+    {
+        m_recorder->Config(EngineRecordType::Preview, nowMs, cfg);
+    }
+    m_previewConfig = cfg;
+    Post(OverlayEvent::Preview);
+}
+
+void OverlayEngine::OnDisplayChange(std::uint64_t nowMs)
+{
+    m_nowMs = nowMs;
+    if (m_recorder)
+    {
+        m_recorder->Input(EngineRecordType::DisplayChange, nowMs);
+    }
+    Emit(0x300u);
+    m_host.ReconcileSurfaces();
+}
+
+void OverlayEngine::OnSnooze(std::uint64_t nowMs, std::uint32_t minutes)
+{
+    m_nowMs = nowMs;
+    if (m_recorder)
+    {
+        m_recorder->Snooze(nowMs, minutes);
+    }
+    m_snoozeMs = std::clamp<std::uint32_t>(minutes, 1, 24 * 60) * 60u * 1000u;
+    Emit(0x500u | minutes);
+    switch (m_fsm.State())
+    {
+    case OverlayState::Hidden:
+        RunCommand(OVERLAY_CMD_SCHEDULER_START);
+        break;
+    case OverlayState::WaitingInput:
+        Post(OverlayEvent::Activity);
+        break;
+    default:
+        break;
+    }
+}
+
+void OverlayEngine::OnTriggerNow(std::uint64_t nowMs)
+{
+    m_nowMs = nowMs;
+    if (m_recorder)
+    {
+        m_recorder->Input(EngineRecordType::TriggerNow, nowMs);
+    }
+    if (m_away)
+    {
+        // 没有人看，不显示
+        return;
+    }
+    Post(OverlayEvent::Interval);
+}
+
+void OverlayEngine::OnResume(std::uint64_t nowMs, std::uint32_t delayMs)
+{
+    m_nowMs = nowMs;
+    if (m_recorder)
+    {
+        m_recorder->Resume(nowMs, delayMs);
+    }
+    if (delayMs == 0 || m_fsm.State() != OverlayState::Hidden)
+    {
+        return;
+    }
+    Emit(0x600u);
+    m_snoozeMs = delayMs;
+    RunCommand(OVERLAY_CMD_SCHEDULER_START);
+}
+
+bool OverlayEngine::OnPresence(std::uint64_t nowMs, bool present)
+{
+    m_nowMs = nowMs;
+    if (m_recorder)
+    {
+        m_recorder->Presence(nowMs, present);
+    }
+    if (present != m_away || m_fsm.State() == OverlayState::Exited)
+    {
+        return false;
+    }
+    Emit(0x800u | (present ? 1u : 0u));
+    if (!present)
+    {
+        // 先记下剩余时间，再撤下遮罩；m_away 置位后 SchedulerStart 只停止计时器
+        const OverlayState state = m_fsm.State();
+        m_awayDuringBreak = state != OverlayState::Hidden && !m_preview;
+        m_pausedRemainingMs = state == OverlayState::Hidden && m_intervalDeadlineMs > nowMs ? (std::uint32_t)(m_intervalDeadlineMs - nowMs) : 0;
+        m_awaySinceMs = nowMs;
+        m_away = true;
+        RunCommand(OVERLAY_CMD_SCHEDULER_STOP);
+        Post(OverlayEvent::Away);
+        return false;
+    }
+
+    m_away = false;
+    const bool credited = m_awayDuringBreak || nowMs - m_awaySinceMs >= ENGINE_AWAY_BREAK_MS;
+    // 离开期间请求的稍后提醒优先；否则短暂离开接着剩余时间，按休息处理时计完整的间隔
+    if (m_snoozeMs == 0 && !credited)
+    {
+        m_snoozeMs = m_pausedRemainingMs;
+    }
+    m_awayDuringBreak = false;
+    m_pausedRemainingMs = 0;
+    if (m_fsm.State() == OverlayState::Hidden)
+    {
+        RunCommand(OVERLAY_CMD_SCHEDULER_START);
+    }
+    return credited;
+}
+
+void OverlayEngine::OnExit(std::uint64_t nowMs)
+{
+    m_nowMs = nowMs;
+    if (m_recorder)
+    {
+        m_recorder->Input(EngineRecordType::Exit, nowMs);
+    }
+    Post(OverlayEvent::Exit);
+}
+
+void OverlayEngine::Post(OverlayEvent event)
+{
+    m_fsm.Post(event);
+    m_fsm.Dispatch([this](OverlayState prev, OverlayEvent, const OverlayTransition& t)
+    {
+        if (prev != t.next)
+        {
+            Emit(0x400u | ((std::uint32_t)prev << 4) | (std::uint32_t)t.next);
+            m_host.OnStateChanged(prev, t.next);
+        }
+        for (std::uint32_t bits = t.commands; bits != 0; bits &= bits - 1)
+        {
+            RunCommand(bits & (0u - bits));
+        }
+        if (prev != t.next && m_recorder)
+        {
+            m_recorder->Checkpoint(m_outputHash);
+        }
+    });
+}
+
+void OverlayEngine::RunCommand(std::uint32_t command)
+{
+    Emit(0x10000u | command);
+    switch (command)
+    {
+    case OVERLAY_CMD_SCHEDULER_STOP:
+        m_host.KillTimer(EngineTimer::Interval);
+        m_intervalDeadlineMs = 0;
+        break;
+    case OVERLAY_CMD_ANIM_TIMER_STOP:
+        m_host.KillTimer(EngineTimer::Anim);
+        break;
+    case OVERLAY_CMD_CLOCK_TIMER_STOP:
+        m_host.KillTimer(EngineTimer::Clock);
+        break;
+    case OVERLAY_CMD_INPUT_STOP:
+        m_host.StopInput();
+        break;
+    case OVERLAY_CMD_ALPHA_ZERO:
+        SetAlpha(0);
+        break;
+    case OVERLAY_CMD_HIDE:
+        m_host.HideSurfaces();
+        break;
+    case OVERLAY_CMD_SHOW:
+    case OVERLAY_CMD_SHOW_PREVIEW:
+        m_preview = command == OVERLAY_CMD_SHOW_PREVIEW;
+        m_overlayConfig = m_preview ? m_previewConfig : m_config;
+        m_targetAlpha = (std::uint8_t)((m_overlayConfig.opacityPercent * 255) / 100);
+        m_currentAlpha = 0;
+        if (!m_host.ShowSurfaces())
+        {
+            if (m_recorder)
+            {
+                m_recorder->Input(EngineRecordType::ShowFailed, m_nowMs);
+            }
+            m_fsm.Post(OverlayEvent::ShowFailed);
+        }
+        break;
+    case OVERLAY_CMD_ALPHA_TARGET:
+        SetAlpha(m_targetAlpha);
+        break;
+    case OVERLAY_CMD_FADE_RESTART:
+        m_fadeStartMs = m_nowMs;
+        break;
+    case OVERLAY_CMD_LATCH_RESET:
+        m_host.ResetActivityLatch();
+        break;
+    case OVERLAY_CMD_INPUT_START:
+        m_host.StartInput();
+        break;
+    case OVERLAY_CMD_CLOCK_TIMER_START:
+        m_host.SetTimer(EngineTimer::Clock, ENGINE_CLOCK_PERIOD_MS);
+        break;
+    case OVERLAY_CMD_ANIM_TIMER_START:
+        m_host.SetTimer(EngineTimer::Anim, ENGINE_ANIM_PERIOD_MS);
+        break;
+    case OVERLAY_CMD_SCHEDULER_START:
+    {
+        if (m_away)
+        {
+            // 离开期间计时暂停，待生效的稍后提醒留到回来时
+            m_host.KillTimer(EngineTimer::Interval);
+            m_intervalDeadlineMs = 0;
+            break;
+        }
+        const std::uint32_t periodMs = NextPeriodMs();
+        m_host.SetTimer(EngineTimer::Interval, periodMs);
+        m_intervalDeadlineMs = m_nowMs + periodMs;
+        m_snoozeMs = 0;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// 宿主决定推迟或跳过时保持隐藏，只重新计时
+bool OverlayEngine::ApplyShowPolicy()
+{
+    const EngineShowPolicy policy = m_host.QueryShowPolicy();
+    if (policy == EngineShowPolicy::Show)
+    {
+        return true;
+    }
+    if (m_recorder)
+    {
+        m_recorder->Policy(m_nowMs, policy);
+    }
+    Emit(0x700u | (std::uint32_t)policy);
+    if (policy == EngineShowPolicy::Defer && m_snoozeMs == 0)
+    {
+        m_snoozeMs = ENGINE_DEFER_RETRY_MS;
+    }
+    RunCommand(OVERLAY_CMD_SCHEDULER_START);
+    return false;
+}
+
+void OverlayEngine::TickAnim()
+{
+    const OverlayState state = m_fsm.State();
+    if (state != OverlayState::FadingIn && state != OverlayState::FadingOut)
+    {
+        m_host.KillTimer(EngineTimer::Anim);
+        return;
+    }
+
+    const std::uint64_t elapsedMs = m_nowMs - m_fadeStartMs;
+    const std::uint64_t durationMs = (std::uint64_t)m_overlayConfig.fadeSeconds * 1000ull;
+    if (durationMs == 0)
+    {
+        return;
+    }
+
+    if (elapsedMs >= durationMs)
+    {
+        Post(state == OverlayState::FadingIn ? OverlayEvent::FadeInDone : OverlayEvent::FadeOutDone);
+        return;
+    }
+
+    const double t = (double)elapsedMs / (double)durationMs;
+    const double k = state == OverlayState::FadingIn ? t : 1.0 - t;
+    const int alpha = (int)(k * (double)m_targetAlpha);
+    SetAlpha((std::uint8_t)std::clamp(alpha, 0, 255));
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+
+#include "config.h"
+#include "overlay_fsm.h"
+
+class EngineRecorder;
+
+enum class EngineTimer : std::uint8_t
+{
+    Interval = 1,
+    Anim = 2,
+    Clock = 3,
+};
+
+// 计时到点时是否显示遮罩（预览与立即提醒不经过这里）
+enum class EngineShowPolicy : std::uint8_t
+{
+    Show = 0,
+    Defer = 1,     // ENGINE_DEFER_RETRY_MS 后再问一次
+    Suppress = 2,  // 跳过本次，重新计完整的间隔
+};
+
+constexpr std::uint32_t ENGINE_ANIM_PERIOD_MS = 15;
+constexpr std::uint32_t ENGINE_CLOCK_PERIOD_MS = 1000;
+constexpr std::uint32_t ENGINE_DEFER_RETRY_MS = 30 * 1000;
+// 离开至少这么久才算作一次休息，回来时重新计完整的间隔；更短的离开只是暂停
+constexpr std::uint32_t ENGINE_AWAY_BREAK_MS = 60 * 1000;
+
+// 引擎对外的全部副作用。Win32 程序用真实的计时器、窗口与钩子实现，
+// 模拟与回放用虚拟时钟实现。计时器与 Win32 SetTimer 一样是周期性的。
+class EngineHost
+{
+public:
+    virtual ~EngineHost() = default;
+
+    virtual void SetTimer(EngineTimer id, std::uint32_t periodMs) = 0;
+    virtual void KillTimer(EngineTimer id) = 0;
+
+    // 以 0 透明度显示所有遮罩；没有可用遮罩时返回 false
+    virtual bool ShowSurfaces() = 0;
+    virtual void HideSurfaces() = 0;
+    virtual void SetAlpha(std::uint8_t alpha) = 0;
+    virtual void InvalidateSurfaces() = 0;
+    virtual void ReconcileSurfaces() = 0;
+
+    virtual void StartInput() = 0;
+    virtual void StopInput() = 0;
+    virtual void ResetActivityLatch() = 0;
+
+    virtual void OnStateChanged(OverlayState prev, OverlayState next) = 0;
+
+    virtual EngineShowPolicy QueryShowPolicy() { return EngineShowPolicy::Show; }
+};
+
+// 调度与淡入淡出的核心逻辑：只依赖传入的时间（毫秒，单调递增），
+// 同样的输入序列总是产生同样的状态转移与透明度。
+class OverlayEngine
+{
+public:
+    explicit OverlayEngine(EngineHost& host) : m_host(host) {}
+
+    void SetRecorder(EngineRecorder* recorder) { m_recorder = recorder; }
+
+    void Start(std::uint64_t nowMs, const AppConfig& cfg);
+    void OnTimer(EngineTimer id, std::uint64_t nowMs);
+    void OnActivity(std::uint64_t nowMs);
+    void OnConfigSaved(std::uint64_t nowMs, const AppConfig& cfg);
+    void OnPreview(std::uint64_t nowMs, const AppConfig& cfg);
+    void OnDisplayChange(std::uint64_t nowMs);
+    // 下一次计时改用 minutes 分钟：未显示遮罩时立即重新计时，等待活动时当作用户已回来，
+    // 淡入淡出中则在这次提醒结束后生效
+    void OnSnooze(std::uint64_t nowMs, std::uint32_t minutes);
+    void OnTriggerNow(std::uint64_t nowMs);
+    // 启动后接着上次退出前的倒计时：未显示遮罩时把当前计时改为 delayMs 毫秒
+    void OnResume(std::uint64_t nowMs, std::uint32_t delayMs);
+    // 用户离开（锁屏、会话断开、显示器关闭）时撤下遮罩并暂停计时；回来时若离开够久或
+    // 离开时正在提醒，按休息处理并重新计时，否则接着暂停前的剩余时间。返回是否按休息处理
+    bool OnPresence(std::uint64_t nowMs, bool present);
+    void OnExit(std::uint64_t nowMs);
+
+    OverlayState State() const { return m_fsm.State(); }
+    const AppConfig& Config() const { return m_config; }
+    const AppConfig& OverlayConfig() const { return m_overlayConfig; }
+    bool IsPreview() const { return m_preview; }
+    bool IsAway() const { return m_away; }
+    // 已请求、等这次提醒结束后才生效的稍后提醒
+    std::uint32_t PendingSnoozeMs() const { return m_snoozeMs; }
+    // 下一次开始计时时的时长：有待生效的稍后提醒时为它，否则为提醒间隔
+    std::uint32_t NextPeriodMs() const { return m_snoozeMs != 0 ? m_snoozeMs : (std::uint32_t)m_config.intervalMinutes * 60u * 1000u; }
+    std::uint8_t Alpha() const { return m_currentAlpha; }
+    std::uint8_t TargetAlpha() const { return m_targetAlpha; }
+
+    // 所有输出（状态转移、透明度、遮罩与计时器操作）的累计哈希，回放时用来比对
+    std::uint32_t OutputHash() const { return m_outputHash; }
+
+private:
+    void Post(OverlayEvent event);
+    void RunCommand(std::uint32_t command);
+    void TickAnim();
+    bool ApplyShowPolicy();
+    void SetAlpha(std::uint8_t alpha);
+    void Emit(std::uint32_t value);
+
+    EngineHost& m_host;
+    EngineRecorder* m_recorder = nullptr;
+    OverlayFsm m_fsm;
+
+    AppConfig m_config{};
+    AppConfig m_overlayConfig{};
+    AppConfig m_previewConfig{};
+    bool m_preview = false;
+
+    std::uint64_t m_nowMs = 0;
+    std::uint64_t m_fadeStartMs = 0;
+    std::uint64_t m_intervalDeadlineMs = 0;
+    std::uint32_t m_snoozeMs = 0;
+
+    bool m_away = false;
+    bool m_awayDuringBreak = false;
+    std::uint64_t m_awaySinceMs = 0;
+    std::uint32_t m_pausedRemainingMs = 0;
+    std::uint8_t m_targetAlpha = 153;
+    std::uint8_t m_currentAlpha = 0;
+    std::uint32_t m_outputHash = 0x811C9DC5u;
+};
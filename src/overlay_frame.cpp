@@ -0,0 +1,226 @@
+#include "overlay_frame.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include "trace.h"
+
+std::uint64_t OverlayFrame_ContentHash(ColorRef bgColor, std::wstring_view text, std::uint64_t animationKey)
+{
+    // FNV-1a
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    auto mix = [&h](std::uint32_t v)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            h ^= (v >> (i * 8)) & 0xFFu;
+            h *= 0x100000001B3ull;
+        }
+    };
+    mix(bgColor);
+    if (animationKey)
+    {
+        mix(0xA11Du);
+        mix((std::uint32_t)animationKey);
+        mix((std::uint32_t)(animationKey >> 32));
+        return h;
+    }
+    mix((std::uint32_t)text.size());
+    for (wchar_t ch : text)
+    {
+        mix((std::uint32_t)ch);
+    }
+    return h;
+}
+
+std::uint64_t OverlayFrame_TemplateHash(ColorRef bgColor, std::uint64_t sourceHash, std::uint64_t lineSignature)
+{
+    std::uint64_t h = OverlayFrame_ContentHash(bgColor, std::wstring_view());
+    for (std::uint64_t v : { sourceHash, lineSignature })
+    {
+        h = (h ^ v) * 0x100000001B3ull;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+std::uint64_t OverlayFrame_RegionHash(const ScreenRegion* region)
+{
+    if (!region)
+    {
+        return 0;
+    }
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    for (const ScreenRect& r : region->Rects())
+    {
+        for (int v : { r.left, r.top, r.right, r.bottom })
+        {
+            h = (h ^ (std::uint32_t)v) * 0x100000001B3ull;
+        }
+    }
+    return h | 1;
+}
+
+void OverlayFrameCache::Store(SurfaceHandle surface, std::shared_ptr<const OverlayFrame> frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& entry : m_frames)
+    {
+        if (entry.first == surface)
+        {
+            entry.second = std::move(frame);
+            return;
+        }
+    }
+    m_frames.emplace_back(surface, std::move(frame));
+}
+
+bool OverlayFrameCache::Store(SurfaceHandle surface, std::shared_ptr<const OverlayFrame> frame, std::uint64_t generation)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (generation != m_generation)
+    {
+        m_discarded.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    for (auto& entry : m_frames)
+    {
+        if (entry.first == surface)
+        {
+            entry.second = std::move(frame);
+            return true;
+        }
+    }
+    m_frames.emplace_back(surface, std::move(frame));
+    return true;
+}
+
+std::shared_ptr<const OverlayFrame> OverlayFrameCache::Find(SurfaceHandle surface, const OverlayFrameKey& key) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& entry : m_frames)
+    {
+        if (entry.first == surface)
+        {
+            return entry.second && entry.second->key == key ? entry.second : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+void OverlayFrameCache::Clear()
+{
+    std::vector<std::pair<SurfaceHandle, std::shared_ptr<const OverlayFrame>>> released;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        released.swap(m_frames);
+        m_generation++;
+    }
+}
+
+void OverlayFrameCache::Revoke()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_generation++;
+}
+
+std::uint64_t OverlayFrameCache::Generation() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_generation;
+}
+
+PrerenderWorker::~PrerenderWorker()
+{
+    Stop();
+}
+
+void PrerenderWorker::Start()
+{
+    if (m_thread.joinable())
+    {
+        return;
+    }
+    m_stop = false;
+    m_thread = std::thread([this] { WorkerLoop(); });
+}
+
+void PrerenderWorker::Stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_job = nullptr;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+}
+
+void PrerenderWorker::Schedule(Clock::time_point deadline, std::chrono::milliseconds lead, Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = std::move(job);
+        m_deadline = deadline;
+        m_wakeAt = deadline - lead;
+    }
+    m_cv.notify_one();
+}
+
+void PrerenderWorker::Cancel()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job = nullptr;
+}
+
+void PrerenderWorker::WorkerLoop()
+{
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+    // Linux 上 PRIO_PROCESS 配合 0 只作用于当前线程
+    setpriority(PRIO_PROCESS, 0, 10);
+#endif
+    Trace_SetThreadName("prerender");
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_cv.wait(lock, [this] { return m_stop || m_job; });
+        if (m_stop)
+        {
+            return;
+        }
+        const Clock::time_point wakeAt = m_wakeAt;
+        if (m_cv.wait_until(lock, wakeAt, [this, wakeAt] { return m_stop || !m_job || m_wakeAt != wakeAt; }))
+        {
+            // 被取消或重新计划，回到外层重新等待
+            continue;
+        }
+
+        Job job = std::move(m_job);
+        m_job = nullptr;
+        const Clock::time_point deadline = m_deadline;
+        lock.unlock();
+
+        const auto untilDeadline = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+        const auto systemNow = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
+        {
+            TRACE_SCOPE("overlay", "Prerender");
+            job((systemNow + untilDeadline).count());
+        }
+        m_completed.fetch_add(1, std::memory_order_relaxed);
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "overlay_surface.h"
+#include "screen_region.h"
+#include "show_arena.h"
+
+// 预渲染的遮罩画面。base 只含背景与文字，composed 额外画好了 clockSecond 那一秒的时间；
+// 像素为自上而下的 32 位 0x00RRGGBB，可直接作为 DIB 输出。
+// 像素放在 ShowArena_Overlay 里，遮罩隐藏、画面缓存清空后随 arena 一起归还系统。
+struct OverlayFrameKey
+{
+    int width = 0;
+    int height = 0;
+    int dpi = 0;
+    std::uint64_t contentHash = 0;
+    std::uint64_t regionHash = 0;   // 只画了部分区域的画面不能给其他区域使用；整屏为 0
+};
+
+inline bool operator==(const OverlayFrameKey& a, const OverlayFrameKey& b)
+{
+    return a.width == b.width && a.height == b.height && a.dpi == b.dpi && a.contentHash == b.contentHash && a.regionHash == b.regionHash;
+}
+
+using OverlayPixels = std::vector<std::uint32_t, ShowArenaAllocator<std::uint32_t>>;
+
+struct OverlayFrame
+{
+    OverlayFrameKey key;
+    std::int64_t clockSecond = -1;
+    // composed 上含变量的文字行的取值（TextTemplate::ValuesHash），与当前取值相同时才能直接输出
+    std::uint64_t textKey = 0;
+    OverlayPixels base;
+    OverlayPixels composed;
+    // 底图在共享资源包里时指向映射内存，base 为空；owner 保证映射在使用期间有效
+    const std::uint32_t* sharedBase = nullptr;
+    std::shared_ptr<const void> owner;
+
+    const std::uint32_t* BasePixels() const { return sharedBase ? sharedBase : base.data(); }
+};
+
+// 影响画面内容的配置项（背景色、文字）的哈希；播放动画时底图不画文字，
+// 用动画的 animationKey 代替文字
+std::uint64_t OverlayFrame_ContentHash(ColorRef bgColor, std::wstring_view text, std::uint64_t animationKey = 0);
+// 按 text.txt 模板绘制时的内容哈希：模板源文字的哈希代替文字本身，再混入含变量的行的高度
+// （底图只画不含变量的行，它们的位置随这些行折行后的高度变化）
+std::uint64_t OverlayFrame_TemplateHash(ColorRef bgColor, std::uint64_t sourceHash, std::uint64_t lineSignature);
+// 绘制时裁剪区域的哈希；region 为空指针时为 0
+std::uint64_t OverlayFrame_RegionHash(const ScreenRegion* region);
+
+// 按遮罩句柄保存最近一次渲染的画面；后台线程写入、界面线程读取。
+// 后台任务计划时取 Generation，写入时带上它：其间 Clear 或 Revoke 过的写入被丢弃，
+// 取消之后才画完的画面不会留在缓存里占着 arena
+class OverlayFrameCache
+{
+public:
+    void Store(SurfaceHandle surface, std::shared_ptr<const OverlayFrame> frame);
+    // 代号已过期时丢弃 frame，返回 false
+    bool Store(SurfaceHandle surface, std::shared_ptr<const OverlayFrame> frame, std::uint64_t generation);
+    std::shared_ptr<const OverlayFrame> Find(SurfaceHandle surface, const OverlayFrameKey& key) const;
+    // 清空画面并使之前取得的代号过期
+    void Clear();
+    // 只使代号过期，已有的画面保留
+    void Revoke();
+    std::uint64_t Generation() const;
+
+    void CountHit() { m_hits.fetch_add(1, std::memory_order_relaxed); }
+    void CountStale() { m_stale.fetch_add(1, std::memory_order_relaxed); }
+    void CountMiss() { m_misses.fetch_add(1, std::memory_order_relaxed); }
+    std::uint64_t Hits() const { return m_hits.load(std::memory_order_relaxed); }
+    std::uint64_t Stale() const { return m_stale.load(std::memory_order_relaxed); }
+    std::uint64_t Misses() const { return m_misses.load(std::memory_order_relaxed); }
+    // 因代号过期被丢弃的写入
+    std::uint64_t Discarded() const { return m_discarded.load(std::memory_order_relaxed); }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::pair<SurfaceHandle, std::shared_ptr<const OverlayFrame>>> m_frames;
+    std::uint64_t m_generation = 0;
+    std::atomic<std::uint64_t> m_discarded{0};
+    std::atomic<std::uint64_t> m_hits{0};
+    std::atomic<std::uint64_t> m_stale{0};
+    std::atomic<std::uint64_t> m_misses{0};
+};
+
+// 低优先级后台线程：在截止时间前 lead 唤醒并执行一次渲染任务。
+// 任务参数是预计弹出时刻（Unix 毫秒），再次 Schedule 会替换尚未执行的任务。
+class PrerenderWorker
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Job = std::function<void(std::int64_t predictedUnixMs)>;
+
+    PrerenderWorker() = default;
+    ~PrerenderWorker();
+
+    PrerenderWorker(const PrerenderWorker&) = delete;
+    PrerenderWorker& operator=(const PrerenderWorker&) = delete;
+
+    void Start();
+    void Stop();
+
+    void Schedule(Clock::time_point deadline, std::chrono::milliseconds lead, Job job);
+    void Cancel();
+
+    std::uint64_t Completed() const { return m_completed.load(std::memory_order_relaxed); }
+
+private:
+    void WorkerLoop();
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+    Job m_job;
+    Clock::time_point m_deadline{};
+    Clock::time_point m_wakeAt{};
+    std::atomic<std::uint64_t> m_completed{0};
+};
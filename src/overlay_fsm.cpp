@@ -0,0 +1,158 @@
+#include "overlay_fsm.h"
+
+namespace
+{
+    using S = OverlayState;
+
+    constexpr std::uint32_t SHOW_COMMON =
+        OVERLAY_CMD_SCHEDULER_STOP | OVERLAY_CMD_FADE_RESTART | OVERLAY_CMD_LATCH_RESET |
+        OVERLAY_CMD_INPUT_START | OVERLAY_CMD_CLOCK_TIMER_START | OVERLAY_CMD_ANIM_TIMER_START;
+
+    // 关闭遮罩的全部资源；回到 Hidden 时另加重新计时
+    constexpr std::uint32_t TEARDOWN =
+        OVERLAY_CMD_ANIM_TIMER_STOP | OVERLAY_CMD_CLOCK_TIMER_STOP | OVERLAY_CMD_INPUT_STOP | OVERLAY_CMD_HIDE;
+
+    constexpr std::uint32_t EXIT = TEARDOWN | OVERLAY_CMD_SCHEDULER_STOP;
+
+    // 遮罩显示期间计时器本应已停止，万一残留的到点消息到来就再停一次
+    constexpr std::uint32_t STRAY_INTERVAL = OVERLAY_CMD_SCHEDULER_STOP;
+
+    // 用户离开时不淡出，直接撤下；回到 Hidden 照常重新计时，离开期间由引擎暂停
+    constexpr std::uint32_t AWAY = TEARDOWN | OVERLAY_CMD_ALPHA_ZERO | OVERLAY_CMD_SCHEDULER_START;
+
+    constexpr OverlayTransition Stay(S s) { return OverlayTransition{ s, 0 }; }
+
+    // 行：状态；列：Interval, Preview, FadeInDone, Activity, FadeOutDone, ConfigSaved, ShowFailed, Exit, Away
+    constexpr OverlayTransition kTable[OVERLAY_STATE_COUNT][OVERLAY_EVENT_COUNT] = {
+        // Hidden
+        {
+            { S::FadingIn, SHOW_COMMON | OVERLAY_CMD_SHOW },
+            { S::FadingIn, SHOW_COMMON | OVERLAY_CMD_SHOW_PREVIEW },
+            Stay(S::Hidden),
+            Stay(S::Hidden),
+            Stay(S::Hidden),
+            { S::Hidden, OVERLAY_CMD_SCHEDULER_START },
+            Stay(S::Hidden),
+            { S::Exited, EXIT },
+            Stay(S::Hidden),
+        },
+        // FadingIn
+        {
+            { S::FadingIn, STRAY_INTERVAL },
+            Stay(S::FadingIn),
+            { S::WaitingInput, OVERLAY_CMD_ALPHA_TARGET | OVERLAY_CMD_ANIM_TIMER_STOP | OVERLAY_CMD_LATCH_RESET },
+            Stay(S::FadingIn),
+            Stay(S::FadingIn),
+            Stay(S::FadingIn),
+            { S::Hidden, TEARDOWN | OVERLAY_CMD_SCHEDULER_START },
+            { S::Exited, EXIT },
+            { S::Hidden, AWAY },
+        },
+        // WaitingInput
+        {
+            { S::WaitingInput, STRAY_INTERVAL },
+            Stay(S::WaitingInput),
+            Stay(S::WaitingInput),
+            { S::FadingOut, OVERLAY_CMD_FADE_RESTART | OVERLAY_CMD_ANIM_TIMER_START },
+            Stay(S::WaitingInput),
+            Stay(S::WaitingInput),
+            Stay(S::WaitingInput),
+            { S::Exited, EXIT },
+            { S::Hidden, AWAY },
+        },
+        // FadingOut
+        {
+            { S::FadingOut, STRAY_INTERVAL },
+            Stay(S::FadingOut),
+            Stay(S::FadingOut),
+            Stay(S::FadingOut),
+            { S::Hidden, TEARDOWN | OVERLAY_CMD_ALPHA_ZERO | OVERLAY_CMD_SCHEDULER_START },
+            Stay(S::FadingOut),
+            Stay(S::FadingOut),
+            { S::Exited, EXIT },
+            { S::Hidden, AWAY },
+        },
+        // Exited
+        {
+            Stay(S::Exited),
+            Stay(S::Exited),
+            Stay(S::Exited),
+            Stay(S::Exited),
+            Stay(S::Exited),
+            Stay(S::Exited),
+            Stay(S::Exited),
+            Stay(S::Exited),
+            Stay(S::Exited),
+        },
+    };
+}
+
+const OverlayTransition& OverlayFsm_Lookup(OverlayState state, OverlayEvent event)
+{
+    return kTable[(int)state][(int)event];
+}
+
+const char* OverlayFsm_StateName(OverlayState state)
+{
+    switch (state)
+    {
+    case OverlayState::Hidden: return "Hidden";
+    case OverlayState::FadingIn: return "FadingIn";
+    case OverlayState::WaitingInput: return "WaitingInput";
+    case OverlayState::FadingOut: return "FadingOut";
+    case OverlayState::Exited: return "Exited";
+    }
+    return "Unknown";
+}
+
+const char* OverlayFsm_EventName(OverlayEvent event)
+{
+    switch (event)
+    {
+    case OverlayEvent::Interval: return "Interval";
+    case OverlayEvent::Preview: return "Preview";
+    case OverlayEvent::FadeInDone: return "FadeInDone";
+    case OverlayEvent::Activity: return "Activity";
+    case OverlayEvent::FadeOutDone: return "FadeOutDone";
+    case OverlayEvent::ConfigSaved: return "ConfigSaved";
+    case OverlayEvent::ShowFailed: return "ShowFailed";
+    case OverlayEvent::Exit: return "Exit";
+    case OverlayEvent::Away: return "Away";
+    }
+    return "Unknown";
+}
+
+const char* OverlayFsm_CommandName(std::uint32_t command)
+{
+    switch (command)
+    {
+    case OVERLAY_CMD_SCHEDULER_STOP: return "SchedulerStop";
+    case OVERLAY_CMD_ANIM_TIMER_STOP: return "AnimTimerStop";
+    case OVERLAY_CMD_CLOCK_TIMER_STOP: return "ClockTimerStop";
+    case OVERLAY_CMD_INPUT_STOP: return "InputStop";
+    case OVERLAY_CMD_ALPHA_ZERO: return "AlphaZero";
+    case OVERLAY_CMD_HIDE: return "Hide";
+    case OVERLAY_CMD_SHOW: return "Show";
+    case OVERLAY_CMD_SHOW_PREVIEW: return "ShowPreview";
+    case OVERLAY_CMD_ALPHA_TARGET: return "AlphaTarget";
+    case OVERLAY_CMD_FADE_RESTART: return "FadeRestart";
+    case OVERLAY_CMD_LATCH_RESET: return "LatchReset";
+    case OVERLAY_CMD_INPUT_START: return "InputStart";
+    case OVERLAY_CMD_CLOCK_TIMER_START: return "ClockTimerStart";
+    case OVERLAY_CMD_ANIM_TIMER_START: return "AnimTimerStart";
+    case OVERLAY_CMD_SCHEDULER_START: return "SchedulerStart";
+    }
+    return "Unknown";
+}
+
+bool OverlayFsm::Post(OverlayEvent event)
+{
+    if (m_head - m_tail >= QUEUE_CAPACITY)
+    {
+        m_dropped++;
+        return false;
+    }
+    m_queue[m_head % QUEUE_CAPACITY] = event;
+    m_head++;
+    return true;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 遮罩生命周期的状态机：状态 × 事件 → (下一个状态, 命令集合)。
+// 转移只查表，不分配内存；副作用以命令位集合返回，由调用方按位序执行。
+
+enum class OverlayState : int
+{
+    Hidden = 0,
+    FadingIn = 1,
+    WaitingInput = 2,
+    FadingOut = 3,
+    Exited = 4,
+};
+
+constexpr int OVERLAY_STATE_COUNT = 5;
+
+enum class OverlayEvent : std::uint8_t
+{
+    Interval = 0,    // 提醒间隔到点
+    Preview = 1,     // 设置窗口点击预览
+    FadeInDone = 2,
+    Activity = 3,    // 淡入完成后的首次键鼠活动
+    FadeOutDone = 4,
+    ConfigSaved = 5,
+    ShowFailed = 6,  // 执行 OVERLAY_CMD_SHOW* 时没有任何可用遮罩
+    Exit = 7,
+    Away = 8,        // 锁屏、会话断开或显示器关闭：立即撤下遮罩，计时由引擎暂停
+};
+
+constexpr int OVERLAY_EVENT_COUNT = 9;
+
+// 按位序执行：先停止与隐藏，再显示与启动
+enum OverlayCommand : std::uint32_t
+{
+    OVERLAY_CMD_SCHEDULER_STOP = 1u << 0,
+    OVERLAY_CMD_ANIM_TIMER_STOP = 1u << 1,
+    OVERLAY_CMD_CLOCK_TIMER_STOP = 1u << 2,
+    OVERLAY_CMD_INPUT_STOP = 1u << 3,
+    OVERLAY_CMD_ALPHA_ZERO = 1u << 4,
+    OVERLAY_CMD_HIDE = 1u << 5,
+    OVERLAY_CMD_SHOW = 1u << 6,
+    OVERLAY_CMD_SHOW_PREVIEW = 1u << 7,
+    OVERLAY_CMD_ALPHA_TARGET = 1u << 8,
+    OVERLAY_CMD_FADE_RESTART = 1u << 9,
+    OVERLAY_CMD_LATCH_RESET = 1u << 10,
+    OVERLAY_CMD_INPUT_START = 1u << 11,
+    OVERLAY_CMD_CLOCK_TIMER_START = 1u << 12,
+    OVERLAY_CMD_ANIM_TIMER_START = 1u << 13,
+    OVERLAY_CMD_SCHEDULER_START = 1u << 14,
+};
+
+constexpr int OVERLAY_COMMAND_COUNT = 15;
+
+struct OverlayTransition
+{
+    OverlayState next;
+    std::uint32_t commands;
+};
+
+const OverlayTransition& OverlayFsm_Lookup(OverlayState state, OverlayEvent event);
+
+const char* OverlayFsm_StateName(OverlayState state);
+const char* OverlayFsm_EventName(OverlayEvent event);
+const char* OverlayFsm_CommandName(std::uint32_t command);
+
+// 单线程使用的事件队列。Dispatch 期间执行命令时投递的新事件排在队尾，
+// 在同一次 Dispatch 中处理完。
+class OverlayFsm
+{
+public:
+    OverlayState State() const { return m_state; }
+
+    // 队列满时丢弃并返回 false
+    bool Post(OverlayEvent event);
+
+    // exec(prev, event, transition) 在状态更新之后调用
+    template <typename Exec>
+    void Dispatch(Exec&& exec)
+    {
+        if (m_dispatching)
+        {
+            return;
+        }
+        m_dispatching = true;
+        while (m_head != m_tail)
+        {
+            const OverlayEvent event = m_queue[m_tail % QUEUE_CAPACITY];
+            m_tail++;
+            const OverlayState prev = m_state;
+            const OverlayTransition& t = OverlayFsm_Lookup(prev, event);
+            m_state = t.next;
+            exec(prev, event, t);
+        }
+        m_dispatching = false;
+    }
+
+    std::uint64_t Dropped() const { return m_dropped; }
+
+private:
+    static constexpr std::size_t QUEUE_CAPACITY = 16;
+
+    OverlayState m_state = OverlayState::Hidden;
+    OverlayEvent m_queue[QUEUE_CAPACITY]{};
+    std::size_t m_head = 0;
+    std::size_t m_tail = 0;
+    std::uint64_t m_dropped = 0;
+    bool m_dispatching = false;
+};
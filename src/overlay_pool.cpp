@@ -0,0 +1,270 @@
+#include "overlay_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+OverlayPool::~OverlayPool()
+{
+    DestroyAll();
+}
+
+size_t OverlayPool::Prepare()
+{
+    if (!m_dirty && !m_slots.empty())
+    {
+        return m_slots.size();
+    }
+    m_scratch.clear();
+    m_backend.EnumMonitors(m_scratch);
+    return Prepare(m_scratch);
+}
+
+size_t OverlayPool::Prepare(const std::vector<MonitorInfo>& monitors)
+{
+    Reconcile(monitors);
+    return m_slots.size();
+}
+
+static long long OverlapArea(const ScreenRect& a, const ScreenRect& b)
+{
+    const long long w = (long long)std::min(a.right, b.right) - std::max(a.left, b.left);
+    const long long h = (long long)std::min(a.bottom, b.bottom) - std::max(a.top, b.top);
+    return (w > 0 && h > 0) ? w * h : 0;
+}
+
+OverlayReconcileResult OverlayPool::Reconcile(const std::vector<MonitorInfo>& monitors)
+{
+    OverlayReconcileResult result;
+    m_dirty = false;
+
+    const bool same = monitors.size() == m_slots.size() &&
+        std::equal(monitors.begin(), monitors.end(), m_slots.begin(),
+            [](const MonitorInfo& m, const Slot& s) { return m == s.monitor; });
+    if (same)
+    {
+        result.kept = m_slots.size();
+        return result;
+    }
+
+    // 第一轮：位置与 DPI 都没变的遮罩原样保留
+    const size_t oldCount = m_slots.size();
+    m_matched.assign(oldCount, false);
+    m_next.assign(monitors.size(), Slot{ MonitorInfo{}, 0, ScreenRegion{} });
+    for (size_t i = 0; i < monitors.size(); i++)
+    {
+        for (size_t j = 0; j < oldCount; j++)
+        {
+            if (!m_matched[j] && m_slots[j].monitor == monitors[i])
+            {
+                m_matched[j] = true;
+                m_next[i] = m_slots[j];
+                result.kept++;
+                break;
+            }
+        }
+    }
+
+    // 第二轮：其余显示器优先接手重叠面积最大的旧遮罩，其次任意空闲的旧遮罩
+    for (size_t i = 0; i < monitors.size(); i++)
+    {
+        if (m_next[i].surface)
+        {
+            continue;
+        }
+        size_t best = oldCount;
+        long long bestArea = -1;
+        for (size_t j = 0; j < oldCount; j++)
+        {
+            if (m_matched[j])
+            {
+                continue;
+            }
+            const long long area = OverlapArea(m_slots[j].monitor.rect, monitors[i].rect);
+            if (area > bestArea)
+            {
+                bestArea = area;
+                best = j;
+            }
+        }
+        if (best == oldCount)
+        {
+            continue;
+        }
+        m_matched[best] = true;
+        m_backend.Reposition(m_slots[best].surface, monitors[i]);
+        m_next[i] = Slot{ monitors[i], m_slots[best].surface, m_slots[best].region };
+        result.moved++;
+    }
+
+    for (size_t j = 0; j < oldCount; j++)
+    {
+        if (!m_matched[j])
+        {
+            m_backend.Destroy(m_slots[j].surface);
+            result.retired++;
+        }
+    }
+
+    // 第三轮：新增的显示器创建遮罩；显示期间以当前透明度立即显示，淡入淡出进度不受影响。
+    // 规则按显示器序号生效，顺序变化后保留下来的遮罩也要重新计算区域
+    m_slots.clear();
+    for (size_t i = 0; i < monitors.size(); i++)
+    {
+        bool wasShown = m_visible && !IsSkipped(m_next[i]);
+        if (!m_next[i].surface)
+        {
+            const SurfaceHandle surface = m_backend.Create(monitors[i]);
+            if (!surface)
+            {
+                // 个别显示器失败不影响其它显示器，下次再试
+                m_dirty = true;
+                result.failed++;
+                continue;
+            }
+            m_next[i] = Slot{ monitors[i], surface, ScreenRegion(ScreenRect{ 0, 0, monitors[i].rect.Width(), monitors[i].rect.Height() }) };
+            wasShown = false;
+            result.created++;
+        }
+        const bool changed = UpdateRegion(i, m_next[i]);
+        ApplyVisibility(m_next[i], wasShown, changed);
+        m_slots.push_back(m_next[i]);
+    }
+    return result;
+}
+
+bool OverlayPool::Show(std::uint8_t alpha, const ScreenRect* skip)
+{
+    Prepare();
+    m_hasSkip = skip != nullptr;
+    m_skip = skip ? *skip : ScreenRect{};
+
+    size_t shown = 0;
+    m_alpha = alpha;
+    for (const Slot& slot : m_slots)
+    {
+        if (IsSkipped(slot))
+        {
+            continue;
+        }
+        m_backend.SetAlpha(slot.surface, alpha);
+        m_backend.Invalidate(slot.surface);
+        m_backend.Show(slot.surface);
+        shown++;
+    }
+    if (shown == 0)
+    {
+        m_hasSkip = false;
+        return false;
+    }
+    m_visible = true;
+    return true;
+}
+
+void OverlayPool::Hide()
+{
+    if (!m_visible)
+    {
+        return;
+    }
+    for (const Slot& slot : m_slots)
+    {
+        m_backend.Hide(slot.surface);
+    }
+    m_visible = false;
+    m_hasSkip = false;
+}
+
+void OverlayPool::DestroyAll()
+{
+    for (const Slot& slot : m_slots)
+    {
+        m_backend.Destroy(slot.surface);
+    }
+    m_slots.clear();
+    m_visible = false;
+    m_dirty = true;
+}
+
+void OverlayPool::SetAlpha(std::uint8_t alpha)
+{
+    m_alpha = alpha;
+    for (const Slot& slot : m_slots)
+    {
+        m_backend.SetAlpha(slot.surface, alpha);
+    }
+}
+
+void OverlayPool::InvalidateAll()
+{
+    for (const Slot& slot : m_slots)
+    {
+        if (!slot.region.IsEmpty())
+        {
+            m_backend.Invalidate(slot.surface);
+        }
+    }
+}
+
+void OverlayPool::SetRegionSpec(std::string_view spec)
+{
+    if (spec == m_regionSpec)
+    {
+        return;
+    }
+    m_regionSpec.assign(spec.data(), spec.size());
+    OverlayRegion_Parse(spec, m_regionRules);
+    for (size_t i = 0; i < m_slots.size(); i++)
+    {
+        Slot& slot = m_slots[i];
+        const bool wasShown = m_visible && !IsSkipped(slot);
+        const bool changed = UpdateRegion(i, slot);
+        ApplyVisibility(slot, wasShown, changed);
+    }
+}
+
+const ScreenRegion* OverlayPool::RegionOf(SurfaceHandle surface) const
+{
+    for (const Slot& slot : m_slots)
+    {
+        if (slot.surface == surface)
+        {
+            return &slot.region;
+        }
+    }
+    return nullptr;
+}
+
+bool OverlayPool::UpdateRegion(size_t index, Slot& slot)
+{
+    OverlayRegion_Build(m_regionRules, index, slot.monitor.rect.Width(), slot.monitor.rect.Height(), m_regionScratch);
+    if (m_regionScratch == slot.region)
+    {
+        return false;
+    }
+    std::swap(slot.region, m_regionScratch);
+    // 变空的遮罩只需隐藏，形状留到区域重新出现时再设置
+    if (!slot.region.IsEmpty())
+    {
+        m_backend.SetRegion(slot.surface, slot.region);
+    }
+    return true;
+}
+
+void OverlayPool::ApplyVisibility(const Slot& slot, bool wasShown, bool changed)
+{
+    const bool shown = m_visible && !IsSkipped(slot);
+    if (wasShown && !shown)
+    {
+        m_backend.Hide(slot.surface);
+    }
+    else if (shown && !wasShown)
+    {
+        m_backend.SetAlpha(slot.surface, m_alpha);
+        m_backend.Invalidate(slot.surface);
+        m_backend.Show(slot.surface);
+    }
+    else if (shown && changed)
+    {
+        m_backend.Invalidate(slot.surface);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "overlay_region.h"
+#include "overlay_surface.h"
+
+struct OverlayReconcileResult
+{
+    size_t kept = 0;
+    size_t moved = 0;
+    size_t created = 0;
+    size_t retired = 0;
+    size_t failed = 0;
+};
+
+// 每个显示器一个预先创建好的隐藏遮罩，在多次提醒之间复用；
+// 只有显示器拓扑或 DPI 变化后才调整对应的遮罩，遮罩显示期间也可以调整。
+class OverlayPool
+{
+public:
+    explicit OverlayPool(SurfaceBackend& backend) : m_backend(backend) {}
+    ~OverlayPool();
+
+    OverlayPool(const OverlayPool&) = delete;
+    OverlayPool& operator=(const OverlayPool&) = delete;
+
+    // 拓扑变化通知到来时调用；下一次 Prepare/Show 时重新枚举显示器
+    void MarkTopologyDirty() { m_dirty = true; }
+    bool IsTopologyDirty() const { return m_dirty; }
+
+    // 按当前显示器准备遮罩；拓扑未变化时不做任何事。返回可用遮罩数
+    size_t Prepare();
+    size_t Prepare(const std::vector<MonitorInfo>& monitors);
+
+    // 与新的显示器集合做差异：不变的保留，移动或缩放的原地调整，
+    // 新增的创建（显示中则立即以当前透明度显示），多余的销毁
+    OverlayReconcileResult Reconcile(const std::vector<MonitorInfo>& monitors);
+
+    // 配置中的 OverlayRegions；与上次相同时不做任何事。格式错误时按整屏处理。
+    // 显示期间调用时立即更新各遮罩的形状，区域变空的遮罩隐藏
+    void SetRegionSpec(std::string_view spec);
+    // 遮罩当前的区域（相对显示器左上角）；不是池中的遮罩时返回 nullptr
+    const ScreenRegion* RegionOf(SurfaceHandle surface) const;
+
+    // 以给定透明度显示所有遮罩；skip 非空时跳过位于该显示器上的遮罩（前台全屏所在的显示器），
+    // 区域为空的遮罩也不显示。没有任何遮罩被显示时返回 false
+    bool Show(std::uint8_t alpha, const ScreenRect* skip = nullptr);
+    void Hide();
+    void DestroyAll();
+
+    void SetAlpha(std::uint8_t alpha);
+    void InvalidateAll();
+
+    bool IsVisible() const { return m_visible; }
+    std::uint8_t Alpha() const { return m_alpha; }
+    size_t Size() const { return m_slots.size(); }
+
+    template <typename Fn>
+    void ForEachSurface(Fn&& fn) const
+    {
+        for (const auto& slot : m_slots)
+        {
+            fn(slot.surface, slot.monitor);
+        }
+    }
+
+private:
+    struct Slot
+    {
+        MonitorInfo monitor;
+        SurfaceHandle surface;
+        ScreenRegion region;
+    };
+
+    bool IsSkipped(const Slot& slot) const { return slot.region.IsEmpty() || (m_hasSkip && slot.monitor.rect == m_skip); }
+    // 按当前规则重新计算第 index 个遮罩的区域，有变化时交给后端；返回区域是否变化
+    bool UpdateRegion(size_t index, Slot& slot);
+    // 显示期间：区域变空的遮罩隐藏，新出现的以当前透明度显示，区域变化的重绘
+    void ApplyVisibility(const Slot& slot, bool wasShown, bool changed);
+
+    SurfaceBackend& m_backend;
+    std::vector<Slot> m_slots;
+    std::vector<MonitorInfo> m_scratch;
+    std::vector<Slot> m_next;
+    std::vector<bool> m_matched;
+    std::string m_regionSpec;
+    std::vector<OverlayRegionRule> m_regionRules;
+    ScreenRegion m_regionScratch;
+    bool m_dirty = true;
+    bool m_visible = false;
+    bool m_hasSkip = false;
+    ScreenRect m_skip{};
+    std::uint8_t m_alpha = 0;
+};
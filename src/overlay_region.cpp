@@ -0,0 +1,166 @@
+#include "overlay_region.h"
+
+#include <climits>
+
+namespace
+{
+    std::string_view Trim(std::string_view s)
+    {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        {
+            s.remove_prefix(1);
+        }
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+        {
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+
+    bool ParseNumber(std::string_view s, int& out)
+    {
+        s = Trim(s);
+        bool negative = false;
+        if (!s.empty() && (s.front() == '-' || s.front() == '+'))
+        {
+            negative = s.front() == '-';
+            s.remove_prefix(1);
+        }
+        if (s.empty() || s.size() > 6)
+        {
+            return false;
+        }
+        int value = 0;
+        for (char ch : s)
+        {
+            if (ch < '0' || ch > '9')
+            {
+                return false;
+            }
+            value = value * 10 + (ch - '0');
+        }
+        out = negative ? -value : value;
+        return true;
+    }
+
+    bool ParseCoord(std::string_view s, OverlayRegionCoord& out)
+    {
+        s = Trim(s);
+        out.percent = !s.empty() && s.back() == '%';
+        if (out.percent)
+        {
+            s.remove_suffix(1);
+        }
+        return ParseNumber(s, out.value) && (!out.percent || (out.value >= 0 && out.value <= 100));
+    }
+
+    bool ParseRule(std::string_view s, OverlayRegionRule& rule)
+    {
+        const size_t colon = s.find(':');
+        if (colon == std::string_view::npos)
+        {
+            return false;
+        }
+        const std::string_view monitor = Trim(s.substr(0, colon));
+        if (monitor == "*")
+        {
+            rule.monitor = 0;
+        }
+        else if (!ParseNumber(monitor, rule.monitor) || rule.monitor < 1)
+        {
+            return false;
+        }
+
+        std::string_view rest = Trim(s.substr(colon + 1));
+        if (rest.empty() || (rest.front() != '+' && rest.front() != '-'))
+        {
+            return false;
+        }
+        rule.include = rest.front() == '+';
+        rest.remove_prefix(1);
+
+        OverlayRegionCoord* coords[4] = { &rule.left, &rule.top, &rule.right, &rule.bottom };
+        for (int i = 0; i < 4; i++)
+        {
+            const size_t comma = i < 3 ? rest.find(',') : rest.size();
+            if (comma == std::string_view::npos || !ParseCoord(rest.substr(0, comma), *coords[i]))
+            {
+                return false;
+            }
+            rest.remove_prefix(i < 3 ? comma + 1 : comma);
+        }
+        return true;
+    }
+
+    int Resolve(const OverlayRegionCoord& c, int extent)
+    {
+        return c.percent ? (int)((long long)extent * c.value / 100) : c.value;
+    }
+
+    ScreenRect ResolveRect(const OverlayRegionRule& rule, int width, int height)
+    {
+        return ScreenRect{ Resolve(rule.left, width), Resolve(rule.top, height), Resolve(rule.right, width), Resolve(rule.bottom, height) };
+    }
+}
+
+bool OverlayRegion_Parse(std::string_view spec, std::vector<OverlayRegionRule>& rules, std::wstring* error)
+{
+    rules.clear();
+    int index = 0;
+    while (!spec.empty())
+    {
+        const size_t semi = spec.find(';');
+        const std::string_view item = Trim(spec.substr(0, semi));
+        spec.remove_prefix(semi == std::string_view::npos ? spec.size() : semi + 1);
+        if (item.empty())
+        {
+            continue;
+        }
+        index++;
+        OverlayRegionRule rule;
+        if (!ParseRule(item, rule) || index > OVERLAY_REGION_MAX_RULES)
+        {
+            if (error)
+            {
+                *error = L"遮罩区域第 " + std::to_wstring(index) + L" 条规则格式不正确，应类似 *:-75%,0,100%,25%。";
+            }
+            rules.clear();
+            return false;
+        }
+        rules.push_back(rule);
+    }
+    return true;
+}
+
+void OverlayRegion_Build(const std::vector<OverlayRegionRule>& rules, size_t monitorIndex, int width, int height, ScreenRegion& out)
+{
+    const ScreenRegion monitor(ScreenRect{ 0, 0, width, height });
+    const int number = monitorIndex < (size_t)INT_MAX ? (int)monitorIndex + 1 : INT_MAX;
+
+    std::vector<ScreenRect> includes;
+    std::vector<ScreenRect> excludes;
+    for (const OverlayRegionRule& rule : rules)
+    {
+        if (rule.monitor != 0 && rule.monitor != number)
+        {
+            continue;
+        }
+        (rule.include ? includes : excludes).push_back(ResolveRect(rule, width, height));
+    }
+    if (includes.empty())
+    {
+        out = monitor;
+    }
+    else
+    {
+        // 面积为 0 的包含规则同样生效，用来整个关闭某个显示器
+        Region_FromRects(includes.data(), includes.size(), out);
+        Region_Intersect(out, monitor, out);
+    }
+    if (!excludes.empty())
+    {
+        ScreenRegion holes;
+        Region_FromRects(excludes.data(), excludes.size(), holes);
+        Region_Subtract(out, holes, out);
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "screen_region.h"
+
+// 遮罩只覆盖显示器的一部分：ini 中 OverlayRegions 的每条规则以分号分隔，
+//   <显示器>:<+|-><左>,<上>,<右>,<下>
+// 显示器为 1 起的序号（与枚举顺序一致）或 * 表示所有显示器；+ 为包含、- 为排除；
+// 坐标相对显示器左上角，单位为像素或带 % 的显示器宽高百分比。例如
+//   *:-75%,0,100%,25%        每个显示器右上角留出一块给视频会议窗口
+//   2:+0,0,0,0               第 2 个显示器不显示遮罩
+// 某个显示器没有包含规则时从整个显示器开始，有则从包含规则的并集开始，再减去排除规则。
+struct OverlayRegionCoord
+{
+    int value = 0;
+    bool percent = false;
+};
+
+struct OverlayRegionRule
+{
+    int monitor = 0;    // 0 为所有显示器，否则为 1 起的序号
+    bool include = true;
+    OverlayRegionCoord left;
+    OverlayRegionCoord top;
+    OverlayRegionCoord right;
+    OverlayRegionCoord bottom;
+};
+
+constexpr int OVERLAY_REGION_MAX_RULES = 512;
+
+// 空串得到空规则表（整屏显示）；格式错误时返回 false 并在 error 中说明是第几条
+bool OverlayRegion_Parse(std::string_view spec, std::vector<OverlayRegionRule>& rules, std::wstring* error = nullptr);
+
+// 第 monitorIndex 个（0 起）显示器上的区域，坐标相对显示器左上角
+void OverlayRegion_Build(const std::vector<OverlayRegionRule>& rules, size_t monitorIndex, int width, int height, ScreenRegion& out);
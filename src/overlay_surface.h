@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct ScreenRect
+{
+    int left = 0;
+    int top = 0;
+    int right = 0;
+    int bottom = 0;
+
+    int Width() const { return right - left; }
+    int Height() const { return bottom - top; }
+};
+
+inline bool operator==(const ScreenRect& a, const ScreenRect& b)
+{
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+inline bool operator!=(const ScreenRect& a, const ScreenRect& b)
+{
+    return !(a == b);
+}
+
+struct MonitorInfo
+{
+    ScreenRect rect;
+    int dpi = 96;
+};
+
+inline bool operator==(const MonitorInfo& a, const MonitorInfo& b)
+{
+    return a.rect == b.rect && a.dpi == b.dpi;
+}
+
+using SurfaceHandle = std::uintptr_t;
+
+class ScreenRegion;
+
+// 遮罩窗口的平台抽象：Win32 使用分层窗口，测试与基准使用无界面实现
+class SurfaceBackend
+{
+public:
+    virtual ~SurfaceBackend() = default;
+
+    virtual void EnumMonitors(std::vector<MonitorInfo>& out) = 0;
+
+    // 创建隐藏的、已配置好的遮罩；失败返回 0
+    virtual SurfaceHandle Create(const MonitorInfo& monitor) = 0;
+    virtual void Destroy(SurfaceHandle surface) = 0;
+    // 显示器移动、改分辨率或 DPI 后把已有遮罩挪过去并重新排版，保持可见性与透明度
+    virtual void Reposition(SurfaceHandle surface, const MonitorInfo& monitor) = 0;
+
+    virtual void Show(SurfaceHandle surface) = 0;
+    virtual void Hide(SurfaceHandle surface) = 0;
+    virtual void SetAlpha(SurfaceHandle surface, std::uint8_t alpha) = 0;
+    // 只重绘区域内的部分
+    virtual void Invalidate(SurfaceHandle surface) = 0;
+    // 遮罩只在 region 内可见（坐标相对显示器左上角），合成、填充与重绘都限于其中；
+    // region 正好是整个显示器时取消形状。新建的遮罩覆盖整个显示器，池不会传入空区域
+    virtual void SetRegion(SurfaceHandle surface, const ScreenRegion& region) = 0;
+};
@@ -0,0 +1,38 @@
+#include "presence.h"
+
+bool PresenceTracker::Set(PresenceReason reason, bool active, std::uint64_t nowMs)
+{
+    m_stats.notifications++;
+    const std::uint8_t next = active ? (std::uint8_t)(m_reasons | reason) : (std::uint8_t)(m_reasons & ~reason);
+    if (next == m_reasons)
+    {
+        m_stats.redundant++;
+        return false;
+    }
+    const bool wasPresent = m_reasons == 0;
+    m_reasons = next;
+    if (wasPresent)
+    {
+        m_absentSinceMs = nowMs;
+        m_stats.absences++;
+        return true;
+    }
+    if (m_reasons == 0)
+    {
+        m_lastAwayMs = nowMs >= m_absentSinceMs ? nowMs - m_absentSinceMs : 0;
+        m_stats.awayMs += m_lastAwayMs;
+        return true;
+    }
+    return false;
+}
+
+const char* Presence_ReasonName(PresenceReason reason)
+{
+    switch (reason)
+    {
+    case PRESENCE_LOCKED: return "locked";
+    case PRESENCE_DISCONNECTED: return "disconnected";
+    case PRESENCE_DISPLAY_OFF: return "display_off";
+    }
+    return "unknown";
+}
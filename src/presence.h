@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// 用户是否在场：锁屏、远程会话断开、显示器关闭任一成立即视为离开。
+// 离开期间暂停计时与绘制，回来时离开的时间按休息计算（见 OverlayEngine::OnPresence）。
+
+enum PresenceReason : std::uint8_t
+{
+    PRESENCE_LOCKED = 1u << 0,
+    PRESENCE_DISCONNECTED = 1u << 1,
+    PRESENCE_DISPLAY_OFF = 1u << 2,
+};
+
+struct PresenceStats
+{
+    std::uint64_t absences = 0;
+    std::uint64_t awayMs = 0;       // 已结束的离开时长合计
+    std::uint64_t notifications = 0;
+    std::uint64_t redundant = 0;    // 没有改变任何原因的通知（例如重复的显示器状态）
+};
+
+// 把各来源的通知合并成一个“在场 / 离开”状态；各原因独立置位与清除，
+// 例如锁屏后显示器关闭、显示器先亮起，直到解锁才算回来。
+// Win32 下由会话与电源通知驱动，模拟与测试中由调用方直接驱动
+class PresenceTracker
+{
+public:
+    // 返回在场状态是否因此改变
+    bool Set(PresenceReason reason, bool active, std::uint64_t nowMs);
+
+    bool IsPresent() const { return m_reasons == 0; }
+    std::uint8_t Reasons() const { return m_reasons; }
+    std::uint64_t AbsentSinceMs() const { return m_absentSinceMs; }
+    // 最近一次回来时结束的那段离开时长
+    std::uint64_t LastAwayMs() const { return m_lastAwayMs; }
+    const PresenceStats& Stats() const { return m_stats; }
+
+private:
+    std::uint8_t m_reasons = 0;
+    std::uint64_t m_absentSinceMs = 0;
+    std::uint64_t m_lastAwayMs = 0;
+    PresenceStats m_stats{};
+};
+
+const char* Presence_ReasonName(PresenceReason reason);
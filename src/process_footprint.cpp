@@ -0,0 +1,116 @@
+#include "process_footprint.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#endif
+
+#ifdef _WIN32
+
+bool ProcessFootprint_Read(long pid, ProcessFootprint& out)
+{
+    out = ProcessFootprint{};
+    HANDLE process = pid == 0 ? GetCurrentProcess() : OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)pid);
+    if (!process)
+    {
+        return false;
+    }
+    PROCESS_MEMORY_COUNTERS_EX counters{};
+    counters.cb = sizeof(counters);
+    const bool ok = K32GetProcessMemoryInfo(process, reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)) != FALSE;
+    if (pid != 0)
+    {
+        CloseHandle(process);
+    }
+    if (!ok)
+    {
+        return false;
+    }
+    out.rssBytes = counters.WorkingSetSize;
+    out.pssBytes = counters.WorkingSetSize;
+    out.privateBytes = counters.PrivateUsage < counters.WorkingSetSize ? counters.PrivateUsage : counters.WorkingSetSize;
+    out.sharedBytes = counters.WorkingSetSize - out.privateBytes;
+    return true;
+}
+
+bool ProcessHandles_ReadSelf(ProcessHandles& out)
+{
+    out = ProcessHandles{};
+    HANDLE process = GetCurrentProcess();
+    out.gdiObjects = GetGuiResources(process, GR_GDIOBJECTS);
+    out.userObjects = GetGuiResources(process, GR_USEROBJECTS);
+    DWORD handles = 0;
+    if (GetProcessHandleCount(process, &handles))
+    {
+        out.handles = handles;
+    }
+    return true;
+}
+
+void ProcessFootprint_Trim()
+{
+    HeapCompact(GetProcessHeap(), 0);
+    SetProcessWorkingSetSize(GetCurrentProcess(), (SIZE_T)-1, (SIZE_T)-1);
+}
+
+#else
+
+bool ProcessFootprint_Read(long pid, ProcessFootprint& out)
+{
+    out = ProcessFootprint{};
+    const std::string path = pid == 0 ? std::string("/proc/self/smaps_rollup") : "/proc/" + std::to_string(pid) + "/smaps_rollup";
+    std::FILE* f = std::fopen(path.c_str(), "r");
+    if (!f)
+    {
+        return false;
+    }
+    char line[256];
+    bool any = false;
+    while (std::fgets(line, sizeof(line), f))
+    {
+        char name[64];
+        unsigned long long kb = 0;
+        if (std::sscanf(line, "%63[^:]: %llu kB", name, &kb) != 2)
+        {
+            continue;
+        }
+        const std::uint64_t bytes = (std::uint64_t)kb * 1024;
+        if (std::strcmp(name, "Rss") == 0) { out.rssBytes = bytes; any = true; }
+        else if (std::strcmp(name, "Pss") == 0) out.pssBytes = bytes;
+        else if (std::strcmp(name, "Shared_Clean") == 0 || std::strcmp(name, "Shared_Dirty") == 0) out.sharedBytes += bytes;
+        else if (std::strcmp(name, "Private_Clean") == 0 || std::strcmp(name, "Private_Dirty") == 0) out.privateBytes += bytes;
+    }
+    std::fclose(f);
+    return any;
+}
+
+bool ProcessHandles_ReadSelf(ProcessHandles& out)
+{
+    out = ProcessHandles{};
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it("/proc/self/fd", ec), end; !ec && it != end; it.increment(ec))
+    {
+        out.handles++;
+    }
+#if defined(__GLIBC__)
+    out.heapBytes = mallinfo2().uordblks;
+#endif
+    return !ec;
+}
+
+void ProcessFootprint_Trim()
+{
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// 进程内存占用，区分本进程独占与和其他进程共享的部分。
+// Linux 读 /proc/<pid>/smaps_rollup；Windows 读工作集与私有提交量（shared = 工作集 - 私有，近似值）
+struct ProcessFootprint
+{
+    std::uint64_t rssBytes = 0;
+    std::uint64_t pssBytes = 0;      // 共享页按映射进程数均摊；Windows 上等于 rssBytes
+    std::uint64_t privateBytes = 0;
+    std::uint64_t sharedBytes = 0;
+};
+
+// pid 为 0 时读取当前进程
+bool ProcessFootprint_Read(long pid, ProcessFootprint& out);
+
+// 句柄与堆占用，用来发现长时间运行后的缓慢增长；平台不支持的项为 0
+struct ProcessHandles
+{
+    std::uint32_t gdiObjects = 0;    // Windows
+    std::uint32_t userObjects = 0;   // Windows
+    std::uint32_t handles = 0;       // Windows 内核句柄；Linux 打开的文件描述符
+    std::uint64_t heapBytes = 0;     // glibc 堆中正在使用的字节
+};
+
+bool ProcessHandles_ReadSelf(ProcessHandles& out);
+
+// 把空闲的堆内存还给系统（glibc malloc_trim；Windows 压缩进程堆并清空工作集）。
+// 在提醒结束后调用，两次提醒之间进程保持在最小的常驻内存
+void ProcessFootprint_Trim();
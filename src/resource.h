@@ -16,3 +16,5 @@
 #define IDC_PREVIEW             50009
 #define IDC_SAVE                50010
 #define IDC_AUTOSTART_CHECK     50011
+#define IDC_PREVIEW_THUMB       50012
+#define IDC_FULLSCREEN_COMBO    50013
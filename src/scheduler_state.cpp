@@ -0,0 +1,159 @@
+#include "scheduler_state.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+    struct StateHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t slotSize;
+        std::uint32_t reserved;
+    };
+
+    struct StateSlot
+    {
+        std::uint64_t sequence;
+        std::uint64_t deadlineUnixMs;
+        std::uint64_t lastBreakUnixMs;
+        std::uint64_t savedUnixMs;
+        std::uint32_t intervalMinutes;
+        std::uint32_t pendingSnoozeMinutes;
+        std::uint32_t checksum;
+        std::uint8_t pad[SCHEDULER_STATE_SLOT_SIZE - 44];
+    };
+
+    static_assert(sizeof(StateHeader) == 16, "header layout");
+    static_assert(sizeof(StateSlot) == SCHEDULER_STATE_SLOT_SIZE, "slot layout");
+
+    // FNV-1a，覆盖校验字段之前的全部字节
+    std::uint32_t SlotChecksum(const StateSlot& slot)
+    {
+        const auto* p = reinterpret_cast<const std::uint8_t*>(&slot);
+        std::uint32_t hash = 0x811C9DC5u;
+        for (size_t i = 0; i < offsetof(StateSlot, checksum); i++)
+        {
+            hash ^= p[i];
+            hash *= 0x01000193u;
+        }
+        return hash;
+    }
+
+    bool HeaderValid(const std::uint8_t* data, size_t size)
+    {
+        if (size < SCHEDULER_STATE_FILE_SIZE)
+        {
+            return false;
+        }
+        StateHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        return header.magic == SCHEDULER_STATE_MAGIC && header.version == SCHEDULER_STATE_VERSION && header.slotSize == SCHEDULER_STATE_SLOT_SIZE;
+    }
+
+    std::uint8_t* SlotAt(std::uint8_t* data, std::uint64_t sequence)
+    {
+        return data + sizeof(StateHeader) + (size_t)(sequence % 2) * SCHEDULER_STATE_SLOT_SIZE;
+    }
+}
+
+bool SchedulerState_Parse(const std::uint8_t* data, size_t size, SchedulerStateRecord& out, std::uint64_t& sequence)
+{
+    sequence = 0;
+    if (!data || !HeaderValid(data, size))
+    {
+        return false;
+    }
+    bool found = false;
+    for (size_t i = 0; i < 2; i++)
+    {
+        StateSlot slot;
+        std::memcpy(&slot, data + sizeof(StateHeader) + i * SCHEDULER_STATE_SLOT_SIZE, sizeof(slot));
+        // 序号 0 表示从未写过；序号必须与槽位对应，防止整槽被错位拷贝
+        if (slot.sequence == 0 || slot.sequence % 2 != i || slot.checksum != SlotChecksum(slot))
+        {
+            continue;
+        }
+        if (!found || slot.sequence > sequence)
+        {
+            found = true;
+            sequence = slot.sequence;
+            out.deadlineUnixMs = slot.deadlineUnixMs;
+            out.lastBreakUnixMs = slot.lastBreakUnixMs;
+            out.savedUnixMs = slot.savedUnixMs;
+            out.intervalMinutes = slot.intervalMinutes;
+            out.pendingSnoozeMinutes = slot.pendingSnoozeMinutes;
+        }
+    }
+    return found;
+}
+
+bool SchedulerStateFile::Open(const std::filesystem::path& path, SchedulerStateRecord& out)
+{
+    Close();
+    if (!m_file.OpenReadWrite(path, SCHEDULER_STATE_FILE_SIZE))
+    {
+        return false;
+    }
+    std::uint8_t* data = m_file.writable_data();
+    if (!HeaderValid(data, m_file.size()))
+    {
+        // 新文件或格式不对：整个重写，两个槽位都作废
+        StateHeader header{ SCHEDULER_STATE_MAGIC, SCHEDULER_STATE_VERSION, (std::uint32_t)SCHEDULER_STATE_SLOT_SIZE, 0 };
+        std::memset(data, 0, SCHEDULER_STATE_FILE_SIZE);
+        std::memcpy(data, &header, sizeof(header));
+        return false;
+    }
+    return SchedulerState_Parse(data, m_file.size(), out, m_sequence);
+}
+
+void SchedulerStateFile::Close()
+{
+    m_file.Close();
+    m_sequence = 0;
+}
+
+bool SchedulerStateFile::Save(const SchedulerStateRecord& record)
+{
+    std::uint8_t* data = m_file.writable_data();
+    if (!data)
+    {
+        return false;
+    }
+    StateSlot slot{};
+    slot.sequence = m_sequence + 1;
+    slot.deadlineUnixMs = record.deadlineUnixMs;
+    slot.lastBreakUnixMs = record.lastBreakUnixMs;
+    slot.savedUnixMs = record.savedUnixMs;
+    slot.intervalMinutes = record.intervalMinutes;
+    slot.pendingSnoozeMinutes = record.pendingSnoozeMinutes;
+    slot.checksum = SlotChecksum(slot);
+    std::memcpy(SlotAt(data, slot.sequence), &slot, sizeof(slot));
+    m_sequence = slot.sequence;
+    m_saves++;
+    return true;
+}
+
+std::uint32_t SchedulerState_ResumeDelayMs(const SchedulerStateRecord& record, std::uint64_t nowUnixMs, std::uint32_t intervalMinutes)
+{
+    const std::uint64_t intervalMs = (std::uint64_t)std::max<std::uint32_t>(intervalMinutes, 1) * 60u * 1000u;
+    if (record.pendingSnoozeMinutes != 0 && nowUnixMs >= record.savedUnixMs && nowUnixMs - record.savedUnixMs < intervalMs)
+    {
+        return std::min<std::uint32_t>(record.pendingSnoozeMinutes, 24 * 60) * 60u * 1000u;
+    }
+    if (record.deadlineUnixMs == 0)
+    {
+        return 0;
+    }
+    if (record.deadlineUnixMs > nowUnixMs)
+    {
+        return (std::uint32_t)std::max<std::uint64_t>(1, std::min(record.deadlineUnixMs - nowUnixMs, intervalMs));
+    }
+    if (nowUnixMs - record.deadlineUnixMs < intervalMs)
+    {
+        return SCHEDULER_RESUME_GRACE_MS;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "mapped_file.h"
+
+// 调度状态持久化：崩溃、更新或注销后重新启动时接着上次的倒计时，而不是从头计时。
+// 文件 = 16 字节头 + 两个 64 字节槽位；每次写入序号较旧的槽位，并带 FNV-1a 校验，
+// 写到一半被杀掉时读取方校验失败，退回另一个槽位。写入只是对映射内存的拷贝，不做系统调用。
+
+struct SchedulerStateRecord
+{
+    std::uint64_t deadlineUnixMs = 0;       // 下一次提醒的绝对时间；0 表示没有进行中的计时
+    std::uint64_t lastBreakUnixMs = 0;      // 上一次（非预览）提醒结束的时间
+    std::uint64_t savedUnixMs = 0;
+    std::uint32_t intervalMinutes = 0;      // 写入时的提醒间隔
+    std::uint32_t pendingSnoozeMinutes = 0; // 已请求、尚未生效的稍后提醒
+};
+
+constexpr std::uint32_t SCHEDULER_STATE_MAGIC = 0x54525353; // "SSRT"
+constexpr std::uint32_t SCHEDULER_STATE_VERSION = 1;
+constexpr size_t SCHEDULER_STATE_SLOT_SIZE = 64;
+constexpr size_t SCHEDULER_STATE_FILE_SIZE = 16 + SCHEDULER_STATE_SLOT_SIZE * 2;
+
+class SchedulerStateFile
+{
+public:
+    // 打开（不存在则创建）并读取一次；读到有效记录时返回 true
+    bool Open(const std::filesystem::path& path, SchedulerStateRecord& out);
+    void Close();
+
+    bool IsOpen() const { return m_file.writable_data() != nullptr; }
+
+    // 写入较旧的槽位后才递增序号，之前的记录在写完之前一直有效
+    bool Save(const SchedulerStateRecord& record);
+
+    std::uint64_t Sequence() const { return m_sequence; }
+    std::uint64_t Saves() const { return m_saves; }
+
+private:
+    MappedFile m_file;
+    std::uint64_t m_sequence = 0;
+    std::uint64_t m_saves = 0;
+};
+
+// 从内存中的文件内容解析出序号最大的有效记录
+bool SchedulerState_Parse(const std::uint8_t* data, size_t size, SchedulerStateRecord& out, std::uint64_t& sequence);
+
+constexpr std::uint32_t SCHEDULER_RESUME_GRACE_MS = 30 * 1000;
+
+// 启动时第一次计时的时长（毫秒）；返回 0 表示按完整间隔重新计时。
+//   有待生效的稍后提醒且写入后不足一个间隔 → 按稍后提醒的分钟数
+//   截止时间在未来 → 剩余时间，最多一个当前间隔（间隔改短或系统时钟回拨时）
+//   已过期但不足一个间隔 → 稍等 SCHEDULER_RESUME_GRACE_MS 后提醒
+//   过期超过一个间隔 → 离开的时间已经算作休息，重新计时
+std::uint32_t SchedulerState_ResumeDelayMs(const SchedulerStateRecord& record, std::uint64_t nowUnixMs, std::uint32_t intervalMinutes);
@@ -0,0 +1,446 @@
+#include "screen_region.h"
+
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+namespace
+{
+    constexpr size_t NO_BAND = (size_t)-1;
+
+    // [begin, 返回值) 为同一带
+    size_t BandEnd(const std::vector<ScreenRect>& rects, size_t begin)
+    {
+        size_t end = begin + 1;
+        while (end < rects.size() && rects[end].top == rects[begin].top)
+        {
+            end++;
+        }
+        return end;
+    }
+
+    // 按 y 递增逐带输出结果；带内跨度按 x 递增给出，相接或重叠的跨度合并，
+    // 与上一带相接且跨度完全相同的带并入上一带
+    class BandWriter
+    {
+    public:
+        explicit BandWriter(std::vector<ScreenRect>& out) : m_out(out) {}
+
+        void Begin(int top, int bottom)
+        {
+            m_bandStart = m_out.size();
+            m_top = top;
+            m_bottom = bottom;
+        }
+
+        void Span(int left, int right)
+        {
+            if (left >= right)
+            {
+                return;
+            }
+            if (m_out.size() > m_bandStart && m_out.back().right >= left)
+            {
+                m_out.back().right = std::max(m_out.back().right, right);
+                return;
+            }
+            m_out.push_back(ScreenRect{ left, m_top, right, m_bottom });
+        }
+
+        void End()
+        {
+            const size_t count = m_out.size() - m_bandStart;
+            if (count == 0)
+            {
+                return;
+            }
+            if (m_prevStart != NO_BAND && m_bandStart - m_prevStart == count && m_out[m_prevStart].bottom == m_top)
+            {
+                bool same = true;
+                for (size_t i = 0; i < count && same; i++)
+                {
+                    same = m_out[m_prevStart + i].left == m_out[m_bandStart + i].left &&
+                        m_out[m_prevStart + i].right == m_out[m_bandStart + i].right;
+                }
+                if (same)
+                {
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        m_out[m_prevStart + i].bottom = m_bottom;
+                    }
+                    m_out.resize(m_bandStart);
+                    return;
+                }
+            }
+            m_prevStart = m_bandStart;
+        }
+
+        // 一个区域独有的部分：原样复制这一带的跨度
+        void Copy(const std::vector<ScreenRect>& src, size_t begin, size_t end, int top, int bottom)
+        {
+            Begin(top, bottom);
+            for (size_t i = begin; i < end; i++)
+            {
+                Span(src[i].left, src[i].right);
+            }
+            End();
+        }
+
+    private:
+        std::vector<ScreenRect>& m_out;
+        size_t m_bandStart = 0;
+        size_t m_prevStart = NO_BAND;
+        int m_top = 0;
+        int m_bottom = 0;
+    };
+
+    void UnionSpans(BandWriter& w, const ScreenRect* a, size_t na, const ScreenRect* b, size_t nb)
+    {
+        size_t i = 0;
+        size_t j = 0;
+        while (i < na || j < nb)
+        {
+            if (j == nb || (i < na && a[i].left <= b[j].left))
+            {
+                w.Span(a[i].left, a[i].right);
+                i++;
+            }
+            else
+            {
+                w.Span(b[j].left, b[j].right);
+                j++;
+            }
+        }
+    }
+
+    void IntersectSpans(BandWriter& w, const ScreenRect* a, size_t na, const ScreenRect* b, size_t nb)
+    {
+        size_t i = 0;
+        size_t j = 0;
+        while (i < na && j < nb)
+        {
+            w.Span(std::max(a[i].left, b[j].left), std::min(a[i].right, b[j].right));
+            if (a[i].right < b[j].right)
+            {
+                i++;
+            }
+            else
+            {
+                j++;
+            }
+        }
+    }
+
+    void SubtractSpans(BandWriter& w, const ScreenRect* a, size_t na, const ScreenRect* b, size_t nb)
+    {
+        size_t j = 0;
+        for (size_t i = 0; i < na; i++)
+        {
+            int left = a[i].left;
+            const int right = a[i].right;
+            while (j < nb && b[j].right <= left)
+            {
+                j++;
+            }
+            // b 的跨度可能跨过 a 的下一个跨度，这里不前移 j
+            for (size_t k = j; k < nb && b[k].left < right && left < right; k++)
+            {
+                w.Span(left, b[k].left);
+                left = std::max(left, b[k].right);
+            }
+            w.Span(left, right);
+        }
+    }
+
+    bool Overlaps(const ScreenRect& a, const ScreenRect& b)
+    {
+        return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+    }
+
+    void CombineBands(const std::vector<ScreenRect>& a, const std::vector<ScreenRect>& b, RegionOp op, std::vector<ScreenRect>& out)
+    {
+        BandWriter w(out);
+        size_t ia = 0;
+        size_t ib = 0;
+        size_t aEnd = a.empty() ? 0 : BandEnd(a, 0);
+        size_t bEnd = b.empty() ? 0 : BandEnd(b, 0);
+        // y 以上的部分已经输出
+        int y = INT_MIN;
+        while (ia < a.size() && ib < b.size())
+        {
+            const int aTop = std::max(a[ia].top, y);
+            const int bTop = std::max(b[ib].top, y);
+            const int aBottom = a[ia].bottom;
+            const int bBottom = b[ib].bottom;
+            if (aTop < bTop)
+            {
+                y = std::min(aBottom, bTop);
+                if (op != RegionOp::Intersect)
+                {
+                    w.Copy(a, ia, aEnd, aTop, y);
+                }
+            }
+            else if (bTop < aTop)
+            {
+                y = std::min(bBottom, aTop);
+                if (op == RegionOp::Union)
+                {
+                    w.Copy(b, ib, bEnd, bTop, y);
+                }
+            }
+            else
+            {
+                y = std::min(aBottom, bBottom);
+                w.Begin(aTop, y);
+                switch (op)
+                {
+                case RegionOp::Union: UnionSpans(w, &a[ia], aEnd - ia, &b[ib], bEnd - ib); break;
+                case RegionOp::Intersect: IntersectSpans(w, &a[ia], aEnd - ia, &b[ib], bEnd - ib); break;
+                case RegionOp::Subtract: SubtractSpans(w, &a[ia], aEnd - ia, &b[ib], bEnd - ib); break;
+                }
+                w.End();
+            }
+            if (aBottom <= y)
+            {
+                ia = aEnd;
+                aEnd = ia < a.size() ? BandEnd(a, ia) : ia;
+            }
+            if (bBottom <= y)
+            {
+                ib = bEnd;
+                bEnd = ib < b.size() ? BandEnd(b, ib) : ib;
+            }
+        }
+        // 只剩一边：并集与差集保留 a 的剩余部分，并集还保留 b 的剩余部分
+        if (op != RegionOp::Intersect)
+        {
+            for (; ia < a.size(); ia = aEnd, aEnd = ia < a.size() ? BandEnd(a, ia) : ia)
+            {
+                w.Copy(a, ia, aEnd, std::max(a[ia].top, y), a[ia].bottom);
+            }
+        }
+        if (op == RegionOp::Union)
+        {
+            for (; ib < b.size(); ib = bEnd, bEnd = ib < b.size() ? BandEnd(b, ib) : ib)
+            {
+                w.Copy(b, ib, bEnd, std::max(b[ib].top, y), b[ib].bottom);
+            }
+        }
+    }
+}
+
+void ScreenRegion::Clear()
+{
+    m_rects.clear();
+    m_bounds = ScreenRect{};
+}
+
+void ScreenRegion::Reset(const ScreenRect& rect)
+{
+    m_rects.clear();
+    if (rect.left < rect.right && rect.top < rect.bottom)
+    {
+        m_rects.push_back(rect);
+        m_bounds = rect;
+    }
+    else
+    {
+        m_bounds = ScreenRect{};
+    }
+}
+
+void ScreenRegion::UpdateBounds()
+{
+    if (m_rects.empty())
+    {
+        m_bounds = ScreenRect{};
+        return;
+    }
+    m_bounds = ScreenRect{ INT_MAX, m_rects.front().top, INT_MIN, m_rects.back().bottom };
+    for (const ScreenRect& r : m_rects)
+    {
+        m_bounds.left = std::min(m_bounds.left, r.left);
+        m_bounds.right = std::max(m_bounds.right, r.right);
+    }
+}
+
+long long ScreenRegion::Area() const
+{
+    long long area = 0;
+    for (const ScreenRect& r : m_rects)
+    {
+        area += (long long)r.Width() * r.Height();
+    }
+    return area;
+}
+
+bool ScreenRegion::Contains(int x, int y) const
+{
+    // 各带的下边随 y 递增，二分找到第一个下边在 y 之下的带
+    auto it = std::partition_point(m_rects.begin(), m_rects.end(), [y](const ScreenRect& r) { return r.bottom <= y; });
+    if (it == m_rects.end() || it->top > y)
+    {
+        return false;
+    }
+    for (const int top = it->top; it != m_rects.end() && it->top == top && it->left <= x; ++it)
+    {
+        if (x < it->right)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ScreenRegion::Translate(int dx, int dy)
+{
+    for (ScreenRect& r : m_rects)
+    {
+        r.left += dx;
+        r.right += dx;
+        r.top += dy;
+        r.bottom += dy;
+    }
+    if (!m_rects.empty())
+    {
+        m_bounds = ScreenRect{ m_bounds.left + dx, m_bounds.top + dy, m_bounds.right + dx, m_bounds.bottom + dy };
+    }
+}
+
+bool ScreenRegion::IsCanonical() const
+{
+    size_t prevStart = NO_BAND;
+    size_t start = 0;
+    while (start < m_rects.size())
+    {
+        const size_t end = BandEnd(m_rects, start);
+        for (size_t i = start; i < end; i++)
+        {
+            const ScreenRect& r = m_rects[i];
+            if (r.left >= r.right || r.top >= r.bottom || r.bottom != m_rects[start].bottom)
+            {
+                return false;
+            }
+            if (i > start && m_rects[i - 1].right >= r.left)
+            {
+                return false;
+            }
+        }
+        if (prevStart != NO_BAND)
+        {
+            const ScreenRect& prev = m_rects[prevStart];
+            if (prev.bottom > m_rects[start].top)
+            {
+                return false;
+            }
+            if (prev.bottom == m_rects[start].top && start - prevStart == end - start)
+            {
+                bool same = true;
+                for (size_t i = 0; i < end - start && same; i++)
+                {
+                    same = m_rects[prevStart + i].left == m_rects[start + i].left && m_rects[prevStart + i].right == m_rects[start + i].right;
+                }
+                if (same)
+                {
+                    return false;
+                }
+            }
+        }
+        prevStart = start;
+        start = end;
+    }
+    ScreenRegion copy;
+    copy.m_rects = m_rects;
+    copy.UpdateBounds();
+    return copy.m_bounds == m_bounds;
+}
+
+void Region_Combine(const ScreenRegion& a, const ScreenRegion& b, RegionOp op, ScreenRegion& out)
+{
+    // 一边为空或外框不相交时不必逐带合并
+    if (a.IsEmpty() || b.IsEmpty() || !Overlaps(a.m_bounds, b.m_bounds))
+    {
+        if (op == RegionOp::Intersect)
+        {
+            out.Clear();
+        }
+        else if (op == RegionOp::Subtract || b.IsEmpty())
+        {
+            if (&out != &a)
+            {
+                out = a;
+            }
+        }
+        else if (a.IsEmpty())
+        {
+            if (&out != &b)
+            {
+                out = b;
+            }
+        }
+        else
+        {
+            // 外框不相交的并集仍要按带交错
+            std::vector<ScreenRect> rects;
+            CombineBands(a.m_rects, b.m_rects, op, rects);
+            out.m_rects = std::move(rects);
+            out.UpdateBounds();
+        }
+        return;
+    }
+    if (op == RegionOp::Intersect && a.IsRect() && b.IsRect())
+    {
+        const ScreenRect& ra = a.m_rects[0];
+        const ScreenRect& rb = b.m_rects[0];
+        out.Reset(ScreenRect{ std::max(ra.left, rb.left), std::max(ra.top, rb.top), std::min(ra.right, rb.right), std::min(ra.bottom, rb.bottom) });
+        return;
+    }
+
+    if (&out != &a && &out != &b)
+    {
+        out.m_rects.clear();
+        CombineBands(a.m_rects, b.m_rects, op, out.m_rects);
+    }
+    else
+    {
+        std::vector<ScreenRect> rects;
+        rects.reserve(a.m_rects.size() + b.m_rects.size());
+        CombineBands(a.m_rects, b.m_rects, op, rects);
+        out.m_rects = std::move(rects);
+    }
+    out.UpdateBounds();
+}
+
+void Region_FromRects(const ScreenRect* rects, size_t count, ScreenRegion& out)
+{
+    std::vector<ScreenRegion> level;
+    level.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (rects[i].left < rects[i].right && rects[i].top < rects[i].bottom)
+        {
+            level.emplace_back(rects[i]);
+        }
+    }
+    while (level.size() > 1)
+    {
+        size_t next = 0;
+        for (size_t i = 0; i + 1 < level.size(); i += 2)
+        {
+            Region_Union(level[i], level[i + 1], level[next++]);
+        }
+        if (level.size() % 2 != 0)
+        {
+            level[next++] = std::move(level.back());
+        }
+        level.resize(next);
+    }
+    if (level.empty())
+    {
+        out.Clear();
+    }
+    else
+    {
+        out = std::move(level[0]);
+    }
+}
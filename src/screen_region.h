@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "overlay_surface.h"
+
+enum class RegionOp : int
+{
+    Union = 0,
+    Intersect = 1,
+    Subtract = 2,   // a - b
+};
+
+// 由矩形组成的区域，按 X11/pixman 的 y-x 分带方式保存：
+// 每一带内的矩形上下边相同、按 x 排序且互不接触；各带按 y 排序互不重叠，
+// 相邻且横向跨度完全相同的带合并成一带。这样的矩形列表可以直接交给
+// SetWindowRgn（ExtCreateRegion）与 XShapeCombineRectangles（YXBanded）。
+class ScreenRegion
+{
+public:
+    ScreenRegion() = default;
+    explicit ScreenRegion(const ScreenRect& rect) { Reset(rect); }
+
+    void Clear();
+    // 空矩形得到空区域
+    void Reset(const ScreenRect& rect);
+
+    bool IsEmpty() const { return m_rects.empty(); }
+    // 区域正好是一个矩形
+    bool IsRect() const { return m_rects.size() == 1; }
+    bool IsExactly(const ScreenRect& rect) const { return m_rects.size() == 1 && m_rects[0] == rect; }
+    const std::vector<ScreenRect>& Rects() const { return m_rects; }
+    const ScreenRect& Bounds() const { return m_bounds; }
+    long long Area() const;
+    bool Contains(int x, int y) const;
+    void Translate(int dx, int dy);
+
+    // 检查分带、排序与合并是否都满足上面的约定（基准测试核对用）
+    bool IsCanonical() const;
+
+private:
+    friend void Region_Combine(const ScreenRegion& a, const ScreenRegion& b, RegionOp op, ScreenRegion& out);
+
+    void UpdateBounds();
+
+    std::vector<ScreenRect> m_rects;
+    ScreenRect m_bounds{};
+};
+
+inline bool operator==(const ScreenRegion& a, const ScreenRegion& b)
+{
+    return a.Rects() == b.Rects();
+}
+
+inline bool operator!=(const ScreenRegion& a, const ScreenRegion& b)
+{
+    return !(a == b);
+}
+
+// 逐带合并两个区域。out 可以与 a 或 b 是同一个对象
+void Region_Combine(const ScreenRegion& a, const ScreenRegion& b, RegionOp op, ScreenRegion& out);
+
+inline void Region_Union(const ScreenRegion& a, const ScreenRegion& b, ScreenRegion& out)
+{
+    Region_Combine(a, b, RegionOp::Union, out);
+}
+
+inline void Region_Intersect(const ScreenRegion& a, const ScreenRegion& b, ScreenRegion& out)
+{
+    Region_Combine(a, b, RegionOp::Intersect, out);
+}
+
+inline void Region_Subtract(const ScreenRegion& a, const ScreenRegion& b, ScreenRegion& out)
+{
+    Region_Combine(a, b, RegionOp::Subtract, out);
+}
+
+// 任意顺序、可以相互重叠的矩形的并集；两两归并，几百个矩形也只需 log2(n) 轮
+void Region_FromRects(const ScreenRect* rects, size_t count, ScreenRegion& out);
@@ -0,0 +1,180 @@
+#include "settings_preview.h"
+
+#include <algorithm>
+
+static constexpr int CHECKER_CELL = 8;
+static constexpr std::uint32_t CHECKER_LIGHT = 0x00E6E6E6u;
+static constexpr std::uint32_t CHECKER_DARK = 0x00B4B4B4u;
+
+PixelBuffer SoftPreviewPainter::Allocate(int width, int height)
+{
+    m_pixels.assign((size_t)width * (size_t)height, 0);
+    PixelBuffer buf;
+    buf.pixels = m_pixels.data();
+    buf.width = width;
+    buf.height = height;
+    buf.stride = width;
+    return buf;
+}
+
+void SoftPreviewPainter::Layout(int width, int height, int dpi, const AppConfig& cfg)
+{
+    Soft_LayoutOverlay(width, height, dpi, cfg.text, m_layout);
+}
+
+void SoftPreviewPainter::DrawBase(PixelBuffer& buf, const AppConfig& cfg)
+{
+    Soft_RenderOverlayBase(buf, m_layout, cfg.bgColor, cfg.text);
+}
+
+ScreenRect SoftPreviewPainter::DrawClock(PixelBuffer& buf, const AppConfig& cfg, std::int64_t unixSecond)
+{
+    const std::int64_t s = unixSecond < 0 ? 0 : unixSecond;
+    Soft_RenderOverlayClock(buf, m_layout, cfg.bgColor, (int)(s / 3600 % 24), (int)(s / 60 % 60), (int)(s % 60));
+    return m_layout.timeRect;
+}
+
+static bool IsEmptyRect(const ScreenRect& r)
+{
+    return r.left >= r.right || r.top >= r.bottom;
+}
+
+static ScreenRect UnionRect(const ScreenRect& a, const ScreenRect& b)
+{
+    if (IsEmptyRect(a))
+    {
+        return b;
+    }
+    if (IsEmptyRect(b))
+    {
+        return a;
+    }
+    return ScreenRect{ std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom) };
+}
+
+void SettingsPreview::Resize(int width, int height, int dpi)
+{
+    width = std::max(width, 0);
+    height = std::max(height, 0);
+    dpi = std::max(dpi, 1);
+    if (width == m_width && height == m_height && dpi == m_dpi && m_content.pixels)
+    {
+        return;
+    }
+    m_width = width;
+    m_height = height;
+    m_dpi = dpi;
+    m_content = m_painter.Allocate(width, height);
+
+    // 棋盘格背景让透明度一眼可见
+    m_backdrop.resize((size_t)width * (size_t)height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const bool light = ((x / CHECKER_CELL) + (y / CHECKER_CELL)) % 2 == 0;
+            m_backdrop[(size_t)y * (size_t)width + (size_t)x] = light ? CHECKER_LIGHT : CHECKER_DARK;
+        }
+    }
+    m_outputPixels.assign(m_backdrop.size(), 0);
+    m_output.pixels = m_outputPixels.data();
+    m_output.width = width;
+    m_output.height = height;
+    m_output.stride = width;
+    m_dirty = PREVIEW_DIRTY_ALL;
+}
+
+void SettingsPreview::SetCandidate(const AppConfig& cfg)
+{
+    if (!m_hasConfig || cfg.text != m_config.text)
+    {
+        m_dirty |= PREVIEW_DIRTY_ALL;
+    }
+    else if (cfg.bgColor != m_config.bgColor)
+    {
+        m_dirty |= PREVIEW_DIRTY_BASE | PREVIEW_DIRTY_CLOCK | PREVIEW_DIRTY_COMPOSITE;
+    }
+    else if (cfg.opacityPercent != m_config.opacityPercent)
+    {
+        m_dirty |= PREVIEW_DIRTY_COMPOSITE;
+    }
+    // 间隔、淡入时长、开机启动不影响画面
+    m_config = cfg;
+    m_hasConfig = true;
+}
+
+void SettingsPreview::SetSecond(std::int64_t unixSecond)
+{
+    if (unixSecond != m_second)
+    {
+        m_second = unixSecond;
+        m_dirty |= PREVIEW_DIRTY_CLOCK;
+    }
+}
+
+ScreenRect SettingsPreview::Update()
+{
+    if (!m_dirty || !m_hasConfig || m_width <= 0 || m_height <= 0 || !m_content.pixels)
+    {
+        return ScreenRect{};
+    }
+
+    const ScreenRect full{ 0, 0, m_width, m_height };
+    ScreenRect changed{};
+    if (m_dirty & PREVIEW_DIRTY_LAYOUT)
+    {
+        m_painter.Layout(m_width, m_height, m_dpi, m_config);
+        m_counters.layouts++;
+    }
+    if (m_dirty & PREVIEW_DIRTY_BASE)
+    {
+        m_painter.DrawBase(m_content, m_config);
+        m_counters.baseRenders++;
+        changed = full;
+    }
+    if (m_dirty & PREVIEW_DIRTY_CLOCK)
+    {
+        changed = UnionRect(changed, m_painter.DrawClock(m_content, m_config, m_second));
+        m_counters.clockRenders++;
+    }
+    if (m_dirty & PREVIEW_DIRTY_COMPOSITE)
+    {
+        changed = full;
+    }
+    m_dirty = 0;
+
+    changed.left = std::max(changed.left, 0);
+    changed.top = std::max(changed.top, 0);
+    changed.right = std::min(changed.right, m_width);
+    changed.bottom = std::min(changed.bottom, m_height);
+    if (IsEmptyRect(changed))
+    {
+        return ScreenRect{};
+    }
+    m_painter.Flush();
+    Composite(changed);
+    return changed;
+}
+
+void SettingsPreview::Composite(const ScreenRect& rect)
+{
+    const std::uint32_t a = (std::uint32_t)std::clamp(m_config.opacityPercent, 0, 100) * 256u / 100u;
+    const std::uint32_t inv = 256u - a;
+    for (int y = rect.top; y < rect.bottom; y++)
+    {
+        const std::uint32_t* src = m_content.pixels + (size_t)y * (size_t)m_content.stride;
+        const std::uint32_t* back = m_backdrop.data() + (size_t)y * (size_t)m_width;
+        std::uint32_t* dst = m_outputPixels.data() + (size_t)y * (size_t)m_width;
+        for (int x = rect.left; x < rect.right; x++)
+        {
+            // 红蓝与绿分两路同时乘，避免逐通道拆分
+            const std::uint32_t s = src[x];
+            const std::uint32_t b = back[x];
+            const std::uint32_t rb = (((s & 0x00FF00FFu) * a + (b & 0x00FF00FFu) * inv) >> 8) & 0x00FF00FFu;
+            const std::uint32_t g = (((s & 0x0000FF00u) * a + (b & 0x0000FF00u) * inv) >> 8) & 0x0000FF00u;
+            dst[x] = rb | g;
+        }
+    }
+    m_counters.composites++;
+    m_counters.pixelsComposited += (std::uint64_t)rect.Width() * (std::uint64_t)rect.Height();
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "config.h"
+#include "overlay_surface.h"
+#include "soft_render.h"
+
+// 设置窗口里的缩略预览：按候选配置以缩小的 DPI 走与遮罩相同的绘制流程，
+// 再以透明度叠加到棋盘格背景上。改动只重画受影响的部分：
+//   文字 → 重新排版 + 底图 + 时间；颜色 → 底图 + 时间；透明度 → 只重新叠加；每秒 → 只画时间区域
+
+enum PreviewDirty : std::uint32_t
+{
+    PREVIEW_DIRTY_LAYOUT = 1u << 0,
+    PREVIEW_DIRTY_BASE = 1u << 1,
+    PREVIEW_DIRTY_CLOCK = 1u << 2,
+    PREVIEW_DIRTY_COMPOSITE = 1u << 3,
+    PREVIEW_DIRTY_ALL = 0xFu,
+};
+
+// 绘制后端：Win32 用 GDI（与 Overlay_Paint 同一套函数），无界面构建用 soft_render
+class PreviewPainter
+{
+public:
+    virtual ~PreviewPainter() = default;
+
+    // 分配内容画布；之前的画布随之失效
+    virtual PixelBuffer Allocate(int width, int height) = 0;
+    virtual void Layout(int width, int height, int dpi, const AppConfig& cfg) = 0;
+    virtual void DrawBase(PixelBuffer& buf, const AppConfig& cfg) = 0;
+    // 返回被重画的区域
+    virtual ScreenRect DrawClock(PixelBuffer& buf, const AppConfig& cfg, std::int64_t unixSecond) = 0;
+    // 读取画布像素之前调用（GDI 需要 GdiFlush）
+    virtual void Flush() {}
+};
+
+class SoftPreviewPainter final : public PreviewPainter
+{
+public:
+    PixelBuffer Allocate(int width, int height) override;
+    void Layout(int width, int height, int dpi, const AppConfig& cfg) override;
+    void DrawBase(PixelBuffer& buf, const AppConfig& cfg) override;
+    ScreenRect DrawClock(PixelBuffer& buf, const AppConfig& cfg, std::int64_t unixSecond) override;
+
+private:
+    std::vector<std::uint32_t> m_pixels;
+    SoftOverlayLayout m_layout{};
+};
+
+struct PreviewCounters
+{
+    std::uint64_t layouts = 0;
+    std::uint64_t baseRenders = 0;
+    std::uint64_t clockRenders = 0;
+    std::uint64_t composites = 0;
+    std::uint64_t pixelsComposited = 0;
+};
+
+class SettingsPreview
+{
+public:
+    explicit SettingsPreview(PreviewPainter& painter) : m_painter(painter) {}
+
+    // 缩略图尺寸与等效 DPI（显示器 DPI × 缩略图宽 / 显示器宽）
+    void Resize(int width, int height, int dpi);
+    void SetCandidate(const AppConfig& cfg);
+    void SetSecond(std::int64_t unixSecond);
+
+    std::uint32_t Dirty() const { return m_dirty; }
+
+    // 只重画脏的部分，返回输出中变化的区域（无变化时为空）
+    ScreenRect Update();
+
+    const PixelBuffer& Output() const { return m_output; }
+    int Width() const { return m_width; }
+    int Height() const { return m_height; }
+    const PreviewCounters& Counters() const { return m_counters; }
+
+private:
+    void Composite(const ScreenRect& rect);
+
+    PreviewPainter& m_painter;
+    AppConfig m_config{};
+    bool m_hasConfig = false;
+    std::int64_t m_second = 0;
+    std::uint32_t m_dirty = PREVIEW_DIRTY_ALL;
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_dpi = 96;
+    PixelBuffer m_content{};
+    std::vector<std::uint32_t> m_backdrop;
+    std::vector<std::uint32_t> m_outputPixels;
+    PixelBuffer m_output{};
+    PreviewCounters m_counters{};
+};
+
+// 键入合并：第一次未处理的改动之后最多等 delayMs 就渲染，连续输入不会无限推迟
+class PreviewDebouncer
+{
+public:
+    explicit PreviewDebouncer(std::uint32_t delayMs) : m_delayMs(delayMs) {}
+
+    void Touch(std::uint64_t nowMs)
+    {
+        if (!m_pending)
+        {
+            m_pending = true;
+            m_deadlineMs = nowMs + m_delayMs;
+        }
+    }
+
+    bool Pending() const { return m_pending; }
+    bool Due(std::uint64_t nowMs) const { return m_pending && nowMs >= m_deadlineMs; }
+    std::uint64_t Deadline() const { return m_deadlineMs; }
+    void Clear() { m_pending = false; }
+
+private:
+    std::uint32_t m_delayMs;
+    std::uint64_t m_deadlineMs = 0;
+    bool m_pending = false;
+};
+
+constexpr std::uint32_t PREVIEW_DEBOUNCE_MS = 8;
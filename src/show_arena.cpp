@@ -0,0 +1,178 @@
+#include "show_arena.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+static constexpr size_t ARENA_ALIGN = 16;
+
+static std::uint8_t* Arena_MapPages(size_t size)
+{
+#ifdef _WIN32
+    return static_cast<std::uint8_t*>(VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? nullptr : static_cast<std::uint8_t*>(p);
+#endif
+}
+
+static void Arena_UnmapPages(std::uint8_t* base, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(base, 0, MEM_RELEASE);
+#else
+    munmap(base, size);
+#endif
+}
+
+ShowArena::~ShowArena()
+{
+    // 进程退出时仍被引用的块随进程一起归还
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_liveCount == 0)
+    {
+        FreeChunksLocked();
+    }
+}
+
+void* ShowArena::Allocate(size_t bytes)
+{
+    bytes = (bytes + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Chunk* chunk = m_chunks.empty() ? nullptr : &m_chunks.back();
+    if (!chunk || chunk->pinned || chunk->size - chunk->used < bytes)
+    {
+        // 超过一块的分配（高分辨率整屏像素）单独占一块，按 64KB 取整
+        const size_t size = bytes > CHUNK_BYTES ? (bytes + 0xFFFF) & ~(size_t)0xFFFF : CHUNK_BYTES;
+        std::uint8_t* base = Arena_MapPages(size);
+        if (!base)
+        {
+            return nullptr;
+        }
+        // 之前的块不再分配，已经没有存活分配的直接归还
+        if (chunk && chunk->live == 0)
+        {
+            FreeChunkLocked(m_chunks.size() - 1);
+        }
+        m_chunks.push_back(Chunk{ base, size, 0, 0, false });
+        chunk = &m_chunks.back();
+        m_stats.reservedBytes += size;
+        if (m_stats.reservedBytes > m_stats.peakBytes)
+        {
+            m_stats.peakBytes = m_stats.reservedBytes;
+        }
+    }
+    void* p = chunk->base + chunk->used;
+    chunk->used += bytes;
+    chunk->live++;
+    m_liveCount++;
+    m_stats.liveBytes += bytes;
+    m_stats.allocations++;
+    return p;
+}
+
+void ShowArena::Deallocate(void* p, size_t bytes)
+{
+    if (!p)
+    {
+        return;
+    }
+    bytes = (bytes + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_liveCount--;
+    m_stats.liveBytes -= bytes;
+    // 全部释放后整块归还，没有调用 Release 的使用方也不会累积
+    if (m_liveCount == 0)
+    {
+        FreeChunksLocked();
+        return;
+    }
+    // 块数很少（每个显示器一两块），最近的块在末尾
+    const std::uint8_t* q = static_cast<const std::uint8_t*>(p);
+    for (size_t i = m_chunks.size(); i-- > 0;)
+    {
+        Chunk& chunk = m_chunks[i];
+        if (q < chunk.base || q >= chunk.base + chunk.size)
+        {
+            continue;
+        }
+        if (--chunk.live == 0)
+        {
+            if (i + 1 == m_chunks.size() && !chunk.pinned)
+            {
+                chunk.used = 0;
+            }
+            else
+            {
+                FreeChunkLocked(i);
+            }
+        }
+        break;
+    }
+}
+
+void ShowArena::Release()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_liveCount == 0)
+    {
+        FreeChunksLocked();
+        return;
+    }
+    // 没有存活分配的块先归还；其余的等最后一个分配释放
+    for (size_t i = m_chunks.size(); i-- > 0;)
+    {
+        Chunk& chunk = m_chunks[i];
+        if (chunk.live == 0)
+        {
+            FreeChunkLocked(i);
+        }
+        else if (!chunk.pinned)
+        {
+            chunk.pinned = true;
+            m_stats.pinnedBytes += chunk.size;
+        }
+    }
+    m_stats.deferred++;
+}
+
+void ShowArena::FreeChunkLocked(size_t index)
+{
+    const Chunk chunk = m_chunks[index];
+    Arena_UnmapPages(chunk.base, chunk.size);
+    m_chunks.erase(m_chunks.begin() + (std::ptrdiff_t)index);
+    m_stats.reservedBytes -= chunk.size;
+    m_stats.pinnedBytes -= chunk.pinned ? chunk.size : 0;
+}
+
+void ShowArena::FreeChunksLocked()
+{
+    m_stats.pinnedBytes = 0;
+    if (m_chunks.empty())
+    {
+        return;
+    }
+    for (const Chunk& chunk : m_chunks)
+    {
+        Arena_UnmapPages(chunk.base, chunk.size);
+    }
+    m_chunks.clear();
+    m_chunks.shrink_to_fit();
+    m_stats.reservedBytes = 0;
+    m_stats.releases++;
+}
+
+ShowArenaStats ShowArena::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+ShowArena& ShowArena_Overlay()
+{
+    static ShowArena arena;
+    return arena;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// 一次提醒期间的大块内存（预渲染首帧、底图等像素）：直接向系统按页申请（VirtualAlloc / mmap），
+// 块内顺序分配、不单独回收；每块记录存活的分配数，块内全部释放后整块归还系统（正在分配的块
+// 改为从头复用），不在堆里留下碎片。
+// 遮罩隐藏、画面缓存清空后调用 Release：没有存活分配的块立即归还，仍被引用的块（例如后台线程
+// 正在渲染）记入 pinnedBytes，等其中最后一个分配释放时归还。分配与释放可以来自任何线程。
+// 只放像素（OverlayFrame 的底图与首帧、动画帧）：每次提醒的其他分配都很小，放进来反而要占住整块。
+// 遮罩窗口及其位图、共享内存图像在池中复用；绘制时的临时 DIB 由 GDI 在绘制结束时释放；
+// 各窗口的文字排版在隐藏时连同容量一起释放，由随后的堆整理归还。
+struct ShowArenaStats
+{
+    std::uint64_t reservedBytes = 0;   // 当前向系统申请的字节
+    std::uint64_t liveBytes = 0;       // 尚未释放的分配
+    std::uint64_t peakBytes = 0;       // reservedBytes 的最大值
+    std::uint64_t allocations = 0;
+    std::uint64_t releases = 0;        // 把块归还系统的次数
+    std::uint64_t deferred = 0;        // Release 时仍有存活分配而推迟的次数
+    std::uint64_t pinnedBytes = 0;     // 最近一次 Release 后仍被存活分配占住的块，归还后回到 0
+};
+
+class ShowArena
+{
+public:
+    static constexpr size_t CHUNK_BYTES = 4u << 20;
+
+    ShowArena() = default;
+    ~ShowArena();
+
+    ShowArena(const ShowArena&) = delete;
+    ShowArena& operator=(const ShowArena&) = delete;
+
+    // 16 字节对齐；系统内存不足时返回 nullptr
+    void* Allocate(size_t bytes);
+    void Deallocate(void* p, size_t bytes);
+    void Release();
+
+    ShowArenaStats Stats() const;
+
+private:
+    struct Chunk
+    {
+        std::uint8_t* base = nullptr;
+        size_t size = 0;
+        size_t used = 0;
+        size_t live = 0;
+        bool pinned = false;   // Release 时仍有存活分配，不再从中分配
+    };
+
+    void FreeChunksLocked();
+    void FreeChunkLocked(size_t index);
+
+    mutable std::mutex m_mutex;
+    std::vector<Chunk> m_chunks;
+    size_t m_liveCount = 0;
+    ShowArenaStats m_stats;
+};
+
+// 遮罩画面用的进程级 arena
+ShowArena& ShowArena_Overlay();
+
+template <typename T>
+class ShowArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ShowArenaAllocator() noexcept : m_arena(&ShowArena_Overlay()) {}
+    explicit ShowArenaAllocator(ShowArena& arena) noexcept : m_arena(&arena) {}
+    template <typename U>
+    ShowArenaAllocator(const ShowArenaAllocator<U>& other) noexcept : m_arena(other.Arena()) {}
+
+    T* allocate(size_t n)
+    {
+        void* p = m_arena->Allocate(n * sizeof(T));
+        if (!p)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        m_arena->Deallocate(p, n * sizeof(T));
+    }
+
+    ShowArena* Arena() const noexcept { return m_arena; }
+
+private:
+    ShowArena* m_arena;
+};
+
+template <typename T, typename U>
+inline bool operator==(const ShowArenaAllocator<T>& a, const ShowArenaAllocator<U>& b) noexcept
+{
+    return a.Arena() == b.Arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ShowArenaAllocator<T>& a, const ShowArenaAllocator<U>& b) noexcept
+{
+    return a.Arena() != b.Arena();
+}
@@ -0,0 +1,196 @@
+#include "single_instance.h"
+
+#include <chrono>
+#include <cwctype>
+#include <iterator>
+#include <thread>
+
+#include "control_server.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include "utf8.h"
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+SingleInstance::~SingleInstance()
+{
+    Release();
+}
+
+#ifdef _WIN32
+
+bool SingleInstance::Acquire(const std::string& name)
+{
+    Release();
+    HANDLE mutex = CreateMutexW(nullptr, FALSE, Utf8ToWide(name).c_str());
+    if (!mutex)
+    {
+        return false;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        CloseHandle(mutex);
+        return false;
+    }
+    m_mutex = mutex;
+    return true;
+}
+
+void SingleInstance::Release()
+{
+    if (m_mutex)
+    {
+        CloseHandle((HANDLE)m_mutex);
+        m_mutex = nullptr;
+    }
+}
+
+std::string SingleInstance::DefaultName()
+{
+    wchar_t user[128]{};
+    const DWORD len = GetEnvironmentVariableW(L"USERNAME", user, (DWORD)std::size(user));
+    std::wstring name = L"Local\\ScreenSaverReminderCPP";
+    if (len > 0 && len < std::size(user))
+    {
+        name += L".";
+        name += user;
+    }
+    return WideToUtf8(name);
+}
+
+#else
+
+bool SingleInstance::Acquire(const std::string& name)
+{
+    Release();
+    // 不跟随符号链接：锁文件所在目录若被别人放了链接，不会去打开（并创建）链接指向的文件
+    const int fd = open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    m_fd = fd;
+    return true;
+}
+
+void SingleInstance::Release()
+{
+    if (m_fd >= 0)
+    {
+        // 不删除锁文件：删除与另一个进程的 open 之间有竞争，会出现两个实例各锁一个文件
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+std::string SingleInstance::DefaultName()
+{
+    const std::string endpoint = ControlServer::DefaultEndpoint();
+    return endpoint.empty() ? std::string() : endpoint + ".lock";
+}
+
+#endif
+
+bool Instance_ParseVerb(std::wstring_view cmdLine, InstanceVerb& out)
+{
+    out = InstanceVerb{};
+    bool found = false;
+    size_t pos = 0;
+    auto nextToken = [&](std::wstring_view& token)
+    {
+        while (pos < cmdLine.size() && std::iswspace(cmdLine[pos]))
+        {
+            pos++;
+        }
+        const size_t start = pos;
+        while (pos < cmdLine.size() && !std::iswspace(cmdLine[pos]))
+        {
+            pos++;
+        }
+        token = cmdLine.substr(start, pos - start);
+        return !token.empty();
+    };
+    auto parseMinutes = [](std::wstring_view text, std::uint32_t& minutes)
+    {
+        if (text.empty() || text.size() > 5)
+        {
+            return false;
+        }
+        std::uint32_t value = 0;
+        for (wchar_t ch : text)
+        {
+            if (ch < L'0' || ch > L'9')
+            {
+                return false;
+            }
+            value = value * 10 + (std::uint32_t)(ch - L'0');
+        }
+        if (value == 0)
+        {
+            return false;
+        }
+        minutes = value;
+        return true;
+    };
+
+    std::wstring_view token;
+    while (nextToken(token))
+    {
+        if (token == L"--settings")
+        {
+            out.op = ControlOp::OpenSettings;
+            found = true;
+        }
+        else if (token == L"--trigger")
+        {
+            out.op = ControlOp::TriggerNow;
+            found = true;
+        }
+        else if (token == L"--snooze" || token.substr(0, 9) == L"--snooze=")
+        {
+            out.op = ControlOp::Snooze;
+            out.snoozeMinutes = INSTANCE_DEFAULT_SNOOZE_MINUTES;
+            found = true;
+            if (token.size() > 9)
+            {
+                parseMinutes(token.substr(9), out.snoozeMinutes);
+            }
+            else if (token.size() == 8)
+            {
+                // 允许 "--snooze 15"：下一个词是数字时才消费
+                const size_t save = pos;
+                std::wstring_view value;
+                if (!nextToken(value) || !parseMinutes(value, out.snoozeMinutes))
+                {
+                    pos = save;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+bool Instance_Forward(const std::string& endpoint, const InstanceVerb& verb, std::uint32_t timeoutMs, ControlResponse& response)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    ControlClient client;
+    while (!client.Connect(endpoint, timeoutMs))
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    const std::string arg = verb.op == ControlOp::Snooze ? Control_SnoozeArg(verb.snoozeMinutes) : std::string();
+    return client.Call(verb.op, arg, response);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "control_protocol.h"
+
+// 每个用户只运行一个实例。Windows 用会话内的命名互斥量，Linux 用 flock 锁文件；
+// 进程退出（包括崩溃）时锁自动释放。
+class SingleInstance
+{
+public:
+    SingleInstance() = default;
+    ~SingleInstance();
+
+    SingleInstance(const SingleInstance&) = delete;
+    SingleInstance& operator=(const SingleInstance&) = delete;
+
+    // 成为唯一实例时返回 true；已有实例在运行时返回 false
+    bool Acquire(const std::string& name);
+    void Release();
+
+    // Windows：Local\ScreenSaverReminderCPP.<用户名>；Linux：控制套接字路径加 .lock
+    static std::string DefaultName();
+
+private:
+#ifdef _WIN32
+    void* m_mutex = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+// 命令行动词：--settings、--trigger、--snooze[=分钟]；没有动词时为 Status（只确认对方在运行）
+struct InstanceVerb
+{
+    ControlOp op = ControlOp::Status;
+    std::uint32_t snoozeMinutes = 0;
+};
+
+constexpr std::uint32_t INSTANCE_DEFAULT_SNOOZE_MINUTES = 10;
+
+bool Instance_ParseVerb(std::wstring_view cmdLine, InstanceVerb& out);
+
+// 把动词交给正在运行的实例。对方可能刚拿到锁、控制端点还没开始监听，因此在 timeoutMs 内重试连接
+bool Instance_Forward(const std::string& endpoint, const InstanceVerb& verb, std::uint32_t timeoutMs, ControlResponse& response);
@@ -0,0 +1,308 @@
+#include "soft_render.h"
+
+#include <algorithm>
+
+#include "screen_region.h"
+
+static constexpr std::uint32_t SOFT_WHITE = 0x00FFFFFFu;
+static constexpr int DIGIT_COLS = 5;
+static constexpr int DIGIT_ROWS = 7;
+
+// 每行 5 位，高位在左
+static constexpr std::uint8_t kDigitRows[11][DIGIT_ROWS] = {
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, // 0
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 1
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, // 2
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // 3
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, // 4
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // 5
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, // 6
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 7
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, // 8
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // 9
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, // :
+};
+
+std::uint32_t Soft_PixelFromColor(ColorRef color)
+{
+    return ((std::uint32_t)ColorR(color) << 16) | ((std::uint32_t)ColorG(color) << 8) | (std::uint32_t)ColorB(color);
+}
+
+static void FillRect(PixelBuffer& buf, int left, int top, int right, int bottom, std::uint32_t pixel)
+{
+    for (int y = top; y < bottom; y++)
+    {
+        std::uint32_t* row = buf.pixels + (size_t)y * (size_t)buf.stride;
+        std::fill(row + left, row + right, pixel);
+    }
+}
+
+// 裁剪到缓冲与 clip 区域后逐块处理；clip 的矩形按 y 排序，跳过不相交的带
+template <typename Fn>
+static void ForEachClipped(const PixelBuffer& buf, ScreenRect rect, Fn&& fn)
+{
+    const int left = std::max(rect.left, 0);
+    const int top = std::max(rect.top, 0);
+    const int right = std::min(rect.right, buf.width);
+    const int bottom = std::min(rect.bottom, buf.height);
+    if (left >= right || top >= bottom)
+    {
+        return;
+    }
+    if (!buf.clip)
+    {
+        fn(left, top, right, bottom);
+        return;
+    }
+    const auto& rects = buf.clip->Rects();
+    auto it = std::partition_point(rects.begin(), rects.end(), [top](const ScreenRect& r) { return r.bottom <= top; });
+    for (; it != rects.end() && it->top < bottom; ++it)
+    {
+        const int l = std::max(left, it->left);
+        const int r = std::min(right, it->right);
+        if (l < r)
+        {
+            fn(l, std::max(top, it->top), r, std::min(bottom, it->bottom));
+        }
+    }
+}
+
+void Soft_Fill(PixelBuffer& buf, ScreenRect rect, std::uint32_t pixel)
+{
+    ForEachClipped(buf, rect, [&](int left, int top, int right, int bottom) { FillRect(buf, left, top, right, bottom, pixel); });
+}
+
+void Soft_Copy(PixelBuffer& buf, const std::uint32_t* src, int srcStride)
+{
+    ForEachClipped(buf, ScreenRect{ 0, 0, buf.width, buf.height }, [&](int left, int top, int right, int bottom)
+    {
+        for (int y = top; y < bottom; y++)
+        {
+            std::copy(src + (size_t)y * (size_t)srcStride + left, src + (size_t)y * (size_t)srcStride + right,
+                buf.pixels + (size_t)y * (size_t)buf.stride + left);
+        }
+    });
+}
+
+static int ScaleByDpi(int value, int dpi)
+{
+    return (value * dpi + 48) / 96;
+}
+
+void Soft_Blit(PixelBuffer& buf, int x, int y, const std::uint32_t* src, int w, int h, int srcStride)
+{
+    ForEachClipped(buf, ScreenRect{ x, y, x + w, y + h }, [&](int left, int top, int right, int bottom)
+    {
+        for (int row = top; row < bottom; row++)
+        {
+            const std::uint32_t* from = src + (size_t)(row - y) * (size_t)srcStride + (left - x);
+            std::copy(from, from + (right - left), buf.pixels + (size_t)row * (size_t)buf.stride + left);
+        }
+    });
+}
+
+void Soft_FitSize(int srcW, int srcH, int maxW, int maxH, int& outW, int& outH)
+{
+    outW = std::max(1, srcW);
+    outH = std::max(1, srcH);
+    maxW = std::max(1, maxW);
+    maxH = std::max(1, maxH);
+    if (outW > maxW)
+    {
+        outH = std::max(1, (int)((long long)outH * maxW / outW));
+        outW = maxW;
+    }
+    if (outH > maxH)
+    {
+        outW = std::max(1, (int)((long long)outW * maxH / outH));
+        outH = maxH;
+    }
+}
+
+void Soft_LayoutAnimation(int width, int height, int dpi, int timeHeight, int animWidth, int animHeight, ScreenRect& timeRect, ScreenRect& animRect)
+{
+    const int marginX = ScaleByDpi(80, dpi);
+    const int marginY = ScaleByDpi(40, dpi);
+    const int gap = ScaleByDpi(18, dpi);
+    const int availWidth = std::max(1, width - marginX * 2);
+    const int availHeight = std::max(1, height - marginY * 2 - timeHeight - gap);
+
+    int w = 0;
+    int h = 0;
+    Soft_FitSize(ScaleByDpi(animWidth, dpi), ScaleByDpi(animHeight, dpi), availWidth, availHeight, w, h);
+
+    const int startY = std::max(0, (height - (timeHeight + gap + h)) / 2);
+    timeRect = ScreenRect{ marginX, startY, width - marginX, startY + timeHeight };
+    const int left = marginX + (availWidth - w) / 2;
+    const int top = startY + timeHeight + gap;
+    animRect = ScreenRect{ left, top, left + w, top + h };
+}
+
+static int CountLines(std::wstring_view text, int charsPerLine)
+{
+    if (text.empty())
+    {
+        return 0;
+    }
+    int lines = 1;
+    int column = 0;
+    for (wchar_t ch : text)
+    {
+        if (ch == L'\n')
+        {
+            lines++;
+            column = 0;
+            continue;
+        }
+        if (ch == L'\r')
+        {
+            continue;
+        }
+        if (column == charsPerLine)
+        {
+            lines++;
+            column = 0;
+        }
+        column++;
+    }
+    return lines;
+}
+
+int Soft_TextCharsPerLine(int width, int dpi)
+{
+    const int availWidth = std::max(1, width - ScaleByDpi(80, dpi) * 2);
+    const int glyphWidth = std::max(1, std::max(1, dpi / 2) / 2);
+    return std::max(1, availWidth / glyphWidth);
+}
+
+int Soft_TextRows(std::wstring_view line, int charsPerLine)
+{
+    return std::max(1, CountLines(line, charsPerLine));
+}
+
+void Soft_LayoutOverlay(int width, int height, int dpi, std::wstring_view text, SoftOverlayLayout& out)
+{
+    Soft_LayoutOverlayRows(width, height, dpi, CountLines(text, Soft_TextCharsPerLine(width, dpi)), out);
+}
+
+void Soft_LayoutOverlayRows(int width, int height, int dpi, int textRows, SoftOverlayLayout& out)
+{
+    // 字号与 Overlay_Paint 一致：时间 72pt、文字 36pt
+    const int timeH = std::max(DIGIT_ROWS, dpi);
+    const int marginX = ScaleByDpi(80, dpi);
+    const int gap = ScaleByDpi(18, dpi);
+
+    out.clockScale = std::max(1, timeH / DIGIT_ROWS);
+    out.lineHeight = std::max(1, dpi / 2);
+    out.glyphWidth = std::max(1, out.lineHeight / 2);
+
+    const int textH = textRows * out.lineHeight;
+
+    const int combinedH = timeH + (textH > 0 ? gap + textH : 0);
+    const int startY = std::max(0, (height - combinedH) / 2);
+
+    out.timeRect = ScreenRect{ marginX, startY, width - marginX, startY + timeH };
+    out.textRect = textH > 0
+        ? ScreenRect{ marginX, startY + timeH + gap, width - marginX, startY + timeH + gap + textH }
+        : ScreenRect{ marginX, startY + timeH, width - marginX, startY + timeH };
+}
+
+ScreenRect Soft_TextRowsRect(const SoftOverlayLayout& layout, int firstRow, int rows)
+{
+    const int top = layout.textRect.top + firstRow * layout.lineHeight;
+    return ScreenRect{ layout.textRect.left, top, layout.textRect.right, top + rows * layout.lineHeight };
+}
+
+void Soft_LayoutOverlayAnim(int width, int height, int dpi, int animWidth, int animHeight, SoftOverlayLayout& out)
+{
+    const int timeH = std::max(DIGIT_ROWS, dpi);
+    out.clockScale = std::max(1, timeH / DIGIT_ROWS);
+    out.lineHeight = std::max(1, dpi / 2);
+    out.glyphWidth = std::max(1, out.lineHeight / 2);
+    Soft_LayoutAnimation(width, height, dpi, timeH, animWidth, animHeight, out.timeRect, out.textRect);
+}
+
+static void DrawTextRows(PixelBuffer& buf, const SoftOverlayLayout& layout, int firstRow, std::wstring_view text)
+{
+    const ScreenRect& area = layout.textRect;
+    const int charsPerLine = std::max(1, area.Width() / layout.glyphWidth);
+    const int inset = std::max(1, layout.glyphWidth / 8);
+
+    int line = firstRow;
+    int column = 0;
+    for (wchar_t ch : text)
+    {
+        if (ch == L'\n')
+        {
+            line++;
+            column = 0;
+            continue;
+        }
+        if (ch == L'\r')
+        {
+            continue;
+        }
+        if (column == charsPerLine)
+        {
+            line++;
+            column = 0;
+        }
+        if (ch != L' ' && ch != L'\t')
+        {
+            const int x = area.left + column * layout.glyphWidth;
+            const int y = area.top + line * layout.lineHeight;
+            Soft_Fill(buf, ScreenRect{ x + inset, y + layout.lineHeight / 4, x + layout.glyphWidth - inset, y + layout.lineHeight - layout.lineHeight / 4 }, SOFT_WHITE);
+        }
+        column++;
+    }
+}
+
+void Soft_RenderOverlayBase(PixelBuffer& buf, const SoftOverlayLayout& layout, ColorRef bgColor, std::wstring_view text)
+{
+    Soft_Fill(buf, ScreenRect{ 0, 0, buf.width, buf.height }, Soft_PixelFromColor(bgColor));
+    DrawTextRows(buf, layout, 0, text);
+}
+
+void Soft_RenderTextLine(PixelBuffer& buf, const SoftOverlayLayout& layout, int firstRow, std::wstring_view line)
+{
+    DrawTextRows(buf, layout, firstRow, line);
+}
+
+static void DrawGlyph(PixelBuffer& buf, int glyph, int x, int y, int scale)
+{
+    for (int row = 0; row < DIGIT_ROWS; row++)
+    {
+        const std::uint8_t bits = kDigitRows[glyph][row];
+        int col = 0;
+        while (col < DIGIT_COLS)
+        {
+            if (!(bits & (0x10 >> col)))
+            {
+                col++;
+                continue;
+            }
+            // 连续的点合并成一次填充
+            int end = col + 1;
+            while (end < DIGIT_COLS && (bits & (0x10 >> end))) end++;
+            Soft_Fill(buf, ScreenRect{ x + col * scale, y + row * scale, x + end * scale, y + (row + 1) * scale }, SOFT_WHITE);
+            col = end;
+        }
+    }
+}
+
+void Soft_RenderOverlayClock(PixelBuffer& buf, const SoftOverlayLayout& layout, ColorRef bgColor, int hour, int minute, int second)
+{
+    Soft_Fill(buf, layout.timeRect, Soft_PixelFromColor(bgColor));
+
+    const int glyphs[8] = { hour / 10 % 10, hour % 10, 10, minute / 10, minute % 10, 10, second / 10, second % 10 };
+    const int scale = layout.clockScale;
+    const int advance = (DIGIT_COLS + 1) * scale;
+    const int totalW = advance * 8 - scale;
+    const int x0 = layout.timeRect.left + (layout.timeRect.Width() - totalW) / 2;
+    const int y0 = layout.timeRect.top + (layout.timeRect.Height() - DIGIT_ROWS * scale) / 2;
+
+    for (int i = 0; i < 8; i++)
+    {
+        DrawGlyph(buf, glyphs[i], x0 + i * advance, y0, scale);
+    }
+}
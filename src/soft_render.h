@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "config.h"
+#include "overlay_surface.h"
+
+// 不依赖 GDI 的简易软件渲染，供无界面后端与基准测试使用。
+// 时间用 5x7 点阵数字绘制，文字以等宽方块近似排版（只模拟版面与填充开销）。
+
+class ScreenRegion;
+
+struct PixelBuffer
+{
+    std::uint32_t* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0; // 以像素计
+    const ScreenRegion* clip = nullptr; // 非空时所有填充与复制都限于这个区域（缓冲内坐标）
+};
+
+struct SoftOverlayLayout
+{
+    ScreenRect timeRect;
+    ScreenRect textRect;
+    int clockScale = 1;
+    int glyphWidth = 1;
+    int lineHeight = 1;
+};
+
+std::uint32_t Soft_PixelFromColor(ColorRef color);
+
+void Soft_Fill(PixelBuffer& buf, ScreenRect rect, std::uint32_t pixel);
+// 从同尺寸、行距为 srcStride 的像素（缓存的底图）复制
+void Soft_Copy(PixelBuffer& buf, const std::uint32_t* src, int srcStride);
+
+// 与 Overlay_Paint 相同的版面：时间与文字整体垂直居中，左右留边距
+void Soft_LayoutOverlay(int width, int height, int dpi, std::wstring_view text, SoftOverlayLayout& out);
+// 同上，文字的行数（折行后）已由调用方按行统计
+void Soft_LayoutOverlayRows(int width, int height, int dpi, int textRows, SoftOverlayLayout& out);
+// 宽 width 的遮罩上文字每行能放下的字数
+int Soft_TextCharsPerLine(int width, int dpi);
+// 一行文字（不含 \n）折行后占的行数，空行也占一行
+int Soft_TextRows(std::wstring_view line, int charsPerLine);
+// 文字区域中从第 firstRow 行起 rows 行的矩形
+ScreenRect Soft_TextRowsRect(const SoftOverlayLayout& layout, int firstRow, int rows);
+
+// 按宽高比缩放 srcW × srcH 使其不超过 maxW × maxH，至少 1 像素
+void Soft_FitSize(int srcW, int srcH, int maxW, int maxH, int& outW, int& outH);
+
+// 显示动画时的版面：时间在上，动画在下，整体垂直居中。动画按源尺寸乘以 DPI 缩放，
+// 放不下时等比缩小。timeHeight 为时间一行的高度（Win32 按字体测量）
+void Soft_LayoutAnimation(int width, int height, int dpi, int timeHeight, int animWidth, int animHeight, ScreenRect& timeRect, ScreenRect& animRect);
+// 同上，时间用点阵数字；textRect 为动画的位置与大小
+void Soft_LayoutOverlayAnim(int width, int height, int dpi, int animWidth, int animHeight, SoftOverlayLayout& out);
+
+// 把 w × h、行距为 srcStride 的像素复制到 (x, y)
+void Soft_Blit(PixelBuffer& buf, int x, int y, const std::uint32_t* src, int w, int h, int srcStride);
+
+// 背景与文字，不含时间
+void Soft_RenderOverlayBase(PixelBuffer& buf, const SoftOverlayLayout& layout, ColorRef bgColor, std::wstring_view text);
+// 从文字区域第 firstRow 行起绘制一行文字，不擦除背景
+void Soft_RenderTextLine(PixelBuffer& buf, const SoftOverlayLayout& layout, int firstRow, std::wstring_view line);
+
+// 擦除时间区域后绘制 hh:mm:ss
+void Soft_RenderOverlayClock(PixelBuffer& buf, const SoftOverlayLayout& layout, ColorRef bgColor, int hour, int minute, int second);
@@ -0,0 +1,67 @@
+#include "startup_profile.h"
+
+#include "trace.h"
+
+static constexpr const char* TRACE_CAT_STARTUP = "startup";
+
+void StartupProfile::Begin()
+{
+    m_count = 0;
+    m_beginUs = Trace_NowUs();
+    m_lastUs = m_beginUs;
+    m_finished = false;
+}
+
+void StartupProfile::Mark(const char* name)
+{
+    if (m_finished || m_beginUs == 0)
+    {
+        return;
+    }
+    const std::uint64_t nowUs = Trace_NowUs();
+    if (m_count == MAX_PHASES)
+    {
+        m_phases[m_count - 1].durUs += nowUs - m_lastUs;
+    }
+    else
+    {
+        m_phases[m_count++] = StartupPhase{ name, m_lastUs, nowUs - m_lastUs };
+    }
+    m_lastUs = nowUs;
+}
+
+void StartupProfile::Finish()
+{
+    if (m_finished || m_beginUs == 0)
+    {
+        return;
+    }
+    m_finished = true;
+    if (!Trace_IsEnabled())
+    {
+        return;
+    }
+    for (int i = 0; i < m_count; i++)
+    {
+        Trace_Record(TracePhase::Complete, TRACE_CAT_STARTUP, m_phases[i].name, m_phases[i].startUs, m_phases[i].durUs, i);
+    }
+    Trace_Record(TracePhase::Complete, TRACE_CAT_STARTUP, "startup", m_beginUs, TotalUs(), OverBudget() ? 1 : 0);
+}
+
+void StartupProfile::AppendText(std::string& out) const
+{
+    auto line = [&out](const char* name, std::uint64_t value)
+    {
+        out += "startup_";
+        out += name;
+        out += "_us=";
+        out += std::to_string(value);
+        out += '\n';
+    };
+    for (int i = 0; i < m_count; i++)
+    {
+        line(m_phases[i].name, m_phases[i].durUs);
+    }
+    line("total", TotalUs());
+    line("budget", kStartupBudgetUs);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// 启动阶段计时：入口处 Begin，每个阶段结束时 Mark，进入消息循环（或等价位置）时 Finish。
+// 时间戳一直记录（只是一次时钟读取）；Finish 时把每个阶段作为 "startup" 类别的
+// Complete 事件写进跟踪，所以跟踪可以在阶段记录之后才启用。
+// 阶段名必须是静态字符串。
+
+// 从入口到 Finish 的预算：登录时与其他自启动程序争抢磁盘与 CPU，超出时应查看各阶段
+constexpr std::uint64_t kStartupBudgetUs = 50000;
+
+struct StartupPhase
+{
+    const char* name = nullptr;
+    std::uint64_t startUs = 0;
+    std::uint64_t durUs = 0;
+};
+
+class StartupProfile
+{
+public:
+    static constexpr int MAX_PHASES = 16;
+
+    void Begin();
+    // 上一个 Mark（或 Begin）到现在算作阶段 name；超过 MAX_PHASES 的阶段并入最后一个
+    void Mark(const char* name);
+    // 写入跟踪；之后的 Mark 被忽略
+    void Finish();
+
+    bool IsFinished() const { return m_finished; }
+    int PhaseCount() const { return m_count; }
+    const StartupPhase& Phase(int index) const { return m_phases[index]; }
+    std::uint64_t TotalUs() const { return m_lastUs - m_beginUs; }
+    bool OverBudget(std::uint64_t budgetUs = kStartupBudgetUs) const { return TotalUs() > budgetUs; }
+
+    // 每行 startup_<阶段>_us=<微秒>，最后是 startup_total_us 与 startup_budget_us
+    void AppendText(std::string& out) const;
+
+private:
+    StartupPhase m_phases[MAX_PHASES];
+    int m_count = 0;
+    std::uint64_t m_beginUs = 0;
+    std::uint64_t m_lastUs = 0;
+    bool m_finished = false;
+};
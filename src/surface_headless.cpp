@@ -0,0 +1,95 @@
+#include "surface_headless.h"
+
+#include <algorithm>
+
+HeadlessSurfaceBackend::~HeadlessSurfaceBackend() = default;
+
+void HeadlessSurfaceBackend::EnumMonitors(std::vector<MonitorInfo>& out)
+{
+    out.insert(out.end(), m_monitors.begin(), m_monitors.end());
+}
+
+SurfaceHandle HeadlessSurfaceBackend::Create(const MonitorInfo& monitor)
+{
+    const int w = monitor.rect.Width();
+    const int h = monitor.rect.Height();
+    if (w <= 0 || h <= 0)
+    {
+        return 0;
+    }
+
+    auto surface = std::make_unique<Surface>();
+    surface->monitor = monitor;
+    surface->pixels.assign((size_t)w * (size_t)h, 0u);
+    surface->region.Reset(ScreenRect{ 0, 0, w, h });
+    m_counters.creates++;
+    m_live++;
+    return reinterpret_cast<SurfaceHandle>(surface.release());
+}
+
+void HeadlessSurfaceBackend::Destroy(SurfaceHandle surface)
+{
+    if (!surface)
+    {
+        return;
+    }
+    delete FromHandle(surface);
+    m_counters.destroys++;
+    m_live--;
+}
+
+void HeadlessSurfaceBackend::Reposition(SurfaceHandle surface, const MonitorInfo& monitor)
+{
+    Surface* s = FromHandle(surface);
+    if (monitor.rect.Width() != s->monitor.rect.Width() || monitor.rect.Height() != s->monitor.rect.Height())
+    {
+        s->pixels.assign((size_t)std::max(0, monitor.rect.Width()) * (size_t)std::max(0, monitor.rect.Height()), 0u);
+    }
+    s->monitor = monitor;
+    s->presented = nullptr;
+    s->invalidations++;
+    m_counters.moves++;
+}
+
+void HeadlessSurfaceBackend::Show(SurfaceHandle surface)
+{
+    FromHandle(surface)->visible = true;
+    m_counters.shows++;
+}
+
+void HeadlessSurfaceBackend::Hide(SurfaceHandle surface)
+{
+    FromHandle(surface)->visible = false;
+    m_counters.hides++;
+}
+
+void HeadlessSurfaceBackend::SetAlpha(SurfaceHandle surface, std::uint8_t alpha)
+{
+    FromHandle(surface)->alpha = alpha;
+}
+
+void HeadlessSurfaceBackend::Invalidate(SurfaceHandle surface)
+{
+    Surface* s = FromHandle(surface);
+    s->presented = nullptr;
+    s->invalidations++;
+}
+
+void HeadlessSurfaceBackend::SetRegion(SurfaceHandle surface, const ScreenRegion& region)
+{
+    Surface* s = FromHandle(surface);
+    s->region = region;
+    s->presented = nullptr;
+    m_counters.regions++;
+}
+
+PixelBuffer HeadlessSurfaceBackend::Pixels(SurfaceHandle surface)
+{
+    Surface* s = FromHandle(surface);
+    return PixelBuffer{ s->pixels.data(), s->monitor.rect.Width(), s->monitor.rect.Height(), s->monitor.rect.Width(), &s->region };
+}
+
+void HeadlessSurfaceBackend::Present(SurfaceHandle surface, std::shared_ptr<const OverlayFrame> frame)
+{
+    FromHandle(surface)->presented = std::move(frame);
+}
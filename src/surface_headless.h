@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "overlay_frame.h"
+#include "overlay_surface.h"
+#include "screen_region.h"
+#include "soft_render.h"
+
+// 无界面的遮罩实现：每个遮罩持有一块与显示器同尺寸的 32 位像素缓冲，
+// 供基准测试和无显示环境使用，并记录各操作的调用次数。
+class HeadlessSurfaceBackend final : public SurfaceBackend
+{
+public:
+    struct Surface
+    {
+        MonitorInfo monitor;
+        std::vector<std::uint32_t> pixels;
+        std::shared_ptr<const OverlayFrame> presented; // 非空时显示预渲染画面而不是 pixels
+        ScreenRegion region;                            // 可见区域，相对显示器左上角
+        std::uint8_t alpha = 0;
+        bool visible = false;
+        std::uint64_t invalidations = 0;
+    };
+
+    struct Counters
+    {
+        std::uint64_t creates = 0;
+        std::uint64_t destroys = 0;
+        std::uint64_t moves = 0;
+        std::uint64_t shows = 0;
+        std::uint64_t hides = 0;
+        std::uint64_t regions = 0;
+    };
+
+    HeadlessSurfaceBackend() = default;
+    explicit HeadlessSurfaceBackend(std::vector<MonitorInfo> monitors) : m_monitors(std::move(monitors)) {}
+    ~HeadlessSurfaceBackend() override;
+
+    void SetMonitors(std::vector<MonitorInfo> monitors) { m_monitors = std::move(monitors); }
+
+    void EnumMonitors(std::vector<MonitorInfo>& out) override;
+    SurfaceHandle Create(const MonitorInfo& monitor) override;
+    void Destroy(SurfaceHandle surface) override;
+    void Reposition(SurfaceHandle surface, const MonitorInfo& monitor) override;
+    void Show(SurfaceHandle surface) override;
+    void Hide(SurfaceHandle surface) override;
+    void SetAlpha(SurfaceHandle surface, std::uint8_t alpha) override;
+    void Invalidate(SurfaceHandle surface) override;
+    void SetRegion(SurfaceHandle surface, const ScreenRegion& region) override;
+
+    // 直接显示预渲染好的整帧，相当于交换缓冲而不是复制像素
+    void Present(SurfaceHandle surface, std::shared_ptr<const OverlayFrame> frame);
+
+    static Surface* FromHandle(SurfaceHandle surface) { return reinterpret_cast<Surface*>(surface); }
+    // 以区域为裁剪的像素缓冲，软件渲染只填充可见部分
+    static PixelBuffer Pixels(SurfaceHandle surface);
+
+    const Counters& GetCounters() const { return m_counters; }
+    size_t LiveSurfaces() const { return m_live; }
+
+private:
+    std::vector<MonitorInfo> m_monitors;
+    Counters m_counters;
+    size_t m_live = 0;
+};
@@ -0,0 +1,135 @@
+#include "surface_tracking.h"
+
+const char* TrackedResource_Name(TrackedResource kind)
+{
+    switch (kind)
+    {
+    case TrackedResource::Surface: return "surface";
+    case TrackedResource::Pixels: return "pixels";
+    case TrackedResource::Frame: return "frame";
+    default: return "unknown";
+    }
+}
+
+void ResourceLedger::Acquire(TrackedResource kind)
+{
+    const size_t i = (size_t)kind;
+    m_live[i]++;
+    if (m_live[i] > m_peak[i])
+    {
+        m_peak[i] = m_live[i];
+    }
+    m_acquired++;
+}
+
+void ResourceLedger::Release(TrackedResource kind)
+{
+    const size_t i = (size_t)kind;
+    if (m_live[i] <= 0)
+    {
+        m_underflows++;
+        return;
+    }
+    m_live[i]--;
+}
+
+std::int64_t ResourceLedger::TotalLive() const
+{
+    std::int64_t total = 0;
+    for (std::int64_t live : m_live)
+    {
+        total += live;
+    }
+    return total;
+}
+
+void TrackingSurfaceBackend::EnumMonitors(std::vector<MonitorInfo>& out)
+{
+    m_inner.EnumMonitors(out);
+}
+
+SurfaceHandle TrackingSurfaceBackend::Create(const MonitorInfo& monitor)
+{
+    m_creates++;
+    if (m_failEvery != 0 && m_creates % m_failEvery == 0)
+    {
+        m_injected++;
+        return 0;
+    }
+    const SurfaceHandle surface = m_inner.Create(monitor);
+    if (surface)
+    {
+        m_live.insert(surface);
+        m_ledger.Acquire(TrackedResource::Surface);
+    }
+    return surface;
+}
+
+void TrackingSurfaceBackend::Destroy(SurfaceHandle surface)
+{
+    if (!Check(surface))
+    {
+        return;
+    }
+    m_live.erase(surface);
+    m_ledger.Release(TrackedResource::Surface);
+    m_inner.Destroy(surface);
+}
+
+void TrackingSurfaceBackend::Reposition(SurfaceHandle surface, const MonitorInfo& monitor)
+{
+    if (Check(surface))
+    {
+        m_inner.Reposition(surface, monitor);
+    }
+}
+
+void TrackingSurfaceBackend::Show(SurfaceHandle surface)
+{
+    if (Check(surface))
+    {
+        m_inner.Show(surface);
+    }
+}
+
+void TrackingSurfaceBackend::Hide(SurfaceHandle surface)
+{
+    if (Check(surface))
+    {
+        m_inner.Hide(surface);
+    }
+}
+
+void TrackingSurfaceBackend::SetAlpha(SurfaceHandle surface, std::uint8_t alpha)
+{
+    if (Check(surface))
+    {
+        m_inner.SetAlpha(surface, alpha);
+    }
+}
+
+void TrackingSurfaceBackend::Invalidate(SurfaceHandle surface)
+{
+    if (Check(surface))
+    {
+        m_inner.Invalidate(surface);
+    }
+}
+
+void TrackingSurfaceBackend::SetRegion(SurfaceHandle surface, const ScreenRegion& region)
+{
+    if (Check(surface))
+    {
+        m_inner.SetRegion(surface, region);
+    }
+}
+
+bool TrackingSurfaceBackend::Check(SurfaceHandle surface)
+{
+    if (m_live.count(surface) == 0)
+    {
+        m_invalidCalls++;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "overlay_surface.h"
+
+// 遮罩每次提醒都要经过创建/复用窗口、绘制、隐藏与销毁，失败分支上漏掉一次释放，
+// 运行几周后句柄数就会涨上去。这里按种类记账，供压力测试在每轮之后核对存活数量。
+
+enum class TrackedResource : std::uint8_t
+{
+    Surface = 0,    // 遮罩窗口
+    Pixels,         // 绘制用的像素缓冲（对应 Win32 的内存 DC 与 DIB）
+    Frame,          // 缓存的底图
+    Count,
+};
+
+const char* TrackedResource_Name(TrackedResource kind);
+
+class ResourceLedger
+{
+public:
+    void Acquire(TrackedResource kind);
+    // 释放次数多于获取次数时记为 underflow（重复释放）
+    void Release(TrackedResource kind);
+
+    std::int64_t Live(TrackedResource kind) const { return m_live[(size_t)kind]; }
+    std::int64_t Peak(TrackedResource kind) const { return m_peak[(size_t)kind]; }
+    std::int64_t TotalLive() const;
+    std::uint64_t Acquired() const { return m_acquired; }
+    std::uint64_t Underflows() const { return m_underflows; }
+
+private:
+    std::int64_t m_live[(size_t)TrackedResource::Count]{};
+    std::int64_t m_peak[(size_t)TrackedResource::Count]{};
+    std::uint64_t m_acquired = 0;
+    std::uint64_t m_underflows = 0;
+};
+
+// 包装另一个遮罩实现并记账：记录存活的遮罩，发现对已销毁或从未创建的遮罩的操作，
+// 并可按间隔让 Create 失败，走一遍 CreateWindowExW 失败的分支
+class TrackingSurfaceBackend final : public SurfaceBackend
+{
+public:
+    TrackingSurfaceBackend(SurfaceBackend& inner, ResourceLedger& ledger) : m_inner(inner), m_ledger(ledger) {}
+
+    // 每 n 次 Create 失败一次；0 表示不注入失败
+    void FailCreateEvery(std::uint32_t n) { m_failEvery = n; }
+
+    void EnumMonitors(std::vector<MonitorInfo>& out) override;
+    SurfaceHandle Create(const MonitorInfo& monitor) override;
+    void Destroy(SurfaceHandle surface) override;
+    void Reposition(SurfaceHandle surface, const MonitorInfo& monitor) override;
+    void Show(SurfaceHandle surface) override;
+    void Hide(SurfaceHandle surface) override;
+    void SetAlpha(SurfaceHandle surface, std::uint8_t alpha) override;
+    void Invalidate(SurfaceHandle surface) override;
+    void SetRegion(SurfaceHandle surface, const ScreenRegion& region) override;
+
+    bool IsLive(SurfaceHandle surface) const { return m_live.count(surface) != 0; }
+    size_t LiveSurfaces() const { return m_live.size(); }
+    std::uint64_t InjectedFailures() const { return m_injected; }
+    // 对未存活的遮罩的调用次数；这些调用不会转给被包装的实现
+    std::uint64_t InvalidCalls() const { return m_invalidCalls; }
+
+private:
+    bool Check(SurfaceHandle surface);
+
+    SurfaceBackend& m_inner;
+    ResourceLedger& m_ledger;
+    std::unordered_set<SurfaceHandle> m_live;
+    std::uint32_t m_failEvery = 0;
+    std::uint64_t m_creates = 0;
+    std::uint64_t m_injected = 0;
+    std::uint64_t m_invalidCalls = 0;
+};
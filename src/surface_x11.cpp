@@ -0,0 +1,543 @@
+#include "surface_x11.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+// Xlib 定义了 None、Bool、Status 等宏，放在项目头文件之后
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xresource.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/shape.h>
+#if defined(SSR_HAVE_XRANDR)
+#include <X11/extensions/Xrandr.h>
+#endif
+#if defined(SSR_HAVE_XINERAMA)
+#include <X11/extensions/Xinerama.h>
+#endif
+
+struct X11SurfaceBackend::Surface
+{
+    Window window = 0;
+    MonitorInfo monitor;
+    XImage* image = nullptr;
+    XShmSegmentInfo shm{};
+    bool shmAttached = false;
+    bool uploadPending = false;
+    bool painted = false;
+    bool visible = false;
+    bool shaped = false;
+    ScreenRegion region;    // shaped 时有效
+};
+
+namespace
+{
+    // 矩形太碎时整块上传外框，请求数比多传的像素更贵
+    constexpr size_t UPLOAD_MAX_RECTS = 64;
+
+    // XShmAttach 在远程显示上会异步失败，临时换掉错误处理函数来发现这种情况
+    bool g_attachFailed = false;
+
+    int OnAttachError(Display*, XErrorEvent*)
+    {
+        g_attachFailed = true;
+        return 0;
+    }
+
+    int ReadXftDpi(Display* display)
+    {
+        const char* resources = XResourceManagerString(display);
+        if (!resources)
+        {
+            return 96;
+        }
+        const char* p = std::strstr(resources, "Xft.dpi:");
+        if (!p)
+        {
+            return 96;
+        }
+        const double dpi = std::atof(p + std::strlen("Xft.dpi:"));
+        return dpi >= 48 && dpi <= 960 ? (int)(dpi + 0.5) : 96;
+    }
+}
+
+_XDisplay* X11_OpenDisplay()
+{
+    return XOpenDisplay(nullptr);
+}
+
+void X11_CloseDisplay(_XDisplay* display)
+{
+    if (display)
+    {
+        XCloseDisplay(display);
+    }
+}
+
+X11SurfaceBackend::X11SurfaceBackend(_XDisplay* display, bool allowShm) : m_display(display)
+{
+    m_screen = DefaultScreen(display);
+    m_root = RootWindow(display, m_screen);
+    m_opacityAtom = XInternAtom(display, "_NET_WM_WINDOW_OPACITY", False);
+
+    XVisualInfo info{};
+    if (XMatchVisualInfo(display, m_screen, 32, TrueColor, &info))
+    {
+        m_argb = true;
+        m_visual = info.visual;
+        m_depth = 32;
+        m_colormap = XCreateColormap(display, m_root, info.visual, AllocNone);
+        m_ownColormap = true;
+    }
+    else
+    {
+        m_visual = DefaultVisual(display, m_screen);
+        m_depth = DefaultDepth(display, m_screen);
+        m_colormap = DefaultColormap(display, m_screen);
+    }
+
+    int major = 0;
+    int minor = 0;
+    Bool pixmaps = False;
+    m_shm = allowShm && XShmQueryVersion(display, &major, &minor, &pixmaps);
+}
+
+X11SurfaceBackend::~X11SurfaceBackend()
+{
+    while (!m_surfaces.empty())
+    {
+        Destroy(reinterpret_cast<SurfaceHandle>(m_surfaces.back()));
+    }
+    if (m_gc)
+    {
+        XFreeGC(m_display, static_cast<GC>(m_gc));
+    }
+    if (m_ownColormap)
+    {
+        XFreeColormap(m_display, m_colormap);
+    }
+    XFlush(m_display);
+}
+
+void X11SurfaceBackend::EnumMonitors(std::vector<MonitorInfo>& out)
+{
+    out.clear();
+    const int dpi = ReadXftDpi(m_display);
+#if defined(SSR_HAVE_XRANDR)
+    int count = 0;
+    if (XRRMonitorInfo* monitors = XRRGetMonitors(m_display, m_root, True, &count))
+    {
+        for (int i = 0; i < count; i++)
+        {
+            const XRRMonitorInfo& m = monitors[i];
+            out.push_back({ ScreenRect{ m.x, m.y, m.x + m.width, m.y + m.height }, dpi });
+        }
+        XRRFreeMonitors(monitors);
+    }
+#endif
+#if defined(SSR_HAVE_XINERAMA)
+    if (out.empty() && XineramaIsActive(m_display))
+    {
+        int count = 0;
+        if (XineramaScreenInfo* screens = XineramaQueryScreens(m_display, &count))
+        {
+            for (int i = 0; i < count; i++)
+            {
+                const XineramaScreenInfo& s = screens[i];
+                out.push_back({ ScreenRect{ s.x_org, s.y_org, s.x_org + s.width, s.y_org + s.height }, dpi });
+            }
+            XFree(screens);
+        }
+    }
+#endif
+    if (out.empty())
+    {
+        out.push_back({ ScreenRect{ 0, 0, DisplayWidth(m_display, m_screen), DisplayHeight(m_display, m_screen) }, dpi });
+    }
+}
+
+bool X11SurfaceBackend::AllocImage(Surface& s, int width, int height)
+{
+    Visual* visual = static_cast<Visual*>(m_visual);
+    if (m_shm)
+    {
+        s.image = XShmCreateImage(m_display, visual, (unsigned)m_depth, ZPixmap, nullptr, &s.shm, (unsigned)width, (unsigned)height);
+        if (s.image && s.image->bits_per_pixel == 32)
+        {
+            s.shm.shmid = shmget(IPC_PRIVATE, (size_t)s.image->bytes_per_line * (size_t)height, IPC_CREAT | 0600);
+            if (s.shm.shmid >= 0)
+            {
+                s.shm.shmaddr = s.image->data = static_cast<char*>(shmat(s.shm.shmid, nullptr, 0));
+                s.shm.readOnly = False;
+                XSync(m_display, False);
+                g_attachFailed = false;
+                auto previous = XSetErrorHandler(OnAttachError);
+                XShmAttach(m_display, &s.shm);
+                XSync(m_display, False);
+                XSetErrorHandler(previous);
+                // 两边都映射后就可以标记删除，进程退出时由内核回收
+                shmctl(s.shm.shmid, IPC_RMID, nullptr);
+                if (s.shm.shmaddr != reinterpret_cast<char*>(-1) && !g_attachFailed)
+                {
+                    s.shmAttached = true;
+                    return true;
+                }
+                if (s.shm.shmaddr != reinterpret_cast<char*>(-1))
+                {
+                    shmdt(s.shm.shmaddr);
+                }
+            }
+            s.image->data = nullptr;
+        }
+        if (s.image)
+        {
+            XDestroyImage(s.image);
+            s.image = nullptr;
+        }
+        // 以后都不再尝试共享内存
+        m_shm = false;
+    }
+
+    const size_t stride = (size_t)width * 4;
+    char* data = static_cast<char*>(std::calloc(stride, (size_t)height));
+    if (!data)
+    {
+        return false;
+    }
+    s.image = XCreateImage(m_display, visual, (unsigned)m_depth, ZPixmap, 0, data, (unsigned)width, (unsigned)height, 32, (int)stride);
+    if (!s.image || s.image->bits_per_pixel != 32)
+    {
+        if (s.image)
+        {
+            XDestroyImage(s.image);
+            s.image = nullptr;
+        }
+        else
+        {
+            std::free(data);
+        }
+        return false;
+    }
+    return true;
+}
+
+void X11SurfaceBackend::FreeImage(Surface& s)
+{
+    if (!s.image)
+    {
+        return;
+    }
+    WaitUpload(s);
+    if (s.shmAttached)
+    {
+        XShmDetach(m_display, &s.shm);
+        XSync(m_display, False);
+        shmdt(s.shm.shmaddr);
+        s.image->data = nullptr;
+        s.shmAttached = false;
+    }
+    XDestroyImage(s.image);
+    s.image = nullptr;
+    s.painted = false;
+}
+
+void X11SurfaceBackend::WaitUpload(Surface& s)
+{
+    if (s.uploadPending)
+    {
+        XSync(m_display, False);
+        s.uploadPending = false;
+    }
+}
+
+SurfaceHandle X11SurfaceBackend::Create(const MonitorInfo& monitor)
+{
+    const int width = std::max(1, monitor.rect.Width());
+    const int height = std::max(1, monitor.rect.Height());
+
+    XSetWindowAttributes attrs{};
+    attrs.override_redirect = True;
+    attrs.colormap = m_colormap;
+    attrs.border_pixel = 0;
+    attrs.background_pixel = 0;
+    attrs.event_mask = ExposureMask;
+    const Window window = XCreateWindow(m_display, m_root, monitor.rect.left, monitor.rect.top, (unsigned)width, (unsigned)height, 0,
+        m_depth, InputOutput, static_cast<Visual*>(m_visual),
+        CWOverrideRedirect | CWColormap | CWBorderPixel | CWBackPixel | CWEventMask, &attrs);
+    if (!window)
+    {
+        return 0;
+    }
+    // 空的输入形状：键鼠事件穿透到下面的窗口，活动检测不依赖遮罩
+    XShapeCombineRectangles(m_display, window, ShapeInput, 0, 0, nullptr, 0, ShapeSet, Unsorted);
+    XStoreName(m_display, window, "ScreenSaverReminder");
+
+    auto* s = new Surface();
+    s->window = window;
+    s->monitor = monitor;
+    if (!AllocImage(*s, width, height))
+    {
+        XDestroyWindow(m_display, window);
+        delete s;
+        return 0;
+    }
+    if (!m_gc)
+    {
+        m_gc = XCreateGC(m_display, window, 0, nullptr);
+    }
+    m_surfaces.push_back(s);
+    m_stats.creates++;
+    SetAlpha(reinterpret_cast<SurfaceHandle>(s), 0);
+    return reinterpret_cast<SurfaceHandle>(s);
+}
+
+void X11SurfaceBackend::Destroy(SurfaceHandle surface)
+{
+    auto* s = reinterpret_cast<Surface*>(surface);
+    auto it = std::find(m_surfaces.begin(), m_surfaces.end(), s);
+    if (it == m_surfaces.end())
+    {
+        return;
+    }
+    m_surfaces.erase(it);
+    FreeImage(*s);
+    XDestroyWindow(m_display, s->window);
+    XFlush(m_display);
+    delete s;
+}
+
+void X11SurfaceBackend::Reposition(SurfaceHandle surface, const MonitorInfo& monitor)
+{
+    auto* s = reinterpret_cast<Surface*>(surface);
+    const int width = std::max(1, monitor.rect.Width());
+    const int height = std::max(1, monitor.rect.Height());
+    const bool resized = !s->image || width != s->image->width || height != s->image->height;
+    s->monitor = monitor;
+    XMoveResizeWindow(m_display, s->window, monitor.rect.left, monitor.rect.top, (unsigned)width, (unsigned)height);
+    if (resized)
+    {
+        FreeImage(*s);
+        AllocImage(*s, width, height);
+    }
+    if (s->visible)
+    {
+        Invalidate(surface);
+    }
+    XFlush(m_display);
+}
+
+void X11SurfaceBackend::Show(SurfaceHandle surface)
+{
+    auto* s = reinterpret_cast<Surface*>(surface);
+    s->visible = true;
+    XMapRaised(m_display, s->window);
+    XFlush(m_display);
+}
+
+void X11SurfaceBackend::Hide(SurfaceHandle surface)
+{
+    auto* s = reinterpret_cast<Surface*>(surface);
+    s->visible = false;
+    XUnmapWindow(m_display, s->window);
+    XFlush(m_display);
+}
+
+void X11SurfaceBackend::SetAlpha(SurfaceHandle surface, std::uint8_t alpha)
+{
+    auto* s = reinterpret_cast<Surface*>(surface);
+    // 0xFFFFFFFF 为完全不透明
+    const unsigned long opacity = (unsigned long)alpha * 0x01010101ul;
+    XChangeProperty(m_display, s->window, m_opacityAtom, XA_CARDINAL, 32, PropModeReplace,
+        reinterpret_cast<const unsigned char*>(&opacity), 1);
+    XFlush(m_display);
+}
+
+void X11SurfaceBackend::Invalidate(SurfaceHandle surface)
+{
+    auto* s = reinterpret_cast<Surface*>(surface);
+    if (!s->image || !m_painter)
+    {
+        return;
+    }
+    WaitUpload(*s);
+    PixelBuffer buf = Pixels(surface);
+    m_painter(surface, s->monitor, buf);
+    const ScreenRect full{ 0, 0, buf.width, buf.height };
+    FillAlpha(*s, full);
+    s->painted = true;
+    m_stats.paints++;
+    UploadWithin(*s, full);
+}
+
+void X11SurfaceBackend::PaintRect(SurfaceHandle surface, const ScreenRect& rect, const Painter& painter)
+{
+    auto* s = reinterpret_cast<Surface*>(surface);
+    if (!s->image || !s->painted)
+    {
+        return;
+    }
+    const ScreenRect limit{ std::max(0, rect.left), std::max(0, rect.top),
+        std::min(s->image->width, rect.right), std::min(s->image->height, rect.bottom) };
+    if (limit.left >= limit.right || limit.top >= limit.bottom)
+    {
+        return;
+    }
+    WaitUpload(*s);
+    PixelBuffer buf = Pixels(surface);
+    painter(surface, s->monitor, buf);
+    FillAlpha(*s, limit);
+    m_stats.paints++;
+    UploadWithin(*s, limit);
+}
+
+void X11SurfaceBackend::FillAlpha(Surface& s, const ScreenRect& limit)
+{
+    if (!m_argb)
+    {
+        return;
+    }
+    // 软件渲染输出 0x00RRGGBB；ARGB 视觉下 alpha 为 0 会被合成器当作全透明
+    PixelBuffer buf = Pixels(reinterpret_cast<SurfaceHandle>(&s));
+    auto setAlpha = [&](const ScreenRect& r)
+    {
+        for (int y = std::max(limit.top, r.top); y < std::min(limit.bottom, r.bottom); y++)
+        {
+            std::uint32_t* row = buf.pixels + (size_t)y * (size_t)buf.stride;
+            for (int x = std::max(limit.left, r.left); x < std::min(limit.right, r.right); x++)
+            {
+                row[x] |= 0xFF000000u;
+            }
+        }
+    };
+    if (s.shaped)
+    {
+        for (const ScreenRect& r : s.region.Rects())
+        {
+            setAlpha(r);
+        }
+    }
+    else
+    {
+        setAlpha(ScreenRect{ 0, 0, buf.width, buf.height });
+    }
+}
+
+void X11SurfaceBackend::SetRegion(SurfaceHandle surface, const ScreenRegion& region)
+{
+    auto* s = reinterpret_cast<Surface*>(surface);
+    const ScreenRect full{ 0, 0, s->monitor.rect.Width(), s->monitor.rect.Height() };
+    s->shaped = !region.IsExactly(full);
+    if (!s->shaped)
+    {
+        s->region.Clear();
+        XShapeCombineMask(m_display, s->window, ShapeBounding, 0, 0, 0, ShapeSet);
+    }
+    else
+    {
+        s->region = region;
+        std::vector<XRectangle> rects;
+        rects.reserve(region.Rects().size());
+        for (const ScreenRect& r : region.Rects())
+        {
+            rects.push_back(XRectangle{ (short)r.left, (short)r.top, (unsigned short)r.Width(), (unsigned short)r.Height() });
+        }
+        XShapeCombineRectangles(m_display, s->window, ShapeBounding, 0, 0, rects.data(), (int)rects.size(), ShapeSet, YXBanded);
+    }
+    m_stats.shapes++;
+    XFlush(m_display);
+}
+
+void X11SurfaceBackend::Upload(SurfaceHandle surface)
+{
+    auto* s = reinterpret_cast<Surface*>(surface);
+    if (!s->image || !s->painted)
+    {
+        return;
+    }
+    UploadWithin(*s, ScreenRect{ 0, 0, s->image->width, s->image->height });
+}
+
+void X11SurfaceBackend::UploadWithin(Surface& s, const ScreenRect& limit)
+{
+    GC gc = static_cast<GC>(m_gc);
+    auto put = [&](const ScreenRect& r)
+    {
+        const int left = std::max(limit.left, r.left);
+        const int top = std::max(limit.top, r.top);
+        const int right = std::min(limit.right, r.right);
+        const int bottom = std::min(limit.bottom, r.bottom);
+        if (left >= right || top >= bottom)
+        {
+            return;
+        }
+        const unsigned w = (unsigned)(right - left);
+        const unsigned h = (unsigned)(bottom - top);
+        if (s.shmAttached)
+        {
+            XShmPutImage(m_display, s.window, gc, s.image, left, top, left, top, w, h, False);
+            m_stats.shmUploads++;
+        }
+        else
+        {
+            XPutImage(m_display, s.window, gc, s.image, left, top, left, top, w, h);
+        }
+        m_stats.uploads++;
+        m_stats.uploadBytes += (std::uint64_t)w * 4 * h;
+    };
+    if (!s.shaped)
+    {
+        put(ScreenRect{ 0, 0, s.image->width, s.image->height });
+    }
+    else if (s.region.Rects().size() > UPLOAD_MAX_RECTS)
+    {
+        put(s.region.Bounds());
+    }
+    else
+    {
+        for (const ScreenRect& r : s.region.Rects())
+        {
+            put(r);
+        }
+    }
+    s.uploadPending = s.shmAttached;
+    XFlush(m_display);
+}
+
+bool X11SurfaceBackend::HandleExpose(unsigned long window)
+{
+    for (Surface* s : m_surfaces)
+    {
+        if (s->window == window)
+        {
+            m_stats.exposes++;
+            Upload(reinterpret_cast<SurfaceHandle>(s));
+            return true;
+        }
+    }
+    return false;
+}
+
+PixelBuffer X11SurfaceBackend::Pixels(SurfaceHandle surface) const
+{
+    const auto* s = reinterpret_cast<const Surface*>(surface);
+    PixelBuffer buf;
+    if (s->image)
+    {
+        buf.pixels = reinterpret_cast<std::uint32_t*>(s->image->data);
+        buf.width = s->image->width;
+        buf.height = s->image->height;
+        buf.stride = s->image->bytes_per_line / 4;
+        buf.clip = s->shaped ? &s->region : nullptr;
+    }
+    return buf;
+}
+
+unsigned long X11SurfaceBackend::WindowOf(SurfaceHandle surface) const
+{
+    return reinterpret_cast<const Surface*>(surface)->window;
+}
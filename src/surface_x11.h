@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "overlay_surface.h"
+#include "screen_region.h"
+#include "soft_render.h"
+
+struct _XDisplay;
+
+// 打开 $DISPLAY；失败返回 nullptr。调用方不必包含 Xlib（Xlib 的宏与 ControlOp::Status 等冲突）
+_XDisplay* X11_OpenDisplay();
+void X11_CloseDisplay(_XDisplay* display);
+
+struct X11SurfaceStats
+{
+    std::uint64_t creates = 0;
+    std::uint64_t paints = 0;
+    std::uint64_t uploads = 0;
+    std::uint64_t shmUploads = 0;
+    std::uint64_t uploadBytes = 0;
+    std::uint64_t exposes = 0;
+    std::uint64_t shapes = 0;
+};
+
+// X11 遮罩：每个显示器一个 override-redirect 窗口，输入形状为空（点击穿透），
+// 有 32 位 ARGB 视觉时使用之，淡入淡出通过 _NET_WM_WINDOW_OPACITY 交给合成器。
+// 像素放在 MIT-SHM 共享内存里，绘制后由 X 服务器直接读取，不经过套接字复制；
+// 远程显示或没有 MIT-SHM 时退回 XPutImage。
+// 设置了区域的遮罩用 SHAPE 扩展裁掉区域外的部分，绘制、补 alpha 与上传也只处理区域内的矩形。
+class X11SurfaceBackend final : public SurfaceBackend
+{
+public:
+    // 在 pixels 上画出 monitor 对应的画面；pixels.clip 非空时只需画区域内的部分
+    using Painter = std::function<void(SurfaceHandle surface, const MonitorInfo& monitor, PixelBuffer& pixels)>;
+
+    // display 由调用方打开与关闭；allowShm 为 false 时总是用 XPutImage（对比测试用）
+    explicit X11SurfaceBackend(_XDisplay* display, bool allowShm = true);
+    ~X11SurfaceBackend() override;
+
+    X11SurfaceBackend(const X11SurfaceBackend&) = delete;
+    X11SurfaceBackend& operator=(const X11SurfaceBackend&) = delete;
+
+    void SetPainter(Painter painter) { m_painter = std::move(painter); }
+
+    // RandR 1.5 的 monitor 列表，其次 Xinerama，都没有时整个屏幕算一个显示器；DPI 取 Xft.dpi
+    void EnumMonitors(std::vector<MonitorInfo>& out) override;
+    SurfaceHandle Create(const MonitorInfo& monitor) override;
+    void Destroy(SurfaceHandle surface) override;
+    void Reposition(SurfaceHandle surface, const MonitorInfo& monitor) override;
+    void Show(SurfaceHandle surface) override;
+    void Hide(SurfaceHandle surface) override;
+    void SetAlpha(SurfaceHandle surface, std::uint8_t alpha) override;
+    // 重新绘制并上传
+    void Invalidate(SurfaceHandle surface) override;
+    void SetRegion(SurfaceHandle surface, const ScreenRegion& region) override;
+
+    // 只把已有像素重新上传到窗口（Expose），不重新绘制
+    void Upload(SurfaceHandle surface);
+    // 由 painter 改写 rect 内的像素后只上传 rect（与区域的交集）；遮罩还没画过时不做任何事
+    void PaintRect(SurfaceHandle surface, const ScreenRect& rect, const Painter& painter);
+    // Expose 事件所属的遮罩；不是遮罩窗口时返回 false
+    bool HandleExpose(unsigned long window);
+
+    PixelBuffer Pixels(SurfaceHandle surface) const;
+    unsigned long WindowOf(SurfaceHandle surface) const;
+
+    bool UsesShm() const { return m_shm; }
+    bool UsesArgb() const { return m_argb; }
+    size_t LiveSurfaces() const { return m_surfaces.size(); }
+    const X11SurfaceStats& Stats() const { return m_stats; }
+
+private:
+    struct Surface;
+
+    bool AllocImage(Surface& s, int width, int height);
+    void FreeImage(Surface& s);
+    // 上一次 XShmPutImage 完成前不能改写共享内存
+    void WaitUpload(Surface& s);
+    // ARGB 视觉下把 limit 内（与区域的交集）像素的 alpha 置满
+    void FillAlpha(Surface& s, const ScreenRect& limit);
+    void UploadWithin(Surface& s, const ScreenRect& limit);
+
+    _XDisplay* m_display;
+    int m_screen = 0;
+    unsigned long m_root = 0;
+    void* m_visual = nullptr;
+    int m_depth = 24;
+    unsigned long m_colormap = 0;
+    bool m_ownColormap = false;
+    void* m_gc = nullptr;
+    unsigned long m_opacityAtom = 0;
+    bool m_shm = false;
+    bool m_argb = false;
+    Painter m_painter;
+    std::vector<Surface*> m_surfaces;
+    X11SurfaceStats m_stats;
+};
@@ -0,0 +1,342 @@
+#include "text_template.h"
+
+namespace
+{
+    struct VarName
+    {
+        std::wstring_view name;
+        TemplateVar var;
+    };
+
+    constexpr VarName VAR_NAMES[] = {
+        { L"time", TemplateVar::Time },
+        { L"date", TemplateVar::Date },
+        { L"next_break", TemplateVar::NextBreak },
+        { L"breaks_today", TemplateVar::BreaksToday },
+        { L"idle_minutes", TemplateVar::IdleMinutes },
+    };
+
+    int FindVar(std::wstring_view name)
+    {
+        for (const VarName& v : VAR_NAMES)
+        {
+            if (v.name == name)
+            {
+                return (int)v.var;
+            }
+        }
+        return -1;
+    }
+
+    // 变量输入的数值摘要：摘要不变时不必重新格式化
+    std::int64_t InputKey(int var, const TemplateInputs& in)
+    {
+        switch ((TemplateVar)var)
+        {
+        case TemplateVar::Time:
+            return (std::int64_t)in.hour * 3600 + in.minute * 60 + in.second;
+        case TemplateVar::Date:
+            return (std::int64_t)in.year * 10000 + in.month * 100 + in.day;
+        case TemplateVar::NextBreak:
+            return in.nextBreakHour < 0 ? -1 : (std::int64_t)in.nextBreakHour * 60 + in.nextBreakMinute;
+        case TemplateVar::BreaksToday:
+            return in.breaksToday;
+        case TemplateVar::IdleMinutes:
+            return in.idleMinutes;
+        }
+        return 0;
+    }
+
+    void AppendPadded(std::wstring& out, int value, int width)
+    {
+        wchar_t digits[12];
+        int n = 0;
+        unsigned v = value < 0 ? 0u : (unsigned)value;
+        do
+        {
+            digits[n++] = (wchar_t)(L'0' + v % 10);
+            v /= 10;
+        } while (v && n < 12);
+        while (n < width)
+        {
+            digits[n++] = L'0';
+        }
+        while (n > 0)
+        {
+            out.push_back(digits[--n]);
+        }
+    }
+
+    void MixHash(std::uint64_t& h, std::uint32_t v)
+    {
+        // FNV-1a
+        for (int i = 0; i < 4; i++)
+        {
+            h ^= (v >> (i * 8)) & 0xFFu;
+            h *= 0x100000001B3ull;
+        }
+    }
+}
+
+void TextTemplate::Format(TemplateVar var, const TemplateInputs& in, std::wstring& out)
+{
+    out.clear();
+    switch (var)
+    {
+    case TemplateVar::Time:
+        AppendPadded(out, in.hour, 2);
+        out.push_back(L':');
+        AppendPadded(out, in.minute, 2);
+        out.push_back(L':');
+        AppendPadded(out, in.second, 2);
+        break;
+    case TemplateVar::Date:
+        AppendPadded(out, in.year, 4);
+        out.push_back(L'-');
+        AppendPadded(out, in.month, 2);
+        out.push_back(L'-');
+        AppendPadded(out, in.day, 2);
+        break;
+    case TemplateVar::NextBreak:
+        if (in.nextBreakHour < 0)
+        {
+            out.append(L"--:--");
+            break;
+        }
+        AppendPadded(out, in.nextBreakHour, 2);
+        out.push_back(L':');
+        AppendPadded(out, in.nextBreakMinute, 2);
+        break;
+    case TemplateVar::BreaksToday:
+        AppendPadded(out, in.breaksToday, 1);
+        break;
+    case TemplateVar::IdleMinutes:
+        AppendPadded(out, in.idleMinutes, 1);
+        break;
+    }
+}
+
+void TextTemplate::Compile(std::wstring_view source)
+{
+    m_source.assign(source);
+    m_sourceHash = 0xCBF29CE484222325ull;
+    MixHash(m_sourceHash, (std::uint32_t)source.size());
+    for (wchar_t ch : source)
+    {
+        MixHash(m_sourceHash, (std::uint32_t)ch);
+    }
+
+    m_literals.clear();
+    m_segments.clear();
+    m_lines.clear();
+    for (auto& lines : m_varLines)
+    {
+        lines.clear();
+    }
+    m_usedVars = 0;
+    m_first = true;
+    m_changed.clear();
+
+    auto appendLiteral = [this](const wchar_t* text, size_t length)
+    {
+        LineData& line = m_lines.back();
+        if (line.segmentCount == 0 || m_segments.back().var >= 0)
+        {
+            Segment seg;
+            seg.offset = (std::uint32_t)m_literals.size();
+            m_segments.push_back(seg);
+            line.segmentCount++;
+        }
+        m_literals.append(text, length);
+        m_segments.back().length += (std::uint32_t)length;
+    };
+
+    // 与 CountLines 一致：空文字没有行，否则按 \n 分行，\r 丢弃
+    size_t pos = 0;
+    while (pos < source.size())
+    {
+        size_t end = source.find(L'\n', pos);
+        if (end == std::wstring_view::npos)
+        {
+            end = source.size();
+        }
+        LineData line;
+        line.firstSegment = (std::uint32_t)m_segments.size();
+        m_lines.push_back(std::move(line));
+        const std::uint32_t lineIndex = (std::uint32_t)(m_lines.size() - 1);
+
+        size_t i = pos;
+        while (i < end)
+        {
+            const wchar_t ch = source[i];
+            if (ch == L'\r')
+            {
+                i++;
+                continue;
+            }
+            if ((ch == L'{' || ch == L'}') && i + 1 < end && source[i + 1] == ch)
+            {
+                appendLiteral(&source[i], 1);
+                i += 2;
+                continue;
+            }
+            if (ch == L'{')
+            {
+                const size_t close = source.find(L'}', i + 1);
+                const int var = close < end ? FindVar(source.substr(i + 1, close - i - 1)) : -1;
+                if (var >= 0)
+                {
+                    Segment seg;
+                    seg.var = var;
+                    m_segments.push_back(seg);
+                    LineData& current = m_lines.back();
+                    current.segmentCount++;
+                    current.dynamic = true;
+                    auto& lines = m_varLines[var];
+                    if (lines.empty() || lines.back() != lineIndex)
+                    {
+                        lines.push_back(lineIndex);
+                    }
+                    m_usedVars |= 1u << var;
+                    i = close + 1;
+                    continue;
+                }
+            }
+            appendLiteral(&source[i], 1);
+            i++;
+        }
+        pos = end + 1;
+        if (end + 1 == source.size())
+        {
+            // 末尾的换行也开始一个空行
+            LineData last;
+            last.firstSegment = (std::uint32_t)m_segments.size();
+            m_lines.push_back(std::move(last));
+        }
+    }
+    m_lineMarked.assign(m_lines.size(), 0);
+}
+
+void TextTemplate::Rebuild(LineData& line)
+{
+    line.text.clear();
+    for (std::uint32_t i = 0; i < line.segmentCount; i++)
+    {
+        const Segment& seg = m_segments[line.firstSegment + i];
+        if (seg.var >= 0)
+        {
+            line.text.append(m_values[seg.var]);
+        }
+        else
+        {
+            line.text.append(m_literals, seg.offset, seg.length);
+        }
+    }
+}
+
+size_t TextTemplate::Update(const TemplateInputs& inputs)
+{
+    m_changed.clear();
+    for (int var = 0; var < TEMPLATE_VAR_COUNT; var++)
+    {
+        if (!(m_usedVars & (1u << var)))
+        {
+            continue;
+        }
+        const std::int64_t key = InputKey(var, inputs);
+        if (!m_first && key == m_inputKey[var])
+        {
+            continue;
+        }
+        m_inputKey[var] = key;
+        Format((TemplateVar)var, inputs, m_scratch);
+        if (!m_first && m_scratch == m_values[var])
+        {
+            continue;
+        }
+        m_values[var].swap(m_scratch);
+        for (std::uint32_t line : m_varLines[var])
+        {
+            if (!m_lineMarked[line])
+            {
+                m_lineMarked[line] = 1;
+                m_changed.push_back(line);
+            }
+        }
+    }
+    if (m_first)
+    {
+        m_first = false;
+        m_changed.clear();
+        for (std::uint32_t line = 0; line < (std::uint32_t)m_lines.size(); line++)
+        {
+            m_lineMarked[line] = 1;
+            m_changed.push_back(line);
+        }
+    }
+    if (m_changed.empty())
+    {
+        return 0;
+    }
+    m_revision++;
+    for (std::uint32_t index : m_changed)
+    {
+        LineData& line = m_lines[index];
+        Rebuild(line);
+        line.revision = m_revision;
+        m_lineMarked[index] = 0;
+    }
+    return m_changed.size();
+}
+
+std::uint64_t TextTemplate::ValuesHash() const
+{
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    for (int var = 0; var < TEMPLATE_VAR_COUNT; var++)
+    {
+        if (!(m_usedVars & (1u << var)))
+        {
+            continue;
+        }
+        MixHash(h, (std::uint32_t)var);
+        for (wchar_t ch : m_values[var])
+        {
+            MixHash(h, (std::uint32_t)ch);
+        }
+    }
+    return h;
+}
+
+std::wstring TextTemplate::Expand() const
+{
+    std::wstring out;
+    for (size_t i = 0; i < m_lines.size(); i++)
+    {
+        if (i)
+        {
+            out.push_back(L'\n');
+        }
+        out.append(m_lines[i].text);
+    }
+    return out;
+}
+
+void TextLineLayout::Relayout(const TextTemplate& text)
+{
+    m_tops.resize(m_heights.size());
+    m_total = 0;
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    bool dynamic = false;
+    for (size_t i = 0; i < m_heights.size(); i++)
+    {
+        m_tops[i] = m_total;
+        m_total += m_heights[i];
+        if (text.IsDynamicLine(i))
+        {
+            dynamic = true;
+            MixHash(h, (std::uint32_t)i);
+            MixHash(h, (std::uint32_t)m_heights[i]);
+        }
+    }
+    m_signature = dynamic ? h : 0;
+}
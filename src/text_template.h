@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// text.txt 中的占位符：{time} {date} {next_break} {breaks_today} {idle_minutes}。
+// 载入时编译成按行分组的文字段与变量段；每次计时只格式化输入变化了的变量，
+// 只重新拼接引用了值变化的变量的行，代价与模板长度无关。
+// {{ 与 }} 为字面的花括号，不认识的 {name} 原样显示。
+enum class TemplateVar : int
+{
+    Time = 0,         // HH:MM:SS
+    Date = 1,         // YYYY-MM-DD
+    NextBreak = 2,    // 下一次提醒的时刻 HH:MM，未知时为 --:--
+    BreaksToday = 3,  // 今天的提醒次数（含正在显示的这一次）
+    IdleMinutes = 4,  // 距最近一次键鼠活动的分钟数
+};
+
+constexpr int TEMPLATE_VAR_COUNT = 5;
+
+// 宿主按本地时间填写
+struct TemplateInputs
+{
+    int year = 1970;
+    int month = 1;
+    int day = 1;
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    int nextBreakHour = -1;   // 未知（计时暂停等）时为 -1
+    int nextBreakMinute = 0;
+    int breaksToday = 0;
+    int idleMinutes = 0;
+};
+
+class TextTemplate
+{
+public:
+    void Compile(std::wstring_view source);
+    const std::wstring& Source() const { return m_source; }
+    // 模板源文字的哈希，排版缓存据此判断模板是否换过
+    std::uint64_t SourceHash() const { return m_sourceHash; }
+
+    bool HasVariables() const { return m_usedVars != 0; }
+    // 引用到的变量，第 i 位对应 TemplateVar i
+    std::uint32_t UsedVars() const { return m_usedVars; }
+
+    // 返回内容变化了的行数，行号见 ChangedLines；编译后第一次调用时所有行都算变化
+    size_t Update(const TemplateInputs& inputs);
+    const std::vector<std::uint32_t>& ChangedLines() const { return m_changed; }
+    // 每次有行变化时加一；排版缓存据此判断只需看 ChangedLines 还是要逐行比较
+    std::uint64_t Revision() const { return m_revision; }
+
+    size_t LineCount() const { return m_lines.size(); }
+    std::wstring_view Line(size_t index) const { return m_lines[index].text; }
+    bool IsDynamicLine(size_t index) const { return m_lines[index].dynamic; }
+    // 这一行最近一次变化时的 Revision
+    std::uint64_t LineRevision(size_t index) const { return m_lines[index].revision; }
+
+    // 当前各变量值的哈希：预渲染的画面只在值相同时可以直接输出
+    std::uint64_t ValuesHash() const;
+    // 展开后的整段文字，行间用 \n 连接（设置预览等不在计时路径上的地方用）
+    std::wstring Expand() const;
+
+    // 单个变量的格式化，不经过模板（基准测试对比用）
+    static void Format(TemplateVar var, const TemplateInputs& inputs, std::wstring& out);
+
+private:
+    struct Segment
+    {
+        std::uint32_t offset = 0;   // 文字段在 m_literals 中的位置
+        std::uint32_t length = 0;
+        int var = -1;               // >= 0 时为变量段
+    };
+
+    struct LineData
+    {
+        std::uint32_t firstSegment = 0;
+        std::uint32_t segmentCount = 0;
+        bool dynamic = false;
+        std::uint64_t revision = 0;
+        std::wstring text;
+    };
+
+    void Rebuild(LineData& line);
+
+    std::wstring m_source;
+    std::uint64_t m_sourceHash = 0;
+    std::wstring m_literals;
+    std::vector<Segment> m_segments;
+    std::vector<LineData> m_lines;
+    std::vector<std::uint32_t> m_varLines[TEMPLATE_VAR_COUNT];
+    std::uint32_t m_usedVars = 0;
+
+    bool m_first = true;
+    std::int64_t m_inputKey[TEMPLATE_VAR_COUNT]{};
+    std::wstring m_values[TEMPLATE_VAR_COUNT];
+    std::wstring m_scratch;
+    std::vector<std::uint32_t> m_changed;
+    std::vector<std::uint8_t> m_lineMarked;
+    std::uint64_t m_revision = 0;
+};
+
+// 按模板逐行排版后的各行高度（像素或行数，由 measure 决定）。只重新测量内容变过的行，
+// 行高都没变时不重新计算各行位置。key 为影响测量的参数（宽度、DPI、字体），变化时全部重新测量
+class TextLineLayout
+{
+public:
+    // 返回是否有行的高度变化（此时各行位置与总高度已更新，画面需要整体重新排版）
+    template <typename Measure>
+    bool Update(const TextTemplate& text, std::uint64_t key, Measure&& measure)
+    {
+        const size_t count = text.LineCount();
+        const bool all = key != m_key || m_heights.size() != count || text.SourceHash() != m_sourceHash;
+        if (!all && m_revision == text.Revision())
+        {
+            return false;
+        }
+        bool changed = false;
+        if (all)
+        {
+            m_key = key;
+            m_sourceHash = text.SourceHash();
+            m_heights.assign(count, 0);
+            m_revisions.assign(count, 0);
+            changed = true;
+        }
+        auto remeasure = [&](size_t i)
+        {
+            if (!all && m_revisions[i] == text.LineRevision(i))
+            {
+                return;
+            }
+            m_revisions[i] = text.LineRevision(i);
+            const int h = measure(text.Line(i));
+            if (h != m_heights[i])
+            {
+                m_heights[i] = h;
+                changed = true;
+            }
+        };
+        if (all || m_revision + 1 != text.Revision())
+        {
+            // 隔了不止一次更新：逐行比较版本，仍只测量变过的行
+            for (size_t i = 0; i < count; i++)
+            {
+                remeasure(i);
+            }
+        }
+        else
+        {
+            for (std::uint32_t i : text.ChangedLines())
+            {
+                remeasure(i);
+            }
+        }
+        m_revision = text.Revision();
+        if (changed)
+        {
+            Relayout(text);
+        }
+        return changed;
+    }
+
+    int Top(size_t line) const { return m_tops[line]; }
+    int Height(size_t line) const { return m_heights[line]; }
+    int TotalHeight() const { return m_total; }
+    // 含变量的行的高度；底图只画不含变量的行，它们的位置由这些高度决定
+    std::uint64_t Signature() const { return m_signature; }
+
+private:
+    void Relayout(const TextTemplate& text);
+
+    std::uint64_t m_sourceHash = 0;
+    std::uint64_t m_key = 0;
+    std::uint64_t m_revision = 0;
+    std::vector<int> m_heights;
+    std::vector<std::uint64_t> m_revisions;
+    std::vector<int> m_tops;
+    int m_total = 0;
+    std::uint64_t m_signature = 0;
+};
@@ -0,0 +1,236 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+std::atomic<bool> g_traceEnabled{false};
+
+static constexpr size_t TRACE_BUFFER_EVENTS = 1u << 14;
+
+struct TraceEvent
+{
+    const char* category;
+    const char* name;
+    std::uint64_t tsUs;
+    std::uint64_t durUs;
+    std::int64_t arg;
+    std::uint32_t tid;
+    TracePhase phase;
+};
+
+// 单写者环形缓冲区：只有所属线程写入，导出时按序号读取
+struct TraceBuffer
+{
+    std::atomic<std::uint64_t> head{0};
+    std::atomic<std::uint64_t> tail{0};
+    std::uint32_t tid = 0;
+    std::atomic<const char*> threadName{nullptr};
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+};
+
+static const auto g_traceEpoch = std::chrono::steady_clock::now();
+
+static std::mutex g_traceRegistryMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> g_traceBuffers;
+static thread_local TraceBuffer* t_traceBuffer = nullptr;
+static thread_local const char* t_traceThreadName = nullptr;
+
+static TraceBuffer* Trace_ThreadBuffer()
+{
+    if (!t_traceBuffer)
+    {
+        auto buffer = std::make_unique<TraceBuffer>();
+        std::lock_guard<std::mutex> lock(g_traceRegistryMutex);
+        buffer->tid = (std::uint32_t)g_traceBuffers.size() + 1;
+        buffer->threadName.store(t_traceThreadName, std::memory_order_relaxed);
+        t_traceBuffer = buffer.get();
+        g_traceBuffers.push_back(std::move(buffer));
+    }
+    return t_traceBuffer;
+}
+
+void Trace_SetEnabled(bool enabled)
+{
+    g_traceEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Trace_SetThreadName(const char* name)
+{
+    t_traceThreadName = name;
+    if (t_traceBuffer)
+    {
+        t_traceBuffer->threadName.store(name, std::memory_order_release);
+    }
+}
+
+std::uint64_t Trace_NowUs()
+{
+    const auto elapsed = std::chrono::steady_clock::now() - g_traceEpoch;
+    return (std::uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + 1;
+}
+
+void Trace_Record(TracePhase phase, const char* category, const char* name, std::uint64_t tsUs, std::uint64_t durUs, std::int64_t arg)
+{
+    TraceBuffer* buffer = Trace_ThreadBuffer();
+    const std::uint64_t seq = buffer->head.load(std::memory_order_relaxed);
+    TraceEvent& ev = buffer->events[seq & (TRACE_BUFFER_EVENTS - 1)];
+    ev.category = category;
+    ev.name = name;
+    ev.tsUs = tsUs;
+    ev.durUs = durUs;
+    ev.arg = arg;
+    ev.tid = buffer->tid;
+    ev.phase = phase;
+    buffer->head.store(seq + 1, std::memory_order_release);
+}
+
+size_t Trace_EventCount()
+{
+    std::lock_guard<std::mutex> lock(g_traceRegistryMutex);
+    size_t count = 0;
+    for (const auto& buffer : g_traceBuffers)
+    {
+        const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const std::uint64_t tail = std::max(buffer->tail.load(std::memory_order_relaxed),
+            head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0);
+        count += (size_t)(head - tail);
+    }
+    return count;
+}
+
+static void AppendJsonString(std::string& out, const char* s)
+{
+    out.push_back('"');
+    for (; s && *s; s++)
+    {
+        const char ch = *s;
+        if (ch == '"' || ch == '\\')
+        {
+            out.push_back('\\');
+            out.push_back(ch);
+        }
+        else if ((unsigned char)ch < 0x20)
+        {
+            out.push_back(' ');
+        }
+        else
+        {
+            out.push_back(ch);
+        }
+    }
+    out.push_back('"');
+}
+
+static unsigned long Trace_ProcessId()
+{
+#ifdef _WIN32
+    return (unsigned long)GetCurrentProcessId();
+#else
+    return (unsigned long)getpid();
+#endif
+}
+
+void Trace_WriteJson(std::string& out, bool clear)
+{
+    std::vector<TraceEvent> events;
+    std::vector<std::pair<std::uint32_t, const char*>> threadNames;
+
+    {
+        std::lock_guard<std::mutex> lock(g_traceRegistryMutex);
+        for (const auto& buffer : g_traceBuffers)
+        {
+            const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+            std::uint64_t tail = std::max(buffer->tail.load(std::memory_order_relaxed),
+                head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0);
+
+            const size_t first = events.size();
+            for (std::uint64_t seq = tail; seq < head; seq++)
+            {
+                events.push_back(buffer->events[seq & (TRACE_BUFFER_EVENTS - 1)]);
+            }
+
+            // 拷贝期间写者可能已经绕回覆盖了最早的事件，丢弃这部分；写者此刻可能正在写
+            // headAfter 所在的槽位，它与 headAfter - TRACE_BUFFER_EVENTS 是同一个槽位，也要丢弃
+            const std::uint64_t headAfter = buffer->head.load(std::memory_order_acquire);
+            const std::uint64_t intactFrom = headAfter + 1 > TRACE_BUFFER_EVENTS ? headAfter + 1 - TRACE_BUFFER_EVENTS : 0;
+            if (intactFrom > tail)
+            {
+                const std::uint64_t overwritten = std::min(head, intactFrom) - tail;
+                events.erase(events.begin() + (std::ptrdiff_t)first, events.begin() + (std::ptrdiff_t)(first + overwritten));
+            }
+
+            if (clear)
+            {
+                buffer->tail.store(head, std::memory_order_relaxed);
+            }
+            if (const char* name = buffer->threadName.load(std::memory_order_acquire))
+            {
+                threadNames.emplace_back(buffer->tid, name);
+            }
+        }
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) { return a.tsUs < b.tsUs; });
+
+    const unsigned long pid = Trace_ProcessId();
+    char num[160];
+
+    out.clear();
+    out.reserve(events.size() * 110 + 64);
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    bool first = true;
+    for (const auto& [tid, name] : threadNames)
+    {
+        out.append(first ? "\n" : ",\n");
+        first = false;
+        std::snprintf(num, sizeof(num), "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%lu,\"tid\":%u,\"args\":{\"name\":", pid, tid);
+        out.append(num);
+        AppendJsonString(out, name);
+        out.append("}}");
+    }
+
+    for (const auto& ev : events)
+    {
+        out.append(first ? "\n" : ",\n");
+        first = false;
+        out.append("{\"name\":");
+        AppendJsonString(out, ev.name);
+        out.append(",\"cat\":");
+        AppendJsonString(out, ev.category);
+        std::snprintf(num, sizeof(num), ",\"ph\":\"%c\",\"ts\":%" PRIu64 ",\"pid\":%lu,\"tid\":%u",
+            (char)ev.phase, ev.tsUs, pid, ev.tid);
+        out.append(num);
+
+        switch (ev.phase)
+        {
+        case TracePhase::Complete:
+            std::snprintf(num, sizeof(num), ",\"dur\":%" PRIu64 ",\"args\":{\"arg\":%" PRId64 "}}", ev.durUs, ev.arg);
+            out.append(num);
+            break;
+        case TracePhase::Instant:
+            std::snprintf(num, sizeof(num), ",\"s\":\"t\",\"args\":{\"arg\":%" PRId64 "}}", ev.arg);
+            out.append(num);
+            break;
+        case TracePhase::Counter:
+            out.append(",\"args\":{");
+            AppendJsonString(out, ev.name);
+            std::snprintf(num, sizeof(num), ":%" PRId64 "}}", ev.arg);
+            out.append(num);
+            break;
+        }
+    }
+
+    out.append("\n]}\n");
+}
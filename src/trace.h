@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Chrome trace-event 格式的轻量跟踪。每个线程写自己的环形缓冲区，
+// 未启用时每个事件只有一次 relaxed 原子读。name/category 必须是静态字符串。
+
+enum class TracePhase : char
+{
+    Complete = 'X',
+    Instant = 'i',
+    Counter = 'C',
+};
+
+extern std::atomic<bool> g_traceEnabled;
+
+inline bool Trace_IsEnabled()
+{
+    return g_traceEnabled.load(std::memory_order_relaxed);
+}
+
+void Trace_SetEnabled(bool enabled);
+void Trace_SetThreadName(const char* name);
+std::uint64_t Trace_NowUs();
+
+void Trace_Record(TracePhase phase, const char* category, const char* name, std::uint64_t tsUs, std::uint64_t durUs, std::int64_t arg);
+
+inline void Trace_Instant(const char* category, const char* name, std::int64_t arg = 0)
+{
+    if (Trace_IsEnabled())
+    {
+        Trace_Record(TracePhase::Instant, category, name, Trace_NowUs(), 0, arg);
+    }
+}
+
+inline void Trace_Counter(const char* category, const char* name, std::int64_t value)
+{
+    if (Trace_IsEnabled())
+    {
+        Trace_Record(TracePhase::Counter, category, name, Trace_NowUs(), 0, value);
+    }
+}
+
+class TraceScope
+{
+public:
+    TraceScope(const char* category, const char* name, std::int64_t arg = 0)
+        : m_category(category), m_name(name), m_arg(arg), m_startUs(Trace_IsEnabled() ? Trace_NowUs() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_startUs != 0 && Trace_IsEnabled())
+        {
+            Trace_Record(TracePhase::Complete, m_category, m_name, m_startUs, Trace_NowUs() - m_startUs, m_arg);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_category;
+    const char* m_name;
+    std::int64_t m_arg;
+    std::uint64_t m_startUs;
+};
+
+#define SSR_TRACE_CONCAT_INNER(a, b) a##b
+#define SSR_TRACE_CONCAT(a, b) SSR_TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(category, name) TraceScope SSR_TRACE_CONCAT(traceScope_, __LINE__)(category, name)
+
+// 按时间顺序导出所有线程的事件；clear 为 true 时导出后清空缓冲区
+void Trace_WriteJson(std::string& out, bool clear);
+size_t Trace_EventCount();
@@ -0,0 +1,175 @@
+#include "utf8.h"
+
+#include <cstdint>
+
+static constexpr char32_t REPLACEMENT_CHAR = 0xFFFD;
+
+static void AppendCodePoint(std::wstring& out, char32_t cp)
+{
+    if constexpr (sizeof(wchar_t) == 2)
+    {
+        if (cp >= 0x10000)
+        {
+            cp -= 0x10000;
+            out.push_back((wchar_t)(0xD800 + (cp >> 10)));
+            out.push_back((wchar_t)(0xDC00 + (cp & 0x3FF)));
+            return;
+        }
+    }
+    out.push_back((wchar_t)cp);
+}
+
+static void AppendUtf8(std::string& out, char32_t cp)
+{
+    if (cp < 0x80)
+    {
+        out.push_back((char)cp);
+    }
+    else if (cp < 0x800)
+    {
+        out.push_back((char)(0xC0 | (cp >> 6)));
+        out.push_back((char)(0x80 | (cp & 0x3F)));
+    }
+    else if (cp < 0x10000)
+    {
+        out.push_back((char)(0xE0 | (cp >> 12)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (cp & 0x3F)));
+    }
+    else
+    {
+        out.push_back((char)(0xF0 | (cp >> 18)));
+        out.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+void WideToUtf8(std::wstring_view input, std::string& out)
+{
+    out.clear();
+    out.reserve(input.size() * 3);
+
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        char32_t cp = (char32_t)input[i];
+        if constexpr (sizeof(wchar_t) == 2)
+        {
+            if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < input.size())
+            {
+                const char32_t lo = (char32_t)input[i + 1];
+                if (lo >= 0xDC00 && lo <= 0xDFFF)
+                {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    i++;
+                }
+            }
+        }
+        if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+        {
+            cp = REPLACEMENT_CHAR;
+        }
+        AppendUtf8(out, cp);
+    }
+}
+
+void Utf8ToWide(std::string_view input, std::wstring& out)
+{
+    out.clear();
+    out.reserve(input.size());
+
+    const auto* p = reinterpret_cast<const std::uint8_t*>(input.data());
+    const auto* end = p + input.size();
+
+    while (p < end)
+    {
+        const std::uint8_t lead = *p;
+        if (lead < 0x80)
+        {
+            out.push_back((wchar_t)lead);
+            p++;
+            continue;
+        }
+
+        int extra = 0;
+        char32_t cp = 0;
+        char32_t minCp = 0;
+        if ((lead & 0xE0) == 0xC0) { extra = 1; cp = lead & 0x1F; minCp = 0x80; }
+        else if ((lead & 0xF0) == 0xE0) { extra = 2; cp = lead & 0x0F; minCp = 0x800; }
+        else if ((lead & 0xF8) == 0xF0) { extra = 3; cp = lead & 0x07; minCp = 0x10000; }
+        else
+        {
+            AppendCodePoint(out, REPLACEMENT_CHAR);
+            p++;
+            continue;
+        }
+
+        if (end - p <= extra)
+        {
+            AppendCodePoint(out, REPLACEMENT_CHAR);
+            break;
+        }
+
+        bool valid = true;
+        for (int k = 1; k <= extra; k++)
+        {
+            if ((p[k] & 0xC0) != 0x80)
+            {
+                valid = false;
+                break;
+            }
+            cp = (cp << 6) | (p[k] & 0x3F);
+        }
+
+        if (!valid || cp < minCp || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+        {
+            AppendCodePoint(out, REPLACEMENT_CHAR);
+            p++;
+            continue;
+        }
+
+        AppendCodePoint(out, cp);
+        p += extra + 1;
+    }
+}
+
+std::string WideToUtf8(std::wstring_view input)
+{
+    std::string out;
+    WideToUtf8(input, out);
+    return out;
+}
+
+std::wstring Utf8ToWide(std::string_view input)
+{
+    std::wstring out;
+    Utf8ToWide(input, out);
+    return out;
+}
+
+std::string Utf16LeToUtf8(std::string_view bytes)
+{
+    std::string out;
+    out.reserve(bytes.size() * 3 / 2);
+    const auto* p = reinterpret_cast<const std::uint8_t*>(bytes.data());
+    const size_t units = bytes.size() / 2;
+    for (size_t i = 0; i < units; i++)
+    {
+        char32_t cp = (char32_t)(p[i * 2] | (p[i * 2 + 1] << 8));
+        if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < units)
+        {
+            const char32_t lo = (char32_t)(p[i * 2 + 2] | (p[i * 2 + 3] << 8));
+            if (lo >= 0xDC00 && lo <= 0xDFFF)
+            {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                i++;
+            }
+        }
+        if (cp >= 0xD800 && cp <= 0xDFFF)
+        {
+            cp = REPLACEMENT_CHAR;
+        }
+        AppendUtf8(out, cp);
+    }
+    return out;
+}
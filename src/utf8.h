@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// wchar_t 在 Windows 上是 UTF-16，在 Linux 上是 UTF-32；非法序列替换为 U+FFFD
+std::string WideToUtf8(std::wstring_view input);
+std::wstring Utf8ToWide(std::string_view input);
+
+void WideToUtf8(std::wstring_view input, std::string& out);
+void Utf8ToWide(std::string_view input, std::wstring& out);
+
+// 旧版本由 WritePrivateProfileStringW 写出的 UTF-16LE 字节（不含 BOM）
+std::string Utf16LeToUtf8(std::string_view bytes);
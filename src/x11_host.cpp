@@ -0,0 +1,779 @@
+#include "x11_host.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "process_footprint.h"
+#include "show_arena.h"
+#include "utf8.h"
+
+// Xlib 定义了 None、Bool、Status 等宏，放在项目头文件之后
+#include <X11/Xlib.h>
+#if defined(SSR_HAVE_XI2)
+#include <X11/extensions/XInput2.h>
+#endif
+#if defined(SSR_HAVE_XRANDR)
+#include <X11/extensions/Xrandr.h>
+#endif
+
+namespace
+{
+    // epoll 数据：1..3 为 EngineTimer，其余为固定的键
+    constexpr std::uint64_t KEY_X = 10;
+    constexpr std::uint64_t KEY_POLL = 11;
+    constexpr std::uint64_t KEY_WAKE = 12;
+    constexpr std::uint64_t KEY_SIGNAL = 13;
+    constexpr std::uint64_t KEY_FRAME = 14;
+    constexpr std::uint32_t INPUT_POLL_MS = 100;
+
+    std::uint64_t MonotonicNs()
+    {
+        return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Watch(int epoll, int fd, std::uint64_t key)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = key;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    void Drain(int fd)
+    {
+        std::uint64_t value;
+        while (read(fd, &value, sizeof(value)) == (ssize_t)sizeof(value))
+        {
+        }
+    }
+}
+
+X11EngineHost::X11EngineHost(_XDisplay* display, bool allowShm)
+    : m_display(display), m_backend(display, allowShm), m_pool(m_backend)
+{
+    m_startNs = MonotonicNs();
+    m_backend.SetPainter([this](SurfaceHandle surface, const MonitorInfo& monitor, PixelBuffer& buf) { Paint(surface, monitor, buf); });
+
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0)
+    {
+        return;
+    }
+    for (int i = 1; i < TIMER_SLOTS; i++)
+    {
+        m_timers[i] = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        Watch(m_epoll, m_timers[i], (std::uint64_t)i);
+    }
+    m_pollTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    Watch(m_epoll, m_pollTimer, KEY_POLL);
+    m_frameTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    Watch(m_epoll, m_frameTimer, KEY_FRAME);
+    m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Watch(m_epoll, m_wake, KEY_WAKE);
+    Watch(m_epoll, ConnectionNumber(display), KEY_X);
+    if (m_timers[1] < 0 || m_timers[2] < 0 || m_timers[3] < 0 || m_pollTimer < 0 || m_frameTimer < 0 || m_wake < 0)
+    {
+        close(m_epoll);
+        m_epoll = -1;
+        return;
+    }
+
+#if defined(SSR_HAVE_XI2)
+    int event = 0;
+    int error = 0;
+    if (XQueryExtension(display, "XInputExtension", &m_xiOpcode, &event, &error))
+    {
+        int major = 2;
+        int minor = 0;
+        if (XIQueryVersion(display, &major, &minor) != Success)
+        {
+            m_xiOpcode = -1;
+        }
+    }
+    else
+    {
+        m_xiOpcode = -1;
+    }
+#endif
+#if defined(SSR_HAVE_XRANDR)
+    int rrError = 0;
+    if (XRRQueryExtension(display, &m_randrEvent, &rrError))
+    {
+        XRRSelectInput(display, DefaultRootWindow(display), RRScreenChangeNotifyMask);
+    }
+    else
+    {
+        m_randrEvent = -1;
+    }
+#endif
+    XFlush(display);
+}
+
+X11EngineHost::~X11EngineHost()
+{
+    // m_pool 在 m_backend 之前析构，遮罩随之销毁
+    m_anim.Stop();
+    for (int fd : { m_timers[1], m_timers[2], m_timers[3], m_pollTimer, m_frameTimer, m_wake, m_signals, m_epoll })
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+void X11EngineHost::WatchSignals()
+{
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    m_signals = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (m_signals >= 0)
+    {
+        Watch(m_epoll, m_signals, KEY_SIGNAL);
+    }
+}
+
+std::uint64_t X11EngineHost::Now() const
+{
+    return (MonotonicNs() - m_startNs) / 1000000;
+}
+
+void X11EngineHost::ArmFd(int fd, std::uint32_t periodMs)
+{
+    itimerspec spec{};
+    if (periodMs != 0)
+    {
+        spec.it_value.tv_sec = periodMs / 1000;
+        spec.it_value.tv_nsec = (long)(periodMs % 1000) * 1000000;
+        spec.it_interval = spec.it_value;
+    }
+    timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+void X11EngineHost::ArmOnce(int fd, std::uint32_t delayMs)
+{
+    itimerspec spec{};
+    delayMs = std::max<std::uint32_t>(1, delayMs);
+    spec.it_value.tv_sec = delayMs / 1000;
+    spec.it_value.tv_nsec = (long)(delayMs % 1000) * 1000000;
+    timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+void X11EngineHost::SetTimer(EngineTimer id, std::uint32_t periodMs)
+{
+    ArmFd(m_timers[(int)id], std::max<std::uint32_t>(1, periodMs));
+}
+
+void X11EngineHost::KillTimer(EngineTimer id)
+{
+    ArmFd(m_timers[(int)id], 0);
+}
+
+bool X11EngineHost::ShowSurfaces()
+{
+    m_pool.Prepare();
+    if (m_engine)
+    {
+        m_pool.SetRegionSpec(m_engine->OverlayConfig().overlayRegions);
+    }
+    if (!m_pool.Show(0))
+    {
+        return false;
+    }
+    SyncAnimation();
+    StartAnimation();
+
+    // 遮罩显示之前不接收键鼠事件，空闲时间从显示时算起
+    m_lastActivityMs = Now();
+    if (m_engine && !m_engine->IsPreview())
+    {
+        const std::time_t t = std::time(nullptr);
+        std::tm local{};
+        localtime_r(&t, &local);
+        const int day = local.tm_year * 1000 + local.tm_yday;
+        m_breaksToday = day == m_breaksDay ? m_breaksToday + 1 : 1;
+        m_breaksDay = day;
+    }
+    SyncText();
+    m_text.Update(TextInputs());
+    m_pool.InvalidateAll();
+    return true;
+}
+
+void X11EngineHost::HideSurfaces()
+{
+    // 共享内存图像随窗口留在池中；本次提醒的画面缓存随 arena 归还系统
+    m_pool.Hide();
+    // 动画的环与当前帧也在 arena 里，先停下解码线程
+    m_anim.Stop();
+    ArmFd(m_frameTimer, 0);
+    m_frames.Clear();
+    std::vector<SurfaceText>().swap(m_surfaceText);
+    ShowArena_Overlay().Release();
+    ProcessFootprint_Trim();
+}
+
+void X11EngineHost::SetAlpha(std::uint8_t alpha)
+{
+    m_pool.SetAlpha(alpha);
+}
+
+void X11EngineHost::InvalidateSurfaces()
+{
+    // 显示期间保存了新的区域规则时，形状变化的遮罩已在 SetRegionSpec 中重绘
+    if (m_engine)
+    {
+        m_pool.SetRegionSpec(m_engine->OverlayConfig().overlayRegions);
+    }
+    if (!m_pool.IsVisible())
+    {
+        m_pool.InvalidateAll();
+        return;
+    }
+    const std::uint64_t key = m_anim.ContentKey();
+    SyncAnimation();
+    const bool animChanged = m_anim.ContentKey() != key;
+    if (animChanged)
+    {
+        StartAnimation();
+    }
+    // 每秒的计时：模板只格式化变了的变量，多数时候只需重画时间与 {time} 所在的行
+    const bool recompiled = SyncText();
+    m_text.Update(TextInputs());
+    if (!animChanged && !recompiled && RepaintChanged())
+    {
+        m_stats.clockPaints++;
+        return;
+    }
+    m_pool.InvalidateAll();
+}
+
+void X11EngineHost::ReconcileSurfaces()
+{
+    std::vector<MonitorInfo> monitors;
+    m_backend.EnumMonitors(monitors);
+    m_pool.Reconcile(monitors);
+    m_frames.Clear();
+    m_surfaceText.clear();
+    // 各显示器上动画的尺寸可能变了
+    if (m_anim.IsPlaying())
+    {
+        StartAnimation();
+    }
+}
+
+void X11EngineHost::StartInput()
+{
+    m_inputActive = true;
+#if defined(SSR_HAVE_XI2)
+    if (m_xiOpcode >= 0)
+    {
+        unsigned char mask[XIMaskLen(XI_LASTEVENT)]{};
+        XISetMask(mask, XI_RawKeyPress);
+        XISetMask(mask, XI_RawButtonPress);
+        XISetMask(mask, XI_RawMotion);
+        XIEventMask events{ XIAllMasterDevices, (int)sizeof(mask), mask };
+        XISelectEvents(m_display, DefaultRootWindow(m_display), &events, 1);
+        XFlush(m_display);
+        return;
+    }
+#endif
+    // 以当前状态为基准，之后的变化才算活动
+    PollInput(true);
+    ArmFd(m_pollTimer, INPUT_POLL_MS);
+}
+
+void X11EngineHost::StopInput()
+{
+    m_inputActive = false;
+#if defined(SSR_HAVE_XI2)
+    if (m_xiOpcode >= 0)
+    {
+        unsigned char mask[XIMaskLen(XI_LASTEVENT)]{};
+        XIEventMask events{ XIAllMasterDevices, (int)sizeof(mask), mask };
+        XISelectEvents(m_display, DefaultRootWindow(m_display), &events, 1);
+        XFlush(m_display);
+        return;
+    }
+#endif
+    ArmFd(m_pollTimer, 0);
+}
+
+void X11EngineHost::OnStateChanged(OverlayState prev, OverlayState next)
+{
+    if (m_listener)
+    {
+        m_listener(prev, next);
+    }
+}
+
+void X11EngineHost::Paint(SurfaceHandle surface, const MonitorInfo& monitor, PixelBuffer& buf)
+{
+    if (!m_engine)
+    {
+        return;
+    }
+    const AppConfig& cfg = m_engine->OverlayConfig();
+    if (SyncText())
+    {
+        m_text.Update(TextInputs());
+    }
+    const bool anim = m_anim.IsOpen();
+    SurfaceText& entry = TextEntry(surface);
+    SoftOverlayLayout layout;
+    // 播放动画时文字的位置换成动画，底图上不画文字
+    if (anim)
+    {
+        Soft_LayoutOverlayAnim(buf.width, buf.height, monitor.dpi, m_anim.Info().width, m_anim.Info().height, layout);
+    }
+    else
+    {
+        LayoutText(entry, monitor);
+        Soft_LayoutOverlayRows(buf.width, buf.height, monitor.dpi, entry.lines.TotalHeight(), layout);
+    }
+    const OverlayFrameKey key{ buf.width, buf.height, monitor.dpi, TextContentHash(cfg.bgColor, entry), OverlayFrame_RegionHash(buf.clip) };
+
+    // 背景与不含变量的文字行在一次提醒内不变，缓存后只重画时间与含变量的行
+    if (auto frame = m_frames.Find(surface, key))
+    {
+        m_frames.CountHit();
+        Soft_Copy(buf, frame->BasePixels(), buf.width);
+    }
+    else
+    {
+        m_frames.CountMiss();
+        Soft_Fill(buf, ScreenRect{ 0, 0, buf.width, buf.height }, Soft_PixelFromColor(cfg.bgColor));
+        for (size_t i = 0; !anim && i < m_text.LineCount(); i++)
+        {
+            if (!m_text.IsDynamicLine(i))
+            {
+                Soft_RenderTextLine(buf, layout, entry.lines.Top(i), m_text.Line(i));
+            }
+        }
+        auto fresh = std::make_shared<OverlayFrame>();
+        fresh->key = key;
+        fresh->base.resize((size_t)buf.width * (size_t)buf.height);
+        // 区域外的像素不会显示，也不复制
+        PixelBuffer cached{ fresh->base.data(), buf.width, buf.height, buf.width, buf.clip };
+        Soft_Copy(cached, buf.pixels, buf.stride);
+        m_frames.Store(surface, std::move(fresh));
+    }
+    for (size_t i = 0; !anim && m_text.HasVariables() && i < m_text.LineCount(); i++)
+    {
+        if (m_text.IsDynamicLine(i))
+        {
+            Soft_RenderTextLine(buf, layout, entry.lines.Top(i), m_text.Line(i));
+        }
+    }
+
+    const std::time_t t = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&t, &local);
+    Soft_RenderOverlayClock(buf, layout, cfg.bgColor, local.tm_hour, local.tm_min, local.tm_sec);
+    if (anim)
+    {
+        BlitAnimation(buf, layout);
+    }
+    entry.layout = layout;
+    entry.contentHash = key.contentHash;
+    entry.painted = true;
+}
+
+X11EngineHost::SurfaceText& X11EngineHost::TextEntry(SurfaceHandle surface)
+{
+    for (SurfaceText& entry : m_surfaceText)
+    {
+        if (entry.surface == surface)
+        {
+            return entry;
+        }
+    }
+    m_surfaceText.emplace_back();
+    m_surfaceText.back().surface = surface;
+    return m_surfaceText.back();
+}
+
+bool X11EngineHost::SyncText()
+{
+    if (!m_engine || m_engine->OverlayConfig().text == m_text.Source())
+    {
+        return false;
+    }
+    m_text.Compile(m_engine->OverlayConfig().text);
+    return true;
+}
+
+TemplateInputs X11EngineHost::TextInputs() const
+{
+    TemplateInputs in;
+    const std::time_t t = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&t, &local);
+    in.year = local.tm_year + 1900;
+    in.month = local.tm_mon + 1;
+    in.day = local.tm_mday;
+    in.hour = local.tm_hour;
+    in.minute = local.tm_min;
+    in.second = local.tm_sec;
+    // 现在回来的话下一次提醒的时刻；离开期间计时暂停，不显示
+    if (m_engine && !m_engine->IsAway())
+    {
+        const std::time_t next = t + (std::time_t)(m_engine->NextPeriodMs() / 1000);
+        std::tm nextLocal{};
+        localtime_r(&next, &nextLocal);
+        in.nextBreakHour = nextLocal.tm_hour;
+        in.nextBreakMinute = nextLocal.tm_min;
+    }
+    in.breaksToday = local.tm_year * 1000 + local.tm_yday == m_breaksDay ? m_breaksToday : 0;
+    const std::uint64_t now = Now();
+    in.idleMinutes = now > m_lastActivityMs ? (int)((now - m_lastActivityMs) / 60000) : 0;
+    return in;
+}
+
+bool X11EngineHost::LayoutText(SurfaceText& entry, const MonitorInfo& monitor)
+{
+    const int width = monitor.rect.Width();
+    const int charsPerLine = Soft_TextCharsPerLine(width, monitor.dpi);
+    const std::uint64_t key = ((std::uint64_t)(std::uint32_t)width << 32) | (std::uint32_t)monitor.dpi;
+    return entry.lines.Update(m_text, key, [charsPerLine](std::wstring_view line) { return Soft_TextRows(line, charsPerLine); });
+}
+
+std::uint64_t X11EngineHost::TextContentHash(ColorRef bgColor, const SurfaceText& entry) const
+{
+    if (m_anim.IsOpen())
+    {
+        return OverlayFrame_ContentHash(bgColor, std::wstring_view(), m_anim.ContentKey());
+    }
+    return OverlayFrame_TemplateHash(bgColor, m_text.SourceHash(), entry.lines.Signature());
+}
+
+bool X11EngineHost::RepaintChanged()
+{
+    const AppConfig& cfg = m_engine->OverlayConfig();
+    const bool anim = m_anim.IsOpen();
+    bool reuse = true;
+    m_pool.ForEachSurface([&](SurfaceHandle surface, const MonitorInfo& monitor)
+    {
+        SurfaceText& entry = TextEntry(surface);
+        // 折行数变化的行会挪动它下面的行，整屏重画
+        if (!entry.painted || (!anim && LayoutText(entry, monitor)) || entry.contentHash != TextContentHash(cfg.bgColor, entry))
+        {
+            reuse = false;
+        }
+    });
+    if (!reuse)
+    {
+        return false;
+    }
+
+    const std::time_t t = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&t, &local);
+    const std::uint32_t bgPixel = Soft_PixelFromColor(cfg.bgColor);
+    m_pool.ForEachSurface([&](SurfaceHandle surface, const MonitorInfo&)
+    {
+        const SurfaceText& entry = TextEntry(surface);
+        m_backend.PaintRect(surface, entry.layout.timeRect, [&](SurfaceHandle, const MonitorInfo&, PixelBuffer& buf)
+        {
+            Soft_RenderOverlayClock(buf, entry.layout, cfg.bgColor, local.tm_hour, local.tm_min, local.tm_sec);
+        });
+        if (anim)
+        {
+            return;
+        }
+        for (std::uint32_t line : m_text.ChangedLines())
+        {
+            const int top = entry.lines.Top(line);
+            const ScreenRect band = Soft_TextRowsRect(entry.layout, top, entry.lines.Height(line));
+            m_backend.PaintRect(surface, band, [&](SurfaceHandle, const MonitorInfo&, PixelBuffer& buf)
+            {
+                Soft_Fill(buf, band, bgPixel);
+                Soft_RenderTextLine(buf, entry.layout, top, m_text.Line(line));
+            });
+            m_stats.textLines++;
+        }
+    });
+    return true;
+}
+
+void X11EngineHost::BlitAnimation(PixelBuffer& buf, const SoftOverlayLayout& layout) const
+{
+    const ScreenRect& r = layout.textRect;
+    // 第一帧还没解出时留着背景色
+    if (const std::uint32_t* frame = m_anim.Frame(r.Width(), r.Height()))
+    {
+        Soft_Blit(buf, r.left, r.top, frame, r.Width(), r.Height(), r.Width());
+    }
+}
+
+void X11EngineHost::SyncAnimation()
+{
+    const std::wstring setting = m_engine ? m_engine->OverlayConfig().animation : std::wstring();
+    if (setting == m_animSetting && (setting.empty() || m_anim.IsOpen()))
+    {
+        return;
+    }
+    m_animSetting = setting;
+    m_anim.Close();
+    if (setting.empty())
+    {
+        return;
+    }
+    std::filesystem::path path(setting);
+    if (path.is_relative())
+    {
+        path = m_contentFolder / path;
+    }
+    std::wstring error;
+    if (!m_anim.Open(path, &error))
+    {
+        // 文件缺失或损坏时照常显示文字
+        std::fprintf(stderr, "ssr_x11: %s: %s\n", path.string().c_str(), WideToUtf8(error).c_str());
+    }
+}
+
+void X11EngineHost::StartAnimation()
+{
+    if (!m_anim.IsOpen() || !m_engine)
+    {
+        m_anim.Stop();
+        ArmFd(m_frameTimer, 0);
+        return;
+    }
+    std::vector<AnimTarget> targets;
+    m_pool.ForEachSurface([&](SurfaceHandle, const MonitorInfo& monitor)
+    {
+        SoftOverlayLayout layout;
+        Soft_LayoutOverlayAnim(monitor.rect.Width(), monitor.rect.Height(), monitor.dpi, m_anim.Info().width, m_anim.Info().height, layout);
+        targets.push_back(AnimTarget{ layout.textRect.Width(), layout.textRect.Height() });
+    });
+    const std::uint64_t now = Now();
+    m_anim.Start(targets, m_engine->OverlayConfig().bgColor, now);
+    std::uint32_t delay = 0;
+    ArmFd(m_frameTimer, 0);
+    if (m_anim.NextDelay(now, delay))
+    {
+        ArmOnce(m_frameTimer, delay);
+    }
+}
+
+void X11EngineHost::OnFrameTimer()
+{
+    Drain(m_frameTimer);
+    if (!m_anim.IsPlaying() || !m_engine)
+    {
+        return;
+    }
+    const std::uint64_t now = Now();
+    if (m_anim.Advance(now))
+    {
+        // 只重画并上传动画所在的矩形；时间与背景留在共享内存里
+        const AnimInfo& info = m_anim.Info();
+        m_pool.ForEachSurface([&](SurfaceHandle surface, const MonitorInfo& monitor)
+        {
+            SoftOverlayLayout layout;
+            Soft_LayoutOverlayAnim(monitor.rect.Width(), monitor.rect.Height(), monitor.dpi, info.width, info.height, layout);
+            m_backend.PaintRect(surface, layout.textRect, [&](SurfaceHandle, const MonitorInfo&, PixelBuffer& buf) { BlitAnimation(buf, layout); });
+            m_stats.animFrames++;
+        });
+    }
+    std::uint32_t delay = 0;
+    if (m_anim.NextDelay(Now(), delay))
+    {
+        ArmOnce(m_frameTimer, delay);
+    }
+}
+
+void X11EngineHost::OnActivity()
+{
+    m_stats.activities++;
+    m_lastActivityMs = Now();
+    if (!m_inputActive || m_activityLatched || !m_engine)
+    {
+        return;
+    }
+    m_activityLatched = true;
+    m_engine->OnActivity(Now());
+}
+
+void X11EngineHost::InjectActivity()
+{
+    OnActivity();
+}
+
+void X11EngineHost::PollInput(bool baseline)
+{
+    m_stats.inputPolls++;
+    Window root = 0;
+    Window child = 0;
+    int rootX = 0;
+    int rootY = 0;
+    int winX = 0;
+    int winY = 0;
+    unsigned buttons = 0;
+    XQueryPointer(m_display, DefaultRootWindow(m_display), &root, &child, &rootX, &rootY, &winX, &winY, &buttons);
+    char keys[32];
+    XQueryKeymap(m_display, keys);
+
+    const bool changed = rootX != m_lastPointerX || rootY != m_lastPointerY || buttons != m_lastButtons ||
+        std::memcmp(keys, m_lastKeys, sizeof(keys)) != 0;
+    m_lastPointerX = rootX;
+    m_lastPointerY = rootY;
+    m_lastButtons = buttons;
+    std::memcpy(m_lastKeys, keys, sizeof(keys));
+    if (changed && !baseline)
+    {
+        OnActivity();
+    }
+}
+
+void X11EngineHost::DrainX()
+{
+    while (XPending(m_display))
+    {
+        XEvent ev;
+        XNextEvent(m_display, &ev);
+        m_stats.xEvents++;
+        if (ev.type == Expose)
+        {
+            if (ev.xexpose.count == 0)
+            {
+                m_backend.HandleExpose(ev.xexpose.window);
+            }
+        }
+#if defined(SSR_HAVE_XI2)
+        else if (ev.type == GenericEvent && ev.xcookie.extension == m_xiOpcode)
+        {
+            m_stats.rawEvents++;
+            OnActivity();
+        }
+#endif
+#if defined(SSR_HAVE_XRANDR)
+        else if (m_randrEvent >= 0 && ev.type == m_randrEvent + RRScreenChangeNotify)
+        {
+            XRRUpdateConfiguration(&ev);
+            m_stats.displayChanges++;
+            m_pool.MarkTopologyDirty();
+            if (m_engine)
+            {
+                m_engine->OnDisplayChange(Now());
+            }
+        }
+#endif
+    }
+}
+
+void X11EngineHost::Post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_tasksMutex);
+        m_tasks.push_back(std::move(task));
+    }
+    const std::uint64_t one = 1;
+    (void)!write(m_wake, &one, sizeof(one));
+}
+
+void X11EngineHost::Stop()
+{
+    Post([this] { m_stop = true; });
+}
+
+void X11EngineHost::Run(std::uint64_t untilMs)
+{
+    m_stop = false;
+    epoll_event events[16];
+    while (!m_stop)
+    {
+        // Xlib 可能已经把事件读进了自己的缓冲区，此时套接字上不会再有可读通知
+        DrainX();
+        XFlush(m_display);
+
+        int timeout = -1;
+        if (untilMs != 0)
+        {
+            const std::uint64_t now = Now();
+            if (now >= untilMs)
+            {
+                break;
+            }
+            timeout = (int)std::min<std::uint64_t>(untilMs - now, 60000);
+        }
+        const int n = epoll_wait(m_epoll, events, (int)std::size(events), timeout);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        m_stats.wakeups += n > 0 ? 1 : 0;
+
+        for (int i = 0; i < n && !m_stop; i++)
+        {
+            const std::uint64_t key = events[i].data.u64;
+            if (key >= 1 && key < (std::uint64_t)TIMER_SLOTS)
+            {
+                std::uint64_t expirations = 0;
+                // 停掉的计时器读不到数据；一次唤醒里错过的多次到点合并为一次
+                if (read(m_timers[key], &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations) && m_engine)
+                {
+                    m_stats.timerFirings++;
+                    m_engine->OnTimer((EngineTimer)key, Now());
+                }
+            }
+            else if (key == KEY_X)
+            {
+                DrainX();
+            }
+            else if (key == KEY_FRAME)
+            {
+                OnFrameTimer();
+            }
+            else if (key == KEY_POLL)
+            {
+                Drain(m_pollTimer);
+                if (m_inputActive)
+                {
+                    PollInput(false);
+                }
+            }
+            else if (key == KEY_WAKE)
+            {
+                Drain(m_wake);
+                {
+                    std::lock_guard<std::mutex> lock(m_tasksMutex);
+                    m_running.swap(m_tasks);
+                }
+                for (auto& task : m_running)
+                {
+                    task();
+                }
+                m_running.clear();
+            }
+            else if (key == KEY_SIGNAL)
+            {
+                signalfd_siginfo info;
+                while (read(m_signals, &info, sizeof(info)) == (ssize_t)sizeof(info))
+                {
+                }
+                m_stop = true;
+            }
+        }
+    }
+}
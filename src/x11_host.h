@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "anim_player.h"
+#include "overlay_engine.h"
+#include "overlay_frame.h"
+#include "overlay_pool.h"
+#include "surface_x11.h"
+#include "text_template.h"
+
+struct X11HostStats
+{
+    std::uint64_t wakeups = 0;       // epoll_wait 返回次数
+    std::uint64_t timerFirings = 0;
+    std::uint64_t xEvents = 0;
+    std::uint64_t rawEvents = 0;     // XInput2 原始键鼠事件
+    std::uint64_t inputPolls = 0;    // 没有 XInput2 时的轮询次数
+    std::uint64_t activities = 0;
+    std::uint64_t displayChanges = 0;
+    std::uint64_t animFrames = 0;    // 动画换帧后的局部重绘次数
+    std::uint64_t clockPaints = 0;   // 只重画时间与变化的文字行的计时次数（否则整屏重画）
+    std::uint64_t textLines = 0;     // 模板变量变化后局部重画的文字行
+};
+
+// Linux 桌面上的 EngineHost：计时器是 timerfd，与 X 连接、唤醒用的 eventfd、SIGINT/SIGTERM 的
+// signalfd 一起挂在同一个 epoll 上，空闲时线程一直阻塞，不轮询。
+// 键鼠活动来自根窗口上的 XInput2 原始事件（遮罩不接收输入）；服务器没有 XInput2 时
+// 在等待活动期间每 100ms 比较一次指针位置与按键状态。
+class X11EngineHost final : public EngineHost
+{
+public:
+    explicit X11EngineHost(_XDisplay* display, bool allowShm = true);
+    ~X11EngineHost() override;
+
+    X11EngineHost(const X11EngineHost&) = delete;
+    X11EngineHost& operator=(const X11EngineHost&) = delete;
+
+    // epoll 或 timerfd 创建失败时为 false
+    bool IsValid() const { return m_epoll >= 0; }
+
+    void SetEngine(OverlayEngine* engine) { m_engine = engine; }
+    void SetStateListener(std::function<void(OverlayState, OverlayState)> listener) { m_listener = std::move(listener); }
+    // 配置中相对路径的动画文件所在的目录（配置目录）
+    void SetContentFolder(std::filesystem::path folder) { m_contentFolder = std::move(folder); }
+    // 屏蔽 SIGINT/SIGTERM 并改由事件循环接收，收到后 Run 返回
+    void WatchSignals();
+
+    // 启动以来的毫秒数，与传给引擎的时间一致
+    std::uint64_t Now() const;
+
+    // 处理事件直到 Stop、收到信号或 untilMs（0 表示不限）
+    void Run(std::uint64_t untilMs = 0);
+    // 任意线程调用：让事件循环执行 task
+    void Post(std::function<void()> task);
+    void Stop();
+
+    // 等同一次真实的键鼠活动（测试用）
+    void InjectActivity();
+
+    void SetTimer(EngineTimer id, std::uint32_t periodMs) override;
+    void KillTimer(EngineTimer id) override;
+    bool ShowSurfaces() override;
+    void HideSurfaces() override;
+    void SetAlpha(std::uint8_t alpha) override;
+    void InvalidateSurfaces() override;
+    void ReconcileSurfaces() override;
+    void StartInput() override;
+    void StopInput() override;
+    void ResetActivityLatch() override { m_activityLatched = false; }
+    void OnStateChanged(OverlayState prev, OverlayState next) override;
+
+    X11SurfaceBackend& Backend() { return m_backend; }
+    OverlayPool& Pool() { return m_pool; }
+    bool HasXInput2() const { return m_xiOpcode >= 0; }
+    bool HasRandr() const { return m_randrEvent >= 0; }
+    const X11HostStats& Stats() const { return m_stats; }
+    const AnimPlayer& Animation() const { return m_anim; }
+    const TextTemplate& Text() const { return m_text; }
+
+private:
+    static constexpr int TIMER_SLOTS = 4;
+
+    void Paint(SurfaceHandle surface, const MonitorInfo& monitor, PixelBuffer& buf);
+    void DrainX();
+    void PollInput(bool baseline);
+    void OnActivity();
+    void ArmFd(int fd, std::uint32_t periodMs);
+    void ArmOnce(int fd, std::uint32_t delayMs);
+    // 按配置打开或关闭动画文件；路径没变时保留已打开的
+    void SyncAnimation();
+    // 按各遮罩的版面重新开始播放，并排好第一次换帧
+    void StartAnimation();
+    void OnFrameTimer();
+    void BlitAnimation(PixelBuffer& buf, const SoftOverlayLayout& layout) const;
+
+    // 每块遮罩上次整屏绘制时的版面；计时只重画时间与变化的文字行时沿用
+    struct SurfaceText
+    {
+        SurfaceHandle surface = 0;
+        TextLineLayout lines;
+        SoftOverlayLayout layout;
+        std::uint64_t contentHash = 0;
+        bool painted = false;
+    };
+
+    SurfaceText& TextEntry(SurfaceHandle surface);
+    // 配置中的文字换过时重新编译；返回是否重新编译了
+    bool SyncText();
+    TemplateInputs TextInputs() const;
+    // 按当前模板排版各行，返回行高是否变化
+    bool LayoutText(SurfaceText& entry, const MonitorInfo& monitor);
+    // 底图的内容哈希：背景色、模板（或动画）与含变量的行的高度
+    std::uint64_t TextContentHash(ColorRef bgColor, const SurfaceText& entry) const;
+    // 各遮罩都能沿用上次的版面时只重画时间与变化的行，返回 false 时需要整屏重画
+    bool RepaintChanged();
+
+    _XDisplay* m_display;
+    X11SurfaceBackend m_backend;
+    OverlayPool m_pool;
+    OverlayFrameCache m_frames;
+    AnimPlayer m_anim;
+    std::filesystem::path m_contentFolder;
+    std::wstring m_animSetting;
+    TextTemplate m_text;
+    std::vector<SurfaceText> m_surfaceText;
+    int m_breaksToday = 0;
+    int m_breaksDay = -1;    // m_breaksToday 所属的日期（年 × 1000 + 年内第几天）
+    std::uint64_t m_lastActivityMs = 0;
+    OverlayEngine* m_engine = nullptr;
+    std::function<void(OverlayState, OverlayState)> m_listener;
+
+    int m_epoll = -1;
+    int m_timers[TIMER_SLOTS]{ -1, -1, -1, -1 };
+    int m_pollTimer = -1;
+    int m_frameTimer = -1;   // 一次性计时器，按动画下一帧的时刻重新设定
+    int m_wake = -1;
+    int m_signals = -1;
+    std::uint64_t m_startNs = 0;
+    bool m_stop = false;
+
+    std::mutex m_tasksMutex;
+    std::vector<std::function<void()>> m_tasks;
+    std::vector<std::function<void()>> m_running;
+
+    int m_xiOpcode = -1;
+    int m_randrEvent = -1;
+    bool m_inputActive = false;
+    bool m_activityLatched = false;
+    int m_lastPointerX = 0;
+    int m_lastPointerY = 0;
+    unsigned m_lastButtons = 0;
+    char m_lastKeys[32]{};
+
+    X11HostStats m_stats;
+};
@@ -0,0 +1,275 @@
+// ssr_x11：Linux 桌面（X11）上的提醒程序，与 Windows 版同一个引擎与设置文件格式。
+//   ssr_x11                                  按 ~/.config/ScreenSaverReminderCPP 下的设置运行
+//   ssr_x11 --events --trigger --exit-after 20000
+//                                            立即提醒一次，状态转移以 JSON 行输出（Xvfb 下端到端测试）
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "config_layers.h"
+#include "config_schema.h"
+#include "control_server.h"
+#include "headless.h"
+#include "x11_host.h"
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::fprintf(stderr,
+            "usage: ssr_x11 [--config <ini>] [--text <file>] [--policy <dir>] [--set <key>=<value>]...\n"
+            "               [--events] [--trigger] [--exit-after <ms>] [--no-shm] [--control[=<endpoint>]]\n");
+    }
+
+    bool StartsWith(const char* arg, const char* prefix)
+    {
+        return std::strncmp(arg, prefix, std::strlen(prefix)) == 0;
+    }
+
+    // $XDG_CONFIG_HOME/ScreenSaverReminderCPP，没有时为 ~/.config/ScreenSaverReminderCPP
+    std::filesystem::path ConfigFolder()
+    {
+        const char* xdg = std::getenv("XDG_CONFIG_HOME");
+        if (xdg && *xdg)
+        {
+            return std::filesystem::u8path(xdg) / "ScreenSaverReminderCPP";
+        }
+        const char* home = std::getenv("HOME");
+        return std::filesystem::u8path(home ? home : ".") / ".config" / "ScreenSaverReminderCPP";
+    }
+
+    void AppendLine(std::string& out, const char* key, long long value)
+    {
+        out += key;
+        out += '=';
+        out += std::to_string(value);
+        out += '\n';
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::filesystem::path folder = ConfigFolder();
+    std::filesystem::path configIni = folder / "config.ini";
+    std::filesystem::path textFile = folder / "text.txt";
+    std::filesystem::path policyDir = "/etc/ScreenSaverReminderCPP/policy";
+    std::vector<std::string> sets;
+    bool events = false;
+    bool trigger = false;
+    bool allowShm = true;
+    std::uint64_t exitAfterMs = 0;
+    bool control = false;
+    std::string endpoint;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--config") == 0 && i + 1 < argc)
+        {
+            configIni = std::filesystem::u8path(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--text") == 0 && i + 1 < argc)
+        {
+            textFile = std::filesystem::u8path(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--policy") == 0 && i + 1 < argc)
+        {
+            policyDir = std::filesystem::u8path(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--set") == 0 && i + 1 < argc)
+        {
+            sets.push_back(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--events") == 0)
+        {
+            events = true;
+        }
+        else if (std::strcmp(arg, "--trigger") == 0)
+        {
+            trigger = true;
+        }
+        else if (std::strcmp(arg, "--exit-after") == 0 && i + 1 < argc)
+        {
+            exitAfterMs = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(arg, "--no-shm") == 0)
+        {
+            allowShm = false;
+        }
+        else if (std::strcmp(arg, "--control") == 0)
+        {
+            control = true;
+            endpoint = ControlServer::DefaultEndpoint();
+        }
+        else if (StartsWith(arg, "--control="))
+        {
+            control = true;
+            endpoint = arg + std::strlen("--control=");
+        }
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    _XDisplay* display = X11_OpenDisplay();
+    if (!display)
+    {
+        std::fprintf(stderr, "ssr_x11: cannot open display\n");
+        return 1;
+    }
+
+    int result = 0;
+    {
+        LayeredConfig layers;
+        layers.SetSources(policyDir, configIni, textFile);
+        const std::filesystem::path cache = folder / "config.cache";
+        layers.LoadCache(cache);
+        if (layers.Load())
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(folder, ec);
+            layers.SaveCache(cache);
+        }
+        // 命令行覆盖：与用户文件相同，不能改被策略锁定的键
+        auto applySets = [&](AppConfig& cfg)
+        {
+            for (const std::string& set : sets)
+            {
+                AppConfig candidate = cfg;
+                const std::uint32_t present = Config_ParseIniLayer(std::string("[") + kConfigSection + "]\n" + set, candidate, nullptr);
+                if (present != 0 && !(present & layers.Locked()))
+                {
+                    cfg = candidate;
+                }
+            }
+            Config_Normalize(cfg);
+            Config_ApplyPolicyLimits(layers.Policy(), cfg);
+        };
+        AppConfig cfg = layers.Merged();
+        applySets(cfg);
+
+        X11EngineHost host(display, allowShm);
+        if (!host.IsValid())
+        {
+            std::fprintf(stderr, "ssr_x11: cannot create event loop\n");
+            X11_CloseDisplay(display);
+            return 1;
+        }
+        OverlayEngine engine(host);
+        host.SetEngine(&engine);
+        host.SetContentFolder(folder);
+        host.WatchSignals();
+        if (events)
+        {
+            host.SetStateListener([&host](OverlayState prev, OverlayState next)
+            {
+                std::string line = "{\"t\":" + std::to_string(host.Now()) + ",\"event\":\"" + Headless_TransitionEvent(prev, next) + "\",\"from\":";
+                Headless_AppendJsonString(line, OverlayFsm_StateName(prev));
+                line += ",\"to\":";
+                Headless_AppendJsonString(line, OverlayFsm_StateName(next));
+                line += '}';
+                std::printf("%s\n", line.c_str());
+                std::fflush(stdout);
+            });
+        }
+
+        ControlServer server;
+        auto handle = [&](const ControlRequest& request, ControlResponse& response)
+        {
+            response.client = request.client;
+            response.id = request.id;
+            response.status = ControlStatus::Ok;
+            const std::uint64_t now = host.Now();
+            switch (request.op)
+            {
+            case ControlOp::Status:
+                response.body = std::string("state=") + OverlayFsm_StateName(engine.State()) + "\n";
+                AppendLine(response.body, "away", engine.IsAway() ? 1 : 0);
+                AppendLine(response.body, "alpha", engine.Alpha());
+                AppendLine(response.body, "interval_minutes", cfg.intervalMinutes);
+                break;
+            case ControlOp::Snooze:
+            {
+                std::uint32_t minutes = 0;
+                if (!Control_ParseSnoozeArg(request.arg, minutes) || minutes == 0)
+                {
+                    response.status = ControlStatus::BadRequest;
+                    break;
+                }
+                engine.OnSnooze(now, minutes);
+                break;
+            }
+            case ControlOp::TriggerNow:
+                engine.OnTriggerNow(now);
+                break;
+            case ControlOp::ReloadConfig:
+                if (layers.Load())
+                {
+                    layers.SaveCache(cache);
+                    cfg = layers.Merged();
+                    applySets(cfg);
+                    engine.OnConfigSaved(now, cfg);
+                }
+                break;
+            case ControlOp::Metrics:
+            {
+                const X11HostStats& stats = host.Stats();
+                const X11SurfaceStats& surfaces = host.Backend().Stats();
+                AppendLine(response.body, "surfaces", (long long)host.Pool().Size());
+                AppendLine(response.body, "xshm", host.Backend().UsesShm() ? 1 : 0);
+                AppendLine(response.body, "xinput2", host.HasXInput2() ? 1 : 0);
+                AppendLine(response.body, "wakeups", (long long)stats.wakeups);
+                AppendLine(response.body, "timer_firings", (long long)stats.timerFirings);
+                AppendLine(response.body, "x_events", (long long)stats.xEvents);
+                AppendLine(response.body, "input_polls", (long long)stats.inputPolls);
+                AppendLine(response.body, "paints", (long long)surfaces.paints);
+                AppendLine(response.body, "upload_bytes", (long long)surfaces.uploadBytes);
+                AppendLine(response.body, "anim_frames", (long long)stats.animFrames);
+                AppendLine(response.body, "clock_paints", (long long)stats.clockPaints);
+                AppendLine(response.body, "text_line_paints", (long long)stats.textLines);
+                AppendLine(response.body, "anim_dropped", (long long)host.Animation().Stats().dropped);
+                break;
+            }
+            default:
+                response.status = ControlStatus::Failed;
+                break;
+            }
+        };
+        if (control && !server.Start(endpoint, [&](std::vector<ControlRequest>& batch)
+            {
+                host.Post([&, batch]
+                {
+                    std::vector<ControlResponse> responses(batch.size());
+                    for (size_t i = 0; i < batch.size(); i++)
+                    {
+                        handle(batch[i], responses[i]);
+                    }
+                    server.Respond(responses);
+                });
+            }))
+        {
+            std::fprintf(stderr, "ssr_x11: cannot listen on %s\n", endpoint.c_str());
+            result = 1;
+        }
+        else
+        {
+            engine.Start(host.Now(), cfg);
+            host.ReconcileSurfaces();
+            if (trigger)
+            {
+                engine.OnTriggerNow(host.Now());
+            }
+            host.Run(exitAfterMs);
+            engine.OnExit(host.Now());
+        }
+        server.Stop();
+    }
+    X11_CloseDisplay(display);
+    return result;
+}